@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Formats and parses random IPv4 and IPv6 addresses with `to_chars` and
+// `from_chars`, and compares them with `snprintf`, `inet_ntop` and
+// `inet_pton`, which are what `to_string` and `make_address_v*` used before.
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "fmt/core.h"
+
+#include "ip/address_v4.hpp"
+#include "ip/address_v6.hpp"
+
+namespace {
+constexpr int count = 4096;
+constexpr int rounds = 100;
+
+template <typename Fn>
+double run(Fn&& fn) {
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; ++round) {
+    for (int i = 0; i < count; ++i) {
+      fn(i);
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+         (count * rounds);
+}
+
+void report(const char* what, double libc_ns, double chars_ns) {
+  fmt::print("{:>12}: libc {:>7.1f}ns, to/from_chars {:>7.1f}ns\n", what,
+             libc_ns, chars_ns);
+}
+
+void bench_v4(std::mt19937& engine) {
+  std::vector<net::ip::address_v4::bytes_type> addresses(count);
+  for (auto& bytes : addresses) {
+    for (auto& byte : bytes) {
+      byte = static_cast<unsigned char>(engine());
+    }
+  }
+  std::vector<std::string> texts(count);
+  for (int i = 0; i < count; ++i) {
+    texts[i] = net::ip::address_v4(addresses[i]).to_string();
+  }
+
+  char text[INET6_ADDRSTRLEN];
+  double snprintf_ns = run([&](int i) {
+    const auto& b = addresses[i];
+    int n = std::snprintf(text, sizeof(text), "%d.%d.%d.%d", b[0], b[1], b[2],
+                          b[3]);
+    asm volatile("" : : "r"(n), "r"(text) : "memory");
+  });
+  double to_chars_ns = run([&](int i) {
+    char* end =
+        net::ip::address_v4(addresses[i]).to_chars(text, text + 16).ptr;
+    asm volatile("" : : "r"(end) : "memory");
+  });
+  report("v4 format", snprintf_ns, to_chars_ns);
+
+  double inet_pton_ns = run([&](int i) {
+    unsigned char bytes[4];
+    int ok = ::inet_pton(AF_INET, texts[i].c_str(), bytes);
+    asm volatile("" : : "r"(ok), "r"(bytes) : "memory");
+  });
+  std::vector<net::ip::address_v4> parsed(count);
+  double from_chars_ns = run([&](int i) {
+    const std::string& s = texts[i];
+    auto result = from_chars(s.data(), s.data() + s.size(), parsed[i]);
+    asm volatile("" : : "r"(result.ptr) : "memory");
+  });
+  for (int i = 0; i < count; ++i) {
+    if (parsed[i].to_bytes() != addresses[i]) {
+      fmt::print("from_chars parsed {} wrongly\n", texts[i]);
+      std::abort();
+    }
+  }
+  report("v4 parse", inet_pton_ns, from_chars_ns);
+}
+
+void bench_v6(std::mt19937& engine) {
+  // Half of the words are zero, so that most addresses have a "::".
+  std::vector<net::ip::address_v6::bytes_type> addresses(count);
+  for (auto& bytes : addresses) {
+    for (std::size_t j = 0; j < bytes.size(); j += 2) {
+      if (engine() % 2 == 0) {
+        bytes[j] = static_cast<unsigned char>(engine());
+        bytes[j + 1] = static_cast<unsigned char>(engine());
+      }
+    }
+  }
+  std::vector<std::string> texts(count);
+  for (int i = 0; i < count; ++i) {
+    texts[i] = net::ip::address_v6(addresses[i]).to_string();
+  }
+
+  char text[INET6_ADDRSTRLEN];
+  double inet_ntop_ns = run([&](int i) {
+    const char* p =
+        ::inet_ntop(AF_INET6, addresses[i].data(), text, sizeof(text));
+    asm volatile("" : : "r"(p) : "memory");
+  });
+  double to_chars_ns = run([&](int i) {
+    char* end = net::ip::address_v6(addresses[i])
+                    .to_chars(text, text + sizeof(text))
+                    .ptr;
+    asm volatile("" : : "r"(end) : "memory");
+  });
+  report("v6 format", inet_ntop_ns, to_chars_ns);
+
+  double inet_pton_ns = run([&](int i) {
+    unsigned char bytes[16];
+    int ok = ::inet_pton(AF_INET6, texts[i].c_str(), bytes);
+    asm volatile("" : : "r"(ok), "r"(bytes) : "memory");
+  });
+  std::vector<net::ip::address_v6> parsed(count);
+  double from_chars_ns = run([&](int i) {
+    const std::string& s = texts[i];
+    auto result = from_chars(s.data(), s.data() + s.size(), parsed[i]);
+    asm volatile("" : : "r"(result.ptr) : "memory");
+  });
+  for (int i = 0; i < count; ++i) {
+    if (parsed[i].to_bytes() != addresses[i]) {
+      fmt::print("from_chars parsed {} wrongly\n", texts[i]);
+      std::abort();
+    }
+  }
+  report("v6 parse", inet_pton_ns, from_chars_ns);
+}
+}  // namespace
+
+int main() {
+  std::mt19937 engine{41};
+  bench_v4(engine);
+  bench_v6(engine);
+  return 0;
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Hashes IPv6 endpoints with the previous hash-combine scheme and with the
+// current `std::hash`, reporting the time per hash and how evenly related
+// keys spread over the buckets of a power-of-two table.
+
+#include <chrono>  // NOLINT
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "fmt/core.h"
+
+#include "ip/basic_endpoint.hpp"
+
+namespace {
+// Stands in for ip::tcp, which brings in the whole socket layer.
+struct protocol {
+  static constexpr protocol v4() { return protocol{AF_INET}; }
+  static constexpr protocol v6() { return protocol{AF_INET6}; }
+  constexpr int family() const noexcept { return family_; }
+  int family_;
+};
+
+using endpoint = net::ip::basic_endpoint<protocol>;
+
+constexpr std::size_t count = 1 << 16;
+constexpr std::size_t buckets = 1 << 12;
+constexpr int rounds = 100;
+
+// The hash of address_v6 and basic_endpoint before they moved to
+// ip/address_hash.hpp.
+std::size_t legacy_hash(const endpoint& ep) {
+  auto combine = [](std::size_t& seed, const unsigned char* bytes) {
+    const std::size_t word = (static_cast<std::size_t>(bytes[0]) << 24) |
+                             (static_cast<std::size_t>(bytes[1]) << 16) |
+                             (static_cast<std::size_t>(bytes[2]) << 8) |
+                             (static_cast<std::size_t>(bytes[3]));
+    seed ^= word + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  };
+  const net::ip::address_v6 addr = ep.address().to_v6();
+  const auto bytes = addr.to_bytes();
+  std::size_t hash1 = addr.scope_id();
+  combine(hash1, &bytes[0]);
+  combine(hash1, &bytes[4]);
+  combine(hash1, &bytes[8]);
+  combine(hash1, &bytes[12]);
+  std::size_t hash2 = std::hash<port_type>()(ep.port());
+  return hash1 ^ (hash2 + 0x9e3779b9 + (hash1 << 6) + (hash1 >> 2));
+}
+
+template <typename Hash>
+void bench(const char* name, const char* keys,
+           const std::vector<endpoint>& endpoints, Hash hash) {
+  std::vector<std::size_t> load(buckets);
+  for (const auto& ep : endpoints) {
+    ++load[hash(ep) & (buckets - 1)];
+  }
+  const auto used = static_cast<std::size_t>(
+      std::count_if(load.begin(), load.end(), [](auto n) { return n != 0; }));
+  const std::size_t max_load = *std::max_element(load.begin(), load.end());
+
+  std::size_t sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; ++round) {
+    for (const auto& ep : endpoints) {
+      sink += hash(ep);
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  asm volatile("" : : "r"(sink) : "memory");
+  const double ns =
+      std::chrono::duration<double, std::nano>(end - start).count() /
+      static_cast<double>(endpoints.size() * rounds);
+  fmt::print("{:>7} {:>22}: {:>5.2f}ns/hash, {:>4}/{} buckets used, "
+             "max load {:>5} (ideal {})\n",
+             name, keys, ns, used, buckets, max_load,
+             endpoints.size() / buckets);
+}
+}  // namespace
+
+int main() {
+  // Hosts of one /64 with random and with strided interface IDs, talking to
+  // one port, and one host connecting from every port.
+  std::vector<endpoint> random_hosts;
+  std::vector<endpoint> strided_hosts;
+  std::vector<endpoint> ports;
+  std::mt19937_64 engine{42};
+  auto host = [](std::uint64_t iid) {
+    net::ip::address_v6::bytes_type bytes{0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 1};
+    for (int j = 0; j < 8; ++j) {
+      bytes[15 - j] = static_cast<unsigned char>(iid >> (8 * j));
+    }
+    return net::ip::address_v6(bytes);
+  };
+  for (std::size_t i = 0; i < count; ++i) {
+    random_hosts.emplace_back(host(engine()), 443);
+    strided_hosts.emplace_back(host(i << 16), 443);
+    ports.emplace_back(host(1), static_cast<port_type>(i));
+  }
+
+  bench("legacy", "random hosts of a /64", random_hosts, legacy_hash);
+  bench("current", "random hosts of a /64", random_hosts,
+        std::hash<endpoint>());
+  bench("legacy", "strided hosts of a /64", strided_hosts, legacy_hash);
+  bench("current", "strided hosts of a /64", strided_hosts,
+        std::hash<endpoint>());
+  bench("legacy", "ports of one host", ports, legacy_hash);
+  bench("current", "ports of one host", ports, std::hash<endpoint>());
+  return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Gathers a scatter-gather sequence into one contiguous buffer with
+// `buffer_copy`, and compares it with a plain per-fragment `memcpy` loop.
+// Each distribution models a different shape of header/payload sequences.
+
+#include <chrono>  // NOLINT
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "fmt/core.h"
+
+#include "buffer.hpp"
+
+namespace {
+struct distribution {
+  const char* name_;
+  std::size_t min_;
+  std::size_t max_;
+};
+
+constexpr std::size_t total_bytes = 64 * 1024;
+constexpr int rounds = 2'000;
+
+template <typename Fn>
+double run(Fn&& fn) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; ++i) {
+    fn();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(end - start).count() /
+         rounds;
+}
+
+void bench(const distribution& dist) {
+  std::mt19937_64 engine{dist.max_};
+  std::uniform_int_distribution<std::size_t> size{dist.min_, dist.max_};
+  std::vector<unsigned char> source(total_bytes);
+  for (auto& c : source) {
+    c = static_cast<unsigned char>(engine());
+  }
+  std::vector<net::const_buffer> fragments;
+  for (std::size_t offset = 0; offset < total_bytes;) {
+    std::size_t n = std::min(size(engine), total_bytes - offset);
+    fragments.emplace_back(source.data() + offset, n);
+    offset += n;
+  }
+  std::vector<unsigned char> target(total_bytes);
+
+  double memcpy_us = run([&] {
+    unsigned char* out = target.data();
+    for (const auto& fragment : fragments) {
+      ::memcpy(out, fragment.data(), fragment.size());
+      out += fragment.size();
+    }
+    asm volatile("" : : "r"(out) : "memory");
+  });
+  double buffer_copy_us = run([&] {
+    std::size_t n = net::buffer_copy(net::buffer(target), fragments);
+    asm volatile("" : : "r"(n) : "memory");
+  });
+  if (std::memcmp(target.data(), source.data(), total_bytes) != 0) {
+    fmt::print("buffer_copy produced wrong bytes\n");
+    std::abort();
+  }
+  fmt::print("{:>14} ({:>7} fragments): memcpy loop {:>8.2f}us, "
+             "buffer_copy {:>8.2f}us\n",
+             dist.name_, fragments.size(), memcpy_us, buffer_copy_us);
+}
+}  // namespace
+
+int main() {
+  for (const distribution& dist : {distribution{"1-8 bytes", 1, 8},
+                                   distribution{"8-64 bytes", 8, 64},
+                                   distribution{"1-256 bytes", 1, 256},
+                                   distribution{"1-4 KiB", 1024, 4096}}) {
+    bench(dist);
+  }
+  return 0;
+}
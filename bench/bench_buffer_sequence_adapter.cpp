@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Constructs `buffer_sequence_adapter`s over sequences of 1 to 64 fragments,
+// which every gathering send and scattering receive does before its syscall,
+// and reports the time per construction for a single buffer, a fixed array
+// and a vector of buffers.
+
+#include <array>
+#include <chrono>  // NOLINT
+#include <cstddef>
+#include <vector>
+
+#include "fmt/core.h"
+
+#include "buffer.hpp"
+#include "buffer_sequence_adapter.hpp"
+
+namespace {
+constexpr int rounds = 1'000'000;
+
+// Keeps the result alive so the construction isn't optimized away.
+volatile std::size_t sink = 0;
+
+template <typename Buffers>
+double run(const Buffers& buffers) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; ++i) {
+    net::buffer_sequence_adapter<net::const_buffer, Buffers> bufs{buffers};
+    sink = sink + bufs.count() + bufs.total_size();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+         rounds;
+}
+
+template <std::size_t N>
+void bench_fixed(const std::vector<char>& storage) {
+  std::array<net::const_buffer, N> array;
+  for (std::size_t i = 0; i < N; ++i) {
+    array[i] = net::const_buffer(storage.data() + i * 64, 64);
+  }
+  std::vector<net::const_buffer> vector(array.begin(), array.end());
+  fmt::print("{:>4} fragments: array {:>8.1f}ns, vector {:>8.1f}ns\n", N,
+             run(array), run(vector));
+}
+}  // namespace
+
+int main() {
+  std::vector<char> storage(64 * 64);
+  net::const_buffer single(storage.data(), storage.size());
+  fmt::print("   single buffer: {:>8.1f}ns\n", run(single));
+  bench_fixed<1>(storage);
+  bench_fixed<2>(storage);
+  bench_fixed<4>(storage);
+  bench_fixed<16>(storage);
+  bench_fixed<64>(storage);
+  return 0;
+}
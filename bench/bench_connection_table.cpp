@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares scanning the traffic of 10k to 1M connections through the counter
+// columns of `connection_table` with reading counters kept in each connection
+// object, as an export or a throttling pass would. The objects are padded to
+// the size of a connection with its sockets and are touched in the order of
+// the dense array, so each one costs a cache miss once the table outgrows the
+// cache.
+
+#include <chrono>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "fmt/core.h"
+
+#include "connection_table.hpp"
+#include "monotonic_clock.hpp"
+
+namespace {
+using clock_type = std::chrono::steady_clock;
+
+struct connection {
+  std::uint64_t bytes_in = 0;
+  std::uint64_t bytes_out = 0;
+  std::uint64_t ops_in = 0;
+  std::uint64_t ops_out = 0;
+  std::int64_t last_activity = 0;
+  char sockets[472] = {};
+};
+
+struct totals {
+  std::uint64_t bytes = 0;
+  std::uint64_t ops = 0;
+  std::size_t idle = 0;
+};
+
+double elapsed_us(clock_type::time_point start, clock_type::time_point end) {
+  return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+void bench_scan(std::size_t count) {
+  net::connection_table<connection> table;
+  table.reserve(count);
+  std::vector<net::connection_table<connection>::handle> handles;
+  handles.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    handles.push_back(table.emplace().first);
+  }
+  // Churn, so the dense order no longer follows the slots.
+  for (std::size_t i = 0; i < count; i += 3) {
+    table.erase(handles[i]);
+    handles[i] = table.emplace().first;
+  }
+  const auto now = net::monotonic_clock::now();
+  for (std::size_t i = 0; i < count; ++i) {
+    table.add_received(handles[i], i % 1500, now);
+    table.add_sent(handles[i], i % 700, now);
+    auto& c = *table.get(handles[i]);
+    c.bytes_in += i % 1500;
+    c.bytes_out += i % 700;
+    ++c.ops_in;
+    ++c.ops_out;
+    c.last_activity = now.seconds() * 1'000'000'000 + now.nanoseconds();
+  }
+  const std::int64_t idle_before =
+      now.seconds() * 1'000'000'000 + now.nanoseconds() + 1;
+
+  auto start = clock_type::now();
+  totals columns;
+  const auto traffic = table.traffic();
+  for (std::size_t i = 0; i < traffic.bytes_in.size(); ++i) {
+    columns.bytes += traffic.bytes_in[i] + traffic.bytes_out[i];
+    columns.ops += traffic.ops_in[i] + traffic.ops_out[i];
+    columns.idle += traffic.last_activity[i] < idle_before;
+  }
+  auto middle = clock_type::now();
+  totals objects;
+  table.for_each([&](auto, const connection& c) noexcept {
+    objects.bytes += c.bytes_in + c.bytes_out;
+    objects.ops += c.ops_in + c.ops_out;
+    objects.idle += c.last_activity < idle_before;
+  });
+  auto end = clock_type::now();
+
+  if (columns.bytes != objects.bytes || columns.ops != objects.ops ||
+      columns.idle != objects.idle) {
+    fmt::print("mismatch\n");
+  }
+  fmt::print("scan {:>8} connections: columns {:>8.1f}us, objects {:>8.1f}us\n",
+             count, elapsed_us(start, middle), elapsed_us(middle, end));
+}
+}  // namespace
+
+int main() {
+  for (std::size_t count : {10'000, 100'000, 1'000'000}) {
+    bench_scan(count);
+  }
+  return 0;
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Accepts and echoes over loopback through `epoll_context`. A blocking client
+// on the main thread drives the io thread:
+//  - accept: connect, `async_accept` and close, per connection.
+//  - echo: round trips of 64B to 16KiB messages over one connection, echoed
+//    by `async_recv_some` and `async_send_all`.
+
+#include <sys/socket.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstddef>
+#include <cstdlib>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "fmt/core.h"
+
+#include "buffer.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_accept_op.hpp"
+#include "epoll/socket_io_base_op.hpp"
+#include "epoll/socket_recv_some_op.hpp"
+#include "epoll/socket_send_all_op.hpp"
+#include "epoll/start_detached.hpp"
+#include "exec/repeat_effect_until.hpp"
+#include "ip/tcp.hpp"
+#include "stdexec.hpp"
+
+namespace ex = stdexec;
+
+namespace {
+using clock_type = std::chrono::steady_clock;
+
+double elapsed_us(clock_type::time_point start, clock_type::time_point end) {
+  return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+[[noreturn]] void fail(const char* what) {
+  fmt::print("{} failed\n", what);
+  std::abort();
+}
+
+// Open a blocking client connected to `peer`.
+net::ip::tcp::socket connect_to(net::epoll_context& ctx,
+                                const net::ip::tcp::endpoint& peer) {
+  net::ip::tcp::socket client{ctx};
+  if (client.open(net::ip::tcp::v4()).failure() ||
+      client.connect(peer).failure()) {
+    fail("connect");
+  }
+  return client;
+}
+
+void bench_accept(net::epoll_context& ctx, net::ip::tcp::acceptor& acceptor,
+                  const net::ip::tcp::endpoint& peer, int count) {
+  auto start = clock_type::now();
+  for (int i = 0; i < count; ++i) {
+    auto client = connect_to(ctx, peer);
+    auto accepted = ex::sync_wait(net::async_accept(acceptor));
+    if (!accepted) {
+      fail("accept");
+    }
+    auto& [server] = *accepted;
+    server.close();
+    client.close();
+  }
+  auto end = clock_type::now();
+  fmt::print("accept {:>6} connections: {:>8.1f}us/connection\n", count,
+             elapsed_us(start, end) / count);
+}
+
+void bench_echo(net::epoll_context& ctx, net::ip::tcp::acceptor& acceptor,
+                const net::ip::tcp::endpoint& peer, std::size_t size,
+                int rounds) {
+  auto client = connect_to(ctx, peer);
+  auto accepted = ex::sync_wait(net::async_accept(acceptor));
+  if (!accepted) {
+    fail("accept");
+  }
+  auto& [server] = *accepted;
+
+  // Echo until the client closes the connection.
+  char buffer[64 * 1024];
+  std::atomic<bool> server_done{false};
+  // clang-format off
+  net::start_detached(ctx, ex::on(ctx.get_scheduler(),
+      exec::repeat_effect_until(
+          net::async_recv_some(server, net::buffer(buffer))
+            | ex::let_value([&](std::size_t n) noexcept {
+                return net::async_send_all(server,
+                                           net::const_buffer(buffer, n))
+                     | ex::then([n](std::size_t) noexcept { return n == 0; });
+              })
+            | ex::upon_error([](auto&&) noexcept { return true; }))
+        | ex::then([&server_done]() noexcept {
+            server_done.store(true, std::memory_order_release);
+            server_done.notify_one();
+          })));
+  // clang-format on
+
+  std::vector<char> message(size, 'x');
+  std::vector<char> reply(size);
+  auto start = clock_type::now();
+  for (int i = 0; i < rounds; ++i) {
+    if (::send(client.native_handle(), message.data(), size, 0) !=
+        static_cast<ssize_t>(size)) {
+      fail("send");
+    }
+    for (std::size_t received = 0; received < size;) {
+      ssize_t n = ::recv(client.native_handle(), reply.data() + received,
+                         size - received, 0);
+      if (n <= 0) {
+        fail("recv");
+      }
+      received += static_cast<std::size_t>(n);
+    }
+  }
+  auto end = clock_type::now();
+  client.close();
+  server_done.wait(false, std::memory_order_acquire);
+  server.close();
+
+  fmt::print("echo {:>6}B x {:>6}: {:>8.1f}us/round trip, {:>8.1f}MiB/s\n",
+             size, rounds, elapsed_us(start, end) / rounds,
+             2.0 * size * rounds / elapsed_us(start, end) * 1e6 / (1 << 20));
+}
+}  // namespace
+
+int main() {
+  net::epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+
+  // Listen on an ephemeral port of the loopback interface.
+  system_error2::system_code ec{system_error2::errc::success};
+  net::ip::tcp::acceptor acceptor{
+      ctx, {net::ip::address_v4::loopback(), 0}, ec, true};
+  if (ec.failure() || acceptor.set_non_blocking(true).failure()) {
+    fail("listen");
+  }
+  auto local = acceptor.local_endpoint();
+  if (!local.has_value()) {
+    fail("local_endpoint");
+  }
+  const net::ip::tcp::endpoint peer = local.value();
+
+  bench_accept(ctx, acceptor, peer, 10'000);
+  for (std::size_t size : {64, 1024, 16 * 1024}) {
+    bench_echo(ctx, acceptor, peer, size, 20'000);
+  }
+
+  acceptor.close();
+  ctx.request_stop();
+  return 0;
+}
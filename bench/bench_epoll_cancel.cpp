@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the delivery of stop requests to parked socket operations, as when
+// a client-side deadline fires for many in-flight requests at once:
+//  - cancel: receives parked on 100 to 4k unix socket pairs are stopped by
+//    one `request_stop` of another thread.
+//  - race: the same, while a third thread sends a byte to every other pair,
+//    so that completions and stops of the same operations race. Each
+//    operation must complete exactly once, either way.
+
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "fmt/core.h"
+
+#include "buffer.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_recv_some_op.hpp"
+#include "local/connect_pair.hpp"
+#include "local/stream_protocol.hpp"
+#include "stdexec.hpp"
+
+namespace ex = stdexec;
+
+namespace {
+using clock_type = std::chrono::steady_clock;
+using socket_type = net::local::stream_protocol::socket;
+
+double elapsed_ns(clock_type::time_point start, clock_type::time_point end) {
+  return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+[[noreturn]] void fail(const char* what) {
+  fmt::print("{} failed\n", what);
+  std::abort();
+}
+
+// Counts the operations which completed with a value, an error or stopped.
+struct outcomes {
+  void add(std::atomic<std::size_t>& counter) noexcept {
+    counter.fetch_add(1, std::memory_order_relaxed);
+    if (done_.fetch_add(1, std::memory_order_acq_rel) + 1 == expected_) {
+      end_ = clock_type::now();
+      finished_.store(true, std::memory_order_release);
+      finished_.notify_one();
+    }
+  }
+
+  // Wait for all operations, returns the time the last one completed.
+  clock_type::time_point wait() noexcept {
+    finished_.wait(false, std::memory_order_acquire);
+    return end_;
+  }
+
+  std::atomic<std::size_t> done_{0};
+  std::atomic<std::size_t> values_{0};
+  std::atomic<std::size_t> errors_{0};
+  std::atomic<std::size_t> stops_{0};
+  std::size_t expected_ = 0;
+  clock_type::time_point end_;
+  std::atomic<bool> finished_{false};
+};
+
+// Adds the outcome of a receive, stoppable through `source_`.
+struct outcome_receiver {
+  using is_receiver = void;
+  using __t = outcome_receiver;
+  using __id = outcome_receiver;
+
+  struct env {
+    friend auto tag_invoke(ex::get_stop_token_t, const env& self) noexcept
+        -> ex::in_place_stop_token {
+      return self.source_->get_token();
+    }
+
+    ex::in_place_stop_source* source_;
+  };
+
+  friend void tag_invoke(ex::set_value_t, outcome_receiver&& self,
+                         std::size_t) noexcept {
+    self.outcomes_->add(self.outcomes_->values_);
+  }
+
+  template <typename Error>
+  friend void tag_invoke(ex::set_error_t, outcome_receiver&& self,
+                         Error&&) noexcept {
+    self.outcomes_->add(self.outcomes_->errors_);
+  }
+
+  friend void tag_invoke(ex::set_stopped_t, outcome_receiver&& self) noexcept {
+    self.outcomes_->add(self.outcomes_->stops_);
+  }
+
+  friend env tag_invoke(ex::get_env_t, const outcome_receiver& self) noexcept {
+    return {self.source_};
+  }
+
+  outcomes* outcomes_;
+  ex::in_place_stop_source* source_;
+};
+
+using recv_sender_t = decltype(net::async_recv_some(
+    std::declval<socket_type&>(), std::declval<net::mutable_buffer>()));
+
+// An operation state connected in place, since it can't be moved.
+struct connected {
+  connected(recv_sender_t&& sender, outcome_receiver receiver)
+      : op_(ex::connect(static_cast<recv_sender_t&&>(sender), receiver)) {}
+
+  ex::connect_result_t<recv_sender_t, outcome_receiver> op_;
+};
+
+// Run `fn` on the io thread and wait for it.
+template <typename Fn>
+void on_io_thread(net::epoll_context& ctx, Fn&& fn) {
+  ex::sync_wait(ex::schedule(ctx.get_scheduler()) |
+                ex::then(static_cast<Fn&&>(fn)));
+}
+
+void bench_cancel(net::epoll_context& ctx, std::size_t count, bool race) {
+  std::deque<socket_type> servers;
+  std::deque<socket_type> clients;
+  for (std::size_t i = 0; i < count; ++i) {
+    auto& server = servers.emplace_back(ctx);
+    auto& client = clients.emplace_back(ctx);
+    if (net::local::connect_pair(server, client).failure() ||
+        server.set_non_blocking(true).failure()) {
+      fail("connect_pair");
+    }
+  }
+
+  outcomes done;
+  done.expected_ = count;
+  ex::in_place_stop_source source;
+  std::vector<char> buffers(count);
+  std::deque<connected> ops;
+  for (std::size_t i = 0; i < count; ++i) {
+    ops.emplace_back(
+        net::async_recv_some(servers[i], net::buffer(&buffers[i], 1)),
+        outcome_receiver{&done, &source});
+  }
+  on_io_thread(ctx, [&]() noexcept {
+    for (auto& op : ops) {
+      ex::start(op.op_);
+    }
+  });
+
+  const auto before = ctx.stats();
+  std::atomic<bool> go{false};
+  std::jthread sender;
+  if (race) {
+    sender = std::jthread([&] {
+      go.wait(false, std::memory_order_acquire);
+      for (std::size_t i = 0; i < count; i += 2) {
+        if (::send(clients[i].native_handle(), "x", 1, MSG_NOSIGNAL) != 1) {
+          fail("send");
+        }
+      }
+    });
+  }
+  auto start = clock_type::now();
+  go.store(true, std::memory_order_release);
+  go.notify_all();
+  source.request_stop();
+  auto end = done.wait();
+  if (sender.joinable()) {
+    sender.join();
+  }
+  const auto after = ctx.stats();
+
+  if (done.errors_.load() != 0) {
+    fail("receive");
+  }
+  fmt::print(
+      "{:>6} {:>5} ops: {:>8.1f}ns/op, {:>5} completed, {:>5} stopped, "
+      "{:>3} interrupts, {:>5} remote stops\n",
+      race ? "race" : "cancel", count, elapsed_ns(start, end) / count,
+      done.values_.load(), done.stops_.load(),
+      after.interrupts - before.interrupts,
+      after.remote_stops - before.remote_stops);
+}
+}  // namespace
+
+int main() {
+  // Two descriptors per pair.
+  rlimit limit{};
+  if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < 16'384) {
+    limit.rlim_cur = std::min<rlim_t>(16'384, limit.rlim_max);
+    (void)::setrlimit(RLIMIT_NOFILE, &limit);
+  }
+
+  net::epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+
+  for (std::size_t count : {100, 1'000, 4'000}) {
+    bench_cancel(ctx, count, false);
+  }
+  for (int round = 0; round < 10; ++round) {
+    for (std::size_t count : {100, 1'000, 4'000}) {
+      bench_cancel(ctx, count, true);
+    }
+  }
+
+  ctx.request_stop();
+  return 0;
+}
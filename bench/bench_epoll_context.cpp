@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the queues and timers of `epoll_context`:
+//  - schedule: operations scheduled by the io thread onto the local queue and
+//    executed by `execute_local`.
+//  - remote: operations scheduled by 1 to 32 other threads at once, which
+//    contend on the remote queue and interrupt the loop, with the single
+//    remote queue and with 16 remote queue lanes.
+//  - timers: 1k to 1M timers inserted by the io thread and cancelled through
+//    their stop tokens before they fire.
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstddef>
+#include <deque>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "fmt/core.h"
+
+#include "epoll/epoll_context.hpp"
+#include "stdexec.hpp"
+
+namespace ex = stdexec;
+using namespace std::chrono_literals;  // NOLINT
+
+namespace {
+using clock_type = std::chrono::steady_clock;
+
+double elapsed_ns(clock_type::time_point start, clock_type::time_point end) {
+  return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+// Counts the completed operations and notes the time of the last one.
+struct completions {
+  void add() noexcept {
+    if (done_.fetch_add(1, std::memory_order_acq_rel) + 1 == expected_) {
+      end_ = clock_type::now();
+      finished_.store(true, std::memory_order_release);
+      finished_.notify_one();
+    }
+  }
+
+  void reset(std::size_t expected) noexcept {
+    done_.store(0, std::memory_order_relaxed);
+    expected_ = expected;
+    finished_.store(false, std::memory_order_relaxed);
+  }
+
+  // Wait for all operations, returns the time the last one completed.
+  clock_type::time_point wait() noexcept {
+    finished_.wait(false, std::memory_order_acquire);
+    return end_;
+  }
+
+  std::atomic<std::size_t> done_{0};
+  std::size_t expected_ = 0;
+  clock_type::time_point end_;
+  std::atomic<bool> finished_{false};
+};
+
+// Adds a completion, with the stop token of `source_` if given.
+struct counting_receiver {
+  using is_receiver = void;
+  using __t = counting_receiver;
+  using __id = counting_receiver;
+
+  struct env {
+    friend auto tag_invoke(ex::get_stop_token_t, const env& self) noexcept
+        -> ex::in_place_stop_token {
+      return self.source_ ? self.source_->get_token()
+                          : ex::in_place_stop_token{};
+    }
+
+    ex::in_place_stop_source* source_;
+  };
+
+  friend void tag_invoke(ex::set_value_t, counting_receiver&& self) noexcept {
+    self.completions_->add();
+  }
+
+  friend void tag_invoke(ex::set_stopped_t,
+                         counting_receiver&& self) noexcept {
+    self.completions_->add();
+  }
+
+  friend env tag_invoke(ex::get_env_t, const counting_receiver& self) noexcept {
+    return {self.source_};
+  }
+
+  completions* completions_;
+  ex::in_place_stop_source* source_ = nullptr;
+};
+
+// An operation state connected in place, since it can't be moved.
+template <typename Sender>
+struct connected {
+  connected(Sender&& sender, counting_receiver receiver)
+      : op_(ex::connect(static_cast<Sender&&>(sender), receiver)) {}
+
+  ex::connect_result_t<Sender, counting_receiver> op_;
+};
+
+template <typename Sender>
+using op_list = std::deque<connected<Sender>>;
+
+using schedule_sender_t =
+    decltype(ex::schedule(std::declval<net::epoll_context::scheduler>()));
+using timer_sender_t = decltype(exec::schedule_after(
+    std::declval<net::epoll_context::scheduler>(), 1h));
+
+// Run `fn` on the io thread and wait for it.
+template <typename Fn>
+void on_io_thread(net::epoll_context& ctx, Fn&& fn) {
+  ex::sync_wait(ex::schedule(ctx.get_scheduler()) |
+                ex::then(static_cast<Fn&&>(fn)));
+}
+
+void bench_schedule(net::epoll_context& ctx, std::size_t count) {
+  completions done;
+  done.reset(count);
+  op_list<schedule_sender_t> ops;
+  for (std::size_t i = 0; i < count; ++i) {
+    ops.emplace_back(ex::schedule(ctx.get_scheduler()),
+                     counting_receiver{&done});
+  }
+
+  clock_type::time_point start;
+  on_io_thread(ctx, [&]() noexcept {
+    start = clock_type::now();
+    for (auto& op : ops) {
+      ex::start(op.op_);
+    }
+  });
+  auto end = done.wait();
+  fmt::print("schedule {:>8} ops: {:>8.1f}ns/op\n", count,
+             elapsed_ns(start, end) / count);
+}
+
+void bench_remote(net::epoll_context& ctx, const char* queue,
+                  std::size_t threads,
+                  std::size_t per_thread) {
+  completions done;
+  done.reset(threads * per_thread);
+  std::vector<op_list<schedule_sender_t>> ops(threads);
+  for (auto& list : ops) {
+    for (std::size_t i = 0; i < per_thread; ++i) {
+      list.emplace_back(ex::schedule(ctx.get_scheduler()),
+                        counting_receiver{&done});
+    }
+  }
+
+  std::atomic<bool> go{false};
+  std::vector<std::jthread> producers;
+  for (auto& list : ops) {
+    producers.emplace_back([&go, &list] {
+      go.wait(false, std::memory_order_acquire);
+      for (auto& op : list) {
+        ex::start(op.op_);
+      }
+    });
+  }
+  auto start = clock_type::now();
+  go.store(true, std::memory_order_release);
+  go.notify_all();
+  auto end = done.wait();
+  producers.clear();
+
+  auto stats = ctx.remote_queue_statistics();
+  fmt::print(
+      "remote {:>6} {:>2} threads x {:>6} ops: {:>8.1f}ns/op, {} interrupts "
+      "so far\n",
+      queue, threads, per_thread,
+      elapsed_ns(start, end) / (threads * per_thread), stats.interrupt_count);
+}
+
+void bench_timers(net::epoll_context& ctx, std::size_t count) {
+  completions done;
+  done.reset(count);
+  ex::in_place_stop_source source;
+  op_list<timer_sender_t> ops;
+  for (std::size_t i = 0; i < count; ++i) {
+    // Spread the due times so the heap isn't degenerate.
+    auto due = 1h + std::chrono::milliseconds(i % 1024);
+    ops.emplace_back(exec::schedule_after(ctx.get_scheduler(), due),
+                     counting_receiver{&done, &source});
+  }
+
+  double insert_ns = 0;
+  on_io_thread(ctx, [&]() noexcept {
+    auto start = clock_type::now();
+    for (auto& op : ops) {
+      ex::start(op.op_);
+    }
+    insert_ns = elapsed_ns(start, clock_type::now());
+  });
+
+  clock_type::time_point start;
+  on_io_thread(ctx, [&]() noexcept {
+    start = clock_type::now();
+    source.request_stop();
+  });
+  auto end = done.wait();
+  fmt::print("timers {:>8}: insert {:>8.1f}ns/op, cancel {:>8.1f}ns/op\n",
+             count, insert_ns / count, elapsed_ns(start, end) / count);
+}
+}  // namespace
+
+int main() {
+  net::epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+
+  for (std::size_t count : {1'000, 100'000, 1'000'000}) {
+    bench_schedule(ctx, count);
+  }
+  net::epoll_context sharded_ctx{net::epoll_context::default_event_batch_size,
+                                 false, 16};
+  std::jthread sharded_io_thread([&sharded_ctx] { sharded_ctx.run(); });
+  for (std::size_t threads : {1, 2, 4, 8, 16, 32}) {
+    bench_remote(ctx, "single", threads, 100'000);
+    bench_remote(sharded_ctx, "lanes", threads, 100'000);
+  }
+  sharded_ctx.request_stop();
+  for (std::size_t count : {1'000, 10'000, 100'000, 1'000'000}) {
+    bench_timers(ctx, count);
+  }
+
+  ctx.request_stop();
+  return 0;
+}
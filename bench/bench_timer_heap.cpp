@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the sorted-list `intrusive_heap` with the `intrusive_pairing_heap`
+// used by `epoll_context` for timers. Each round inserts N timers with random
+// due times, cancels half of them by handle and pops the rest.
+
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "fmt/core.h"
+
+#include "intrusive_heap.hpp"
+#include "intrusive_pairing_heap.hpp"
+
+namespace {
+struct timer {
+  timer* child_ = nullptr;
+  timer* next_ = nullptr;
+  timer* prev_ = nullptr;
+  std::int64_t due_time_ = 0;
+};
+
+using list_heap = net::intrusive_heap<timer,           //
+                                      &timer::next_,   //
+                                      &timer::prev_,   //
+                                      std::int64_t,    //
+                                      &timer::due_time_>;
+
+using pairing_heap = net::intrusive_pairing_heap<timer,           //
+                                                 &timer::child_,  //
+                                                 &timer::next_,   //
+                                                 &timer::prev_,   //
+                                                 std::int64_t,    //
+                                                 &timer::due_time_>;
+
+template <typename Heap>
+double run_round(std::vector<timer>& timers) {
+  Heap heap;
+  auto start = std::chrono::steady_clock::now();
+  for (auto& t : timers) {
+    heap.insert(&t);
+  }
+  for (std::size_t i = 0; i < timers.size(); i += 2) {
+    heap.remove(&timers[i]);
+  }
+  std::int64_t last = 0;
+  while (!heap.empty()) {
+    timer* t = heap.pop();
+    if (t->due_time_ < last) {
+      fmt::print("heap order violated\n");
+      std::abort();
+    }
+    last = t->due_time_;
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+void bench(std::size_t count) {
+  std::mt19937_64 engine{count};
+  std::uniform_int_distribution<std::int64_t> due_time{0, 1'000'000'000};
+  std::vector<timer> timers(count);
+  for (auto& t : timers) {
+    t.due_time_ = due_time(engine);
+  }
+
+  double list_us = run_round<list_heap>(timers);
+  double pairing_us = run_round<pairing_heap>(timers);
+  fmt::print(
+      "{:>8} timers: sorted list {:>12.1f}us, pairing heap {:>10.1f}us\n",
+      count, list_us, pairing_us);
+}
+}  // namespace
+
+int main() {
+  for (std::size_t count : {100, 1'000, 10'000, 50'000}) {
+    bench(count);
+  }
+  return 0;
+}
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the packets per second a `udp_server` receives on each core over
+// loopback, against a hand-rolled loop of one thread per core doing blocking
+// recvmmsg on its own SO_REUSEPORT socket:
+//  - sink: the handler drops every datagram.
+//  - echo: the handler replies to every datagram, replies are sent with
+//    sendmmsg and dropped by the senders.
+// The senders blast 64B datagrams from several source ports with sendmmsg, so
+// the reuseport hash spreads them over the shards.
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "fmt/core.h"
+
+#include "datagram_batch.hpp"
+#include "epoll/reactor_pool.hpp"
+#include "epoll/udp_server.hpp"
+#include "ip/udp.hpp"
+
+using namespace std::chrono_literals;  // NOLINT
+
+namespace {
+using clock_type = std::chrono::steady_clock;
+using batch_type = net::datagram_batch<net::ip::udp>;
+
+constexpr std::size_t datagram_size = 64;
+constexpr std::size_t batch_size = 64;
+constexpr std::size_t ports_per_sender = 8;
+constexpr auto warmup = 500ms;
+constexpr auto duration = 2s;
+
+[[noreturn]] void fail(const char* what) {
+  fmt::print("{} failed\n", what);
+  std::abort();
+}
+
+// Threads sending datagrams to `peer` until stopped.
+class senders {
+ public:
+  senders(std::size_t count, const net::ip::udp::endpoint& peer) {
+    for (std::size_t i = 0; i < count; ++i) {
+      threads_.emplace_back([this, peer] { run(peer); });
+    }
+  }
+
+  ~senders() {
+    stop_.store(true, std::memory_order_relaxed);
+    threads_.clear();
+  }
+
+ private:
+  void run(const net::ip::udp::endpoint& peer) {
+    ::sockaddr_storage addr;
+    ::socklen_t addr_size = peer.native_address(&addr);
+    std::vector<int> fds;
+    for (std::size_t i = 0; i < ports_per_sender; ++i) {
+      int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+      if (fd < 0 ||
+          ::connect(fd, reinterpret_cast<::sockaddr*>(&addr), addr_size)) {
+        fail("connect");
+      }
+      fds.push_back(fd);
+    }
+    char payload[datagram_size] = {};
+    ::iovec iov{payload, sizeof(payload)};
+    std::vector<::mmsghdr> msgs(batch_size);
+    for (auto& m : msgs) {
+      m.msg_hdr.msg_iov = &iov;
+      m.msg_hdr.msg_iovlen = 1;
+    }
+    for (std::size_t i = 0; !stop_.load(std::memory_order_relaxed); ++i) {
+      ::sendmmsg(fds[i % fds.size()], msgs.data(), batch_size, 0);
+    }
+    for (int fd : fds) {
+      ::close(fd);
+    }
+  }
+
+  std::atomic<bool> stop_{false};
+  std::vector<std::jthread> threads_;
+};
+
+void print(const char* name, std::size_t cores,
+           const std::vector<std::uint64_t>& packets) {
+  const double seconds = std::chrono::duration<double>(duration).count();
+  std::uint64_t total = 0;
+  for (auto n : packets) {
+    total += n;
+  }
+  fmt::print("{:<8} {} core(s): {:>8.2f} Mpps total, {:>8.2f} Mpps/core [",
+             name, cores, total / seconds / 1e6,
+             total / seconds / 1e6 / cores);
+  for (std::size_t i = 0; i < packets.size(); ++i) {
+    fmt::print("{}{:.2f}", i == 0 ? "" : " ", packets[i] / seconds / 1e6);
+  }
+  fmt::print("]\n");
+}
+
+void bench_server(std::size_t cores, bool echo) {
+  net::reactor_pool pool{cores};
+  pool.run();
+  auto handler = [echo](const batch_type& received, std::size_t count,
+                        batch_type& replies) noexcept {
+    for (std::size_t i = 0; echo && i < count; ++i) {
+      if (auto peer = received.endpoint(i); peer.has_value()) {
+        replies.push_back(
+            net::const_buffer(received.buffer(i).data(), received.length(i)),
+            peer.value());
+      }
+    }
+  };
+  net::udp_server server{
+      pool, net::ip::udp::endpoint{net::ip::address_v4::loopback(), 0},
+      handler, {.batch_size = batch_size, .receive_buffer_size = 4 << 20}};
+  server.start();
+
+  std::vector<std::uint64_t> packets(cores);
+  {
+    senders blast{cores, server.local_endpoint()};
+    std::this_thread::sleep_for(warmup);
+    for (std::size_t i = 0; i < cores; ++i) {
+      packets[i] = server.stats(i).received;
+    }
+    std::this_thread::sleep_for(duration);
+    for (std::size_t i = 0; i < cores; ++i) {
+      packets[i] = server.stats(i).received - packets[i];
+    }
+  }
+  server.request_stop();
+  server.wait();
+  print(echo ? "echo" : "sink", cores, packets);
+}
+
+// One thread per core, each blocking in recvmmsg on its own socket.
+void bench_baseline(std::size_t cores) {
+  std::vector<int> fds;
+  net::ip::udp::endpoint local{net::ip::address_v4::loopback(), 0};
+  for (std::size_t i = 0; i < cores; ++i) {
+    int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    int on = 1;
+    int rcvbuf = 4 << 20;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    ::sockaddr_storage addr;
+    ::socklen_t size = local.native_address(&addr);
+    if (::bind(fd, reinterpret_cast<::sockaddr*>(&addr), size) != 0) {
+      fail("bind");
+    }
+    // The others share the port the first one picked.
+    size = local.capacity();
+    ::getsockname(fd, local.data(), &size);
+    // Wake the blocked receivers up once in a while to check for the end.
+    ::timeval timeout{0, 100'000};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    fds.push_back(fd);
+  }
+
+  std::atomic<bool> stop{false};
+  std::vector<std::atomic<std::uint64_t>> received(cores);
+  std::vector<std::jthread> receivers;
+  for (std::size_t i = 0; i < cores; ++i) {
+    receivers.emplace_back([&, i] {
+      std::vector<char> storage(batch_size * 2048);
+      std::vector<::iovec> iovs(batch_size);
+      std::vector<::mmsghdr> msgs(batch_size);
+      for (std::size_t j = 0; j < batch_size; ++j) {
+        iovs[j] = {&storage[j * 2048], 2048};
+        msgs[j].msg_hdr.msg_iov = &iovs[j];
+        msgs[j].msg_hdr.msg_iovlen = 1;
+      }
+      while (!stop.load(std::memory_order_relaxed)) {
+        int n = ::recvmmsg(fds[i], msgs.data(), batch_size, 0, nullptr);
+        if (n > 0) {
+          received[i].fetch_add(n, std::memory_order_relaxed);
+        }
+      }
+    });
+  }
+
+  std::vector<std::uint64_t> packets(cores);
+  {
+    senders blast{cores, local};
+    std::this_thread::sleep_for(warmup);
+    for (std::size_t i = 0; i < cores; ++i) {
+      packets[i] = received[i].load(std::memory_order_relaxed);
+    }
+    std::this_thread::sleep_for(duration);
+    for (std::size_t i = 0; i < cores; ++i) {
+      packets[i] = received[i].load(std::memory_order_relaxed) - packets[i];
+    }
+  }
+  stop.store(true, std::memory_order_relaxed);
+  receivers.clear();
+  for (int fd : fds) {
+    ::close(fd);
+  }
+  print("baseline", cores, packets);
+}
+}  // namespace
+
+int main() {
+  const std::size_t max_cores =
+      std::max<std::size_t>(1, std::thread::hardware_concurrency() / 2);
+  for (std::size_t cores = 1; cores <= std::min<std::size_t>(max_cores, 8);
+       cores *= 2) {
+    bench_baseline(cores);
+    bench_server(cores, false);
+    bench_server(cores, true);
+  }
+  return 0;
+}
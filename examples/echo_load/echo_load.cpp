@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// A load generator for echo_server. Each of `threads` epoll_contexts opens
+// `connections` connections, and each connection keeps `depth` requests of
+// `size` bytes in flight: it writes them at once, reads their echo back and
+// records the round trip as the latency of each of them. After `seconds` it
+// reports the requests and bytes per second and the p50/p99/p999 latencies.
+//
+// Usage: echo_load [host] [port] [threads] [connections] [depth] [size]
+//                  [seconds]
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_connect_op.hpp"
+#include "epoll/socket_io_base_op.hpp"
+#include "epoll/socket_recv_exactly_op.hpp"
+#include "epoll/socket_send_all_op.hpp"
+#include "epoll/start_detached.hpp"
+#include "ip/address.hpp"
+#include "ip/tcp.hpp"
+#include "latency_histogram.hpp"
+
+#include "exec/repeat_effect_until.hpp"
+#include "fmt/format.h"
+#include "stdexec.hpp"
+#include "stdexec/execution.hpp"
+
+using namespace std::chrono_literals;  // NOLINT
+namespace ex = stdexec;
+
+struct options {
+  const char* host = "127.0.0.1";
+  port_type port = 12312;
+  int threads = 2;
+  int connections = 64;
+  int depth = 4;
+  std::size_t size = 64;
+  int seconds = 10;
+};
+
+struct connection {
+  explicit connection(net::epoll_context& ctx, const options& opts)
+      : socket(ctx), out(opts.size * opts.depth, 'x'), in(out.size()) {}
+
+  net::ip::tcp::socket socket;
+  std::vector<char> out;
+  std::vector<char> in;
+  std::chrono::steady_clock::time_point sent;
+};
+
+// One client context and its connections. Everything but `finished` is only
+// touched by its io thread until all connections have finished.
+struct worker {
+  net::epoll_context ctx;
+  std::deque<connection> connections;
+  net::latency_histogram latencies;
+  std::uint64_t requests = 0;
+  std::uint64_t errors = 0;
+  std::atomic<int> finished{0};
+};
+
+// Write the requests of `c`, read their echo and record the round trip, until
+// `stop` is set.
+auto exchange(worker& w, connection& c, int depth,
+              const std::atomic<bool>& stop) {
+  // clang-format off
+  return exec::repeat_effect_until(
+      ex::just()
+        | ex::let_value([&c]() noexcept {
+            c.sent = std::chrono::steady_clock::now();
+            return net::async_send_all(
+                c.socket, net::const_buffer(c.out.data(), c.out.size()));
+          })
+        | ex::let_value([&c](std::size_t) noexcept {
+            return net::async_recv_exactly(
+                c.socket, net::mutable_buffer(c.in.data(), c.in.size()));
+          })
+        | ex::then([&w, &c, depth, &stop](std::size_t) noexcept {
+            auto rtt = std::chrono::steady_clock::now() - c.sent;
+            for (int i = 0; i < depth; ++i) {
+              w.latencies.record(rtt);
+            }
+            w.requests += depth;
+            return stop.load(std::memory_order_relaxed);
+          }));
+  // clang-format on
+}
+
+int main(int argc, char* argv[]) {
+  options opts;
+  if (argc > 1) opts.host = argv[1];
+  if (argc > 2) opts.port = static_cast<port_type>(std::atoi(argv[2]));
+  if (argc > 3) opts.threads = std::atoi(argv[3]);
+  if (argc > 4) opts.connections = std::atoi(argv[4]);
+  if (argc > 5) opts.depth = std::atoi(argv[5]);
+  if (argc > 6) opts.size = static_cast<std::size_t>(std::atoi(argv[6]));
+  if (argc > 7) opts.seconds = std::atoi(argv[7]);
+
+  const net::ip::tcp::endpoint peer{net::ip::make_address(opts.host),
+                                    opts.port};
+  fmt::print("{} threads x {} connections x {} in flight, {}B to {}:{}\n",
+             opts.threads, opts.connections, opts.depth, opts.size, opts.host,
+             opts.port);
+
+  std::atomic<bool> stop{false};
+  std::deque<worker> workers(opts.threads);
+  std::vector<std::jthread> io_threads;
+  for (auto& w : workers) {
+    io_threads.emplace_back([&w] { w.ctx.run(); });
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (auto& w : workers) {
+    for (int i = 0; i < opts.connections; ++i) {
+      auto& c = w.connections.emplace_back(w.ctx, opts);
+      if (c.socket.open(peer.protocol()).failure()) {
+        fmt::print("failed to open a socket\n");
+        return 1;
+      }
+      // clang-format off
+      net::start_detached(w.ctx, ex::on(w.ctx.get_scheduler(),
+          net::async_connect(c.socket, peer)
+            | ex::let_value([&w, &c, &opts, &stop]() noexcept {
+                return exchange(w, c, opts.depth, stop);
+              })
+            | ex::upon_error([&w](auto&&) noexcept { ++w.errors; }))
+        | ex::then([&w]() noexcept {
+            w.finished.fetch_add(1, std::memory_order_release);
+            w.finished.notify_one();
+          }));
+      // clang-format on
+    }
+  }
+
+  std::this_thread::sleep_for(std::chrono::seconds(opts.seconds));
+  stop.store(true, std::memory_order_relaxed);
+  auto elapsed = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+
+  net::latency_histogram latencies;
+  std::uint64_t requests = 0;
+  std::uint64_t errors = 0;
+  for (auto& w : workers) {
+    for (int n = w.finished.load(std::memory_order_acquire);
+         n != opts.connections;
+         n = w.finished.load(std::memory_order_acquire)) {
+      w.finished.wait(n, std::memory_order_acquire);
+    }
+    for (auto& c : w.connections) {
+      c.socket.close();
+    }
+    latencies.merge(w.latencies);
+    requests += w.requests;
+    errors += w.errors;
+    w.ctx.request_stop();
+  }
+
+  auto us = [&latencies](double p) {
+    return std::chrono::duration<double, std::micro>(latencies.percentile(p))
+        .count();
+  };
+  fmt::print("{:.0f} requests/s, {:.1f} MiB/s, {} failed connections\n",
+             requests / elapsed,
+             requests * opts.size / elapsed / (1 << 20), errors);
+  fmt::print("latency p50 {:.1f}us, p99 {:.1f}us, p999 {:.1f}us\n", us(50),
+             us(99), us(99.9));
+  return 0;
+}
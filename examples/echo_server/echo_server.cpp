@@ -14,19 +14,23 @@
  * limitations under the License.
  */
 
+#include <sys/socket.h>
+
 #include <iostream>
 #include <string>
 #include <system_error>  // NOLINT
-#include <thread>        // NOLINT
-#include <unordered_map>
 #include <vector>
 
 #include "buffer.hpp"
+#include "connection_table.hpp"
+#include "epoll/async_scope.hpp"
 #include "epoll/epoll_context.hpp"
-#include "epoll/socket_accept_op.hpp"
+#include "epoll/idle_sweeper.hpp"
+#include "epoll/socket_accept_each_op.hpp"
 #include "epoll/socket_io_base_op.hpp"
-#include "epoll/socket_recv_some_op.hpp"
+#include "epoll/socket_recv_pooled_op.hpp"
 #include "epoll/socket_send_some_op.hpp"
+#include "epoll/sync_wait.hpp"
 #include "ip/tcp.hpp"
 #include "net_error.hpp"
 
@@ -41,30 +45,36 @@
 
 using namespace std::chrono_literals;  // NOLINT
 namespace ex = stdexec;
-using net::async_recv_some;
 using net::async_send_some;
 using system_error2::errc;
 using system_error2::system_code;
 
 constexpr port_type port = 12312;
 
-inline uint64_t simple_uuid() {
-  static uint64_t n = 0;
-  return n++;
-}
-
-struct client {
-  std::optional<net::ip::tcp::socket> socket;
-  std::string buf;
+struct client : net::idle_tracker {
+  net::ip::tcp::socket socket;
 };
 
 int main(int argc, char* argv[]) {
   // Prepare context.
   net::epoll_context ctx{};
-  std::jthread io_thread([&]() { ctx.run(); });
-  exec::scope_guard context_guard{[&ctx]() noexcept {
-    ctx.request_stop();
-  }};
+
+  // Prepare sockets. Only touched by the io thread. Received bytes live in
+  // the receive buffer pool of the context until they are echoed.
+  net::connection_table<client> clients;
+
+  // Shut down connections idle for 60s, the pending receive then completes and
+  // closes the socket.
+  auto on_idle = [](auto, client& c) noexcept {
+    fmt::print("idle fd: {}.\n", c.socket.native_handle());
+    ::shutdown(c.socket.native_handle(), SHUT_RDWR);
+  };
+  net::idle_sweeper<client, decltype(on_idle)> sweeper{ctx, clients, 60s,
+                                                       on_idle};
+  sweeper.start();
+
+  // The connection handlers, so the server can wait for them on shutdown.
+  net::async_scope handlers{ctx};
 
   // Prepare acceptor.
   system_code code{errc::success};
@@ -76,29 +86,34 @@ int main(int argc, char* argv[]) {
   }};
   fmt::print("Server listen: {}, fd: {}\n", port, acceptor.native_handle());
 
-  // Prepare sockets and buffer containers.
-  std::unordered_map<uint64_t, client> clients;
-
   // clang-format off
-  // Echo whatever received from client.
+  // Echo whatever received from client. The acceptor stays armed and every
+  // accepted connection is handed to the handler.
   ex::sender auto s =
-      net::async_accept(acceptor)
-      | ex::then([&clients, &ctx](net::ip::tcp::socket&& sock) noexcept {
-          uint64_t uuid = simple_uuid();
-          fmt::print("client uuid: {}, fd: {}\n", uuid, sock.native_handle());
+      net::async_accept_each(acceptor,
+          [&clients, &ctx, &handlers](net::ip::tcp::socket&& sock) noexcept {
+          auto [handle, c] = clients.emplace();
+          fmt::print("client id: {}, fd: {}\n", handle.value(),
+                     sock.native_handle());
 
-          clients[uuid].socket = std::move(sock);
-          clients[uuid].buf.resize(1024);
-          auto& socket = clients[uuid].socket.value();
-          auto& buf = clients[uuid].buf;
+          c.socket = std::move(sock);
+          c.touch(ctx);
+          auto& socket = c.socket;
 
           ex::sender auto s1 = exec::repeat_effect_until(ex::on(
-              ctx.get_scheduler(),
-              async_recv_some(socket, net::buffer(buf))
-                  | ex::let_value([&buf, &socket](size_t sz) noexcept {
-                      net::const_buffer const_buf = net::buffer(buf, sz);
+              ctx.get_inline_scheduler(),
+              net::async_recv_pooled(socket)
+                  | ex::let_value([&c, &ctx, &socket](
+                                      net::buffer_lease& lease) noexcept {
+                      c.touch(ctx);
+                      net::const_buffer const_buf = lease.buffer();
                       return async_send_some(socket, const_buf)
-                            | ex::then([](size_t sz) noexcept {
+                            | ex::then([&socket](size_t sz) noexcept {
+                              if (sz == 0) {
+                                // Peer closed or the connection was shut down.
+                                socket.close();
+                                return true;
+                              }
                               return false;
                             });
                     })
@@ -106,19 +121,24 @@ int main(int argc, char* argv[]) {
                       fmt::print("close fd: {}.\n", socket.native_handle());
                       socket.close();
                       return true;
-                    })));
+                    })))
+            | ex::then([&clients, handle] { clients.erase(handle); });
 
-          ex::start_detached(std::move(s1));
-          return false;
+          handlers.spawn(std::move(s1));
         })
       | ex::upon_error([](std::error_code&& ec) noexcept {
           fmt::print("Error: {}\n", ec.message().c_str());
-          return true;
-        })
-      | exec::repeat_effect_until();
+        });
   // clang-format on
 
-  ex::sync_wait(std::move(s));
+  // The context runs on this thread until the acceptor fails.
+  net::sync_wait(ctx, std::move(s));
+
+  // Shut down the remaining connections and wait for their handlers.
+  clients.for_each([](auto, client& c) noexcept {
+    ::shutdown(c.socket.native_handle(), SHUT_RDWR);
+  });
+  net::sync_wait(ctx, handlers.join());
 
   return 0;
 }
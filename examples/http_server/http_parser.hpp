@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EXAMPLES_HTTP_SERVER_HTTP_PARSER_HPP_
+#define EXAMPLES_HTTP_SERVER_HTTP_PARSER_HPP_
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+
+namespace http {
+// A request parsed in place. The views point into the receive buffer and are
+// valid until the buffer is compacted.
+struct request {
+  std::string_view method;
+  std::string_view target;
+  int minor_version = 1;
+  bool keep_alive = true;
+  std::size_t content_length = 0;
+};
+
+// Returns the first '\n' in [first, last), or `last`. With SSE2, 16 bytes are
+// compared at once and the match is found with a bit scan of the mask.
+inline const char* find_eol(const char* first, const char* last) noexcept {
+#if defined(__SSE2__)
+  const __m128i lf = _mm_set1_epi8('\n');
+  for (; last - first >= 16; first += 16) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+    const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, lf));
+    if (mask != 0) {
+      return first + __builtin_ctz(static_cast<unsigned>(mask));
+    }
+  }
+#endif
+  const void* eol =
+      std::memchr(first, '\n', static_cast<std::size_t>(last - first));
+  return eol != nullptr ? static_cast<const char*>(eol) : last;
+}
+
+// Compares `str` with the lower case `lower`, ignoring the case of `str`.
+inline bool iequals(std::string_view str, std::string_view lower) noexcept {
+  if (str.size() != lower.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < str.size(); ++i) {
+    char c = str[i];
+    if (c >= 'A' && c <= 'Z') {
+      c = static_cast<char>(c - 'A' + 'a');
+    }
+    if (c != lower[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+inline std::string_view trim(std::string_view str) noexcept {
+  while (!str.empty() && (str.front() == ' ' || str.front() == '\t')) {
+    str.remove_prefix(1);
+  }
+  while (!str.empty() && (str.back() == ' ' || str.back() == '\t')) {
+    str.remove_suffix(1);
+  }
+  return str;
+}
+
+// The result of parse_request() when the request isn't complete yet, and when
+// it's malformed or unsupported.
+inline constexpr std::ptrdiff_t incomplete = 0;
+inline constexpr std::ptrdiff_t bad_request = -1;
+
+// Parses the request at the front of [data, data + size). Returns the size of
+// the request including its body, `incomplete` or `bad_request`. Lines end
+// with CRLF, a bare LF is accepted as well. Chunked bodies are not supported.
+inline std::ptrdiff_t parse_request(const char* data, std::size_t size,
+                                    request& req) noexcept {
+  const char* const last = data + size;
+  const char* pos = data;
+  // Reads the next line without its line ending, returns false if incomplete.
+  auto next_line = [&pos, last](std::string_view& line) noexcept {
+    const char* eol = find_eol(pos, last);
+    if (eol == last) {
+      return false;
+    }
+    const char* end = eol != pos && eol[-1] == '\r' ? eol - 1 : eol;
+    line = std::string_view(pos, static_cast<std::size_t>(end - pos));
+    pos = eol + 1;
+    return true;
+  };
+
+  std::string_view line;
+  // Empty lines before the request line are ignored, see RFC 9112 2.2.
+  do {
+    if (!next_line(line)) {
+      return incomplete;
+    }
+  } while (line.empty());
+
+  // METHOD SP request-target SP HTTP/1.x
+  const std::size_t sp1 = line.find(' ');
+  const std::size_t sp2 = line.rfind(' ');
+  if (sp1 == std::string_view::npos || sp1 == 0 || sp2 == sp1 + 1 ||
+      sp2 == sp1) {
+    return bad_request;
+  }
+  const std::string_view version = line.substr(sp2 + 1);
+  if (version.size() != 8 || version.substr(0, 7) != "HTTP/1." ||
+      (version[7] != '0' && version[7] != '1')) {
+    return bad_request;
+  }
+  req.method = line.substr(0, sp1);
+  req.target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+  req.minor_version = version[7] - '0';
+  req.keep_alive = req.minor_version == 1;
+  req.content_length = 0;
+
+  for (;;) {
+    if (!next_line(line)) {
+      return incomplete;
+    }
+    if (line.empty()) {
+      break;
+    }
+    const std::size_t colon = line.find(':');
+    if (colon == std::string_view::npos || colon == 0) {
+      return bad_request;
+    }
+    const std::string_view name = line.substr(0, colon);
+    const std::string_view value = trim(line.substr(colon + 1));
+    if (iequals(name, "content-length")) {
+      std::size_t length = 0;
+      if (value.empty() || value.size() > 18) {
+        return bad_request;
+      }
+      for (char c : value) {
+        if (c < '0' || c > '9') {
+          return bad_request;
+        }
+        length = length * 10 + static_cast<std::size_t>(c - '0');
+      }
+      req.content_length = length;
+    } else if (iequals(name, "connection")) {
+      if (iequals(value, "close")) {
+        req.keep_alive = false;
+      } else if (iequals(value, "keep-alive")) {
+        req.keep_alive = true;
+      }
+    } else if (iequals(name, "transfer-encoding")) {
+      return bad_request;
+    }
+  }
+
+  const std::size_t head = static_cast<std::size_t>(pos - data);
+  if (size - head < req.content_length) {
+    return incomplete;
+  }
+  return static_cast<std::ptrdiff_t>(head + req.content_length);
+}
+}  // namespace http
+
+#endif  // EXAMPLES_HTTP_SERVER_HTTP_PARSER_HPP_
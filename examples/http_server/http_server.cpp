@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// A minimal HTTP/1.1 server, meant as a realistic load target for the
+// library. Each core runs its own epoll_context of a reactor_pool and accepts
+// from its own SO_REUSEPORT acceptor. A connection reads whatever the client
+// has sent, answers every complete request in it, pipelined or not, with one
+// coalesced send, and stays open unless the client asks to close it.
+//
+//   GET / and GET /plaintext answer "Hello, World!", other targets 404.
+//
+// Usage: http_server [port] [threads]
+// Load:  wrk -t4 -c256 -d10s http://127.0.0.1:8080/plaintext
+//        (add a pipelining script such as wrk's pipeline.lua for depth > 1)
+
+#include <sys/socket.h>
+
+#include <chrono>  // NOLINT
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+#include <vector>
+
+#include "buffer.hpp"
+#include "connection_table.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/idle_sweeper.hpp"
+#include "epoll/reactor_pool.hpp"
+#include "epoll/socket_accept_each_op.hpp"
+#include "epoll/socket_io_base_op.hpp"
+#include "epoll/socket_recv_some_op.hpp"
+#include "epoll/socket_send_all_op.hpp"
+#include "epoll/start_detached.hpp"
+#include "ip/tcp.hpp"
+
+#include "exec/repeat_effect_until.hpp"
+#include "fmt/format.h"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+#include "stdexec/execution.hpp"
+
+#include "http_parser.hpp"
+
+using namespace std::chrono_literals;  // NOLINT
+namespace ex = stdexec;
+
+// The receive buffer of a connection, which bounds the size of a request.
+constexpr std::size_t buffer_size = 16 * 1024;
+
+struct connection : net::idle_tracker {
+  net::ip::tcp::socket socket;
+  // Received bytes not yet consumed by a complete request.
+  std::vector<char> in = std::vector<char>(buffer_size);
+  std::size_t size = 0;
+  // The responses of the current batch of requests.
+  std::string out;
+  bool closing = false;
+};
+
+// The Date header changes once per second, so each io thread formats it once
+// per second.
+std::string_view http_date() {
+  thread_local std::time_t cached = 0;
+  thread_local char date[64];
+  thread_local std::size_t length = 0;
+  const std::time_t now = std::time(nullptr);
+  if (now != cached) {
+    std::tm tm{};
+    ::gmtime_r(&now, &tm);
+    length =
+        std::strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    cached = now;
+  }
+  return {date, length};
+}
+
+void append_response(std::string& out, std::string_view status,
+                     std::string_view body, bool head, bool keep_alive) {
+  fmt::format_to(std::back_inserter(out),
+                 "HTTP/1.1 {}\r\n"
+                 "Server: net\r\n"
+                 "Date: {}\r\n"
+                 "Content-Type: text/plain\r\n"
+                 "Content-Length: {}\r\n"
+                 "{}"
+                 "\r\n"
+                 "{}",
+                 status, http_date(), body.size(),
+                 keep_alive ? "" : "Connection: close\r\n",
+                 head ? std::string_view{} : body);
+}
+
+void append_response(std::string& out, const http::request& req) {
+  const bool head = req.method == "HEAD";
+  if (req.method != "GET" && !head) {
+    append_response(out, "405 Method Not Allowed", "", head, req.keep_alive);
+  } else if (req.target == "/" || req.target == "/plaintext") {
+    append_response(out, "200 OK", "Hello, World!", head, req.keep_alive);
+  } else {
+    append_response(out, "404 Not Found", "", head, req.keep_alive);
+  }
+}
+
+// Answers every complete request in the receive buffer of `c`, then moves the
+// remaining bytes of a partial request to the front of the buffer.
+void handle_requests(connection& c) {
+  std::size_t offset = 0;
+  while (!c.closing && offset < c.size) {
+    http::request req;
+    const std::ptrdiff_t n =
+        http::parse_request(c.in.data() + offset, c.size - offset, req);
+    if (n == http::incomplete) {
+      if (offset == 0 && c.size == c.in.size()) {
+        // The request can't fit in the buffer.
+        append_response(c.out, "413 Content Too Large", "", false, false);
+        c.closing = true;
+      }
+      break;
+    }
+    if (n == http::bad_request) {
+      append_response(c.out, "400 Bad Request", "", false, false);
+      c.closing = true;
+      break;
+    }
+    append_response(c.out, req);
+    c.closing = !req.keep_alive;
+    offset += static_cast<std::size_t>(n);
+  }
+  if (offset != 0) {
+    std::memmove(c.in.data(), c.in.data() + offset, c.size - offset);
+    c.size -= offset;
+  }
+}
+
+// Shut down keep-alive connections idle for 30s, the pending receive then
+// completes and closes the socket.
+struct on_idle {
+  template <typename Handle>
+  void operator()(Handle, connection& c) const noexcept {
+    ::shutdown(c.socket.native_handle(), SHUT_RDWR);
+  }
+};
+
+// The connections of one context. Only touched by its io thread.
+struct worker {
+  explicit worker(net::epoll_context& context)
+      : ctx(context), sweeper(context, clients, 30s, on_idle{}) {}
+
+  net::epoll_context& ctx;
+  net::connection_table<connection> clients;
+  net::idle_sweeper<connection, on_idle> sweeper;
+};
+
+void serve(worker& w, net::ip::tcp::socket&& sock) noexcept {
+  auto [handle, c] = w.clients.emplace();
+  c.socket = std::move(sock);
+  c.size = 0;
+  c.out.clear();
+  c.closing = false;
+  c.touch(w.ctx);
+
+  // clang-format off
+  // Each round receives into the free tail of the buffer, which moves as
+  // partial requests are kept, so the receive is built anew every round.
+  ex::sender auto s = exec::repeat_effect_until(ex::on(
+      w.ctx.get_inline_scheduler(),
+      ex::just()
+          | ex::let_value([&c]() noexcept {
+              return net::async_recv_some(
+                  c.socket,
+                  net::mutable_buffer(c.in.data() + c.size,
+                                      c.in.size() - c.size));
+            })
+          | ex::let_value([&c, &w](std::size_t n) noexcept {
+              c.touch(w.ctx);
+              if (n == 0) {
+                c.closing = true;
+              } else {
+                c.size += n;
+                handle_requests(c);
+              }
+              // All responses of this round go out with one send. Nothing is
+              // sent while a request is still partial.
+              return net::async_send_all(
+                         c.socket, net::const_buffer(c.out.data(),
+                                                     c.out.size()))
+                   | ex::then([&c](std::size_t) noexcept {
+                       c.out.clear();
+                       if (c.closing) {
+                         c.socket.close();
+                       }
+                       return c.closing;
+                     });
+            })
+          | ex::upon_error([&c](auto&&) noexcept {
+              c.socket.close();
+              return true;
+            })))
+    | ex::then([&w, handle] { w.clients.erase(handle); });
+  // clang-format on
+
+  net::start_detached(w.ctx, std::move(s));
+}
+
+int main(int argc, char* argv[]) {
+  const port_type port =
+      argc > 1 ? static_cast<port_type>(std::atoi(argv[1])) : 8080;
+  const std::size_t threads =
+      argc > 2 ? static_cast<std::size_t>(std::atoi(argv[2]))
+               : std::thread::hardware_concurrency();
+
+  net::reactor_pool pool{threads};
+  std::vector<std::unique_ptr<worker>> workers;
+  for (std::size_t i = 0; i < pool.size(); ++i) {
+    workers.push_back(std::make_unique<worker>(pool.context(i)));
+  }
+
+  system_error2::system_code code{};
+  net::ip::tcp::endpoint ep{net::ip::address_v4::any(), port};
+  auto acceptors = pool.make_acceptors<net::ip::tcp>(ep, code);
+  if (code.failure()) {
+    fmt::print("Can't listen on {}: {}\n", port, code.message().c_str());
+    return 1;
+  }
+  fmt::print("Server listen: {}, threads: {}\n", port, pool.size());
+
+  // The accept loops and sweepers are started before the io threads run, so
+  // nothing of a context is touched by two threads at once.
+  for (std::size_t i = 0; i < pool.size(); ++i) {
+    acceptors[i].set_non_blocking(true);
+    worker& w = *workers[i];
+    w.sweeper.start();
+    net::start_detached(
+        w.ctx,
+        net::async_accept_each(acceptors[i],
+                               [&w](net::ip::tcp::socket&& sock) noexcept {
+                                 serve(w, std::move(sock));
+                               })
+            | ex::upon_error([](std::error_code&& ec) noexcept {
+                fmt::print("Error: {}\n", ec.message().c_str());
+              }));
+  }
+
+  pool.run();
+  pool.join();
+  return 0;
+}
@@ -55,6 +55,13 @@ class atomic_intrusive_queue<Next> {
   atomic_intrusive_queue& operator=(const atomic_intrusive_queue&) = delete;
   atomic_intrusive_queue& operator=(atomic_intrusive_queue&&) = delete;
 
+  // Whether there is no item in the queue. Can be called from any thread, the
+  // result may be outdated as soon as it returns.
+  [[nodiscard]] bool empty() const noexcept {
+    void* value = head_.load(std::memory_order_relaxed);
+    return value == nullptr || value == inactive_value();
+  }
+
   // Returns true if previous state was inactive, this operation successfully
   // marked it as active. Returns false if the previous state was active.
   [[nodiscard]] bool try_mark_active() noexcept {
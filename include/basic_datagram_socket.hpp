@@ -42,6 +42,9 @@ class basic_datagram_socket : public basic_socket<Protocol> {
   // The context_type
   using context_type = typename basic_socket<protocol_type>::context_type;
 
+  // Construct a null basic_datagram_socket, see basic_socket.
+  constexpr basic_datagram_socket() noexcept = default;
+
   // Construct a basic_datagram_socket without opening it.
   explicit constexpr basic_datagram_socket(context_type& ctx) noexcept
       : basic_socket<protocol_type>(ctx) {}
@@ -74,6 +77,31 @@ class basic_datagram_socket : public basic_socket<Protocol> {
   // Destroys the socket.
   constexpr ~basic_datagram_socket() noexcept = default;
 
+  // Open a socket on the same context, bound to the local endpoint of this
+  // one and connected to `peer`. This socket must have SO_REUSEPORT set, the
+  // new one gets it too. The kernel then prefers the connected socket for the
+  // datagrams of `peer`, and sends on it skip the route lookup of sendto. The
+  // non-blocking mode is copied. `ec` is assigned if any step fails, the
+  // returned socket is closed then.
+  socket_type connect_flow(const endpoint_type& peer,
+                           system_error2::system_code& ec) noexcept {
+    socket_type flow{this->context()};
+    auto local = this->local_endpoint();
+    if (local.has_error()) {
+      ec = static_cast<system_error2::system_code&&>(local.error());
+      return flow;
+    }
+    if ((ec = flow.open(local.value().protocol())).failure() ||
+        (ec = flow.set_option(socket_base::reuse_address{true})).failure() ||
+        (ec = flow.set_option(socket_base::reuse_port{true})).failure() ||
+        (ec = flow.bind(local.value())).failure() ||
+        (ec = flow.connect(peer)).failure() ||
+        (ec = flow.set_non_blocking(this->is_non_blocking())).failure()) {
+      flow.close();
+    }
+    return flow;
+  }
+
  private:
   basic_datagram_socket(const basic_datagram_socket&) = delete;
   basic_datagram_socket& operator=(const basic_datagram_socket&) = delete;
@@ -17,14 +17,23 @@
 #define BASIC_SOCKET_HPP_
 
 #include <arpa/inet.h>
+#include <linux/sockios.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <netinet/udp.h>
 #include <sys/poll.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cassert>
 #include <cstddef>
-#include <optional>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
 
 #include "buffer_sequence_adapter.hpp"
 #include "exec/linux/safe_file_descriptor.hpp"
@@ -50,6 +59,12 @@ using system_error2::system_code;
 // socket-related functions. We don't force a context on basic_socket (as `Asio`
 // does) because basic_socket defines generic socket operations that are
 // independent of their context.
+//
+// The layout is packed, a server may hold millions of these: the socket type
+// shares the state byte with the state flags, the family and the protocol
+// number are kept in narrow fields and the protocol object is rebuilt on
+// demand. A default constructed socket is a null socket without a context,
+// it can be moved into later so no `std::optional` wrapper is needed.
 template <typename Protocol>
 class basic_socket : public socket_base {
  public:
@@ -60,53 +75,109 @@ class basic_socket : public socket_base {
   using socket_state = unsigned char;
   using context_type = execution_context;
 
+  // Construct a null socket. It has no context and must be move-assigned
+  // before any operation is started on it.
+  constexpr basic_socket() noexcept
+      : descriptor_(),
+        state_(0),
+        family_(AF_UNSPEC),
+        protocol_bits_(0),
+        descriptor_data_(nullptr),
+        context_(nullptr) {}
+
   // Default constructor.
   explicit constexpr basic_socket(context_type& ctx) noexcept
-      : state_(0), protocol_(), descriptor_(), context_(ctx) {}
+      : descriptor_(),
+        state_(0),
+        family_(AF_UNSPEC),
+        protocol_bits_(0),
+        descriptor_data_(nullptr),
+        context_(&ctx) {}
 
   // Constructor with specific protocol and create a new descriptor.
   constexpr basic_socket(context_type& ctx, const protocol_type& protocol,
                          system_code& code) noexcept
-      : context_(ctx) {
+      : basic_socket(ctx) {
     code = basic_socket::open(protocol);
   }
 
   // Constructor with native socket and specific protocol.
   constexpr basic_socket(context_type& ctx, const protocol_type& protocol,
                          native_handle_type fd) noexcept
-      : context_(ctx) {
+      : basic_socket(ctx) {
     assign(protocol, fd);
   }
 
   // Move constructor.
   // The file descriptor of the moved socket will be set to invalid.
   constexpr basic_socket(basic_socket&& o) noexcept
-      : state_(static_cast<socket_state&&>(o.state_)),
-        protocol_(static_cast<std::optional<protocol_type>&&>(o.protocol_)),
-        descriptor_(static_cast<exec::safe_file_descriptor&&>(o.descriptor_)),
+      : descriptor_(static_cast<exec::safe_file_descriptor&&>(o.descriptor_)),
+        state_(o.state_),
+        family_(o.family_),
+        protocol_bits_(o.protocol_bits_),
+        descriptor_data_(std::exchange(o.descriptor_data_, nullptr)),
         context_(o.context_) {}
 
   // Move assign.
   constexpr basic_socket& operator=(basic_socket&& other) noexcept {
-    state_ = static_cast<socket_state&&>(other.state_);
-    protocol_ = static_cast<std::optional<protocol_type>&&>(other.protocol_);
+    release_descriptor_data();
     descriptor_ = static_cast<exec::safe_file_descriptor&&>(other.descriptor_);
+    state_ = other.state_;
+    family_ = other.family_;
+    protocol_bits_ = other.protocol_bits_;
+    descriptor_data_ = std::exchange(other.descriptor_data_, nullptr);
     context_ = other.context_;
     return *this;
   }
 
-  constexpr ~basic_socket() = default;
+  // Destructor.
+  constexpr ~basic_socket() {
+    static_assert(sizeof(basic_socket) ==
+                      sizeof(native_handle_type) + 4 + 2 * sizeof(void*),
+                  "basic_socket is expected to stay packed");
+    release_descriptor_data();
+  }
+
+  // Check whether this is a null socket, i.e. it has no associated context.
+  constexpr bool is_null() const noexcept { return context_ == nullptr; }
 
-  // Get associated context.
-  constexpr context_type& context() noexcept { return context_; }
+  // Get associated context. Must not be called on a null socket.
+  constexpr context_type& context() noexcept { return *context_; }
+
+  // Hand this socket over to `ctx`. The per-descriptor state attached by the
+  // current context is released, the new one attaches its own on the next
+  // operation. No operation may be pending on the socket, see `async_migrate`
+  // to move it between running epoll contexts.
+  constexpr void rebind(context_type& ctx) noexcept {
+    release_descriptor_data();
+    context_ = &ctx;
+  }
 
   // Get the native socket representation.
   constexpr native_handle_type native_handle() const noexcept {
     return descriptor_.native_handle();
   }
 
-  // Get associated protocol.
-  constexpr protocol_type protocol() const noexcept { return *protocol_; }
+  // Get the opaque per-descriptor state attached by the associated context.
+  constexpr void*& descriptor_data() noexcept { return descriptor_data_; }
+
+  // Check whether a protocol has been associated by open() or assign().
+  constexpr bool has_protocol() const noexcept {
+    return family_ != AF_UNSPEC;
+  }
+
+  // Get associated protocol. Only meaningful if has_protocol() is true.
+  constexpr protocol_type protocol() const noexcept {
+    int type = protocol_bits_ >> type_shift;
+    int protocol = protocol_bits_ & protocol_mask;
+    if constexpr (std::is_constructible_v<protocol_type, int, int, int>) {
+      return protocol_type(family_, type, protocol);
+    } else if constexpr (std::is_constructible_v<protocol_type, int>) {
+      return protocol_type(family_);
+    } else {
+      return protocol_type();
+    }
+  }
 
   // Get associated state.
   constexpr socket_state state() const noexcept { return state_; }
@@ -155,7 +226,7 @@ class basic_socket : public socket_base {
     } else {
       set_state(0);
     }
-    protocol_ = protocol;
+    store_protocol(protocol);
     return errc::success;
   }
 
@@ -167,6 +238,7 @@ class basic_socket : public socket_base {
   // Assign a native file descriptor with specified protocol to this socket.
   constexpr void assign(const protocol_type& protocol,
                         native_handle_type fd) noexcept {
+    release_descriptor_data();
     descriptor_.reset(fd);
     if (protocol.type() == SOCK_STREAM) {
       set_state(stream_oriented);
@@ -175,7 +247,7 @@ class basic_socket : public socket_base {
     } else {
       set_state(0);
     }
-    protocol_ = protocol;
+    store_protocol(protocol);
   }
 
   // Close this socket and reset descriptor. state and protocol are not reset.
@@ -183,6 +255,7 @@ class basic_socket : public socket_base {
     if (descriptor_ == invalid_socket_fd) {
       return errc::bad_file_descriptor;
     }
+    release_descriptor_data();
     if (::close(descriptor_) != 0) {
       // According to UNIX Network Programming Vol. 1, it is possible for
       // close() to fail with EWOULDBLOCK under certain circumstances. What
@@ -218,6 +291,7 @@ class basic_socket : public socket_base {
     if (::shutdown(descriptor_, static_cast<int>(what)) != 0) {
       return system_error2::posix_code::current();
     }
+    release_descriptor_data();
     descriptor_.reset();
     return errc::success;
   }
@@ -343,6 +417,27 @@ class basic_socket : public socket_base {
     return errc::success;
   }
 
+  // Convert a native address of `size` bytes, e.g. the source address of a
+  // datagram, to an endpoint.
+  static constexpr result<endpoint_type> make_endpoint(
+      const ::sockaddr_storage& storage,
+      ::socklen_t size = sizeof(::sockaddr_storage)) noexcept {
+    if constexpr (std::is_constructible_v<endpoint_type, const ::sockaddr_un&,
+                                          ::socklen_t>) {
+      if (storage.ss_family == AF_UNIX) {
+        return endpoint_type{*reinterpret_cast<const sockaddr_un*>(&storage),
+                             size};
+      }
+      return errc::address_family_not_supported;
+    } else if (storage.ss_family == AF_INET6) {
+      return endpoint_type{*reinterpret_cast<const sockaddr_in6*>(&storage)};
+    } else if (storage.ss_family == AF_INET) {
+      return endpoint_type{*reinterpret_cast<const sockaddr_in*>(&storage)};
+    } else {
+      return errc::address_family_not_supported;
+    }
+  }
+
   // Provides an endpoint, which is set when getsockname executes successfully.
   constexpr result<endpoint_type> getsockname() const noexcept {
     ::sockaddr_storage storage;
@@ -351,13 +446,7 @@ class basic_socket : public socket_base {
                       &size) != 0) {
       return system_error2::posix_code::current();
     }
-    if (storage.ss_family == AF_INET6) {
-      return endpoint_type{*reinterpret_cast<sockaddr_in6*>(&storage)};
-    } else if (storage.ss_family == AF_INET) {
-      return endpoint_type{*reinterpret_cast<sockaddr_in*>(&storage)};
-    } else {
-      return errc::address_family_not_supported;
-    }
+    return make_endpoint(storage, size);
   }
 
   // Provides an endpoint, which is set when getpeername executes successfully.
@@ -368,13 +457,7 @@ class basic_socket : public socket_base {
                       &size) != 0) {
       return system_error2::posix_code::current();
     }
-    if (storage.ss_family == AF_INET6) {
-      return endpoint_type{*reinterpret_cast<sockaddr_in6*>(&storage)};
-    } else if (storage.ss_family == AF_INET) {
-      return endpoint_type{*reinterpret_cast<sockaddr_in*>(&storage)};
-    } else {
-      return errc::address_family_not_supported;
-    }
+    return make_endpoint(storage, size);
   }
 
   // Get the local endpoint.
@@ -464,31 +547,46 @@ class basic_socket : public socket_base {
   // Get option for this socket.
   template <typename Option>
   constexpr system_code get_option(Option& option) const noexcept {
-    ::socklen_t size = static_cast<::socklen_t>(option.size(protocol_));
-    return basic_socket::getsockopt(option.level(protocol_),
-                                    option.name(protocol_),
-                                    option.data(protocol_), &size);
+    protocol_type protocol = basic_socket::protocol();
+    ::socklen_t size = static_cast<::socklen_t>(option.size(protocol));
+    return basic_socket::getsockopt(option.level(protocol),
+                                    option.name(protocol),
+                                    option.data(protocol), &size);
   }
 
   // TODO(xiaoming): add concept for Option
   template <typename Option>
   constexpr system_code set_option(const Option& option) noexcept {
+    protocol_type protocol = basic_socket::protocol();
     return basic_socket::setsockopt(
-        option.level(protocol_), option.name(protocol_), option.data(protocol_),
-        option.size(protocol_));
+        option.level(protocol), option.name(protocol), option.data(protocol),
+        option.size(protocol));
   }
 
-  // Accept a new connection.
-  constexpr result<socket_type> accept() const noexcept {
+  // Accept a new connection. `flags` is passed to accept4, SOCK_NONBLOCK puts
+  // the new socket into non-blocking mode without an extra syscall. If
+  // `peer` isn't null it receives the address of the peer and `*size` its
+  // length, which saves a getpeername per connection.
+  constexpr result<socket_type> accept(
+      int flags = 0, ::sockaddr_storage* peer = nullptr,
+      ::socklen_t* size = nullptr) const noexcept {
     if (descriptor_ == invalid_socket_fd) {
       return errc::bad_file_descriptor;
     }
 
-    int new_fd = ::accept(descriptor_, nullptr, 0);
+    if (peer != nullptr) {
+      *size = static_cast<::socklen_t>(sizeof(*peer));
+    }
+    int new_fd = ::accept4(descriptor_, reinterpret_cast<::sockaddr*>(peer),
+                           peer != nullptr ? size : nullptr, flags);
     if (new_fd == invalid_socket_fd) {
       return system_error2::posix_code::current();
     }
-    return socket_type{context_, protocol(), new_fd};
+    socket_type socket{*context_, protocol(), new_fd};
+    if (flags & SOCK_NONBLOCK) {
+      static_cast<basic_socket&>(socket).state_ |= non_blocking;
+    }
+    return socket;
   }
 
   // Accept a new connection.
@@ -526,11 +624,14 @@ class basic_socket : public socket_base {
     }
   }
 
-  // Accept a new connection without blocking.
-  constexpr result<socket_type> non_blocking_accept() const noexcept {
+  // Accept a new connection without blocking. `flags` is passed to accept4,
+  // `peer` and `size` are as for `accept`.
+  constexpr result<socket_type> non_blocking_accept(
+      int flags = 0, ::sockaddr_storage* peer = nullptr,
+      ::socklen_t* size = nullptr) const noexcept {
     while (true) {
       // Accept the waiting connection.
-      auto res = basic_socket::accept();
+      auto res = basic_socket::accept(flags, peer, size);
 
       // Retry operation if interrupted by signal.
       if (!res.has_value() && res.error() == errc::interrupted) {
@@ -588,7 +689,8 @@ class basic_socket : public socket_base {
     return getsockopt(SOL_SOCKET, SO_ERROR, &connect_error, &len);
   }
 
-  // Connect to peer without blocking.
+  // Check the result of a connect to peer which is in progress, without
+  // blocking. Returns operation_in_progress if it's not finished yet.
   constexpr system_code non_blocking_connect(
       const endpoint_type& peer_endpoint) const noexcept {
     pollfd fds{descriptor_, POLLOUT, 0};
@@ -599,12 +701,14 @@ class basic_socket : public socket_base {
     // Get the error informations from the connect operation.
     int connect_error = 0;
     ::socklen_t len = static_cast<::socklen_t>(sizeof(connect_error));
-    if (getsockopt(SOL_SOCKET, SO_ERROR, &connect_error, &len).success()) {
-      if (connect_error) {
-        return system_error2::posix_code{connect_error};
-      }
+    if (system_code ec = getsockopt(SOL_SOCKET, SO_ERROR, &connect_error, &len);
+        ec.failure()) {
+      return ec;
     }
-    return errc::unknown;
+    if (connect_error) {
+      return system_error2::posix_code{connect_error};
+    }
+    return errc::success;
   }
 
   // Recvmsg.
@@ -668,19 +772,38 @@ class basic_socket : public socket_base {
     }
   }
 
-  // Recvmsg from
-  constexpr result<size_t> recvmsg_from(iovec* bufs, size_t count, int flags,
-                                        void* addr, int* addrlen) noexcept {
+  // Recvmsg from. If `segment_size` isn't null, it is assigned the size of
+  // the segments coalesced by UDP_GRO into the received data, or zero if the
+  // data is a single datagram.
+  constexpr result<size_t> recvmsg_from(
+      iovec* bufs, size_t count, int flags, void* addr, int* addrlen,
+      uint16_t* segment_size = nullptr) noexcept {
     msghdr msg = msghdr();
     init_msghdr_msg_name(msg.msg_name, addr);
     msg.msg_namelen = static_cast<int>(*addrlen);
     msg.msg_iov = bufs;
     msg.msg_iovlen = static_cast<int>(count);
+    alignas(::cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    if (segment_size != nullptr) {
+      *segment_size = 0;
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof(control);
+    }
     int32_t result = ::recvmsg(descriptor_, &msg, flags);
     if (result < 0) {
       return system_error2::posix_code::current();
     }
     *addrlen = msg.msg_namelen;
+    if (segment_size != nullptr) {
+      for (::cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+           cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+          int size = 0;
+          std::memcpy(&size, CMSG_DATA(cmsg), sizeof(size));
+          *segment_size = static_cast<uint16_t>(size);
+        }
+      }
+    }
     return static_cast<size_t>(result);
   }
 
@@ -715,12 +838,13 @@ class basic_socket : public socket_base {
   }
 
   // Recvmsg without blocking.
-  constexpr result<size_t> non_blocking_recvmsg_from(iovec* bufs, size_t count,
-                                                     int flags, void* addr,
-                                                     int* addrlen) noexcept {
+  constexpr result<size_t> non_blocking_recvmsg_from(
+      iovec* bufs, size_t count, int flags, void* addr, int* addrlen,
+      uint16_t* segment_size = nullptr) noexcept {
     while (true) {
       // Read some data.
-      auto res = basic_socket::recvmsg_from(bufs, count, flags, addr, addrlen);
+      auto res = basic_socket::recvmsg_from(bufs, count, flags, addr, addrlen,
+                                            segment_size);
 
       // Retry operation if interrupted by signal.
       if (!res.has_value() && res.error() == errc::interrupted) {
@@ -928,12 +1052,23 @@ class basic_socket : public socket_base {
     }
   }
 
-  // sendmsg_to
+  // sendmsg_to. If `segment_size` isn't zero, the data is split into
+  // datagrams of that size by UDP_SEGMENT, the last one may be shorter.
   constexpr result<size_t> sendmsg_to(iovec* bufs, uint64_t count, int flags,
-                                      const void* addr,
-                                      ::socklen_t addrlen) noexcept {
+                                      const void* addr, ::socklen_t addrlen,
+                                      uint16_t segment_size = 0) noexcept {
     msghdr msg{.msg_namelen = addrlen, .msg_iov = bufs, .msg_iovlen = count};
     init_msghdr_msg_name(msg.msg_name, addr);
+    alignas(::cmsghdr) char control[CMSG_SPACE(sizeof(uint16_t))];
+    if (segment_size != 0) {
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof(control);
+      ::cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+      cmsg->cmsg_level = SOL_UDP;
+      cmsg->cmsg_type = UDP_SEGMENT;
+      cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+      std::memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+    }
 
     int32_t result = ::sendmsg(descriptor_, &msg, flags);
     if (result < 0) {
@@ -975,9 +1110,10 @@ class basic_socket : public socket_base {
   // non_blocking_sendto
   constexpr result<size_t> non_blocking_sendmsg_to(
       iovec* bufs, uint64_t count, int flags, const void* addr,
-      ::socklen_t addrlen) noexcept {
+      ::socklen_t addrlen, uint16_t segment_size = 0) noexcept {
     while (true) {
-      auto res = basic_socket::sendmsg_to(bufs, count, flags, addr, addrlen);
+      auto res = basic_socket::sendmsg_to(bufs, count, flags, addr, addrlen,
+                                          segment_size);
       if (res.has_value()) {
         return res;
       }
@@ -1112,6 +1248,220 @@ class basic_socket : public socket_base {
     }
   }
 
+  // Send up to `count` bytes of the file `in_fd` starting at `*offset`, which
+  // is advanced by the count of bytes sent. The data is copied by the kernel
+  // without passing through user space.
+  constexpr result<size_t> sendfile(int in_fd, ::off_t* offset,
+                                    size_t count) noexcept {
+    ::ssize_t result = ::sendfile(descriptor_, in_fd, offset, count);
+    if (result < 0) {
+      return system_error2::posix_code::current();
+    }
+    return static_cast<size_t>(result);
+  }
+
+  // sendfile without blocking.
+  constexpr result<size_t> non_blocking_sendfile(int in_fd, ::off_t* offset,
+                                                 size_t count) noexcept {
+    while (true) {
+      auto res = basic_socket::sendfile(in_fd, offset, count);
+      if (res.has_value()) {
+        return res;
+      }
+
+      // Retry operation if interrupted by signal.
+      if (res.error() == errc::interrupted) {
+        continue;
+      }
+      return res;
+    }
+  }
+
+  // Receive up to `count` messages with one system call. Returns the count of
+  // messages received, the length of each is stored in its `msg_len`.
+  constexpr result<size_t> recvmmsg(::mmsghdr* msgs, unsigned int count,
+                                    int flags) noexcept {
+    int result = ::recvmmsg(descriptor_, msgs, count, flags, nullptr);
+    if (result < 0) {
+      return system_error2::posix_code::current();
+    }
+    return static_cast<size_t>(result);
+  }
+
+  // recvmmsg without blocking.
+  constexpr result<size_t> non_blocking_recvmmsg(::mmsghdr* msgs,
+                                                 unsigned int count,
+                                                 int flags) noexcept {
+    while (true) {
+      auto res = basic_socket::recvmmsg(msgs, count, flags);
+      if (res.has_value()) {
+        return res;
+      }
+
+      // Retry operation if interrupted by signal.
+      if (res.error() == errc::interrupted) {
+        continue;
+      }
+      return res;
+    }
+  }
+
+  // Send up to `count` messages with one system call. Returns the count of
+  // messages sent.
+  constexpr result<size_t> sendmmsg(::mmsghdr* msgs, unsigned int count,
+                                    int flags) noexcept {
+    int result = ::sendmmsg(descriptor_, msgs, count, flags);
+    if (result < 0) {
+      return system_error2::posix_code::current();
+    }
+    return static_cast<size_t>(result);
+  }
+
+  // sendmmsg without blocking.
+  constexpr result<size_t> non_blocking_sendmmsg(::mmsghdr* msgs,
+                                                 unsigned int count,
+                                                 int flags) noexcept {
+    while (true) {
+      auto res = basic_socket::sendmmsg(msgs, count, flags);
+      if (res.has_value()) {
+        return res;
+      }
+
+      // Retry operation if interrupted by signal.
+      if (res.error() == errc::interrupted) {
+        continue;
+      }
+      return res;
+    }
+  }
+
+  // The most descriptors passed with one message, SCM_MAX_FD of the kernel.
+  static constexpr size_t max_passed_fds = 253;
+
+  // Send `size` bytes along with `fd_count` descriptors over a unix domain
+  // socket (SCM_RIGHTS). The peer receives duplicates, the caller still owns
+  // `fds`. At least one byte has to be sent. Does not block.
+  constexpr result<size_t> non_blocking_send_fds(const void* data,
+                                                 size_t size, const int* fds,
+                                                 size_t fd_count) noexcept {
+    if (fd_count == 0 || fd_count > max_passed_fds || size == 0) {
+      return errc::invalid_argument;
+    }
+    alignas(::cmsghdr) char control[CMSG_SPACE(sizeof(int) * max_passed_fds)];
+    iovec iov{.iov_base = const_cast<void*>(data), .iov_len = size};
+    msghdr msg{.msg_iov = &iov,
+               .msg_iovlen = 1,
+               .msg_control = control,
+               .msg_controllen = CMSG_SPACE(sizeof(int) * fd_count)};
+    ::cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fd_count);
+    std::memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * fd_count);
+    while (true) {
+      ssize_t result = ::sendmsg(descriptor_, &msg, MSG_NOSIGNAL);
+      if (result < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return system_error2::posix_code::current();
+      }
+      return static_cast<size_t>(result);
+    }
+  }
+
+  // Receive up to `size` bytes and the descriptors sent along with them over
+  // a unix domain socket. Up to `max_fds` descriptors are stored to `fds`,
+  // close-on-exec and owned by the caller, `fd_count` is assigned their
+  // count. If more were sent, the kernel drops the excess, so the received
+  // ones are closed and `errc::message_size` is returned. Does not block.
+  constexpr result<size_t> non_blocking_recv_fds(void* data, size_t size,
+                                                 int* fds, size_t max_fds,
+                                                 size_t& fd_count) noexcept {
+    fd_count = 0;
+    max_fds = std::min(max_fds, max_passed_fds);
+    alignas(::cmsghdr) char control[CMSG_SPACE(sizeof(int) * max_passed_fds)];
+    iovec iov{.iov_base = data, .iov_len = size};
+    while (true) {
+      msghdr msg{.msg_iov = &iov,
+                 .msg_iovlen = 1,
+                 .msg_control = control,
+                 .msg_controllen = CMSG_SPACE(sizeof(int) * max_fds)};
+      ssize_t result = ::recvmsg(descriptor_, &msg, MSG_CMSG_CLOEXEC);
+      if (result < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return system_error2::posix_code::current();
+      }
+      for (::cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+           cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+          continue;
+        }
+        const size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        const size_t stored = std::min(count, max_fds - fd_count);
+        std::memcpy(fds + fd_count, CMSG_DATA(cmsg), sizeof(int) * stored);
+        fd_count += stored;
+      }
+      if ((msg.msg_flags & MSG_CTRUNC) != 0) {
+        for (size_t i = 0; i < fd_count; ++i) {
+          ::close(fds[i]);
+        }
+        fd_count = 0;
+        return errc::message_size;
+      }
+      return static_cast<size_t>(result);
+    }
+  }
+
+  // Recvmsg without blocking, along with the kernel receive timestamps of the
+  // data, see `socket_base::timestamping`. Timestamps the kernel didn't
+  // report are zero.
+  constexpr result<size_t> non_blocking_recvmsg_timestamped(
+      iovec* bufs, size_t count, int flags,
+      receive_timestamps& timestamps) noexcept {
+    timestamps = receive_timestamps{};
+    // Room for SCM_TIMESTAMPING, or the single SCM_TIMESTAMPNS of
+    // SO_TIMESTAMPNS.
+    alignas(::cmsghdr) char control[CMSG_SPACE(sizeof(::timespec) * 3)];
+    while (true) {
+      msghdr msg{.msg_iov = bufs,
+                 .msg_iovlen = count,
+                 .msg_control = control,
+                 .msg_controllen = sizeof(control)};
+      ssize_t result = ::recvmsg(descriptor_, &msg, flags);
+      if (result < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return system_error2::posix_code::current();
+      }
+      auto to_duration = [](const ::timespec& ts) noexcept {
+        return std::chrono::seconds(ts.tv_sec) +
+               std::chrono::nanoseconds(ts.tv_nsec);
+      };
+      for (::cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+           cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET) {
+          continue;
+        }
+        if (cmsg->cmsg_type == SCM_TIMESTAMPING) {
+          // The software, a legacy and the raw hardware timestamp.
+          ::timespec ts[3];
+          std::memcpy(ts, CMSG_DATA(cmsg), sizeof(ts));
+          timestamps.software = to_duration(ts[0]);
+          timestamps.hardware = to_duration(ts[2]);
+        } else if (cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+          ::timespec ts;
+          std::memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+          timestamps.software = to_duration(ts);
+        }
+      }
+      return static_cast<size_t>(result);
+    }
+  }
+
   // select
   constexpr result<size_t> select(int nfds, fd_set* readfds, fd_set* writefds,
                                   fd_set* exceptfds,
@@ -1151,6 +1501,21 @@ class basic_socket : public socket_base {
     return value;
   }
 
+  // Determine the number of bytes in the kernel send queue, the ones not yet
+  // sent plus, for TCP, the ones not yet acknowledged by the peer.
+  constexpr result<std::size_t> unsent() const noexcept {
+    if (descriptor_ == invalid_socket_fd) {
+      return errc::bad_file_descriptor;
+    }
+
+    int value = 0;
+    if (::ioctl(descriptor_, SIOCOUTQ, &value) != 0) {
+      return system_error2::posix_code::current();
+    }
+
+    return static_cast<std::size_t>(value);
+  }
+
   constexpr system_code ioctl(int cmd, int* arg) noexcept {
     if (descriptor_ == invalid_socket_fd) {
       return errc::bad_file_descriptor;
@@ -1224,10 +1589,38 @@ class basic_socket : public socket_base {
     b.iov_len = size;
   }
 
-  socket_state state_;
-  std::optional<protocol_type> protocol_;
+  // Let the associated context release the per-descriptor state before the
+  // descriptor is closed.
+  constexpr void release_descriptor_data() noexcept {
+    if (descriptor_data_ != nullptr) {
+      context_->deregister_descriptor(descriptor_, descriptor_data_);
+    }
+  }
+
+  // state_ holds only the state flags. The socket type lives in the top bits
+  // of protocol_bits_, above the protocol number.
+  static_assert(exclusive_wakeup < (1u << (8 * sizeof(socket_state))),
+                "all socket state flags must fit in socket_state");
+  static constexpr int type_shift = 12;
+  static constexpr std::uint16_t protocol_mask = (1 << type_shift) - 1;
+
+  // Pack the protocol into family_ and protocol_bits_.
+  constexpr void store_protocol(const protocol_type& protocol) noexcept {
+    assert(protocol.family() > AF_UNSPEC && protocol.family() <= UINT8_MAX);
+    assert(protocol.type() >= 0 &&
+           protocol.type() <= (UINT16_MAX >> type_shift));
+    assert(protocol.protocol() >= 0 && protocol.protocol() <= protocol_mask);
+    family_ = static_cast<std::uint8_t>(protocol.family());
+    protocol_bits_ = static_cast<std::uint16_t>(
+        (protocol.type() << type_shift) | protocol.protocol());
+  }
+
   exec::safe_file_descriptor descriptor_;
-  context_type& context_;
+  socket_state state_;
+  std::uint8_t family_;
+  std::uint16_t protocol_bits_;
+  void* descriptor_data_;
+  context_type* context_;
 };
 
 }  // namespace net
@@ -16,6 +16,10 @@
 #ifndef BASIC_SOCKET_ACCEPTOR_HPP_
 #define BASIC_SOCKET_ACCEPTOR_HPP_
 
+#include <linux/filter.h>
+#include <sys/socket.h>
+
+#include <cstddef>
 #include <utility>
 
 #include "basic_socket.hpp"
@@ -45,6 +49,9 @@ class basic_socket_acceptor : public basic_socket<Protocol> {
   // The context_type
   using context_type = typename basic_socket<protocol_type>::context_type;
 
+  // Construct a null acceptor, see basic_socket.
+  constexpr basic_socket_acceptor() noexcept = default;
+
   // Construct an acceptor without opening it.
   explicit constexpr basic_socket_acceptor(context_type& ctx) noexcept
       : basic_socket<protocol_type>(ctx) {}
@@ -57,11 +64,19 @@ class basic_socket_acceptor : public basic_socket<Protocol> {
   constexpr basic_socket_acceptor& operator=(
       basic_socket_acceptor&& other) noexcept = default;
 
+  // Construct an acceptor from a native listening socket, e.g. one inherited
+  // from the service manager.
+  constexpr basic_socket_acceptor(context_type& ctx,
+                                  const protocol_type& protocol,
+                                  native_handle_type fd) noexcept
+      : basic_socket<protocol_type>(ctx, protocol, fd) {}
+
   // Construct an acceptor opened on the given endpoint.
   constexpr basic_socket_acceptor(context_type& ctx,
                                   const endpoint_type& endpoint,
                                   system_error2::system_code& ec,
-                                  bool reuse_addr = true) noexcept
+                                  bool reuse_addr = true,
+                                  bool reuse_port = false) noexcept
       : basic_socket<Protocol>(ctx) {
     if (ec = basic_socket<Protocol>::open(endpoint.protocol()); ec.failure()) {
       return;
@@ -74,6 +89,13 @@ class basic_socket_acceptor : public basic_socket<Protocol> {
         return;
     }
 
+    if (reuse_port) {
+      if (ec = basic_socket<Protocol>::set_option(
+              socket_base::reuse_port{true});
+          ec.failure())
+        return;
+    }
+
     if (ec = basic_socket<Protocol>::bind(endpoint); ec.failure()) {
       return;
     }
@@ -87,6 +109,57 @@ class basic_socket_acceptor : public basic_socket<Protocol> {
   // Destroys the acceptor.
   constexpr ~basic_socket_acceptor() noexcept = default;
 
+  // Wake up only one of the contexts waiting on this acceptor for each
+  // incoming connection. This lets several contexts share one listening
+  // socket without a thundering herd when SO_REUSEPORT sharding isn't
+  // possible. Must be set before the first asynchronous operation starts.
+  constexpr void set_exclusive_wakeup(bool mode) noexcept {
+    auto state = basic_socket<protocol_type>::state();
+    basic_socket<protocol_type>::set_state(
+        mode ? (state | exclusive_wakeup) : (state & ~exclusive_wakeup));
+  }
+
+  // Check whether only one waiting context is woken up for each connection.
+  constexpr bool is_exclusive_wakeup() const noexcept {
+    return (basic_socket<protocol_type>::state() & exclusive_wakeup) != 0;
+  }
+
+  // Set `option` once for every connection this acceptor accepts, which
+  // inherit it from the listening socket without a setsockopt of their own.
+  template <typename Option>
+    requires socket_option::inherited_by_accept<Option>
+  constexpr system_code set_inherited_option(const Option& option) noexcept {
+    return basic_socket<protocol_type>::set_option(option);
+  }
+
+  // Pick the acceptor of each new connection in the SO_REUSEPORT group of
+  // this acceptor with a classic BPF program instead of the kernel's hash.
+  // The program returns the index of the acceptor in the group, in the order
+  // they were bound, an index out of range falls back to the hash. The
+  // program applies to the whole group, attach it to any one acceptor.
+  system_code attach_reuseport_cbpf(const sock_filter* code,
+                                    std::size_t count) noexcept {
+    sock_fprog prog{static_cast<unsigned short>(count),  // NOLINT
+                    const_cast<sock_filter*>(code)};
+    return basic_socket<protocol_type>::setsockopt(
+        SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog));
+  }
+
+  // Like `attach_reuseport_cbpf`, with a loaded eBPF program of type
+  // BPF_PROG_TYPE_SK_REUSEPORT, e.g. one that reads the load of each
+  // context from a map.
+  system_code attach_reuseport_ebpf(int program_fd) noexcept {
+    return basic_socket<protocol_type>::setsockopt(
+        SOL_SOCKET, SO_ATTACH_REUSEPORT_EBPF, &program_fd, sizeof(program_fd));
+  }
+
+  // Go back to hashing, needs Linux 5.3 or later.
+  system_code detach_reuseport_bpf() noexcept {
+    int unused = 0;
+    return basic_socket<protocol_type>::setsockopt(
+        SOL_SOCKET, SO_DETACH_REUSEPORT_BPF, &unused, sizeof(unused));
+  }
+
  private:
   basic_socket_acceptor(const basic_socket_acceptor&) = delete;
   basic_socket_acceptor& operator=(const basic_socket_acceptor&) = delete;
@@ -16,9 +16,24 @@
 #ifndef BASIC_STREAM_SOCKET_HPP_
 #define BASIC_STREAM_SOCKET_HPP_
 
+#include <linux/tls.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include <concepts>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
 #include "basic_socket.hpp"
 
 namespace net {
+// The crypto info structures of <linux/tls.h>, e.g.
+// `tls12_crypto_info_aes_gcm_128`, which all start with the version and the
+// cipher type.
+template <typename T>
+concept ktls_crypto_info = std::same_as<decltype(T::info), ::tls_crypto_info>;
+
 // Provides stream-oriented socket functionality.
 template <typename Protocol>
 class basic_stream_socket : public basic_socket<Protocol> {
@@ -38,6 +53,9 @@ class basic_stream_socket : public basic_socket<Protocol> {
   // The context_type
   using context_type = typename basic_socket<protocol_type>::context_type;
 
+  // Construct a null basic_stream_socket, see basic_socket.
+  constexpr basic_stream_socket() noexcept = default;
+
   // Construct a basic_stream_socket without opening it.
   explicit constexpr basic_stream_socket(context_type& ctx) noexcept
       : basic_socket<protocol_type>(ctx) {}
@@ -58,6 +76,91 @@ class basic_stream_socket : public basic_socket<Protocol> {
   // Destroys the socket.
   constexpr ~basic_stream_socket() noexcept = default;
 
+  // The directions of kernel TLS.
+  enum class tls_direction { tx = TLS_TX, rx = TLS_RX };
+
+  // The TLS content type of application data records.
+  static constexpr uint8_t tls_application_data = 23;
+
+  // The name of the kernel TLS upper layer protocol.
+  static constexpr char tls_ulp[] = "tls";
+
+  // Attach the "tls" upper layer protocol, the first step of kernel TLS once
+  // the handshake has been done in user space. Fails with
+  // `errc::no_such_file_or_directory` if the kernel has no TLS support.
+  constexpr system_code enable_tls() noexcept {
+    return this->setsockopt(SOL_TCP, TCP_ULP, tls_ulp, sizeof(tls_ulp));
+  }
+
+  // Hand the keys negotiated by the handshake to the kernel. From then on the
+  // data sent or received in `direction`, e.g. by `async_send_some` or
+  // sendfile, is encrypted or decrypted by the kernel or the NIC.
+  template <ktls_crypto_info CryptoInfo>
+  constexpr system_code set_tls_crypto(tls_direction direction,
+                                       const CryptoInfo& info) noexcept {
+    return this->setsockopt(SOL_TLS, static_cast<int>(direction), &info,
+                            sizeof(info));
+  }
+
+  // Receive the payload of TLS records once `tls_direction::rx` is set. A
+  // single call never mixes records of different types, `record_type` is
+  // assigned the type of the received ones, e.g. an alert or a handshake
+  // message after the application data. Does not block.
+  constexpr result<size_t> non_blocking_recv_tls_record(
+      iovec* bufs, size_t count, uint8_t& record_type) noexcept {
+    alignas(::cmsghdr) char control[CMSG_SPACE(sizeof(uint8_t))];
+    while (true) {
+      msghdr msg{.msg_iov = bufs,
+                 .msg_iovlen = count,
+                 .msg_control = control,
+                 .msg_controllen = sizeof(control)};
+      ssize_t result = ::recvmsg(this->native_handle(), &msg, 0);
+      if (result < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return system_error2::posix_code::current();
+      }
+      record_type = tls_application_data;
+      for (::cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+           cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_TLS &&
+            cmsg->cmsg_type == TLS_GET_RECORD_TYPE) {
+          std::memcpy(&record_type, CMSG_DATA(cmsg), sizeof(record_type));
+        }
+      }
+      return static_cast<size_t>(result);
+    }
+  }
+
+  // Send `size` bytes as a TLS record of `record_type` once
+  // `tls_direction::tx` is set, e.g. a close_notify alert. Plain sends are
+  // application data. Does not block.
+  constexpr result<size_t> non_blocking_send_tls_record(
+      const void* data, size_t size, uint8_t record_type) noexcept {
+    alignas(::cmsghdr) char control[CMSG_SPACE(sizeof(uint8_t))] = {};
+    iovec iov{.iov_base = const_cast<void*>(data), .iov_len = size};
+    msghdr msg{.msg_iov = &iov,
+               .msg_iovlen = 1,
+               .msg_control = control,
+               .msg_controllen = sizeof(control)};
+    ::cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_TLS;
+    cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(record_type));
+    std::memcpy(CMSG_DATA(cmsg), &record_type, sizeof(record_type));
+    while (true) {
+      ssize_t result = ::sendmsg(this->native_handle(), &msg, MSG_NOSIGNAL);
+      if (result < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return system_error2::posix_code::current();
+      }
+      return static_cast<size_t>(result);
+    }
+  }
+
  private:
   // Disallow copying and assignment.
   basic_stream_socket(const basic_stream_socket&) = delete;
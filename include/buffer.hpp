@@ -18,6 +18,7 @@
 
 #include <concepts>
 
+#include <algorithm>
 #include <array>
 #include <cstring>
 #include <iterator>
@@ -747,12 +748,54 @@ inline constexpr dynamic_vector_buffer<Elem, Allocator> dynamic_buffer(
   return dynamic_vector_buffer<Elem, Allocator>(data, max_size);
 }
 
+// Fragments up to this size are copied inline instead of through a library
+// memcpy call. Scatter-gather headers are usually made of such fragments.
+inline constexpr std::size_t small_copy_threshold = 64;
+
+// Copies `n <= small_copy_threshold` bytes with at most two overlapping
+// fixed-width moves per size class. Fixed-size memcpy calls are lowered to
+// plain (vector) loads and stores by the compiler, so no call and no byte
+// loop is emitted. All loads happen before the stores of each step, which
+// keeps the overlapping head/tail pairs correct.
+inline void small_copy(void* target, const void* source,
+                       std::size_t n) noexcept {
+  auto* d = static_cast<unsigned char*>(target);
+  const auto* s = static_cast<const unsigned char*>(source);
+  auto move2 = [d, s, n]<std::size_t W>(std::integral_constant<std::size_t, W>) {
+    unsigned char head[W];
+    unsigned char tail[W];
+    ::memcpy(head, s, W);
+    ::memcpy(tail, s + n - W, W);
+    ::memcpy(d, head, W);
+    ::memcpy(d + n - W, tail, W);
+  };
+  if (n >= 32) {
+    move2(std::integral_constant<std::size_t, 32>{});
+  } else if (n >= 16) {
+    move2(std::integral_constant<std::size_t, 16>{});
+  } else if (n >= 8) {
+    move2(std::integral_constant<std::size_t, 8>{});
+  } else if (n >= 4) {
+    move2(std::integral_constant<std::size_t, 4>{});
+  } else if (n != 0) {
+    // 1..3 bytes: first, middle and last byte cover every length.
+    unsigned char first = s[0];
+    unsigned char middle = s[n / 2];
+    unsigned char last = s[n - 1];
+    d[0] = first;
+    d[n / 2] = middle;
+    d[n - 1] = last;
+  }
+}
+
 inline std::size_t buffer_copy_1(const mutable_buffer& target,
                                  const const_buffer& source) {
   std::size_t target_size = target.size();
   std::size_t source_size = source.size();
   std::size_t n = target_size < source_size ? target_size : source_size;
-  if (n > 0) {
+  if (n <= small_copy_threshold) {
+    small_copy(target.data(), source.data(), n);
+  } else {
     ::memcpy(target.data(), source.data(), n);
   }
   return n;
@@ -925,6 +968,73 @@ inline std::size_t buffer_copy(const MutableBufferSequence& target,
                      max_bytes_to_copy);
 }
 
+// Whether `delim` starts at byte `pos` of the buffer `iter` points to. The
+// delimiter may continue into the following buffers.
+template <typename Iterator>
+bool buffer_match_at(Iterator iter, Iterator end, std::size_t pos,
+                     std::string_view delim) noexcept {
+  while (!delim.empty()) {
+    if (iter == end) {
+      return false;
+    }
+    const_buffer b{*iter};
+    std::size_t n = (std::min)(b.size() - pos, delim.size());
+    if (::memcmp(static_cast<const char*>(b.data()) + pos, delim.data(), n) !=
+        0) {
+      return false;
+    }
+    delim.remove_prefix(n);
+    pos = 0;
+    ++iter;
+  }
+  return true;
+}
+
+// Find the first occurrence of `delim` in a buffer sequence at or after byte
+// `pos`. Returns its offset from the beginning of the sequence, or
+// `std::string_view::npos`. Candidates are located with `memchr`, which the
+// C library vectorizes, and delimiters spanning two buffers are matched too.
+template <typename ConstBufferSequence>
+std::size_t buffer_find(const ConstBufferSequence& sequence,
+                        std::string_view delim, std::size_t pos = 0) noexcept {
+  if (delim.empty()) {
+    return pos <= buffer_size(sequence) ? pos : std::string_view::npos;
+  }
+  auto end = buffer_sequence_end(sequence);
+  std::size_t offset = 0;
+  for (auto iter = buffer_sequence_begin(sequence); iter != end; ++iter) {
+    const_buffer b{*iter};
+    const char* data = static_cast<const char*>(b.data());
+    std::size_t i = pos > offset ? pos - offset : 0;
+    while (i < b.size()) {
+      const void* hit = ::memchr(data + i, delim[0], b.size() - i);
+      if (hit == nullptr) {
+        break;
+      }
+      i = static_cast<std::size_t>(static_cast<const char*>(hit) - data);
+      if (buffer_match_at(iter, end, i, delim)) {
+        return offset + i;
+      }
+      ++i;
+    }
+    offset += b.size();
+  }
+  return std::string_view::npos;
+}
+
+// Concept to determine whether a type satisfies the DynamicBuffer
+// requirements: an input sequence that grows by `prepare` and `commit`.
+template <typename T>
+concept dynamic_buffer_sequence = requires(T& t, const T& ct, std::size_t n) {
+  { ct.size() } -> std::convertible_to<std::size_t>;
+  { ct.max_size() } -> std::convertible_to<std::size_t>;
+  { ct.capacity() } -> std::convertible_to<std::size_t>;
+  ct.data();
+  t.prepare(n);
+  t.commit(n);
+  t.consume(n);
+};  // NOLINT
+
 // Concept to determine whether a type satisfies the MutableBufferSequence
 // requirements.
 template <typename T>
@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef BUFFER_POOL_HPP_
+#define BUFFER_POOL_HPP_
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#include "buffer.hpp"
+#include "hugepage_arena.hpp"
+
+namespace net {
+
+class buffer_pool;
+
+// A block of a `buffer_pool` holding received bytes. The block goes back to
+// the pool when the lease is destroyed or released. Move only.
+class buffer_lease {
+ public:
+  // Constructor. The default lease holds no block.
+  constexpr buffer_lease() noexcept : block_(nullptr), size_(0) {}
+
+  buffer_lease(buffer_lease&& other) noexcept
+      : block_(std::exchange(other.block_, nullptr)),
+        size_(std::exchange(other.size_, 0)) {}
+
+  buffer_lease& operator=(buffer_lease&& other) noexcept {
+    if (this != &other) {
+      release();
+      block_ = std::exchange(other.block_, nullptr);
+      size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+  }
+
+  // Destructor.
+  ~buffer_lease() { release(); }
+
+  // Whether the lease holds a block.
+  explicit operator bool() const noexcept { return block_ != nullptr; }
+
+  // The bytes of the block.
+  std::byte* data() const noexcept;
+
+  // The count of valid bytes.
+  std::size_t size() const noexcept { return size_; }
+
+  // The size of the block.
+  std::size_t capacity() const noexcept;
+
+  // Set the count of valid bytes.
+  void resize(std::size_t size) noexcept {
+    assert(size <= capacity());
+    size_ = size;
+  }
+
+  // The valid bytes.
+  mutable_buffer buffer() const noexcept { return {data(), size_}; }
+
+  // Give the block back to its pool.
+  void release() noexcept;
+
+ private:
+  friend class buffer_pool;
+
+  struct block {
+    block* next;
+    buffer_pool* pool;
+  };
+
+  explicit buffer_lease(block* b) noexcept : block_(b), size_(0) {}
+
+  block* block_;
+  std::size_t size_;
+};
+
+// A pool of equally sized receive buffers, in the manner of the provided
+// buffers of io_uring: operations claim a block only once data is ready, so
+// idle connections hold no receive memory. Blocks are allocated in chunks and
+// kept until the pool is destroyed, which must outlive every lease.
+//
+// Blocks are only acquired by the owning thread. Leases may be released on
+// any thread, they are pushed to a lock-free list which the owning thread
+// takes over once its own free list is empty.
+class buffer_pool {
+  using block = buffer_lease::block;
+
+ public:
+  // Constructor.
+  explicit buffer_pool(std::size_t block_size = 16 * 1024,
+                       std::size_t blocks_per_chunk = 64) noexcept
+      : block_size_(block_size),
+        blocks_per_chunk_(blocks_per_chunk == 0 ? 1 : blocks_per_chunk),
+        free_(nullptr),
+        remote_free_(nullptr),
+        chunks_(nullptr),
+        arena_(nullptr),
+        block_count_(0),
+        acquired_count_(0),
+        released_count_(0) {}
+
+  buffer_pool(const buffer_pool&) = delete;
+  buffer_pool& operator=(const buffer_pool&) = delete;
+
+  // Destructor releases all chunks. Chunks carved from an arena go back with
+  // the arena.
+  ~buffer_pool() {
+    while (chunk* c = chunks_) {
+      chunks_ = c->next;
+      if (arena_ == nullptr || !arena_->contains(c)) {
+        ::operator delete(c);
+      }
+    }
+  }
+
+  // Change the size of the blocks. Only before the first block is acquired.
+  void set_block_size(std::size_t block_size) noexcept {
+    assert(block_count_ == 0);
+    block_size_ = block_size;
+  }
+
+  // Carve the chunks from `arena` while it has room, e.g. to back the blocks
+  // with hugepages. Only before the first block is acquired, the arena must
+  // outlive the pool.
+  void set_arena(hugepage_arena* arena) noexcept {
+    assert(block_count_ == 0);
+    arena_ = arena;
+  }
+
+  // Allocate chunks until at least `count` blocks exist. If `prefault` is
+  // true, the chunks are written once so their pages are faulted in now.
+  void reserve(std::size_t count, bool prefault = false) {
+    while (block_count_ < count) {
+      allocate_chunk(prefault);
+    }
+  }
+
+  // The count of blocks of a chunk.
+  std::size_t blocks_per_chunk() const noexcept { return blocks_per_chunk_; }
+
+  // The size of the memory a chunk takes.
+  std::size_t chunk_size() const noexcept {
+    return header_size + stride() * blocks_per_chunk_;
+  }
+
+  // Claim a block. Allocates a new chunk if no block is free.
+  buffer_lease acquire() {
+    if (free_ == nullptr) {
+      free_ = remote_free_.exchange(nullptr, std::memory_order_acquire);
+      if (free_ == nullptr) {
+        allocate_chunk();
+      }
+    }
+    block* b = free_;
+    free_ = b->next;
+    ++acquired_count_;
+    return buffer_lease{b};
+  }
+
+  // The size of the blocks.
+  std::size_t block_size() const noexcept { return block_size_; }
+
+  // The count of blocks allocated so far, which is the largest count of
+  // blocks leased at once.
+  std::size_t block_count() const noexcept { return block_count_; }
+
+  // The count of blocks acquired so far.
+  std::uint64_t acquired_count() const noexcept { return acquired_count_; }
+
+  // The count of blocks currently leased. Only exact on the owning thread.
+  std::uint64_t leased_count() const noexcept {
+    return acquired_count_ - released_count_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  friend class buffer_lease;
+
+  struct chunk {
+    chunk* next;
+  };
+
+  static constexpr std::size_t align_up(std::size_t size) noexcept {
+    return (size + alignof(std::max_align_t) - 1) /
+           alignof(std::max_align_t) * alignof(std::max_align_t);
+  }
+
+  // Every block starts with its header, the bytes follow it.
+  static constexpr std::size_t header_size =
+      (sizeof(block) + alignof(std::max_align_t) - 1) /
+      alignof(std::max_align_t) * alignof(std::max_align_t);
+
+  std::size_t stride() const noexcept {
+    return header_size + align_up(block_size_);
+  }
+
+  void allocate_chunk(bool prefault = false) {
+    const std::size_t stride = this->stride();
+    void* memory = arena_ != nullptr ? arena_->allocate(chunk_size()) : nullptr;
+    if (memory == nullptr) {
+      memory = ::operator new(chunk_size());
+    }
+    if (prefault) {
+      std::memset(memory, 0, chunk_size());
+    }
+    auto* c = static_cast<chunk*>(memory);
+    c->next = chunks_;
+    chunks_ = c;
+    auto* first = static_cast<std::byte*>(memory) + header_size;
+    for (std::size_t i = blocks_per_chunk_; i-- > 0;) {
+      auto* b = reinterpret_cast<block*>(first + i * stride);
+      b->pool = this;
+      b->next = free_;
+      free_ = b;
+    }
+    block_count_ += blocks_per_chunk_;
+  }
+
+  void release(block* b) noexcept {
+    released_count_.fetch_add(1, std::memory_order_relaxed);
+    block* head = remote_free_.load(std::memory_order_relaxed);
+    do {
+      b->next = head;
+    } while (!remote_free_.compare_exchange_weak(
+        head, b, std::memory_order_release, std::memory_order_relaxed));
+  }
+
+  std::size_t block_size_;
+  std::size_t blocks_per_chunk_;
+  block* free_;
+  std::atomic<block*> remote_free_;
+  chunk* chunks_;
+  hugepage_arena* arena_;
+  std::size_t block_count_;
+  std::uint64_t acquired_count_;
+  std::atomic<std::uint64_t> released_count_;
+};
+
+inline std::byte* buffer_lease::data() const noexcept {
+  return block_ == nullptr ? nullptr
+                           : reinterpret_cast<std::byte*>(block_) +
+                                 buffer_pool::header_size;
+}
+
+inline std::size_t buffer_lease::capacity() const noexcept {
+  return block_ == nullptr ? 0 : block_->pool->block_size();
+}
+
+inline void buffer_lease::release() noexcept {
+  if (block_ != nullptr) {
+    block_->pool->release(std::exchange(block_, nullptr));
+    size_ = 0;
+  }
+}
+
+}  // namespace net
+
+#endif  // BUFFER_POOL_HPP_
@@ -17,6 +17,10 @@
 #ifndef BUFFER_SEQUENCE_ADAPTER_HPP_
 #define BUFFER_SEQUENCE_ADAPTER_HPP_
 
+#include <array>
+#include <cstddef>
+#include <utility>
+
 #include "buffer.hpp"
 #include "ip/socket_types.hpp"
 
@@ -48,24 +52,70 @@ class buffer_sequence_adapter_base {
     init_iov_base(iov.iov_base, const_cast<void*>(buf.data()));
     iov.iov_len = buf.size();
   }
+
+  // Drop `size` bytes from the front of `buffers`, which holds `count` native
+  // buffers starting at `first`. Fully consumed buffers are skipped by
+  // advancing `first`, a partially consumed one is trimmed in place.
+  static constexpr void consume(native_buffer_type* buffers, std::size_t count,
+                                std::size_t& first, std::size_t size) noexcept {
+    while (size != 0 && first < count) {
+      iovec& iov = buffers[first];
+      if (size < iov.iov_len) {
+        iov.iov_base = static_cast<char*>(iov.iov_base) + size;
+        iov.iov_len -= size;
+        return;
+      }
+      size -= iov.iov_len;
+      ++first;
+    }
+  }
 };
 
+// The maximum count of native buffers translated for a single system call on
+// `Buffers`. Specialize it for a sequence type to raise the limit up to
+// `max_iov_len`, e.g. for sequences of many small fragments.
+template <typename Buffers>
+inline constexpr int max_buffers_per_call =
+    buffer_sequence_adapter_base::max_buffers;
+
 // Helper class to translate buffers into the native buffer representation.
-template <typename Buffer, typename Buffers>
+// At most `MaxBuffers` buffers are translated at once. Once they are
+// consumed, `refill` translates the next ones, so a sequence longer than that
+// can be walked by several system calls. The sequence must outlive the
+// adapter in that case.
+template <typename Buffer, typename Buffers,
+          int MaxBuffers = max_buffers_per_call<Buffers>>
 class buffer_sequence_adapter : private buffer_sequence_adapter_base {
+  static_assert(MaxBuffers > 0 && MaxBuffers <= max_iov_len,
+                "MaxBuffers must be within (0, max_iov_len]");
+
+  using iterator_t =
+      decltype(buffer_sequence_begin(std::declval<const Buffers&>()));
+
  public:
   static constexpr bool is_single_buffer = false;
   static constexpr int linearization_storage_size = 8192;
 
   explicit constexpr buffer_sequence_adapter(const Buffers& sequence) noexcept
-      : count_(0), total_buffer_size_(0) {
-    buffer_sequence_adapter::init(buffer_sequence_begin(sequence),
-                                  buffer_sequence_end(sequence));
+      : count_(0),
+        first_(0),
+        total_buffer_size_(0),
+        next_(buffer_sequence_begin(sequence)),
+        end_(buffer_sequence_end(sequence)) {
+    init();
   }
 
-  constexpr native_buffer_type* buffers() noexcept { return buffers_; }
+  constexpr native_buffer_type* buffers() noexcept { return buffers_ + first_; }
 
-  constexpr std::size_t count() const noexcept { return count_; }
+  constexpr std::size_t count() const noexcept { return count_ - first_; }
+
+  // Advance the native buffers past the first `size` bytes, so that a partial
+  // transfer can be resumed without translating the sequence again.
+  constexpr void consume(std::size_t size) noexcept {
+    size = size < total_buffer_size_ ? size : total_buffer_size_;
+    buffer_sequence_adapter_base::consume(buffers_, count_, first_, size);
+    total_buffer_size_ -= size;
+  }
 
   constexpr std::size_t total_size() const noexcept {
     return total_buffer_size_;
@@ -73,6 +123,21 @@ class buffer_sequence_adapter : private buffer_sequence_adapter_base {
 
   constexpr bool all_empty() const noexcept { return total_buffer_size_ == 0; }
 
+  // Whether buffers of the sequence are left beyond the translated ones.
+  constexpr bool more() const noexcept { return next_ != end_; }
+
+  // Translate the next buffers of the sequence once the current ones are all
+  // consumed. Returns false if there is nothing left to translate.
+  constexpr bool refill() noexcept {
+    if (!all_empty() || next_ == end_) {
+      return false;
+    }
+    count_ = 0;
+    first_ = 0;
+    init();
+    return true;
+  }
+
   static constexpr bool all_empty(const Buffers& sequence) noexcept {
     return buffer_sequence_adapter::all_empty(buffer_sequence_begin(sequence),
                                               buffer_sequence_end(sequence));
@@ -91,11 +156,9 @@ class buffer_sequence_adapter : private buffer_sequence_adapter_base {
   }
 
  private:
-  template <typename Iterator>
-  void init(Iterator begin, Iterator end) {
-    for (Iterator iter = begin; iter != end && count_ < max_buffers;
-         ++iter, ++count_) {
-      Buffer buffer{*iter};
+  constexpr void init() noexcept {
+    for (; next_ != end_ && count_ < MaxBuffers; ++next_, ++count_) {
+      Buffer buffer{*next_};
       init_native_buffer(buffers_[count_], buffer);
       total_buffer_size_ += buffer.size();
     }
@@ -103,8 +166,7 @@ class buffer_sequence_adapter : private buffer_sequence_adapter_base {
 
   template <typename Iterator>
   static bool all_empty(Iterator begin, Iterator end) {
-    std::size_t i = 0;
-    for (Iterator iter = begin; iter != end && i < max_buffers; ++iter, ++i) {
+    for (Iterator iter = begin; iter != end; ++iter) {
       if (Buffer(*iter).size() > 0) {
         return false;
       }
@@ -147,13 +209,18 @@ class buffer_sequence_adapter : private buffer_sequence_adapter_base {
     return Buffer{storage.data(), storage.size() - unused_storage.size()};
   }
 
-  native_buffer_type buffers_[max_buffers];
+  native_buffer_type buffers_[MaxBuffers];
   std::size_t count_;
+  std::size_t first_;
   std::size_t total_buffer_size_;
+
+  // The next buffer of the sequence to translate.
+  iterator_t next_;
+  iterator_t end_;
 };
 
-template <typename Buffer>
-class buffer_sequence_adapter<Buffer, mutable_buffer>
+template <typename Buffer, int MaxBuffers>
+class buffer_sequence_adapter<Buffer, mutable_buffer, MaxBuffers>
     : buffer_sequence_adapter_base {
  public:
   static constexpr bool is_single_buffer = true;
@@ -168,12 +235,25 @@ class buffer_sequence_adapter<Buffer, mutable_buffer>
 
   constexpr std::size_t count() const noexcept { return 1; }
 
+  // Advance the native buffer past the first `size` bytes.
+  constexpr void consume(std::size_t size) noexcept {
+    size = size < total_buffer_size_ ? size : total_buffer_size_;
+    buffer_.iov_base = static_cast<char*>(buffer_.iov_base) + size;
+    buffer_.iov_len -= size;
+    total_buffer_size_ -= size;
+  }
+
   constexpr std::size_t total_size() const noexcept {
     return total_buffer_size_;
   }
 
   constexpr bool all_empty() const noexcept { return total_buffer_size_ == 0; }
 
+  // The whole sequence is translated at once.
+  constexpr bool more() const noexcept { return false; }
+
+  constexpr bool refill() noexcept { return false; }
+
   static constexpr bool all_empty(const mutable_buffer& sequence) noexcept {
     return sequence.size() == 0;
   }
@@ -192,8 +272,8 @@ class buffer_sequence_adapter<Buffer, mutable_buffer>
   std::size_t total_buffer_size_;
 };
 
-template <typename Buffer>
-class buffer_sequence_adapter<Buffer, const_buffer>
+template <typename Buffer, int MaxBuffers>
+class buffer_sequence_adapter<Buffer, const_buffer, MaxBuffers>
     : buffer_sequence_adapter_base {
  public:
   static constexpr bool is_single_buffer = true;
@@ -208,12 +288,25 @@ class buffer_sequence_adapter<Buffer, const_buffer>
 
   constexpr std::size_t count() const noexcept { return 1; }
 
+  // Advance the native buffer past the first `size` bytes.
+  constexpr void consume(std::size_t size) noexcept {
+    size = size < total_buffer_size_ ? size : total_buffer_size_;
+    buffer_.iov_base = static_cast<char*>(buffer_.iov_base) + size;
+    buffer_.iov_len -= size;
+    total_buffer_size_ -= size;
+  }
+
   constexpr std::size_t total_size() const noexcept {
     return total_buffer_size_;
   }
 
   constexpr bool all_empty() const noexcept { return total_buffer_size_ == 0; }
 
+  // The whole sequence is translated at once.
+  constexpr bool more() const noexcept { return false; }
+
+  constexpr bool refill() noexcept { return false; }
+
   static constexpr bool all_empty(const const_buffer& sequence) noexcept {
     return sequence.size() == 0;
   }
@@ -236,23 +329,34 @@ class buffer_sequence_adapter<Buffer, const_buffer>
   std::size_t total_buffer_size_;
 };
 
-template <typename Buffer, typename Elem>
-class buffer_sequence_adapter<Buffer, std::array<Elem, 2>>
+// Fixed size sequences are translated into an array of exactly their size.
+template <typename Buffer, typename Elem, std::size_t N, int MaxBuffers>
+  requires(N <= static_cast<std::size_t>(MaxBuffers))
+class buffer_sequence_adapter<Buffer, std::array<Elem, N>, MaxBuffers>
     : buffer_sequence_adapter_base {
  public:
   static constexpr bool is_single_buffer = false;
   static constexpr int linearization_storage_size = 8192;
 
   explicit constexpr buffer_sequence_adapter(
-      const std::array<Elem, 2>& sequence) noexcept {
-    init_native_buffer(buffers_[0], Buffer(sequence[0]));
-    init_native_buffer(buffers_[1], Buffer(sequence[1]));
-    total_buffer_size_ = sequence[0].size() + sequence[1].size();
+      const std::array<Elem, N>& sequence) noexcept
+      : first_(0), total_buffer_size_(0) {
+    for (std::size_t i = 0; i < N; ++i) {
+      init_native_buffer(buffers_[i], Buffer(sequence[i]));
+      total_buffer_size_ += sequence[i].size();
+    }
   }
 
-  constexpr native_buffer_type* buffers() noexcept { return buffers_; }
+  constexpr native_buffer_type* buffers() noexcept { return buffers_ + first_; }
 
-  constexpr std::size_t count() const noexcept { return 2; }
+  constexpr std::size_t count() const noexcept { return N - first_; }
+
+  // Advance the native buffers past the first `size` bytes.
+  constexpr void consume(std::size_t size) noexcept {
+    size = size < total_buffer_size_ ? size : total_buffer_size_;
+    buffer_sequence_adapter_base::consume(buffers_, N, first_, size);
+    total_buffer_size_ -= size;
+  }
 
   constexpr std::size_t total_size() const noexcept {
     return total_buffer_size_;
@@ -260,28 +364,46 @@ class buffer_sequence_adapter<Buffer, std::array<Elem, 2>>
 
   constexpr bool all_empty() const noexcept { return total_buffer_size_ == 0; }
 
+  // The whole sequence is translated at once.
+  constexpr bool more() const noexcept { return false; }
+
+  constexpr bool refill() noexcept { return false; }
+
   static constexpr bool all_empty(
-      const std::array<Elem, 2>& sequence) noexcept {
-    return sequence[0].size() == 0 && sequence[1].size() == 0;
+      const std::array<Elem, N>& sequence) noexcept {
+    for (const Elem& elem : sequence) {
+      if (elem.size() != 0) {
+        return false;
+      }
+    }
+    return true;
   }
 
-  static constexpr Buffer first(const std::array<Elem, 2>& sequence) noexcept {
-    return Buffer{sequence[0].size() != 0 ? sequence[0] : sequence[1]};
+  static constexpr Buffer first(const std::array<Elem, N>& sequence) noexcept {
+    for (const Elem& elem : sequence) {
+      if (elem.size() != 0) {
+        return Buffer{elem};
+      }
+    }
+    return Buffer{};
   }
 
-  static constexpr Buffer linearise(const std::array<Elem, 2>& sequence,
+  static constexpr Buffer linearise(const std::array<Elem, N>& sequence,
                                     const mutable_buffer& storage) {
-    if (sequence[0].size() == 0) {
-      return Buffer{sequence[1]};
+    // No copy is needed unless two buffers are non-empty.
+    std::size_t non_empty = 0;
+    for (const Elem& elem : sequence) {
+      non_empty += elem.size() != 0 ? 1 : 0;
     }
-    if (sequence[1].size() == 0) {
-      return Buffer{sequence[0]};
+    if (non_empty <= 1) {
+      return first(sequence);
     }
     return Buffer{storage.data(), buffer_copy(storage, sequence)};
   }
 
  private:
-  native_buffer_type buffers_[2];
+  native_buffer_type buffers_[N == 0 ? 1 : N];
+  std::size_t first_;
   std::size_t total_buffer_size_;
 };
 
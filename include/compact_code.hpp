@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef COMPACT_CODE_HPP_
+#define COMPACT_CODE_HPP_
+
+#include <cstdint>
+
+#include "net_error.hpp"
+#include "status-code/generic_code.hpp"
+#include "status-code/system_code.hpp"
+
+namespace net {
+
+// The result of a socket operation in four bytes instead of a `system_code`,
+// which carries a domain pointer besides its value. Only the errno values of
+// the generic and posix domains and the values of `network_errc` are
+// expected, the latter are kept as negative values.
+class compact_code {
+ public:
+  // Constructor. The default code is success.
+  constexpr compact_code() noexcept : value_(0) {}
+
+  constexpr compact_code(system_error2::errc code) noexcept  // NOLINT
+      : value_(static_cast<std::int32_t>(code)) {}
+
+  constexpr compact_code(network_errc code) noexcept  // NOLINT
+      : value_(-static_cast<std::int32_t>(code) - 1) {}
+
+  compact_code(const system_error2::system_code& code) noexcept  // NOLINT
+      : value_(0) {
+    if (code.success()) {
+      return;
+    }
+    const auto value = static_cast<std::int32_t>(code.value());
+    if (code.domain() ==
+        system_error2::quick_status_code_from_enum_domain<network_errc>) {
+      value_ = -value - 1;
+    } else {
+      value_ = value;
+    }
+  }
+
+  // Whether the code indicates success.
+  constexpr bool success() const noexcept { return value_ == 0; }
+
+  // Whether the code indicates failure.
+  constexpr bool failure() const noexcept { return value_ != 0; }
+
+  // The domain of the code, either `network_errc` or the generic domain.
+  const system_error2::status_code_domain& domain() const noexcept {
+    if (value_ < 0) {
+      return system_error2::quick_status_code_from_enum_domain<network_errc>;
+    }
+    return system_error2::generic_code_domain;
+  }
+
+  // The value of the code within its domain.
+  constexpr int value() const noexcept {
+    return value_ < 0 ? -value_ - 1 : value_;
+  }
+
+  friend constexpr bool operator==(compact_code a,
+                                   system_error2::errc b) noexcept {
+    return a.value_ == static_cast<std::int32_t>(b);
+  }
+
+  friend constexpr bool operator==(compact_code a, network_errc b) noexcept {
+    return a.value_ == -static_cast<std::int32_t>(b) - 1;
+  }
+
+  friend constexpr bool operator==(compact_code a, compact_code b) noexcept {
+    return a.value_ == b.value_;
+  }
+
+ private:
+  std::int32_t value_;
+};
+
+}  // namespace net
+
+#endif  // COMPACT_CODE_HPP_
@@ -0,0 +1,372 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef CONNECTION_TABLE_HPP_
+#define CONNECTION_TABLE_HPP_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "monotonic_clock.hpp"
+
+namespace net {
+
+// A table of connection objects addressed by generation-tagged handles.
+//
+// Objects live in fixed-size slabs, so their addresses are stable for as long
+// as they are in the table, which the sockets registered to a context rely on.
+// Freed slots are recycled through a free list like `ObjectPool` does, and
+// every reuse bumps the generation of the slot, so a handle kept past `erase`
+// is detected as stale instead of reaching the next occupant. Insertion,
+// lookup and erasure are O(1), and the live objects are kept in a dense array
+// which sweeps iterate without touching free slots.
+//
+// The table also keeps the traffic counters of each connection, column by
+// column in the order of the dense array, see `traffic`. An export or a
+// throttling pass streams through a few contiguous arrays instead of touching
+// every object.
+//
+// Not thread safe, a table is meant to be owned by one io thread.
+template <typename T, std::size_t SlabSize = 1024>
+class connection_table {
+  static_assert(SlabSize > 0);
+
+ public:
+  // A reference to an object of the table which can outlive the object.
+  class handle {
+   public:
+    // Constructor. The default handle never refers to an object.
+    constexpr handle() noexcept : value_(0) {}
+
+    // The slot index of the object.
+    constexpr std::uint32_t index() const noexcept {
+      return static_cast<std::uint32_t>(value_ & 0xFFFFFFFF);
+    }
+
+    // The generation of the slot when the object was inserted.
+    constexpr std::uint32_t generation() const noexcept {
+      return static_cast<std::uint32_t>(value_ >> 32);
+    }
+
+    // The handle packed into an integer, e.g. to be stored as user data.
+    constexpr std::uint64_t value() const noexcept { return value_; }
+
+    // Unpack a handle from `value()`.
+    static constexpr handle from_value(std::uint64_t value) noexcept {
+      handle h;
+      h.value_ = value;
+      return h;
+    }
+
+    friend constexpr bool operator==(handle a, handle b) noexcept {
+      return a.value_ == b.value_;
+    }
+
+   private:
+    friend connection_table;
+
+    constexpr handle(std::uint32_t index, std::uint32_t generation) noexcept
+        : value_((static_cast<std::uint64_t>(generation) << 32) | index) {}
+
+    std::uint64_t value_;
+  };
+
+  // The traffic counter columns, entry `i` of each belongs to the object at
+  // `at_position(i)`. Invalidated by inserting or erasing objects.
+  struct traffic_columns {
+    // The bytes received and sent.
+    std::span<const std::uint64_t> bytes_in;
+    std::span<const std::uint64_t> bytes_out;
+
+    // The count of completed receives and sends.
+    std::span<const std::uint64_t> ops_in;
+    std::span<const std::uint64_t> ops_out;
+
+    // The time of the last receive or send in nanoseconds of the monotonic
+    // clock, zero if none.
+    std::span<const std::int64_t> last_activity;
+  };
+
+  // Constructor.
+  connection_table() noexcept : free_head_(npos) {}
+
+  connection_table(const connection_table&) = delete;
+  connection_table& operator=(const connection_table&) = delete;
+
+  // Destructor destroys all live objects.
+  ~connection_table() { clear(); }
+
+  // Construct an object in a free slot. Returns its handle and the object.
+  template <typename... Args>
+  std::pair<handle, T&> emplace(Args&&... args) {
+    if (free_head_ == npos) {
+      grow();
+    }
+    const std::uint32_t index = free_head_;
+    slot& s = slot_at(index);
+    T* object = ::new (static_cast<void*>(s.storage))
+        T(static_cast<Args&&>(args)...);
+    free_head_ = s.link;
+    s.occupied = true;
+    s.link = static_cast<std::uint32_t>(live_.size());
+    live_.push_back(index);
+    traffic_.push_back();
+    return {handle{index, s.generation}, *object};
+  }
+
+  // Get the object referred to by `h`, or nullptr if it has been erased.
+  T* get(handle h) noexcept {
+    if (!contains(h)) {
+      return nullptr;
+    }
+    return object_at(h.index());
+  }
+
+  const T* get(handle h) const noexcept {
+    return const_cast<connection_table*>(this)->get(h);
+  }
+
+  // Whether `h` refers to a live object.
+  bool contains(handle h) const noexcept {
+    const std::uint32_t index = h.index();
+    if (index >= capacity()) {
+      return false;
+    }
+    const slot& s = slot_at(index);
+    return s.occupied && s.generation == h.generation();
+  }
+
+  // Destroy the object referred to by `h`. Returns false if `h` is stale.
+  bool erase(handle h) noexcept {
+    if (!contains(h)) {
+      return false;
+    }
+    erase_index(h.index());
+    return true;
+  }
+
+  // Add slabs until there are at least `count` slots, so that the first
+  // `count` insertions don't allocate.
+  void reserve(std::size_t count) {
+    slabs_.reserve((count + SlabSize - 1) / SlabSize);
+    live_.reserve(count);
+    traffic_.reserve(count);
+    while (capacity() < count) {
+      grow();
+    }
+  }
+
+  // Destroy all objects.
+  void clear() noexcept {
+    while (!live_.empty()) {
+      erase_index(live_.back());
+    }
+  }
+
+  // The count of live objects.
+  std::size_t size() const noexcept { return live_.size(); }
+
+  // Whether the table is empty.
+  bool empty() const noexcept { return live_.empty(); }
+
+  // The count of slots, live or free.
+  std::size_t capacity() const noexcept { return slabs_.size() * SlabSize; }
+
+  // Call `f(handle, T&)` for every live object. `f` must not insert or erase
+  // objects.
+  template <typename F>
+  void for_each(F&& f) {
+    for (std::uint32_t index : live_) {
+      f(handle{index, slot_at(index).generation}, *object_at(index));
+    }
+  }
+
+  // Count a receive of `bytes` by the connection `h` at `now`, e.g. from the
+  // completion of the receive. Stale handles are ignored.
+  void add_received(handle h, std::size_t bytes,
+                    monotonic_clock::time_point now) noexcept {
+    if (contains(h)) {
+      const std::uint32_t position = slot_at(h.index()).link;
+      traffic_.bytes_in[position] += bytes;
+      ++traffic_.ops_in[position];
+      traffic_.last_activity[position] = to_nanoseconds(now);
+    }
+  }
+
+  // Count a send of `bytes` by the connection `h` at `now`. Stale handles are
+  // ignored.
+  void add_sent(handle h, std::size_t bytes,
+                monotonic_clock::time_point now) noexcept {
+    if (contains(h)) {
+      const std::uint32_t position = slot_at(h.index()).link;
+      traffic_.bytes_out[position] += bytes;
+      ++traffic_.ops_out[position];
+      traffic_.last_activity[position] = to_nanoseconds(now);
+    }
+  }
+
+  // The traffic counters of the live objects.
+  traffic_columns traffic() const noexcept {
+    return {.bytes_in = traffic_.bytes_in,
+            .bytes_out = traffic_.bytes_out,
+            .ops_in = traffic_.ops_in,
+            .ops_out = traffic_.ops_out,
+            .last_activity = traffic_.last_activity};
+  }
+
+  // Zero the byte and operation counters of every live object, e.g. after
+  // exporting them, so that the next export sees the traffic since. The last
+  // activity is kept.
+  void reset_traffic() noexcept {
+    std::fill(traffic_.bytes_in.begin(), traffic_.bytes_in.end(), 0);
+    std::fill(traffic_.bytes_out.begin(), traffic_.bytes_out.end(), 0);
+    std::fill(traffic_.ops_in.begin(), traffic_.ops_in.end(), 0);
+    std::fill(traffic_.ops_out.begin(), traffic_.ops_out.end(), 0);
+  }
+
+  // The handle of the object at `position` of the dense array of live
+  // objects, `position` must be less than `size()`. Lets a sweep proceed in
+  // batches. Erasing an object moves the last live object to its position.
+  handle at_position(std::size_t position) const noexcept {
+    assert(position < live_.size());
+    const std::uint32_t index = live_[position];
+    return handle{index, slot_at(index).generation};
+  }
+
+ private:
+  static constexpr std::uint32_t npos =
+      std::numeric_limits<std::uint32_t>::max();
+
+  struct slot {
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    // Bumped every time the slot is freed.
+    std::uint32_t generation = 1;
+
+    // The position in `live_` when occupied, the next free slot otherwise.
+    std::uint32_t link = npos;
+
+    bool occupied = false;
+  };
+
+  // The traffic counters, parallel to `live_`.
+  struct traffic_storage {
+    void push_back() {
+      bytes_in.push_back(0);
+      bytes_out.push_back(0);
+      ops_in.push_back(0);
+      ops_out.push_back(0);
+      last_activity.push_back(0);
+    }
+
+    void reserve(std::size_t count) {
+      bytes_in.reserve(count);
+      bytes_out.reserve(count);
+      ops_in.reserve(count);
+      ops_out.reserve(count);
+      last_activity.reserve(count);
+    }
+
+    // Move the counters of the last position to `position` and drop the
+    // last position.
+    void remove(std::uint32_t position) noexcept {
+      bytes_in[position] = bytes_in.back();
+      bytes_out[position] = bytes_out.back();
+      ops_in[position] = ops_in.back();
+      ops_out[position] = ops_out.back();
+      last_activity[position] = last_activity.back();
+      bytes_in.pop_back();
+      bytes_out.pop_back();
+      ops_in.pop_back();
+      ops_out.pop_back();
+      last_activity.pop_back();
+    }
+
+    std::vector<std::uint64_t> bytes_in;
+    std::vector<std::uint64_t> bytes_out;
+    std::vector<std::uint64_t> ops_in;
+    std::vector<std::uint64_t> ops_out;
+    std::vector<std::int64_t> last_activity;
+  };
+
+  static std::int64_t to_nanoseconds(monotonic_clock::time_point t) noexcept {
+    return t.seconds() * 1'000'000'000 + t.nanoseconds();
+  }
+
+  slot& slot_at(std::uint32_t index) noexcept {
+    return slabs_[index / SlabSize][index % SlabSize];
+  }
+
+  const slot& slot_at(std::uint32_t index) const noexcept {
+    return slabs_[index / SlabSize][index % SlabSize];
+  }
+
+  T* object_at(std::uint32_t index) noexcept {
+    return std::launder(reinterpret_cast<T*>(slot_at(index).storage));
+  }
+
+  // Add a slab and put its slots on the free list.
+  void grow() {
+    assert(capacity() + SlabSize < npos);
+    const auto first = static_cast<std::uint32_t>(capacity());
+    slabs_.emplace_back(new slot[SlabSize]);
+    slot* slab = slabs_.back().get();
+    for (std::uint32_t i = 0; i < SlabSize; ++i) {
+      slab[i].link = i + 1 < SlabSize ? first + i + 1 : free_head_;
+    }
+    free_head_ = first;
+  }
+
+  void erase_index(std::uint32_t index) noexcept {
+    slot& s = slot_at(index);
+    assert(s.occupied);
+    std::destroy_at(object_at(index));
+
+    // Keep the live objects dense.
+    const std::uint32_t position = s.link;
+    const std::uint32_t last = live_.back();
+    live_[position] = last;
+    slot_at(last).link = position;
+    live_.pop_back();
+    traffic_.remove(position);
+
+    s.occupied = false;
+    ++s.generation;
+    if (s.generation == 0) {
+      // Generation zero is never handed out, so the default handle is never
+      // valid.
+      s.generation = 1;
+    }
+    s.link = free_head_;
+    free_head_ = index;
+  }
+
+  std::vector<std::unique_ptr<slot[]>> slabs_;
+  std::vector<std::uint32_t> live_;
+  traffic_storage traffic_;
+  std::uint32_t free_head_;
+};
+
+}  // namespace net
+
+#endif  // CONNECTION_TABLE_HPP_
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DATAGRAM_BATCH_HPP_
+#define DATAGRAM_BATCH_HPP_
+
+#include <sys/socket.h>
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+#include "status-code/system_code.hpp"
+
+#include "basic_socket.hpp"
+#include "buffer.hpp"
+#include "ip/packet_info.hpp"
+
+namespace net {
+
+// A reusable batch of datagrams exchanged with recvmmsg and sendmmsg. All
+// native message headers are allocated once in the constructor, so receiving
+// or sending a batch doesn't allocate. A batch is filled with push_back(),
+// either with buffers to receive into or with datagrams and their peers to
+// send, then handed to async_recv_batch or async_send_batch. A batch can also
+// reserve room for ancillary data, e.g. to learn the multicast group of every
+// datagram received by a socket which has `ip::udp::packet_info` enabled.
+template <typename Protocol>
+class datagram_batch {
+ public:
+  // The protocol type.
+  using protocol_type = Protocol;
+
+  // The endpoint type.
+  using endpoint_type = typename protocol_type::endpoint;
+
+  // Construct an empty batch which holds up to `capacity` datagrams, with
+  // `control_size` bytes of ancillary data for each received datagram, e.g.
+  // `ip::packet_info::control_size`.
+  explicit datagram_batch(std::size_t capacity, std::size_t control_size = 0)
+      : headers_(capacity),
+        iovecs_(capacity),
+        addresses_(capacity),
+        control_size_(CMSG_ALIGN(control_size)),
+        controls_(capacity * control_size_),
+        size_(0) {}
+
+  // Copying a batch would leave the message headers pointing to the storage
+  // of the source batch.
+  datagram_batch(const datagram_batch&) = delete;
+  datagram_batch& operator=(const datagram_batch&) = delete;
+
+  // Moving keeps the storage, so the message headers stay valid.
+  datagram_batch(datagram_batch&&) noexcept = default;
+  datagram_batch& operator=(datagram_batch&&) noexcept = default;
+
+  // The maximum count of datagrams in this batch.
+  std::size_t capacity() const noexcept { return headers_.size(); }
+
+  // The count of datagrams in this batch.
+  std::size_t size() const noexcept { return size_; }
+
+  // Whether this batch has no datagram.
+  bool empty() const noexcept { return size_ == 0; }
+
+  // Whether this batch can't take more datagrams.
+  bool full() const noexcept { return size_ == headers_.size(); }
+
+  // Remove all datagrams. The capacity is kept.
+  void clear() noexcept { size_ = 0; }
+
+  // Add a buffer to receive a datagram into. Returns false if the batch is
+  // full.
+  bool push_back(mutable_buffer buffer) noexcept {
+    if (full()) {
+      return false;
+    }
+    assign(size_++, buffer.data(), buffer.size(), nullptr);
+    return true;
+  }
+
+  // Add a datagram to send to `peer`. Returns false if the batch is full.
+  bool push_back(const_buffer data, const endpoint_type& peer) noexcept {
+    if (full()) {
+      return false;
+    }
+    assign(size_++, const_cast<void*>(data.data()), data.size(), &peer);
+    return true;
+  }
+
+  // The buffer of the datagram at `index`.
+  mutable_buffer buffer(std::size_t index) const noexcept {
+    assert(index < size_);
+    return {iovecs_[index].iov_base, iovecs_[index].iov_len};
+  }
+
+  // The count of bytes of the datagram at `index` which have been received or
+  // sent.
+  std::size_t length(std::size_t index) const noexcept {
+    assert(index < size_);
+    return headers_[index].msg_len;
+  }
+
+  // Whether the datagram at `index` was larger than its buffer, and the rest
+  // of it has been discarded.
+  bool truncated(std::size_t index) const noexcept {
+    assert(index < size_);
+    return (headers_[index].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+  }
+
+  // The peer of the datagram at `index`, which is the source of a received
+  // datagram or the destination of a datagram to send.
+  result<endpoint_type> endpoint(std::size_t index) const noexcept {
+    assert(index < size_);
+    if (!addresses_[index].is_valid()) {
+      return errc::address_family_not_supported;
+    }
+    return addresses_[index];
+  }
+
+  // The destination and the interface of the received datagram at `index`.
+  // Fails with no_message if the batch has no room for ancillary data or the
+  // socket doesn't have `ip::udp::packet_info` enabled.
+  result<ip::packet_info> packet_info(std::size_t index) const noexcept {
+    assert(index < size_);
+    ip::packet_info info;
+    if (!ip::packet_info::parse(headers_[index].msg_hdr, info)) {
+      return errc::no_message;
+    }
+    return info;
+  }
+
+  // Get the native message headers.
+  ::mmsghdr* native_messages() noexcept { return headers_.data(); }
+
+  // Reset the lengths of source addresses and ancillary data before receiving
+  // into this batch.
+  void prepare_receive() noexcept {
+    for (std::size_t i = 0; i < size_; ++i) {
+      headers_[i].msg_hdr.msg_namelen = endpoint_type::capacity();
+      headers_[i].msg_hdr.msg_controllen =
+          headers_[i].msg_hdr.msg_control != nullptr ? control_size_ : 0;
+      headers_[i].msg_hdr.msg_flags = 0;
+      headers_[i].msg_len = 0;
+    }
+  }
+
+ private:
+  void assign(std::size_t index, void* data, std::size_t size,
+              const endpoint_type* peer) noexcept {
+    iovecs_[index] = {.iov_base = data, .iov_len = size};
+    ::msghdr& msg = headers_[index].msg_hdr;
+    msg = ::msghdr{};
+    msg.msg_name = addresses_[index].data();
+    msg.msg_namelen = endpoint_type::capacity();
+    msg.msg_iov = &iovecs_[index];
+    msg.msg_iovlen = 1;
+    if (peer != nullptr) {
+      addresses_[index] = *peer;
+      msg.msg_namelen = peer->size();
+    } else if (control_size_ != 0) {
+      // Datagrams to send carry no ancillary data.
+      msg.msg_control = &controls_[index * control_size_];
+      msg.msg_controllen = control_size_;
+    }
+    headers_[index].msg_len = 0;
+  }
+
+  // The native message headers, one for each datagram.
+  std::vector<::mmsghdr> headers_;
+
+  // The buffer of each datagram.
+  std::vector<::iovec> iovecs_;
+
+  // The peer of each datagram, which recvmmsg writes in place.
+  std::vector<endpoint_type> addresses_;
+
+  // The size of the ancillary data of each datagram.
+  std::size_t control_size_;
+
+  // The ancillary data of each datagram. The storage of operator new is
+  // aligned enough for control message headers.
+  std::vector<char> controls_;
+
+  // The count of datagrams in use.
+  std::size_t size_;
+};
+
+}  // namespace net
+
+#endif  // DATAGRAM_BATCH_HPP_
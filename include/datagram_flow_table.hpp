@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DATAGRAM_FLOW_TABLE_HPP_
+#define DATAGRAM_FLOW_TABLE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+#include "status-code/system_code.hpp"
+
+#include "basic_datagram_socket.hpp"
+
+namespace net {
+
+// Per-peer connected sockets for long-lived datagram flows, e.g. QUIC. The
+// listener is an unconnected socket with SO_REUSEPORT. The first datagram of
+// a peer arrives on it and route() spawns a socket connected to that peer,
+// bound to the same endpoint and on the same context. From then on the kernel
+// delivers the datagrams of the peer to the flow socket and replies go out
+// with send instead of sendto. Datagrams which were already queued on the
+// listener when the flow was spawned are routed to the same entry.
+//
+// `Flow` is the state kept with each flow socket. Entries never move, so
+// operations may be pending on their sockets; erase an entry only after they
+// completed.
+template <typename Protocol, typename Flow>
+class datagram_flow_table {
+ public:
+  using protocol_type = Protocol;
+  using endpoint_type = typename Protocol::endpoint;
+  using socket_type = typename Protocol::socket;
+
+  struct entry {
+    // The socket connected to the peer.
+    socket_type socket;
+
+    // The state of the flow.
+    Flow flow;
+  };
+
+  // Constructor. At most `max_flows` sockets are spawned, the datagrams of
+  // further peers are left to the listener.
+  explicit datagram_flow_table(socket_type& listener,
+                               std::size_t max_flows = SIZE_MAX)
+      : listener_(listener), max_flows_(max_flows), flows_() {}
+
+  datagram_flow_table(const datagram_flow_table&) = delete;
+  datagram_flow_table& operator=(const datagram_flow_table&) = delete;
+
+  // Get the entry of `peer`, which sent a datagram to the listener. A new
+  // entry is created for an unknown peer, with a connected socket and the
+  // flow constructed from `args`, and the second value is true. Returns null
+  // if the table is full, with `errc::too_many_files_open`, or the socket
+  // can't be spawned, with the error of the failed step.
+  template <typename... Args>
+  std::pair<entry*, bool> route(const endpoint_type& peer,
+                                system_error2::system_code& ec,
+                                Args&&... args) {
+    if (auto it = flows_.find(peer); it != flows_.end()) {
+      return {it->second.get(), false};
+    }
+    if (flows_.size() >= max_flows_) {
+      ec = errc::too_many_files_open;
+      return {nullptr, false};
+    }
+    socket_type socket = listener_.connect_flow(peer, ec);
+    if (ec.failure()) {
+      return {nullptr, false};
+    }
+    std::unique_ptr<entry> e{new entry{static_cast<socket_type&&>(socket),
+                                       Flow(static_cast<Args&&>(args)...)}};
+    entry* result = e.get();
+    flows_.emplace(peer, static_cast<std::unique_ptr<entry>&&>(e));
+    return {result, true};
+  }
+
+  // Get the entry of `peer`, null if it has none.
+  entry* find(const endpoint_type& peer) noexcept {
+    auto it = flows_.find(peer);
+    return it == flows_.end() ? nullptr : it->second.get();
+  }
+
+  // Close the socket of `peer` and remove its entry. Returns whether there
+  // was one.
+  bool erase(const endpoint_type& peer) noexcept {
+    auto it = flows_.find(peer);
+    if (it == flows_.end()) {
+      return false;
+    }
+    it->second->socket.close();
+    flows_.erase(it);
+    return true;
+  }
+
+  // The count of flows.
+  std::size_t size() const noexcept { return flows_.size(); }
+
+  // The unconnected socket which receives the first datagram of each peer.
+  socket_type& listener() noexcept { return listener_; }
+
+ private:
+  socket_type& listener_;
+  std::size_t max_flows_;
+  std::unordered_map<endpoint_type, std::unique_ptr<entry>> flows_;
+};
+
+}  // namespace net
+
+#endif  // DATAGRAM_FLOW_TABLE_HPP_
@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DYNAMIC_RING_BUFFER_HPP_
+#define DYNAMIC_RING_BUFFER_HPP_
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "buffer.hpp"
+
+namespace net {
+
+// A DynamicBuffer over a ring of owned memory for streaming protocols.
+// Consuming bytes only advances the read position, so no bytes are moved
+// until the ring has to grow. The input and output sequences are two-element
+// buffer sequences, the second buffer is used when a sequence wraps around.
+//
+// If `double_mapped` is requested, the ring is mapped twice back to back in
+// virtual memory, so every sequence is contiguous and the second buffer is
+// always empty. The capacity is then rounded up to the page size. The ring
+// falls back to plain memory if the mapping can't be created.
+class dynamic_ring_buffer {
+ public:
+  // The type used to represent a sequence of constant buffers that refers to
+  // the underlying memory.
+  using const_buffers_type = std::array<const_buffer, 2>;
+
+  // The type used to represent a sequence of mutable buffers that refers to the
+  // underlying memory.
+  using mutable_buffers_type = std::array<mutable_buffer, 2>;
+
+  // Constructor.
+  explicit dynamic_ring_buffer(
+      std::size_t capacity = 4096,
+      std::size_t max_size = (std::numeric_limits<std::size_t>::max)(),
+      bool double_mapped = false)
+      : memory_(nullptr),
+        capacity_(0),
+        head_(0),
+        size_(0),
+        prepared_(0),
+        max_size_(max_size),
+        double_mapped_(false) {
+    allocate(capacity < 1 ? 1 : capacity, double_mapped);
+  }
+
+  dynamic_ring_buffer(const dynamic_ring_buffer&) = delete;
+  dynamic_ring_buffer& operator=(const dynamic_ring_buffer&) = delete;
+
+  // Move construct a dynamic buffer.
+  dynamic_ring_buffer(dynamic_ring_buffer&& other) noexcept
+      : memory_(std::exchange(other.memory_, nullptr)),
+        capacity_(std::exchange(other.capacity_, 0)),
+        head_(std::exchange(other.head_, 0)),
+        size_(std::exchange(other.size_, 0)),
+        prepared_(std::exchange(other.prepared_, 0)),
+        max_size_(other.max_size_),
+        double_mapped_(std::exchange(other.double_mapped_, false)) {}
+
+  // Destructor.
+  ~dynamic_ring_buffer() { deallocate(memory_, capacity_, double_mapped_); }
+
+  // Get the size of the input sequence.
+  std::size_t size() const noexcept { return size_; }
+
+  // Get the maximum size of the dynamic buffer.
+  std::size_t max_size() const noexcept { return max_size_; }
+
+  // Get the maximum size that the buffer may grow to without triggering
+  // reallocation.
+  std::size_t capacity() const noexcept { return capacity_; }
+
+  // Whether the ring is mapped twice, i.e. all sequences are contiguous.
+  bool is_double_mapped() const noexcept { return double_mapped_; }
+
+  // Get a list of buffers that represents the input sequence.
+  const_buffers_type data() const noexcept {
+    auto [first, second] = region(head_, size_);
+    return {const_buffer{first}, const_buffer{second}};
+  }
+
+  // Get a list of buffers that represents the output sequence, with the given
+  // size. The ring grows if the free space is less than `n`.
+  mutable_buffers_type prepare(std::size_t n) {
+    if (size_ > max_size_ || max_size_ - size_ < n) {
+      throw std::length_error{"dynamic_ring_buffer too long"};
+    }
+    if (capacity_ - size_ < n) {
+      grow(size_ + n);
+    }
+    prepared_ = n;
+    return region(wrap(head_ + size_), n);
+  }
+
+  // Move bytes from the output sequence to the input sequence.
+  void commit(std::size_t n) noexcept {
+    size_ += (std::min)(n, prepared_);
+    prepared_ = 0;
+  }
+
+  // Remove bytes from the beginning of the input sequence.
+  void consume(std::size_t n) noexcept {
+    n = (std::min)(n, size_);
+    size_ -= n;
+    // Start over at the beginning once empty, so small messages stay
+    // contiguous without a double mapping.
+    head_ = size_ == 0 ? 0 : wrap(head_ + n);
+  }
+
+ private:
+  std::size_t wrap(std::size_t pos) const noexcept {
+    return pos >= capacity_ ? pos - capacity_ : pos;
+  }
+
+  // The buffers of `n` bytes starting at `pos` of the ring.
+  mutable_buffers_type region(std::size_t pos, std::size_t n) const noexcept {
+    if (double_mapped_ || pos + n <= capacity_) {
+      return {mutable_buffer{memory_ + pos, n}, mutable_buffer{}};
+    }
+    const std::size_t first = capacity_ - pos;
+    return {mutable_buffer{memory_ + pos, first},
+            mutable_buffer{memory_, n - first}};
+  }
+
+  // Reallocate the ring with room for at least `n` bytes. The input sequence
+  // is moved to the beginning.
+  void grow(std::size_t n) {
+    std::size_t capacity = capacity_ == 0 ? 1 : capacity_;
+    while (capacity < n) {
+      capacity = capacity > max_size_ / 2 ? max_size_ : capacity * 2;
+    }
+    char* old_memory = memory_;
+    const std::size_t old_capacity = capacity_;
+    const bool old_double_mapped = double_mapped_;
+    const auto [first, second] = region(head_, size_);
+
+    allocate(capacity, old_double_mapped);
+    std::memcpy(memory_, first.data(), first.size());
+    std::memcpy(memory_ + first.size(), second.data(), second.size());
+    head_ = 0;
+    deallocate(old_memory, old_capacity, old_double_mapped);
+  }
+
+  void allocate(std::size_t capacity, bool double_mapped) {
+    if (double_mapped) {
+      const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+      const std::size_t size = (capacity + page - 1) / page * page;
+      if (char* memory = map_twice(size)) {
+        memory_ = memory;
+        capacity_ = size;
+        double_mapped_ = true;
+        return;
+      }
+    }
+    memory_ = new char[capacity];
+    capacity_ = capacity;
+    double_mapped_ = false;
+  }
+
+  static void deallocate(char* memory, std::size_t capacity,
+                         bool double_mapped) noexcept {
+    if (memory == nullptr) {
+      return;
+    }
+    if (double_mapped) {
+      ::munmap(memory, capacity * 2);
+    } else {
+      delete[] memory;
+    }
+  }
+
+  // Map `size` bytes of an anonymous file twice back to back. Returns nullptr
+  // on failure.
+  static char* map_twice(std::size_t size) noexcept {
+    int fd = ::memfd_create("net_ring_buffer", MFD_CLOEXEC);
+    if (fd < 0) {
+      return nullptr;
+    }
+    char* result = nullptr;
+    if (::ftruncate(fd, static_cast<::off_t>(size)) == 0) {
+      void* base = ::mmap(nullptr, size * 2, PROT_NONE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (base != MAP_FAILED) {
+        auto* addr = static_cast<char*>(base);
+        if (::mmap(addr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+                   fd, 0) != MAP_FAILED &&
+            ::mmap(addr + size, size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED) {
+          result = addr;
+        } else {
+          ::munmap(base, size * 2);
+        }
+      }
+    }
+    ::close(fd);
+    return result;
+  }
+
+  char* memory_;
+  std::size_t capacity_;
+
+  // The position of the input sequence and its size.
+  std::size_t head_;
+  std::size_t size_;
+
+  // The size of the output sequence of the last `prepare`.
+  std::size_t prepared_;
+  std::size_t max_size_;
+  bool double_mapped_;
+};
+
+}  // namespace net
+
+#endif  // DYNAMIC_RING_BUFFER_HPP_
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_ADMISSION_CONTROL_HPP_
+#define EPOLL_ADMISSION_CONTROL_HPP_
+
+#include <sys/socket.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+
+#include "epoll/epoll_context.hpp"
+
+namespace net {
+
+// The policy of `async_accept_each` for shedding load while the context is
+// overloaded, which is far cheaper at accept than accepting and then timing
+// out requests. The context is overloaded once the last iteration of its run
+// loop took longer than `max_loop_lag`, see `epoll_context::heartbeat`, or
+// once it serves `max_descriptors` descriptors. Then the acceptor either
+// pauses, leaving new connections to the kernel backlog or to other
+// SO_REUSEPORT shards, or accepts and resets each connection right away.
+// One policy may be shared by the acceptors of several contexts, its
+// counters can be read from any thread.
+//
+// A peer filter, e.g. a lookup in an `ip::prefix_table` of denied networks,
+// sees the address of every connection before it's admitted. The address
+// comes with the accept, so filtering costs no extra syscall.
+class admission_control {
+ public:
+  enum class action : std::uint8_t { pause, reject };
+
+  struct options {
+    // Zero disables a limit.
+    std::chrono::nanoseconds max_loop_lag{};
+    std::size_t max_descriptors = 0;
+
+    action on_overload = action::pause;
+
+    // How long a paused acceptor waits before checking the load again.
+    std::chrono::nanoseconds pause_time = std::chrono::milliseconds{10};
+
+    // Whether to admit the peer at `addr` of `size` bytes, called on the io
+    // thread with `peer_filter_arg`. Refused connections are reset. Null
+    // admits every peer.
+    bool (*peer_filter)(const void* arg, const ::sockaddr_storage& addr,
+                        ::socklen_t size) noexcept = nullptr;
+    const void* peer_filter_arg = nullptr;
+  };
+
+  struct statistics {
+    // The count of connections accepted and handed to the handler.
+    std::uint64_t admitted = 0;
+
+    // The count of connections accepted and reset because of overload.
+    std::uint64_t rejected = 0;
+
+    // The count of times the acceptor paused.
+    std::uint64_t pauses = 0;
+
+    // The count of connections accepted and reset by the peer filter.
+    std::uint64_t filtered = 0;
+  };
+
+  // Constructor.
+  explicit admission_control(const options& opts) noexcept
+      : options_(opts), admitted_(0), rejected_(0), pauses_(0), filtered_(0) {}
+
+  admission_control(const admission_control&) = delete;
+  admission_control& operator=(const admission_control&) = delete;
+
+  const options& get_options() const noexcept { return options_; }
+
+  // Whether `context` is overloaded. A loop lag limit needs the heartbeat of
+  // the context, which `async_accept_each` enables. Must be called from the
+  // io thread of `context`.
+  bool overloaded(const epoll_context& context) const noexcept {
+    if (options_.max_descriptors != 0 &&
+        context.descriptor_count() >= options_.max_descriptors) {
+      return true;
+    }
+    return options_.max_loop_lag.count() > 0 &&
+           context.read_heartbeat().last_iteration > options_.max_loop_lag;
+  }
+
+  // Whether the peer filter admits the peer at `addr`.
+  bool admits(const ::sockaddr_storage& addr,
+              ::socklen_t size) const noexcept {
+    return options_.peer_filter == nullptr ||
+           options_.peer_filter(options_.peer_filter_arg, addr, size);
+  }
+
+  statistics stats() const noexcept {
+    constexpr auto relaxed = std::memory_order_relaxed;
+    return {.admitted = admitted_.load(relaxed),
+            .rejected = rejected_.load(relaxed),
+            .pauses = pauses_.load(relaxed),
+            .filtered = filtered_.load(relaxed)};
+  }
+
+  // Count the decisions, called by the io threads which accept.
+  void count_admitted() noexcept { add(admitted_); }
+
+  void count_rejected() noexcept { add(rejected_); }
+
+  void count_pause() noexcept { add(pauses_); }
+
+  void count_filtered() noexcept { add(filtered_); }
+
+ private:
+  static void add(std::atomic<std::uint64_t>& counter) noexcept {
+    counter.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  options options_;
+  std::atomic<std::uint64_t> admitted_;
+  std::atomic<std::uint64_t> rejected_;
+  std::atomic<std::uint64_t> pauses_;
+  std::atomic<std::uint64_t> filtered_;
+};
+
+}  // namespace net
+
+#endif  // EPOLL_ADMISSION_CONTROL_HPP_
@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_ASYNC_SCOPE_HPP_
+#define EPOLL_ASYNC_SCOPE_HPP_
+
+#include <cassert>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "epoll/epoll_context.hpp"
+#include "epoll/start_detached.hpp"
+#include "intrusive_list.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+// Like `start_detached`, spawns senders whose operation states are allocated
+// from the operation pool of the context, but keeps track of them, so their
+// completion can be awaited with `join()`, e.g. to shut down once every
+// connection handler has finished. Each spawned operation counts as
+// outstanding work of the context, so an `async_drain` waits for it too.
+//
+// The scope doesn't stop the spawned operations, cancel them with a
+// `cancellation_group`, by closing their sockets or by a drain. Spawned
+// senders must not complete with an error and must complete on the io
+// thread, as the operations of the context do. Only used from the io thread,
+// or while the context is not running. The scope must be empty when it's
+// destroyed.
+class async_scope {
+  // The part of a spawned operation known to the scope.
+  struct spawned_base {
+    spawned_base* next_ = nullptr;
+    spawned_base* prev_ = nullptr;
+  };
+
+  // A `join()` waiting for the scope to become empty.
+  struct join_base {
+    join_base* next_ = nullptr;
+    void (*complete_)(join_base*) noexcept = nullptr;  // NOLINT
+  };
+
+  template <typename SenderId>
+  class spawn_op;
+
+  template <typename ReceiverId>
+  class join_op;
+
+  class join_sender;
+
+ public:
+  // Constructor.
+  explicit async_scope(epoll_context& context) noexcept
+      : context_(context), spawned_(), count_(0), joins_(nullptr) {}
+
+  async_scope(const async_scope&) = delete;
+  async_scope& operator=(const async_scope&) = delete;
+
+  // Destructor.
+  ~async_scope() { assert(empty() && joins_ == nullptr); }
+
+  // Start `sender` within the scope. The environment of its receiver exposes
+  // the allocator and the scheduler of the context. Throws if the operation
+  // state can't be allocated or connected, nothing is spawned then.
+  template <stdexec::sender Sender>
+  void spawn(Sender&& sender);
+
+  // A sender which completes on the io thread once no operation of the scope
+  // is left, right away if it is empty already. Operations may be spawned
+  // while it waits.
+  join_sender join() noexcept;
+
+  // The context the operations are spawned on.
+  epoll_context& context() const noexcept { return context_; }
+
+  // The count of operations which have not completed yet.
+  std::size_t size() const noexcept { return count_; }
+
+  bool empty() const noexcept { return count_ == 0; }
+
+ private:
+  void add(spawned_base* op) noexcept {
+    assert(context_.is_running_on_io_thread() || !context_.is_running());
+    spawned_.push_back(op);
+    ++count_;
+    context_.work_started();
+  }
+
+  // `op` is about to complete and release its state.
+  void unlink(spawned_base* op) noexcept {
+    assert(context_.is_running_on_io_thread() || !context_.is_running());
+    spawned_.remove(op);
+  }
+
+  // An operation has completed and released its state. Completes the joins if
+  // it was the last one, which may destroy the scope.
+  void finished() noexcept {
+    --count_;
+    context_.work_finished();
+    if (count_ == 0) {
+      join_base* join = std::exchange(joins_, nullptr);
+      while (join != nullptr) {
+        std::exchange(join, join->next_)->complete_(join);
+      }
+    }
+  }
+
+  epoll_context& context_;
+
+  // The operations spawned and not completed yet.
+  intrusive_list<spawned_base, &spawned_base::next_, &spawned_base::prev_>
+      spawned_;
+  std::size_t count_;
+
+  // The joins waiting for the scope to become empty.
+  join_base* joins_;
+};
+
+template <typename SenderId>
+class async_scope::spawn_op {
+  using sender_t = stdexec::__t<SenderId>;
+
+ public:
+  struct __t;
+
+  struct receiver {
+    using is_receiver = void;
+    using __t = receiver;
+    using __id = receiver;
+
+    template <typename... Values>
+    friend void tag_invoke(stdexec::set_value_t, receiver&& self,
+                           Values&&...) noexcept {
+      self.op_->complete();
+    }
+
+    // Same as `start_detached`, errors are not allowed.
+    template <typename Error>
+    friend void tag_invoke(stdexec::set_error_t, receiver&&,
+                           Error&&) noexcept {
+      std::terminate();
+    }
+
+    friend void tag_invoke(stdexec::set_stopped_t, receiver&& self) noexcept {
+      self.op_->complete();
+    }
+
+    friend auto tag_invoke(stdexec::get_env_t, const receiver& self) noexcept
+        -> detached_env {
+      return {&self.op_->scope_.context()};
+    }
+
+    spawn_op::__t* op_;
+  };
+
+  struct __t : spawned_base, stdexec::__immovable {
+    using __id = spawn_op;
+    using allocator_t = epoll_context::allocator<__t>;
+
+    __t(async_scope& scope, sender_t&& sender)
+        : scope_(scope),
+          op_(stdexec::connect(static_cast<sender_t&&>(sender),
+                               receiver{this})) {}
+
+    // Release the operation state before the scope learns about the
+    // completion, the scope may be gone afterwards.
+    void complete() noexcept {
+      async_scope& scope = scope_;
+      allocator_t alloc{scope.context_};
+      scope.unlink(this);
+      std::destroy_at(this);
+      alloc.deallocate(this, 1);
+      scope.finished();
+    }
+
+    async_scope& scope_;
+    stdexec::connect_result_t<sender_t, receiver> op_;
+  };
+};
+
+template <stdexec::sender Sender>
+void async_scope::spawn(Sender&& sender) {
+  using op_t =
+      stdexec::__t<spawn_op<stdexec::__id<std::remove_cvref_t<Sender>>>>;
+  typename op_t::allocator_t alloc{context_};
+  op_t* op = alloc.allocate(1);
+  try {
+    std::construct_at(
+        op, *this, std::remove_cvref_t<Sender>(static_cast<Sender&&>(sender)));
+  } catch (...) {
+    alloc.deallocate(op, 1);
+    throw;
+  }
+  add(op);
+  stdexec::start(op->op_);
+}
+
+template <typename ReceiverId>
+class async_scope::join_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+
+ public:
+  struct __t : private join_base, stdexec::__immovable {
+    using __id = join_op;
+
+    __t(receiver_t receiver, async_scope& scope) noexcept
+        : scope_(scope), receiver_(static_cast<receiver_t&&>(receiver)) {
+      this->complete_ = &complete;
+    }
+
+    friend void tag_invoke(stdexec::start_t, __t& self) noexcept {
+      self.start_impl();
+    }
+
+   private:
+    void start_impl() noexcept {
+      assert(scope_.context_.is_running_on_io_thread() ||
+             !scope_.context_.is_running());
+      if (scope_.empty()) {
+        stdexec::set_value(static_cast<receiver_t&&>(receiver_));
+        return;
+      }
+      this->next_ = std::exchange(scope_.joins_, static_cast<join_base*>(this));
+    }
+
+    static void complete(join_base* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      stdexec::set_value(static_cast<receiver_t&&>(self.receiver_));
+    }
+
+    async_scope& scope_;
+    STDEXEC_NO_UNIQUE_ADDRESS receiver_t receiver_;
+  };
+};
+
+class async_scope::join_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<join_op<stdexec::__id<Receiver>>>;
+
+ public:
+  using is_sender = void;
+  using completion_signatures =
+      stdexec::completion_signatures<stdexec::set_value_t()>;
+
+  template <typename Env>
+  friend auto tag_invoke(stdexec::get_completion_signatures_t,
+                         const join_sender&, Env&&) noexcept
+      -> completion_signatures;
+
+  friend auto tag_invoke(stdexec::get_env_t, const join_sender&) noexcept
+      -> stdexec::empty_env {
+    return {};
+  }
+
+  template <stdexec::receiver_of<completion_signatures> Receiver>
+  friend auto tag_invoke(stdexec::connect_t, const join_sender& self,
+                         Receiver receiver) noexcept -> op_t<Receiver> {
+    return {static_cast<Receiver&&>(receiver), *self.scope_};
+  }
+
+  explicit join_sender(async_scope& scope) noexcept : scope_(&scope) {}
+
+ private:
+  async_scope* scope_;
+};
+
+inline async_scope::join_sender async_scope::join() noexcept {
+  return join_sender{*this};
+}
+}  // namespace __epoll
+
+using async_scope = __epoll::async_scope;
+}  // namespace net
+
+#endif  // EPOLL_ASYNC_SCOPE_HPP_
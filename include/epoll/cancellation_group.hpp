@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_CANCELLATION_GROUP_HPP_
+#define EPOLL_CANCELLATION_GROUP_HPP_
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+
+#include "epoll/epoll_context.hpp"
+
+namespace net {
+
+// The sockets of one connection, e.g. a client and the upstream serving it,
+// whose pending operations are canceled together when the connection is torn
+// down. The operations are already linked into the descriptor states of their
+// sockets, so `cancel_all()` takes them out of there in a single pass. It
+// needs no stop source, no stop callback per operation and no atomics, the
+// operations may be started with an unstoppable receiver. An operation
+// canceled this way completes as stopped.
+//
+// The group keeps references to the sockets, which must not move or be
+// destroyed while they are members. Only used from the io thread, or while
+// the context is not running. Embed it in the entry of a `connection_table`
+// next to the sockets.
+template <std::size_t Capacity = 4>
+class cancellation_group {
+ public:
+  // Constructor.
+  explicit cancellation_group(epoll_context& context) noexcept
+      : context_(context), members_{}, size_(0), canceled_(false) {}
+
+  cancellation_group(const cancellation_group&) = delete;
+  cancellation_group& operator=(const cancellation_group&) = delete;
+
+  // Add a socket, acceptor or descriptor of the context to the group. Returns
+  // false if the group is full.
+  template <typename Socket>
+  bool add(Socket& socket) noexcept {
+    assert(&socket.context() == &context_);
+    if (size_ == Capacity) {
+      return false;
+    }
+    members_[size_++] = &socket.descriptor_data();
+    return true;
+  }
+
+  // Remove a socket from the group, e.g. an upstream going back to its pool.
+  template <typename Socket>
+  void remove(Socket& socket) noexcept {
+    for (std::size_t i = 0; i < size_; ++i) {
+      if (members_[i] == &socket.descriptor_data()) {
+        members_[i] = members_[--size_];
+        return;
+      }
+    }
+  }
+
+  // Cancel the operations pending on every socket of the group. Operations
+  // which would wait on them afterwards fail the same way, until the sockets
+  // are closed. The membership is kept.
+  void cancel_all() noexcept {
+    canceled_ = true;
+    for (std::size_t i = 0; i < size_; ++i) {
+      context_.cancel_descriptor(*members_[i]);
+    }
+  }
+
+  // Forget the members and the cancellation, so the group can be used by the
+  // next connection of a recycled table entry.
+  void clear() noexcept {
+    size_ = 0;
+    canceled_ = false;
+  }
+
+  // Whether `cancel_all()` has been called since the last `clear()`.
+  bool canceled() const noexcept { return canceled_; }
+
+  // The count of sockets in the group.
+  std::size_t size() const noexcept { return size_; }
+
+ private:
+  epoll_context& context_;
+
+  // The descriptor data of the members, it's assigned once a socket first
+  // waits, so it's read only when the group is canceled.
+  std::array<void**, Capacity> members_;
+  std::size_t size_;
+  bool canceled_;
+};
+
+}  // namespace net
+
+#endif  // EPOLL_CANCELLATION_GROUP_HPP_
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef EPOLL_CHANNEL_HPP_
+#define EPOLL_CHANNEL_HPP_
+
+#include <cassert>
+#include <utility>
+
+#include "atomic_intrusive_queue.hpp"
+#include "epoll/epoll_context.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// A channel of `T` between contexts. Any thread may `send`, a single
+// `async_receive` at a time waits for the messages on the io thread of the
+// receiving context, in the order they were sent by each producer.
+//
+// The queue is marked inactive while the receiving side is idle, like the
+// remote queue of the context. The send that finds it inactive schedules one
+// drain on the receiving context, later sends only push onto the queue until
+// the receiver runs dry again. A burst of messages thus costs at most one
+// wakeup of the io thread.
+//
+// A pending receive can't be stopped. The channel must outlive the sends in
+// flight and is destroyed on the io thread.
+template <typename T>
+class epoll_context::channel {
+ public:
+  // A waiting receive.
+  struct waiter : operation_base {
+    void (*complete_)(waiter*, T&& value) noexcept;
+    channel* owner_ = nullptr;
+  };
+
+  // Constructor.
+  explicit channel(epoll_context& context) noexcept
+      : context_(context),
+        queue_(false),
+        drain_op_(*this),
+        waiter_(nullptr),
+        idle_(true) {}
+
+  channel(const channel&) = delete;
+  channel& operator=(const channel&) = delete;
+
+  // Destructor.
+  ~channel() {
+    assert(waiter_ == nullptr);
+    if (!queue_.empty()) {
+      pending_.append(queue_.dequeue_all());
+    }
+    while (!pending_.empty()) {
+      delete pending_.pop_front();
+    }
+  }
+
+  // The receiving context.
+  epoll_context& context() noexcept { return context_; }
+
+  // Send `value` from any thread.
+  void send(T value) {
+    auto* n = new node{nullptr, static_cast<T&&>(value)};
+    if (queue_.enqueue(n)) {
+      context_.schedule_impl(&drain_op_);
+    }
+  }
+
+  // Wait for the next message. From another thread the receive is queued
+  // once the io thread picks it up.
+  void receive(waiter* w) noexcept {
+    w->owner_ = this;
+    if (context_.is_running_on_io_thread()) {
+      wait(w);
+    } else {
+      w->execute_ = [](operation_base* op) noexcept {
+        auto* w = static_cast<waiter*>(op);
+        w->owner_->wait(w);
+      };
+      context_.schedule_remote(w);
+    }
+  }
+
+ private:
+  struct node {
+    node* next_;
+    T value_;
+  };
+
+  struct drain_op : operation_base {
+    explicit drain_op(channel& owner) noexcept : owner_(owner) {
+      this->execute_ = [](operation_base* op) noexcept {
+        static_cast<drain_op*>(op)->owner_.drain();
+      };
+    }
+
+    channel& owner_;
+  };
+
+  // Runs on the io thread.
+  void wait(waiter* w) noexcept {
+    assert(waiter_ == nullptr);
+    if (pending_.empty() && !idle_) {
+      pending_.append(queue_.try_mark_inactive_or_dequeue_all());
+      // Nothing queued, the next send schedules a drain.
+      idle_ = pending_.empty();
+    }
+    if (pending_.empty()) {
+      waiter_ = w;
+      return;
+    }
+    deliver(w);
+  }
+
+  // Runs on the io thread, scheduled by the send that found the queue
+  // inactive. That send also made it active again.
+  void drain() noexcept {
+    idle_ = false;
+    pending_.append(queue_.dequeue_all());
+    assert(!pending_.empty());
+    if (waiter_ != nullptr) {
+      deliver(std::exchange(waiter_, nullptr));
+    }
+  }
+
+  void deliver(waiter* w) noexcept {
+    node* n = pending_.pop_front();
+    T value = static_cast<T&&>(n->value_);
+    delete n;
+    w->complete_(w, static_cast<T&&>(value));
+  }
+
+  epoll_context& context_;
+  atomic_intrusive_queue<&node::next_> queue_;
+  // Messages taken from `queue_` but not yet received.
+  stdexec::__intrusive_queue<&node::next_> pending_;
+  drain_op drain_op_;
+  waiter* waiter_;
+  // Whether `queue_` is marked inactive and a send will schedule a drain.
+  bool idle_;
+};
+
+// A receive from a `channel`.
+template <typename ReceiverId, typename T>
+class epoll_context::channel_receive_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  using channel_t = epoll_context::channel<T>;
+
+ public:
+  struct __t : public stdexec::__immovable, private channel_t::waiter {
+    using __id = channel_receive_op;
+
+    // Constructor.
+    __t(receiver_t receiver, channel_t& channel) noexcept
+        : receiver_(static_cast<receiver_t&&>(receiver)), channel_(channel) {
+      this->complete_ = &complete;
+    }
+
+    friend void tag_invoke(stdexec::start_t, __t& self) noexcept {
+      self.channel_.receive(&self);
+    }
+
+   private:
+    static void complete(typename channel_t::waiter* w, T&& value) noexcept {
+      auto& self = *static_cast<__t*>(w);
+      stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                         static_cast<T&&>(value));
+    }
+
+    receiver_t receiver_;
+    channel_t& channel_;
+  };
+};
+
+template <typename T>
+class receive_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<
+      epoll_context::channel_receive_op<stdexec::__id<Receiver>, T>>;
+  using channel_t = epoll_context::channel<T>;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = receive_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(T)>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.channel_};
+    }
+
+    explicit constexpr __t(channel_t& channel) noexcept : channel_(channel) {}
+
+   private:
+    channel_t& channel_;
+  };
+};
+
+// Receive the next message of `channel`, completes on its context.
+struct async_receive_t {
+  template <typename T>
+  constexpr auto operator()(epoll_context::channel<T>& channel) const noexcept
+      -> stdexec::__t<receive_sender<T>> {
+    return stdexec::__t<receive_sender<T>>{channel};
+  }
+};
+}  // namespace __epoll
+
+template <typename T>
+using channel = __epoll::epoll_context::channel<T>;
+
+inline constexpr __epoll::async_receive_t async_receive{};
+}  // namespace net
+
+#endif  // EPOLL_CHANNEL_HPP_
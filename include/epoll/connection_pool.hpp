@@ -0,0 +1,439 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef EPOLL_CONNECTION_POOL_HPP_
+#define EPOLL_CONNECTION_POOL_HPP_
+
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>        // NOLINT
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <system_error>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "status-code/system_code.hpp"
+
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_connect_op.hpp"
+#include "error_channel.hpp"
+#include "meta.hpp"
+#include "monotonic_clock.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// A pool of idle keep-alive connections to upstreams, owned by one context
+// and only touched on its I/O thread, so it needs no lock; a `reactor_pool`
+// gives each context its own. The connections of an endpoint are reused
+// last in, first out, so the busiest ones stay warm and the others age out.
+//
+// A loop task of the context checks the idle connections every
+// `health_interval`: those idle for longer than `idle_timeout`, closed by
+// the peer or with unexpected data are closed. A connection is checked again
+// when it's acquired.
+//
+// Must be destroyed on the I/O thread or while the context is not running.
+// The endpoint type must be hashable.
+template <typename Protocol>
+class epoll_context::connection_pool : private loop_task {
+ public:
+  using socket_type = typename Protocol::socket;
+  using endpoint_type = typename Protocol::endpoint;
+  using duration = monotonic_clock::duration;
+
+  struct options {
+    // The most idle connections kept for one endpoint, the stalest one is
+    // closed to make room.
+    std::size_t max_idle_per_endpoint = 16;
+
+    // The most idle connections kept in total, connections released beyond
+    // it are closed.
+    std::size_t max_idle = 1024;
+
+    // How long a connection may stay idle.
+    duration idle_timeout = std::chrono::seconds(60);
+
+    // How often the idle connections are checked.
+    duration health_interval = std::chrono::seconds(5);
+  };
+
+  struct statistics {
+    // Acquisitions answered with an idle connection.
+    std::uint64_t hits = 0;
+
+    // Acquisitions which had to connect.
+    std::uint64_t misses = 0;
+
+    // Idle connections found dead when acquired.
+    std::uint64_t stale = 0;
+
+    // Idle connections closed by the health checks.
+    std::uint64_t evictions = 0;
+
+    // Connections closed on release to stay within the limits.
+    std::uint64_t overflows = 0;
+  };
+
+  // Constructor.
+  explicit connection_pool(epoll_context& context, options opts = {}) noexcept
+      : context_(context),
+        options_(opts),
+        stats_(),
+        idle_count_(0),
+        checking_(false) {
+    this->execute_ = &connection_pool::check;
+  }
+
+  connection_pool(const connection_pool&) = delete;
+  connection_pool& operator=(const connection_pool&) = delete;
+
+  // Destructor. The idle connections are closed.
+  ~connection_pool() {
+    if (checking_) {
+      context_.remove_loop_task(this);
+    }
+  }
+
+  // The context this pool belongs to.
+  epoll_context& context() noexcept { return context_; }
+
+  // The count of idle connections. Must be called on the I/O thread.
+  std::size_t idle_count() const noexcept { return idle_count_; }
+
+  // The count of idle connections to `peer`. Must be called on the I/O
+  // thread.
+  std::size_t idle_count(const endpoint_type& peer) const noexcept {
+    auto it = idle_.find(peer);
+    return it == idle_.end() ? 0 : it->second.size();
+  }
+
+  // Get the statistics. Must be called on the I/O thread.
+  statistics stats() const noexcept { return stats_; }
+
+  // Take the idle connection to `peer` released last, if any is alive. Must
+  // be called on the I/O thread.
+  std::optional<socket_type> try_acquire(const endpoint_type& peer) noexcept {
+    auto it = idle_.find(peer);
+    if (it == idle_.end()) {
+      return std::nullopt;
+    }
+    auto& stack = it->second;
+    std::optional<socket_type> socket;
+    while (!stack.empty() && !socket) {
+      idle_connection c = static_cast<idle_connection&&>(stack.back());
+      stack.pop_back();
+      --idle_count_;
+      if (is_alive(c.socket_)) {
+        socket.emplace(static_cast<socket_type&&>(c.socket_));
+      } else {
+        ++stats_.stale;
+      }
+    }
+    if (stack.empty()) {
+      idle_.erase(it);
+    }
+    return socket;
+  }
+
+  // Give a connection to `peer` back for reuse. It must belong to the context
+  // of the pool and have no operation pending. Must be called on the I/O
+  // thread.
+  void release(const endpoint_type& peer, socket_type socket) noexcept {
+    assert(&socket.context() == &context_);
+    if (!socket.is_open()) {
+      return;
+    }
+    if (idle_count_ >= options_.max_idle ||
+        options_.max_idle_per_endpoint == 0) {
+      ++stats_.overflows;
+      return;
+    }
+    try {
+      auto& stack = idle_[peer];
+      if (stack.size() >= options_.max_idle_per_endpoint) {
+        stack.erase(stack.begin());
+        --idle_count_;
+        ++stats_.overflows;
+      }
+      stack.push_back(
+          {static_cast<socket_type&&>(socket), context_.loop_now()});
+    } catch (...) {
+      ++stats_.overflows;
+      return;
+    }
+    ++idle_count_;
+    if (!checking_) {
+      checking_ = true;
+      this->due_ = context_.loop_now() + options_.health_interval;
+      context_.add_loop_task(this);
+    }
+  }
+
+  // Close every idle connection. Must be called on the I/O thread.
+  void clear() noexcept {
+    idle_.clear();
+    idle_count_ = 0;
+  }
+
+ private:
+  template <typename, typename>
+  friend class epoll_context::acquire_op;
+
+  struct idle_connection {
+    socket_type socket_;
+    time_point since_;
+  };
+
+  // Whether an idle connection can still be used: nothing to read and not
+  // closed by the peer. Data on an idle connection is a protocol error.
+  static bool is_alive(socket_type& socket) noexcept {
+    char byte;
+    auto res = socket.recv(&byte, 1, MSG_PEEK | MSG_DONTWAIT);
+    return res.has_error() && res.error() == errc::operation_would_block;
+  }
+
+  static void check(loop_task* task) noexcept {
+    auto& self = static_cast<connection_pool&>(*task);
+    const time_point now = self.context_.loop_now();
+    for (auto it = self.idle_.begin(); it != self.idle_.end();) {
+      auto& stack = it->second;
+      const std::size_t before = stack.size();
+      std::erase_if(stack, [&](idle_connection& c) {
+        return now - c.since_ >= self.options_.idle_timeout ||
+               !is_alive(c.socket_);
+      });
+      self.stats_.evictions += before - stack.size();
+      self.idle_count_ -= before - stack.size();
+      it = stack.empty() ? self.idle_.erase(it) : std::next(it);
+    }
+    if (self.idle_count_ == 0) {
+      self.checking_ = false;
+      self.context_.remove_loop_task(task);
+    } else {
+      self.due_ = now + self.options_.health_interval;
+    }
+  }
+
+  epoll_context& context_;
+  options options_;
+  statistics stats_;
+  std::unordered_map<endpoint_type, std::vector<idle_connection>> idle_;
+  std::size_t idle_count_;
+
+  // Whether the loop task is added to the context.
+  bool checking_;
+};
+
+// Take an idle connection from the pool, or connect a new one. Runs on the
+// I/O thread of the pool. A stop request cancels the connect.
+template <typename ReceiverId, typename Protocol>
+class epoll_context::acquire_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  using pool_t = epoll_context::connection_pool<Protocol>;
+  using socket_t = typename Protocol::socket;
+  using endpoint_t = typename Protocol::endpoint;
+
+ public:
+  struct __t;
+
+ private:
+  // The receiver of the connect, which hands the outcome to the operation.
+  struct connect_receiver {
+    using is_receiver = void;
+    using __t = connect_receiver;
+    using __id = connect_receiver;
+
+    friend void tag_invoke(stdexec::set_value_t,
+                           connect_receiver&& self) noexcept {
+      self.op_->on_connected({});
+    }
+
+    friend void tag_invoke(stdexec::set_error_t, connect_receiver&& self,
+                           std::error_code&& ec) noexcept {
+      self.op_->on_connected(ec);
+    }
+
+    friend void tag_invoke(stdexec::set_stopped_t,
+                           connect_receiver&& self) noexcept {
+      self.op_->on_connected(
+          std::make_error_code(std::errc::operation_canceled));
+    }
+
+    friend auto tag_invoke(stdexec::get_env_t,
+                           const connect_receiver& self) noexcept {
+      return stdexec::get_env(self.op_->receiver_);
+    }
+
+    acquire_op::__t* op_;
+  };
+
+  // The connect of a new connection.
+  struct connector {
+    explicit connector(acquire_op::__t& op) noexcept
+        : op_(stdexec::connect(
+              stdexec::__t<connect_sender<Protocol>>{op.socket_, op.peer_},
+              connect_receiver{&op})) {}
+
+    stdexec::connect_result_t<stdexec::__t<connect_sender<Protocol>>,
+                              connect_receiver>
+        op_;
+  };
+
+ public:
+  struct __t : private completion_op {
+    using __id = acquire_op;
+    using stop_token = stdexec::stop_token_of_t<stdexec::env_of_t<receiver_t>&>;
+
+    __t(receiver_t receiver, pool_t& pool, const endpoint_t& peer) noexcept
+        : receiver_(static_cast<receiver_t&&>(receiver)),
+          pool_(pool),
+          peer_(peer),
+          socket_(pool.context()) {}
+
+    friend void tag_invoke(stdexec::start_t, __t& self) noexcept {
+      if constexpr (!std::unstoppable_token<stop_token>) {
+        if (stdexec::get_stop_token(stdexec::get_env(self.receiver_))
+                .stop_requested()) {
+          stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+          return;
+        }
+      }
+      epoll_context& context = self.pool_.context();
+      if (context.can_run_inline()) {
+        epoll_context::inline_scope scope{context};
+        self.begin();
+      } else {
+        self.execute_ = [](operation_base* op) noexcept {
+          static_cast<__t*>(static_cast<completion_op*>(op))->begin();
+        };
+        context.schedule_impl(static_cast<completion_op*>(&self));
+      }
+    }
+
+   private:
+    friend connect_receiver;
+    friend connector;
+
+    void begin() noexcept {
+      if (auto socket = pool_.try_acquire(peer_)) {
+        ++pool_.stats_.hits;
+        stdexec::set_value(static_cast<receiver_t&&>(receiver_),
+                           static_cast<socket_t&&>(*socket));
+        return;
+      }
+      ++pool_.stats_.misses;
+      if (auto ec = socket_.open(peer_.protocol()); ec.failure()) {
+        stdexec::set_error(
+            static_cast<receiver_t&&>(receiver_),
+            to_error<std::error_code>(
+                static_cast<system_error2::system_code&&>(ec)));
+        return;
+      }
+      connector_.__construct(*this);
+      stdexec::start(connector_.__get().op_);
+    }
+
+    void on_connected(std::error_code ec) noexcept {
+      connector_.__destroy();
+      if (!ec) {
+        stdexec::set_value(static_cast<receiver_t&&>(receiver_),
+                           static_cast<socket_t&&>(socket_));
+      } else if (ec == std::errc::operation_canceled) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(receiver_));
+      } else {
+        stdexec::set_error(static_cast<receiver_t&&>(receiver_),
+                           static_cast<std::error_code&&>(ec));
+      }
+    }
+
+    receiver_t receiver_;
+    pool_t& pool_;
+    endpoint_t peer_;
+    socket_t socket_;
+    exec::__manual_lifetime<connector> connector_;
+  };
+};
+
+template <typename Protocol>
+class acquire_sender {
+  using pool_t = epoll_context::connection_pool<Protocol>;
+  template <typename Receiver>
+  using op_t = stdexec::__t<
+      epoll_context::acquire_op<stdexec::__id<Receiver>, Protocol>>;
+  using socket_t = typename Protocol::socket;
+  using endpoint_t = typename Protocol::endpoint;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = acquire_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(socket_t),
+                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.pool_, self.peer_};
+    }
+
+    constexpr __t(pool_t& pool, const endpoint_t& peer) noexcept
+        : pool_(pool), peer_(peer) {}
+
+   private:
+    pool_t& pool_;
+    endpoint_t peer_;
+  };
+};
+
+// Get a connected socket to `peer` from `pool`, reusing an idle connection
+// when there is one. Give it back with `pool.release` once the exchange on
+// it is complete, or let it close.
+struct async_acquire_t {
+  template <transport_protocol Protocol>
+  auto operator()(epoll_context::connection_pool<Protocol>& pool,
+                  const typename Protocol::endpoint& peer) const noexcept
+      -> stdexec::__t<acquire_sender<Protocol>> {
+    return {pool, peer};
+  }
+};
+}  // namespace __epoll
+
+template <typename Protocol>
+using connection_pool = __epoll::epoll_context::connection_pool<Protocol>;
+
+inline constexpr __epoll::async_acquire_t async_acquire{};
+}  // namespace net
+
+#endif  // EPOLL_CONNECTION_POOL_HPP_
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_COUNT_TRAFFIC_HPP_
+#define EPOLL_COUNT_TRAFFIC_HPP_
+
+#include <cstddef>
+
+#include "stdexec.hpp"
+
+#include "connection_table.hpp"
+#include "epoll/epoll_context.hpp"
+
+namespace net {
+
+// Adaptors counting the bytes of a receive or a send into the traffic columns
+// of the connection `h` of `table`, stamped with the loop time of `context`:
+//
+//   async_recv_some(socket, buf) | count_received(table, h, ctx)
+//
+// The value passes through. The operations complete on the io thread which
+// owns the table, and a connection erased meanwhile is ignored.
+template <typename T, std::size_t SlabSize>
+auto count_received(connection_table<T, SlabSize>& table,
+                    typename connection_table<T, SlabSize>::handle h,
+                    epoll_context& context) noexcept {
+  return stdexec::then([&table, h, &context](std::size_t n) noexcept {
+    table.add_received(h, n, context.loop_now());
+    return n;
+  });
+}
+
+template <typename T, std::size_t SlabSize>
+auto count_sent(connection_table<T, SlabSize>& table,
+                typename connection_table<T, SlabSize>::handle h,
+                epoll_context& context) noexcept {
+  return stdexec::then([&table, h, &context](std::size_t n) noexcept {
+    table.add_sent(h, n, context.loop_now());
+    return n;
+  });
+}
+
+}  // namespace net
+
+#endif  // EPOLL_COUNT_TRAFFIC_HPP_
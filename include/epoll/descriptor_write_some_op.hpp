@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef EPOLL_DESCRIPTOR_WRITE_SOME_OP_HPP_
+#define EPOLL_DESCRIPTOR_WRITE_SOME_OP_HPP_
+
+#include <cstddef>
+#include <system_error>  // NOLINT
+
+#include "status-code/system_code.hpp"
+
+#include "buffer.hpp"
+#include "buffer_sequence_adapter.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_io_base_op.hpp"
+#include "error_channel.hpp"
+#include "posix/stream_descriptor.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+template <typename ReceiverId, typename Buffers>
+class epoll_context::descriptor_write_some_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  template <typename Derived>
+  using base_op_t = stdexec::__t<epoll_context::socket_io_base_op<
+      ReceiverId, void, Derived, posix::stream_descriptor>>;
+  using bufs_t = buffer_sequence_adapter<const_buffer, Buffers>;
+
+ public:
+  struct __t : public base_op_t<__t> {
+    using __id = descriptor_write_some_op;
+    using base_t = base_op_t<__t>;
+    friend base_t;
+
+    // Constructor.
+    constexpr __t(receiver_t receiver, posix::stream_descriptor& descriptor,
+                  Buffers buffers) noexcept
+        : base_t(static_cast<receiver_t&&>(receiver), descriptor),
+          bytes_transferred_(0),
+          buffers_(buffers),
+          bufs_(buffers_) {}
+
+   private:
+    static constexpr void non_blocking_write(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      auto res =
+          self.socket_.write_some(self.bufs_.buffers(), self.bufs_.count());
+      if (res.has_error()) {
+        self.ec_ = static_cast<system_error2::system_code&&>(res.error());
+      } else {
+        self.bytes_transferred_ += res.value();
+      }
+    }
+
+    static void complete(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      if (self.ec_ == errc::operation_canceled) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      } else if (self.ec_ == errc::success) {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                           self.bytes_transferred_);
+      } else {
+        stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                           to_error<std::error_code>(self.ec_));
+      }
+    }
+
+    static constexpr typename base_t::op_type otype = base_t::op_type::op_write;
+    static constexpr
+        typename base_t::op_vtable op_vtable{&non_blocking_write, &complete};
+    size_t bytes_transferred_;
+    Buffers buffers_;
+    bufs_t bufs_;
+  };
+};
+
+template <typename Buffers>
+class write_some_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<epoll_context::descriptor_write_some_op<
+      stdexec::__id<Receiver>, Buffers>>;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = write_some_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(size_t),
+                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.descriptor_,
+              self.buffers_};
+    }
+
+    constexpr __t(posix::stream_descriptor& descriptor,
+                  Buffers buffers) noexcept
+        : descriptor_(descriptor), buffers_(buffers) {}
+
+   private:
+    posix::stream_descriptor& descriptor_;
+    Buffers buffers_;
+  };
+};
+
+// Write some bytes of `buffers` to `descriptor`, waiting until it's writable.
+struct async_write_some_t {
+  template <const_buffer_sequence Buffers>
+  constexpr auto operator()(posix::stream_descriptor& descriptor,
+                            Buffers buffers) const noexcept
+      -> stdexec::__t<write_some_sender<Buffers>> {
+    return {descriptor, buffers};
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::async_write_some_t async_write_some{};
+}  // namespace net
+
+#endif  // EPOLL_DESCRIPTOR_WRITE_SOME_OP_HPP_
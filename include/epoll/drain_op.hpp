@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef EPOLL_DRAIN_OP_HPP_
+#define EPOLL_DRAIN_OP_HPP_
+
+#include <chrono>  // NOLINT
+
+#include "epoll/epoll_context.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// Drain the context for a graceful shutdown. The listening sockets are
+// canceled right away, the operations parked on the other descriptors and
+// the work counted by `work_started` may finish until `deadline`, then the
+// remaining parked operations are canceled too. Completes on the io thread
+// once nothing is left, and `run()` returns right after. Timers are not
+// waited for, they stay pending like after `request_stop`.
+//
+// Several drains may overlap, the earliest deadline wins. The canceled
+// sockets can be used again once the drain has completed.
+template <typename ReceiverId>
+class epoll_context::drain_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+
+ public:
+  struct __t : public stdexec::__immovable, private drain_base {
+    using __id = drain_op;
+
+    // Constructor.
+    __t(receiver_t receiver, epoll_context& context,
+        const time_point& deadline) noexcept
+        : receiver_(static_cast<receiver_t&&>(receiver)), context_(context) {
+      this->deadline_ = deadline;
+      this->execute_ = [](operation_base* op) noexcept {
+        auto* self = static_cast<__t*>(static_cast<drain_base*>(op));
+        self->context_.begin_drain(self);
+      };
+      this->complete_ = [](drain_base* op) noexcept {
+        auto& self = *static_cast<__t*>(op);
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_));
+      };
+    }
+
+    friend void tag_invoke(stdexec::start_t, __t& self) noexcept {
+      self.context_.schedule_impl(static_cast<drain_base*>(&self));
+    }
+
+   private:
+    receiver_t receiver_;
+    epoll_context& context_;
+  };
+};
+
+class drain_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<epoll_context::drain_op<stdexec::__id<Receiver>>>;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = drain_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.context_,
+              self.deadline_};
+    }
+
+    constexpr __t(epoll_context& context,
+                  const epoll_context::time_point& deadline) noexcept
+        : context_(context), deadline_(deadline) {}
+
+   private:
+    epoll_context& context_;
+    epoll_context::time_point deadline_;
+  };
+};
+
+// Drain `context`, canceling what is left at `deadline` or after `grace`.
+struct async_drain_t {
+  constexpr auto operator()(epoll_context& context,
+                            const epoll_context::time_point& deadline) const
+      noexcept -> stdexec::__t<drain_sender> {
+    return stdexec::__t<drain_sender>{context, deadline};
+  }
+
+  template <typename Rep, typename Ratio>
+  auto operator()(epoll_context& context,
+                  const std::chrono::duration<Rep, Ratio>& grace) const noexcept
+      -> stdexec::__t<drain_sender> {
+    return stdexec::__t<drain_sender>{context, context.now() + grace};
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::async_drain_t async_drain{};
+}  // namespace net
+
+#endif  // EPOLL_DRAIN_OP_HPP_
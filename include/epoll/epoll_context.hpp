@@ -17,36 +17,95 @@
 #define EPOLL_EPOLL_CONTEXT_HPP_
 
 #include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
 #include <sys/timerfd.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <cassert>
 #include <chrono>  // NOLINT
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <limits>
+#include <memory>
 #include <optional>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "status-code/result.hpp"
+#include "status-code/system_code.hpp"
 #include "stdexec.hpp"
 
 #include "atomic_intrusive_queue.hpp"
 #include "eventfd_interrupter.hpp"
+#include "buffer_pool.hpp"
 #include "execution_context.hpp"
-#include "intrusive_heap.hpp"
+#include "flight_recorder.hpp"
+#include "hugepage_arena.hpp"
 #include "intrusive_list.hpp"
+#include "intrusive_pairing_heap.hpp"
+#include "intrusive_timing_wheel.hpp"
+#include "latency_histogram.hpp"
+#include "loop_profiler.hpp"
 #include "meta.hpp"
 #include "monotonic_clock.hpp"
+#include "recycling_allocator.hpp"
+#include "sharded_intrusive_queue.hpp"
+#include "size_class_pool.hpp"
+#include "stat_counter.hpp"
+#include "usdt_probe.hpp"
 
 namespace net {
 namespace __epoll {
+// Customization point object that schedules a coarse timer. The timer may
+// complete up to one tick of the scheduler's timing wheel late, in exchange
+// for O(1) insertion and cancellation. Suits timeouts which are mostly
+// cancelled before they fire.
+struct schedule_after_coarse_t {
+  template <typename Scheduler>
+    requires stdexec::tag_invocable<schedule_after_coarse_t,
+                                    const Scheduler&, std::chrono::nanoseconds>
+  constexpr auto operator()(const Scheduler& sched,
+                            std::chrono::nanoseconds duration) const noexcept {
+    return tag_invoke(*this, sched, duration);
+  }
+};
+
+// Customization point object that returns the time cached by the scheduler's
+// context at the start of the current iteration of its run loop. Cheaper than
+// `exec::now` but lags behind it by the time spent executing operations, which
+// is fine for coarse timeouts and activity stamps.
+struct loop_now_t {
+  template <typename Scheduler>
+    requires stdexec::tag_invocable<loop_now_t, const Scheduler&>
+  constexpr auto operator()(const Scheduler& sched) const noexcept {
+    return tag_invoke(*this, sched);
+  }
+};
+
 // The usage mode is single thread single epoll. Multithreading drive one
 // context is not allowed. The thread which running the context is called io
 // thread, and others are called remote threads.
 class epoll_context final : public execution_context {
  public:
-  // The scheduler of this context. Both `schedule_at`, `schedule_after` and
-  // `schedule` customization point object are supported by this scheduler.
+  // The scheduler of this context. Both `schedule_at`, `schedule_after`,
+  // `schedule_after_coarse` and `schedule` customization point object are
+  // supported by this scheduler.
   class scheduler;
 
+  // An allocator for operation states. Memory allocated and freed on the io
+  // thread is recycled by a size-class pool of this context, other threads use
+  // the global heap.
+  template <typename T>
+  class allocator;
+
   // The base class for all the types of operations that this context can
   // perform. Note that operations will be executed by context in the order they
   // are committed.
@@ -59,7 +118,9 @@ class epoll_context final : public execution_context {
     ~operation_base() { assert(!enqueued_); }
 
     // The flag determines whether the current operation is in a remote or local
-    // queue.
+    // queue. The io thread sets and clears it with relaxed stores, which are
+    // plain stores on x86 instead of a locked exchange, since only remote
+    // enqueues must publish it and those go through the remote queue.
     std::atomic_bool enqueued_;
 
     // The `next_` pointer points to the next operation on the operation queue,
@@ -85,76 +146,517 @@ class epoll_context final : public execution_context {
     bool should_stop_ = false;
   };
 
+  // The state of a descriptor registered to epoll. Every descriptor is
+  // registered only once with all the events we are interested in, and stays
+  // registered until the socket is closed. The operations waiting for the
+  // descriptor to become ready are parked on the slots of this state.
+  struct descriptor_state {
+    // The slots of operations waiting on this descriptor.
+    enum op_slot { read_slot = 0, write_slot = 1, except_slot = 2, max_slots };
+
+    // Constructor.
+    constexpr descriptor_state() noexcept
+        : descriptor_(-1),
+          ops_{},
+          zerocopy_sequence_(0),
+          zerocopy_enabled_(false),
+          canceled_(false),
+          background_(false),
+          ready_(0),
+          reads_(0),
+          read_iteration_(0),
+          next_free_(nullptr) {}
+
+    // Park the operation on the given slot. Only one operation can wait on
+    // each slot, returns false if the slot is already taken.
+    constexpr bool park(op_slot slot, completion_op* op) noexcept {
+      if (ops_[slot] != nullptr) {
+        return false;
+      }
+      ops_[slot] = op;
+      return true;
+    }
+
+    // Take the operation out of the given slot if it's still parked there.
+    // Returns whether the operation was parked.
+    constexpr bool unpark(op_slot slot, completion_op* op) noexcept {
+      if (ops_[slot] != op) {
+        return false;
+      }
+      ops_[slot] = nullptr;
+      return true;
+    }
+
+    // The registered descriptor.
+    int descriptor_;
+
+    // The operations waiting on this descriptor.
+    completion_op* ops_[max_slots];
+
+    // The kernel numbers every successful MSG_ZEROCOPY send on a socket,
+    // starting from zero. This is the number of the next one.
+    uint32_t zerocopy_sequence_;
+
+    // Whether SO_ZEROCOPY has been set on the descriptor.
+    bool zerocopy_enabled_;
+
+    // Set by a drain to cancel the operations waiting on the descriptor,
+    // cleared once the drain is finished.
+    bool canceled_;
+
+    // Whether the operations waiting on the descriptor are canceled as soon
+    // as a drain begins, like those on listening sockets, instead of holding
+    // it up. Set by waits which may never complete, e.g. on signals.
+    bool background_;
+
+    // The slots which were reported ready while no operation was parked on
+    // them, one bit per slot. A bit may be stale if the readiness has been
+    // consumed by a syscall since.
+    uint8_t ready_;
+
+    // The reads started on the descriptor in the iteration `read_iteration_`
+    // of the run loop, see `set_read_budget`.
+    uint32_t reads_;
+    uint64_t read_iteration_;
+
+    // The next state in the context's free list or in the list of states
+    // released by remote threads.
+    descriptor_state* next_free_;
+  };
+
   // The base class for the socket io operation associated with epoll.
-  template <typename Receiver, typename Protocol>
+  // `Socket` is the type of the descriptor owner the operation works on.
+  template <typename Receiver, typename Protocol, typename Derived,
+            typename Socket = typename Protocol::socket>
   class socket_io_base_op;
 
-  // Socket operation that accepts a new connection based on epoll.
-  template <typename Receiver, typename Protocol>
+  // Socket operation that accepts a new connection based on epoll. If `Many`
+  // is true, the operation drains the backlog and completes with a batch of
+  // connections. Errors are delivered as `Error`.
+  template <typename Receiver, typename Protocol, bool Many = false,
+            typename Error = std::error_code>
   class socket_accept_op;
 
-  // recv some operation.
+  // Socket operation that stays parked on the acceptor and hands every
+  // accepted connection to a handler until it is stopped.
+  template <typename Receiver, typename Protocol, typename Handler>
+  class socket_accept_each_op;
+
+  // Socket operation that sends with MSG_ZEROCOPY and completes once the
+  // kernel has released the buffers.
+  template <typename Receiver, typename Protocol, typename Buffers>
+  class socket_send_zerocopy_op;
+
+  // Socket operation that sends a file with sendfile.
+  template <typename Receiver, typename Protocol>
+  class socket_sendfile_op;
+
+  // Socket operation that moves data between two sockets with splice.
+  template <typename Receiver, typename Protocol>
+  class socket_splice_op;
+
+  // Socket operation that waits for a socket to become ready.
+  template <typename ReceiverId, typename Protocol>
+  class socket_wait_op;
+
+  // Socket operation that connects to a peer without blocking.
+  template <typename Receiver, typename Protocol>
+  class socket_connect_op;
+
+  // Socket operation that connects with TCP Fast Open, sending the first
+  // bytes along with the SYN.
   template <typename Receiver, typename Protocol, typename Buffers>
+  class socket_connect_with_data_op;
+
+  // recv some operation. Errors are delivered as `Error`.
+  template <typename Receiver, typename Protocol, typename Buffers,
+            typename Error = std::error_code>
   class socket_recv_some_op;
 
+  // Receive operation which also tells the kernel receive timestamps.
+  template <typename Receiver, typename Protocol, typename Buffers>
+  class socket_recv_timestamp_op;
+
+  // Receive operation of kernel TLS records, which also tells their type.
+  template <typename Receiver, typename Protocol, typename Buffers>
+  class socket_recv_tls_record_op;
+
+  // Send and receive operations passing descriptors over unix domain sockets.
+  template <typename Receiver, typename Protocol>
+  class socket_send_fds_op;
+
+  template <typename Receiver, typename Protocol>
+  class socket_recv_fds_op;
+
+  // Read and write operations on a `posix::stream_descriptor`.
+  template <typename Receiver, typename Buffers>
+  class descriptor_read_some_op;
+
+  template <typename Receiver, typename Buffers>
+  class descriptor_write_some_op;
+
+  // Waits for signals through a signalfd, see `async_wait_signal`.
+  template <typename Receiver>
+  class signal_wait_op;
+
+  // Moves an idle socket to another epoll context, see `async_migrate`.
+  template <typename Receiver, typename Protocol>
+  class socket_migrate_op;
+
+  // Runs this context on the calling thread until a sender completes, see
+  // `net::sync_wait`.
+  template <typename Sender>
+  class sync_wait_op;
+
   // send some operation.
   template <typename Receiver, typename Protocol, typename Buffers>
   class socket_send_some_op;
 
+  // recv operation which claims a block of the context's receive buffer pool
+  // only once the socket is readable.
+  template <typename Receiver, typename Protocol>
+  class socket_recv_pooled_op;
+
+  // Stream operations which keep waiting until the whole buffer sequence is
+  // transferred.
+  template <typename Receiver, typename Protocol, typename Buffers>
+  class socket_send_all_op;
+
+  // Operation which sends one payload to a set of sockets, see
+  // `async_send_to_all`.
+  template <typename Receiver, typename Protocol, typename Buffers>
+  class socket_send_to_all_op;
+
+  template <typename Receiver, typename Protocol, typename Buffers>
+  class socket_recv_exactly_op;
+
+  // Stream operation which receives into a dynamic buffer until it contains
+  // a delimiter.
+  template <typename Receiver, typename Protocol, typename DynamicBuffer>
+  class socket_recv_until_op;
+
+  // Receive operation which grows a dynamic buffer by the bytes available.
+  template <typename Receiver, typename Protocol, typename DynamicBuffer,
+            typename Error>
+  class socket_recv_dynamic_op;
+
+  // Stream operation which receives until `framed_stream` holds at least one
+  // complete frame.
+  template <typename Receiver, typename Protocol>
+  class socket_recv_frames_op;
+
+  // The outgoing queue of a stream socket, which coalesces the writes queued
+  // during an iteration of the run loop into one sendmsg.
+  template <typename Protocol>
+  class write_queue;
+
+  template <typename Receiver, typename Protocol, typename Buffers>
+  class socket_send_queued_op;
+
+  // Waits for the bytes queued on a `write_queue` to fall below a mark.
+  template <typename Receiver, typename Protocol>
+  class write_queue_wait_op;
+
+  // Datagram operations which also carry the peer endpoint. If `Segmented`
+  // is true, the size of the segments coalesced by UDP GRO is reported too.
+  template <typename Receiver, typename Protocol, typename Buffers,
+            bool Segmented = false>
+  class socket_recv_from_op;
+
+  template <typename Receiver, typename Protocol, typename Buffers>
+  class socket_send_to_op;
+
+  // Datagram operations which exchange a whole datagram_batch with one
+  // recvmmsg or sendmmsg.
+  template <typename Receiver, typename Protocol>
+  class socket_recv_batch_op;
+
+  template <typename Receiver, typename Protocol>
+  class socket_send_batch_op;
+
+  // Resolves a host and service name on a `resolver_pool` worker and
+  // completes back on the I/O thread.
+  template <typename Receiver, typename Protocol>
+  class resolve_op;
+
+  // Reads or writes a file at an offset on a `file_io_pool` worker and
+  // completes back on the I/O thread.
+  template <typename Receiver, typename Buffers, bool Write>
+  class file_io_op;
+
+  // A per-context cache of resolver results, and the lookup through it.
+  template <typename Protocol>
+  class resolver_cache;
+
+  template <typename Receiver, typename Protocol>
+  class resolve_cached_op;
+
+  // A per-context pool of idle connections to upstreams, and the acquisition
+  // of a connection through it.
+  template <typename Protocol>
+  class connection_pool;
+
+  template <typename Receiver, typename Protocol>
+  class acquire_op;
+
+  // Races staggered connects over a list of endpoints, RFC 8305 style.
+  template <typename Receiver, typename Protocol, typename Factory>
+  class connect_any_op;
+
+  // A multi-producer channel of `T` drained by this context. Only the first
+  // message after the receiving side went idle wakes the io thread.
+  template <typename T>
+  class channel;
+
+  template <typename ReceiverId, typename T>
+  class channel_receive_op;
+
+  // A timer any number of operations can wait on, sharing one heap entry.
+  class steady_timer;
+
+  template <typename ReceiverId>
+  class timer_wait_op;
+
+  // Waits for the context to drain, see `async_drain`.
+  template <typename ReceiverId>
+  class drain_op;
+
   // The time_point type used by scheduler.
   using time_point = monotonic_clock::time_point;
 
   // The `schedule_at_op` is executed on `due_time`.
   struct schedule_at_base_op : operation_base {
     schedule_at_base_op(epoll_context& context, const time_point& due_time,
-                        bool can_be_cancelled) noexcept
-        : timer_next_(nullptr),
+                        bool can_be_cancelled, bool coarse = false) noexcept
+        : timer_child_(nullptr),
+          timer_next_(nullptr),
           timer_prev_(nullptr),
+          timer_slot_(0),
           context_(context),
           due_time_(due_time),
           can_be_cancelled_(can_be_cancelled),
+          coarse_(coarse),
           state_(0) {}
 
     // The operation status value.
     static constexpr uint32_t timer_elapsed = 1;
     static constexpr uint32_t cancel_pending = 2;
 
+    schedule_at_base_op* timer_child_;
     schedule_at_base_op* timer_next_;
     schedule_at_base_op* timer_prev_;
+    uint32_t timer_slot_;
     epoll_context& context_;
     time_point due_time_;
     bool can_be_cancelled_;
+
+    // Whether this timer lives in the timing wheel instead of the heap.
+    bool coarse_;
     std::atomic<uint32_t> state_;
   };
 
+  // A task executed by the run loop once `due_` has passed, checked against
+  // the loop time once per iteration. The blocking wait is bounded by the
+  // earliest due task, so tasks run even when the context is idle. A task
+  // sets its next due time when it's executed, a due time in the past makes
+  // it run again in the next iteration.
+  struct loop_task {
+    loop_task* next_ = nullptr;
+    loop_task* prev_ = nullptr;
+    time_point due_;
+    void (*execute_)(loop_task*) noexcept = nullptr;
+  };
+
+  // The base of the operations waiting for the context to drain.
+  struct drain_base : operation_base {
+    time_point deadline_;
+    drain_base* next_drain_ = nullptr;
+    void (*complete_)(drain_base*) noexcept = nullptr;
+  };
+
   // The heap of all timer operations.
-  using timer_heap = intrusive_heap<schedule_at_base_op,                //
-                                    &schedule_at_base_op::timer_next_,  //
-                                    &schedule_at_base_op::timer_prev_,  //
-                                    time_point,                         //
-                                    &schedule_at_base_op::due_time_>;
+  using timer_heap =
+      intrusive_pairing_heap<schedule_at_base_op,                 //
+                             &schedule_at_base_op::timer_child_,  //
+                             &schedule_at_base_op::timer_next_,   //
+                             &schedule_at_base_op::timer_prev_,   //
+                             time_point,                          //
+                             &schedule_at_base_op::due_time_>;
+
+  // The timing wheel of coarse timer operations.
+  using timer_wheel =
+      intrusive_timing_wheel<schedule_at_base_op,                //
+                             &schedule_at_base_op::timer_next_,  //
+                             &schedule_at_base_op::timer_prev_,  //
+                             &schedule_at_base_op::timer_slot_,  //
+                             time_point,                         //
+                             &schedule_at_base_op::due_time_>;
+
+  // The tick of the coarse timing wheel.
+  static constexpr auto coarse_timer_tick = std::chrono::milliseconds(10);
 
   // The queue of operations.
   using operation_queue = stdexec::__intrusive_queue<&operation_base::next_>;
 
-  // Default constructor.
-  epoll_context()
+  // The default count of events one epoll_wait call can return.
+  static constexpr std::size_t default_event_batch_size = 256;
+
+  // The smallest batch the adaptive mode shrinks to.
+  static constexpr std::size_t min_event_batch_size = 16;
+
+  // How many events ahead the dispatch pass requests the descriptor states.
+  static constexpr int dispatch_prefetch_distance = 4;
+
+  // Statistics of the events returned by epoll_wait. Can be read from any
+  // thread while the context is running.
+  struct event_batch_stats {
+    // The count of epoll_wait calls.
+    std::uint64_t wait_count = 0;
+
+    // The total count of events returned.
+    std::uint64_t event_count = 0;
+
+    // The count of epoll_wait calls which filled up the whole batch.
+    std::uint64_t full_batch_count = 0;
+
+    // The count of events returned by the last epoll_wait call.
+    std::size_t last_batch_fill = 0;
+
+    // The current batch size.
+    std::size_t batch_size = 0;
+  };
+
+  // How a context is sized up front, see the constructor taking it. Timers are
+  // intrusive, they need no storage of the context.
+  struct options {
+    // See the constructor below.
+    std::size_t event_batch_size = default_event_batch_size;
+    bool adaptive_event_batch = false;
+    std::size_t remote_queue_lanes = 1;
+
+    // Descriptor states created up front, about one per connection.
+    std::size_t expected_connections = 0;
+
+    // Operation states of every size class cached up front.
+    std::size_t operations_per_class = 0;
+
+    // The block size of the receive buffer pool, zero keeps the default, and
+    // the count of blocks allocated up front.
+    std::size_t recv_block_size = 0;
+    std::size_t recv_blocks = 0;
+
+    // Back the operation states and the receive buffers with a hugepage
+    // arena, see `reserve_hugepages`.
+    bool hugepages = false;
+
+    // Write everything reserved once, so that its pages are faulted in at
+    // construction instead of during the first traffic.
+    bool prefault = false;
+  };
+
+  // Constructor. At most `event_batch_size` events are fetched by each
+  // epoll_wait call. If `adaptive_event_batch` is true, the batch starts small
+  // and doubles every time it fills up, and halves when less than a quarter of
+  // it is used, bounded by `event_batch_size`. If `remote_queue_lanes` is more
+  // than one, operations submitted by other threads go through that many
+  // lanes instead of a single queue, which scales better when many threads
+  // submit at once, but loses the order between different threads.
+  explicit epoll_context(
+      std::size_t event_batch_size = default_event_batch_size,
+      bool adaptive_event_batch = false, std::size_t remote_queue_lanes = 1)
       : epoll_fd_(create_epoll()),                 //
         timer_fd_(create_timer()),                 //
         interrupter_(),                            //
         timers_(),                                 //
+        coarse_timers_(coarse_timer_tick),         //
         current_earliest_due_time_(),              //
-        processed_remote_queue_submitted_(false),  //
         timers_are_dirty_(false),                  //
         local_queue_(),                            //
+        continuation_queue_(),                     //
+        high_queue_(),                             //
+        low_queue_(),                              //
+        high_remote_queue_(),                      //
+        local_budget_ops_(std::numeric_limits<std::size_t>::max()),
+        local_budget_time_(0),
         remote_queue_(),                           //
+        remote_lanes_(remote_queue_lanes > 1
+                          ? std::make_unique<remote_lanes>(remote_queue_lanes)
+                          : nullptr),
+        stop_queue_(),                             //
         outstanding_work_(0),                      //
+        draining_(false),                          //
+        drain_waiters_(nullptr),                   //
+        drain_deadline_(),                         //
         stop_source_(std::in_place),               //
-        is_running_(false) {
+        is_running_(false),                        //
+        io_thread_id_(),                           //
+        descriptor_states_(),                      //
+        free_descriptor_states_(nullptr),          //
+        descriptor_count_(0),                      //
+        remote_released_descriptor_states_(nullptr),  //
+        events_(std::max<std::size_t>(event_batch_size, 1)),
+        adaptive_event_batch_(adaptive_event_batch),
+        event_batch_size_(
+            adaptive_event_batch
+                ? std::min(min_event_batch_size, events_.size())
+                : events_.size()),
+        wait_count_(0),
+        event_count_(0),
+        full_batch_count_(0),
+        last_batch_fill_(0),
+        spin_budget_(0),
+        socket_busy_poll_(0),
+        remote_item_count_(0),
+        remote_interrupt_count_(0),
+        remote_saved_interrupt_count_(0),
+        inline_depth_(0),
+        read_budget_(0),
+        inline_io_completions_(false),
+        loop_iteration_(0),
+        deferred_queue_(),
+        timer_mode_(timer_mode::timerfd),
+        has_epoll_pwait2_(true),
+        timer_slack_(0),
+        timer_rearm_count_(0),
+        clock_(&monotonic_clock::now),
+        arena_(),
+        operation_pool_(),
+        remote_freed_operations_(nullptr),
+        recv_buffer_pool_(),
+        loop_tasks_(),
+        thread_info_(),
+        loop_time_(monotonic_clock::now()),
+        heartbeat_enabled_(false),
+        busy_since_(0),
+        current_execute_(nullptr),
+        last_iteration_(0),
+        latency_(latency_enabled ? std::make_unique<std::array<
+                                       latency_stats, op_kind_count>>()
+                                 : nullptr),
+        flight_recorder_(nullptr) {
     add_timer_to_epoll();
     add_interrupter_to_epoll();
   }
 
+  // Constructor. Everything which otherwise grows lazily is reserved as
+  // `opts` tells, so that a cold start doesn't pay for allocations and page
+  // faults during its first traffic.
+  explicit epoll_context(const options& opts)
+      : epoll_context(opts.event_batch_size, opts.adaptive_event_batch,
+                      opts.remote_queue_lanes) {
+    if (opts.recv_block_size != 0) {
+      recv_buffer_pool_.set_block_size(opts.recv_block_size);
+    }
+    if (opts.hugepages) {
+      reserve_hugepages(opts.operations_per_class, opts.recv_blocks,
+                        {.prefault = opts.prefault});
+    } else {
+      operation_pool_.reserve(opts.operations_per_class, opts.prefault);
+      recv_buffer_pool_.reserve(opts.recv_blocks, opts.prefault);
+    }
+    reserve_descriptor_states(opts.expected_connections);
+  }
+
   // Destructor.
   ~epoll_context() {
     remove_timer_from_epoll();
@@ -164,6 +666,26 @@ class epoll_context final : public execution_context {
   // Execute all operations submitted to this context.
   void run();
 
+  // Execute operations until at least one has been executed or the context is
+  // requested to stop, blocking if nothing is ready. Returns the count of
+  // executed operations.
+  std::size_t run_one();
+
+  // Execute the operations which are ready without blocking. Returns the count
+  // of executed operations.
+  std::size_t poll();
+
+  // Execute operations until `deadline` or until the context is requested to
+  // stop. Returns the count of executed operations.
+  std::size_t run_until(const time_point& deadline);
+
+  // Execute operations for at most `duration`. Returns the count of executed
+  // operations.
+  template <typename Rep, typename Ratio>
+  std::size_t run_for(const std::chrono::duration<Rep, Ratio>& duration) {
+    return run_until(clock_() + duration);
+  }
+
   // Request to stop the context. Note that the context may block on the
   // epoll_wait call, so we must use interrupt to wake up the context.
   void request_stop() {
@@ -186,9 +708,487 @@ class epoll_context final : public execution_context {
     return is_running_.load(std::memory_order_relaxed);
   }
 
+  // The context run by the calling thread, or nullptr. If a thread runs
+  // contexts nested in each other, the innermost one. Each thread of a
+  // `reactor_pool` finds its own context this way.
+  static epoll_context* current() noexcept;
+
+  // Count work which a drain must wait for besides the operations parked on
+  // descriptors, e.g. a request handed over to another thread. Every
+  // `work_started` must be followed by one `work_finished`, from any thread.
+  void work_started() noexcept {
+    outstanding_work_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void work_finished() noexcept {
+    if (outstanding_work_.fetch_sub(1, std::memory_order_acq_rel) == 1 &&
+        draining_.load(std::memory_order_acquire)) {
+      interrupter_.interrupt();
+    }
+  }
+
+  // The count of unfinished work.
+  std::int64_t outstanding_work() const noexcept {
+    return outstanding_work_.load(std::memory_order_acquire);
+  }
+
+  // Whether an `async_drain` is in progress.
+  bool draining() const noexcept {
+    return draining_.load(std::memory_order_acquire);
+  }
+
   // CPO: get_scheduler.
   constexpr scheduler get_scheduler() noexcept;
 
+  // The priority of the operations scheduled by a scheduler.
+  enum class priority : std::uint8_t { high, normal, low };
+
+  // Get a scheduler whose `schedule` runs at priority `p`. Each iteration of
+  // the run loop executes the high priority operations first, then timer and
+  // I/O completions, then normal and at last low priority operations, e.g.
+  // heartbeats can be kept on time with `on(ctx.get_scheduler(high), ...)`
+  // while bulk transfers saturate the loop. Scheduling at high priority from
+  // another thread always interrupts the io thread.
+  constexpr scheduler get_scheduler(priority p) noexcept;
+
+  // Get an allocator backed by the operation pool of this context.
+  template <typename T = std::byte>
+  constexpr allocator<T> get_allocator() noexcept;
+
+  // The pool recycling operation states. Must only be used on the io thread.
+  const size_class_pool& operation_pool() const noexcept {
+    return operation_pool_;
+  }
+
+  // The pool of receive buffers claimed by `async_recv_pooled`. Blocks are
+  // acquired on the io thread, configure it before the first one.
+  buffer_pool& recv_buffer_pool() noexcept { return recv_buffer_pool_; }
+
+  // Create descriptor states until at least `count` exist, so that
+  // registering that many descriptors doesn't allocate. Not while the context
+  // runs on another thread.
+  void reserve_descriptor_states(std::size_t count) {
+    assert(is_running_on_io_thread() || !is_running());
+    descriptor_states_.reserve(count);
+    while (descriptor_states_.size() < count) {
+      descriptor_state* state =
+          descriptor_states_.emplace_back(new descriptor_state{}).get();
+      state->next_free_ = std::exchange(free_descriptor_states_, state);
+    }
+  }
+
+  // Back `operations_per_class` operation states of every size class and
+  // `recv_blocks` receive buffers with one hugepage arena, faulted in right
+  // away, so that busy contexts take fewer TLB misses and no page faults on
+  // those. Allocations beyond that come from the heap as usual. Call it once,
+  // before the context runs and after the block size of the receive buffer
+  // pool is set. Throws std::system_error if the arena can't be mapped.
+  void reserve_hugepages(std::size_t operations_per_class,
+                         std::size_t recv_blocks,
+                         hugepage_arena::options opts = {}) {
+    assert(!is_running() && arena_ == nullptr);
+    const std::size_t per_chunk = recv_buffer_pool_.blocks_per_chunk();
+    const std::size_t chunks = (recv_blocks + per_chunk - 1) / per_chunk;
+    arena_ = std::make_unique<hugepage_arena>(
+        size_class_pool::reserve_size(operations_per_class) +
+            chunks * recv_buffer_pool_.chunk_size(),
+        opts);
+    (void)operation_pool_.reserve(*arena_, operations_per_class);
+    recv_buffer_pool_.set_arena(arena_.get());
+    recv_buffer_pool_.reserve(recv_blocks);
+  }
+
+  // Get a scheduler whose `schedule` completes inline when it's started on
+  // the io thread, instead of taking a trip through the local queue. Use it
+  // to hop onto the io thread in loops which are usually already there, e.g.
+  // `on(ctx.get_inline_scheduler(), recv | send)`. Inline completion is
+  // bounded by `max_inline_depth`.
+  constexpr scheduler get_inline_scheduler() noexcept;
+
+  // The deepest nesting of operations which start and complete inline on the
+  // io thread. Deeper operations are enqueued to the local queue instead, so
+  // that chains of immediately ready operations can't overflow the stack.
+  static constexpr std::size_t max_inline_depth = 32;
+
+  // The time cached at the start of the current iteration of the run loop
+  // when called from the io thread, otherwise the current time.
+  time_point loop_now() const noexcept {
+    return is_running_on_io_thread() ? loop_time_ : clock_();
+  }
+
+  // The function this context reads the current time with.
+  using clock_function = time_point (*)() noexcept;
+
+  // Read the time with `clock` instead of `monotonic_clock::now`, e.g.
+  // `&fast_monotonic_clock::now`. The clock must return time points of
+  // CLOCK_MONOTONIC, since timers are armed against it. Must be called when
+  // the context is not running.
+  void set_clock(clock_function clock) noexcept {
+    assert(!is_running());
+    assert(clock != nullptr);
+    clock_ = clock;
+  }
+
+  // Get the current time with the clock of this context.
+  time_point now() const noexcept { return clock_(); }
+
+  // The function executing an operation, see `operation_base::execute_`.
+  using execute_function = void (*)(operation_base*) noexcept;
+
+  // What the run loop is doing, see `read_heartbeat`.
+  struct heartbeat {
+    // Whether the io thread is executing an iteration rather than waiting
+    // for events, and since when.
+    bool busy = false;
+    time_point busy_since{};
+
+    // The operation being executed from the local queues, or nullptr.
+    execute_function current = nullptr;
+
+    // How long the last finished iteration ran before waiting for events,
+    // i.e. the loop lag an event arriving then would have seen.
+    std::chrono::nanoseconds last_iteration{};
+  };
+
+  // Publish the heartbeat of the run loop, e.g. for `loop_watchdog` on
+  // another thread or for `admission_control`. It costs a clock read and a
+  // few relaxed stores per iteration, and one store per operation. Must be
+  // called from the io thread or when the context is not running.
+  void set_heartbeat_enabled(bool enabled) noexcept {
+    assert(is_running_on_io_thread() || !is_running());
+    heartbeat_enabled_ = enabled;
+  }
+
+  // Whether the heartbeat is published.
+  bool heartbeat_enabled() const noexcept { return heartbeat_enabled_; }
+
+  // Read the heartbeat of the run loop. Can be called from any thread, it
+  // stays idle unless `set_heartbeat_enabled(true)`.
+  heartbeat read_heartbeat() const noexcept {
+    const std::int64_t since = busy_since_.load(std::memory_order_relaxed);
+    return {.busy = since != 0,
+            .busy_since = time_point::from_seconds_and_nanoseconds(
+                since / 1'000'000'000, since % 1'000'000'000),
+            .current = current_execute_.load(std::memory_order_relaxed),
+            .last_iteration = std::chrono::nanoseconds{
+                last_iteration_.load(std::memory_order_relaxed)}};
+  }
+
+  // The count of descriptors currently registered to this context, a rough
+  // measure of how loaded the context is. Can be called from any thread.
+  std::size_t descriptor_count() const noexcept {
+    return descriptor_count_.load(std::memory_order_relaxed);
+  }
+
+  // Bound the operations executed by each iteration of the run loop to
+  // `max_ops` and, unless zero, to about `max_time`. The rest stays queued
+  // until epoll and the timers have been polled again. Timer and I/O
+  // completions run before the continuations of `schedule()`, so a flood of
+  // the latter can't starve them. Unbounded by default. Must be called when
+  // the context is not running.
+  void set_local_budget(
+      std::size_t max_ops,
+      std::chrono::nanoseconds max_time = std::chrono::nanoseconds::zero()) {
+    assert(!is_running());
+    local_budget_ops_ = std::max<std::size_t>(max_ops, 1);
+    local_budget_time_ = max_time;
+  }
+
+  // Spin on a non-blocking epoll_wait and the remote queue for up to `budget`
+  // before blocking when there is nothing to execute. This trades cpu for the
+  // latency of waking up a sleeping thread. Zero, the default, disables
+  // spinning. Must be called when the context is not running.
+  void set_spin_budget(std::chrono::microseconds budget) noexcept {
+    assert(!is_running());
+    spin_budget_ = budget;
+  }
+
+  // Bound the reads started on one socket by each iteration of the run loop
+  // to `max_reads`, later ones wait for the next iteration, so a socket
+  // whose data keeps a receive loop completing inline can't starve the
+  // others. Reads are tried before waiting for epoll anyway, so a socket
+  // with data left after a short buffer is read again right away. Zero, the
+  // default, means unbounded. Must be called when the context is not
+  // running.
+  void set_read_budget(std::uint32_t max_reads) noexcept {
+    assert(!is_running());
+    read_budget_ = max_reads;
+  }
+
+  // Execute the operations woken up by epoll right from the pass over the
+  // events, while their descriptor states are still in cache, instead of
+  // queueing them to the local queue first. They run before the operations
+  // of every priority and are not bounded by `set_local_budget`. Disabled by
+  // default. Must be called when the context is not running.
+  void set_inline_io_completions(bool enabled) noexcept {
+    assert(!is_running());
+    inline_io_completions_ = enabled;
+  }
+
+  // Set SO_BUSY_POLL to `duration` on every socket registered to this context
+  // afterwards, so that receives busy poll the device queue as well. Zero, the
+  // default, leaves the sockets untouched. Raising the value above the system
+  // default needs CAP_NET_ADMIN, failures are ignored. Must be called when the
+  // context is not running.
+  void set_socket_busy_poll(std::chrono::microseconds duration) noexcept {
+    assert(!is_running());
+    socket_busy_poll_ = duration;
+  }
+
+  // Statistics of operations submitted by remote threads. Can be read from any
+  // thread while the context is running.
+  struct remote_queue_stats {
+    // The count of operations collected from the remote queue.
+    std::uint64_t item_count = 0;
+
+    // The count of times remote threads signaled the interrupter, including
+    // for high priority operations and stops.
+    std::uint64_t interrupt_count = 0;
+
+    // The count of operations passed to schedule_remote and enqueued without
+    // signaling the interrupter, because the I/O thread was known to be awake.
+    std::uint64_t saved_interrupt_count = 0;
+  };
+
+  // Get the statistics of the remote queue.
+  remote_queue_stats remote_queue_statistics() const noexcept {
+    constexpr auto relaxed = std::memory_order_relaxed;
+    return {
+        .item_count = remote_item_count_.load(relaxed),
+        .interrupt_count = remote_interrupt_count_.load(relaxed),
+        .saved_interrupt_count = remote_saved_interrupt_count_.load(relaxed)};
+  }
+
+  // How the context wakes up for the earliest timer.
+  enum class timer_mode {
+    // Arm a timerfd. Precise on every kernel, but each expiry costs a
+    // timerfd_settime, a wakeup by the timerfd and a read of it.
+    timerfd,
+
+    // Bound the epoll_wait timeout by the earliest timer instead, without any
+    // extra syscall. Uses epoll_pwait2 for nanosecond precision when the
+    // kernel supports it (5.11), otherwise timers are rounded up to the next
+    // millisecond.
+    wait_timeout
+  };
+
+  // Select how the context wakes up for timers. Must be called when the
+  // context is not running.
+  void set_timer_mode(timer_mode mode) noexcept {
+    assert(!is_running());
+    timer_mode_ = mode;
+  }
+
+  // Let the timerfd fire up to `slack` late. Deadlines are rounded up to a
+  // multiple of `slack`, so that close timers share one wakeup and the timerfd
+  // is not re-armed for a new earliest deadline in the window of the armed
+  // one. Zero, the default, keeps timers precise. Must be called when the
+  // context is not running.
+  void set_timer_slack(std::chrono::nanoseconds slack) noexcept {
+    assert(!is_running());
+    timer_slack_ = slack;
+  }
+
+  // Statistics of the timerfd. Can be read from any thread while the context
+  // is running.
+  struct timer_stats {
+    // The count of timerfd_settime calls.
+    std::uint64_t rearm_count = 0;
+  };
+
+  // Get the statistics of the timerfd.
+  timer_stats timer_statistics() const noexcept {
+    return {.rearm_count = timer_rearm_count_.load(std::memory_order_relaxed)};
+  }
+
+  // Whether the counters of `stats` are kept. Define NET_EPOLL_DISABLE_STATS
+  // to compile them out, `stats` then reports zeros for them.
+#if defined(NET_EPOLL_DISABLE_STATS)
+  static constexpr bool stats_enabled = false;
+#else
+  static constexpr bool stats_enabled = true;
+#endif
+
+  // The runtime statistics of the context. Can be read from any thread while
+  // the context is running.
+  struct statistics {
+    // The count of iterations of the run loop.
+    std::uint64_t loop_iterations = 0;
+
+    // The count of epoll_wait calls and of the events they returned, their
+    // ratio is the average count of events per call.
+    std::uint64_t wait_calls = 0;
+    std::uint64_t events = 0;
+
+    // The count of operations executed from the local queue.
+    std::uint64_t local_ops = 0;
+
+    // The count of operations collected from the remote queue.
+    std::uint64_t remote_ops = 0;
+
+    // The count of times remote threads signaled the eventfd.
+    std::uint64_t interrupts = 0;
+
+    // The count of timers inserted, removed before they elapsed, and elapsed.
+    std::uint64_t timer_inserts = 0;
+    std::uint64_t timer_removes = 0;
+    std::uint64_t timer_fires = 0;
+
+    // The count of timerfd_settime calls.
+    std::uint64_t timer_rearms = 0;
+
+    // The count of epoll_ctl calls registering and removing sockets.
+    std::uint64_t epoll_ctl_calls = 0;
+
+    // The count of socket operations which would block and had to wait for
+    // the descriptor to become ready again.
+    std::uint64_t would_block = 0;
+
+    // The count of operations the io thread itself sent through the remote
+    // queue, because it wasn't recognized as the io thread. Should be zero.
+    std::uint64_t io_thread_remote_ops = 0;
+
+    // The count of stop requests of socket operations delivered by other
+    // threads, not included in `remote_ops`.
+    std::uint64_t remote_stops = 0;
+  };
+
+  // Get a snapshot of the statistics. The counters are read one by one, so
+  // they may be slightly apart from each other.
+  statistics stats() const noexcept {
+    constexpr auto relaxed = std::memory_order_relaxed;
+    return {.loop_iterations = counters_.loop_iterations_.load(),
+            .wait_calls = wait_count_.load(relaxed),
+            .events = event_count_.load(relaxed),
+            .local_ops = counters_.local_ops_.load(),
+            .remote_ops = remote_item_count_.load(relaxed),
+            .interrupts = remote_interrupt_count_.load(relaxed),
+            .timer_inserts = counters_.timer_inserts_.load(),
+            .timer_removes = counters_.timer_removes_.load(),
+            .timer_fires = counters_.timer_fires_.load(),
+            .timer_rearms = timer_rearm_count_.load(relaxed),
+            .epoll_ctl_calls = counters_.epoll_ctl_calls_.load(),
+            .would_block = counters_.would_block_.load(),
+            .io_thread_remote_ops = counters_.io_thread_remote_ops_.load(),
+            .remote_stops = counters_.remote_stops_.load()};
+  }
+
+  // Whether the latencies of socket operations are recorded. Define
+  // NET_EPOLL_LATENCY_HISTOGRAMS to compile the recording in. It costs two
+  // clock reads per operation, and the histograms take about 50KB per
+  // context.
+#if defined(NET_EPOLL_LATENCY_HISTOGRAMS)
+  static constexpr bool latency_enabled = true;
+#else
+  static constexpr bool latency_enabled = false;
+#endif
+
+  // The kinds of socket operations whose latencies are recorded.
+  enum class op_kind : std::uint8_t { recv, send, connect, accept };
+  static constexpr std::size_t op_kind_count = 4;
+
+  // The latency histograms of one kind of operation. Only recorded by the
+  // I/O thread, and can be read from any thread.
+  struct latency_stats {
+    // From `start` to the completion of the operation.
+    latency_histogram total;
+
+    // From parking on the descriptor until epoll reports it ready.
+    latency_histogram parked;
+
+    // From epoll reporting the descriptor ready until the completion.
+    latency_histogram ready_to_complete;
+  };
+
+  // Get the latency histograms of `kind`, which stay empty unless
+  // `latency_enabled`. Use `latency_histogram::merge` to combine those of
+  // several contexts.
+  const latency_stats& latency(op_kind kind) const noexcept {
+    static const latency_stats none{};
+    return latency_ ? (*latency_)[static_cast<std::size_t>(kind)] : none;
+  }
+
+  // Whether the run loop times its phases. Define NET_EPOLL_PHASE_PROFILER to
+  // compile the profiler in, it reads the time stamp counter six times per
+  // iteration.
+#if defined(NET_EPOLL_PHASE_PROFILER)
+  static constexpr bool phase_profiler_enabled = true;
+#else
+  static constexpr bool phase_profiler_enabled = false;
+#endif
+
+  using phase_profiler = loop_profiler<phase_profiler_enabled>;
+
+  // Get the phase profiler of the run loop. Its histograms and totals stay
+  // empty unless `phase_profiler_enabled`.
+  const phase_profiler& profiler() const noexcept { return profiler_; }
+
+  // Keep the last `capacity` phases of the run loop in a trace, see
+  // `loop_profiler::trace`. Must be called when the context is not running.
+  void set_phase_trace_capacity(std::size_t capacity) {
+    assert(!is_running());
+    profiler_.set_trace_capacity(capacity);
+  }
+
+  // Record the last `capacity` events of the run loop in a flight recorder,
+  // zero turns it off. Must be called when the context is not running.
+  void enable_flight_recorder(std::size_t capacity) {
+    assert(!is_running());
+    flight_recorder_ =
+        capacity != 0 ? std::make_unique<flight_recorder>(capacity) : nullptr;
+  }
+
+  // Get the flight recorder, null unless enabled. It can be read from any
+  // thread, see `flight_recorder::snapshot` and `flight_recorder::dump`.
+  const flight_recorder* recorder() const noexcept {
+    return flight_recorder_.get();
+  }
+
+  // Get the statistics of epoll_wait batches.
+  event_batch_stats event_batch_statistics() const noexcept {
+    constexpr auto relaxed = std::memory_order_relaxed;
+    return {.wait_count = wait_count_.load(relaxed),
+            .event_count = event_count_.load(relaxed),
+            .full_batch_count = full_batch_count_.load(relaxed),
+            .last_batch_fill = last_batch_fill_.load(relaxed),
+            .batch_size = event_batch_size_.load(relaxed)};
+  }
+
+  // Add a task to the run loop. Must be called from the io thread or when the
+  // context is not running.
+  void add_loop_task(loop_task* task) noexcept {
+    assert(is_running_on_io_thread() || !is_running());
+    assert(task->execute_ != nullptr);
+    loop_tasks_.push_back(task);
+  }
+
+  // Remove a task from the run loop. A task being executed may only remove
+  // itself. Must be called from the io thread or when the context is not
+  // running.
+  void remove_loop_task(loop_task* task) noexcept {
+    assert(is_running_on_io_thread() || !is_running());
+    loop_tasks_.remove(task);
+  }
+
+  // Cancel the operations parked on the descriptor of `descriptor_data` in
+  // one pass. They complete as stopped without going through their stop
+  // callbacks, and operations which would wait on the descriptor later fail
+  // the same way until it's closed. Nothing is parked on a descriptor which
+  // has not been waited on yet. Must be called from the io thread or when the
+  // context is not running. See `cancellation_group`.
+  void cancel_descriptor(void* descriptor_data) noexcept {
+    assert(is_running_on_io_thread() || !is_running());
+    if (descriptor_data != nullptr) {
+      cancel_descriptor_state(static_cast<descriptor_state*>(descriptor_data));
+    }
+  }
+
+  // Release the descriptor state attached to a socket which is going to be
+  // closed. Operations still parked on the descriptor are woken up in one
+  // pass and complete as stopped, without touching the descriptor again.
+  void deregister_descriptor(int descriptor,
+                             void*& descriptor_data) noexcept override;
+
  private:
   // The thread that calls `context.run()` is called io thread, and other
   // threads are remote threads. This function checks which thread is using the
@@ -201,9 +1201,115 @@ class epoll_context final : public execution_context {
   // remote queue.
   void schedule_impl(operation_base* op) noexcept;
 
+  // Like `schedule_impl`, but the io thread queues `op` behind timer and I/O
+  // completions. Used by `schedule()`, whose continuations are the least
+  // urgent work.
+  void schedule_continuation(operation_base* op) noexcept;
+
+  // Schedule `op` to the queue of priority `p`. Remote operations of low
+  // priority are queued with the normal ones, see `schedule_op`.
+  void schedule_with_priority(operation_base* op, priority p) noexcept;
+
+  // Whether any of the local queues has an operation to execute.
+  bool has_local_work() const noexcept {
+    return !high_queue_.empty() || !local_queue_.empty() ||
+           !continuation_queue_.empty() || !low_queue_.empty();
+  }
+
   // Schedule the operation to the local queue.
   void schedule_local(operation_base* op) noexcept;
 
+  // Deliver the stop request `op` of a socket operation. Other threads queue
+  // it on the stop queue, which the I/O thread collects in one batch per
+  // iteration ahead of the remote queue, so that a burst of cancellations
+  // costs one wakeup and the operations are unparked before they're
+  // performed again. The I/O thread queues it at high priority directly.
+  void schedule_stop(operation_base* op) noexcept;
+
+  // Whether a read on `descriptor_data` must wait for the next iteration of
+  // the run loop, see `set_read_budget`. Counts the read otherwise.
+  bool read_budget_exhausted(void* descriptor_data) noexcept {
+    if (read_budget_ == 0 || descriptor_data == nullptr) {
+      return false;
+    }
+    auto& state = *static_cast<descriptor_state*>(descriptor_data);
+    if (state.read_iteration_ != loop_iteration_) {
+      state.read_iteration_ = loop_iteration_;
+      state.reads_ = 0;
+    }
+    return ++state.reads_ > read_budget_;
+  }
+
+  // Run the operation in the next iteration of the run loop.
+  void defer_to_next_iteration(operation_base* op) noexcept {
+    assert(!op->enqueued_);
+    op->enqueued_.store(true, std::memory_order_relaxed);
+    deferred_queue_.push_back(op);
+  }
+
+  // Allocate and free memory for operation states, see `allocator`.
+  void* allocate_operation(std::size_t size) {
+    return is_running_on_io_thread()
+               ? operation_pool_.allocate(size)
+               : size_class_pool::allocate_block(size);
+  }
+
+  void deallocate_operation(void* p, std::size_t size) noexcept {
+    if (is_running_on_io_thread()) {
+      operation_pool_.deallocate(p, size);
+    } else if (operation_pool_.owns(p)) {
+      // Blocks of the arena can only go back to the pool, on the io thread.
+      auto* freed = ::new (p) freed_operation{nullptr, size};
+      freed->next = remote_freed_operations_.load(std::memory_order_relaxed);
+      while (!remote_freed_operations_.compare_exchange_weak(
+          freed->next, freed, std::memory_order_release,
+          std::memory_order_relaxed)) {
+      }
+    } else {
+      ::operator delete(p);
+    }
+  }
+
+  // An operation state of the arena freed by another thread.
+  struct freed_operation {
+    freed_operation* next;
+    std::size_t size;
+  };
+
+  // Give the operation states freed by other threads back to the pool.
+  void reclaim_remote_operations() noexcept {
+    freed_operation* op = remote_freed_operations_.exchange(
+        nullptr, std::memory_order_acquire);
+    while (op != nullptr) {
+      freed_operation* next = op->next;
+      operation_pool_.deallocate(op, op->size);
+      op = next;
+    }
+  }
+
+  // Whether an operation started by the current thread can be executed
+  // inline right now.
+  bool can_run_inline() const noexcept {
+    return is_running_on_io_thread() && inline_depth_ < max_inline_depth;
+  }
+
+  // Counts an operation executed inline for as long as it's alive.
+  class inline_scope {
+   public:
+    explicit inline_scope(epoll_context& context) noexcept
+        : context_(context) {
+      ++context_.inline_depth_;
+    }
+
+    inline_scope(const inline_scope&) = delete;
+    inline_scope& operator=(const inline_scope&) = delete;
+
+    ~inline_scope() { --context_.inline_depth_; }
+
+   private:
+    epoll_context& context_;
+  };
+
   // Move all contents from remote queue to local queue.
   void schedule_local(operation_queue ops) noexcept;
 
@@ -218,34 +1324,177 @@ class epoll_context final : public execution_context {
   // Won't run other items that were enqueued during the execution of the items
   // that were already enqueued. This bounds the amount of work to a finite
   // amount.
-  size_t execute_local() noexcept;
+  // At most `max_count` items are executed, the others are left on the queue.
+  // The queues run from the high priority one to the low priority one, all
+  // within the budget set by `set_local_budget`.
+  size_t execute_local(
+      size_t max_count = std::numeric_limits<size_t>::max()) noexcept;
+
+  // Execute up to `max_count` items of `queue`, stopping early once
+  // `deadline` has passed. Leftovers stay on `queue` in order.
+  size_t execute_queue(operation_queue& queue, size_t max_count,
+                       const std::optional<time_point>& deadline) noexcept;
 
   // Check if any completion queue items are available and if so add them to the
-  // local queue.
-  void acquire_completion_queue_items();
+  // local queue. Blocks for at most `timeout` milliseconds if there is nothing
+  // to execute, -1 means forever.
+  void acquire_completion_queue_items(int timeout = -1);
+
+  // The loop shared by all run functions. Executes at most `max_count`
+  // operations. If `deadline` is given, the loop makes a last non-blocking
+  // pass once the deadline is reached and returns.
+  std::size_t run_loop(std::optional<time_point> deadline,
+                       std::size_t max_count);
 
   // Collect the contents of the remote queue and pass them to local queue.
-  // The return value represents whether the remote queue is empty before we
-  // make a collection. Returns true means remote queue is emtpy before we
-  // collect.
+  // The queue is kept active, so remote threads don't signal the interrupter
+  // while the I/O thread is awake. Returns true means remote queue is emtpy
+  // before we collect.
   bool try_schedule_remote_to_local() noexcept;
 
+  // Move the stop requests queued by other threads to the high priority
+  // queue. Returns false if there were any.
+  bool try_collect_stops() noexcept;
+
+  // Mark the remote queue inactive right before blocking in epoll_wait, so the
+  // next remote thread enqueueing an item wakes us up. Returns false if some
+  // items arrived in the meantime, they are moved to the local queue and the
+  // caller must not block.
+  bool try_mark_remote_queue_inactive() noexcept;
+
+  // The times an operation measures its latencies from, empty unless
+  // `latency_enabled`.
+  struct latency_stamps {
+    // When the operation was started.
+    time_point started_;
+
+    // When the operation parked, then when it was woken up.
+    time_point ready_;
+    bool woken_ = false;
+  };
+
+  struct no_latency_stamps {};
+
+  using op_stamps = std::conditional_t<latency_enabled, latency_stamps,
+                                       no_latency_stamps>;
+
+  // The histograms operations of `kind` record into. Must only be used from
+  // the I/O thread.
+  latency_stats& latency_of(op_kind kind) noexcept {
+    return (*latency_)[static_cast<std::size_t>(kind)];
+  }
+
+  // Record `event` if the flight recorder is enabled. Must only be called
+  // from the I/O thread.
+  void record_flight(flight_event event, std::int32_t arg,
+                     std::uint8_t kind = 0) noexcept {
+    if (flight_recorder_) [[unlikely]] {
+      flight_recorder_->record(event, arg, kind);
+    }
+  }
+
+  // Count the items collected from the remote queue.
+  void add_remote_items(const operation_queue& items) noexcept;
+
+  // Record the fill of the last epoll_wait batch and resize the next batch in
+  // adaptive mode. Must be called from the I/O thread.
+  void update_event_batch(std::size_t fill) noexcept;
+
+  // Call epoll_wait, throws an error when it fails. In `wait_timeout` mode a
+  // blocking wait is also bounded by the earliest timer.
+  int wait_events(int timeout);
+
+  // Wait for at most `timeout`, with nanosecond precision if possible.
+  int wait_events(std::chrono::nanoseconds timeout);
+
+  // Poll for events without blocking until some events arrive, the remote
+  // queue becomes non-empty or the spin budget runs out. Returns the count of
+  // events, or -1 if the budget ran out and the caller should block.
+  int spin_wait_events();
+
   // Signal the remote queue eventfd.
   // This should only be called after trying to enqueue() work to the remote
   // queue and being told that the I/O thread is inactive.
   void interrupt() { interrupter_.interrupt(); }
 
+  // Refresh the cached loop time. Must be called from the I/O thread.
+  void update_loop_time() noexcept { loop_time_ = clock_(); }
+
+  // Publish the start of an iteration of the run loop, see `heartbeat`.
+  void mark_busy() noexcept {
+    if (heartbeat_enabled_) {
+      busy_since_.store(
+          loop_time_.seconds() * 1'000'000'000 + loop_time_.nanoseconds(),
+          std::memory_order_relaxed);
+    }
+  }
+
+  // Publish that the run loop waits for events or has left.
+  void mark_idle() noexcept {
+    if (heartbeat_enabled_) {
+      const auto busy = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          clock_() - loop_time_);
+      last_iteration_.store(busy.count(), std::memory_order_relaxed);
+      current_execute_.store(nullptr, std::memory_order_relaxed);
+      busy_since_.store(0, std::memory_order_relaxed);
+    }
+  }
+
   // Remove timer from time heap.
   void remove_timer(schedule_at_base_op* op) noexcept;
 
+  // Reposition a heap timer whose due time has been lowered in place. Must be
+  // called from the I/O thread.
+  void advance_timer(schedule_at_base_op* op) noexcept;
+
   // Update timers.
   void update_timers() noexcept;
 
+  // Execute the due loop tasks. Returns the earliest due time of the
+  // remaining ones.
+  std::optional<time_point> run_loop_tasks() noexcept;
+
+  // Round `due_time` up to a multiple of the timer slack.
+  time_point apply_timer_slack(const time_point& due_time) const noexcept;
+
   // `due_time` indicates the absolute time since system startup. This timer
   // will only alarm once. If both due_time.seconds() and due_time.nanoseconds()
   // are zero, this timer would't alarm.
   void set_timer(const time_point& due_time);
 
+  // Get the descriptor state attached to `descriptor_data`. The descriptor is
+  // registered to epoll the first time this is called for a socket, with
+  // EPOLLEXCLUSIVE and only for readability if `exclusive` is true. Returns
+  // nullptr and assigns `ec` if the registration fails. Must be called from the
+  // I/O thread.
+  descriptor_state* register_descriptor(int descriptor, void*& descriptor_data,
+                                        system_error2::system_code& ec,
+                                        bool exclusive = false);
+
+  // Wake up all operations parked on the state and recycle it. Must be called
+  // from the I/O thread or when the context is not running.
+  void release_descriptor_state(descriptor_state* state) noexcept;
+
+  // Release all descriptor states handed over by remote threads.
+  void release_remote_descriptor_states() noexcept;
+
+  // Whether the operations woken up on a descriptor must complete as
+  // canceled, because the socket was closed or the context is draining.
+  static bool descriptor_canceled(void* descriptor_data) noexcept {
+    return descriptor_data == nullptr ||
+           static_cast<descriptor_state*>(descriptor_data)->canceled_;
+  }
+
+  // Mark the state canceled and wake up the operations parked on it.
+  void cancel_descriptor_state(descriptor_state* state) noexcept;
+
+  // Start draining, or join the drain in progress. Listening sockets are
+  // canceled right away, the rest when the earliest deadline passes.
+  void begin_drain(drain_base* op) noexcept;
+
+  // Complete the drain if no work is left. Returns whether it completed.
+  bool try_finish_drain() noexcept;
+
   // Used to specific the epoll_event to be a timer data
   constexpr void* timers_data() const {
     return const_cast<void*>(static_cast<const void*>(&timers_));
@@ -287,30 +1536,204 @@ class epoll_context final : public execution_context {
   // Set of operations waiting to be executed at a specific time.
   timer_heap timers_;
 
+  // Set of coarse timer operations.
+  timer_wheel coarse_timers_;
+
   // The absolute time that the current active timer submitted to the kernel.
   std::optional<time_point> current_earliest_due_time_;
 
-  // Whether the operation submitted by the remote thread has been processed.
-  bool processed_remote_queue_submitted_;
-
   // Indicates whether we should update timers.
   bool timers_are_dirty_;
 
   // Local queue for operations that are ready to execute.
   operation_queue local_queue_;
 
+  // Continuations of `schedule()` started by the io thread, executed after
+  // the local queue.
+  operation_queue continuation_queue_;
+
+  // Operations scheduled at high priority, executed before the local queue,
+  // and at low priority, executed after the continuations.
+  operation_queue high_queue_;
+  operation_queue low_queue_;
+
+  // Operations scheduled at high priority by remote threads. It's never
+  // marked inactive, the producers always interrupt the io thread instead.
+  atomic_intrusive_queue<&operation_base::next_> high_remote_queue_;
+
+  // The most operations, and the longest time if not zero, executed by each
+  // iteration of the run loop.
+  std::size_t local_budget_ops_;
+  std::chrono::nanoseconds local_budget_time_;
+
   // Queue of operations enqueued by remote threads.
   // exec::__atomic_intrusive_queue<&operation_base::next_> remote_queue_;
   atomic_intrusive_queue<&operation_base::next_> remote_queue_;
 
-  // The count of unfinished work.
+  // The lanes used instead of `remote_queue_` if the context was constructed
+  // with more than one remote queue lane.
+  using remote_lanes = sharded_intrusive_queue<&operation_base::next_>;
+  std::unique_ptr<remote_lanes> remote_lanes_;
+
+  // The stop requests of socket operations made by other threads, see
+  // `schedule_stop`. Marked inactive together with the remote queue.
+  atomic_intrusive_queue<&operation_base::next_> stop_queue_;
+
+  // The count of unfinished work, see `work_started`.
   std::atomic<int64_t> outstanding_work_;
 
+  // Whether a drain is in progress.
+  std::atomic_bool draining_;
+
+  // The operations waiting for the drain. Only touched by the I/O thread.
+  drain_base* drain_waiters_;
+
+  // Cancels the remaining work at the drain deadline.
+  struct drain_deadline_task : loop_task {
+    epoll_context* context_ = nullptr;
+    bool armed_ = false;
+  };
+  drain_deadline_task drain_deadline_;
+
   // The stop source.
   std::optional<stdexec::in_place_stop_source> stop_source_;
 
   // Whether this context is running.
   std::atomic_bool is_running_;
+
+  // The thread running this context, if any.
+  std::atomic<std::thread::id> io_thread_id_;
+
+  // Storage of all descriptor states ever created by this context.
+  std::vector<std::unique_ptr<descriptor_state>> descriptor_states_;
+
+  // Descriptor states available for reuse.
+  descriptor_state* free_descriptor_states_;
+
+  // The count of registered descriptors.
+  std::atomic<std::size_t> descriptor_count_;
+
+  // Descriptor states of sockets closed by remote threads, waiting for the I/O
+  // thread to release them.
+  std::atomic<descriptor_state*> remote_released_descriptor_states_;
+
+  // The buffer of events returned by epoll_wait, sized to the largest batch.
+  std::vector<epoll_event> events_;
+
+  // Whether the batch size adapts to the load.
+  bool adaptive_event_batch_;
+
+  // Statistics of epoll_wait batches. Only written by the I/O thread.
+  std::atomic<std::size_t> event_batch_size_;
+  std::atomic<std::uint64_t> wait_count_;
+  std::atomic<std::uint64_t> event_count_;
+  std::atomic<std::uint64_t> full_batch_count_;
+  std::atomic<std::size_t> last_batch_fill_;
+
+  // How long to spin before blocking in epoll_wait.
+  std::chrono::microseconds spin_budget_;
+
+  // The SO_BUSY_POLL value applied to registered sockets.
+  std::chrono::microseconds socket_busy_poll_;
+
+  // The count of items collected from the remote queue by the I/O thread.
+  std::atomic<std::uint64_t> remote_item_count_;
+
+  // The count of interrupts signaled by remote threads.
+  std::atomic<std::uint64_t> remote_interrupt_count_;
+
+  // The count of schedule_remote calls which didn't need to interrupt.
+  std::atomic<std::uint64_t> remote_saved_interrupt_count_;
+
+  // The nesting of operations currently executed inline. Only touched by the
+  // I/O thread.
+  std::size_t inline_depth_;
+
+  // The reads started on one socket per iteration, zero if unbounded.
+  std::uint32_t read_budget_;
+
+  // Whether operations woken up by epoll are executed by the dispatch pass.
+  // A state released and reused by one of them within the pass may see a
+  // stale event, a spurious wakeup the operations already tolerate.
+  bool inline_io_completions_;
+
+  // The count of iterations of the run loop. Only touched by the I/O thread.
+  std::uint64_t loop_iteration_;
+
+  // Operations put off until the next iteration of the run loop.
+  operation_queue deferred_queue_;
+
+  // How the context wakes up for timers.
+  timer_mode timer_mode_;
+
+  // Cleared the first time epoll_pwait2 is found missing.
+  bool has_epoll_pwait2_;
+
+  // How late timers may fire to save timerfd re-arms.
+  std::chrono::nanoseconds timer_slack_;
+
+  // The count of timerfd_settime calls. Only written by the I/O thread.
+  std::atomic<std::uint64_t> timer_rearm_count_;
+
+  // The counters of `stats` which can be compiled out. Only written by the
+  // I/O thread, except for `epoll_ctl_calls_`.
+  struct stat_counters {
+    stat_counter<stats_enabled> loop_iterations_;
+    stat_counter<stats_enabled> local_ops_;
+    stat_counter<stats_enabled> timer_inserts_;
+    stat_counter<stats_enabled> timer_removes_;
+    stat_counter<stats_enabled> timer_fires_;
+    stat_counter<stats_enabled> epoll_ctl_calls_;
+    stat_counter<stats_enabled> would_block_;
+    stat_counter<stats_enabled> io_thread_remote_ops_;
+    stat_counter<stats_enabled> remote_stops_;
+  };
+  stat_counters counters_;
+
+  // Times the phases of the run loop. Only marked by the I/O thread.
+  phase_profiler profiler_;
+
+  // The function reading the current time.
+  clock_function clock_;
+
+  // The hugepage arena of the pools below, see `reserve_hugepages`. Declared
+  // first so that it's unmapped last.
+  std::unique_ptr<hugepage_arena> arena_;
+
+  // Recycled memory of operation states. Only touched by the I/O thread.
+  size_class_pool operation_pool_;
+
+  // Operation states of the arena freed by other threads.
+  std::atomic<freed_operation*> remote_freed_operations_;
+
+  // Receive buffers shared by the pooled receive operations.
+  buffer_pool recv_buffer_pool_;
+
+  // Tasks polled once per iteration of the run loop.
+  intrusive_list<loop_task, &loop_task::next_, &loop_task::prev_> loop_tasks_;
+
+  // The recycling cache of `recycling_allocator`, installed as the current one
+  // of the I/O thread while the context runs.
+  thread_info_base thread_info_;
+
+  // The time cached once per iteration of the run loop. Only touched by the
+  // I/O thread.
+  time_point loop_time_;
+
+  // The heartbeat of the run loop, only published if `heartbeat_enabled_`.
+  // The start of the iteration is kept in nanoseconds, zero while idle.
+  bool heartbeat_enabled_;
+  std::atomic<std::int64_t> busy_since_;
+  std::atomic<execute_function> current_execute_;
+  std::atomic<std::int64_t> last_iteration_;
+
+  // The latency histograms by operation kind, only allocated if
+  // `latency_enabled`.
+  std::unique_ptr<std::array<latency_stats, op_kind_count>> latency_;
+
+  // The recent events of the run loop, null unless enabled. Only recorded by
+  // the I/O thread.
+  std::unique_ptr<flight_recorder> flight_recorder_;
 };
 
 // The scheduler with returned by `stdexec::get_schedule` customization point
@@ -339,13 +1762,21 @@ class epoll_context::scheduler {
     friend auto tag_invoke(
         stdexec::get_completion_scheduler_t<stdexec::set_value_t>,
         const schedule_env& env) noexcept -> scheduler {
-      return scheduler{env.context};
+      return scheduler{env.context, env.is_inline, env.prio};
     }
 
-    explicit constexpr schedule_env(epoll_context& ctx) noexcept
-        : context(ctx) {}
+    explicit constexpr schedule_env(
+        epoll_context& ctx, bool inline_schedule = false,
+        epoll_context::priority p = epoll_context::priority::normal) noexcept
+        : context(ctx), is_inline(inline_schedule), prio(p) {}
 
     epoll_context& context;
+
+    // Whether `schedule` may complete inline.
+    bool is_inline;
+
+    // The priority `schedule` runs at.
+    epoll_context::priority prio;
   };  // schedule_env
 
   template <typename ReceiverId>
@@ -358,8 +1789,12 @@ class epoll_context::scheduler {
       using stop_token =
           stdexec::stop_token_of_t<stdexec::env_of_t<receiver_t>&>;
 
-      constexpr __t(epoll_context& context, receiver_t r)
-          : context_(context), receiver_(static_cast<receiver_t&&>(r)) {
+      constexpr __t(epoll_context& context, bool inline_schedule,
+                    epoll_context::priority p, receiver_t r)
+          : context_(context),
+            inline_(inline_schedule),
+            priority_(p),
+            receiver_(static_cast<receiver_t&&>(r)) {
         execute_ = &execute_impl;
       }
 
@@ -368,7 +1803,26 @@ class epoll_context::scheduler {
       }
 
      private:
-      constexpr void start_impl() noexcept { context_.schedule_impl(this); }
+      constexpr void start_impl() noexcept {
+        if (inline_ && context_.can_run_inline()) {
+          epoll_context::inline_scope scope{context_};
+          execute_impl(this);
+          return;
+        }
+        if (priority_ == epoll_context::priority::low &&
+            !context_.is_running_on_io_thread()) {
+          // Remote items are collected into the local queue, move on to the
+          // low priority queue from there.
+          execute_ = &requeue_low;
+        }
+        context_.schedule_with_priority(this, priority_);
+      }
+
+      static constexpr void requeue_low(operation_base* p) noexcept {
+        auto& self = *static_cast<__t*>(p);
+        self.execute_ = &execute_impl;
+        self.context_.schedule_with_priority(p, epoll_context::priority::low);
+      }
 
       static constexpr void execute_impl(operation_base* p) noexcept {
         auto& self = *static_cast<__t*>(p);
@@ -386,6 +1840,8 @@ class epoll_context::scheduler {
       friend scheduler::schedule_sender;
 
       epoll_context& context_;
+      bool inline_;
+      epoll_context::priority priority_;
       STDEXEC_NO_UNIQUE_ADDRESS receiver_t receiver_;
     };
   };  // schedule_op.
@@ -417,6 +1873,8 @@ class epoll_context::scheduler {
       friend auto tag_invoke(stdexec::connect_t, Sender&& self,
                              Receiver receiver) noexcept -> op_t<Receiver> {
         return {static_cast<__t&&>(self).env_.context,
+                static_cast<__t&&>(self).env_.is_inline,
+                static_cast<__t&&>(self).env_.prio,
                 static_cast<Receiver&&>(receiver)};
       }
 
@@ -439,10 +1897,11 @@ class epoll_context::scheduler {
       using __id = schedule_at_op;
 
       constexpr __t(epoll_context& context, const time_point& due_time,
-                    receiver_t r) noexcept
+                    bool coarse, receiver_t r) noexcept
           : epoll_context::schedule_at_base_op(
                 context, due_time,
-                stdexec::get_stop_token(stdexec::get_env(r)).stop_possible()),
+                stdexec::get_stop_token(stdexec::get_env(r)).stop_possible(),
+                coarse),
             receiver_(static_cast<receiver_t&&>(r)) {}
 
       friend void tag_invoke(stdexec::start_t, __t& op) noexcept {
@@ -613,24 +2072,31 @@ class epoll_context::scheduler {
                              Receiver receiver) noexcept -> op_t<Receiver> {
         return {static_cast<__t&&>(self).env_.context,  //
                 static_cast<__t&&>(self).due_time_,     //
+                static_cast<__t&&>(self).coarse_,       //
                 static_cast<Receiver&&>(receiver)};
       }
 
-      constexpr __t(schedule_env env, const time_point& due_time) noexcept
-          : env_(env), due_time_(due_time) {}
+      constexpr __t(schedule_env env, const time_point& due_time,
+                    bool coarse = false) noexcept
+          : env_(env), due_time_(due_time), coarse_(coarse) {}
 
      private:
       friend epoll_context::scheduler;
 
       schedule_env env_;
       time_point due_time_;
+
+      // Whether the timer is put into the coarse timing wheel.
+      bool coarse_;
     };
   };  // schedule_at_sender
 
  public:
   // Constructors.
-  explicit constexpr scheduler(epoll_context& context) noexcept
-      : context_(&context) {}
+  explicit constexpr scheduler(
+      epoll_context& context, bool inline_schedule = false,
+      epoll_context::priority p = epoll_context::priority::normal) noexcept
+      : context_(&context), inline_(inline_schedule), priority_(p) {}
 
   constexpr scheduler(const scheduler&) noexcept = default;
 
@@ -638,13 +2104,23 @@ class epoll_context::scheduler {
 
   constexpr ~scheduler() = default;
 
-  friend auto tag_invoke(exec::now_t, const scheduler&) noexcept -> time_point {
-    return monotonic_clock::now();
+  // Get the context this scheduler schedules on.
+  constexpr epoll_context& context() const noexcept { return *context_; }
+
+  friend auto tag_invoke(exec::now_t, const scheduler& sched) noexcept
+      -> time_point {
+    return sched.context_->now();
+  }
+
+  friend auto tag_invoke(loop_now_t, const scheduler& sched) noexcept
+      -> time_point {
+    return sched.context_->loop_now();
   }
 
   friend auto tag_invoke(stdexec::schedule_t, const scheduler& sched) noexcept
       -> stdexec::__t<schedule_sender> {
-    return stdexec::__t<schedule_sender>{schedule_env{*sched.context_}};
+    return stdexec::__t<schedule_sender>{
+        schedule_env{*sched.context_, sched.inline_, sched.priority_}};
   }
 
   friend auto tag_invoke(exec::schedule_at_t,     //
@@ -658,21 +2134,72 @@ class epoll_context::scheduler {
                          const scheduler& sched,  //
                          std::chrono::nanoseconds duration) noexcept
       -> stdexec::__t<schedule_at_sender> {
-    return {schedule_env{*sched.context_}, monotonic_clock::now() + duration};
+    return {schedule_env{*sched.context_}, sched.context_->now() + duration};
+  }
+
+  friend auto tag_invoke(schedule_after_coarse_t,  //
+                         const scheduler& sched,   //
+                         std::chrono::nanoseconds duration) noexcept
+      -> stdexec::__t<schedule_at_sender> {
+    return {schedule_env{*sched.context_},
+            sched.context_->loop_now() + duration, true};
   }
 
  private:
   friend bool operator==(scheduler a, scheduler b) noexcept {
-    return a.context_ == b.context_;
+    return a.context_ == b.context_ && a.inline_ == b.inline_ &&
+           a.priority_ == b.priority_;
   }
 
   friend bool operator!=(scheduler a, scheduler b) noexcept {
-    return a.context_ != b.context_;
+    return !(a == b);
   }
 
   friend epoll_context;
 
   epoll_context* context_;
+
+  // Whether `schedule` completes inline on the io thread.
+  bool inline_;
+
+  // The priority `schedule` runs at.
+  epoll_context::priority priority_;
+};
+
+template <typename T>
+class epoll_context::allocator {
+ public:
+  using value_type = T;
+
+  static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+                "over-aligned types are not supported");
+
+  explicit constexpr allocator(epoll_context& context) noexcept
+      : context_(&context) {}
+
+  template <typename U>
+  constexpr allocator(const allocator<U>& other) noexcept  // NOLINT
+      : context_(other.context_) {}
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(context_->allocate_operation(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, std::size_t n) noexcept {
+    context_->deallocate_operation(p, n * sizeof(T));
+  }
+
+  template <typename U>
+  friend constexpr bool operator==(const allocator& a,
+                                   const allocator<U>& b) noexcept {
+    return a.context_ == b.context_;
+  }
+
+ private:
+  template <typename U>
+  friend class allocator;
+
+  epoll_context* context_;
 };
 
 inline constexpr epoll_context::scheduler
@@ -680,6 +2207,22 @@ epoll_context::get_scheduler() noexcept {
   return scheduler{*this};
 }
 
+template <typename T>
+inline constexpr epoll_context::allocator<T>
+epoll_context::get_allocator() noexcept {
+  return allocator<T>{*this};
+}
+
+inline constexpr epoll_context::scheduler epoll_context::get_scheduler(
+    priority p) noexcept {
+  return scheduler{*this, false, p};
+}
+
+inline constexpr epoll_context::scheduler
+epoll_context::get_inline_scheduler() noexcept {
+  return scheduler{*this, true};
+}
+
 inline int epoll_context::create_epoll() {
   int fd = ::epoll_create(1);
   if (fd < 0) {
@@ -736,47 +2279,116 @@ inline void epoll_context::remove_interrupter_from_epoll() {
   }
 }
 
-// !!!Stores the address of the context owned by the current thread
-static thread_local epoll_context* current_thread_context;
+// The context run by the current thread. An inline variable, so that every
+// translation unit sees the same slot and recognizes the io thread.
+inline thread_local epoll_context* current_thread_context = nullptr;
+
+inline epoll_context* epoll_context::current() noexcept {
+  return current_thread_context;
+}
 
-static constexpr uint32_t epoll_event_max_count = 256;
+inline size_t epoll_context::execute_local(size_t max_count) noexcept {
+  if (!has_local_work()) {
+    return 0;
+  }
+  max_count = std::min(max_count, local_budget_ops_);
+  std::optional<time_point> deadline;
+  if (local_budget_time_.count() > 0) {
+    deadline = clock_() + local_budget_time_;
+  }
+  size_t count = 0;
+  for (operation_queue* queue :
+       {&high_queue_, &local_queue_, &continuation_queue_, &low_queue_}) {
+    if (queue->empty()) {
+      continue;
+    }
+    if (count > 0 &&
+        (count >= max_count || (deadline && clock_() >= *deadline))) {
+      break;
+    }
+    count += execute_queue(*queue, max_count - count, deadline);
+  }
+  counters_.local_ops_.add(count);
+  return count;
+}
 
-inline size_t epoll_context::execute_local() noexcept {
-  if (local_queue_.empty()) {
+inline size_t epoll_context::execute_queue(
+    operation_queue& queue, size_t max_count,
+    const std::optional<time_point>& deadline) noexcept {
+  if (queue.empty()) {
     return 0;
   }
+  // Reading the clock costs about as much as a cheap operation, so only
+  // check the deadline every few operations.
+  constexpr size_t deadline_check_interval = 16;
   size_t count = 0;
-  auto pending = std::move(local_queue_);
-  while (!pending.empty()) {
+  auto pending = std::move(queue);
+  while (!pending.empty() && count < max_count) {
     auto* item = pending.pop_front();
     assert(item->enqueued_);
-    item->enqueued_ = false;
+    item->enqueued_.store(false, std::memory_order_relaxed);
     std::exchange(item->next_, nullptr);
+    if (heartbeat_enabled_) {
+      current_execute_.store(item->execute_, std::memory_order_relaxed);
+    }
     item->execute_(item);
     ++count;
+    if (deadline && count % deadline_check_interval == 0 &&
+        clock_() >= *deadline) {
+      break;
+    }
+  }
+  if (!pending.empty()) {
+    // Keep the order, the leftovers were enqueued first.
+    queue.prepend(std::move(pending));
   }
   return count;
 }
 
-inline void epoll_context::acquire_completion_queue_items() {
-  epoll_event events[epoll_event_max_count];
-  int wait_timeout = local_queue_.empty() ? -1 : 0;
-  int result =
-      ::epoll_wait(epoll_fd_, events, epoll_event_max_count, wait_timeout);
-  if (result < 0) {
-    throw std::system_error{static_cast<int>(errno), std::system_category(),
-                            "epoll_wait_return_error"};
+inline void epoll_context::acquire_completion_queue_items(int timeout) {
+  epoll_event* events = events_.data();
+  int result = 0;
+  record_flight(flight_event::wait_begin, timeout);
+  if (has_local_work() || timeout == 0) {
+    result = wait_events(0);
+  } else if (spin_budget_.count() == 0 || (result = spin_wait_events()) < 0) {
+    // Block only if no remote item sneaked in.
+    result = wait_events(try_mark_remote_queue_inactive() ? timeout : 0);
   }
+  profiler_.mark(loop_phase::wait);
+  NET_USDT_PROBE(epoll_wakeup, result);
+  record_flight(flight_event::wait_end, result);
+  update_event_batch(static_cast<std::size_t>(result));
 
   // temporary queue of newly completed items.
   operation_queue completion_queue;
+  std::size_t executed = 0;
+
+  // The descriptor states and the operations parked on them are usually cold
+  // in a large batch. Request the state `dispatch_prefetch_distance` events
+  // ahead, and the operations parked on the state of the next event, whose
+  // line has been requested a few iterations ago.
+  auto is_descriptor = [this](void* data) noexcept {
+    return data != &interrupter_ && data != timers_data();
+  };
+  for (int i = 0; i < std::min(result, dispatch_prefetch_distance); ++i) {
+    __builtin_prefetch(events[i].data.ptr);
+  }
   for (int i = 0; i < result; ++i) {
+    if (i + dispatch_prefetch_distance < result) {
+      __builtin_prefetch(events[i + dispatch_prefetch_distance].data.ptr);
+    }
+    if (i + 1 < result && is_descriptor(events[i + 1].data.ptr)) {
+      const auto* next = static_cast<descriptor_state*>(events[i + 1].data.ptr);
+      __builtin_prefetch(next->ops_[descriptor_state::read_slot], 1);
+      __builtin_prefetch(next->ops_[descriptor_state::write_slot], 1);
+    }
+
     if (events[i].data.ptr == &interrupter_) {
       // No need to read the eventfd to clear the signal since we're leaving the
       // descriptor in a ready-to-read state and relying on edge-triggered
       // notifications. Skip processing this item and let the run loop check for
       // the remote-queued items next time.
-      processed_remote_queue_submitted_ = false;
     } else if (events[i].data.ptr == timers_data()) {
       current_earliest_due_time_.reset();
       timers_are_dirty_ = true;
@@ -788,17 +2400,361 @@ inline void epoll_context::acquire_completion_queue_items() {
                                 "read_timerfd"};
       }
     } else {
-      auto& completion_state =
-          *reinterpret_cast<completion_op*>(events[i].data.ptr);
-      assert(completion_state.enqueued_.load() == false);
-      completion_state.enqueued_ = true;
-      completion_queue.push_back(&completion_state);
+      // Dispatch the event to the operations parked on this descriptor. The
+      // readiness of a slot without any parked operation is only remembered
+      // for `async_wait`, since every other operation tries the syscall
+      // before waiting.
+      auto& state = *static_cast<descriptor_state*>(events[i].data.ptr);
+      if (state.descriptor_ < 0) {
+        // Released by an operation executed earlier in this pass.
+        continue;
+      }
+      const uint32_t revents = events[i].events;
+      completion_op* ready[descriptor_state::max_slots];
+      std::size_t ready_count = 0;
+      auto dispatch = [&](descriptor_state::op_slot slot) noexcept {
+        if (completion_op* op = std::exchange(state.ops_[slot], nullptr)) {
+          assert(op->enqueued_.load() == false);
+          ready[ready_count++] = op;
+        } else {
+          state.ready_ |= static_cast<uint8_t>(1U << slot);
+        }
+      };
+      if (revents & (EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP)) {
+        dispatch(descriptor_state::read_slot);
+      }
+      if (revents & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+        dispatch(descriptor_state::write_slot);
+      }
+      if (revents & (EPOLLPRI | EPOLLERR | EPOLLHUP)) {
+        dispatch(descriptor_state::except_slot);
+      }
+      for (std::size_t j = 0; j < ready_count; ++j) {
+        if (inline_io_completions_) {
+          // All slots of the descriptor have been taken first, an operation
+          // may close it.
+          if (heartbeat_enabled_) {
+            current_execute_.store(ready[j]->execute_,
+                                   std::memory_order_relaxed);
+          }
+          ready[j]->execute_(ready[j]);
+          ++executed;
+        } else {
+          ready[j]->enqueued_.store(true, std::memory_order_relaxed);
+          completion_queue.push_back(ready[j]);
+        }
+      }
     }
   }
+  if (executed != 0) {
+    counters_.local_ops_.add(executed);
+  }
   schedule_local(std::move(completion_queue));
+  profiler_.mark(loop_phase::dispatch);
+}
+
+inline int epoll_context::wait_events(int timeout) {
+  if (timer_mode_ == timer_mode::wait_timeout && timeout != 0 &&
+      current_earliest_due_time_) {
+    auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        *current_earliest_due_time_ - clock_());
+    remaining = std::max(remaining, std::chrono::nanoseconds(0));
+    if (timeout < 0 || remaining < std::chrono::milliseconds(timeout)) {
+      return wait_events(remaining);
+    }
+  }
+  int result = ::epoll_wait(
+      epoll_fd_, events_.data(),
+      static_cast<int>(event_batch_size_.load(std::memory_order_relaxed)),
+      timeout);
+  if (result < 0) {
+    throw std::system_error{static_cast<int>(errno), std::system_category(),
+                            "epoll_wait_return_error"};
+  }
+  return result;
+}
+
+inline int epoll_context::wait_events(std::chrono::nanoseconds timeout) {
+  const int max_events =
+      static_cast<int>(event_batch_size_.load(std::memory_order_relaxed));
+#if defined(SYS_epoll_pwait2)
+  if (has_epoll_pwait2_) {
+    const auto seconds = std::chrono::floor<std::chrono::seconds>(timeout);
+    ::timespec ts = {.tv_sec = seconds.count(),
+                     .tv_nsec = (timeout - seconds).count()};
+    const int fd = epoll_fd_;
+    int result = static_cast<int>(::syscall(SYS_epoll_pwait2, fd,
+                                            events_.data(), max_events, &ts,
+                                            nullptr, 0));
+    if (result >= 0) {
+      return result;
+    }
+    if (errno != ENOSYS) {
+      throw std::system_error{static_cast<int>(errno), std::system_category(),
+                              "epoll_pwait2_return_error"};
+    }
+    has_epoll_pwait2_ = false;
+  }
+#endif
+  auto milliseconds = std::chrono::ceil<std::chrono::milliseconds>(timeout);
+  int result = ::epoll_wait(epoll_fd_, events_.data(), max_events,
+                            static_cast<int>(std::min<std::int64_t>(
+                                milliseconds.count(),
+                                std::numeric_limits<int>::max())));
+  if (result < 0) {
+    throw std::system_error{static_cast<int>(errno), std::system_category(),
+                            "epoll_wait_return_error"};
+  }
+  return result;
+}
+
+inline int epoll_context::spin_wait_events() {
+  const time_point deadline = clock_() + spin_budget_;
+  do {
+    if (int result = wait_events(0); result > 0) {
+      return result;
+    }
+    if (!stop_queue_.empty() ||
+        (remote_lanes_ ? !remote_lanes_->empty() : !remote_queue_.empty())) {
+      // Let the run loop collect the items right now.
+      return 0;
+    }
+  } while (clock_() < deadline);
+  return -1;
+}
+
+inline void epoll_context::update_event_batch(std::size_t fill) noexcept {
+  // Single writer, plain stores are enough.
+  const std::size_t size = event_batch_size_.load(std::memory_order_relaxed);
+  wait_count_.store(wait_count_.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+  event_count_.store(event_count_.load(std::memory_order_relaxed) + fill,
+                     std::memory_order_relaxed);
+  last_batch_fill_.store(fill, std::memory_order_relaxed);
+  if (fill == size) {
+    full_batch_count_.store(
+        full_batch_count_.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+  }
+  if (!adaptive_event_batch_) {
+    return;
+  }
+  if (fill == size && size < events_.size()) {
+    event_batch_size_.store(std::min(size * 2, events_.size()),
+                            std::memory_order_relaxed);
+  } else if (fill < size / 4 && size > min_event_batch_size) {
+    event_batch_size_.store(std::max(size / 2, min_event_batch_size),
+                            std::memory_order_relaxed);
+  }
+}
+
+inline epoll_context::descriptor_state* epoll_context::register_descriptor(
+    int descriptor, void*& descriptor_data, system_error2::system_code& ec,
+    bool exclusive) {
+  assert(is_running_on_io_thread());
+  if (descriptor_data != nullptr) {
+    return static_cast<descriptor_state*>(descriptor_data);
+  }
+
+  descriptor_state* state = free_descriptor_states_;
+  if (state != nullptr) {
+    free_descriptor_states_ = std::exchange(state->next_free_, nullptr);
+  } else {
+    state = descriptor_states_.emplace_back(new descriptor_state{}).get();
+  }
+
+  epoll_event event = {.events = EPOLLIN | EPOLLOUT | EPOLLPRI | EPOLLRDHUP |
+                                 EPOLLERR | EPOLLHUP | EPOLLET,
+                       .data = {.ptr = state}};
+  if (exclusive) {
+    // EPOLLEXCLUSIVE can't be combined with EPOLLPRI or EPOLLRDHUP.
+    event.events = EPOLLIN | EPOLLERR | EPOLLHUP | EPOLLET | EPOLLEXCLUSIVE;
+  }
+  counters_.epoll_ctl_calls_.add_shared();
+  if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, descriptor, &event) != 0) {
+    ec = system_error2::posix_code::current();
+    state->next_free_ = std::exchange(free_descriptor_states_, state);
+    return nullptr;
+  }
+  if (socket_busy_poll_.count() > 0) {
+    int value = static_cast<int>(socket_busy_poll_.count());
+    (void)::setsockopt(descriptor, SOL_SOCKET, SO_BUSY_POLL, &value,
+                       sizeof(value));
+  }
+  state->descriptor_ = descriptor;
+  state->zerocopy_sequence_ = 0;
+  state->zerocopy_enabled_ = false;
+  state->canceled_ = false;
+  state->background_ = false;
+  state->ready_ = 0;
+  state->reads_ = 0;
+  descriptor_data = state;
+  descriptor_count_.fetch_add(1, std::memory_order_relaxed);
+  return state;
+}
+
+inline void epoll_context::deregister_descriptor(
+    int descriptor, void*& descriptor_data) noexcept {
+  auto* state = static_cast<descriptor_state*>(
+      std::exchange(descriptor_data, nullptr));
+  if (state == nullptr) {
+    return;
+  }
+  assert(state->descriptor_ == descriptor);
+  descriptor_count_.fetch_sub(1, std::memory_order_relaxed);
+
+  // Removing the descriptor from epoll is thread safe, so do it right now
+  // before the descriptor gets closed and possibly reused.
+  epoll_event event = {};
+  counters_.epoll_ctl_calls_.add_shared();
+  ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, descriptor, &event);
+
+  if (is_running_on_io_thread() || !is_running()) {
+    release_descriptor_state(state);
+  } else {
+    // The slots are only touched by the I/O thread, hand the state over to it
+    // and wake it up in case some operations are still parked on the state.
+    state->next_free_ =
+        remote_released_descriptor_states_.load(std::memory_order_relaxed);
+    while (!remote_released_descriptor_states_.compare_exchange_weak(
+        state->next_free_, state, std::memory_order_release,
+        std::memory_order_relaxed)) {
+    }
+    interrupter_.interrupt();
+  }
+}
+
+inline void epoll_context::release_descriptor_state(
+    descriptor_state* state) noexcept {
+  for (auto& op : state->ops_) {
+    if (op != nullptr) {
+      completion_op* parked = std::exchange(op, nullptr);
+      if (is_running_on_io_thread()) {
+        schedule_local(parked);
+      } else {
+        schedule_remote(parked);
+      }
+    }
+  }
+  state->descriptor_ = -1;
+  state->next_free_ = std::exchange(free_descriptor_states_, state);
+}
+
+inline void epoll_context::release_remote_descriptor_states() noexcept {
+  descriptor_state* state = remote_released_descriptor_states_.exchange(
+      nullptr, std::memory_order_acquire);
+  while (state != nullptr) {
+    release_descriptor_state(std::exchange(state, state->next_free_));
+  }
+}
+
+inline void epoll_context::cancel_descriptor_state(
+    descriptor_state* state) noexcept {
+  state->canceled_ = true;
+  for (auto& op : state->ops_) {
+    if (op != nullptr) {
+      schedule_local(std::exchange(op, nullptr));
+    }
+  }
+}
+
+inline void epoll_context::begin_drain(drain_base* op) noexcept {
+  assert(is_running_on_io_thread());
+  op->next_drain_ = std::exchange(drain_waiters_, op);
+  if (draining_.load(std::memory_order_relaxed)) {
+    if (op->deadline_ < drain_deadline_.due_) {
+      drain_deadline_.due_ = op->deadline_;
+    }
+    return;
+  }
+  draining_.store(true, std::memory_order_release);
+
+  // Stop accepting. The connections already accepted are served until the
+  // deadline.
+  for (auto& state : descriptor_states_) {
+    int listening = 0;
+    socklen_t len = sizeof(listening);
+    if (state->descriptor_ >= 0 &&
+        (state->background_ ||
+         (::getsockopt(state->descriptor_, SOL_SOCKET, SO_ACCEPTCONN,
+                       &listening, &len) == 0 &&
+          listening != 0))) {
+      cancel_descriptor_state(state.get());
+    }
+  }
+
+  drain_deadline_.context_ = this;
+  drain_deadline_.due_ = op->deadline_;
+  drain_deadline_.execute_ = [](loop_task* task) noexcept {
+    auto& self = *static_cast<drain_deadline_task*>(task)->context_;
+    self.drain_deadline_.armed_ = false;
+    self.remove_loop_task(task);
+    for (auto& state : self.descriptor_states_) {
+      if (state->descriptor_ >= 0) {
+        self.cancel_descriptor_state(state.get());
+      }
+    }
+  };
+  drain_deadline_.armed_ = true;
+  add_loop_task(&drain_deadline_);
+}
+
+inline bool epoll_context::try_finish_drain() noexcept {
+  if (has_local_work() || !deferred_queue_.empty() ||
+      !try_schedule_remote_to_local() ||
+      outstanding_work_.load(std::memory_order_acquire) != 0) {
+    return false;
+  }
+  bool parked = false;
+  for (auto& state : descriptor_states_) {
+    const auto& ops = state->ops_;
+    if (std::any_of(ops, ops + descriptor_state::max_slots,
+                    [](completion_op* op) { return op != nullptr; })) {
+      parked = true;
+      if (state->canceled_) {
+        // Started after the state was canceled.
+        cancel_descriptor_state(state.get());
+      }
+    }
+  }
+  if (parked) {
+    return false;
+  }
+
+  // The canceled sockets may be used again by the next run.
+  for (auto& state : descriptor_states_) {
+    state->canceled_ = false;
+  }
+  if (std::exchange(drain_deadline_.armed_, false)) {
+    remove_loop_task(&drain_deadline_);
+  }
+  draining_.store(false, std::memory_order_release);
+  drain_base* op = std::exchange(drain_waiters_, nullptr);
+  while (op != nullptr) {
+    std::exchange(op, op->next_drain_)->complete_(op);
+  }
+  return true;
 }
 
 inline void epoll_context::run() {
+  (void)run_loop(std::nullopt, std::numeric_limits<std::size_t>::max());
+}
+
+inline std::size_t epoll_context::run_one() {
+  return run_loop(std::nullopt, 1);
+}
+
+inline std::size_t epoll_context::poll() {
+  return run_loop(clock_(),
+                  std::numeric_limits<std::size_t>::max());
+}
+
+inline std::size_t epoll_context::run_until(const time_point& deadline) {
+  return run_loop(deadline, std::numeric_limits<std::size_t>::max());
+}
+
+inline std::size_t epoll_context::run_loop(std::optional<time_point> deadline,
+                                           std::size_t max_count) {
   // Only one thread of execution is allowed to drive the io context.
   bool expected_running = false;
   if (!is_running_.compare_exchange_strong(expected_running, true,
@@ -806,33 +2762,100 @@ inline void epoll_context::run() {
     throw std::runtime_error(
         "epoll_context::run() called on a running context");
   }
+  io_thread_id_.store(std::this_thread::get_id(), std::memory_order_relaxed);
   exec::scope_guard set_not_running{[&]() noexcept {  //
+    mark_idle();
+    io_thread_id_.store(std::thread::id{}, std::memory_order_relaxed);
     is_running_.store(false, std::memory_order_relaxed);
   }};
 
   auto* old_context = std::exchange(current_thread_context, this);
+  auto* old_thread_info =
+      std::exchange(thread_info_base::current(), &thread_info_);
   exec::scope_guard g{[=]() noexcept {
     std::exchange(current_thread_context, old_context);
+    std::exchange(thread_info_base::current(), old_thread_info);
   }};
 
-  size_t executed_cnt;
+  std::size_t executed_cnt = 0;
+  bool deadline_reached = false;
+  update_loop_time();
+  mark_busy();
+  profiler_.start();
   while (true) {
-    executed_cnt = execute_local();
-    if (stop_source_->stop_requested()) {
-      // Should we cancel all operations in this context or just ignored?
+    counters_.loop_iterations_.add();
+    ++loop_iteration_;
+    if (remote_released_descriptor_states_.load(std::memory_order_relaxed) !=
+        nullptr) {
+      release_remote_descriptor_states();
+    }
+    if (remote_freed_operations_.load(std::memory_order_relaxed) != nullptr) {
+      reclaim_remote_operations();
+    }
+    executed_cnt += execute_local(max_count - executed_cnt);
+    profiler_.mark(loop_phase::execute_local);
+    if (stop_source_->stop_requested() || executed_cnt >= max_count) {
+      // A stop leaves the pending operations as they are, `async_drain`
+      // completes or cancels them first.
+      break;
+    }
+    if (draining_.load(std::memory_order_relaxed) && try_finish_drain()) {
       break;
     }
-    if (timers_are_dirty_) {
+    const bool timers_were_dirty = timers_are_dirty_;
+    if (timers_were_dirty) {
       update_timers();
     }
-    if (!processed_remote_queue_submitted_) {
-      // This flag will be true if we have collected some items from remote
-      // queue to local queue. So we have cleared remote queue. Just wait the
-      // next time's interrupt.
-      processed_remote_queue_submitted_ = try_schedule_remote_to_local();
+    profiler_.mark(loop_phase::update_timers, timers_were_dirty);
+    std::optional<time_point> task_due;
+    const bool has_loop_tasks = !loop_tasks_.empty();
+    if (has_loop_tasks) {
+      task_due = run_loop_tasks();
+    }
+    profiler_.mark(loop_phase::loop_tasks, has_loop_tasks);
+    // Cheap if the queue is empty, the queue stays active while we are awake.
+    (void)try_schedule_remote_to_local();
+    profiler_.mark(loop_phase::collect_remote);
+
+    int timeout = -1;
+    if (deadline) {
+      const time_point now = loop_time_;
+      if (now >= *deadline) {
+        if (deadline_reached) {
+          break;
+        }
+        deadline_reached = true;
+        timeout = 0;
+      } else {
+        auto remaining =
+            std::chrono::ceil<std::chrono::milliseconds>(*deadline - now);
+        timeout = static_cast<int>(std::min<std::int64_t>(
+            remaining.count(), std::numeric_limits<int>::max()));
+      }
+    }
+    if (task_due) {
+      auto remaining =
+          std::chrono::ceil<std::chrono::milliseconds>(*task_due - loop_time_);
+      const int task_timeout = static_cast<int>(std::clamp<std::int64_t>(
+          remaining.count(), 0, std::numeric_limits<int>::max()));
+      timeout = timeout < 0 ? task_timeout : std::min(timeout, task_timeout);
+    }
+    if (!deferred_queue_.empty()) {
+      // Ahead of the completions of the coming wait, which doesn't block.
+      schedule_local(std::move(deferred_queue_));
+    }
+    mark_idle();
+    acquire_completion_queue_items(timeout);
+    update_loop_time();
+    mark_busy();
+    if (timer_mode_ == timer_mode::wait_timeout && current_earliest_due_time_ &&
+        loop_time_ >= *current_earliest_due_time_) {
+      // The earliest timer is due, as if the timerfd had fired.
+      current_earliest_due_time_.reset();
+      timers_are_dirty_ = true;
     }
-    acquire_completion_queue_items();
   }
+  return executed_cnt;
 }
 
 inline bool epoll_context::is_running_on_io_thread() const noexcept {
@@ -848,10 +2871,44 @@ inline void epoll_context::schedule_impl(operation_base* op) noexcept {
   }
 }
 
+inline void epoll_context::schedule_continuation(
+    operation_base* op) noexcept {
+  assert(op != nullptr);
+  if (is_running_on_io_thread()) {
+    assert(op->execute_ != nullptr);
+    assert(!op->enqueued_);
+    op->enqueued_.store(true, std::memory_order_relaxed);
+    continuation_queue_.push_back(op);
+  } else {
+    schedule_remote(op);
+  }
+}
+
+inline void epoll_context::schedule_with_priority(operation_base* op,
+                                                  priority p) noexcept {
+  assert(op != nullptr);
+  if (p == priority::normal) {
+    schedule_continuation(op);
+  } else if (is_running_on_io_thread()) {
+    assert(!op->enqueued_);
+    op->enqueued_.store(true, std::memory_order_relaxed);
+    (p == priority::high ? high_queue_ : low_queue_).push_back(op);
+  } else if (p == priority::high) {
+    assert(!op->enqueued_.load());
+    op->enqueued_ = true;
+    NET_USDT_PROBE(remote_enqueue, op);
+    (void)high_remote_queue_.enqueue(op);
+    remote_interrupt_count_.fetch_add(1, std::memory_order_relaxed);
+    interrupter_.interrupt();
+  } else {
+    schedule_remote(op);
+  }
+}
+
 inline void epoll_context::schedule_local(operation_base* op) noexcept {
   assert(op->execute_ != nullptr);
   assert(!op->enqueued_);
-  op->enqueued_ = true;
+  op->enqueued_.store(true, std::memory_order_relaxed);
   local_queue_.push_back(op);
 }
 
@@ -864,26 +2921,127 @@ inline void epoll_context::schedule_local(operation_queue ops) noexcept {
 inline void epoll_context::schedule_remote(operation_base* op) noexcept {
   assert(!op->enqueued_.load());
   op->enqueued_ = true;
-  if (remote_queue_.enqueue(op)) {
+  NET_USDT_PROBE(remote_enqueue, op);
+  if constexpr (stats_enabled) {
+    if (io_thread_id_.load(std::memory_order_relaxed) ==
+        std::this_thread::get_id()) {
+      counters_.io_thread_remote_ops_.add();
+    }
+  }
+  if (remote_lanes_ ? remote_lanes_->enqueue(op) : remote_queue_.enqueue(op)) {
     // We were the first to queue an item and the I/O thread is not
     // going to check the queue until we notify it that new items
     // have been enqueued remotely by writing to the eventfd.
+    remote_interrupt_count_.fetch_add(1, std::memory_order_relaxed);
+    interrupter_.interrupt();
+  } else {
+    remote_saved_interrupt_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+inline void epoll_context::schedule_stop(operation_base* op) noexcept {
+  assert(!op->enqueued_.load());
+  if (is_running_on_io_thread()) {
+    op->enqueued_.store(true, std::memory_order_relaxed);
+    high_queue_.push_back(op);
+    return;
+  }
+  op->enqueued_.store(true, std::memory_order_relaxed);
+  NET_USDT_PROBE(remote_enqueue, op);
+  if (stop_queue_.enqueue(op)) {
+    // The I/O thread is blocked or about to block, the next stops of the
+    // burst are collected with this one.
+    remote_interrupt_count_.fetch_add(1, std::memory_order_relaxed);
     interrupter_.interrupt();
   }
 }
 
+inline bool epoll_context::try_collect_stops() noexcept {
+  (void)stop_queue_.try_mark_active();
+  auto stops = stop_queue_.dequeue_all();
+  if (stops.empty()) {
+    return true;
+  }
+  std::uint64_t count = 0;
+  for (operation_base* op = stops.front(); op != nullptr; op = op->next_) {
+    ++count;
+  }
+  counters_.remote_stops_.add(count);
+  high_queue_.append(std::move(stops));
+  return false;
+}
+
 inline bool epoll_context::try_schedule_remote_to_local() noexcept {
-  auto queued_items = remote_queue_.try_mark_inactive_or_dequeue_all();
+  // Stops and high priority items skip the local queue.
+  bool collected_high = !try_collect_stops();
+  if (!high_remote_queue_.empty()) {
+    auto high_items = high_remote_queue_.dequeue_all();
+    add_remote_items(high_items);
+    high_queue_.append(std::move(high_items));
+    collected_high = true;
+  }
+  // The queue is inactive if we have been blocked in epoll_wait, or active
+  // already if a remote thread enqueued an item since then.
+  if (remote_lanes_) {
+    (void)remote_lanes_->try_mark_active();
+  } else {
+    (void)remote_queue_.try_mark_active();
+  }
+  auto queued_items = remote_lanes_ ? remote_lanes_->dequeue_all()
+                                    : remote_queue_.dequeue_all();
+  if (!queued_items.empty()) {
+    add_remote_items(queued_items);
+    schedule_local(std::move(queued_items));
+    return false;
+  }
+  return !collected_high;
+}
+
+inline bool epoll_context::try_mark_remote_queue_inactive() noexcept {
+  if (!stop_queue_.try_mark_inactive()) {
+    (void)try_collect_stops();
+    return false;
+  }
+  auto queued_items =
+      remote_lanes_ ? remote_lanes_->try_mark_inactive_or_dequeue_all()
+                    : remote_queue_.try_mark_inactive_or_dequeue_all();
   if (!queued_items.empty()) {
+    add_remote_items(queued_items);
     schedule_local(std::move(queued_items));
     return false;
   }
   return true;
 }
 
+inline void epoll_context::add_remote_items(
+    const operation_queue& items) noexcept {
+  std::uint64_t count = 0;
+  for (operation_base* op = items.front(); op != nullptr; op = op->next_) {
+    ++count;
+  }
+  if (count != 0) {
+    record_flight(flight_event::remote_drain, static_cast<std::int32_t>(count));
+  }
+  remote_item_count_.store(
+      remote_item_count_.load(std::memory_order_relaxed) + count,
+      std::memory_order_relaxed);
+}
+
 inline void epoll_context::schedule_at_impl(schedule_at_base_op* op) noexcept {
   assert(op);
   assert(is_running_on_io_thread());
+  counters_.timer_inserts_.add();
+  if (op->coarse_) {
+    if (coarse_timers_.empty()) {
+      coarse_timers_.reset(loop_time_);
+    }
+    coarse_timers_.insert(op);
+    if (!current_earliest_due_time_ ||
+        *coarse_timers_.next_expiry() < *current_earliest_due_time_) {
+      timers_are_dirty_ = true;
+    }
+    return;
+  }
   timers_.insert(op);
   if (timers_.top() == op) {
     timers_are_dirty_ = true;
@@ -891,6 +3049,13 @@ inline void epoll_context::schedule_at_impl(schedule_at_base_op* op) noexcept {
 }
 
 inline void epoll_context::remove_timer(schedule_at_base_op* op) noexcept {
+  counters_.timer_removes_.add();
+  if (op->coarse_) {
+    // The timerfd may fire for nothing later, which is cheaper than
+    // rearming it on each cancellation.
+    coarse_timers_.remove(op);
+    return;
+  }
   assert(!timers_.empty());
   if (timers_.top() == op) {
     timers_are_dirty_ = true;
@@ -898,31 +3063,70 @@ inline void epoll_context::remove_timer(schedule_at_base_op* op) noexcept {
   timers_.remove(op);
 }
 
+inline void epoll_context::advance_timer(schedule_at_base_op* op) noexcept {
+  assert(is_running_on_io_thread());
+  assert(!op->coarse_);
+  timers_.decrease(op);
+  if (timers_.top() == op) {
+    timers_are_dirty_ = true;
+  }
+}
+
 inline void epoll_context::update_timers() noexcept {
+  auto on_elapsed = [this](schedule_at_base_op* op) noexcept {
+    counters_.timer_fires_.add();
+    NET_USDT_PROBE(timer_fire, op);
+    record_flight(flight_event::timer_fire, 0);
+    if (op->can_be_cancelled_) {
+      auto old_state = op->state_.fetch_add(schedule_at_base_op::timer_elapsed,
+                                            std::memory_order_acq_rel);
+      if ((old_state & schedule_at_base_op::cancel_pending) != 0) {
+        // Timer has been cancelled by a remote thread.
+        // The other thread is responsible for enqueueing is operation onto
+        // the remote_queue_.
+        return;
+      }
+    }
+
+    // Otherwise, we are responsible for enqueuing the timer onto the
+    // ready-to-run queue.
+    schedule_local(op);
+  };
+
   // Reap any elapsed timers.
-  if (!timers_.empty()) {
-    time_point now = monotonic_clock::now();
+  if (!timers_.empty() || !coarse_timers_.empty()) {
+    const time_point now = loop_time_;
     while (!timers_.empty() && timers_.top()->due_time_ <= now) {
-      schedule_at_base_op* op = timers_.pop();
-      if (op->can_be_cancelled_) {
-        auto old_state = op->state_.fetch_add(
-            schedule_at_base_op::timer_elapsed, std::memory_order_acq_rel);
-        if ((old_state & schedule_at_base_op::cancel_pending) != 0) {
-          // Timer has been cancelled by a remote thread.
-          // The other thread is responsible for enqueueing is operation onto
-          // the remote_queue_.
-          continue;
-        }
-      }
+      on_elapsed(timers_.pop());
+    }
+    if (!coarse_timers_.empty()) {
+      coarse_timers_.advance(now, on_elapsed);
+    }
+  }
+
+  // The earliest time we must be woken up at.
+  std::optional<time_point> earliest;
+  if (!timers_.empty()) {
+    earliest = timers_.top()->due_time_;
+  }
+  if (auto coarse = coarse_timers_.next_expiry()) {
+    if (!earliest || *coarse < *earliest) {
+      earliest = coarse;
+    }
+  }
 
-      // Otherwise, we are responsible for enqueuing the timer onto the
-      // ready-to-run queue.
-      schedule_local(op);
+  if (timer_mode_ == timer_mode::wait_timeout) {
+    // epoll_wait picks the time up before blocking.
+    current_earliest_due_time_.reset();
+    if (earliest) {
+      current_earliest_due_time_ = apply_timer_slack(*earliest);
     }
+    timers_are_dirty_ = false;
+    return;
   }
 
   // Check if we need to cancel or start some new OS timers.
-  if (timers_.empty()) {
+  if (!earliest) {
     // If there is no timing operation currently, we should reset the timing
     // time for timerfd
     if (current_earliest_due_time_.has_value()) {
@@ -930,9 +3134,13 @@ inline void epoll_context::update_timers() noexcept {
       set_timer(time_point{});
     }
   } else {
-    const auto earliest_due_time = timers_.top()->due_time_;
+    const auto earliest_due_time = apply_timer_slack(*earliest);
     if (current_earliest_due_time_) {
-      constexpr auto threshold = std::chrono::microseconds(1);
+      // With slack, deadlines in the same slack window are rounded to the
+      // same time point, so only an earlier window needs a re-arm.
+      const std::chrono::nanoseconds threshold =
+          timer_slack_.count() > 0 ? std::chrono::nanoseconds(0)
+                                   : std::chrono::microseconds(1);
       if (earliest_due_time < (*current_earliest_due_time_ - threshold)) {
         // An earlier time has been scheduled.
         // Cancel the old timer before submitting a new one.
@@ -951,7 +3159,54 @@ inline void epoll_context::update_timers() noexcept {
   timers_are_dirty_ = false;
 }
 
+inline epoll_context::time_point epoll_context::apply_timer_slack(
+    const time_point& due_time) const noexcept {
+  const std::int64_t slack = timer_slack_.count();
+  if (slack <= 1) {
+    return due_time;
+  }
+  constexpr std::int64_t nanoseconds_per_second = 1'000'000'000;
+  // Far due times, e.g. time_point::max(), don't fit in nanoseconds and
+  // gain nothing from being rounded.
+  const std::int64_t max_seconds =
+      (std::numeric_limits<std::int64_t>::max() - slack) /
+          nanoseconds_per_second -
+      1;
+  if (due_time.seconds() < 0 || due_time.seconds() > max_seconds) {
+    return due_time;
+  }
+  const std::int64_t ns =
+      due_time.seconds() * nanoseconds_per_second + due_time.nanoseconds();
+  const std::int64_t rounded = (ns + slack - 1) / slack * slack;
+  return time_point::from_seconds_and_nanoseconds(
+      rounded / nanoseconds_per_second, rounded % nanoseconds_per_second);
+}
+
+inline std::optional<epoll_context::time_point>
+epoll_context::run_loop_tasks() noexcept {
+  loop_task* task = loop_tasks_.front();
+  while (task != nullptr) {
+    // The task may remove itself.
+    loop_task* next = task->next_;
+    if (task->due_ <= loop_time_) {
+      task->execute_(task);
+    }
+    task = next;
+  }
+
+  std::optional<time_point> earliest;
+  for (task = loop_tasks_.front(); task != nullptr; task = task->next_) {
+    if (!earliest || task->due_ < *earliest) {
+      earliest = task->due_;
+    }
+  }
+  return earliest;
+}
+
 inline void epoll_context::set_timer(const time_point& due_time) {
+  timer_rearm_count_.store(
+      timer_rearm_count_.load(std::memory_order_relaxed) + 1,
+      std::memory_order_relaxed);
   ::itimerspec time = {
       .it_interval = {.tv_sec = 0, .tv_nsec = 0},
       .it_value = {.tv_sec = due_time.seconds(),
@@ -965,6 +3220,10 @@ inline void epoll_context::set_timer(const time_point& due_time) {
 };  // namespace __epoll
 
 using epoll_context = __epoll::epoll_context;
+
+inline constexpr __epoll::schedule_after_coarse_t schedule_after_coarse{};
+
+inline constexpr __epoll::loop_now_t loop_now{};
 }  // namespace net
 
 #endif  // EPOLL_EPOLL_CONTEXT_HPP_
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_FILE_IO_OP_HPP_
+#define EPOLL_FILE_IO_OP_HPP_
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <system_error>  // NOLINT
+#include <type_traits>
+
+#include "buffer.hpp"
+#include "buffer_sequence_adapter.hpp"
+#include "epoll/epoll_context.hpp"
+#include "file_io_pool.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// Read or write a file at an offset with a blocking preadv or pwritev on a
+// worker of a `file_io_pool`, then schedule the completion back onto the I/O
+// thread of the context. Completions of many workers are collected with one
+// wakeup of the I/O thread, as only the first item queued to an idle remote
+// queue signals it. The call can't be interrupted, so a stop request is only
+// observed when the operation starts and when it completes.
+template <typename ReceiverId, typename Buffers, bool Write>
+class epoll_context::file_io_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  using buffer_t = std::conditional_t<Write, const_buffer, mutable_buffer>;
+  using bufs_t = buffer_sequence_adapter<buffer_t, Buffers>;
+
+ public:
+  struct __t : private operation_base, private resolver_pool::job {
+    using __id = file_io_op;
+    using stop_token = stdexec::stop_token_of_t<stdexec::env_of_t<receiver_t>&>;
+
+    __t(receiver_t receiver, epoll_context& context, file_io_pool& pool,
+        int file, std::uint64_t offset, Buffers buffers) noexcept
+        : context_(context),
+          pool_(pool),
+          file_(file),
+          offset_(offset),
+          buffers_(buffers),
+          bufs_(buffers_),
+          result_(0),
+          receiver_(static_cast<receiver_t&&>(receiver)) {
+      this->execute_ = &complete;
+      this->run_ = &transfer;
+    }
+
+    friend void tag_invoke(stdexec::start_t, __t& self) noexcept {
+      if constexpr (!std::unstoppable_token<stop_token>) {
+        if (stdexec::get_stop_token(stdexec::get_env(self.receiver_))
+                .stop_requested()) {
+          stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+          return;
+        }
+      }
+      self.pool_.submit(static_cast<resolver_pool::job*>(&self));
+    }
+
+   private:
+    // Runs on a worker of the pool.
+    static void transfer(resolver_pool::job* j) noexcept {
+      auto& self = *static_cast<__t*>(j);
+      const auto offset = static_cast<::off_t>(self.offset_);
+      ::ssize_t res = 0;
+      if (!self.bufs_.all_empty()) {
+        do {
+          if constexpr (Write) {
+            res = ::pwritev(self.file_, self.bufs_.buffers(),
+                            static_cast<int>(self.bufs_.count()), offset);
+          } else {
+            res = ::preadv(self.file_, self.bufs_.buffers(),
+                           static_cast<int>(self.bufs_.count()), offset);
+          }
+        } while (res < 0 && errno == EINTR);
+      }
+      self.result_ = res < 0 ? -errno : res;
+
+      // Hand the operation back to the I/O thread.
+      self.context_.schedule_impl(static_cast<operation_base*>(&self));
+    }
+
+    // Runs on the I/O thread.
+    static void complete(operation_base* op) noexcept {
+      auto& self = *static_cast<__t*>(op);
+      if constexpr (!std::unstoppable_token<stop_token>) {
+        if (stdexec::get_stop_token(stdexec::get_env(self.receiver_))
+                .stop_requested()) {
+          stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+          return;
+        }
+      }
+      if (self.result_ < 0) {
+        stdexec::set_error(
+            static_cast<receiver_t&&>(self.receiver_),
+            make_error_code(static_cast<std::errc>(-self.result_)));
+      } else {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                           static_cast<size_t>(self.result_));
+      }
+    }
+
+    epoll_context& context_;
+    file_io_pool& pool_;
+    int file_;
+    std::uint64_t offset_;
+    Buffers buffers_;
+    bufs_t bufs_;
+
+    // The count of bytes transferred, or the negated errno.
+    ::ssize_t result_;
+    STDEXEC_NO_UNIQUE_ADDRESS receiver_t receiver_;
+  };
+};
+
+template <typename Buffers, bool Write>
+class file_io_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<
+      epoll_context::file_io_op<stdexec::__id<Receiver>, Buffers, Write>>;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = file_io_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(size_t),
+                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.context_, self.pool_,
+              self.file_, self.offset_, self.buffers_};
+    }
+
+    __t(epoll_context& context, file_io_pool& pool, int file,
+        std::uint64_t offset, Buffers buffers) noexcept
+        : context_(context),
+          pool_(pool),
+          file_(file),
+          offset_(offset),
+          buffers_(buffers) {}
+
+   private:
+    epoll_context& context_;
+    file_io_pool& pool_;
+    int file_;
+    std::uint64_t offset_;
+    Buffers buffers_;
+  };
+};
+
+// Read from the file descriptor `file` at `offset` into `buffers`, without
+// blocking the I/O thread of `context`. Like preadv, completes with the count
+// of bytes read, which is short at the end of the file, and is 0 past it. A
+// sequence of more buffers than a single call takes is read up to that
+// limit. The file position is not used nor changed.
+struct async_read_file_at_t {
+  template <mutable_buffer_sequence Buffers>
+  auto operator()(epoll_context& context, int file, std::uint64_t offset,
+                  Buffers buffers) const noexcept
+      -> stdexec::__t<file_io_sender<Buffers, false>> {
+    return {context, file_io_pool::shared(), file, offset, buffers};
+  }
+
+  // Read on the workers of `pool` rather than the shared pool.
+  template <mutable_buffer_sequence Buffers>
+  auto operator()(epoll_context& context, file_io_pool& pool, int file,
+                  std::uint64_t offset, Buffers buffers) const noexcept
+      -> stdexec::__t<file_io_sender<Buffers, false>> {
+    return {context, pool, file, offset, buffers};
+  }
+};
+
+// Write `buffers` to the file descriptor `file` at `offset`, without blocking
+// the I/O thread of `context`. Like pwritev, completes with the count of bytes
+// written, which is short only if the device is full or a limit is hit. A
+// file opened with O_APPEND is written at its end regardless of `offset`.
+struct async_write_file_at_t {
+  template <const_buffer_sequence Buffers>
+  auto operator()(epoll_context& context, int file, std::uint64_t offset,
+                  Buffers buffers) const noexcept
+      -> stdexec::__t<file_io_sender<Buffers, true>> {
+    return {context, file_io_pool::shared(), file, offset, buffers};
+  }
+
+  // Write on the workers of `pool` rather than the shared pool.
+  template <const_buffer_sequence Buffers>
+  auto operator()(epoll_context& context, file_io_pool& pool, int file,
+                  std::uint64_t offset, Buffers buffers) const noexcept
+      -> stdexec::__t<file_io_sender<Buffers, true>> {
+    return {context, pool, file, offset, buffers};
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::async_read_file_at_t async_read_file_at{};
+inline constexpr __epoll::async_write_file_at_t async_write_file_at{};
+}  // namespace net
+
+#endif  // EPOLL_FILE_IO_OP_HPP_
@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_FRAMED_STREAM_HPP_
+#define EPOLL_FRAMED_STREAM_HPP_
+
+#include <algorithm>
+#include <array>
+#include <concepts>      // NOLINT
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <system_error>  // NOLINT
+#include <vector>
+
+#include "status-code/system_code.hpp"
+
+#include "basic_socket.hpp"
+#include "buffer.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_io_base_op.hpp"
+#include "epoll/socket_send_all_op.hpp"
+#include "meta.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+
+// A stream of frames, each prefixed with its length as a 4 bytes big endian
+// integer. Reads receive large chunks into one buffer and hand out every
+// complete frame of a chunk at once as views into that buffer. Writes encode
+// a batch of payloads into a single buffer sequence for `async_send_all`, so
+// the headers and payloads leave with one `sendmsg` per window.
+//
+// The views of a read stay valid until the next read, the buffer sequence of
+// a write until the next write. Only one read and one write may be pending at
+// a time. The internal vectors keep their capacity, so steady-state traffic
+// doesn't allocate per frame.
+template <typename Protocol>
+class framed_stream {
+  using socket_t = typename Protocol::socket;
+
+ public:
+  // The size of the length prefix of each frame.
+  static constexpr std::size_t header_size = 4;
+
+  // Constructor. Frames larger than `max_frame_size` fail the read with
+  // `errc::message_size`. Each receive asks for at least `recv_size` bytes.
+  explicit framed_stream(basic_socket<Protocol>& socket,
+                         std::size_t max_frame_size = 16 * 1024 * 1024,
+                         std::size_t recv_size = 64 * 1024)
+      : socket_(static_cast<socket_t&>(socket)),
+        max_frame_size_(max_frame_size),
+        recv_size_(recv_size),
+        in_(),
+        head_(0),
+        tail_(0),
+        frames_(),
+        headers_(),
+        out_() {}
+
+  // The underlying socket.
+  socket_t& socket() noexcept { return socket_; }
+
+  // The maximum payload size of a frame.
+  std::size_t max_frame_size() const noexcept { return max_frame_size_; }
+
+  // The frames handed out by the last read.
+  std::span<const const_buffer> frames() const noexcept { return frames_; }
+
+  // The received bytes which don't form a complete frame yet.
+  std::size_t buffered() const noexcept { return tail_ - head_; }
+
+  // Encode `payloads` as frames. Returns the buffer sequence of headers and
+  // payloads, which refers to the payloads without copying them.
+  std::span<const const_buffer> encode(
+      std::span<const const_buffer> payloads) {
+    headers_.resize(payloads.size());
+    out_.clear();
+    out_.reserve(payloads.size() * 2);
+    for (std::size_t i = 0; i < payloads.size(); ++i) {
+      auto size = static_cast<std::uint32_t>(payloads[i].size());
+      headers_[i] = {static_cast<unsigned char>(size >> 24),
+                     static_cast<unsigned char>(size >> 16),
+                     static_cast<unsigned char>(size >> 8),
+                     static_cast<unsigned char>(size)};
+      out_.emplace_back(headers_[i].data(), header_size);
+      out_.push_back(payloads[i]);
+    }
+    return out_;
+  }
+
+ private:
+  template <typename ReceiverId, typename P>
+  friend class epoll_context::socket_recv_frames_op;
+
+  // Move every complete frame of the buffered bytes to `frames_`. Returns
+  // false if a header announces a frame above the limit.
+  bool extract_frames() noexcept {
+    while (tail_ - head_ >= header_size) {
+      std::uint32_t size = frame_size(head_);
+      if (size > max_frame_size_) {
+        return false;
+      }
+      if (tail_ - head_ - header_size < size) {
+        break;
+      }
+      frames_.emplace_back(in_.data() + head_ + header_size, size);
+      head_ += header_size + size;
+    }
+    return true;
+  }
+
+  // The space for the next receive. A partial frame is moved to the front
+  // first, and the buffer grows to hold it whole. The frames of the previous
+  // read are released here.
+  mutable_buffer prepare() {
+    std::size_t pending = tail_ - head_;
+    if (head_ != 0) {
+      if (pending != 0) {
+        ::memmove(in_.data(), in_.data() + head_, pending);
+      }
+      head_ = 0;
+      tail_ = pending;
+    }
+    std::size_t wanted = tail_ + recv_size_;
+    if (pending >= header_size) {
+      wanted = (std::max)(wanted, header_size + frame_size(0));
+    }
+    if (in_.size() < wanted) {
+      in_.resize(wanted);
+    }
+    return buffer(in_.data() + tail_, in_.size() - tail_);
+  }
+
+  // Append `n` received bytes to the buffered bytes.
+  void commit(std::size_t n) noexcept { tail_ += n; }
+
+  // The payload size in the header at `pos`.
+  std::uint32_t frame_size(std::size_t pos) const noexcept {
+    const auto* p = reinterpret_cast<const unsigned char*>(in_.data() + pos);
+    return (static_cast<std::uint32_t>(p[0]) << 24) |
+           (static_cast<std::uint32_t>(p[1]) << 16) |
+           (static_cast<std::uint32_t>(p[2]) << 8) |
+           static_cast<std::uint32_t>(p[3]);
+  }
+
+  socket_t& socket_;
+  std::size_t max_frame_size_;
+  std::size_t recv_size_;
+
+  // The receive buffer, bytes in [head_, tail_) are not handed out yet.
+  std::vector<char> in_;
+  std::size_t head_;
+  std::size_t tail_;
+  std::vector<const_buffer> frames_;
+
+  // The headers and the buffer sequence of the last write.
+  std::vector<std::array<unsigned char, header_size>> headers_;
+  std::vector<const_buffer> out_;
+};
+
+namespace __epoll {
+
+// Receive until at least one complete frame is buffered, then complete with
+// all complete frames. Frames already buffered by an earlier read complete
+// the operation without touching the socket.
+template <typename ReceiverId, typename Protocol>
+class epoll_context::socket_recv_frames_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  template <typename Derived>
+  using base_op_t = stdexec::__t<
+      epoll_context::socket_io_base_op<ReceiverId, Protocol, Derived>>;
+  using socket_t = typename Protocol::socket;
+
+ public:
+  struct __t : public base_op_t<__t> {
+    using __id = socket_recv_frames_op;
+    using base_t = base_op_t<__t>;
+    friend base_t;
+
+    // Constructor.
+    constexpr __t(receiver_t receiver, framed_stream<Protocol>& stream) noexcept
+        : base_t(static_cast<receiver_t&&>(receiver), stream.socket()),
+          stream_(stream) {}
+
+   private:
+    static void non_blocking_recv(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      auto& stream = self.stream_;
+      self.ec_ = errc::success;
+      stream.frames_.clear();
+      while (true) {
+        if (!stream.extract_frames()) {
+          self.ec_ = errc::message_size;
+          return;
+        }
+        if (!stream.frames_.empty()) {
+          return;
+        }
+        mutable_buffer space;
+        try {
+          space = stream.prepare();
+        } catch (...) {
+          self.ec_ = errc::not_enough_memory;
+          return;
+        }
+        auto res =
+            self.socket_.non_blocking_recv(space.data(), space.size(), 0);
+        if (res.has_error()) {
+          self.ec_ = static_cast<system_error2::system_code&&>(res.error());
+          return;
+        }
+        if (res.value() == 0) {
+          self.ec_ = network_errc::eof;
+          return;
+        }
+        stream.commit(res.value());
+      }
+    }
+
+    static void complete(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      if (self.ec_ == errc::operation_canceled) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      } else if (self.ec_ == errc::success) {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                           self.stream_.frames());
+      } else {
+        if (self.ec_.domain() ==
+            system_error2::quick_status_code_from_enum_domain<
+                net::network_errc>) {
+          stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                             make_error_code(static_cast<net::network_errc>(
+                                 self.ec_.value())));
+        } else {
+          stdexec::set_error(
+              static_cast<receiver_t&&>(self.receiver_),
+              make_error_code(static_cast<std::errc>(self.ec_.value())));
+        }
+      }
+    }
+
+    static constexpr typename base_t::op_type otype = base_t::op_type::op_read;
+    static constexpr
+        typename base_t::op_vtable op_vtable{&non_blocking_recv, &complete};
+    framed_stream<Protocol>& stream_;
+  };
+};
+
+template <typename Protocol>
+class recv_frames_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<
+      epoll_context::socket_recv_frames_op<stdexec::__id<Receiver>, Protocol>>;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = recv_frames_sender;
+    using completion_signatures = stdexec::completion_signatures<
+        stdexec::set_value_t(std::span<const const_buffer>),
+        stdexec::set_error_t(std::error_code&&), stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.stream_};
+    }
+
+    explicit constexpr __t(framed_stream<Protocol>& stream) noexcept
+        : stream_(stream) {}
+
+   private:
+    framed_stream<Protocol>& stream_;
+  };
+};
+
+// Read the next batch of frames of `stream`. Completes with the payloads of
+// all complete frames received so far, which stay valid until the next read.
+// A peer closing the connection completes with `network_errc::eof`.
+struct async_read_frames_t {
+  template <transport_protocol Protocol>
+  constexpr auto operator()(framed_stream<Protocol>& stream) const noexcept
+      -> stdexec::__t<recv_frames_sender<Protocol>> {
+    return stdexec::__t<recv_frames_sender<Protocol>>{stream};
+  }
+};
+
+// Write `payloads` as frames of `stream`. The frames are encoded when the
+// sender is created and sent with `async_send_all`, which completes with the
+// count of bytes including the headers. The payloads must outlive the write.
+struct async_write_frames_t {
+  template <transport_protocol Protocol>
+  auto operator()(framed_stream<Protocol>& stream,
+                  std::span<const const_buffer> payloads) const {
+    return async_send_all(stream.socket(), stream.encode(payloads));
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::async_read_frames_t async_read_frames{};
+inline constexpr __epoll::async_write_frames_t async_write_frames{};
+}  // namespace net
+
+#endif  // EPOLL_FRAMED_STREAM_HPP_
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_IDLE_SWEEPER_HPP_
+#define EPOLL_IDLE_SWEEPER_HPP_
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <concepts>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+
+#include "connection_table.hpp"
+#include "epoll/epoll_context.hpp"
+#include "monotonic_clock.hpp"
+
+namespace net {
+
+// The last activity of a connection. Touching it reads the loop time of the
+// context, which costs no clock call on the io thread.
+class idle_tracker {
+ public:
+  // Constructor. The connection starts active.
+  idle_tracker() noexcept : last_activity_(monotonic_clock::now()) {}
+
+  explicit idle_tracker(epoll_context& context) noexcept
+      : last_activity_(context.loop_now()) {}
+
+  // Record activity, e.g. from the completion of a receive or a send.
+  void touch(epoll_context& context) noexcept {
+    last_activity_ = context.loop_now();
+  }
+
+  // The time of the last activity.
+  epoll_context::time_point last_activity() const noexcept {
+    return last_activity_;
+  }
+
+ private:
+  epoll_context::time_point last_activity_;
+};
+
+// Finds the connections of a table which have been idle for longer than a
+// timeout, instead of one timer per connection. Runs as a loop task of the
+// context: every `idle_timeout / 4` a pass checks the table in batches of
+// `batch_size` connections, one batch per iteration of the run loop, and
+// hands each idle connection to `handler(handle, connection&)`. The
+// connection counts as active again afterwards. The handler usually closes the
+// socket, and may erase the connection from the table.
+//
+// Only used from the io thread, or while the context is not running.
+template <typename T, typename Handler, std::size_t SlabSize = 1024>
+  requires std::derived_from<T, idle_tracker>
+class idle_sweeper : private epoll_context::loop_task {
+ public:
+  using table_t = connection_table<T, SlabSize>;
+  using handle = typename table_t::handle;
+
+  // Constructor.
+  idle_sweeper(epoll_context& context, table_t& table,
+               std::chrono::nanoseconds idle_timeout, Handler handler,
+               std::size_t batch_size = 256) noexcept
+      : context_(context),
+        table_(table),
+        idle_timeout_(idle_timeout),
+        interval_(std::max<std::chrono::nanoseconds>(
+            idle_timeout / 4, std::chrono::milliseconds(1))),
+        handler_(static_cast<Handler&&>(handler)),
+        batch_size_(std::max<std::size_t>(batch_size, 1)),
+        cursor_(0),
+        idle_count_(0),
+        running_(false) {
+    this->execute_ = &idle_sweeper::sweep;
+  }
+
+  idle_sweeper(const idle_sweeper&) = delete;
+  idle_sweeper& operator=(const idle_sweeper&) = delete;
+
+  // Destructor.
+  ~idle_sweeper() { stop(); }
+
+  // Start sweeping, the first pass begins after one interval.
+  void start() noexcept {
+    if (running_) {
+      return;
+    }
+    running_ = true;
+    cursor_ = 0;
+    this->due_ = context_.loop_now() + interval_;
+    context_.add_loop_task(this);
+  }
+
+  // Stop sweeping.
+  void stop() noexcept {
+    if (!running_) {
+      return;
+    }
+    running_ = false;
+    context_.remove_loop_task(this);
+  }
+
+  // Whether the sweeper is started.
+  bool is_running() const noexcept { return running_; }
+
+  // The count of idle connections handed to the handler.
+  std::uint64_t idle_count() const noexcept { return idle_count_; }
+
+ private:
+  static void sweep(epoll_context::loop_task* task) noexcept {
+    auto& self = static_cast<idle_sweeper&>(*task);
+    const epoll_context::time_point now = self.context_.loop_now();
+    std::size_t count = 0;
+    while (count < self.batch_size_ && self.cursor_ < self.table_.size()) {
+      const handle h = self.table_.at_position(self.cursor_);
+      T& connection = *self.table_.get(h);
+      ++count;
+      if (now - connection.last_activity() >= self.idle_timeout_) {
+        ++self.idle_count_;
+        connection.touch(self.context_);
+        self.handler_(h, connection);
+        if (self.cursor_ < self.table_.size() &&
+            !(self.table_.at_position(self.cursor_) == h)) {
+          // Erased, the last connection took its position.
+          continue;
+        }
+      }
+      ++self.cursor_;
+    }
+
+    if (self.cursor_ < self.table_.size()) {
+      // Continue in the next iteration.
+      self.due_ = now;
+    } else {
+      self.cursor_ = 0;
+      self.due_ = now + self.interval_;
+    }
+  }
+
+  epoll_context& context_;
+  table_t& table_;
+  std::chrono::nanoseconds idle_timeout_;
+  std::chrono::nanoseconds interval_;
+  Handler handler_;
+  std::size_t batch_size_;
+
+  // The position in the table the current pass continues from.
+  std::size_t cursor_;
+  std::uint64_t idle_count_;
+  bool running_;
+};
+
+}  // namespace net
+
+#endif  // EPOLL_IDLE_SWEEPER_HPP_
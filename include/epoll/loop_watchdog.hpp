@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_LOOP_WATCHDOG_HPP_
+#define EPOLL_LOOP_WATCHDOG_HPP_
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+
+#include <atomic>
+#include <cassert>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <stop_token>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "epoll/epoll_context.hpp"
+#include "latency_histogram.hpp"
+
+namespace net {
+
+// Detects iterations of the run loop which block the io thread for too long,
+// e.g. a handler doing blocking work, from a thread of its own. Every
+// `interval` it samples the heartbeat of the watched contexts: the time the
+// current iteration has been running is recorded as the loop lag, and an
+// iteration running for longer than `threshold` is reported once to the
+// stall handler along with the operation being executed. The handler runs on
+// the watchdog thread while the io thread is still stuck.
+class loop_watchdog {
+ public:
+  // A stalled iteration of the run loop.
+  struct stall {
+    epoll_context* context;
+
+    // How long the iteration had been running when it was detected.
+    std::chrono::nanoseconds duration;
+
+    // The operation being executed, or nullptr if the iteration is not
+    // executing an operation of the local queues. See `describe`.
+    epoll_context::execute_function execute;
+  };
+
+  using stall_handler = std::function<void(const stall&)>;
+
+  // Constructor. A zero `interval` samples four times per `threshold`.
+  explicit loop_watchdog(std::chrono::nanoseconds threshold,
+                         stall_handler handler = {},
+                         std::chrono::nanoseconds interval = {})
+      : threshold_(threshold),
+        interval_(interval.count() > 0 ? interval : threshold / 4),
+        handler_(std::move(handler)),
+        watched_(),
+        stall_count_(0),
+        thread_() {}
+
+  loop_watchdog(const loop_watchdog&) = delete;
+  loop_watchdog& operator=(const loop_watchdog&) = delete;
+
+  // Destructor. Stops the watchdog thread.
+  ~loop_watchdog() { stop(); }
+
+  // Watch `context`, which enables its heartbeat. Must be called before
+  // `start` and when the context is not running, the context must outlive
+  // the watchdog or its `stop`.
+  void watch(epoll_context& context) {
+    assert(!thread_.joinable());
+    context.set_heartbeat_enabled(true);
+    watched_.push_back(std::make_unique<watched>(context));
+  }
+
+  // Start the watchdog thread.
+  void start() {
+    assert(!thread_.joinable());
+    thread_ = std::jthread([this](std::stop_token token) { run(token); });
+  }
+
+  // Stop and join the watchdog thread.
+  void stop() {
+    if (thread_.joinable()) {
+      thread_.request_stop();
+      thread_.join();
+    }
+  }
+
+  // The count of stalls reported so far.
+  std::uint64_t stall_count() const noexcept {
+    return stall_count_.load(std::memory_order_relaxed);
+  }
+
+  // The loop lag samples of the `index`-th watched context. Zero lag is
+  // recorded while the loop waits for events. Can be read from any thread.
+  const latency_histogram& lag(std::size_t index = 0) const noexcept {
+    return watched_[index]->lag;
+  }
+
+  // A readable name of `execute`, the demangled symbol of the function if
+  // the binary exports it (e.g. linked with -rdynamic), otherwise its
+  // address. The symbol names the type of the operation.
+  static std::string describe(epoll_context::execute_function execute) {
+    if (execute == nullptr) {
+      return "(none)";
+    }
+    Dl_info info{};
+    const void* address = reinterpret_cast<const void*>(execute);
+    if (::dladdr(address, &info) != 0 && info.dli_sname != nullptr) {
+      int status = 0;
+      char* demangled =
+          abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+      std::string name = status == 0 ? demangled : info.dli_sname;
+      std::free(demangled);  // NOLINT
+      return name;
+    }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%p", address);
+    return buf;
+  }
+
+ private:
+  struct watched {
+    explicit watched(epoll_context& c) noexcept
+        : context(&c), lag(), reported_since() {}
+
+    epoll_context* context;
+    latency_histogram lag;
+
+    // The start of the last iteration reported, so that each stall is
+    // reported once.
+    epoll_context::time_point reported_since;
+  };
+
+  void run(std::stop_token token) {
+    std::mutex mutex;
+    std::condition_variable_any cv;
+    std::unique_lock lock{mutex};
+    while (!token.stop_requested()) {
+      cv.wait_for(lock, token, interval_, [] { return false; });
+      if (!token.stop_requested()) {
+        check();
+      }
+    }
+  }
+
+  void check() {
+    for (auto& w : watched_) {
+      const epoll_context::heartbeat beat = w->context->read_heartbeat();
+      if (!beat.busy) {
+        w->lag.record(std::chrono::nanoseconds{0});
+        continue;
+      }
+      const std::chrono::nanoseconds running =
+          w->context->now() - beat.busy_since;
+      w->lag.record(running);
+      if (running >= threshold_ && beat.busy_since != w->reported_since) {
+        w->reported_since = beat.busy_since;
+        stall_count_.fetch_add(1, std::memory_order_relaxed);
+        if (handler_) {
+          handler_(stall{w->context, running, beat.current});
+        }
+      }
+    }
+  }
+
+  std::chrono::nanoseconds threshold_;
+  std::chrono::nanoseconds interval_;
+  stall_handler handler_;
+  std::vector<std::unique_ptr<watched>> watched_;
+  std::atomic<std::uint64_t> stall_count_;
+  std::jthread thread_;
+};
+
+}  // namespace net
+
+#endif  // EPOLL_LOOP_WATCHDOG_HPP_
@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_REACTOR_POOL_HPP_
+#define EPOLL_REACTOR_POOL_HPP_
+
+#include <fcntl.h>
+#include <linux/filter.h>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <future>  // NOLINT
+#include <memory>
+#include <stdexcept>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+#include <vector>
+
+#include "status-code/system_code.hpp"
+
+#include "basic_socket_acceptor.hpp"
+#include "epoll/epoll_context.hpp"
+
+namespace net {
+namespace __epoll {
+// A thread-per-core runtime. The pool owns several epoll_contexts, each of
+// them is driven by its own io thread which is optionally pinned to a core.
+// Listening sockets are sharded with SO_REUSEPORT, so that every context
+// accepts and serves its own connections without any cross thread traffic.
+//
+// A pinned io thread is pinned before it runs its context, so the pools the
+// context fills lazily, e.g. the receive buffers and operation states, are
+// first touched on the NUMA node of its cpu.
+class reactor_pool {
+ public:
+  // Constructor. Throws an error when any context can't be created.
+  explicit reactor_pool(
+      std::size_t count = std::thread::hardware_concurrency())
+      : contexts_(), cpus_(allowed_cpus()), threads_(), next_(0) {
+    if (count == 0) {
+      count = 1;
+    }
+    contexts_.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+      contexts_.emplace_back(std::make_unique<epoll_context>());
+    }
+  }
+
+  // Destructor. Stops and joins all io threads.
+  ~reactor_pool() {
+    request_stop();
+    join();
+  }
+
+  // Start one io thread for each context. If `pin_to_cores` is true, the i-th
+  // io thread is pinned to `cpu(i)` and prefers memory of the local node.
+  // Throws an error when the pool is already running or pinning fails.
+  void run(bool pin_to_cores = true) {
+    if (!threads_.empty()) {
+      throw std::runtime_error("reactor_pool::run() called on a running pool");
+    }
+    std::vector<std::future<int>> pinned;
+    pinned.reserve(contexts_.size());
+    threads_.reserve(contexts_.size());
+    for (std::size_t i = 0; i < contexts_.size(); ++i) {
+      std::promise<int> promise;
+      pinned.push_back(promise.get_future());
+      threads_.emplace_back([&ctx = *contexts_[i],
+                             cpu = pin_to_cores ? this->cpu(i) : -1,
+                             promise = std::move(promise)]() mutable {
+        promise.set_value(cpu < 0 ? 0 : pin_current_thread(cpu));
+        ctx.run();
+      });
+    }
+    for (auto& rc : pinned) {
+      if (int error = rc.get(); error != 0) {
+        throw std::system_error{error, std::system_category(),
+                                "pthread_setaffinity_np"};
+      }
+    }
+  }
+
+  // Request all contexts to stop.
+  void request_stop() {
+    for (auto& ctx : contexts_) {
+      ctx->request_stop();
+    }
+  }
+
+  // Wait for all io threads to exit.
+  void join() {
+    for (auto& thread : threads_) {
+      if (thread.joinable()) {
+        thread.join();
+      }
+    }
+    threads_.clear();
+  }
+
+  // The count of contexts in this pool.
+  std::size_t size() const noexcept { return contexts_.size(); }
+
+  // Get the context at `index`.
+  epoll_context& context(std::size_t index) noexcept {
+    assert(index < contexts_.size());
+    return *contexts_[index];
+  }
+
+  // The cpu the io thread of the context at `index` is pinned to by `run()`,
+  // the allowed cpus in order, wrapping around. -1 if they are unknown.
+  int cpu(std::size_t index) const noexcept {
+    return cpus_.empty() ? -1 : cpus_[index % cpus_.size()];
+  }
+
+  // The index of the first context pinned to `cpu`, e.g. the one reported by
+  // `socket_base::incoming_cpu` of a connection. `size()` if there is none.
+  std::size_t index_of_cpu(int cpu) const noexcept {
+    for (std::size_t i = 0; i < contexts_.size(); ++i) {
+      if (this->cpu(i) == cpu) {
+        return i;
+      }
+    }
+    return contexts_.size();
+  }
+
+  // Get the scheduler of the next context in round-robin order.
+  epoll_context::scheduler get_scheduler() noexcept {
+    std::size_t index = next_.fetch_add(1, std::memory_order_relaxed);
+    return contexts_[index % contexts_.size()]->get_scheduler();
+  }
+
+  // Get the scheduler of the context which has the fewest registered
+  // descriptors.
+  epoll_context::scheduler get_least_loaded_scheduler() noexcept {
+    epoll_context* least = contexts_.front().get();
+    for (auto& ctx : contexts_) {
+      if (ctx->descriptor_count() < least->descriptor_count()) {
+        least = ctx.get();
+      }
+    }
+    return least->get_scheduler();
+  }
+
+  // Open one acceptor per context, all of them listening on `endpoint` with
+  // SO_REUSEPORT set. The kernel then balances incoming connections among the
+  // contexts. `ec` is assigned if any acceptor can't be opened.
+  template <typename Protocol>
+  std::vector<basic_socket_acceptor<Protocol>> make_acceptors(
+      const typename Protocol::endpoint& endpoint,
+      system_error2::system_code& ec) {
+    std::vector<basic_socket_acceptor<Protocol>> acceptors;
+    acceptors.reserve(contexts_.size());
+    for (auto& ctx : contexts_) {
+      acceptors.emplace_back(*ctx, endpoint, ec, true, true);
+      if (ec.failure()) {
+        acceptors.clear();
+        break;
+      }
+    }
+    return acceptors;
+  }
+
+  // Share the listening socket `fd`, which must already be bound and
+  // listening, among all contexts. Every context gets an acceptor on its own
+  // duplicate of `fd` registered with EPOLLEXCLUSIVE, so a new connection wakes
+  // up only one of them. Use this instead of make_acceptors() when the socket
+  // can't be re-bound, e.g. it's inherited from the service manager. The
+  // duplicates are switched to non-blocking mode, which also applies to `fd`
+  // since they share the open file description, but `fd` itself is left open.
+  // `ec` is assigned if any duplicate can't be created.
+  template <typename Protocol>
+  std::vector<basic_socket_acceptor<Protocol>> share_acceptor(
+      const Protocol& protocol, socket_base::native_handle_type fd,
+      system_error2::system_code& ec) {
+    std::vector<basic_socket_acceptor<Protocol>> acceptors;
+    acceptors.reserve(contexts_.size());
+    for (auto& ctx : contexts_) {
+      int dup_fd = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+      if (dup_fd < 0) {
+        ec = system_error2::posix_code::current();
+        acceptors.clear();
+        break;
+      }
+      auto& acceptor = acceptors.emplace_back(*ctx, protocol, dup_fd);
+      acceptor.set_exclusive_wakeup(true);
+      if (ec = acceptor.set_non_blocking(true); ec.failure()) {
+        acceptors.clear();
+        break;
+      }
+    }
+    return acceptors;
+  }
+
+  // A classic BPF program for the reuseport group of the acceptors returned
+  // by `make_acceptors()`, which maps the cpu that received a connection to
+  // the index of the context pinned to it, or `cpu % size()` for other cpus.
+  // See `basic_socket_acceptor::attach_reuseport_cbpf`.
+  std::vector<sock_filter> reuseport_cpu_program() const {
+    std::vector<sock_filter> code;
+    code.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS,
+                            static_cast<__u32>(SKF_AD_OFF + SKF_AD_CPU)));
+    for (std::size_t i = 0; i < contexts_.size() && !cpus_.empty(); ++i) {
+      code.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K,
+                              static_cast<__u32>(cpu(i)), 0, 1));
+      code.push_back(BPF_STMT(BPF_RET | BPF_K, static_cast<__u32>(i)));
+    }
+    code.push_back(BPF_STMT(BPF_ALU | BPF_MOD | BPF_K,
+                            static_cast<__u32>(contexts_.size())));
+    code.push_back(BPF_STMT(BPF_RET | BPF_A, 0));
+    return code;
+  }
+
+  // Steer the connections of the acceptors returned by `make_acceptors()` to
+  // the context whose io thread runs on the cpu that received them, which is
+  // where the NIC queue raised its interrupt. Each acceptor gets
+  // SO_INCOMING_CPU, which Linux 6.2 and later honors within the reuseport
+  // group, and the group gets `reuseport_cpu_program()`. Only useful with
+  // pinned io threads. `ec` is assigned if an option can't be set.
+  template <typename Protocol>
+  void steer_by_cpu(std::vector<basic_socket_acceptor<Protocol>>& acceptors,
+                    system_error2::system_code& ec) {
+    assert(acceptors.size() == contexts_.size());
+    if (acceptors.empty() || cpus_.empty()) {
+      return;
+    }
+    for (std::size_t i = 0; i < acceptors.size(); ++i) {
+      ec = acceptors[i].set_option(socket_base::incoming_cpu{cpu(i)});
+      if (ec.failure()) {
+        return;
+      }
+    }
+    auto code = reuseport_cpu_program();
+    ec = acceptors.front().attach_reuseport_cbpf(code.data(), code.size());
+  }
+
+ private:
+  static std::vector<int> allowed_cpus() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (::sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+      throw std::system_error{static_cast<int>(errno), std::system_category(),
+                              "sched_getaffinity"};
+    }
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &allowed)) {
+        cpus.push_back(cpu);
+      }
+    }
+    return cpus;
+  }
+
+  // Pin the calling thread to `cpu` and have it allocate from the local node,
+  // even if the process was started with another policy, e.g. interleaved.
+  // Returns the error of pinning, the memory policy is only a preference.
+  static int pin_current_thread(int cpu) noexcept {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (int rc = ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+        rc != 0) {
+      return rc;
+    }
+    ::syscall(SYS_set_mempolicy, MPOL_LOCAL, nullptr, 0UL);
+    return 0;
+  }
+
+  // The contexts. They are never moved, so that sockets can keep references
+  // to them.
+  std::vector<std::unique_ptr<epoll_context>> contexts_;
+
+  // The cpus this process is allowed to run on, in ascending order.
+  std::vector<int> cpus_;
+
+  // The io threads, one for each context.
+  std::vector<std::jthread> threads_;
+
+  // The index used by round-robin scheduling.
+  std::atomic<std::size_t> next_;
+};
+
+}  // namespace __epoll
+
+using reactor_pool = __epoll::reactor_pool;
+}  // namespace net
+
+#endif  // EPOLL_REACTOR_POOL_HPP_
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_RESOLVE_OP_HPP_
+#define EPOLL_RESOLVE_OP_HPP_
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <cerrno>
+#include <new>
+#include <string>
+#include <string_view>
+#include <system_error>  // NOLINT
+#include <vector>
+
+#include "epoll/epoll_context.hpp"
+#include "meta.hpp"
+#include "resolver_pool.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// Resolve `host` and `service` with a blocking getaddrinfo for the socket
+// type of `Protocol`, and append the IPv4 and IPv6 results to `endpoints`.
+// An empty host or service is passed as null.
+template <typename Protocol>
+std::error_code resolve_endpoints(
+    const std::string& host, const std::string& service,
+    std::vector<typename Protocol::endpoint>& endpoints) noexcept {
+  ::addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = Protocol::v4().type();
+  hints.ai_protocol = Protocol::v4().protocol();
+
+  ::addrinfo* result = nullptr;
+  const int res =
+      ::getaddrinfo(host.empty() ? nullptr : host.c_str(),
+                    service.empty() ? nullptr : service.c_str(), &hints,
+                    &result);
+  if (res != 0) {
+    return make_resolver_error_code(res, errno);
+  }
+  std::error_code ec;
+  try {
+    for (::addrinfo* ai = result; ai != nullptr; ai = ai->ai_next) {
+      if (ai->ai_family == AF_INET) {
+        endpoints.emplace_back(
+            *reinterpret_cast<const ::sockaddr_in*>(ai->ai_addr));
+      } else if (ai->ai_family == AF_INET6) {
+        endpoints.emplace_back(
+            *reinterpret_cast<const ::sockaddr_in6*>(ai->ai_addr));
+      }
+    }
+  } catch (const std::bad_alloc&) {
+    ec = std::make_error_code(std::errc::not_enough_memory);
+  }
+  ::freeaddrinfo(result);
+  return ec;
+}
+
+// Resolve a host and service name with getaddrinfo on a worker of a
+// `resolver_pool`, then schedule the completion back onto the I/O thread of
+// the context. getaddrinfo can't be interrupted, so a stop request is only
+// observed when the operation starts and when it completes.
+template <typename ReceiverId, typename Protocol>
+class epoll_context::resolve_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  using endpoint_t = typename Protocol::endpoint;
+
+ public:
+  struct __t : private operation_base, private resolver_pool::job {
+    using __id = resolve_op;
+    using stop_token = stdexec::stop_token_of_t<stdexec::env_of_t<receiver_t>&>;
+
+    __t(receiver_t receiver, epoll_context& context, resolver_pool& pool,
+        std::string host, std::string service) noexcept
+        : context_(context),
+          pool_(pool),
+          host_(static_cast<std::string&&>(host)),
+          service_(static_cast<std::string&&>(service)),
+          receiver_(static_cast<receiver_t&&>(receiver)) {
+      this->execute_ = &complete;
+      this->run_ = &resolve;
+    }
+
+    friend void tag_invoke(stdexec::start_t, __t& self) noexcept {
+      if constexpr (!std::unstoppable_token<stop_token>) {
+        if (stdexec::get_stop_token(stdexec::get_env(self.receiver_))
+                .stop_requested()) {
+          stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+          return;
+        }
+      }
+      self.pool_.submit(static_cast<resolver_pool::job*>(&self));
+    }
+
+   private:
+    // Runs on a worker of the pool.
+    static void resolve(resolver_pool::job* j) noexcept {
+      auto& self = *static_cast<__t*>(j);
+      self.ec_ = resolve_endpoints<Protocol>(self.host_, self.service_,
+                                             self.endpoints_);
+
+      // Hand the operation back to the I/O thread.
+      self.context_.schedule_impl(static_cast<operation_base*>(&self));
+    }
+
+    // Runs on the I/O thread.
+    static void complete(operation_base* op) noexcept {
+      auto& self = *static_cast<__t*>(op);
+      if constexpr (!std::unstoppable_token<stop_token>) {
+        if (stdexec::get_stop_token(stdexec::get_env(self.receiver_))
+                .stop_requested()) {
+          stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+          return;
+        }
+      }
+      if (self.ec_) {
+        stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                           static_cast<std::error_code&&>(self.ec_));
+      } else {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                           static_cast<std::vector<endpoint_t>&&>(
+                               self.endpoints_));
+      }
+    }
+
+    epoll_context& context_;
+    resolver_pool& pool_;
+    std::string host_;
+    std::string service_;
+    std::error_code ec_;
+    std::vector<endpoint_t> endpoints_;
+    STDEXEC_NO_UNIQUE_ADDRESS receiver_t receiver_;
+  };
+};
+
+template <typename Protocol>
+class resolve_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<
+      epoll_context::resolve_op<stdexec::__id<Receiver>, Protocol>>;
+  using endpoint_t = typename Protocol::endpoint;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = resolve_sender;
+    using completion_signatures = stdexec::completion_signatures<
+        stdexec::set_value_t(std::vector<endpoint_t>),
+        stdexec::set_error_t(std::error_code&&), stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.context_, self.pool_,
+              static_cast<Sender&&>(self).host_,
+              static_cast<Sender&&>(self).service_};
+    }
+
+    __t(epoll_context& context, resolver_pool& pool, std::string_view host,
+        std::string_view service)
+        : context_(context), pool_(pool), host_(host), service_(service) {}
+
+   private:
+    epoll_context& context_;
+    resolver_pool& pool_;
+    std::string host_;
+    std::string service_;
+  };
+};
+
+// Resolve `host` and `service` to the endpoints of `Protocol`, in the order
+// getaddrinfo returns them, without blocking the I/O thread of `context`. An
+// empty host or service is passed to getaddrinfo as null. Fails with an error
+// of `resolver_category()`, or of the system category for `EAI_SYSTEM`.
+template <transport_protocol Protocol>
+struct async_resolve_t {
+  auto operator()(epoll_context& context, std::string_view host,
+                  std::string_view service) const
+      -> stdexec::__t<resolve_sender<Protocol>> {
+    return {context, resolver_pool::shared(), host, service};
+  }
+
+  // Run getaddrinfo on the workers of `pool` rather than the shared pool.
+  auto operator()(epoll_context& context, resolver_pool& pool,
+                  std::string_view host, std::string_view service) const
+      -> stdexec::__t<resolve_sender<Protocol>> {
+    return {context, pool, host, service};
+  }
+};
+}  // namespace __epoll
+
+template <transport_protocol Protocol>
+inline constexpr __epoll::async_resolve_t<Protocol> async_resolve{};
+}  // namespace net
+
+#endif  // EPOLL_RESOLVE_OP_HPP_
@@ -0,0 +1,416 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_RESOLVER_CACHE_HPP_
+#define EPOLL_RESOLVER_CACHE_HPP_
+
+#include <cassert>
+#include <chrono>        // NOLINT
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "epoll/epoll_context.hpp"
+#include "epoll/resolve_op.hpp"
+#include "meta.hpp"
+#include "monotonic_clock.hpp"
+#include "resolver_pool.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// A cache of resolver results owned by one context and only touched on its
+// I/O thread, so it needs no lock; a `reactor_pool` gives each context its
+// own. getaddrinfo doesn't report the TTLs of the records, so results are
+// kept for a fixed `ttl`, and failures for `negative_ttl`. Concurrent lookups
+// of a name which isn't cached share a single getaddrinfo call.
+//
+// Lookups waiting for a result can't be stopped early, a stop request is
+// observed when they complete. The cache must outlive its lookups.
+template <typename Protocol>
+class epoll_context::resolver_cache {
+ public:
+  using endpoint_type = typename Protocol::endpoint;
+
+  // The cached endpoints, shared by every lookup that hits them.
+  using results_type = std::shared_ptr<const std::vector<endpoint_type>>;
+
+  using duration = monotonic_clock::duration;
+
+  struct options {
+    // How long resolved endpoints are kept, zero disables caching them.
+    duration ttl = std::chrono::seconds(30);
+
+    // How long failures are kept, zero disables negative caching.
+    duration negative_ttl = std::chrono::seconds(5);
+
+    // The count of names beyond which expired and then arbitrary entries are
+    // evicted to make room.
+    std::size_t max_entries = 4096;
+  };
+
+  struct statistics {
+    // Lookups answered with cached endpoints.
+    std::uint64_t hits = 0;
+
+    // Lookups answered with a cached failure.
+    std::uint64_t negative_hits = 0;
+
+    // Lookups which started a getaddrinfo call.
+    std::uint64_t misses = 0;
+
+    // Lookups which joined a getaddrinfo call already in flight.
+    std::uint64_t coalesced = 0;
+
+    // Entries evicted before they expired to make room.
+    std::uint64_t evictions = 0;
+  };
+
+  // A lookup of a name.
+  struct waiter : completion_op {
+    // Notify the receiver of the result.
+    void (*complete_)(waiter*, const results_type& results,
+                      std::error_code ec) noexcept;
+
+    // The host and service, separated by a null character.
+    std::string key_;
+
+    resolver_cache* owner_ = nullptr;
+    waiter* next_waiter_ = nullptr;
+  };
+
+  // Constructor. getaddrinfo runs on the workers of `pool`.
+  explicit resolver_cache(epoll_context& context, options opts = {})
+      : resolver_cache(context, resolver_pool::shared(), opts) {}
+
+  resolver_cache(epoll_context& context, resolver_pool& pool,
+                 options opts = {})
+      : context_(context), pool_(pool), options_(opts), stats_() {}
+
+  resolver_cache(const resolver_cache&) = delete;
+  resolver_cache& operator=(const resolver_cache&) = delete;
+
+  // Destructor.
+  ~resolver_cache() {
+    for ([[maybe_unused]] auto& [key, e] : entries_) {
+      assert(e.fetch_ == nullptr);
+    }
+  }
+
+  // The context this cache belongs to.
+  epoll_context& context() noexcept { return context_; }
+
+  // The count of cached and in-flight names. Must be called on the I/O
+  // thread.
+  std::size_t size() const noexcept { return entries_.size(); }
+
+  // Get the statistics. Must be called on the I/O thread.
+  statistics stats() const noexcept { return stats_; }
+
+  // Drop every cached result, names being resolved are kept. Must be called
+  // on the I/O thread.
+  void clear() noexcept {
+    std::erase_if(entries_, [](const auto& item) {
+      return item.second.fetch_ == nullptr;
+    });
+  }
+
+  // Look a name up. Started off the I/O thread, the lookup is handed to it
+  // first.
+  void lookup(waiter* w) noexcept {
+    w->owner_ = this;
+    if (context_.can_run_inline()) {
+      epoll_context::inline_scope scope{context_};
+      find(w);
+    } else {
+      w->execute_ = [](operation_base* op) noexcept {
+        auto* w = static_cast<waiter*>(static_cast<completion_op*>(op));
+        w->owner_->find(w);
+      };
+      context_.schedule_impl(w);
+    }
+  }
+
+ private:
+  struct fetch;
+
+  struct entry {
+    results_type results_;
+    std::error_code ec_;
+    time_point expiry_;
+
+    // The getaddrinfo call in flight for this name, if any.
+    fetch* fetch_ = nullptr;
+  };
+
+  // One getaddrinfo call and the lookups waiting for it.
+  struct fetch : completion_op, resolver_pool::job {
+    fetch(resolver_cache& cache, std::string key) noexcept
+        : cache_(cache), key_(static_cast<std::string&&>(key)) {
+      this->run_ = [](resolver_pool::job* j) noexcept {
+        auto& self = *static_cast<fetch*>(j);
+        const std::size_t split = self.key_.find('\0');
+        self.ec_ = resolve_endpoints<Protocol>(self.key_.substr(0, split),
+                                               self.key_.substr(split + 1),
+                                               self.endpoints_);
+        self.cache_.context_.schedule_impl(
+            static_cast<completion_op*>(&self));
+      };
+      this->execute_ = [](operation_base* op) noexcept {
+        auto* self = static_cast<fetch*>(static_cast<completion_op*>(op));
+        self->cache_.store(self);
+      };
+    }
+
+    resolver_cache& cache_;
+    std::string key_;
+    waiter* head_ = nullptr;
+    waiter* tail_ = nullptr;
+    std::vector<endpoint_type> endpoints_;
+    std::error_code ec_;
+  };
+
+  // Answer `w` from the cache, or wait for a getaddrinfo call.
+  void find(waiter* w) noexcept {
+    auto it = entries_.find(w->key_);
+    if (it != entries_.end()) {
+      entry& e = it->second;
+      if (e.fetch_ != nullptr) {
+        ++stats_.coalesced;
+        enqueue(e.fetch_, w);
+        return;
+      }
+      if (context_.loop_now() < e.expiry_) {
+        ++(e.ec_ ? stats_.negative_hits : stats_.hits);
+        results_type results = e.results_;
+        w->complete_(w, results, e.ec_);
+        return;
+      }
+    }
+
+    ++stats_.misses;
+    fetch* f = nullptr;
+    try {
+      if (it == entries_.end()) {
+        make_room();
+        it = entries_.try_emplace(w->key_).first;
+      }
+      f = new fetch(*this, w->key_);
+    } catch (...) {
+      // An entry left without a result counts as expired.
+      w->complete_(w, nullptr,
+                   std::make_error_code(std::errc::not_enough_memory));
+      return;
+    }
+    it->second.fetch_ = f;
+    enqueue(f, w);
+    pool_.submit(f);
+  }
+
+  static void enqueue(fetch* f, waiter* w) noexcept {
+    w->next_waiter_ = nullptr;
+    if (f->tail_ == nullptr) {
+      f->head_ = w;
+    } else {
+      f->tail_->next_waiter_ = w;
+    }
+    f->tail_ = w;
+  }
+
+  // Keep the result of `f` and complete the lookups waiting for it.
+  void store(fetch* f) noexcept {
+    std::unique_ptr<fetch> owner{f};
+    results_type results;
+    if (!f->ec_) {
+      try {
+        results = std::make_shared<const std::vector<endpoint_type>>(
+            static_cast<std::vector<endpoint_type>&&>(f->endpoints_));
+      } catch (...) {
+        f->ec_ = std::make_error_code(std::errc::not_enough_memory);
+      }
+    }
+
+    auto it = entries_.find(f->key_);
+    assert(it != entries_.end() && it->second.fetch_ == f);
+    const duration ttl = f->ec_ ? options_.negative_ttl : options_.ttl;
+    if (ttl > duration::zero()) {
+      it->second = entry{results, f->ec_, context_.loop_now() + ttl, nullptr};
+    } else {
+      entries_.erase(it);
+    }
+
+    // A completion may start another lookup, which must not see this fetch.
+    const std::error_code ec = f->ec_;
+    waiter* w = f->head_;
+    owner.reset();
+    while (w != nullptr) {
+      waiter* next = w->next_waiter_;
+      w->complete_(w, results, ec);
+      w = next;
+    }
+  }
+
+  // Evict entries until a new one fits.
+  void make_room() noexcept {
+    if (entries_.size() < options_.max_entries) {
+      return;
+    }
+    const time_point now = context_.loop_now();
+    std::erase_if(entries_, [now](const auto& item) {
+      return item.second.fetch_ == nullptr && !(now < item.second.expiry_);
+    });
+    for (auto it = entries_.begin();
+         entries_.size() >= options_.max_entries && it != entries_.end();) {
+      if (it->second.fetch_ == nullptr) {
+        it = entries_.erase(it);
+        ++stats_.evictions;
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  epoll_context& context_;
+  resolver_pool& pool_;
+  options options_;
+  statistics stats_;
+  std::unordered_map<std::string, entry> entries_;
+};
+
+template <typename ReceiverId, typename Protocol>
+class epoll_context::resolve_cached_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  using cache_t = epoll_context::resolver_cache<Protocol>;
+  using results_t = typename cache_t::results_type;
+
+ public:
+  struct __t : private cache_t::waiter {
+    using __id = resolve_cached_op;
+    using stop_token = stdexec::stop_token_of_t<stdexec::env_of_t<receiver_t>&>;
+
+    __t(receiver_t receiver, cache_t& cache, std::string key) noexcept
+        : cache_(cache), receiver_(static_cast<receiver_t&&>(receiver)) {
+      this->key_ = static_cast<std::string&&>(key);
+      this->complete_ = &complete;
+    }
+
+    friend void tag_invoke(stdexec::start_t, __t& self) noexcept {
+      if constexpr (!std::unstoppable_token<stop_token>) {
+        if (stdexec::get_stop_token(stdexec::get_env(self.receiver_))
+                .stop_requested()) {
+          stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+          return;
+        }
+      }
+      self.cache_.lookup(&self);
+    }
+
+   private:
+    static void complete(typename cache_t::waiter* w,
+                         const results_t& results,
+                         std::error_code ec) noexcept {
+      auto& self = *static_cast<__t*>(w);
+      if constexpr (!std::unstoppable_token<stop_token>) {
+        if (stdexec::get_stop_token(stdexec::get_env(self.receiver_))
+                .stop_requested()) {
+          stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+          return;
+        }
+      }
+      if (ec) {
+        stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                           static_cast<std::error_code&&>(ec));
+      } else {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                           results_t{results});
+      }
+    }
+
+    cache_t& cache_;
+    STDEXEC_NO_UNIQUE_ADDRESS receiver_t receiver_;
+  };
+};
+
+template <typename Protocol>
+class resolve_cached_sender {
+  using cache_t = epoll_context::resolver_cache<Protocol>;
+  template <typename Receiver>
+  using op_t = stdexec::__t<
+      epoll_context::resolve_cached_op<stdexec::__id<Receiver>, Protocol>>;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = resolve_cached_sender;
+    using completion_signatures = stdexec::completion_signatures<
+        stdexec::set_value_t(typename cache_t::results_type),
+        stdexec::set_error_t(std::error_code&&), stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.cache_,
+              static_cast<Sender&&>(self).key_};
+    }
+
+    __t(cache_t& cache, std::string_view host, std::string_view service)
+        : cache_(cache) {
+      key_.reserve(host.size() + service.size() + 1);
+      key_.append(host).push_back('\0');
+      key_.append(service);
+    }
+
+   private:
+    cache_t& cache_;
+    std::string key_;
+  };
+};
+
+// Resolve `host` and `service` through `cache`, completing with the shared
+// endpoints. Like `async_resolve`, but a name resolved within the TTL of the
+// cache completes without leaving the I/O thread.
+struct async_resolve_cached_t {
+  template <transport_protocol Protocol>
+  auto operator()(epoll_context::resolver_cache<Protocol>& cache,
+                  std::string_view host, std::string_view service) const
+      -> stdexec::__t<resolve_cached_sender<Protocol>> {
+    return {cache, host, service};
+  }
+};
+}  // namespace __epoll
+
+template <typename Protocol>
+using resolver_cache = __epoll::epoll_context::resolver_cache<Protocol>;
+
+inline constexpr __epoll::async_resolve_cached_t async_resolve_cached{};
+}  // namespace net
+
+#endif  // EPOLL_RESOLVER_CACHE_HPP_
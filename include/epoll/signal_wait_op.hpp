@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef EPOLL_SIGNAL_WAIT_OP_HPP_
+#define EPOLL_SIGNAL_WAIT_OP_HPP_
+
+#include <signal.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <initializer_list>
+#include <system_error>  // NOLINT
+
+#include "status-code/system_code.hpp"
+
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_io_base_op.hpp"
+#include "error_channel.hpp"
+#include "posix/stream_descriptor.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// Wait for one of a set of signals through a signalfd registered to the
+// epoll set of the context, and complete with its number on the io thread.
+// The signals must be blocked in every thread of the process, e.g. with
+// pthread_sigmask in main() before any thread is started, otherwise they
+// are delivered the usual way instead.
+//
+// The wait doesn't hold up a drain, it's canceled as soon as the drain
+// begins. Several waits may be pending, each signal completes only one of
+// them.
+template <typename ReceiverId>
+class epoll_context::signal_wait_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  template <typename Derived>
+  using base_op_t = stdexec::__t<epoll_context::socket_io_base_op<
+      ReceiverId, void, Derived, posix::stream_descriptor>>;
+
+  // The signalfd, a base so that it's constructed before the I/O base which
+  // takes its context.
+  struct signal_descriptor {
+    posix::stream_descriptor descriptor_;
+  };
+
+ public:
+  struct __t : private signal_descriptor, public base_op_t<__t> {
+    using __id = signal_wait_op;
+    using base_t = base_op_t<__t>;
+    friend base_t;
+
+    // Constructor.
+    __t(receiver_t receiver, epoll_context& context,
+        const ::sigset_t& signals) noexcept
+        : signal_descriptor{posix::stream_descriptor(context)},
+          base_t(static_cast<receiver_t&&>(receiver),
+                 signal_descriptor::descriptor_),
+          signals_(signals),
+          signal_(0) {}
+
+   private:
+    // Read a pending signal. The signalfd is created by the first attempt,
+    // on the io thread.
+    static void receive(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      auto& descriptor = self.socket_;
+      if (!descriptor.is_open()) {
+        int fd = ::signalfd(-1, &self.signals_, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (fd < 0) {
+          self.ec_ =
+              system_error2::system_code{system_error2::posix_code::current()};
+          return;
+        }
+        descriptor.assign(fd);
+      }
+      ::signalfd_siginfo info;
+      while (true) {
+        ::ssize_t n = ::read(descriptor.native_handle(), &info, sizeof(info));
+        if (n == static_cast<::ssize_t>(sizeof(info))) {
+          self.signal_ = static_cast<int>(info.ssi_signo);
+          self.ec_ = errc::success;
+          return;
+        }
+        if (n < 0 && errno == EINTR) {
+          continue;
+        }
+        if (n < 0) {
+          self.ec_ =
+              system_error2::system_code{system_error2::posix_code::current()};
+        } else {
+          self.ec_ = errc::operation_would_block;
+        }
+        return;
+      }
+    }
+
+    // Release the signalfd before the receiver may destroy this operation.
+    // A stopped wait releases it when it's destroyed.
+    static void complete(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      self.socket_.close();
+      if (self.ec_ == errc::operation_canceled) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      } else if (self.ec_ == errc::success) {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                           self.signal_);
+      } else {
+        stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                           to_error<std::error_code>(self.ec_));
+      }
+    }
+
+    static constexpr typename base_t::op_type otype = base_t::op_type::op_read;
+    static constexpr typename base_t::op_vtable op_vtable{&receive, &complete};
+    static constexpr bool background = true;
+    ::sigset_t signals_;
+    int signal_;
+  };
+};
+
+class signal_wait_sender {
+  template <typename Receiver>
+  using op_t =
+      stdexec::__t<epoll_context::signal_wait_op<stdexec::__id<Receiver>>>;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = signal_wait_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(int),
+                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.context_,
+              self.signals_};
+    }
+
+    __t(epoll_context& context, const ::sigset_t& signals) noexcept
+        : context_(context), signals_(signals) {}
+
+   private:
+    epoll_context& context_;
+    ::sigset_t signals_;
+  };
+};
+
+// Wait on `context` for one of `signals`, e.g. {SIGTERM, SIGHUP}, completing
+// with the number of the signal received.
+struct async_wait_signal_t {
+  auto operator()(epoll_context& context,
+                  std::initializer_list<int> signals) const noexcept
+      -> stdexec::__t<signal_wait_sender> {
+    ::sigset_t set;
+    ::sigemptyset(&set);
+    for (int signo : signals) {
+      ::sigaddset(&set, signo);
+    }
+    return {context, set};
+  }
+
+  auto operator()(epoll_context& context, const ::sigset_t& signals) const
+      noexcept -> stdexec::__t<signal_wait_sender> {
+    return {context, signals};
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::async_wait_signal_t async_wait_signal{};
+}  // namespace net
+
+#endif  // EPOLL_SIGNAL_WAIT_OP_HPP_
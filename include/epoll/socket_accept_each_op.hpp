@@ -0,0 +1,412 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_SOCKET_ACCEPT_EACH_OP_HPP_
+#define EPOLL_SOCKET_ACCEPT_EACH_OP_HPP_
+
+#include <sys/socket.h>
+
+#include <cassert>
+#include <concepts>      // NOLINT
+#include <functional>
+#include <system_error>  // NOLINT
+#include <type_traits>
+#include <utility>
+
+#include "status-code/system_code.hpp"
+
+#include "basic_socket_acceptor.hpp"
+#include "epoll/admission_control.hpp"
+#include "epoll/epoll_context.hpp"
+#include "meta.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// A multi-shot accept. The operation is parked on the descriptor state of the
+// acceptor once and re-parked after each wakeup, every accepted connection is
+// passed to the handler on the io thread. If the handler returns a bool,
+// returning false completes the operation with set_value. Otherwise the
+// operation only completes when stopped or when accept fails.
+//
+// With an `admission_control`, the load of the context is checked before each
+// accept. While overloaded, the operation either pauses as a loop task of the
+// context instead of accepting, or resets the connections it accepts.
+// Connections its peer filter refuses are reset as well.
+template <typename ReceiverId, typename Protocol, typename Handler>
+class epoll_context::socket_accept_each_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  using acceptor_t = basic_socket_acceptor<Protocol>;
+  using socket_t = typename Protocol::socket;
+  using stop_token = stdexec::stop_token_of_t<stdexec::env_of_t<receiver_t>>;
+
+ public:
+  struct __t : public stdexec::__immovable,
+               private epoll_context::completion_op,
+               private epoll_context::stop_op,
+               private epoll_context::loop_task {
+    using __id = socket_accept_each_op;
+
+    // Constructor.
+    constexpr __t(receiver_t receiver, acceptor_t& acceptor, Handler handler,
+                  admission_control* admission) noexcept
+        : receiver_(static_cast<receiver_t&&>(receiver)),
+          acceptor_(acceptor),
+          context_(static_cast<epoll_context&>(acceptor.context())),
+          handler_(static_cast<Handler&&>(handler)),
+          admission_(admission),
+          paused_(false),
+          state_(0),
+          ec_(errc::success),
+          stop_callback_() {}
+
+    friend void tag_invoke(stdexec::start_t, __t& self) noexcept {
+      self.start_impl();
+    }
+
+   private:
+    void start_impl() noexcept {
+      if (!context_.is_running_on_io_thread()) {
+        static_cast<completion_op*>(this)->execute_ =
+            &__t::on_schedule_complete;
+        context_.schedule_remote(static_cast<completion_op*>(this));
+      } else {
+        perform();
+      }
+    }
+
+    // epoll_context starts to execute this operation in the io thread.
+    static void on_schedule_complete(operation_base* op) noexcept {
+      static_cast<__t*>(static_cast<completion_op*>(op))->perform();
+    }
+
+    // This function is not thread safe, it must be executed in io thread.
+    void perform() noexcept {
+      assert(context_.is_running_on_io_thread());
+      if (admission_ != nullptr &&
+          admission_->get_options().max_loop_lag.count() > 0) {
+        context_.set_heartbeat_enabled(true);
+      }
+      if (accept_all() && wait_for_more()) {
+        return;
+      }
+      finish();
+    }
+
+    // Handle epoll event.
+    static void wakeup(operation_base* op) noexcept {
+      static_cast<__t*>(static_cast<completion_op*>(op))->resume();
+    }
+
+    // The pause is over.
+    static void on_pause_end(loop_task* task) noexcept {
+      auto& self = *static_cast<__t*>(task);
+      self.context_.remove_loop_task(task);
+      self.paused_ = false;
+      self.resume();
+    }
+
+    void resume() noexcept {
+      if constexpr (!stdexec::unstoppable_token<stop_token>) {
+        stop_callback_.__destruct();
+      }
+      // A closed acceptor or a drain cancels the operation.
+      if (descriptor_canceled(acceptor_.descriptor_data())) {
+        ec_ = errc::operation_canceled;
+      } else if ((state_.load(std::memory_order_acquire) &
+                  request_stopped_mask) == 0) {
+        if (accept_all() && wait_for_more()) {
+          return;
+        }
+      }
+      finish();
+    }
+
+    // Complete the operation unless a remote thread has requested to stop it,
+    // in which case the stop operation completes it.
+    void finish() noexcept {
+      auto old_state =
+          state_.fetch_add(operation_ended, std::memory_order_acq_rel);
+      if ((old_state & request_stopped_mask) != 0) {
+        return;
+      }
+      complete();
+    }
+
+    // Accept all waiting connections. Returns true if the operation should
+    // wait for more connections or for the end of a pause, otherwise `ec_`
+    // tells how to complete.
+    bool accept_all() noexcept {
+      while (true) {
+        const bool reject = admission_ != nullptr &&
+                            admission_->overloaded(context_);
+        if (reject && admission_->get_options().on_overload ==
+                          admission_control::action::pause) {
+          admission_->count_pause();
+          paused_ = true;
+          return true;
+        }
+        const bool filter = admission_ != nullptr &&
+                            admission_->get_options().peer_filter != nullptr;
+        ::sockaddr_storage peer;
+        ::socklen_t peer_size = 0;
+        auto res = acceptor_.non_blocking_accept(SOCK_NONBLOCK | SOCK_CLOEXEC,
+                                                 filter ? &peer : nullptr,
+                                                 &peer_size);
+        if (res.has_value()) {
+          if (reject) {
+            reset(res.value());
+            admission_->count_rejected();
+            continue;
+          }
+          if (filter && !admission_->admits(peer, peer_size)) {
+            reset(res.value());
+            admission_->count_filtered();
+            continue;
+          }
+          if (admission_ != nullptr) {
+            admission_->count_admitted();
+          }
+          if (!deliver(static_cast<socket_t&&>(res.value()))) {
+            ec_ = errc::success;
+            return false;
+          }
+          continue;
+        }
+        ec_ = static_cast<system_error2::system_code&&>(res.error());
+        if (ec_ == errc::resource_unavailable_try_again ||
+            ec_ == errc::operation_would_block) {
+          return true;
+        }
+        if (ec_ == errc::connection_aborted || ec_ == errc::protocol_error) {
+          // The peer gave up before we accepted it, try the next one.
+          continue;
+        }
+        return false;
+      }
+    }
+
+    // Close a connection with a reset instead of a graceful shutdown, so the
+    // peer fails fast and no state lingers.
+    void reset(socket_t& socket) noexcept {
+      (void)socket.set_option(socket_base::linger{true, 0});
+      (void)socket.close();
+    }
+
+    // Park on the acceptor, or wait as a loop task until the pause is over.
+    bool wait_for_more() noexcept {
+      if (!paused_) {
+        return start_waiting();
+      }
+      if constexpr (!stdexec::unstoppable_token<stop_token>) {
+        stop_callback_.__construct(
+            stdexec::get_stop_token(stdexec::get_env(receiver_)),
+            cancel_callback{*this});
+      }
+      static_cast<loop_task*>(this)->due_ =
+          context_.loop_now() + admission_->get_options().pause_time;
+      static_cast<loop_task*>(this)->execute_ = &__t::on_pause_end;
+      context_.add_loop_task(this);
+      return true;
+    }
+
+    // Pass the connection to the handler. Returns false if the handler asks to
+    // stop accepting.
+    bool deliver(socket_t&& socket) noexcept {
+      using result_t = std::invoke_result_t<Handler&, socket_t&&>;
+      if constexpr (std::is_void_v<result_t>) {
+        std::invoke(handler_, static_cast<socket_t&&>(socket));
+        return true;
+      } else {
+        return static_cast<bool>(
+            std::invoke(handler_, static_cast<socket_t&&>(socket)));
+      }
+    }
+
+    void complete() noexcept {
+      if (ec_ == errc::operation_canceled) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(receiver_));
+      } else if (ec_ == errc::success) {
+        stdexec::set_value(static_cast<receiver_t&&>(receiver_));
+      } else {
+        std::error_code ec{static_cast<int>(ec_.value()),
+                           std::system_category()};
+        stdexec::set_error(static_cast<receiver_t&&>(receiver_),
+                           static_cast<std::error_code&&>(ec));
+      }
+    }
+
+    // Send the stopped signal to the downstream receiver.
+    static void complete_with_stop(operation_base* op) noexcept {
+      auto& self = *static_cast<__t*>(static_cast<stop_op*>(op));
+      if (!static_cast<completion_op&>(self).enqueued_.load()) {
+        self.stop_waiting();
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      } else {
+        // Wait for the pending wakeup to observe the stop request first.
+        static_cast<stop_op&>(self).execute_ = &complete_with_stop;
+        self.context_.schedule_local(static_cast<stop_op*>(op));
+      }
+    }
+
+    // The remote thread requests that this operation should be stopped.
+    void request_stop() noexcept {
+      auto old_state =
+          state_.fetch_add(request_stopped, std::memory_order_acq_rel);
+      if ((old_state & operation_ended_mask) == 0) {
+        static_cast<stop_op*>(this)->execute_ = &complete_with_stop;
+        context_.schedule_remote(static_cast<stop_op*>(this));
+      }
+    }
+
+    // Park this operation on the descriptor state of the acceptor. Returns
+    // false and assigns `ec_` if it can't be parked.
+    bool start_waiting() noexcept {
+      ec_ = errc::success;
+      descriptor_state* state = context_.register_descriptor(
+          acceptor_.native_handle(), acceptor_.descriptor_data(), ec_,
+          acceptor_.is_exclusive_wakeup());
+      if (state == nullptr) {
+        return false;
+      }
+      if (!state->park(descriptor_state::read_slot,
+                       static_cast<completion_op*>(this))) {
+        ec_ = errc::device_or_resource_busy;
+        return false;
+      }
+      if constexpr (!stdexec::unstoppable_token<stop_token>) {
+        stop_callback_.__construct(
+            stdexec::get_stop_token(stdexec::get_env(receiver_)),
+            cancel_callback{*this});
+      }
+      static_cast<completion_op*>(this)->execute_ = wakeup;
+      return true;
+    }
+
+    // Take this operation out of its descriptor slot if it's still parked,
+    // or out of the loop tasks if it's paused.
+    void stop_waiting() noexcept {
+      if (std::exchange(paused_, false)) {
+        context_.remove_loop_task(this);
+      } else if (void* data = acceptor_.descriptor_data()) {
+        static_cast<descriptor_state*>(data)->unpark(
+            descriptor_state::read_slot, static_cast<completion_op*>(this));
+      }
+    }
+
+    // Use theses to synchronize the remote thread and the io thread.
+    static constexpr uint32_t operation_ended = 0x00010000;
+    static constexpr uint32_t operation_ended_mask = 0xFFFF0000;
+    static constexpr uint32_t request_stopped = 0x1;
+    static constexpr uint32_t request_stopped_mask = 0xFFFF;
+
+    // The cancel callback.
+    struct cancel_callback {
+      __t& op_;
+
+      void operator()() noexcept { op_.request_stop(); }
+    };
+
+    // The data members.
+    receiver_t receiver_;
+    acceptor_t& acceptor_;
+    epoll_context& context_;
+    Handler handler_;
+    admission_control* admission_;
+    bool paused_;
+    std::atomic<uint32_t> state_;
+    system_error2::system_code ec_;
+    exec::__manual_lifetime<
+        typename stop_token::template callback_type<cancel_callback>>
+        stop_callback_;
+  };
+};
+
+template <typename Protocol, typename Handler>
+class accept_each_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<epoll_context::socket_accept_each_op<
+      stdexec::__id<Receiver>, Protocol, Handler>>;
+  using acceptor_t = basic_socket_acceptor<Protocol>;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = accept_each_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(),
+                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t,
+                           const __t& self, Env) -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.acceptor_,
+              static_cast<Sender&&>(self).handler_, self.admission_};
+    }
+
+    // Constructors.
+    constexpr __t(acceptor_t& acceptor, Handler handler,
+                  admission_control* admission = nullptr)
+        : acceptor_(acceptor),
+          handler_(static_cast<Handler&&>(handler)),
+          admission_(admission) {}
+
+   private:
+    acceptor_t& acceptor_;
+    Handler handler_;
+    admission_control* admission_;
+  };
+};
+
+// Accept connections one after another, calling `handler` with each of them
+// on the io thread. The acceptor stays parked between connections.
+struct async_accept_each_t {
+  template <transport_protocol Protocol, typename Handler>
+    requires std::invocable<std::decay_t<Handler>&, typename Protocol::socket&&>
+  constexpr auto operator()(basic_socket_acceptor<Protocol>& acceptor,
+                            Handler&& handler) const noexcept
+      -> stdexec::__t<accept_each_sender<Protocol, std::decay_t<Handler>>> {
+    return {acceptor, static_cast<Handler&&>(handler)};
+  }
+
+  // The same, shedding load as `admission` tells while the context is
+  // overloaded. `admission` must outlive the operation.
+  template <transport_protocol Protocol, typename Handler>
+    requires std::invocable<std::decay_t<Handler>&, typename Protocol::socket&&>
+  constexpr auto operator()(basic_socket_acceptor<Protocol>& acceptor,
+                            admission_control& admission,
+                            Handler&& handler) const noexcept
+      -> stdexec::__t<accept_each_sender<Protocol, std::decay_t<Handler>>> {
+    return {acceptor, static_cast<Handler&&>(handler), &admission};
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::async_accept_each_t async_accept_each{};
+}  // namespace net
+
+#endif  // EPOLL_SOCKET_ACCEPT_EACH_OP_HPP_
@@ -16,244 +16,131 @@
 #ifndef EPOLL_SOCKET_ACCEPT_OP_HPP_
 #define EPOLL_SOCKET_ACCEPT_OP_HPP_
 
-#include <cassert>
-#include <concepts>  // NOLINT
+#include <sys/socket.h>
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
 
 #include "basic_socket_acceptor.hpp"
 #include "epoll/epoll_context.hpp"
+#include "epoll/socket_io_base_op.hpp"
+#include "error_channel.hpp"
 #include "meta.hpp"
-#include "socket_option.hpp"
 #include "status-code/system_code.hpp"
 #include "stdexec.hpp"
 
 namespace net {
 namespace __epoll {
 
-template <typename ReceiverId, typename Protocol>
+// Accepts on top of `socket_io_base_op`, which owns the state machine: the
+// acceptor is the descriptor owner and the operation waits on its read slot.
+template <typename ReceiverId, typename Protocol, bool Many, typename Error>
 class epoll_context::socket_accept_op {
   using receiver_t = stdexec::__t<ReceiverId>;
   using acceptor_t = basic_socket_acceptor<Protocol>;
+  template <typename Derived>
+  using base_op_t = stdexec::__t<epoll_context::socket_io_base_op<
+      ReceiverId, Protocol, Derived, acceptor_t>>;
   using socket_t = typename Protocol::socket;
-  using endpoint_t = typename Protocol::endpoint;
-  using stop_token = stdexec::stop_token_of_t<stdexec::env_of_t<receiver_t>>;
+  // A single accept stores one socket, `Many` a vector of them.
+  using accepted_t = std::conditional_t<Many, std::vector<socket_t>, socket_t>;
 
  public:
-  struct __t : public stdexec::__immovable,
-               private epoll_context::completion_op,
-               private epoll_context::stop_op {
+  struct __t : public base_op_t<__t> {
     using __id = socket_accept_op;
+    using base_t = base_op_t<__t>;
+    friend base_t;
 
-    // Constructor.
-    constexpr __t(receiver_t receiver, acceptor_t& acceptor) noexcept
-        : receiver_(static_cast<receiver_t&&>(receiver)),
-          acceptor_(acceptor),
-          context_(static_cast<epoll_context&>(acceptor.context())),
-          socket_(context_),
-          state_(0),
-          ec_(errc::success),
-          stop_callback_() {}
-
-    // `start` customization point object.
-    // The operation is submitted to the corresponding queue based on the thread
-    // that submitted it. The start operation is non-blocking and deep recursive
-    // safe.
-    friend void tag_invoke(stdexec::start_t, __t& self) noexcept {
-      self.start_impl();
-    }
+    // Constructor. `max_count` is the most connections accepted at once,
+    // only used if `Many` is true.
+    constexpr __t(receiver_t receiver, acceptor_t& acceptor,
+                  std::size_t max_count = 1) noexcept
+        : base_t(static_cast<receiver_t&&>(receiver), acceptor),
+          accepted_(make_accepted(acceptor)),
+          max_count_(max_count > 0 ? max_count : 1) {}
 
    private:
-    void start_impl() noexcept {
-      if (!context_.is_running_on_io_thread()) {
-        static_cast<completion_op*>(this)->execute_ =
-            &__t::on_schedule_complete;
-        context_.schedule_remote(static_cast<completion_op*>(this));
+    static accepted_t make_accepted(acceptor_t& acceptor) noexcept {
+      if constexpr (Many) {
+        return {};
       } else {
-        perform();
+        return socket_t(static_cast<epoll_context&>(acceptor.context()));
       }
     }
 
-    // epoll_context starts to execute this operation in the io thread.
-    static void on_schedule_complete(operation_base* op) noexcept {
-      static_cast<__t*>(static_cast<completion_op*>(op))->perform();
-    }
-
-    // This function is not thread safe, it must be executed in io thread.
-    constexpr void perform() noexcept {
-      assert(context_.is_running_on_io_thread());
-      assert(!static_cast<completion_op*>(this)->enqueued_.load());
-
-      // And according to P2762, the operation should be performed in first.
-      // P2762:
-      // https://www.open-std.org/jtc1/sc22/wg21/docs/papers/2023/p2762r0.pdf
-      non_blocking_accept();
-      if (ec_ == errc::resource_unavailable_try_again ||
-          ec_ == errc::operation_would_block) {
-        ec_ = errc::success;
-        if constexpr (!stdexec::unstoppable_token<stop_token>) {
-          stop_callback_.__construct(
-              stdexec::get_stop_token(stdexec::get_env(receiver_)),
-              cancel_callback{*this});
+    // The accepted sockets are put into non-blocking mode by accept4 itself.
+    static void non_blocking_accept(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      if constexpr (Many) {
+        // Reserve room for the whole batch before accepting anything, so
+        // running out of memory completes with an error instead of throwing
+        // out of this noexcept function.
+        if (self.accepted_.capacity() < self.max_count_) {
+          try {
+            self.accepted_.reserve(self.max_count_);
+          } catch (...) {
+            self.ec_ = errc::not_enough_memory;
+            return;
+          }
         }
-        add_events();
-        static_cast<completion_op*>(this)->execute_ = wakeup;
-        return;
-      }
-
-      // Operation has been cancelled by a remote thread.
-      auto old_state =
-          state_.fetch_add(operation_ended, std::memory_order_acq_rel);
-      if ((old_state & request_stopped_mask) != 0) {
-        // The other thread is responsible for enqueueing the operation
-        // completion and set stopped to downstream receiver and deregister peer
-        // socket fd from epoll.
-        return;
-      }
-      complete();
-    }
-
-    // Handle epoll event.
-    static void wakeup(operation_base* op) noexcept {
-      assert(op->enqueued_.load() == false);
-
-      auto& self = *static_cast<__t*>(static_cast<completion_op*>(op));
-      self.stop_callback_.__destruct();
-      self.remove_events();
-
-      // Operation has been cancelled by a remote thread.
-      auto old_state =
-          self.state_.fetch_add(operation_ended, std::memory_order_acq_rel);
-      if ((old_state & request_stopped_mask) != 0) {
-        return;
-      }
-
-      // An socket operation is performed to obtain the result of this
-      // operation.
-      self.non_blocking_accept();
-      self.complete();
-    }
-
-    void non_blocking_accept() {
-      auto res = acceptor_.non_blocking_accept();
-      if (res.has_error()) {
-        ec_ = static_cast<system_error2::system_code&&>(res.error());
-      } else {
-        socket_ = static_cast<socket_t&&>(res.value());
-        ec_ = socket_.set_non_blocking(true);
-      }
-    }
-
-    void complete() {
-      if (ec_ == errc::operation_canceled) {
-        stdexec::set_stopped(static_cast<receiver_t&&>(receiver_));
-      } else if (ec_ == errc::success) {
-        stdexec::set_value(static_cast<receiver_t&&>(receiver_),  //
-                           static_cast<socket_t&&>(socket_));
+        // Drain the backlog. Errors after some connections have been accepted
+        // are left for the next accept to report.
+        while (self.accepted_.size() < self.max_count_) {
+          auto res = self.socket_.non_blocking_accept(accept_flags);
+          if (res.has_error()) {
+            self.ec_ = static_cast<system_error2::system_code&&>(res.error());
+            if (!self.accepted_.empty()) {
+              self.ec_ = errc::success;
+            }
+            return;
+          }
+          self.accepted_.push_back(static_cast<socket_t&&>(res.value()));
+        }
+        self.ec_ = errc::success;
       } else {
-        // Compatible with the use of error_code in stdexec.
-        // Should we changed status_code to error_code or just wait status_code
-        // adopted by standard?
-        std::error_code ec{static_cast<int>(ec_.value()),
-                           std::system_category()};
-        stdexec::set_error(static_cast<receiver_t&&>(receiver_),
-                           static_cast<std::error_code&&>(ec));
-      }
-    }
-
-    // Send the stopped signal to the downstream receiver.
-    static void complete_with_stop(operation_base* op) noexcept {
-      assert(static_cast<stop_op*>(op)->enqueued_ == false);
-
-      auto& self = *static_cast<__t*>(static_cast<stop_op*>(op));
-      if (!static_cast<completion_op&>(self).enqueued_.load()) {
-        if constexpr (!stdexec::unstoppable_token<stop_token>) {
-          stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+        auto res = self.socket_.non_blocking_accept(accept_flags);
+        if (res.has_error()) {
+          self.ec_ = static_cast<system_error2::system_code&&>(res.error());
         } else {
-          // This should never be called if stop is not possible.
-          assert(false);
+          self.accepted_ = static_cast<socket_t&&>(res.value());
+          self.ec_ = errc::success;
         }
-      } else {
-        // The current operation has been committed to the queue, we do not
-        // offer to delete the operation from the queue, so wait for the
-        // operation to be completed, then the stop operation will be executed
-        // sequentially, at which point the operation will be stopped, and no
-        // further completion operation will be committed to the queue.
-        self.execute_ = &complete_with_stop;
-        self.context_.schedule_local(static_cast<stop_op*>(op));
       }
     }
 
-    // The remote thread requests that this operation should be stopped.
-    void request_stop() noexcept {
-      auto old_state =
-          state_.fetch_add(request_stopped, std::memory_order_acq_rel);
-      if ((old_state & operation_ended_mask) == 0) {
-        // Io operation not yet completed.
-        // Note that we removed the peer descriptor registered on epoll,
-        // `wakeup` won't be called.
-        remove_events();
-
-        // We are responsible for scheduling the completion of this io
-        // operation.
-        static_cast<stop_op*>(this)->execute_ = &complete_with_stop;
-        context_.schedule_remote(static_cast<stop_op*>(this));
-      }
-    }
-
-    // Register epoll events. Returns whether the execution was successful
-    constexpr bool add_events() {
-      epoll_event event{
-          .events = EPOLLIN | EPOLLERR | EPOLLHUP | EPOLLPRI | EPOLLET,
-          .data = {.ptr = this}};
-      if (::epoll_ctl(context_.epoll_fd_, EPOLL_CTL_ADD,
-                      acceptor_.native_handle(), &event) != 0) {
-        ec_ = system_error2::posix_code::current();
-        return false;
-      }
-      return true;
-    }
-
-    // Unregister epoll events. Returns whether the execution was successful
-    constexpr bool remove_events() {
-      epoll_event event = {};
-      if (::epoll_ctl(context_.epoll_fd_, EPOLL_CTL_DEL,
-                      acceptor_.native_handle(), &event) != 0) {
-        ec_ = system_error2::posix_code::current();
-        return false;
+    static void complete(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      if (self.ec_ == errc::operation_canceled) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      } else if (self.ec_ == errc::success) {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                           static_cast<accepted_t&&>(self.accepted_));
+      } else {
+        stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                           to_error<Error>(self.ec_));
       }
-      return true;
     }
 
-    // Use theses to synchronize the remote thread and the io thread.
-    static constexpr uint32_t operation_ended = 0x00010000;
-    static constexpr uint32_t operation_ended_mask = 0xFFFF0000;
-    static constexpr uint32_t request_stopped = 0x1;
-    static constexpr uint32_t request_stopped_mask = 0xFFFF;
+    // The flags of accept4.
+    static constexpr int accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
 
-    // The cancel callback.
-    struct cancel_callback {
-      __t& op_;
-
-      void operator()() noexcept { op_.request_stop(); }
-    };
+    static constexpr typename base_t::op_type otype =
+        base_t::op_type::op_accept;
+    static constexpr
+        typename base_t::op_vtable op_vtable{&non_blocking_accept, &complete};
 
     // The data members.
-    receiver_t receiver_;
-    acceptor_t& acceptor_;
-    epoll_context& context_;
-    socket_t socket_;
-    std::atomic<uint32_t> state_;
-    system_error2::system_code ec_;
-    exec::__manual_lifetime<
-        typename stop_token::template callback_type<cancel_callback>>
-        stop_callback_;
+    accepted_t accepted_;
+    std::size_t max_count_;
   };
 };
 
-template <typename Protocol>
+template <typename Protocol, error_channel Error = std::error_code>
 class accept_sender {
   template <typename Receiver>
-  using op_t = stdexec::__t<
-      epoll_context::socket_accept_op<stdexec::__id<Receiver>, Protocol>>;
+  using op_t = stdexec::__t<epoll_context::socket_accept_op<
+      stdexec::__id<Receiver>, Protocol, false, Error>>;
   using acceptor_t = basic_socket_acceptor<Protocol>;
   using socket_t = typename Protocol::socket;
   using endpoint_t = typename Protocol::endpoint;
@@ -264,7 +151,7 @@ class accept_sender {
     using __id = accept_sender;
     using completion_signatures =
         stdexec::completion_signatures<stdexec::set_value_t(socket_t&&),
-                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_error_t(Error&&),
                                        stdexec::set_stopped_t()>;
 
     template <typename Env>
@@ -296,16 +183,82 @@ class accept_sender {
   };
 };
 
+template <typename Protocol, error_channel Error = std::error_code>
+class accept_many_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<epoll_context::socket_accept_op<
+      stdexec::__id<Receiver>, Protocol, true, Error>>;
+  using acceptor_t = basic_socket_acceptor<Protocol>;
+  using socket_t = typename Protocol::socket;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = accept_many_sender;
+    using completion_signatures = stdexec::completion_signatures<
+        stdexec::set_value_t(std::vector<socket_t>&&),
+        stdexec::set_error_t(Error&&), stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t,
+                           const __t& self, Env) -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.acceptor_,
+              self.max_count_};
+    }
+
+    // Constructors.
+    constexpr __t(acceptor_t& acceptor, std::size_t max_count)
+        : acceptor_(acceptor), max_count_(max_count) {}
+
+   private:
+    acceptor_t& acceptor_;
+    std::size_t max_count_;
+  };
+};
+
+// `Error` is the type of the error channel.
+template <error_channel Error = std::error_code>
 struct async_accept_t {
   template <transport_protocol Protocol>
   constexpr auto operator()(basic_socket_acceptor<Protocol>& acceptor)
-      const noexcept -> stdexec::__t<accept_sender<Protocol>> {
-    return stdexec::__t<accept_sender<Protocol>>{acceptor};
+      const noexcept -> stdexec::__t<accept_sender<Protocol, Error>> {
+    return stdexec::__t<accept_sender<Protocol, Error>>{acceptor};
+  }
+};
+// Accept up to `max_count` connections that are already waiting in one go,
+// waiting for at least one of them.
+template <error_channel Error = std::error_code>
+struct async_accept_many_t {
+  template <transport_protocol Protocol>
+  constexpr auto operator()(basic_socket_acceptor<Protocol>& acceptor,
+                            std::size_t max_count) const noexcept
+      -> stdexec::__t<accept_many_sender<Protocol, Error>> {
+    return {acceptor, max_count};
   }
 };
 }  // namespace __epoll
 
-inline constexpr __epoll::async_accept_t async_accept{};
+inline constexpr __epoll::async_accept_t<> async_accept{};
+inline constexpr __epoll::async_accept_many_t<> async_accept_many{};
+
+// Like `async_accept` and `async_accept_many`, but errors are delivered as
+// `Error`, for example `system_error2::system_code` to skip the conversion to
+// `std::error_code`.
+template <error_channel Error>
+inline constexpr __epoll::async_accept_t<Error> async_accept_as{};
+
+template <error_channel Error>
+inline constexpr __epoll::async_accept_many_t<Error> async_accept_many_as{};
 
 }  // namespace net
 
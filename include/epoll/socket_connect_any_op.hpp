@@ -0,0 +1,465 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_SOCKET_CONNECT_ANY_OP_HPP_
+#define EPOLL_SOCKET_CONNECT_ANY_OP_HPP_
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>        // NOLINT
+#include <concepts>      // NOLINT
+#include <cstddef>
+#include <memory>
+#include <ranges>        // NOLINT
+#include <system_error>  // NOLINT
+#include <type_traits>
+#include <vector>
+
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_connect_op.hpp"
+#include "meta.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// The delay between two connection attempts recommended by RFC 8305.
+inline constexpr std::chrono::milliseconds connection_attempt_delay{250};
+
+// Reorder `endpoints` so the address families alternate, starting with the
+// family of the first one. The order within each family is kept.
+template <typename Endpoint>
+void interleave_families(std::vector<Endpoint>& endpoints) {
+  if (endpoints.size() < 3) {
+    return;
+  }
+  const auto first = endpoints.front().protocol();
+  auto split = std::stable_partition(
+      endpoints.begin(), endpoints.end(),
+      [&first](const Endpoint& ep) { return ep.protocol() == first; });
+  std::vector<Endpoint> result;
+  result.reserve(endpoints.size());
+  for (auto a = endpoints.begin(), b = split;
+       a != split || b != endpoints.end();) {
+    if (a != split) {
+      result.push_back(*a++);
+    }
+    if (b != endpoints.end()) {
+      result.push_back(*b++);
+    }
+  }
+  endpoints = static_cast<std::vector<Endpoint>&&>(result);
+}
+
+// Connect to the first of several endpoints that answers. The endpoints are
+// tried in turn with the address families interleaved, a new attempt starts
+// whenever the previous one fails or after `delay` without an answer, while
+// the earlier ones keep going. The first connected socket wins and the other
+// attempts are cancelled. The socket of each attempt comes from the factory,
+// it's opened for the endpoint if the factory leaves it closed.
+//
+// All the bookkeeping happens on the I/O thread, only a stop request may
+// come from another thread.
+template <typename ReceiverId, typename Protocol, typename Factory>
+class epoll_context::connect_any_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  using socket_t = typename Protocol::socket;
+  using endpoint_t = typename Protocol::endpoint;
+
+ public:
+  struct __t;
+
+ private:
+  struct attempt;
+
+  // The receiver of one connection attempt. Its stop token is the one of the
+  // race, so stopping the race cancels every attempt in flight.
+  struct attempt_receiver {
+    using is_receiver = void;
+    using __t = attempt_receiver;
+    using __id = attempt_receiver;
+
+    struct env {
+      friend auto tag_invoke(stdexec::get_stop_token_t,
+                             const env& self) noexcept
+          -> stdexec::in_place_stop_token {
+        return self.token_;
+      }
+
+      stdexec::in_place_stop_token token_;
+    };
+
+    friend void tag_invoke(stdexec::set_value_t,
+                           attempt_receiver&& self) noexcept {
+      self.attempt_->owner_.on_attempt_done(self.attempt_, {});
+    }
+
+    friend void tag_invoke(stdexec::set_error_t, attempt_receiver&& self,
+                           std::error_code&& ec) noexcept {
+      self.attempt_->owner_.on_attempt_done(self.attempt_, ec);
+    }
+
+    friend void tag_invoke(stdexec::set_stopped_t,
+                           attempt_receiver&& self) noexcept {
+      self.attempt_->owner_.on_attempt_done(
+          self.attempt_, std::make_error_code(std::errc::operation_canceled));
+    }
+
+    friend auto tag_invoke(stdexec::get_env_t,
+                           const attempt_receiver& self) noexcept -> env {
+      return {self.attempt_->owner_.stop_source_.get_token()};
+    }
+
+    attempt* attempt_;
+  };
+
+  // One socket connecting to one endpoint.
+  struct attempt {
+    attempt(connect_any_op::__t& owner, socket_t socket,
+            const endpoint_t& peer) noexcept
+        : owner_(owner),
+          socket_(static_cast<socket_t&&>(socket)),
+          peer_(peer),
+          op_(stdexec::connect(
+              stdexec::__t<connect_sender<Protocol>>{socket_, peer_},
+              attempt_receiver{this})) {}
+
+    connect_any_op::__t& owner_;
+    socket_t socket_;
+    endpoint_t peer_;
+    bool done_ = false;
+    stdexec::connect_result_t<stdexec::__t<connect_sender<Protocol>>,
+                              attempt_receiver>
+        op_;
+  };
+
+ public:
+  struct __t : private completion_op {
+    using __id = connect_any_op;
+    using stop_token = stdexec::stop_token_of_t<stdexec::env_of_t<receiver_t>&>;
+
+    __t(receiver_t receiver, epoll_context& context, Factory factory,
+        std::vector<endpoint_t> endpoints, std::chrono::milliseconds delay)
+        : receiver_(static_cast<receiver_t&&>(receiver)),
+          context_(context),
+          factory_(static_cast<Factory&&>(factory)),
+          endpoints_(static_cast<std::vector<endpoint_t>&&>(endpoints)),
+          delay_(delay),
+          timer_(*this, context),
+          stop_entry_(*this) {
+      interleave_families(endpoints_);
+      attempts_.reserve(endpoints_.size());
+    }
+
+    // The race is set up on the I/O thread.
+    friend void tag_invoke(stdexec::start_t, __t& self) noexcept {
+      if (self.context_.can_run_inline()) {
+        epoll_context::inline_scope scope{self.context_};
+        self.begin();
+      } else {
+        self.execute_ = [](operation_base* op) noexcept {
+          static_cast<__t*>(static_cast<completion_op*>(op))->begin();
+        };
+        self.context_.schedule_impl(static_cast<completion_op*>(&self));
+      }
+    }
+
+   private:
+    friend attempt_receiver;
+
+    // The timer which starts the next attempt.
+    struct stagger_timer : schedule_at_base_op {
+      stagger_timer(__t& op, epoll_context& context) noexcept
+          : schedule_at_base_op(context, time_point::max(), false), op_(op) {
+        this->execute_ = &__t::on_timer;
+      }
+
+      __t& op_;
+    };
+
+    // Queued on the I/O thread when the receiver asks to stop.
+    struct stop_entry : operation_base {
+      explicit stop_entry(__t& op) noexcept : op_(op) {
+        this->execute_ = [](operation_base* base) noexcept {
+          auto& self = static_cast<stop_entry*>(base)->op_;
+          self.disarm_timer();
+          self.try_complete();
+        };
+      }
+
+      __t& op_;
+    };
+
+    struct cancel_callback {
+      __t& op_;
+
+      void operator()() noexcept {
+        op_.stop_source_.request_stop();
+        op_.context_.schedule_impl(&op_.stop_entry_);
+      }
+    };
+
+    using stop_callback_t =
+        typename stop_token::template callback_type<cancel_callback>;
+
+    void begin() noexcept {
+      if constexpr (!stdexec::unstoppable_token<stop_token>) {
+        auto token = stdexec::get_stop_token(stdexec::get_env(receiver_));
+        if (token.stop_requested()) {
+          stdexec::set_stopped(static_cast<receiver_t&&>(receiver_));
+          return;
+        }
+        stop_callback_.__construct(token, cancel_callback{*this});
+        callback_engaged_ = true;
+      }
+      launch();
+    }
+
+    // Whether no further attempt should be made.
+    bool stopping() const noexcept {
+      return winner_ != nullptr || stop_source_.stop_requested();
+    }
+
+    // Start attempts until one of them is in flight, and arm the timer for
+    // the next one. An attempt failing at once is followed by the next one.
+    void launch() noexcept {
+      launching_ = true;
+      while (next_ < endpoints_.size() && !stopping()) {
+        attempt* a = make_attempt(endpoints_[next_++]);
+        if (a == nullptr) {
+          continue;
+        }
+        ++running_;
+        stdexec::start(a->op_);
+        if (!a->done_) {
+          if (next_ < endpoints_.size()) {
+            arm_timer();
+          }
+          break;
+        }
+      }
+      launching_ = false;
+      try_complete();
+    }
+
+    attempt* make_attempt(const endpoint_t& peer) noexcept {
+      try {
+        socket_t socket = factory_(peer);
+        if (!socket.is_open()) {
+          if (auto ec = socket.open(peer.protocol()); ec.failure()) {
+            ec_ = make_error_code(static_cast<std::errc>(ec.value()));
+            return nullptr;
+          }
+        }
+        attempts_.push_back(std::make_unique<attempt>(
+            *this, static_cast<socket_t&&>(socket), peer));
+        return attempts_.back().get();
+      } catch (const std::system_error& e) {
+        ec_ = e.code();
+      } catch (...) {
+        ec_ = std::make_error_code(std::errc::not_enough_memory);
+      }
+      return nullptr;
+    }
+
+    void on_attempt_done(attempt* a, std::error_code ec) noexcept {
+      a->done_ = true;
+      --running_;
+      if (!ec) {
+        if (winner_ == nullptr) {
+          winner_ = a;
+          stop_source_.request_stop();
+          disarm_timer();
+        }
+      } else if (ec != std::errc::operation_canceled) {
+        ec_ = ec;
+      }
+      if (launching_) {
+        return;
+      }
+      // Don't wait for the timer once an attempt failed. A timer which has
+      // already elapsed starts the next attempt itself.
+      if (ec && !stopping() && next_ < endpoints_.size() && disarm_timer()) {
+        launch();
+        return;
+      }
+      try_complete();
+    }
+
+    void arm_timer() noexcept {
+      timer_.due_time_ = context_.loop_now() + delay_;
+      context_.schedule_at_impl(&timer_);
+      timer_armed_ = true;
+    }
+
+    // Take the timer out of the timer heap. Returns false if it can't be,
+    // because it has elapsed and waits on the local queue.
+    bool disarm_timer() noexcept {
+      if (!timer_armed_) {
+        return true;
+      }
+      if (timer_.enqueued_.load(std::memory_order_relaxed)) {
+        return false;
+      }
+      context_.remove_timer(&timer_);
+      timer_armed_ = false;
+      return true;
+    }
+
+    static void on_timer(operation_base* op) noexcept {
+      auto& self =
+          static_cast<stagger_timer*>(static_cast<schedule_at_base_op*>(op))
+              ->op_;
+      self.timer_armed_ = false;
+      if (self.stopping()) {
+        self.try_complete();
+      } else {
+        self.launch();
+      }
+    }
+
+    // Complete once nothing refers to this operation anymore.
+    void try_complete() noexcept {
+      if (launching_ || running_ != 0 || timer_armed_) {
+        return;
+      }
+      if constexpr (!stdexec::unstoppable_token<stop_token>) {
+        if (callback_engaged_) {
+          // Waits for a callback running on another thread.
+          stop_callback_.__destruct();
+          callback_engaged_ = false;
+        }
+        if (stop_entry_.enqueued_.load(std::memory_order_acquire)) {
+          return;
+        }
+      }
+
+      if (winner_ != nullptr) {
+        socket_t socket = static_cast<socket_t&&>(winner_->socket_);
+        endpoint_t peer = winner_->peer_;
+        attempts_.clear();
+        stdexec::set_value(static_cast<receiver_t&&>(receiver_),
+                           static_cast<socket_t&&>(socket), peer);
+      } else if (stop_source_.stop_requested()) {
+        attempts_.clear();
+        stdexec::set_stopped(static_cast<receiver_t&&>(receiver_));
+      } else {
+        attempts_.clear();
+        stdexec::set_error(static_cast<receiver_t&&>(receiver_),
+                           static_cast<std::error_code&&>(ec_));
+      }
+    }
+
+    receiver_t receiver_;
+    epoll_context& context_;
+    Factory factory_;
+    std::vector<endpoint_t> endpoints_;
+    std::chrono::milliseconds delay_;
+    stagger_timer timer_;
+    stop_entry stop_entry_;
+    stdexec::in_place_stop_source stop_source_;
+    exec::__manual_lifetime<stop_callback_t> stop_callback_;
+    std::vector<std::unique_ptr<attempt>> attempts_;
+    attempt* winner_ = nullptr;
+
+    // The error of the last failed attempt, reported if none succeeds. An
+    // empty list of endpoints reports `host_unreachable`.
+    std::error_code ec_ = std::make_error_code(std::errc::host_unreachable);
+    std::size_t next_ = 0;
+    std::size_t running_ = 0;
+    bool launching_ = false;
+    bool timer_armed_ = false;
+    bool callback_engaged_ = false;
+  };
+};
+
+template <typename Protocol, typename Factory>
+class connect_any_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<epoll_context::connect_any_op<
+      stdexec::__id<Receiver>, Protocol, Factory>>;
+  using socket_t = typename Protocol::socket;
+  using endpoint_t = typename Protocol::endpoint;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = connect_any_sender;
+    using completion_signatures = stdexec::completion_signatures<
+        stdexec::set_value_t(socket_t, endpoint_t),
+        stdexec::set_error_t(std::error_code&&), stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.context_,
+              static_cast<Sender&&>(self).factory_,
+              static_cast<Sender&&>(self).endpoints_, self.delay_};
+    }
+
+    __t(epoll_context& context, Factory factory,
+        std::vector<endpoint_t> endpoints,
+        std::chrono::milliseconds delay) noexcept
+        : context_(context),
+          factory_(static_cast<Factory&&>(factory)),
+          endpoints_(static_cast<std::vector<endpoint_t>&&>(endpoints)),
+          delay_(delay) {}
+
+   private:
+    epoll_context& context_;
+    Factory factory_;
+    std::vector<endpoint_t> endpoints_;
+    std::chrono::milliseconds delay_;
+  };
+};
+
+// Connect to the first endpoint of `endpoints` which answers, with the
+// sockets made by `factory`, which is called with the endpoint to connect
+// to. Completes with the connected socket and its peer, or with the error of
+// the last attempt.
+struct async_connect_any_t {
+  template <typename Factory, std::ranges::input_range Endpoints,
+            typename Protocol = typename std::ranges::range_value_t<
+                Endpoints>::protocol_type>
+    requires transport_protocol<Protocol> &&
+             std::is_invocable_r_v<typename Protocol::socket,
+                                   std::decay_t<Factory>&,
+                                   const typename Protocol::endpoint&>
+  auto operator()(
+      epoll_context& context, Factory&& factory, Endpoints&& endpoints,
+      std::chrono::milliseconds delay = connection_attempt_delay) const
+      -> stdexec::__t<connect_any_sender<Protocol, std::decay_t<Factory>>> {
+    return {context, static_cast<Factory&&>(factory),
+            std::vector<typename Protocol::endpoint>(
+                std::ranges::begin(endpoints), std::ranges::end(endpoints)),
+            delay};
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::async_connect_any_t async_connect_any{};
+}  // namespace net
+
+#endif  // EPOLL_SOCKET_CONNECT_ANY_OP_HPP_
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_SOCKET_CONNECT_OP_HPP_
+#define EPOLL_SOCKET_CONNECT_OP_HPP_
+
+#include <cassert>
+#include <concepts>      // NOLINT
+#include <system_error>  // NOLINT
+
+#include "status-code/system_code.hpp"
+
+#include "basic_socket.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_io_base_op.hpp"
+#include "meta.hpp"
+#include "socket_option.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// Connect the socket to a peer. The connect is started at once and the
+// operation waits for the socket to become writable, then the result is read
+// from SO_ERROR. The socket is switched to non-blocking mode if it isn't.
+template <typename ReceiverId, typename Protocol>
+class epoll_context::socket_connect_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  template <typename Derived>
+  using base_op_t = stdexec::__t<
+      epoll_context::socket_io_base_op<ReceiverId, Protocol, Derived>>;
+  using socket_t = typename Protocol::socket;
+  using endpoint_t = typename Protocol::endpoint;
+
+ public:
+  struct __t : public base_op_t<__t> {
+    using __id = socket_connect_op;
+    using base_t = base_op_t<__t>;
+    friend base_t;
+
+    // Constructor.
+    constexpr __t(receiver_t receiver, basic_socket<Protocol>& socket,
+                  const endpoint_t& peer) noexcept
+        : base_t(static_cast<receiver_t&&>(receiver),  //
+                 static_cast<socket_t&>(socket)),
+          peer_(peer),
+          connecting_(false) {}
+
+   private:
+    static constexpr void non_blocking_connect(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      if (!self.connecting_) {
+        if (!self.socket_.is_non_blocking()) {
+          if (self.ec_ = self.socket_.set_non_blocking(true);
+              self.ec_.failure()) {
+            return;
+          }
+        }
+        self.ec_ = self.socket_.connect(self.peer_);
+        self.connecting_ = true;
+      } else {
+        self.ec_ = self.socket_.non_blocking_connect(self.peer_);
+      }
+
+      // Wait for the socket to become writable.
+      if (self.ec_ == errc::operation_in_progress) {
+        self.ec_ = errc::operation_would_block;
+      }
+    }
+
+    static void complete(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      if (self.ec_ == errc::operation_canceled) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      } else if (self.ec_ == errc::success) {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_));
+      } else {
+        if (self.ec_.domain() ==
+            system_error2::quick_status_code_from_enum_domain<
+                net::network_errc>) {
+          stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                             make_error_code(static_cast<net::network_errc>(
+                                 self.ec_.value())));
+        } else {
+          stdexec::set_error(
+              static_cast<receiver_t&&>(self.receiver_),
+              make_error_code(static_cast<std::errc>(self.ec_.value())));
+        }
+      }
+    }
+
+    static constexpr typename base_t::op_type otype =
+        base_t::op_type::op_connect;
+    static constexpr op_kind latency_kind = op_kind::connect;
+    static constexpr
+        typename base_t::op_vtable op_vtable{&non_blocking_connect, &complete};
+    endpoint_t peer_;
+
+    // Whether connect(2) has been issued.
+    bool connecting_;
+  };
+};
+
+template <typename Protocol>
+class connect_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<
+      epoll_context::socket_connect_op<stdexec::__id<Receiver>, Protocol>>;
+  using socket_t = typename Protocol::socket;
+  using endpoint_t = typename Protocol::endpoint;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = connect_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(),
+                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.socket_, self.peer_};
+    }
+
+    constexpr __t(basic_socket<Protocol>& socket,
+                  const endpoint_t& peer) noexcept
+        : socket_(static_cast<socket_t&>(socket)), peer_(peer) {}
+
+   private:
+    socket_t& socket_;
+    endpoint_t peer_;
+  };
+};
+
+struct async_connect_t {
+  template <transport_protocol Protocol>
+  constexpr auto operator()(basic_socket<Protocol>& socket,
+                            const typename Protocol::endpoint& peer)
+      const noexcept -> stdexec::__t<connect_sender<Protocol>> {
+    return {socket, peer};
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::async_connect_t async_connect{};
+}  // namespace net
+
+#endif  // EPOLL_SOCKET_CONNECT_OP_HPP_
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef EPOLL_SOCKET_CONNECT_WITH_DATA_OP_HPP_
+#define EPOLL_SOCKET_CONNECT_WITH_DATA_OP_HPP_
+
+#include <sys/socket.h>
+
+#include <cassert>
+#include <concepts>      // NOLINT
+#include <system_error>  // NOLINT
+
+#include "status-code/system_code.hpp"
+
+#include "basic_socket.hpp"
+#include "buffer.hpp"
+#include "buffer_sequence_adapter.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_io_base_op.hpp"
+#include "meta.hpp"
+#include "socket_option.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// Connect the socket to a peer with TCP Fast Open, carrying the first bytes
+// of `Buffers` in the SYN when the kernel holds a cookie for the peer. Without
+// a cookie the SYN asks for one and the bytes are sent once the connection is
+// established. If client fast open is disabled by net.ipv4.tcp_fastopen, it
+// falls back to a plain connect followed by the send.
+//
+// Completes with the count of bytes sent along with the connect, which may
+// be less than the size of `Buffers`, the caller sends the rest.
+template <typename ReceiverId, typename Protocol, typename Buffers>
+class epoll_context::socket_connect_with_data_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  template <typename Derived>
+  using base_op_t = stdexec::__t<
+      epoll_context::socket_io_base_op<ReceiverId, Protocol, Derived>>;
+  using socket_t = typename Protocol::socket;
+  using endpoint_t = typename Protocol::endpoint;
+  using bufs_t = buffer_sequence_adapter<const_buffer, Buffers>;
+
+ public:
+  struct __t : public base_op_t<__t> {
+    using __id = socket_connect_with_data_op;
+    using base_t = base_op_t<__t>;
+    friend base_t;
+
+    // Constructor.
+    constexpr __t(receiver_t receiver, basic_socket<Protocol>& socket,
+                  const endpoint_t& peer, Buffers buffers) noexcept
+        : base_t(static_cast<receiver_t&&>(receiver),  //
+                 static_cast<socket_t&>(socket)),
+          peer_(peer),
+          buffers_(buffers),
+          bufs_(buffers_),
+          bytes_transferred_(0),
+          connecting_(false) {}
+
+   private:
+    static constexpr void non_blocking_connect(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      if (!self.connecting_) {
+        self.connecting_ = true;
+        if (!self.socket_.is_non_blocking()) {
+          if (self.ec_ = self.socket_.set_non_blocking(true);
+              self.ec_.failure()) {
+            return;
+          }
+        }
+        ::sockaddr_storage storage;
+        ::socklen_t size = self.peer_.native_address(&storage);
+        auto res = self.socket_.non_blocking_sendmsg_to(
+            self.bufs_.buffers(), self.bufs_.count(),
+            MSG_FASTOPEN | MSG_NOSIGNAL, &storage, size);
+        if (res.has_value()) {
+          // The bytes went out with the SYN.
+          self.bytes_transferred_ = res.value();
+          self.ec_ = errc::operation_would_block;
+          return;
+        }
+        self.ec_ = static_cast<system_error2::system_code&&>(res.error());
+        if (self.ec_ == errc::operation_not_supported) {
+          self.ec_ = self.socket_.connect(self.peer_);
+        }
+      } else {
+        self.ec_ = self.socket_.non_blocking_connect(self.peer_);
+      }
+
+      if (self.ec_ == errc::operation_in_progress) {
+        // Wait for the socket to become writable.
+        self.ec_ = errc::operation_would_block;
+      } else if (self.ec_ == errc::success && self.bytes_transferred_ == 0) {
+        send_after_connect(self);
+      }
+    }
+
+    // The SYN carried no data, send it the usual way. A full socket buffer
+    // is no error, the caller sends whatever is left.
+    static constexpr void send_after_connect(__t& self) noexcept {
+      if (self.bufs_.total_size() == 0) {
+        return;
+      }
+      auto res = self.socket_.non_blocking_sendmsg(self.bufs_.buffers(),
+                                                   self.bufs_.count(), 0);
+      if (res.has_value()) {
+        self.bytes_transferred_ = res.value();
+      } else if (res.error() != errc::operation_would_block &&
+                 res.error() != errc::resource_unavailable_try_again) {
+        self.ec_ = static_cast<system_error2::system_code&&>(res.error());
+      }
+    }
+
+    static void complete(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      if (self.ec_ == errc::operation_canceled) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      } else if (self.ec_ == errc::success) {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                           self.bytes_transferred_);
+      } else {
+        if (self.ec_.domain() ==
+            system_error2::quick_status_code_from_enum_domain<
+                net::network_errc>) {
+          stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                             make_error_code(static_cast<net::network_errc>(
+                                 self.ec_.value())));
+        } else {
+          stdexec::set_error(
+              static_cast<receiver_t&&>(self.receiver_),
+              make_error_code(static_cast<std::errc>(self.ec_.value())));
+        }
+      }
+    }
+
+    static constexpr typename base_t::op_type otype =
+        base_t::op_type::op_connect;
+    static constexpr op_kind latency_kind = op_kind::connect;
+    static constexpr
+        typename base_t::op_vtable op_vtable{&non_blocking_connect, &complete};
+    endpoint_t peer_;
+    Buffers buffers_;
+    bufs_t bufs_;
+    size_t bytes_transferred_;
+
+    // Whether the fast open sendmsg or connect(2) has been issued.
+    bool connecting_;
+  };
+};
+
+template <typename Protocol, typename Buffers>
+class connect_with_data_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<epoll_context::socket_connect_with_data_op<
+      stdexec::__id<Receiver>, Protocol, Buffers>>;
+  using socket_t = typename Protocol::socket;
+  using endpoint_t = typename Protocol::endpoint;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = connect_with_data_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(size_t),
+                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.socket_, self.peer_,
+              self.buffers_};
+    }
+
+    constexpr __t(basic_socket<Protocol>& socket, const endpoint_t& peer,
+                  Buffers buffers) noexcept
+        : socket_(static_cast<socket_t&>(socket)),
+          peer_(peer),
+          buffers_(buffers) {}
+
+   private:
+    socket_t& socket_;
+    endpoint_t peer_;
+    Buffers buffers_;
+  };
+};
+
+struct async_connect_with_data_t {
+  template <transport_protocol Protocol, const_buffer_sequence Buffers>
+  constexpr auto operator()(basic_socket<Protocol>& socket,
+                            const typename Protocol::endpoint& peer,
+                            Buffers buffers) const noexcept
+      -> stdexec::__t<connect_with_data_sender<Protocol, Buffers>> {
+    return {socket, peer, buffers};
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::async_connect_with_data_t async_connect_with_data{};
+}  // namespace net
+
+#endif  // EPOLL_SOCKET_CONNECT_WITH_DATA_OP_HPP_
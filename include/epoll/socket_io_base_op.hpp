@@ -18,27 +18,39 @@
 
 #include <cassert>
 #include <concepts>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 
 #include "basic_socket.hpp"
 
+#include "compact_code.hpp"
 #include "epoll/epoll_context.hpp"
 #include "socket_option.hpp"
 #include "status-code/system_code.hpp"
 #include "stdexec.hpp"
+#include "usdt_probe.hpp"
 
 namespace net::__epoll {
-// Base class for socket I/O operations
-template <typename ReceiverId, typename Protocol>
+// Base class for socket I/O operations. `Derived` is the operation state of
+// the subclass, which provides `op_vtable` and `otype` as static constexpr
+// members, so both are resolved at compile time instead of being stored in
+// every operation. `Socket` is the socket, acceptor or descriptor the operation
+// works on, `Protocol` only picks the default one.
+template <typename ReceiverId, typename Protocol, typename Derived,
+          typename Socket>
 class epoll_context::socket_io_base_op {
   using receiver_t = stdexec::__t<ReceiverId>;
 
+  // The entry queued by `request_stop`. Unlike `stop_op` it carries no flag.
+  struct stop_entry : operation_base {};
+
  public:
   struct __t : public stdexec::__immovable,
-               private epoll_context::stop_op,
+               private stop_entry,
                private epoll_context::completion_op {
     using __id = socket_io_base_op;
-    using socket_t = typename Protocol::socket;
-    using endpoint_t = typename Protocol::endpoint;
+    using socket_t = Socket;
     using stop_token = stdexec::stop_token_of_t<stdexec::env_of_t<receiver_t>>;
 
     // Use theses to synchronize the remote thread and the io thread.
@@ -47,7 +59,8 @@ class epoll_context::socket_io_base_op {
     static constexpr uint32_t request_stopped = 0x1;
     static constexpr uint32_t request_stopped_mask = 0xFFFF;
 
-    // Subclasses should provide these necessary functions.
+    // Subclasses should provide these necessary functions as
+    // `static constexpr op_vtable op_vtable`.
     struct op_vtable {
       // The core implementation of this operation.
       // The `ec_` should be assigned to indicate whether the operation is
@@ -59,8 +72,17 @@ class epoll_context::socket_io_base_op {
       void (*complete)(__t*) noexcept = nullptr;  // NOLINT
     };
 
-    // The operation type of the subclass.
-    enum class op_type { op_read = 1, op_write = 2, op_connect = 2 };
+    // The operation type of the subclass, provided as
+    // `static constexpr op_type otype`. Accepts wait on the read slot like
+    // reads, but aren't held back by the read budget. Waits park on the slot
+    // the subclass picks at run time as its `wait_slot_` member.
+    enum class op_type {
+      op_read = 1,
+      op_write = 2,
+      op_connect = 2,
+      op_accept = 3,
+      op_wait = 4
+    };
 
     struct cancel_callback {
       __t& op_;
@@ -68,29 +90,108 @@ class epoll_context::socket_io_base_op {
       void operator()() noexcept { op_.request_stop(); }
     };
 
+    // The timer linked into the context's timer heap while the operation
+    // waits with a deadline. It also holds the context of the operation.
+    struct deadline_timer : epoll_context::schedule_at_base_op {
+      deadline_timer(__t& op, epoll_context& context,
+                     const time_point& deadline) noexcept
+          : schedule_at_base_op(context, deadline, false), op_(op) {}
+
+      __t& op_;
+    };
+
+    // The state of the deadline. The timer is only armed once the operation
+    // has to wait.
+    enum class deadline_state : uint8_t { none, pending, armed, expired };
+
+    // The size of the members besides the receiver and the stop callback.
+    // A parked operation stays in memory until its socket becomes ready, so
+    // keep an eye on this when adding members.
+    static constexpr std::size_t size_budget =
+        168 + (latency_enabled ? sizeof(latency_stamps) : 0);
+
+    using stop_callback_t =
+        typename stop_token::template callback_type<cancel_callback>;
+
     // The data members.
     receiver_t receiver_;
     socket_t& socket_;
-    epoll_context& context_;
-    const op_vtable* op_vtable_;
-    const op_type op_type_;
     std::atomic<uint32_t> state_;
-    system_error2::system_code ec_;
-    exec::__manual_lifetime<
-        typename stop_token::template callback_type<cancel_callback>>
-        stop_callback_;
-
-    // Constructor.
-    __t(receiver_t receiver, basic_socket<Protocol>& socket,
-        const op_vtable& vtable, op_type otype) noexcept
+    compact_code ec_;
+    exec::__manual_lifetime<stop_callback_t> stop_callback_;
+    deadline_timer deadline_timer_;
+    deadline_state deadline_state_;
+    STDEXEC_NO_UNIQUE_ADDRESS op_stamps stamps_;
+
+    // Constructor. If `deadline` is given, the operation completes with
+    // `errc::timed_out` when it's still waiting at that time.
+    explicit __t(receiver_t receiver, socket_t& socket,
+                 std::optional<time_point> deadline = std::nullopt) noexcept
         : receiver_(static_cast<receiver_t&&>(receiver)),
-          socket_(static_cast<socket_t&>(socket)),
-          context_(static_cast<epoll_context&>(socket.context())),
-          op_vtable_(&vtable),
-          op_type_(otype),
+          socket_(socket),
           state_(0),
           ec_(errc::success),
-          stop_callback_() {}
+          stop_callback_(),
+          deadline_timer_(*this, static_cast<epoll_context&>(socket.context()),
+                          deadline.value_or(time_point::max())),
+          deadline_state_(deadline ? deadline_state::pending
+                                   : deadline_state::none) {
+      static_assert(sizeof(__t) <= sizeof(receiver_t) +
+                                       sizeof(stop_callback_) + size_budget,
+                    "socket_io_base_op exceeds its size budget");
+    }
+
+    // The context this operation runs on.
+    constexpr epoll_context& context() const noexcept {
+      return deadline_timer_.context_;
+    }
+
+    // Dispatch to the subclass at compile time.
+    constexpr void perform_op() noexcept { Derived::op_vtable.perform(this); }
+
+    constexpr void complete_op() noexcept {
+      record_latency();
+      NET_USDT_PROBE(op_complete, this, socket_.native_handle(), probe_kind(),
+                     ec_.value());
+      record_flight(flight_event::op_complete);
+      Derived::op_vtable.complete(this);
+    }
+
+    // The kind of operation the latencies are recorded as. Subclasses may
+    // provide it as `static constexpr op_kind latency_kind`.
+    static constexpr op_kind latency_kind() noexcept {
+      if constexpr (requires { Derived::latency_kind; }) {
+        return Derived::latency_kind;
+      } else if constexpr (Derived::otype == op_type::op_accept) {
+        return op_kind::accept;
+      } else {
+        return Derived::otype == op_type::op_read ? op_kind::recv
+                                                  : op_kind::send;
+      }
+    }
+
+    // The kind of operation passed to the probes.
+    static constexpr int probe_kind() noexcept {
+      return static_cast<int>(latency_kind());
+    }
+
+    // Record `event` of this operation in the flight recorder of the context.
+    void record_flight(flight_event event) noexcept {
+      context().record_flight(event, socket_.native_handle(),
+                              static_cast<std::uint8_t>(latency_kind()));
+    }
+
+    // Record the latencies of this operation, which is about to complete.
+    void record_latency() noexcept {
+      if constexpr (latency_enabled) {
+        const time_point now = context().now();
+        auto& stats = context().latency_of(latency_kind());
+        stats.total.record(now - stamps_.started_);
+        if (stamps_.woken_) {
+          stats.ready_to_complete.record(now - stamps_.ready_);
+        }
+      }
+    }
 
     // `start` customization point object.
     // The operation is submitted to the corresponding queue based on the thread
@@ -100,13 +201,30 @@ class epoll_context::socket_io_base_op {
       self.start_impl();
     }
 
+    // On the io thread the operation is performed inline, unless too many
+    // operations are already nested on the stack, in which case it's deferred
+    // to the local queue.
     constexpr void start_impl() noexcept {
-      if (!context_.is_running_on_io_thread()) {
+      NET_USDT_PROBE(op_start, this, socket_.native_handle(), probe_kind());
+      if constexpr (latency_enabled) {
+        stamps_.started_ = context().now();
+      }
+      if (!context().is_running_on_io_thread()) {
         static_cast<completion_op*>(this)->execute_ =
             &__t::on_schedule_complete;
-        context_.schedule_remote(static_cast<completion_op*>(this));
-      } else {
+        context().schedule_remote(static_cast<completion_op*>(this));
+        return;
+      }
+      // Only the io thread records, operations started by other threads
+      // show up in the remote drain.
+      record_flight(flight_event::op_start);
+      if (context().can_run_inline()) {
+        epoll_context::inline_scope scope{context()};
         perform();
+      } else {
+        static_cast<completion_op*>(this)->execute_ =
+            &__t::on_schedule_complete;
+        context().schedule_local(static_cast<completion_op*>(this));
       }
     }
 
@@ -117,66 +235,137 @@ class epoll_context::socket_io_base_op {
 
     // This function is not thread safe, it must be executed in io thread.
     constexpr void perform() noexcept {
-      assert(context_.is_running_on_io_thread());
+      assert(context().is_running_on_io_thread());
       assert(!static_cast<completion_op*>(this)->enqueued_.load());
+      if constexpr (Derived::otype == op_type::op_read) {
+        if (context().read_budget_exhausted(socket_.descriptor_data())) {
+          static_cast<completion_op*>(this)->execute_ =
+              &__t::on_schedule_complete;
+          context().defer_to_next_iteration(static_cast<completion_op*>(this));
+          return;
+        }
+      }
 
       // According to P2762, the operation should be performed once in first.
       // P2762:
       // https://www.open-std.org/jtc1/sc22/wg21/docs/papers/2023/p2762r0.pdf
-      op_vtable_->perform(this);
-      if (ec_ == errc::resource_unavailable_try_again ||
-          ec_ == errc::operation_would_block) {
-        ec_ = errc::success;
-        if constexpr (!stdexec::unstoppable_token<stop_token>) {
-          stop_callback_.__construct(
-              stdexec::get_stop_token(stdexec::get_env(receiver_)),
-              cancel_callback{*this});
+      perform_op();
+      if (would_block()) {
+        context().counters_.would_block_.add();
+        if (start_waiting()) {
+          return;
         }
-        add_events();
-        static_cast<completion_op*>(this)->execute_ = wakeup;
+      }
+      finish();
+    }
+
+    // Complete this operation unless it has been cancelled by a remote thread.
+    // Waits for the deadline timer first if it has elapsed and still sits on
+    // the local queue.
+    constexpr void finish() noexcept {
+      if (deadline_enqueued()) {
+        deadline_timer_.execute_ = &__t::finish_after_deadline;
         return;
       }
+      cancel_deadline();
 
       // Operation has been cancelled by a remote thread.
       auto old_state =
           state_.fetch_add(operation_ended, std::memory_order_acq_rel);
       if ((old_state & request_stopped_mask) != 0) {
         // The other thread is responsible for enqueueing the operation
-        // completion and set stopped to downstream receiver and deregister peer
-        // socket fd from epoll.
+        // completion and set stopped to downstream receiver.
         return;
       }
 
-      op_vtable_->complete(this);
+      complete_op();
     }
 
-    // Handle epoll event.
-    static void wakeup(operation_base* op) noexcept {
-      assert(op->enqueued_.load() == false);
+    // The elapsed deadline timer ran after the operation finished.
+    static void finish_after_deadline(operation_base* op) noexcept {
+      auto& self =
+          static_cast<deadline_timer*>(static_cast<schedule_at_base_op*>(op))
+              ->op_;
+      self.deadline_state_ = deadline_state::none;
+      self.finish();
+    }
 
-      auto& self = *static_cast<__t*>(static_cast<completion_op*>(op));
+    // The deadline passed. A parked operation is taken out of its slot and
+    // completes with `errc::timed_out`. If a wakeup is already queued, it
+    // completes the operation instead and observes the expiry if it would
+    // block again.
+    static void on_deadline(operation_base* op) noexcept {
+      auto& self =
+          static_cast<deadline_timer*>(static_cast<schedule_at_base_op*>(op))
+              ->op_;
+      self.deadline_state_ = deadline_state::expired;
+      if (static_cast<completion_op&>(self).enqueued_.load() ||
+          !self.stop_waiting()) {
+        return;
+      }
       self.stop_callback_.__destruct();
-      self.remove_events();
 
-      // Operation has been cancelled by a remote thread.
       auto old_state =
           self.state_.fetch_add(operation_ended, std::memory_order_acq_rel);
       if ((old_state & request_stopped_mask) != 0) {
         return;
       }
+      self.ec_ = errc::timed_out;
+      self.complete_op();
+    }
+
+    // Handle epoll event.
+    static void wakeup(operation_base* op) noexcept {
+      assert(op->enqueued_.load() == false);
+
+      auto& self = *static_cast<__t*>(static_cast<completion_op*>(op));
+      NET_USDT_PROBE(op_wakeup, &self, self.socket_.native_handle(),
+                     probe_kind());
+      self.record_flight(flight_event::op_wakeup);
+      self.stop_callback_.__destruct();
+      if constexpr (latency_enabled) {
+        // The loop time is when epoll reported the descriptor ready.
+        const time_point now = self.context().loop_now();
+        self.context()
+            .latency_of(latency_kind())
+            .parked.record(now - self.stamps_.ready_);
+        self.stamps_.ready_ = now;
+        self.stamps_.woken_ = true;
+      }
 
       // An socket operation is performed to obtain the result of this
-      // operation.
-      self.op_vtable_->perform(&self);
-      self.op_vtable_->complete(&self);
+      // operation. Since the read and write directions of a descriptor are
+      // reported by the same event, the readiness may have been consumed by
+      // another operation already, in which case we just wait again. If the
+      // socket was closed meanwhile, its descriptor may already belong to
+      // another file, so don't touch it. A drain cancels it as well.
+      if (descriptor_canceled(self.socket_.descriptor_data())) {
+        self.ec_ = errc::operation_canceled;
+      } else if ((self.state_.load(std::memory_order_acquire) &
+                  request_stopped_mask) == 0) {
+        self.perform_op();
+        if (self.would_block()) {
+          self.context().counters_.would_block_.add();
+          if (self.start_waiting()) {
+            return;
+          }
+        }
+      }
+      self.finish();
     }
 
     // Send the stopped signal to the downstream receiver.
     static void complete_with_stop(operation_base* op) noexcept {
-      assert(static_cast<stop_op*>(op)->enqueued_ == false);
-
-      auto& self = *static_cast<__t*>(static_cast<stop_op*>(op));
-      if (!static_cast<completion_op&>(self).enqueued_.load()) {
+      assert(static_cast<stop_entry*>(op)->enqueued_ == false);
+
+      auto& self = *static_cast<__t*>(static_cast<stop_entry*>(op));
+      if (!static_cast<completion_op&>(self).enqueued_.load() &&
+          !self.deadline_enqueued()) {
+        self.stop_waiting();
+        self.cancel_deadline();
+        NET_USDT_PROBE(op_cancel, &self, self.socket_.native_handle(),
+                       probe_kind());
+        self.record_flight(flight_event::op_cancel);
         if constexpr (!stdexec::unstoppable_token<stop_token>) {
           stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
         } else {
@@ -184,13 +373,14 @@ class epoll_context::socket_io_base_op {
           assert(false);
         }
       } else {
-        // The current operation has been committed to the queue, we do not
-        // offer to delete the operation from the queue, so wait for the
-        // operation to be completed, then the stop operation will be executed
-        // sequentially, at which point the operation will be stopped, and no
-        // further completion operation will be committed to the queue.
-        static_cast<stop_op&>(self).execute_ = &complete_with_stop;
-        self.context_.schedule_local(static_cast<stop_op*>(op));
+        // The current operation or its elapsed deadline timer has been
+        // committed to the queue, we do not offer to delete the operation from
+        // the queue, so wait for the operation to be completed, then the stop
+        // operation will be executed sequentially, at which point the
+        // operation will be stopped, and no further completion operation will
+        // be committed to the queue.
+        static_cast<stop_entry&>(self).execute_ = &complete_with_stop;
+        self.context().schedule_local(static_cast<stop_entry*>(op));
       }
     }
 
@@ -199,43 +389,111 @@ class epoll_context::socket_io_base_op {
       auto old_state =
           state_.fetch_add(request_stopped, std::memory_order_acq_rel);
       if ((old_state & operation_ended_mask) == 0) {
-        // Io operation not yet completed.
-        // Note that we removed the peer descriptor registered on epoll,
-        // `wakeup` won't be called.
-        remove_events();
-
+        // Io operation not yet completed. The operation is taken out of its
+        // descriptor slot by `complete_with_stop` on the io thread, which
+        // collects the stops of a burst together.
         // We are responsible for scheduling the completion of this io
         // operation.
-        static_cast<stop_op*>(this)->execute_ = &complete_with_stop;
-        context_.schedule_remote(static_cast<stop_op*>(this));
+        static_cast<stop_entry*>(this)->execute_ = &complete_with_stop;
+        context().schedule_stop(static_cast<stop_entry*>(this));
       }
     }
 
-    // Register epoll events. Returns whether the execution was successful
-    constexpr bool add_events() {
-      epoll_event event{.data = {.ptr = static_cast<completion_op*>(this)}};
-      if (op_type_ == op_type::op_read) {
-        event.events = EPOLLIN | EPOLLERR | EPOLLHUP | EPOLLPRI | EPOLLET;
+    // Whether the last attempt of this operation would block.
+    constexpr bool would_block() const noexcept {
+      return ec_ == errc::resource_unavailable_try_again ||
+             ec_ == errc::operation_would_block;
+    }
+
+    // The descriptor slot this operation waits on.
+    constexpr descriptor_state::op_slot slot() const noexcept {
+      if constexpr (Derived::otype == op_type::op_wait) {
+        return static_cast<const Derived*>(this)->wait_slot_;
       } else {
-        event.events = EPOLLOUT | EPOLLERR | EPOLLHUP | EPOLLPRI | EPOLLET;
+        return Derived::otype == op_type::op_read ||
+                       Derived::otype == op_type::op_accept
+                   ? descriptor_state::read_slot
+                   : descriptor_state::write_slot;
       }
-      if (::epoll_ctl(context_.epoll_fd_, EPOLL_CTL_ADD,
-                      socket_.native_handle(), &event) != 0) {
-        ec_ = system_error2::posix_code::current();
+    }
+
+    // Park this operation on the descriptor state of the socket until epoll
+    // reports the descriptor is ready. Returns false and assigns `ec_` if the
+    // descriptor can't be registered to epoll.
+    constexpr bool start_waiting() noexcept {
+      ec_ = errc::success;
+      if (deadline_state_ == deadline_state::expired) {
+        ec_ = errc::timed_out;
+        return false;
+      }
+      system_error2::system_code ec{errc::success};
+      bool exclusive = false;
+      if constexpr (requires { socket_.is_exclusive_wakeup(); }) {
+        exclusive = socket_.is_exclusive_wakeup();
+      }
+      descriptor_state* state = context().register_descriptor(
+          socket_.native_handle(), socket_.descriptor_data(), ec, exclusive);
+      if (state == nullptr) {
+        ec_ = ec;
+        return false;
+      }
+      if constexpr (requires { Derived::background; }) {
+        // Subclasses whose wait shouldn't hold up a drain provide
+        // `static constexpr bool background = true`, they are canceled as
+        // soon as the drain begins.
+        state->background_ = Derived::background;
+      }
+      if (state->canceled_) {
+        // Canceled by a group or a drain, don't wait for the next cancel.
+        ec_ = errc::operation_canceled;
+        return false;
+      }
+      if (!state->park(slot(), static_cast<completion_op*>(this))) {
+        // Another operation of the same direction is waiting on the socket.
+        ec_ = errc::device_or_resource_busy;
         return false;
       }
+      if constexpr (!stdexec::unstoppable_token<stop_token>) {
+        stop_callback_.__construct(
+            stdexec::get_stop_token(stdexec::get_env(receiver_)),
+            cancel_callback{*this});
+      }
+      static_cast<completion_op*>(this)->execute_ = wakeup;
+      if constexpr (latency_enabled) {
+        stamps_.ready_ = context().loop_now();
+      }
+      NET_USDT_PROBE(op_park, this, socket_.native_handle(), probe_kind());
+      record_flight(flight_event::op_park);
+      if (deadline_state_ == deadline_state::pending) {
+        deadline_state_ = deadline_state::armed;
+        deadline_timer_.execute_ = &__t::on_deadline;
+        context().schedule_at_impl(&deadline_timer_);
+      }
       return true;
     }
 
-    // Unregister epoll events. Returns whether the execution was successful
-    constexpr bool remove_events() {
-      epoll_event event = {};
-      if (::epoll_ctl(context_.epoll_fd_, EPOLL_CTL_DEL,
-                      socket_.native_handle(), &event) != 0) {
-        ec_ = system_error2::posix_code::current();
-        return false;
+    // Take this operation out of its descriptor slot if it's still parked.
+    // Returns whether the operation was parked.
+    constexpr bool stop_waiting() noexcept {
+      if (void* data = socket_.descriptor_data()) {
+        return static_cast<descriptor_state*>(data)->unpark(
+            slot(), static_cast<completion_op*>(this));
       }
-      return true;
+      return false;
+    }
+
+    // Whether the deadline timer has elapsed and waits on the local queue.
+    constexpr bool deadline_enqueued() const noexcept {
+      return deadline_state_ == deadline_state::armed &&
+             deadline_timer_.enqueued_.load(std::memory_order_relaxed);
+    }
+
+    // Remove the deadline timer from the timer heap if it's still there.
+    constexpr void cancel_deadline() noexcept {
+      if (deadline_state_ == deadline_state::armed) {
+        context().remove_timer(&deadline_timer_);
+      }
+      deadline_state_ = deadline_state::none;
     }
   };
 };
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef EPOLL_SOCKET_MIGRATE_OP_HPP_
+#define EPOLL_SOCKET_MIGRATE_OP_HPP_
+
+#include <system_error>  // NOLINT
+
+#include "status-code/system_code.hpp"
+
+#include "basic_socket.hpp"
+#include "epoll/epoll_context.hpp"
+#include "error_channel.hpp"
+#include "meta.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// Move a socket to another epoll context without closing it, e.g. to take
+// heavy connections off a hot core. The socket must be idle: no operation may
+// be pending on it while it's migrated. On the io thread of its current
+// context it's removed from epoll, then it's bound to the target context and
+// registered there on the target's io thread, where the operation completes.
+//
+// If an operation is still parked on the socket, the socket is left alone and
+// the operation fails with `errc::device_or_resource_busy` on the io thread
+// of the current context.
+template <typename ReceiverId, typename Protocol>
+class epoll_context::socket_migrate_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+
+ public:
+  struct __t : public stdexec::__immovable, private operation_base {
+    using __id = socket_migrate_op;
+
+    // Constructor.
+    __t(receiver_t receiver, basic_socket<Protocol>& socket,
+        epoll_context& target) noexcept
+        : receiver_(static_cast<receiver_t&&>(receiver)),
+          socket_(socket),
+          target_(target),
+          ec_(errc::success) {}
+
+    friend void tag_invoke(stdexec::start_t, __t& self) noexcept {
+      if (stdexec::get_stop_token(stdexec::get_env(self.receiver_))
+              .stop_requested()) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+        return;
+      }
+      auto& source = static_cast<epoll_context&>(self.socket_.context());
+      if (&source != &self.target_ &&
+          self.socket_.descriptor_data() != nullptr) {
+        self.execute_ = &leave;
+        source.schedule_impl(&self);
+        return;
+      }
+      // Nothing to remove from the current context.
+      if (&source != &self.target_) {
+        self.socket_.rebind(self.target_);
+      }
+      self.execute_ = &arrive;
+      self.target_.schedule_impl(&self);
+    }
+
+   private:
+    // Runs on the io thread of the current context.
+    static void leave(operation_base* op) noexcept {
+      auto& self = *static_cast<__t*>(op);
+      if (auto* state =
+              static_cast<descriptor_state*>(self.socket_.descriptor_data())) {
+        for (completion_op* parked : state->ops_) {
+          if (parked != nullptr) {
+            self.ec_ = errc::device_or_resource_busy;
+            self.complete();
+            return;
+          }
+        }
+      }
+      self.socket_.rebind(self.target_);
+      self.execute_ = &arrive;
+      self.target_.schedule_impl(op);
+    }
+
+    // Runs on the io thread of the target context.
+    static void arrive(operation_base* op) noexcept {
+      auto& self = *static_cast<__t*>(op);
+      bool exclusive = false;
+      if constexpr (requires { self.socket_.is_exclusive_wakeup(); }) {
+        exclusive = self.socket_.is_exclusive_wakeup();
+      }
+      system_error2::system_code ec{errc::success};
+      if (self.target_.register_descriptor(self.socket_.native_handle(),
+                                           self.socket_.descriptor_data(), ec,
+                                           exclusive) == nullptr) {
+        self.ec_ = static_cast<system_error2::system_code&&>(ec);
+      }
+      self.complete();
+    }
+
+    void complete() noexcept {
+      if (ec_ == errc::success) {
+        stdexec::set_value(static_cast<receiver_t&&>(receiver_));
+      } else {
+        stdexec::set_error(static_cast<receiver_t&&>(receiver_),
+                           to_error<std::error_code>(ec_));
+      }
+    }
+
+    receiver_t receiver_;
+    basic_socket<Protocol>& socket_;
+    epoll_context& target_;
+    system_error2::system_code ec_;
+  };
+};
+
+template <typename Protocol>
+class migrate_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<
+      epoll_context::socket_migrate_op<stdexec::__id<Receiver>, Protocol>>;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = migrate_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(),
+                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.socket_, self.target_};
+    }
+
+    constexpr __t(basic_socket<Protocol>& socket,
+                  epoll_context& target) noexcept
+        : socket_(socket), target_(target) {}
+
+   private:
+    basic_socket<Protocol>& socket_;
+    epoll_context& target_;
+  };
+};
+
+// Move the idle `socket` to the context of `target`, completing on its io
+// thread.
+struct async_migrate_t {
+  template <transport_protocol Protocol>
+  auto operator()(basic_socket<Protocol>& socket,
+                  epoll_context::scheduler target) const noexcept
+      -> stdexec::__t<migrate_sender<Protocol>> {
+    return {socket, target.context()};
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::async_migrate_t async_migrate{};
+}  // namespace net
+
+#endif  // EPOLL_SOCKET_MIGRATE_OP_HPP_
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_SOCKET_RECV_BATCH_OP_HPP_
+#define EPOLL_SOCKET_RECV_BATCH_OP_HPP_
+
+#include <sys/socket.h>
+
+#include <cassert>
+#include <concepts>      // NOLINT
+#include <system_error>  // NOLINT
+
+#include "status-code/system_code.hpp"
+
+#include "basic_socket.hpp"
+#include "datagram_batch.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_io_base_op.hpp"
+#include "meta.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// Receive up to `batch.size()` datagrams with one recvmmsg. MSG_DONTWAIT is
+// always passed, otherwise recvmmsg keeps blocking on a blocking socket until
+// the whole batch is filled.
+template <typename ReceiverId, typename Protocol>
+class epoll_context::socket_recv_batch_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  template <typename Derived>
+  using base_op_t = stdexec::__t<
+      epoll_context::socket_io_base_op<ReceiverId, Protocol, Derived>>;
+  using socket_t = typename Protocol::socket;
+  using batch_t = datagram_batch<Protocol>;
+
+ public:
+  struct __t : public base_op_t<__t> {
+    using __id = socket_recv_batch_op;
+    using base_t = base_op_t<__t>;
+    friend base_t;
+
+    // Constructor.
+    constexpr __t(receiver_t receiver, basic_socket<Protocol>& socket,
+                  batch_t& batch) noexcept
+        : base_t(static_cast<receiver_t&&>(receiver),  //
+                 static_cast<socket_t&>(socket)),
+          count_(0),
+          batch_(batch) {}
+
+   private:
+    static constexpr void non_blocking_recv_batch(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      self.batch_.prepare_receive();
+      auto res = self.socket_.non_blocking_recvmmsg(
+          self.batch_.native_messages(),
+          static_cast<unsigned int>(self.batch_.size()), MSG_DONTWAIT);
+      if (res.has_error()) {
+        self.ec_ = static_cast<system_error2::system_code&&>(res.error());
+      } else {
+        self.count_ = res.value();
+      }
+    }
+
+    static void complete(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      if (self.ec_ == errc::operation_canceled) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      } else if (self.ec_ == errc::success) {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                           self.count_);
+      } else {
+        if (self.ec_.domain() ==
+            system_error2::quick_status_code_from_enum_domain<
+                net::network_errc>) {
+          stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                             make_error_code(static_cast<net::network_errc>(
+                                 self.ec_.value())));
+        } else {
+          stdexec::set_error(
+              static_cast<receiver_t&&>(self.receiver_),
+              make_error_code(static_cast<std::errc>(self.ec_.value())));
+        }
+      }
+    }
+
+    static constexpr typename base_t::op_type otype = base_t::op_type::op_read;
+    static constexpr typename base_t::op_vtable op_vtable{
+        &non_blocking_recv_batch, &complete};
+    size_t count_;
+    batch_t& batch_;
+  };
+};
+
+template <typename Protocol>
+class recv_batch_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<
+      epoll_context::socket_recv_batch_op<stdexec::__id<Receiver>, Protocol>>;
+  using socket_t = typename Protocol::socket;
+  using batch_t = datagram_batch<Protocol>;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = recv_batch_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(size_t),
+                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.socket_, self.batch_};
+    }
+
+    constexpr __t(basic_socket<Protocol>& socket, batch_t& batch) noexcept
+        : socket_(static_cast<socket_t&>(socket)), batch_(batch) {}
+
+   private:
+    socket_t& socket_;
+    batch_t& batch_;
+  };
+};
+
+// Receive datagrams into the buffers of `batch`. Completes with the count of
+// datagrams received, their lengths and sources are stored in the batch.
+struct async_recv_batch_t {
+  template <transport_protocol Protocol>
+  constexpr auto operator()(basic_socket<Protocol>& socket,
+                            datagram_batch<Protocol>& batch) const noexcept
+      -> stdexec::__t<recv_batch_sender<Protocol>> {
+    return {socket, batch};
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::async_recv_batch_t async_recv_batch{};
+}  // namespace net
+
+#endif  // EPOLL_SOCKET_RECV_BATCH_OP_HPP_
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef EPOLL_SOCKET_RECV_DYNAMIC_OP_HPP_
+#define EPOLL_SOCKET_RECV_DYNAMIC_OP_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <system_error>  // NOLINT
+#include <type_traits>
+
+#include "status-code/system_code.hpp"
+
+#include "basic_socket.hpp"
+#include "buffer.hpp"
+#include "buffer_sequence_adapter.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_io_base_op.hpp"
+#include "error_channel.hpp"
+#include "meta.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// Receive some data into a dynamic buffer. FIONREAD tells how much is
+// queued, so the buffer grows once to the exact size and a single receive
+// takes all of it. When nothing is queued the receive goes to a small stack
+// buffer instead, which tells the end of the stream or the need to wait
+// without growing the buffer, and data racing in is copied over.
+template <typename ReceiverId, typename Protocol, typename DynamicBuffer,
+          typename Error>
+class epoll_context::socket_recv_dynamic_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  template <typename Derived>
+  using base_op_t = stdexec::__t<
+      epoll_context::socket_io_base_op<ReceiverId, Protocol, Derived>>;
+  using socket_t = typename Protocol::socket;
+  using dynamic_buffer_t = std::remove_cvref_t<DynamicBuffer>;
+  using prepared_t = typename dynamic_buffer_t::mutable_buffers_type;
+  using bufs_t = buffer_sequence_adapter<mutable_buffer, prepared_t>;
+
+  // The size of the stack buffer used when nothing is queued.
+  static constexpr std::size_t bounce_size = 512;
+
+ public:
+  struct __t : public base_op_t<__t> {
+    using __id = socket_recv_dynamic_op;
+    using base_t = base_op_t<__t>;
+    friend base_t;
+
+    // Constructor.
+    constexpr __t(receiver_t receiver, basic_socket<Protocol>& socket,
+                  DynamicBuffer buffers) noexcept
+        : base_t(static_cast<receiver_t&&>(receiver),  //
+                 static_cast<socket_t&>(socket)),
+          buffers_(static_cast<DynamicBuffer&&>(buffers)),
+          bytes_transferred_(0) {}
+
+   private:
+    static void non_blocking_recv(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      self.ec_ = errc::success;
+      const std::size_t size = self.buffers_.size();
+      if (size >= self.buffers_.max_size()) {
+        self.ec_ = errc::no_buffer_space;
+        return;
+      }
+      const std::size_t room = self.buffers_.max_size() - size;
+
+      auto available = self.socket_.available();
+      if (available.has_error()) {
+        self.ec_ = static_cast<system_error2::system_code&&>(available.error());
+        return;
+      }
+      if (available.value() == 0) {
+        char bounce[bounce_size];
+        auto res = self.socket_.non_blocking_recv(
+            bounce, (std::min)(bounce_size, room), 0);
+        if (res.has_error()) {
+          self.ec_ = static_cast<system_error2::system_code&&>(res.error());
+        } else {
+          self.copy_in(bounce, res.value());
+        }
+        return;
+      }
+
+      prepared_t prepared;
+      try {
+        prepared = self.buffers_.prepare((std::min)(available.value(), room));
+      } catch (...) {
+        self.ec_ = errc::no_buffer_space;
+        return;
+      }
+      auto res = self.recv_some(prepared);
+      self.buffers_.commit(res.has_value() ? res.value() : 0);
+      if (res.has_error()) {
+        self.ec_ = static_cast<system_error2::system_code&&>(res.error());
+      } else {
+        self.bytes_transferred_ = res.value();
+      }
+    }
+
+    // Call the socket with the prepared output sequence.
+    constexpr auto recv_some(const prepared_t& prepared) noexcept {
+      bufs_t bufs{prepared};
+      if constexpr (bufs_t::is_single_buffer) {
+        return this->socket_.non_blocking_recv(bufs.buffers()->iov_base,
+                                               bufs.buffers()->iov_len, 0);
+      } else {
+        return this->socket_.non_blocking_recvmsg(bufs.buffers(), bufs.count(),
+                                                  0);
+      }
+    }
+
+    // Append `n` bytes received into the stack buffer.
+    void copy_in(const char* data, std::size_t n) noexcept {
+      prepared_t prepared;
+      try {
+        prepared = buffers_.prepare(n);
+      } catch (...) {
+        this->ec_ = errc::no_buffer_space;
+        return;
+      }
+      buffer_copy(prepared, const_buffer(data, n));
+      buffers_.commit(n);
+      bytes_transferred_ = n;
+    }
+
+    static void complete(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      if (self.ec_ == errc::operation_canceled) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      } else if (self.ec_ == errc::success) {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                           self.bytes_transferred_);
+      } else {
+        stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                           to_error<Error>(self.ec_));
+      }
+    }
+
+    static constexpr typename base_t::op_type otype = base_t::op_type::op_read;
+    static constexpr
+        typename base_t::op_vtable op_vtable{&non_blocking_recv, &complete};
+    DynamicBuffer buffers_;
+    size_t bytes_transferred_;
+  };
+};
+
+template <typename Protocol, typename DynamicBuffer, typename Error>
+class recv_dynamic_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<epoll_context::socket_recv_dynamic_op<
+      stdexec::__id<Receiver>, Protocol, DynamicBuffer, Error>>;
+  using socket_t = typename Protocol::socket;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = recv_dynamic_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(size_t),
+                                       stdexec::set_error_t(Error&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.socket_, self.buffers_};
+    }
+
+    constexpr __t(basic_socket<Protocol>& socket,
+                  DynamicBuffer buffers) noexcept
+        : socket_(static_cast<socket_t&>(socket)),
+          buffers_(static_cast<DynamicBuffer&&>(buffers)) {}
+
+   private:
+    socket_t& socket_;
+    DynamicBuffer buffers_;
+  };
+};
+}  // namespace __epoll
+}  // namespace net
+
+#endif  // EPOLL_SOCKET_RECV_DYNAMIC_OP_HPP_
@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_SOCKET_RECV_FROM_OP_HPP_
+#define EPOLL_SOCKET_RECV_FROM_OP_HPP_
+
+#include <sys/socket.h>
+
+#include <cassert>
+#include <concepts>      // NOLINT
+#include <cstdint>
+#include <system_error>  // NOLINT
+#include <type_traits>
+
+#include "status-code/system_code.hpp"
+
+#include "basic_socket.hpp"
+#include "buffer.hpp"
+#include "buffer_sequence_adapter.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_io_base_op.hpp"
+#include "meta.hpp"
+#include "socket_option.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// Receive one datagram and its source endpoint. If `Segmented` is true, the
+// received data may be several segments coalesced by UDP GRO, and their size
+// is passed to the receiver as well.
+template <typename ReceiverId, typename Protocol, typename Buffers,
+          bool Segmented>
+class epoll_context::socket_recv_from_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  template <typename Derived>
+  using base_op_t = stdexec::__t<
+      epoll_context::socket_io_base_op<ReceiverId, Protocol, Derived>>;
+  using socket_t = typename Protocol::socket;
+  using endpoint_t = typename Protocol::endpoint;
+  using bufs_t = buffer_sequence_adapter<mutable_buffer, Buffers>;
+
+ public:
+  struct __t : public base_op_t<__t> {
+    using __id = socket_recv_from_op;
+    using base_t = base_op_t<__t>;
+    friend base_t;
+
+    // Constructor.
+    constexpr __t(receiver_t receiver, basic_socket<Protocol>& socket,
+                  Buffers buffers) noexcept
+        : base_t(static_cast<receiver_t&&>(receiver),  //
+                 static_cast<socket_t&>(socket)),
+          bytes_transferred_(0),
+          buffers_(buffers),
+          bufs_(buffers_),
+          source_(),
+          segment_size_(0) {}
+
+   private:
+    static constexpr void non_blocking_recv_from(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      // The source is written in place, in its native form.
+      ::sockaddr* source = self.source_.data();
+      if constexpr (Segmented) {
+        // The segment size is only reported with the control message.
+        auto& bufs = self.bufs_;
+        int size = endpoint_t::capacity();
+        auto res = self.socket_.non_blocking_recvmsg_from(
+            bufs.buffers(), bufs.count(), 0, source, &size,
+            &self.segment_size_);
+        if (res.has_error()) {
+          self.ec_ = static_cast<system_error2::system_code&&>(res.error());
+          return;
+        }
+        self.bytes_transferred_ = res.value();
+        self.resize_source(size);
+      } else if constexpr (bufs_t::is_single_buffer) {
+        uint64_t size = endpoint_t::capacity();
+        auto res = self.socket_.non_blocking_recvfrom(
+            self.bufs_.buffers()->iov_base,  //
+            self.bufs_.buffers()->iov_len,   //
+            0, source, &size);
+        if (res.has_error()) {
+          self.ec_ = static_cast<system_error2::system_code&&>(res.error());
+          return;
+        }
+        self.bytes_transferred_ = res.value();
+        self.resize_source(size);
+      } else {
+        auto& bufs = self.bufs_;
+        int size = endpoint_t::capacity();
+        auto res = self.socket_.non_blocking_recvmsg_from(
+            bufs.buffers(), bufs.count(), 0, source, &size);
+        if (res.has_error()) {
+          self.ec_ = static_cast<system_error2::system_code&&>(res.error());
+          return;
+        }
+        self.bytes_transferred_ = res.value();
+        self.resize_source(size);
+      }
+
+      if (!self.source_.is_valid()) {
+        self.ec_ = errc::address_family_not_supported;
+      }
+    }
+
+    // Unix domain addresses vary in size.
+    constexpr void resize_source(uint64_t size) noexcept {
+      if constexpr (requires { source_.resize(::socklen_t{}); }) {
+        source_.resize(static_cast<::socklen_t>(size));
+      }
+    }
+
+    static void complete(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      if (self.ec_ == errc::operation_canceled) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      } else if (self.ec_ == errc::success) {
+        if constexpr (Segmented) {
+          stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                             self.bytes_transferred_,
+                             static_cast<endpoint_t&&>(self.source_),
+                             static_cast<size_t>(self.segment_size_));
+        } else {
+          stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                             self.bytes_transferred_,
+                             static_cast<endpoint_t&&>(self.source_));
+        }
+      } else {
+        if (self.ec_.domain() ==
+            system_error2::quick_status_code_from_enum_domain<
+                net::network_errc>) {
+          stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                             make_error_code(static_cast<net::network_errc>(
+                                 self.ec_.value())));
+        } else {
+          stdexec::set_error(
+              static_cast<receiver_t&&>(self.receiver_),
+              make_error_code(static_cast<std::errc>(self.ec_.value())));
+        }
+      }
+    }
+
+    static constexpr typename base_t::op_type otype = base_t::op_type::op_read;
+    static constexpr typename base_t::op_vtable op_vtable{
+        &non_blocking_recv_from, &complete};
+    size_t bytes_transferred_;
+    Buffers buffers_;
+
+    // The native buffers, translated once when the operation is constructed so
+    // that retries don't walk the sequence again.
+    bufs_t bufs_;
+    endpoint_t source_;
+
+    // The size of coalesced segments, zero for a single datagram.
+    uint16_t segment_size_;
+  };
+};
+
+template <typename Protocol, typename Buffers, bool Segmented = false>
+class recv_from_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<epoll_context::socket_recv_from_op<
+      stdexec::__id<Receiver>, Protocol, Buffers, Segmented>>;
+  using socket_t = typename Protocol::socket;
+  using endpoint_t = typename Protocol::endpoint;
+  using value_signature =
+      std::conditional_t<Segmented,
+                         stdexec::set_value_t(size_t, endpoint_t&&, size_t),
+                         stdexec::set_value_t(size_t, endpoint_t&&)>;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = recv_from_sender;
+    using completion_signatures = stdexec::completion_signatures<
+        value_signature, stdexec::set_error_t(std::error_code&&),
+        stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.socket_, self.buffers_};
+    }
+
+    constexpr __t(basic_socket<Protocol>& socket,  // NOLINT
+                  Buffers buffers) noexcept
+        : socket_(static_cast<socket_t&>(socket)), buffers_(buffers) {}
+
+   private:
+    socket_t& socket_;
+    Buffers buffers_;
+  };
+};
+
+// Receive a datagram into `buffers`. Completes with the size of the datagram
+// and the endpoint it came from.
+struct async_recv_from_t {
+  template <transport_protocol Protocol, mutable_buffer_sequence Buffers>
+  constexpr auto operator()(basic_socket<Protocol>& socket,
+                            Buffers buffers) const noexcept
+      -> stdexec::__t<recv_from_sender<Protocol, Buffers>> {
+    return {socket, buffers};
+  }
+};
+
+// Receive datagrams coalesced by UDP GRO into `buffers`, which needs
+// udp::generic_receive_offload to be enabled on the socket. Completes with
+// the total size, the source endpoint and the size of each segment, the last
+// segment may be shorter. The segment size is zero if a single datagram has
+// been received.
+struct async_recv_segments_t {
+  template <transport_protocol Protocol, mutable_buffer_sequence Buffers>
+  constexpr auto operator()(basic_socket<Protocol>& socket,
+                            Buffers buffers) const noexcept
+      -> stdexec::__t<recv_from_sender<Protocol, Buffers, true>> {
+    return {socket, buffers};
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::async_recv_from_t async_recv_from{};
+inline constexpr __epoll::async_recv_segments_t async_recv_segments{};
+}  // namespace net
+
+#endif  // EPOLL_SOCKET_RECV_FROM_OP_HPP_
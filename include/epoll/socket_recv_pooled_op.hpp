@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_SOCKET_RECV_POOLED_OP_HPP_
+#define EPOLL_SOCKET_RECV_POOLED_OP_HPP_
+
+#include <concepts>      // NOLINT
+#include <system_error>  // NOLINT
+
+#include "status-code/system_code.hpp"
+
+#include "basic_socket.hpp"
+#include "buffer_pool.hpp"
+#include "compact_code.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_io_base_op.hpp"
+#include "meta.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// Receive into a block of the context's receive buffer pool. The block is
+// only claimed while a receive is attempted and goes straight back to the pool
+// if the socket isn't readable, so a parked operation holds no buffer.
+template <typename ReceiverId, typename Protocol>
+class epoll_context::socket_recv_pooled_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  template <typename Derived>
+  using base_op_t = stdexec::__t<
+      epoll_context::socket_io_base_op<ReceiverId, Protocol, Derived>>;
+  using socket_t = typename Protocol::socket;
+
+ public:
+  struct __t : public base_op_t<__t> {
+    using __id = socket_recv_pooled_op;
+    using base_t = base_op_t<__t>;
+    friend base_t;
+
+    // Constructor.
+    constexpr __t(receiver_t receiver, basic_socket<Protocol>& socket) noexcept
+        : base_t(static_cast<receiver_t&&>(receiver),  //
+                 static_cast<socket_t&>(socket)),
+          lease_() {}
+
+   private:
+    static void non_blocking_recv(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      buffer_lease lease = self.context().recv_buffer_pool().acquire();
+      auto res =
+          self.socket_.non_blocking_recv(lease.data(), lease.capacity(), 0);
+      if (res.has_error()) {
+        // The peer closed the connection, the block isn't needed.
+        compact_code ec{res.error()};
+        if (ec != network_errc::eof) {
+          self.ec_ = ec;
+        }
+        return;
+      }
+      if (res.value() != 0) {
+        lease.resize(res.value());
+        self.lease_ = static_cast<buffer_lease&&>(lease);
+      }
+    }
+
+    static void complete(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      if (self.ec_ == errc::operation_canceled) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      } else if (self.ec_ == errc::success) {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                           static_cast<buffer_lease&&>(self.lease_));
+      } else {
+        if (self.ec_.domain() ==
+            system_error2::quick_status_code_from_enum_domain<
+                net::network_errc>) {
+          stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                             make_error_code(static_cast<net::network_errc>(
+                                 self.ec_.value())));
+        } else {
+          stdexec::set_error(
+              static_cast<receiver_t&&>(self.receiver_),
+              make_error_code(static_cast<std::errc>(self.ec_.value())));
+        }
+      }
+    }
+
+    static constexpr typename base_t::op_type otype = base_t::op_type::op_read;
+    static constexpr
+        typename base_t::op_vtable op_vtable{&non_blocking_recv, &complete};
+
+    // The received bytes, handed to the receiver.
+    buffer_lease lease_;
+  };
+};
+
+template <typename Protocol>
+class recv_pooled_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<
+      epoll_context::socket_recv_pooled_op<stdexec::__id<Receiver>, Protocol>>;
+  using socket_t = typename Protocol::socket;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = recv_pooled_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(buffer_lease),
+                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.socket_};
+    }
+
+    explicit constexpr __t(basic_socket<Protocol>& socket) noexcept
+        : socket_(static_cast<socket_t&>(socket)) {}
+
+   private:
+    socket_t& socket_;
+  };
+};
+
+// Receive into a block of the receive buffer pool of the socket's context,
+// see `epoll_context::recv_buffer_pool`. Completes with a lease of the block
+// holding the received bytes, or with an empty lease once the peer closed
+// the connection.
+struct async_recv_pooled_t {
+  template <transport_protocol Protocol>
+  constexpr auto operator()(basic_socket<Protocol>& socket) const noexcept
+      -> stdexec::__t<recv_pooled_sender<Protocol>> {
+    return stdexec::__t<recv_pooled_sender<Protocol>>{socket};
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::async_recv_pooled_t async_recv_pooled{};
+}  // namespace net
+
+#endif  // EPOLL_SOCKET_RECV_POOLED_OP_HPP_
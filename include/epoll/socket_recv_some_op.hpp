@@ -18,7 +18,9 @@
 
 #include <cassert>
 #include <concepts>      // NOLINT
+#include <optional>
 #include <system_error>  // NOLINT
+#include <type_traits>
 
 #include "status-code/system_code.hpp"
 
@@ -27,6 +29,8 @@
 #include "buffer_sequence_adapter.hpp"
 #include "epoll/epoll_context.hpp"
 #include "epoll/socket_io_base_op.hpp"
+#include "epoll/socket_recv_dynamic_op.hpp"
+#include "error_channel.hpp"
 #include "meta.hpp"
 #include "socket_option.hpp"
 #include "stdexec.hpp"
@@ -34,38 +38,46 @@
 namespace net {
 namespace __epoll {
 
-template <typename ReceiverId, typename Protocol, typename Buffers>
+template <typename ReceiverId, typename Protocol, typename Buffers,
+          typename Error>
 class epoll_context::socket_recv_some_op {
   using receiver_t = stdexec::__t<ReceiverId>;
-  using base_t =
-      stdexec::__t<epoll_context::socket_io_base_op<ReceiverId, Protocol>>;
+  template <typename Derived>
+  using base_op_t = stdexec::__t<
+      epoll_context::socket_io_base_op<ReceiverId, Protocol, Derived>>;
   using socket_t = typename Protocol::socket;
   using bufs_t = buffer_sequence_adapter<mutable_buffer, Buffers>;
 
  public:
-  struct __t : public base_t {
+  struct __t : public base_op_t<__t> {
     using __id = socket_recv_some_op;
+    using base_t = base_op_t<__t>;
+    friend base_t;
 
     // Constructor.
     // Note: CPO or constructor interfaces need to use `basic_socket<Protocol>`
     // instead of `Protocol::socket` as the parameter type to infer `Protocol`
     // template parameter. Subsequently, the storage and use of socket arguments
     // are converted to the actual subclass type, which is `Protocol::socket`.
+    // If `deadline` is given, the operation completes with `errc::timed_out`
+    // when the socket is still not ready at that time.
     constexpr __t(receiver_t receiver, basic_socket<Protocol>& socket,
-                  Buffers buffers) noexcept
+                  Buffers buffers,
+                  std::optional<time_point> deadline = std::nullopt) noexcept
         : base_t(static_cast<receiver_t&&>(receiver),  //
                  static_cast<socket_t&>(socket),       //
-                 op_vtable, otype),
+                 deadline),
           bytes_transferred_(0),
-          buffers_(buffers) {}
+          buffers_(buffers),
+          bufs_(buffers_) {}
 
    private:
     static constexpr void non_blocking_recv(base_t* base) noexcept {
       auto& self = *static_cast<__t*>(base);
       if constexpr (bufs_t::is_single_buffer) {
         auto res = self.socket_.non_blocking_recv(
-            bufs_t::first(self.buffers_).data(),  //
-            bufs_t::first(self.buffers_).size(),  //
+            self.bufs_.buffers()->iov_base,  //
+            self.bufs_.buffers()->iov_len,   //
             0);
         if (res.has_error()) {
           self.ec_ = static_cast<system_error2::system_code&&>(res.error());
@@ -73,7 +85,7 @@ class epoll_context::socket_recv_some_op {
           self.bytes_transferred_ += res.value();
         }
       } else {
-        bufs_t bufs(self.buffers_);
+        auto& bufs = self.bufs_;
         auto res =
             self.socket_.non_blocking_recvmsg(bufs.buffers(), bufs.count(), 0);
         if (res.has_error()) {
@@ -92,20 +104,8 @@ class epoll_context::socket_recv_some_op {
         stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
                            self.bytes_transferred_);
       } else {
-        // !Compatible with the use of error_code in stdexec.
-        // Should we changed status_code to error_code or just wait status_code
-        // adopted by standard?
-        if (self.ec_.domain() ==
-            system_error2::quick_status_code_from_enum_domain<
-                net::network_errc>) {
-          stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
-                             make_error_code(static_cast<net::network_errc>(
-                                 self.ec_.value())));
-        } else {
-          stdexec::set_error(
-              static_cast<receiver_t&&>(self.receiver_),
-              make_error_code(static_cast<std::errc>(self.ec_.value())));
-        }
+        stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                           to_error<Error>(self.ec_));
       }
     }
 
@@ -114,16 +114,21 @@ class epoll_context::socket_recv_some_op {
         typename base_t::op_vtable op_vtable{&non_blocking_recv, &complete};
     size_t bytes_transferred_;
     Buffers buffers_;
+
+    // The native buffers, translated once when the operation is constructed so
+    // that retries don't walk the sequence again.
+    bufs_t bufs_;
   };
 };
 
-template <typename Protocol, typename Buffers>
+template <typename Protocol, typename Buffers,
+          error_channel Error = std::error_code>
 class recv_some_sender {
   template <typename Receiver>
-  using op_t =
-      stdexec::__t<epoll_context::socket_recv_some_op<stdexec::__id<Receiver>,
-                                                      Protocol, Buffers>>;
+  using op_t = stdexec::__t<epoll_context::socket_recv_some_op<
+      stdexec::__id<Receiver>, Protocol, Buffers, Error>>;
   using socket_t = typename Protocol::socket;
+  using time_point = epoll_context::time_point;
 
  public:
   struct __t {
@@ -131,7 +136,7 @@ class recv_some_sender {
     using __id = recv_some_sender;
     using completion_signatures =
         stdexec::completion_signatures<stdexec::set_value_t(size_t),
-                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_error_t(Error&&),
                                        stdexec::set_stopped_t()>;
 
     template <typename Env>
@@ -147,37 +152,80 @@ class recv_some_sender {
               stdexec::receiver_of<completion_signatures> Receiver>
     friend auto tag_invoke(stdexec::connect_t, Sender&& self,
                            Receiver receiver) noexcept -> op_t<Receiver> {
-      return {static_cast<Receiver&&>(receiver), self.socket_, self.buffers_};
+      return {static_cast<Receiver&&>(receiver), self.socket_, self.buffers_,
+              self.deadline_};
     }
 
     constexpr __t(basic_socket<Protocol>& socket,  // NOLINT
-                  Buffers buffers) noexcept
-        : socket_(static_cast<socket_t&>(socket)), buffers_(buffers) {}
+                  Buffers buffers,
+                  std::optional<time_point> deadline = std::nullopt) noexcept
+        : socket_(static_cast<socket_t&>(socket)),
+          buffers_(buffers),
+          deadline_(deadline) {}
 
     explicit constexpr __t(const recv_some_sender& other) noexcept
-        : socket_(other.socket_), buffers_(other.buffers_) {}
+        : socket_(other.socket_),
+          buffers_(other.buffers_),
+          deadline_(other.deadline_) {}
 
     explicit constexpr __t(recv_some_sender&& other) noexcept
         : socket_(other.socket_),
-          buffers_(static_cast<Buffers&&>(other.buffers_)) {}
+          buffers_(static_cast<Buffers&&>(other.buffers_)),
+          deadline_(other.deadline_) {}
 
    private:
     socket_t& socket_;
     Buffers buffers_;
+
+    // The time by which the operation must have completed.
+    std::optional<time_point> deadline_;
   };
 };
 
+// `Error` is the type of the error channel.
+template <error_channel Error = std::error_code>
 struct async_recv_some_t {
   template <transport_protocol Protocol, mutable_buffer_sequence Buffers>
   constexpr auto operator()(basic_socket<Protocol>& socket,
                             Buffers buffers) const noexcept
-      -> stdexec::__t<recv_some_sender<Protocol, Buffers>> {
+      -> stdexec::__t<recv_some_sender<Protocol, Buffers, Error>> {
     return {socket, buffers};
   }
+
+  // The operation completes with `errc::timed_out` if the socket doesn't
+  // become ready before `deadline`. The deadline is linked into the timer heap
+  // of the socket's context only once the operation has to wait.
+  template <transport_protocol Protocol, mutable_buffer_sequence Buffers>
+  constexpr auto operator()(basic_socket<Protocol>& socket, Buffers buffers,
+                            epoll_context::time_point deadline) const noexcept
+      -> stdexec::__t<recv_some_sender<Protocol, Buffers, Error>> {
+    return {socket, buffers, deadline};
+  }
+
+  // Grow a dynamic buffer such as `dynamic_buffer(str)` once by the bytes
+  // queued on the socket and receive all of them in a single call. Adapters
+  // are copied into the operation, an lvalue like a `dynamic_ring_buffer` is
+  // referenced.
+  template <transport_protocol Protocol, typename DynamicBuffer>
+    requires dynamic_buffer_sequence<std::remove_cvref_t<DynamicBuffer>> &&
+             (!mutable_buffer_sequence<std::remove_cvref_t<DynamicBuffer>>) &&
+             (!std::is_const_v<std::remove_reference_t<DynamicBuffer>>) &&
+             (std::is_lvalue_reference_v<DynamicBuffer> ||
+              std::copy_constructible<DynamicBuffer>)
+  constexpr auto operator()(basic_socket<Protocol>& socket,
+                            DynamicBuffer&& buffers) const noexcept
+      -> stdexec::__t<recv_dynamic_sender<Protocol, DynamicBuffer, Error>> {
+    return {socket, static_cast<DynamicBuffer&&>(buffers)};
+  }
 };
 }  // namespace __epoll
 
-inline constexpr __epoll::async_recv_some_t async_recv_some{};
+inline constexpr __epoll::async_recv_some_t<> async_recv_some{};
+
+// Like `async_recv_some`, but errors are delivered as `Error`, for example
+// `system_error2::system_code` to skip the conversion to `std::error_code`.
+template <error_channel Error>
+inline constexpr __epoll::async_recv_some_t<Error> async_recv_some_as{};
 }  // namespace net
 
 #endif  // EPOLL_SOCKET_RECV_SOME_OP_HPP_
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef EPOLL_SOCKET_RECV_TLS_RECORD_OP_HPP_
+#define EPOLL_SOCKET_RECV_TLS_RECORD_OP_HPP_
+
+#include <cstdint>
+#include <system_error>  // NOLINT
+
+#include "status-code/system_code.hpp"
+
+#include "basic_socket.hpp"
+#include "basic_stream_socket.hpp"
+#include "buffer.hpp"
+#include "buffer_sequence_adapter.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_io_base_op.hpp"
+#include "error_channel.hpp"
+#include "meta.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// Receive the payload of kernel TLS records. Completes with the count of
+// bytes and the record type, which changes between records when the peer
+// sends an alert or a handshake message, e.g. a TLS 1.3 key update.
+template <typename ReceiverId, typename Protocol, typename Buffers>
+class epoll_context::socket_recv_tls_record_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  template <typename Derived>
+  using base_op_t = stdexec::__t<
+      epoll_context::socket_io_base_op<ReceiverId, Protocol, Derived>>;
+  using socket_t = typename Protocol::socket;
+  using bufs_t = buffer_sequence_adapter<mutable_buffer, Buffers>;
+
+ public:
+  struct __t : public base_op_t<__t> {
+    using __id = socket_recv_tls_record_op;
+    using base_t = base_op_t<__t>;
+    friend base_t;
+
+    // Constructor.
+    constexpr __t(receiver_t receiver, basic_socket<Protocol>& socket,
+                  Buffers buffers) noexcept
+        : base_t(static_cast<receiver_t&&>(receiver),  //
+                 static_cast<socket_t&>(socket)),
+          bytes_transferred_(0),
+          record_type_(socket_t::tls_application_data),
+          buffers_(buffers),
+          bufs_(buffers_) {}
+
+   private:
+    static constexpr void non_blocking_recv(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      auto res = self.socket_.non_blocking_recv_tls_record(
+          self.bufs_.buffers(), self.bufs_.count(), self.record_type_);
+      if (res.has_error()) {
+        self.ec_ = static_cast<system_error2::system_code&&>(res.error());
+      } else {
+        self.bytes_transferred_ = res.value();
+      }
+    }
+
+    static void complete(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      if (self.ec_ == errc::operation_canceled) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      } else if (self.ec_ == errc::success) {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                           self.bytes_transferred_, self.record_type_);
+      } else {
+        stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                           to_error<std::error_code>(self.ec_));
+      }
+    }
+
+    static constexpr typename base_t::op_type otype = base_t::op_type::op_read;
+    static constexpr
+        typename base_t::op_vtable op_vtable{&non_blocking_recv, &complete};
+    size_t bytes_transferred_;
+    uint8_t record_type_;
+    Buffers buffers_;
+    bufs_t bufs_;
+  };
+};
+
+template <typename Protocol, typename Buffers>
+class recv_tls_record_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<epoll_context::socket_recv_tls_record_op<
+      stdexec::__id<Receiver>, Protocol, Buffers>>;
+  using socket_t = typename Protocol::socket;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = recv_tls_record_sender;
+    using completion_signatures = stdexec::completion_signatures<
+        stdexec::set_value_t(size_t, uint8_t),
+        stdexec::set_error_t(std::error_code&&), stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.socket_, self.buffers_};
+    }
+
+    constexpr __t(basic_socket<Protocol>& socket, Buffers buffers) noexcept
+        : socket_(static_cast<socket_t&>(socket)), buffers_(buffers) {}
+
+   private:
+    socket_t& socket_;
+    Buffers buffers_;
+  };
+};
+
+// Receive from a stream socket with kernel TLS enabled for reception, see
+// `basic_stream_socket::set_tls_crypto`. Sending needs no special operation,
+// plain sends are encrypted as application data.
+struct async_recv_tls_record_t {
+  template <transport_protocol Protocol, mutable_buffer_sequence Buffers>
+  constexpr auto operator()(basic_socket<Protocol>& socket,
+                            Buffers buffers) const noexcept
+      -> stdexec::__t<recv_tls_record_sender<Protocol, Buffers>> {
+    return {socket, buffers};
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::async_recv_tls_record_t async_recv_tls_record{};
+}  // namespace net
+
+#endif  // EPOLL_SOCKET_RECV_TLS_RECORD_OP_HPP_
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_SOCKET_RECV_UNTIL_OP_HPP_
+#define EPOLL_SOCKET_RECV_UNTIL_OP_HPP_
+
+#include <algorithm>
+#include <concepts>      // NOLINT
+#include <string_view>
+#include <system_error>  // NOLINT
+#include <type_traits>
+
+#include "status-code/system_code.hpp"
+
+#include "basic_socket.hpp"
+#include "buffer.hpp"
+#include "buffer_sequence_adapter.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_io_base_op.hpp"
+#include "meta.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// Receive into a dynamic buffer until its input sequence contains a
+// delimiter. The operation keeps its registration across partial receives and
+// only scans the bytes received since the last scan, plus the few bytes a
+// delimiter may have started in.
+template <typename ReceiverId, typename Protocol, typename DynamicBuffer>
+class epoll_context::socket_recv_until_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  template <typename Derived>
+  using base_op_t = stdexec::__t<
+      epoll_context::socket_io_base_op<ReceiverId, Protocol, Derived>>;
+  using socket_t = typename Protocol::socket;
+  using dynamic_buffer_t = std::remove_cvref_t<DynamicBuffer>;
+  using prepared_t = typename dynamic_buffer_t::mutable_buffers_type;
+  using bufs_t = buffer_sequence_adapter<mutable_buffer, prepared_t>;
+
+  // The bounds of the size of each receive.
+  static constexpr std::size_t min_recv_size = 512;
+  static constexpr std::size_t max_recv_size = 65536;
+
+ public:
+  struct __t : public base_op_t<__t> {
+    using __id = socket_recv_until_op;
+    using base_t = base_op_t<__t>;
+    friend base_t;
+
+    // Constructor.
+    constexpr __t(receiver_t receiver, basic_socket<Protocol>& socket,
+                  DynamicBuffer buffers, std::string_view delim) noexcept
+        : base_t(static_cast<receiver_t&&>(receiver),  //
+                 static_cast<socket_t&>(socket)),
+          buffers_(static_cast<DynamicBuffer&&>(buffers)),
+          delim_(delim),
+          search_pos_(0) {}
+
+   private:
+    static void non_blocking_recv(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      self.ec_ = errc::success;
+      while (true) {
+        std::size_t pos =
+            buffer_find(self.buffers_.data(), self.delim_, self.search_pos_);
+        if (pos != std::string_view::npos) {
+          self.search_pos_ = pos + self.delim_.size();
+          return;
+        }
+        std::size_t size = self.buffers_.size();
+        self.search_pos_ =
+            size < self.delim_.size() ? 0 : size - self.delim_.size() + 1;
+        if (size >= self.buffers_.max_size()) {
+          self.ec_ = errc::no_buffer_space;
+          return;
+        }
+
+        std::size_t n = (std::min)(
+            std::clamp(self.buffers_.capacity() - size, min_recv_size,
+                       max_recv_size),
+            self.buffers_.max_size() - size);
+        prepared_t prepared;
+        try {
+          prepared = self.buffers_.prepare(n);
+        } catch (...) {
+          self.ec_ = errc::no_buffer_space;
+          return;
+        }
+        auto res = self.recv_some(prepared);
+        self.buffers_.commit(res.has_value() ? res.value() : 0);
+        if (res.has_error()) {
+          self.ec_ = static_cast<system_error2::system_code&&>(res.error());
+          return;
+        }
+        // Datagram-style zero reads end the stream too.
+        if (res.value() == 0) {
+          self.ec_ = network_errc::eof;
+          return;
+        }
+      }
+    }
+
+    // Call the socket with the prepared output sequence.
+    constexpr auto recv_some(const prepared_t& prepared) noexcept {
+      bufs_t bufs{prepared};
+      if constexpr (bufs_t::is_single_buffer) {
+        return this->socket_.non_blocking_recv(bufs.buffers()->iov_base,
+                                               bufs.buffers()->iov_len, 0);
+      } else {
+        return this->socket_.non_blocking_recvmsg(bufs.buffers(), bufs.count(),
+                                                  0);
+      }
+    }
+
+    static void complete(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      if (self.ec_ == errc::operation_canceled) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      } else if (self.ec_ == errc::success) {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                           self.search_pos_);
+      } else {
+        if (self.ec_.domain() ==
+            system_error2::quick_status_code_from_enum_domain<
+                net::network_errc>) {
+          stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                             make_error_code(static_cast<net::network_errc>(
+                                 self.ec_.value())));
+        } else {
+          stdexec::set_error(
+              static_cast<receiver_t&&>(self.receiver_),
+              make_error_code(static_cast<std::errc>(self.ec_.value())));
+        }
+      }
+    }
+
+    static constexpr typename base_t::op_type otype = base_t::op_type::op_read;
+    static constexpr
+        typename base_t::op_vtable op_vtable{&non_blocking_recv, &complete};
+    DynamicBuffer buffers_;
+    std::string_view delim_;
+
+    // Where the next scan starts. Once the delimiter is found, the size of
+    // the input sequence up to and including it.
+    std::size_t search_pos_;
+  };
+};
+
+template <typename Protocol, typename DynamicBuffer>
+class recv_until_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<epoll_context::socket_recv_until_op<
+      stdexec::__id<Receiver>, Protocol, DynamicBuffer>>;
+  using socket_t = typename Protocol::socket;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = recv_until_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(size_t),
+                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.socket_, self.buffers_,
+              self.delim_};
+    }
+
+    constexpr __t(basic_socket<Protocol>& socket, DynamicBuffer buffers,
+                  std::string_view delim) noexcept
+        : socket_(static_cast<socket_t&>(socket)),
+          buffers_(static_cast<DynamicBuffer&&>(buffers)),
+          delim_(delim) {}
+
+   private:
+    socket_t& socket_;
+    DynamicBuffer buffers_;
+    std::string_view delim_;
+  };
+};
+
+// Receive into `buffers` until its input sequence contains `delim`. Completes
+// with the size of the input sequence up to and including the first
+// delimiter, bytes after it stay in the buffer for the next call. Adapters
+// such as `dynamic_buffer(str)` are copied into the operation, an lvalue like
+// a `dynamic_ring_buffer` is referenced. The delimiter isn't copied and must
+// outlive the operation. Fails with `errc::no_buffer_space` if the buffer
+// reaches its maximum size first.
+struct async_recv_until_t {
+  template <transport_protocol Protocol, typename DynamicBuffer>
+    requires dynamic_buffer_sequence<std::remove_cvref_t<DynamicBuffer>> &&
+             (!std::is_const_v<std::remove_reference_t<DynamicBuffer>>) &&
+             (std::is_lvalue_reference_v<DynamicBuffer> ||
+              std::copy_constructible<DynamicBuffer>)
+  constexpr auto operator()(basic_socket<Protocol>& socket,
+                            DynamicBuffer&& buffers,
+                            std::string_view delim) const noexcept
+      -> stdexec::__t<recv_until_sender<Protocol, DynamicBuffer>> {
+    return {socket, static_cast<DynamicBuffer&&>(buffers), delim};
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::async_recv_until_t async_recv_until{};
+}  // namespace net
+
+#endif  // EPOLL_SOCKET_RECV_UNTIL_OP_HPP_
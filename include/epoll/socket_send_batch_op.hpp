@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_SOCKET_SEND_BATCH_OP_HPP_
+#define EPOLL_SOCKET_SEND_BATCH_OP_HPP_
+
+#include <sys/socket.h>
+
+#include <cassert>
+#include <concepts>      // NOLINT
+#include <system_error>  // NOLINT
+
+#include "status-code/system_code.hpp"
+
+#include "basic_socket.hpp"
+#include "datagram_batch.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_io_base_op.hpp"
+#include "meta.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// Send all datagrams of a batch with as few sendmmsg calls as possible. If
+// the send buffer fills up, the operation waits and sends the rest. If an
+// error occurs after some datagrams have been sent, the operation completes
+// with that count, as sendmmsg itself does, and the error is reported by the
+// next send.
+template <typename ReceiverId, typename Protocol>
+class epoll_context::socket_send_batch_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  template <typename Derived>
+  using base_op_t = stdexec::__t<
+      epoll_context::socket_io_base_op<ReceiverId, Protocol, Derived>>;
+  using socket_t = typename Protocol::socket;
+  using batch_t = datagram_batch<Protocol>;
+
+ public:
+  struct __t : public base_op_t<__t> {
+    using __id = socket_send_batch_op;
+    using base_t = base_op_t<__t>;
+    friend base_t;
+
+    // Constructor.
+    constexpr __t(receiver_t receiver, basic_socket<Protocol>& socket,
+                  batch_t& batch) noexcept
+        : base_t(static_cast<receiver_t&&>(receiver),  //
+                 static_cast<socket_t&>(socket)),
+          count_(0),
+          batch_(batch) {}
+
+   private:
+    static constexpr void non_blocking_send_batch(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      while (self.count_ < self.batch_.size()) {
+        auto res = self.socket_.non_blocking_sendmmsg(
+            self.batch_.native_messages() + self.count_,
+            static_cast<unsigned int>(self.batch_.size() - self.count_),
+            MSG_DONTWAIT);
+        if (res.has_error()) {
+          self.ec_ = static_cast<system_error2::system_code&&>(res.error());
+          if (self.count_ > 0 && !self.would_block()) {
+            self.ec_ = errc::success;
+          }
+          return;
+        }
+        self.count_ += res.value();
+      }
+    }
+
+    static void complete(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      if (self.ec_ == errc::operation_canceled) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      } else if (self.ec_ == errc::success) {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                           self.count_);
+      } else {
+        if (self.ec_.domain() ==
+            system_error2::quick_status_code_from_enum_domain<
+                net::network_errc>) {
+          stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                             make_error_code(static_cast<net::network_errc>(
+                                 self.ec_.value())));
+        } else {
+          stdexec::set_error(
+              static_cast<receiver_t&&>(self.receiver_),
+              make_error_code(static_cast<std::errc>(self.ec_.value())));
+        }
+      }
+    }
+
+    static constexpr typename base_t::op_type otype = base_t::op_type::op_write;
+    static constexpr typename base_t::op_vtable op_vtable{
+        &non_blocking_send_batch, &complete};
+    size_t count_;
+    batch_t& batch_;
+  };
+};
+
+template <typename Protocol>
+class send_batch_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<
+      epoll_context::socket_send_batch_op<stdexec::__id<Receiver>, Protocol>>;
+  using socket_t = typename Protocol::socket;
+  using batch_t = datagram_batch<Protocol>;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = send_batch_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(size_t),
+                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.socket_, self.batch_};
+    }
+
+    constexpr __t(basic_socket<Protocol>& socket, batch_t& batch) noexcept
+        : socket_(static_cast<socket_t&>(socket)), batch_(batch) {}
+
+   private:
+    socket_t& socket_;
+    batch_t& batch_;
+  };
+};
+
+// Send the datagrams of `batch` to their peers. Completes with the count of
+// datagrams sent.
+struct async_send_batch_t {
+  template <transport_protocol Protocol>
+  constexpr auto operator()(basic_socket<Protocol>& socket,
+                            datagram_batch<Protocol>& batch) const noexcept
+      -> stdexec::__t<send_batch_sender<Protocol>> {
+    return {socket, batch};
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::async_send_batch_t async_send_batch{};
+}  // namespace net
+
+#endif  // EPOLL_SOCKET_SEND_BATCH_OP_HPP_
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef EPOLL_SOCKET_SEND_FDS_OP_HPP_
+#define EPOLL_SOCKET_SEND_FDS_OP_HPP_
+
+#include <cstddef>
+#include <span>          // NOLINT
+#include <system_error>  // NOLINT
+
+#include "status-code/system_code.hpp"
+
+#include "basic_socket.hpp"
+#include "buffer.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_io_base_op.hpp"
+#include "error_channel.hpp"
+#include "meta.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// Send bytes along with descriptors over a unix domain socket, e.g. to hand
+// an accepted connection to a worker process. The descriptors go with the
+// first byte, so they are sent exactly once even if only a part of the bytes
+// is. The caller keeps ownership of them and may close them once the
+// operation completes.
+template <typename ReceiverId, typename Protocol>
+class epoll_context::socket_send_fds_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  template <typename Derived>
+  using base_op_t = stdexec::__t<
+      epoll_context::socket_io_base_op<ReceiverId, Protocol, Derived>>;
+  using socket_t = typename Protocol::socket;
+
+ public:
+  struct __t : public base_op_t<__t> {
+    using __id = socket_send_fds_op;
+    using base_t = base_op_t<__t>;
+    friend base_t;
+
+    // Constructor.
+    constexpr __t(receiver_t receiver, basic_socket<Protocol>& socket,
+                  const_buffer buffer, std::span<const int> fds) noexcept
+        : base_t(static_cast<receiver_t&&>(receiver),  //
+                 static_cast<socket_t&>(socket)),
+          bytes_transferred_(0),
+          buffer_(buffer),
+          fds_(fds) {}
+
+   private:
+    static constexpr void non_blocking_send(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      auto res = self.socket_.non_blocking_send_fds(
+          self.buffer_.data(), self.buffer_.size(), self.fds_.data(),
+          self.fds_.size());
+      if (res.has_error()) {
+        self.ec_ = static_cast<system_error2::system_code&&>(res.error());
+      } else {
+        self.bytes_transferred_ = res.value();
+      }
+    }
+
+    static void complete(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      if (self.ec_ == errc::operation_canceled) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      } else if (self.ec_ == errc::success) {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                           self.bytes_transferred_);
+      } else {
+        stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                           to_error<std::error_code>(self.ec_));
+      }
+    }
+
+    static constexpr typename base_t::op_type otype = base_t::op_type::op_write;
+    static constexpr
+        typename base_t::op_vtable op_vtable{&non_blocking_send, &complete};
+    size_t bytes_transferred_;
+    const_buffer buffer_;
+    std::span<const int> fds_;
+  };
+};
+
+template <typename Protocol>
+class send_fds_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<
+      epoll_context::socket_send_fds_op<stdexec::__id<Receiver>, Protocol>>;
+  using socket_t = typename Protocol::socket;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = send_fds_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(size_t),
+                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.socket_, self.buffer_,
+              self.fds_};
+    }
+
+    constexpr __t(basic_socket<Protocol>& socket, const_buffer buffer,
+                  std::span<const int> fds) noexcept
+        : socket_(static_cast<socket_t&>(socket)),
+          buffer_(buffer),
+          fds_(fds) {}
+
+   private:
+    socket_t& socket_;
+    const_buffer buffer_;
+    std::span<const int> fds_;
+  };
+};
+
+// Send `buffer`, which must not be empty, and the descriptors `fds`, at most
+// `basic_socket::max_passed_fds`, over a unix domain socket. Completes with
+// the count of bytes sent.
+struct async_send_fds_t {
+  template <transport_protocol Protocol>
+  constexpr auto operator()(basic_socket<Protocol>& socket,
+                            const_buffer buffer,
+                            std::span<const int> fds) const noexcept
+      -> stdexec::__t<send_fds_sender<Protocol>> {
+    return {socket, buffer, fds};
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::async_send_fds_t async_send_fds{};
+}  // namespace net
+
+#endif  // EPOLL_SOCKET_SEND_FDS_OP_HPP_
@@ -18,6 +18,7 @@
 
 #include <cassert>
 #include <concepts>      // NOLINT
+#include <optional>
 #include <system_error>  // NOLINT
 
 #include "status-code/system_code.hpp"
@@ -37,35 +38,42 @@ namespace __epoll {
 template <typename ReceiverId, typename Protocol, typename Buffers>
 class epoll_context::socket_send_some_op {
   using receiver_t = stdexec::__t<ReceiverId>;
-  using base_t =
-      stdexec::__t<epoll_context::socket_io_base_op<ReceiverId, Protocol>>;
+  template <typename Derived>
+  using base_op_t = stdexec::__t<
+      epoll_context::socket_io_base_op<ReceiverId, Protocol, Derived>>;
   using socket_t = typename Protocol::socket;
   using bufs_t = buffer_sequence_adapter<const_buffer, Buffers>;
 
  public:
-  struct __t : public base_t {
+  struct __t : public base_op_t<__t> {
     using __id = socket_send_some_op;
+    using base_t = base_op_t<__t>;
+    friend base_t;
 
     // Constructor.
     // Note: CPO or constructor interfaces need to use `basic_socket<Protocol>`
     // instead of `Protocol::socket` as the parameter type to infer `Protocol`
     // template parameter. Subsequently, the storage and use of socket arguments
     // are converted to the actual subclass type, which is `Protocol::socket`.
+    // If `deadline` is given, the operation completes with `errc::timed_out`
+    // when the socket is still not ready at that time.
     constexpr __t(receiver_t receiver, basic_socket<Protocol>& socket,
-                  Buffers buffers) noexcept
+                  Buffers buffers,
+                  std::optional<time_point> deadline = std::nullopt) noexcept
         : base_t(static_cast<receiver_t&&>(receiver),  //
                  static_cast<socket_t&>(socket),       //
-                 op_vtable, otype),
+                 deadline),
           bytes_transferred_(0),
-          buffers_(buffers) {}
+          buffers_(buffers),
+          bufs_(buffers_) {}
 
    private:
     static constexpr void non_blocking_send(base_t* base) noexcept {
       auto& self = *static_cast<__t*>(base);
       if constexpr (bufs_t::is_single_buffer) {
         auto res = self.socket_.non_blocking_send(
-            bufs_t::first(self.buffers_).data(),  //
-            bufs_t::first(self.buffers_).size(),  //
+            self.bufs_.buffers()->iov_base,  //
+            self.bufs_.buffers()->iov_len,   //
             0);
         if (res.has_error()) {
           self.ec_ = static_cast<system_error2::system_code&&>(res.error());
@@ -73,14 +81,24 @@ class epoll_context::socket_send_some_op {
           self.bytes_transferred_ += res.value();
         }
       } else {
-        bufs_t bufs(self.buffers_);
-        auto res =
-            self.socket_.non_blocking_sendmsg(bufs.buffers(), bufs.count(), 0);
-        if (res.has_error()) {
-          self.ec_ = static_cast<system_error2::system_code&&>(res.error());
-        } else {
-          self.bytes_transferred_ += res.value();
-        }
+        // A sequence longer than a single call takes is walked by further
+        // calls as long as the previous ones sent everything.
+        auto& bufs = self.bufs_;
+        size_t sent = 0;
+        do {
+          auto res = self.socket_.non_blocking_sendmsg(bufs.buffers(),
+                                                       bufs.count(), 0);
+          if (res.has_error()) {
+            // Bytes already sent are reported, the error shows up again.
+            if (sent == 0) {
+              self.ec_ = static_cast<system_error2::system_code&&>(res.error());
+            }
+            break;
+          }
+          sent += res.value();
+          bufs.consume(res.value());
+        } while (bufs.all_empty() && bufs.refill());
+        self.bytes_transferred_ += sent;
       }
     }
 
@@ -114,6 +132,10 @@ class epoll_context::socket_send_some_op {
         typename base_t::op_vtable op_vtable{&non_blocking_send, &complete};
     size_t bytes_transferred_;
     Buffers buffers_;
+
+    // The native buffers, translated once when the operation is constructed so
+    // that retries don't walk the sequence again.
+    bufs_t bufs_;
   };
 };
 
@@ -124,6 +146,7 @@ class send_some_sender {
       stdexec::__t<epoll_context::socket_send_some_op<stdexec::__id<Receiver>,
                                                       Protocol, Buffers>>;
   using socket_t = typename Protocol::socket;
+  using time_point = epoll_context::time_point;
 
  public:
   struct __t {
@@ -147,23 +170,33 @@ class send_some_sender {
               stdexec::receiver_of<completion_signatures> Receiver>
     friend auto tag_invoke(stdexec::connect_t, Sender&& self,
                            Receiver receiver) noexcept -> op_t<Receiver> {
-      return {static_cast<Receiver&&>(receiver), self.socket_, self.buffers_};
+      return {static_cast<Receiver&&>(receiver), self.socket_, self.buffers_,
+              self.deadline_};
     }
 
     constexpr __t(basic_socket<Protocol>& socket,  // NOLINT
-                  Buffers buffers) noexcept
-        : socket_(static_cast<socket_t&>(socket)), buffers_(buffers) {}
+                  Buffers buffers,
+                  std::optional<time_point> deadline = std::nullopt) noexcept
+        : socket_(static_cast<socket_t&>(socket)),
+          buffers_(buffers),
+          deadline_(deadline) {}
 
     explicit constexpr __t(const send_some_sender& other) noexcept
-        : socket_(other.socket_), buffers_(other.buffers_) {}
+        : socket_(other.socket_),
+          buffers_(other.buffers_),
+          deadline_(other.deadline_) {}
 
     explicit constexpr __t(send_some_sender&& other) noexcept
         : socket_(other.socket_),
-          buffers_(static_cast<Buffers&&>(other.buffers_)) {}
+          buffers_(static_cast<Buffers&&>(other.buffers_)),
+          deadline_(other.deadline_) {}
 
    private:
     socket_t& socket_;
     Buffers buffers_;
+
+    // The time by which the operation must have completed.
+    std::optional<time_point> deadline_;
   };
 };
 
@@ -174,6 +207,16 @@ struct async_send_some_t {
       -> stdexec::__t<send_some_sender<Protocol, Buffers>> {
     return {socket, buffers};
   }
+
+  // The operation completes with `errc::timed_out` if the socket doesn't
+  // become ready before `deadline`. The deadline is linked into the timer heap
+  // of the socket's context only once the operation has to wait.
+  template <transport_protocol Protocol, const_buffer_sequence Buffers>
+  constexpr auto operator()(basic_socket<Protocol>& socket, Buffers buffers,
+                            epoll_context::time_point deadline) const noexcept
+      -> stdexec::__t<send_some_sender<Protocol, Buffers>> {
+    return {socket, buffers, deadline};
+  }
 };
 }  // namespace __epoll
 
@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_SOCKET_SEND_TO_ALL_OP_HPP_
+#define EPOLL_SOCKET_SEND_TO_ALL_OP_HPP_
+
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <ranges>        // NOLINT
+#include <span>          // NOLINT
+#include <system_error>  // NOLINT
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "status-code/system_code.hpp"
+
+#include "basic_socket.hpp"
+#include "buffer.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_io_base_op.hpp"
+#include "error_channel.hpp"
+#include "meta.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// Send one payload to every socket of a set. Each socket is sent to by its
+// own socket I/O operation, which first writes inline on the io thread and
+// only parks the sockets which can't take the whole payload at once. The
+// payload is referenced by a single iovec array shared by these sends, pass
+// a `shared_buffer_chain` to share its memory with other operations.
+template <typename ReceiverId, typename Protocol, typename Buffers>
+class epoll_context::socket_send_to_all_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  using socket_t = typename Protocol::socket;
+
+  // The count of iovecs passed to one sendmsg.
+  static constexpr size_t max_window = 64;
+
+ public:
+  struct __t;
+
+ private:
+  // The receiver of the send to one socket. Its stop token is the one of the
+  // operation, so stopping the operation stops every parked send.
+  struct entry_receiver {
+    using is_receiver = void;
+    using __t = entry_receiver;
+    using __id = entry_receiver;
+
+    friend void tag_invoke(stdexec::set_value_t, entry_receiver&& self,
+                           std::error_code ec) noexcept {
+      self.op_->on_entry_done(self.index_, ec);
+    }
+
+    friend void tag_invoke(stdexec::set_stopped_t,
+                           entry_receiver&& self) noexcept {
+      self.op_->on_entry_stopped();
+    }
+
+    friend auto tag_invoke(stdexec::get_env_t,
+                           const entry_receiver& self) noexcept
+        -> stdexec::env_of_t<receiver_t> {
+      return stdexec::get_env(self.op_->receiver_);
+    }
+
+    socket_send_to_all_op::__t* op_;
+    size_t index_;
+  };
+
+  template <typename Derived>
+  using base_op_t = stdexec::__t<
+      epoll_context::socket_io_base_op<entry_receiver, Protocol, Derived>>;
+
+  // The send of the payload to one socket. Completes with the result of the
+  // socket, a cleared code means the whole payload was sent.
+  struct entry : public base_op_t<entry> {
+    using base_t = base_op_t<entry>;
+    friend base_t;
+
+    // Constructor.
+    entry(socket_send_to_all_op::__t& op, size_t index,
+          socket_t& socket) noexcept
+        : base_t(entry_receiver{&op, index}, socket), sent_(0) {}
+
+   private:
+    // Send the rest of the payload.
+    static void non_blocking_send(base_t* base) noexcept {
+      auto& self = *static_cast<entry*>(base);
+      auto& op = *self.receiver_.op_;
+      self.ec_ = errc::success;
+      while (self.sent_ < op.total_) {
+        auto res = op.send_from(self.socket_, self.sent_);
+        if (res.has_error()) {
+          self.ec_ = static_cast<system_error2::system_code&&>(res.error());
+          return;
+        }
+        self.sent_ += res.value();
+      }
+    }
+
+    // A closed socket or a drain cancels the send to this socket only, so
+    // it's reported as its result like any other error.
+    static void complete(base_t* base) noexcept {
+      auto& self = *static_cast<entry*>(base);
+      stdexec::set_value(static_cast<entry_receiver&&>(self.receiver_),
+                         to_error<std::error_code>(self.ec_));
+    }
+
+    static constexpr typename base_t::op_type otype = base_t::op_type::op_write;
+    static constexpr
+        typename base_t::op_vtable op_vtable{&non_blocking_send, &complete};
+    size_t sent_;
+  };
+
+ public:
+  struct __t : public stdexec::__immovable,
+               private epoll_context::completion_op {
+    using __id = socket_send_to_all_op;
+
+    // Constructor.
+    __t(receiver_t receiver, std::span<socket_t* const> sockets,
+        Buffers buffers) noexcept
+        : receiver_(static_cast<receiver_t&&>(receiver)),
+          sockets_(sockets),
+          context_(sockets.empty()
+                       ? nullptr
+                       : &static_cast<epoll_context&>(
+                             sockets.front()->context())),
+          buffers_(static_cast<Buffers&&>(buffers)),
+          total_(0),
+          pending_(0),
+          stopped_(false) {}
+
+    friend void tag_invoke(stdexec::start_t, __t& self) noexcept {
+      self.start_impl();
+    }
+
+   private:
+    friend entry_receiver;
+    friend entry;
+
+    void start_impl() noexcept {
+      if (context_ == nullptr) {
+        stdexec::set_value(static_cast<receiver_t&&>(receiver_),
+                           std::vector<std::error_code>{});
+      } else if (!context_->is_running_on_io_thread()) {
+        static_cast<completion_op*>(this)->execute_ =
+            &__t::on_schedule_complete;
+        context_->schedule_remote(static_cast<completion_op*>(this));
+      } else {
+        perform();
+      }
+    }
+
+    // epoll_context starts to execute this operation in the io thread.
+    static void on_schedule_complete(operation_base* op) noexcept {
+      static_cast<__t*>(static_cast<completion_op*>(op))->perform();
+    }
+
+    // Start the send to every socket. This function is not thread safe, it
+    // must be executed in io thread, where the sends complete as well.
+    void perform() noexcept {
+      assert(context_->is_running_on_io_thread());
+      try {
+        prepare();
+      } catch (const std::bad_alloc&) {
+        stdexec::set_error(
+            static_cast<receiver_t&&>(receiver_),
+            std::make_error_code(std::errc::not_enough_memory));
+        return;
+      }
+      // Held until every send is started, since they may complete inline.
+      pending_ = sockets_.size() + 1;
+      for (size_t i = 0; i < sockets_.size(); ++i) {
+        stdexec::start(entries_[i].emplace(*this, i, *sockets_[i]));
+      }
+      release();
+    }
+
+    // Allocate the results, the sends and the iovecs of the payload once for
+    // all the sockets.
+    void prepare() {
+      results_.resize(sockets_.size());
+      entries_ = std::make_unique<std::optional<entry>[]>(sockets_.size());
+      auto first = net::buffer_sequence_begin(buffers_);
+      auto last = net::buffer_sequence_end(buffers_);
+      for (; first != last; ++first) {
+        const_buffer b = *first;
+        if (b.size() != 0) {
+          iov_.push_back(
+              iovec{const_cast<void*>(b.data()), b.size()});  // NOLINT
+          total_ += b.size();
+        }
+      }
+    }
+
+    // Send at most `max_window` iovecs starting `offset` bytes into the
+    // payload.
+    result<size_t> send_from(socket_t& socket, size_t offset) noexcept {
+      size_t i = 0;
+      while (offset >= iov_[i].iov_len) {
+        offset -= iov_[i].iov_len;
+        ++i;
+      }
+      iovec window[max_window];
+      const size_t count = std::min(iov_.size() - i, max_window);
+      std::copy_n(iov_.begin() + i, count, window);
+      window[0].iov_base = static_cast<char*>(window[0].iov_base) + offset;
+      window[0].iov_len -= offset;
+      return socket.non_blocking_sendmsg(window, count, 0);
+    }
+
+    void on_entry_done(size_t index, std::error_code ec) noexcept {
+      results_[index] = ec;
+      release();
+    }
+
+    void on_entry_stopped() noexcept {
+      stopped_ = true;
+      release();
+    }
+
+    // Complete once every send has. A stop request stops the operation even
+    // if some of the sockets took the whole payload.
+    void release() noexcept {
+      if (--pending_ != 0) {
+        return;
+      }
+      if (stopped_) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(receiver_));
+      } else {
+        stdexec::set_value(
+            static_cast<receiver_t&&>(receiver_),
+            static_cast<std::vector<std::error_code>&&>(results_));
+      }
+    }
+
+    // The data members.
+    receiver_t receiver_;
+    std::span<socket_t* const> sockets_;
+    epoll_context* context_;
+    Buffers buffers_;
+    std::vector<iovec> iov_;
+    size_t total_;
+    std::vector<std::error_code> results_;
+    std::unique_ptr<std::optional<entry>[]> entries_;
+    size_t pending_;
+    bool stopped_;
+  };
+};
+
+template <typename Protocol, typename Buffers>
+class send_to_all_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<epoll_context::socket_send_to_all_op<
+      stdexec::__id<Receiver>, Protocol, Buffers>>;
+  using socket_t = typename Protocol::socket;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = send_to_all_sender;
+    using completion_signatures = stdexec::completion_signatures<
+        stdexec::set_value_t(std::vector<std::error_code>),
+        stdexec::set_error_t(std::error_code&&), stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.sockets_,
+              static_cast<Sender&&>(self).buffers_};
+    }
+
+    constexpr __t(std::span<socket_t* const> sockets, Buffers buffers) noexcept
+        : sockets_(sockets), buffers_(static_cast<Buffers&&>(buffers)) {}
+
+   private:
+    std::span<socket_t* const> sockets_;
+    Buffers buffers_;
+  };
+};
+
+// Send `buffers` to every socket of `sockets`, which must all be associated
+// with the same context and outlive the operation. Completes with one error
+// code per socket, in the order of `sockets`; a cleared code means the whole
+// payload was sent. A failing socket doesn't affect the others.
+struct async_send_to_all_t {
+  template <std::ranges::contiguous_range Sockets,
+            const_buffer_sequence Buffers>
+    requires std::ranges::sized_range<Sockets> &&
+             std::is_pointer_v<std::ranges::range_value_t<Sockets>>
+  constexpr auto operator()(const Sockets& sockets,
+                            Buffers buffers) const noexcept {
+    using socket_t =
+        std::remove_pointer_t<std::ranges::range_value_t<Sockets>>;
+    using protocol_t = typename socket_t::protocol_type;
+    return stdexec::__t<send_to_all_sender<protocol_t, Buffers>>{
+        std::span<socket_t* const>{std::ranges::data(sockets),
+                                   std::ranges::size(sockets)},
+        static_cast<Buffers&&>(buffers)};
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::async_send_to_all_t async_send_to_all{};
+}  // namespace net
+
+#endif  // EPOLL_SOCKET_SEND_TO_ALL_OP_HPP_
@@ -0,0 +1,480 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_SOCKET_SEND_ZEROCOPY_OP_HPP_
+#define EPOLL_SOCKET_SEND_ZEROCOPY_OP_HPP_
+
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <cassert>
+#include <concepts>  // NOLINT
+#include <cstdint>
+#include <cstring>
+#include <system_error>  // NOLINT
+
+#include "status-code/system_code.hpp"
+
+#include "basic_socket.hpp"
+#include "buffer.hpp"
+#include "buffer_sequence_adapter.hpp"
+#include "epoll/epoll_context.hpp"
+#include "meta.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// Send all of the buffers with MSG_ZEROCOPY. The kernel sends the pages of
+// the buffers themselves instead of copying them, so the operation completes
+// only when the completion notifications of all its sends have been read from
+// the error queue of the socket, at which point the kernel doesn't reference
+// the buffers anymore.
+//
+// A stop request stops sending the rest of the buffers, but the operation
+// still waits for the notifications of what has been sent before completing
+// with set_stopped, so the buffers are never released early. Only closing the
+// socket completes the operation while notifications are outstanding.
+template <typename ReceiverId, typename Protocol, typename Buffers>
+class epoll_context::socket_send_zerocopy_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  using socket_t = typename Protocol::socket;
+  using bufs_t = buffer_sequence_adapter<const_buffer, Buffers>;
+  using stop_token = stdexec::stop_token_of_t<stdexec::env_of_t<receiver_t>>;
+
+ public:
+  struct __t : public stdexec::__immovable,
+               private epoll_context::completion_op,
+               private epoll_context::stop_op {
+    using __id = socket_send_zerocopy_op;
+
+    // Constructor.
+    constexpr __t(receiver_t receiver, basic_socket<Protocol>& socket,
+                  Buffers buffers) noexcept
+        : receiver_(static_cast<receiver_t&&>(receiver)),
+          socket_(static_cast<socket_t&>(socket)),
+          context_(static_cast<epoll_context&>(socket.context())),
+          bufs_(buffers),
+          iov_(bufs_.buffers()),
+          iov_count_(bufs_.count()),
+          bytes_transferred_(0),
+          first_sequence_(0),
+          send_count_(0),
+          notified_count_(0),
+          copied_(false),
+          sending_(true),
+          stop_seen_(false),
+          has_stop_callback_(false),
+          state_(0),
+          ec_(errc::success),
+          stop_callback_() {}
+
+    friend void tag_invoke(stdexec::start_t, __t& self) noexcept {
+      self.start_impl();
+    }
+
+   private:
+    void start_impl() noexcept {
+      if (!context_.is_running_on_io_thread()) {
+        static_cast<completion_op*>(this)->execute_ =
+            &__t::on_schedule_complete;
+        context_.schedule_remote(static_cast<completion_op*>(this));
+      } else {
+        perform();
+      }
+    }
+
+    // epoll_context starts to execute this operation in the io thread.
+    static void on_schedule_complete(operation_base* op) noexcept {
+      static_cast<__t*>(static_cast<completion_op*>(op))->perform();
+    }
+
+    // This function is not thread safe, it must be executed in io thread.
+    void perform() noexcept {
+      assert(context_.is_running_on_io_thread());
+      descriptor_state* state = context_.register_descriptor(
+          socket_.native_handle(), socket_.descriptor_data(), ec_);
+      if (state == nullptr) {
+        finish();
+        return;
+      }
+      if (!state->zerocopy_enabled_) {
+        if (ec_ = socket_.set_option(socket_base::zero_copy{true});
+            ec_.failure()) {
+          finish();
+          return;
+        }
+        state->zerocopy_enabled_ = true;
+      }
+      first_sequence_ = state->zerocopy_sequence_;
+
+      if constexpr (!stdexec::unstoppable_token<stop_token>) {
+        stop_callback_.__construct(
+            stdexec::get_stop_token(stdexec::get_env(receiver_)),
+            cancel_callback{*this});
+        has_stop_callback_ = true;
+      }
+      if (step() && start_waiting()) {
+        return;
+      }
+      finish();
+    }
+
+    // Handle epoll event.
+    static void wakeup(operation_base* op) noexcept {
+      auto& self = *static_cast<__t*>(static_cast<completion_op*>(op));
+      // A closed socket cancels the operation, its notifications are lost.
+      if (descriptor_canceled(self.socket_.descriptor_data())) {
+        self.ec_ = errc::operation_canceled;
+      } else if (self.step() && self.start_waiting()) {
+        return;
+      }
+      self.finish();
+    }
+
+    // Send as much as possible, then read the notifications. Returns true if
+    // the operation should wait for the socket, otherwise `ec_` tells how to
+    // complete.
+    bool step() noexcept {
+      if (sending_ && !send()) {
+        return true;
+      }
+      return !read_notifications();
+    }
+
+    // Send the rest of the buffers. Returns false if the socket isn't
+    // writable before all of them have been sent.
+    bool send() noexcept {
+      skip_empty_buffers();
+      while (iov_count_ > 0) {
+        auto res = socket_.non_blocking_sendmsg(
+            iov_, iov_count_, MSG_ZEROCOPY | MSG_NOSIGNAL);
+        if (res.has_error()) {
+          auto ec = static_cast<system_error2::system_code&&>(res.error());
+          if (ec == errc::resource_unavailable_try_again ||
+              ec == errc::operation_would_block) {
+            return false;
+          }
+          if (ec == errc::no_buffer_space && send_count_ > notified_count_) {
+            // Too many notifications are pending, wait for some of them.
+            return false;
+          }
+          ec_ = static_cast<system_error2::system_code&&>(ec);
+          break;
+        }
+        ++send_count_;
+        ++static_cast<descriptor_state*>(socket_.descriptor_data())
+              ->zerocopy_sequence_;
+        advance(res.value());
+      }
+      sending_ = false;
+      return true;
+    }
+
+    // Read the pending notifications from the error queue. Returns true if
+    // all sends have been notified or the error queue can't be read anymore.
+    bool read_notifications() noexcept {
+      while (notified_count_ < send_count_) {
+        alignas(::cmsghdr) char control[CMSG_SPACE(sizeof(sock_extended_err)) +
+                                        CMSG_SPACE(sizeof(sockaddr_in6))];
+        ::msghdr msg{};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (::recvmsg(socket_.native_handle(), &msg,
+                      MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+          if (errno == EINTR) {
+            continue;
+          }
+          if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return false;
+          }
+          ec_ = system_error2::posix_code::current();
+          return true;
+        }
+        for (::cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+             cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+          if (!(cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) &&
+              !(cmsg->cmsg_level == SOL_IPV6 &&
+                cmsg->cmsg_type == IPV6_RECVERR)) {
+            continue;
+          }
+          sock_extended_err err;
+          std::memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+          if (err.ee_origin != SO_EE_ORIGIN_ZEROCOPY || err.ee_errno != 0) {
+            continue;
+          }
+          // The notification covers the sends numbered [ee_info, ee_data].
+          uint32_t count = own_sends(err.ee_info, err.ee_data);
+          notified_count_ += count;
+          if (count > 0 && (err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED)) {
+            copied_ = true;
+          }
+        }
+      }
+      return true;
+    }
+
+    // The count of the sends numbered [low, high] which belong to this
+    // operation. The numbers wrap around, so they are taken relative to the
+    // first send of this operation.
+    uint32_t own_sends(uint32_t low, uint32_t high) const noexcept {
+      uint32_t first = low - first_sequence_;
+      uint32_t last = high - first_sequence_;
+      if (first > last) {
+        // The range starts before this operation.
+        first = 0;
+      }
+      if (first >= send_count_) {
+        return 0;
+      }
+      if (last >= send_count_) {
+        last = send_count_ - 1;
+      }
+      return last - first + 1;
+    }
+
+    // Skip `size` bytes of the buffers which have been sent.
+    void advance(std::size_t size) noexcept {
+      while (size > 0 && iov_count_ > 0) {
+        if (size < iov_->iov_len) {
+          iov_->iov_base = static_cast<char*>(iov_->iov_base) + size;
+          iov_->iov_len -= size;
+          bytes_transferred_ += size;
+          break;
+        }
+        size -= iov_->iov_len;
+        bytes_transferred_ += iov_->iov_len;
+        ++iov_;
+        --iov_count_;
+      }
+      skip_empty_buffers();
+    }
+
+    void skip_empty_buffers() noexcept {
+      while (iov_count_ > 0 && iov_->iov_len == 0) {
+        ++iov_;
+        --iov_count_;
+      }
+    }
+
+    // Complete the operation unless a remote thread has requested to stop it,
+    // in which case the stop operation completes it.
+    void finish() noexcept {
+      if (has_stop_callback_) {
+        stop_callback_.__destruct();
+        has_stop_callback_ = false;
+      }
+      auto old_state =
+          state_.fetch_add(operation_ended, std::memory_order_acq_rel);
+      if ((old_state & request_stopped_mask) != 0 && !stop_seen_) {
+        return;
+      }
+      complete();
+    }
+
+    void complete() noexcept {
+      if (stop_seen_ || ec_ == errc::operation_canceled) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(receiver_));
+      } else if (ec_ == errc::success) {
+        stdexec::set_value(static_cast<receiver_t&&>(receiver_),
+                           bytes_transferred_, copied_);
+      } else if (ec_.domain() ==
+                 system_error2::quick_status_code_from_enum_domain<
+                     net::network_errc>) {
+        stdexec::set_error(
+            static_cast<receiver_t&&>(receiver_),
+            make_error_code(static_cast<net::network_errc>(ec_.value())));
+      } else {
+        stdexec::set_error(
+            static_cast<receiver_t&&>(receiver_),
+            make_error_code(static_cast<std::errc>(ec_.value())));
+      }
+    }
+
+    // Stop the operation on the io thread.
+    static void complete_with_stop(operation_base* op) noexcept {
+      auto& self = *static_cast<__t*>(static_cast<stop_op*>(op));
+      if (static_cast<completion_op&>(self).enqueued_.load()) {
+        // Wait for the pending wakeup to run first.
+        static_cast<stop_op&>(self).execute_ = &complete_with_stop;
+        self.context_.schedule_local(static_cast<stop_op*>(op));
+        return;
+      }
+      if ((self.state_.load(std::memory_order_acquire) &
+           operation_ended_mask) != 0) {
+        // The operation has finished and left the completion to us.
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+        return;
+      }
+      self.stop_seen_ = true;
+      self.sending_ = false;
+      if (self.send_count_ == self.notified_count_) {
+        // Nothing is in flight, so the buffers can be released right now.
+        self.stop_waiting();
+        self.finish();
+      }
+      // Otherwise keep waiting for the notifications, `finish` completes the
+      // operation with set_stopped afterwards.
+    }
+
+    // The remote thread requests that this operation should be stopped.
+    void request_stop() noexcept {
+      auto old_state =
+          state_.fetch_add(request_stopped, std::memory_order_acq_rel);
+      if ((old_state & operation_ended_mask) == 0) {
+        static_cast<stop_op*>(this)->execute_ = &complete_with_stop;
+        context_.schedule_remote(static_cast<stop_op*>(this));
+      }
+    }
+
+    // Park this operation on the write slot of the socket. Notifications
+    // raise EPOLLERR, which wakes up every slot. Returns false and assigns
+    // `ec_` if it can't be parked.
+    bool start_waiting() noexcept {
+      auto* state = static_cast<descriptor_state*>(socket_.descriptor_data());
+      if (state == nullptr) {
+        // The socket has been closed.
+        ec_ = errc::bad_file_descriptor;
+        return false;
+      }
+      if (!state->park(descriptor_state::write_slot,
+                       static_cast<completion_op*>(this))) {
+        ec_ = errc::device_or_resource_busy;
+        return false;
+      }
+      static_cast<completion_op*>(this)->execute_ = wakeup;
+      return true;
+    }
+
+    // Take this operation out of its descriptor slot if it's still parked.
+    void stop_waiting() noexcept {
+      if (void* data = socket_.descriptor_data()) {
+        static_cast<descriptor_state*>(data)->unpark(
+            descriptor_state::write_slot, static_cast<completion_op*>(this));
+      }
+    }
+
+    // Use theses to synchronize the remote thread and the io thread.
+    static constexpr uint32_t operation_ended = 0x00010000;
+    static constexpr uint32_t operation_ended_mask = 0xFFFF0000;
+    static constexpr uint32_t request_stopped = 0x1;
+    static constexpr uint32_t request_stopped_mask = 0xFFFF;
+
+    // The cancel callback.
+    struct cancel_callback {
+      __t& op_;
+
+      void operator()() noexcept { op_.request_stop(); }
+    };
+
+    // The data members.
+    receiver_t receiver_;
+    socket_t& socket_;
+    epoll_context& context_;
+    bufs_t bufs_;
+
+    // The buffers which haven't been sent yet.
+    ::iovec* iov_;
+    std::size_t iov_count_;
+    std::size_t bytes_transferred_;
+
+    // The kernel's number of the first send of this operation.
+    uint32_t first_sequence_;
+
+    // The count of successful sends and of those which have been notified.
+    uint32_t send_count_;
+    uint32_t notified_count_;
+
+    // Whether the kernel has copied any of the buffers anyway.
+    bool copied_;
+
+    // Whether there are buffers to send.
+    bool sending_;
+
+    // Whether the stop request has been handled on the io thread.
+    bool stop_seen_;
+
+    bool has_stop_callback_;
+    std::atomic<uint32_t> state_;
+    system_error2::system_code ec_;
+    exec::__manual_lifetime<
+        typename stop_token::template callback_type<cancel_callback>>
+        stop_callback_;
+  };
+};
+
+template <typename Protocol, typename Buffers>
+class send_zerocopy_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<epoll_context::socket_send_zerocopy_op<
+      stdexec::__id<Receiver>, Protocol, Buffers>>;
+  using socket_t = typename Protocol::socket;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = send_zerocopy_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(size_t, bool),
+                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.socket_, self.buffers_};
+    }
+
+    constexpr __t(basic_socket<Protocol>& socket,  // NOLINT
+                  Buffers buffers) noexcept
+        : socket_(static_cast<socket_t&>(socket)), buffers_(buffers) {}
+
+   private:
+    socket_t& socket_;
+    Buffers buffers_;
+  };
+};
+
+// Send all of `buffers` without copying them. The buffers must stay alive and
+// unmodified until the sender completes: any completion, including set_error
+// and set_stopped, signals that the kernel has released them, unless the
+// socket has been closed meanwhile. Completes with the count of bytes sent
+// and whether the kernel fell back to copying some of them, e.g. over
+// loopback, in which case a plain send would have been cheaper.
+struct async_send_zerocopy_t {
+  template <transport_protocol Protocol, const_buffer_sequence Buffers>
+  constexpr auto operator()(basic_socket<Protocol>& socket,
+                            Buffers buffers) const noexcept
+      -> stdexec::__t<send_zerocopy_sender<Protocol, Buffers>> {
+    return {socket, buffers};
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::async_send_zerocopy_t async_send_zerocopy{};
+}  // namespace net
+
+#endif  // EPOLL_SOCKET_SEND_ZEROCOPY_OP_HPP_
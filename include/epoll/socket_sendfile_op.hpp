@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_SOCKET_SENDFILE_OP_HPP_
+#define EPOLL_SOCKET_SENDFILE_OP_HPP_
+
+#include <sys/types.h>
+
+#include <cassert>
+#include <cstddef>
+#include <system_error>  // NOLINT
+
+#include "status-code/system_code.hpp"
+
+#include "basic_socket.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_io_base_op.hpp"
+#include "meta.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// Send `count` bytes of a file with sendfile(2). The operation keeps waiting
+// for EPOLLOUT until all bytes are sent or the end of the file is reached.
+template <typename ReceiverId, typename Protocol>
+class epoll_context::socket_sendfile_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  template <typename Derived>
+  using base_op_t = stdexec::__t<
+      epoll_context::socket_io_base_op<ReceiverId, Protocol, Derived>>;
+  using socket_t = typename Protocol::socket;
+
+ public:
+  struct __t : public base_op_t<__t> {
+    using __id = socket_sendfile_op;
+    using base_t = base_op_t<__t>;
+    friend base_t;
+
+    // Constructor.
+    constexpr __t(receiver_t receiver, basic_socket<Protocol>& socket,
+                  int file, ::off_t offset, size_t count) noexcept
+        : base_t(static_cast<receiver_t&&>(receiver),  //
+                 static_cast<socket_t&>(socket)),
+          file_(file),
+          offset_(offset),
+          remaining_(count),
+          bytes_transferred_(0) {}
+
+   private:
+    static constexpr void non_blocking_sendfile(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      self.ec_ = errc::success;
+      while (self.remaining_ != 0) {
+        auto res = self.socket_.non_blocking_sendfile(self.file_, &self.offset_,
+                                                      self.remaining_);
+        if (res.has_error()) {
+          self.ec_ = static_cast<system_error2::system_code&&>(res.error());
+          return;
+        }
+        if (res.value() == 0) {
+          // The end of the file.
+          return;
+        }
+        self.bytes_transferred_ += res.value();
+        self.remaining_ -= res.value();
+      }
+    }
+
+    static void complete(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      if (self.ec_ == errc::operation_canceled) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      } else if (self.ec_ == errc::success) {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                           self.bytes_transferred_);
+      } else {
+        if (self.ec_.domain() ==
+            system_error2::quick_status_code_from_enum_domain<
+                net::network_errc>) {
+          stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                             make_error_code(static_cast<net::network_errc>(
+                                 self.ec_.value())));
+        } else {
+          stdexec::set_error(
+              static_cast<receiver_t&&>(self.receiver_),
+              make_error_code(static_cast<std::errc>(self.ec_.value())));
+        }
+      }
+    }
+
+    static constexpr typename base_t::op_type otype = base_t::op_type::op_write;
+    static constexpr
+        typename base_t::op_vtable op_vtable{&non_blocking_sendfile, &complete};
+    int file_;
+    ::off_t offset_;
+    size_t remaining_;
+    size_t bytes_transferred_;
+  };
+};
+
+template <typename Protocol>
+class sendfile_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<
+      epoll_context::socket_sendfile_op<stdexec::__id<Receiver>, Protocol>>;
+  using socket_t = typename Protocol::socket;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = sendfile_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(size_t),
+                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.socket_, self.file_,
+              self.offset_, self.count_};
+    }
+
+    constexpr __t(basic_socket<Protocol>& socket, int file, ::off_t offset,
+                  size_t count) noexcept
+        : socket_(static_cast<socket_t&>(socket)),
+          file_(file),
+          offset_(offset),
+          count_(count) {}
+
+   private:
+    socket_t& socket_;
+    int file_;
+    ::off_t offset_;
+    size_t count_;
+  };
+};
+
+// Send `count` bytes of the file `file` starting at `offset` without copying
+// them to user space. Completes with the count of bytes sent, which is less
+// than `count` only if the end of the file is reached. The file offset of
+// `file` is left unchanged.
+struct async_sendfile_t {
+  template <transport_protocol Protocol>
+  constexpr auto operator()(basic_socket<Protocol>& socket, int file,
+                            ::off_t offset, size_t count) const noexcept
+      -> stdexec::__t<sendfile_sender<Protocol>> {
+    return {socket, file, offset, count};
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::async_sendfile_t async_sendfile{};
+}  // namespace net
+
+#endif  // EPOLL_SOCKET_SENDFILE_OP_HPP_
@@ -0,0 +1,343 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_SOCKET_SPLICE_OP_HPP_
+#define EPOLL_SOCKET_SPLICE_OP_HPP_
+
+#include <cassert>
+#include <cstddef>
+#include <system_error>  // NOLINT
+#include <utility>
+
+#include "status-code/system_code.hpp"
+
+#include "basic_socket.hpp"
+#include "epoll/epoll_context.hpp"
+#include "meta.hpp"
+#include "pipe.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// Move one chunk of data from a socket to another one through a pipe with
+// splice(2). The operation first waits on the source until data can be moved
+// into the pipe, then waits on the destination until the pipe is drained.
+// Only one of the sockets is waited on at a time.
+template <typename ReceiverId, typename Protocol>
+class epoll_context::socket_splice_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  using socket_t = typename Protocol::socket;
+  using stop_token = stdexec::stop_token_of_t<stdexec::env_of_t<receiver_t>>;
+
+ public:
+  struct __t : public stdexec::__immovable,
+               private epoll_context::completion_op,
+               private epoll_context::stop_op {
+    using __id = socket_splice_op;
+
+    // Constructor.
+    constexpr __t(receiver_t receiver, basic_socket<Protocol>& from,
+                  basic_socket<Protocol>& to, net::pipe& pipe,
+                  size_t count) noexcept
+        : receiver_(static_cast<receiver_t&&>(receiver)),
+          from_(static_cast<socket_t&>(from)),
+          to_(static_cast<socket_t&>(to)),
+          context_(static_cast<epoll_context&>(from.context())),
+          pipe_(pipe),
+          count_(count),
+          pending_(0),
+          bytes_transferred_(0),
+          parked_(nullptr),
+          slot_(descriptor_state::read_slot),
+          state_(0),
+          ec_(errc::success),
+          stop_callback_() {}
+
+    friend void tag_invoke(stdexec::start_t, __t& self) noexcept {
+      self.start_impl();
+    }
+
+   private:
+    void start_impl() noexcept {
+      if (!context_.is_running_on_io_thread()) {
+        static_cast<completion_op*>(this)->execute_ =
+            &__t::on_schedule_complete;
+        context_.schedule_remote(static_cast<completion_op*>(this));
+      } else {
+        perform();
+      }
+    }
+
+    // epoll_context starts to execute this operation in the io thread.
+    static void on_schedule_complete(operation_base* op) noexcept {
+      static_cast<__t*>(static_cast<completion_op*>(op))->perform();
+    }
+
+    // This function is not thread safe, it must be executed in io thread.
+    void perform() noexcept {
+      assert(context_.is_running_on_io_thread());
+      if (transfer()) {
+        return;
+      }
+      finish();
+    }
+
+    // Handle epoll event.
+    static void wakeup(operation_base* op) noexcept {
+      auto& self = *static_cast<__t*>(static_cast<completion_op*>(op));
+      if constexpr (!stdexec::unstoppable_token<stop_token>) {
+        self.stop_callback_.__destruct();
+      }
+      // A closed socket or a drain cancels the operation.
+      if (descriptor_canceled(
+              std::exchange(self.parked_, nullptr)->descriptor_data())) {
+        self.ec_ = errc::operation_canceled;
+      } else if ((self.state_.load(std::memory_order_acquire) &
+                  request_stopped_mask) == 0) {
+        if (self.transfer()) {
+          return;
+        }
+      }
+      self.finish();
+    }
+
+    // Complete the operation unless a remote thread has requested to stop it,
+    // in which case the stop operation completes it.
+    void finish() noexcept {
+      auto old_state =
+          state_.fetch_add(operation_ended, std::memory_order_acq_rel);
+      if ((old_state & request_stopped_mask) != 0) {
+        return;
+      }
+      complete();
+    }
+
+    // Move data until the chunk is delivered. Returns true if the operation
+    // is parked on one of the sockets, otherwise `ec_` tells how to complete.
+    bool transfer() noexcept {
+      if (pending_ == 0) {
+        auto res = pipe_.splice_from(from_.native_handle(), count_);
+        if (res.has_error()) {
+          ec_ = static_cast<system_error2::system_code&&>(res.error());
+          return would_block() &&
+                 start_waiting(from_, descriptor_state::read_slot);
+        }
+        if (res.value() == 0) {
+          // The peer has closed the source.
+          ec_ = errc::success;
+          return false;
+        }
+        pending_ = res.value();
+      }
+
+      while (pending_ != 0) {
+        auto res = pipe_.splice_to(to_.native_handle(), pending_);
+        if (res.has_error()) {
+          ec_ = static_cast<system_error2::system_code&&>(res.error());
+          return would_block() &&
+                 start_waiting(to_, descriptor_state::write_slot);
+        }
+        pending_ -= res.value();
+        bytes_transferred_ += res.value();
+      }
+      ec_ = errc::success;
+      return false;
+    }
+
+    bool would_block() const noexcept {
+      return ec_ == errc::resource_unavailable_try_again ||
+             ec_ == errc::operation_would_block;
+    }
+
+    void complete() noexcept {
+      if (ec_ == errc::operation_canceled) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(receiver_));
+      } else if (ec_ == errc::success) {
+        stdexec::set_value(static_cast<receiver_t&&>(receiver_),
+                           bytes_transferred_);
+      } else if (ec_.domain() ==
+                 system_error2::quick_status_code_from_enum_domain<
+                     net::network_errc>) {
+        stdexec::set_error(
+            static_cast<receiver_t&&>(receiver_),
+            make_error_code(static_cast<net::network_errc>(ec_.value())));
+      } else {
+        stdexec::set_error(
+            static_cast<receiver_t&&>(receiver_),
+            make_error_code(static_cast<std::errc>(ec_.value())));
+      }
+    }
+
+    // Send the stopped signal to the downstream receiver.
+    static void complete_with_stop(operation_base* op) noexcept {
+      auto& self = *static_cast<__t*>(static_cast<stop_op*>(op));
+      if (!static_cast<completion_op&>(self).enqueued_.load()) {
+        self.stop_waiting();
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      } else {
+        // Wait for the pending wakeup to observe the stop request first.
+        static_cast<stop_op&>(self).execute_ = &complete_with_stop;
+        self.context_.schedule_local(static_cast<stop_op*>(op));
+      }
+    }
+
+    // The remote thread requests that this operation should be stopped.
+    void request_stop() noexcept {
+      auto old_state =
+          state_.fetch_add(request_stopped, std::memory_order_acq_rel);
+      if ((old_state & operation_ended_mask) == 0) {
+        static_cast<stop_op*>(this)->execute_ = &complete_with_stop;
+        context_.schedule_remote(static_cast<stop_op*>(this));
+      }
+    }
+
+    // Park this operation on `slot` of the descriptor state of `socket`.
+    // Returns false and assigns `ec_` if it can't be parked.
+    bool start_waiting(socket_t& socket,
+                       descriptor_state::op_slot slot) noexcept {
+      ec_ = errc::success;
+      descriptor_state* state = context_.register_descriptor(
+          socket.native_handle(), socket.descriptor_data(), ec_);
+      if (state == nullptr) {
+        return false;
+      }
+      if (!state->park(slot, static_cast<completion_op*>(this))) {
+        ec_ = errc::device_or_resource_busy;
+        return false;
+      }
+      parked_ = &socket;
+      slot_ = slot;
+      if constexpr (!stdexec::unstoppable_token<stop_token>) {
+        stop_callback_.__construct(
+            stdexec::get_stop_token(stdexec::get_env(receiver_)),
+            cancel_callback{*this});
+      }
+      static_cast<completion_op*>(this)->execute_ = wakeup;
+      return true;
+    }
+
+    // Take this operation out of its descriptor slot if it's still parked.
+    void stop_waiting() noexcept {
+      if (parked_ == nullptr) {
+        return;
+      }
+      if (void* data = parked_->descriptor_data()) {
+        static_cast<descriptor_state*>(data)->unpark(
+            slot_, static_cast<completion_op*>(this));
+      }
+      parked_ = nullptr;
+    }
+
+    // Use theses to synchronize the remote thread and the io thread.
+    static constexpr uint32_t operation_ended = 0x00010000;
+    static constexpr uint32_t operation_ended_mask = 0xFFFF0000;
+    static constexpr uint32_t request_stopped = 0x1;
+    static constexpr uint32_t request_stopped_mask = 0xFFFF;
+
+    // The cancel callback.
+    struct cancel_callback {
+      __t& op_;
+
+      void operator()() noexcept { op_.request_stop(); }
+    };
+
+    // The data members.
+    receiver_t receiver_;
+    socket_t& from_;
+    socket_t& to_;
+    epoll_context& context_;
+    net::pipe& pipe_;
+    size_t count_;
+    size_t pending_;
+    size_t bytes_transferred_;
+    socket_t* parked_;
+    descriptor_state::op_slot slot_;
+    std::atomic<uint32_t> state_;
+    system_error2::system_code ec_;
+    exec::__manual_lifetime<
+        typename stop_token::template callback_type<cancel_callback>>
+        stop_callback_;
+  };
+};
+
+template <typename Protocol>
+class splice_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<
+      epoll_context::socket_splice_op<stdexec::__id<Receiver>, Protocol>>;
+  using socket_t = typename Protocol::socket;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = splice_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(size_t),
+                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.from_, self.to_,
+              self.pipe_, self.count_};
+    }
+
+    constexpr __t(basic_socket<Protocol>& from, basic_socket<Protocol>& to,
+                  net::pipe& pipe, size_t count) noexcept
+        : from_(static_cast<socket_t&>(from)),
+          to_(static_cast<socket_t&>(to)),
+          pipe_(pipe),
+          count_(count) {}
+
+   private:
+    socket_t& from_;
+    socket_t& to_;
+    net::pipe& pipe_;
+    size_t count_;
+  };
+};
+
+// Move up to `count` bytes from `from` to `to` through `pipe` without copying
+// them to user space. Completes with the count of bytes moved, zero means the
+// peer of `from` has closed the connection. Both sockets must be associated
+// with the same context. If the operation is stopped or fails while writing,
+// the bytes which are still in `pipe` are left there.
+struct async_splice_t {
+  template <transport_protocol Protocol>
+  constexpr auto operator()(basic_socket<Protocol>& from,
+                            basic_socket<Protocol>& to, net::pipe& pipe,
+                            size_t count) const noexcept
+      -> stdexec::__t<splice_sender<Protocol>> {
+    return {from, to, pipe, count};
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::async_splice_t async_splice{};
+}  // namespace net
+
+#endif  // EPOLL_SOCKET_SPLICE_OP_HPP_
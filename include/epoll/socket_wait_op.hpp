@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef EPOLL_SOCKET_WAIT_OP_HPP_
+#define EPOLL_SOCKET_WAIT_OP_HPP_
+
+#include <cstdint>
+#include <system_error>  // NOLINT
+
+#include "basic_socket.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_io_base_op.hpp"
+#include "epoll/steady_timer.hpp"
+#include "error_channel.hpp"
+#include "meta.hpp"
+#include "socket_base.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// Wait until a socket is ready to read, to write or has an error condition,
+// without performing any I/O, for libraries which do their own I/O on the
+// descriptor. The descriptor stays registered to epoll, so a wait costs no
+// syscall. The readiness reported while nothing was parked is remembered, and
+// consumed by the next wait, which thus may complete spuriously: the caller
+// must retry its I/O and wait again if it would still block.
+template <typename ReceiverId, typename Protocol>
+class epoll_context::socket_wait_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  template <typename Derived>
+  using base_op_t = stdexec::__t<
+      epoll_context::socket_io_base_op<ReceiverId, Protocol, Derived>>;
+  using socket_t = typename Protocol::socket;
+  using wait_type = socket_base::wait_type;
+
+ public:
+  struct __t : public base_op_t<__t> {
+    using __id = socket_wait_op;
+    using base_t = base_op_t<__t>;
+    friend base_t;
+
+    // Constructor.
+    constexpr __t(receiver_t receiver, basic_socket<Protocol>& socket,
+                  wait_type w) noexcept
+        : base_t(static_cast<receiver_t&&>(receiver),
+                 static_cast<socket_t&>(socket)),
+          wait_slot_(w == wait_type::wait_read ? descriptor_state::read_slot
+                     : w == wait_type::wait_write
+                         ? descriptor_state::write_slot
+                         : descriptor_state::except_slot),
+          parked_(false) {}
+
+   private:
+    // There is no I/O to perform. The first attempt consumes the readiness
+    // reported while nothing was parked, otherwise the operation parks on its
+    // slot, and succeeds once it's woken up.
+    static constexpr void wait(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      if (self.parked_ || self.consume_ready()) {
+        self.ec_ = errc::success;
+      } else {
+        self.parked_ = true;
+        self.ec_ = errc::operation_would_block;
+      }
+    }
+
+    // Clear the remembered readiness of the slot. Returns whether it was set.
+    constexpr bool consume_ready() noexcept {
+      auto* state =
+          static_cast<descriptor_state*>(this->socket_.descriptor_data());
+      if (state == nullptr || state->canceled_) {
+        return false;
+      }
+      const auto bit = static_cast<uint8_t>(1U << wait_slot_);
+      if ((state->ready_ & bit) == 0) {
+        return false;
+      }
+      state->ready_ &= static_cast<uint8_t>(~bit);
+      return true;
+    }
+
+    static void complete(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      if (self.ec_ == errc::operation_canceled) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      } else if (self.ec_ == errc::success) {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_));
+      } else {
+        stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                           to_error<std::error_code>(self.ec_));
+      }
+    }
+
+    static constexpr typename base_t::op_type otype = base_t::op_type::op_wait;
+    static constexpr typename base_t::op_vtable op_vtable{&wait, &complete};
+    descriptor_state::op_slot wait_slot_;
+
+    // Whether the operation has parked, so the next attempt comes from a
+    // wakeup.
+    bool parked_;
+  };
+};
+
+template <typename Protocol>
+class wait_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<
+      epoll_context::socket_wait_op<stdexec::__id<Receiver>, Protocol>>;
+  using socket_t = typename Protocol::socket;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = wait_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(),
+                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.socket_, self.wait_};
+    }
+
+    constexpr __t(basic_socket<Protocol>& socket,
+                  socket_base::wait_type w) noexcept
+        : socket_(static_cast<socket_t&>(socket)), wait_(w) {}
+
+   private:
+    socket_t& socket_;
+    socket_base::wait_type wait_;
+  };
+};
+
+// Wait for the readiness of a socket or the expiry of a `steady_timer`.
+struct async_wait_t {
+  // Wait until `socket` is ready for `w`. Completes with no value, possibly
+  // spuriously, see `socket_wait_op`.
+  template <transport_protocol Protocol>
+  constexpr auto operator()(basic_socket<Protocol>& socket,
+                            socket_base::wait_type w) const noexcept
+      -> stdexec::__t<wait_sender<Protocol>> {
+    return {socket, w};
+  }
+
+  // Wait until `timer` expires. Completes with no value, or stopped if the
+  // wait is canceled.
+  constexpr auto operator()(epoll_context::steady_timer& timer) const noexcept
+      -> stdexec::__t<timer_wait_sender> {
+    return stdexec::__t<timer_wait_sender>{timer};
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::async_wait_t async_wait{};
+}  // namespace net
+
+#endif  // EPOLL_SOCKET_WAIT_OP_HPP_
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_START_DETACHED_HPP_
+#define EPOLL_START_DETACHED_HPP_
+
+#include <exception>
+#include <memory>
+#include <utility>
+
+#include "epoll/epoll_context.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+// The environment of detached operations. Operations started within can find
+// the allocator and the scheduler of the context through it.
+struct detached_env {
+  friend auto tag_invoke(stdexec::get_allocator_t,
+                         const detached_env& env) noexcept
+      -> epoll_context::allocator<std::byte> {
+    return env.context->get_allocator();
+  }
+
+  friend auto tag_invoke(stdexec::get_scheduler_t,
+                         const detached_env& env) noexcept
+      -> epoll_context::scheduler {
+    return env.context->get_scheduler();
+  }
+
+  epoll_context* context;
+};
+
+// The operation state of a detached sender. It's allocated with the allocator
+// of the context and frees itself once the sender completes.
+template <typename SenderId>
+class detached_op {
+  using sender_t = stdexec::__t<SenderId>;
+
+ public:
+  struct __t;
+
+  struct receiver {
+    using is_receiver = void;
+    using __t = receiver;
+    using __id = receiver;
+
+    template <typename... Values>
+    friend void tag_invoke(stdexec::set_value_t, receiver&& self,
+                           Values&&...) noexcept {
+      self.op_->destroy();
+    }
+
+    // Same as `stdexec::start_detached`, errors are not allowed.
+    template <typename Error>
+    friend void tag_invoke(stdexec::set_error_t, receiver&&,
+                           Error&&) noexcept {
+      std::terminate();
+    }
+
+    friend void tag_invoke(stdexec::set_stopped_t, receiver&& self) noexcept {
+      self.op_->destroy();
+    }
+
+    friend auto tag_invoke(stdexec::get_env_t, const receiver& self) noexcept
+        -> detached_env {
+      return {&self.op_->context_};
+    }
+
+    detached_op::__t* op_;
+  };
+
+  struct __t : stdexec::__immovable {
+    using __id = detached_op;
+    using allocator_t = epoll_context::allocator<__t>;
+
+    __t(epoll_context& context, sender_t&& sender)
+        : context_(context),
+          op_(stdexec::connect(static_cast<sender_t&&>(sender),
+                               receiver{this})) {}
+
+    void destroy() noexcept {
+      allocator_t alloc{context_};
+      std::destroy_at(this);
+      alloc.deallocate(this, 1);
+    }
+
+    epoll_context& context_;
+    stdexec::connect_result_t<sender_t, receiver> op_;
+  };
+};
+
+struct start_detached_t {
+  // Start `sender` without waiting for it. Unlike `stdexec::start_detached`,
+  // the operation state is allocated from the operation pool of `context`, and
+  // the receiver's environment exposes that pool through `get_allocator`. The
+  // sender must not complete with an error.
+  template <stdexec::sender Sender>
+  void operator()(epoll_context& context, Sender&& sender) const {
+    using op_t =
+        stdexec::__t<detached_op<stdexec::__id<std::remove_cvref_t<Sender>>>>;
+    typename op_t::allocator_t alloc{context};
+    op_t* op = alloc.allocate(1);
+    try {
+      std::construct_at(op, context,
+                        std::remove_cvref_t<Sender>(
+                            static_cast<Sender&&>(sender)));
+    } catch (...) {
+      alloc.deallocate(op, 1);
+      throw;
+    }
+    stdexec::start(op->op_);
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::start_detached_t start_detached{};
+}  // namespace net
+
+#endif  // EPOLL_START_DETACHED_HPP_
@@ -0,0 +1,341 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef EPOLL_STEADY_TIMER_HPP_
+#define EPOLL_STEADY_TIMER_HPP_
+
+#include <atomic>
+#include <cassert>
+#include <chrono>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "epoll/epoll_context.hpp"
+#include "intrusive_list.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+
+// A timer object any number of operations can wait on. All waits share one
+// entry in the timer heap of the context, and complete together when the
+// expiry passes.
+//
+// Re-arming is made for timers pushed back over and over, e.g. a keepalive
+// re-armed on every packet: moving the expiry later only stores it, the entry
+// stays where it is and, once it fires, goes back into the heap at the stored
+// expiry. That is one heap insert per period instead of a remove and insert
+// per re-arm. Moving the expiry earlier repositions the entry in O(1).
+// Pending waits follow the expiry rather than being canceled by a re-arm.
+//
+// The expiry and `cancel` are io thread only, waits may start from any
+// thread. The timer is destroyed on the io thread with no pending wait.
+class epoll_context::steady_timer {
+ public:
+  // A pending wait.
+  struct waiter : operation_base {
+    // Called on the io thread, `expired` is false if the wait was canceled.
+    void (*complete_)(waiter*, bool expired) noexcept = nullptr;
+    waiter* next_waiter_ = nullptr;
+    waiter* prev_waiter_ = nullptr;
+    steady_timer* owner_ = nullptr;
+    // Whether the waiter is in the list of the timer.
+    bool linked_ = false;
+  };
+
+  // Constructor. The timer has expired until an expiry is set.
+  explicit steady_timer(epoll_context& context) noexcept
+      : entry_(context, *this), expiry_(), armed_(false) {}
+
+  steady_timer(const steady_timer&) = delete;
+  steady_timer& operator=(const steady_timer&) = delete;
+
+  // Destructor.
+  ~steady_timer() {
+    assert(waiters_.empty());
+    assert(!entry_.enqueued_);
+    if (armed_) {
+      context().remove_timer(&entry_);
+    }
+  }
+
+  // The context the waits complete on.
+  epoll_context& context() noexcept { return entry_.context_; }
+
+  // The time the waits complete at.
+  time_point expiry() const noexcept { return expiry_; }
+
+  // Set the expiry to `due_time`.
+  void expires_at(time_point due_time) noexcept {
+    assert(context().is_running_on_io_thread());
+    expiry_ = due_time;
+    if (armed_ && due_time < entry_.due_time_) {
+      entry_.due_time_ = due_time;
+      context().advance_timer(&entry_);
+    }
+  }
+
+  // Set the expiry to `duration` after the loop time.
+  template <typename Rep, typename Ratio>
+  void expires_after(std::chrono::duration<Rep, Ratio> duration) noexcept {
+    expires_at(context().loop_now() + duration);
+  }
+
+  // Complete the pending waits with stopped. Returns how many there were.
+  std::size_t cancel() noexcept {
+    assert(context().is_running_on_io_thread());
+    if (armed_) {
+      armed_ = false;
+      context().remove_timer(&entry_);
+    }
+    return complete_all(false);
+  }
+
+  // Wait for the expiry. From another thread the wait is queued once the io
+  // thread picks it up.
+  void wait(waiter* w) noexcept {
+    w->owner_ = this;
+    if (context().is_running_on_io_thread()) {
+      add(w);
+    } else {
+      w->execute_ = [](operation_base* op) noexcept {
+        auto* w = static_cast<waiter*>(op);
+        w->owner_->add(w);
+      };
+      context().schedule_remote(w);
+    }
+  }
+
+  // Take a pending wait out of the timer, it won't complete. Runs on the io
+  // thread.
+  void remove(waiter* w) noexcept {
+    if (w->linked_) {
+      w->linked_ = false;
+      waiters_.remove(w);
+    }
+  }
+
+ private:
+  // The heap entry of the timer.
+  struct entry : schedule_at_base_op {
+    entry(epoll_context& context, steady_timer& owner) noexcept
+        : schedule_at_base_op(context, time_point{}, false), owner_(owner) {
+      this->execute_ = [](operation_base* op) noexcept {
+        static_cast<entry*>(op)->owner_.fire();
+      };
+    }
+
+    steady_timer& owner_;
+  };
+
+  // Runs on the io thread.
+  void add(waiter* w) noexcept {
+    if (expiry_ <= context().loop_now()) {
+      w->complete_(w, true);
+      return;
+    }
+    w->linked_ = true;
+    waiters_.push_back(w);
+    // An entry which has fired but not run yet re-arms by itself.
+    if (!armed_ && !entry_.enqueued_.load(std::memory_order_relaxed)) {
+      arm();
+    }
+  }
+
+  void arm() noexcept {
+    armed_ = true;
+    entry_.due_time_ = expiry_;
+    context().schedule_at_impl(&entry_);
+  }
+
+  // The heap entry has elapsed.
+  void fire() noexcept {
+    armed_ = false;
+    if (waiters_.empty()) {
+      return;
+    }
+    if (context().loop_now() < expiry_) {
+      // Pushed back since the entry was armed.
+      arm();
+      return;
+    }
+    complete_all(true);
+  }
+
+  // The waits are taken out first, a completion may wait again or destroy
+  // this timer.
+  std::size_t complete_all(bool expired) noexcept {
+    waiter_list ready(std::move(waiters_));
+    std::size_t count = 0;
+    while (!ready.empty()) {
+      waiter* w = ready.pop_front();
+      w->linked_ = false;
+      w->complete_(w, expired);
+      ++count;
+    }
+    return count;
+  }
+
+  using waiter_list = intrusive_list<waiter, &waiter::next_waiter_,
+                                     &waiter::prev_waiter_>;
+
+  entry entry_;
+  time_point expiry_;
+  waiter_list waiters_;
+  // Whether `entry_` is in the timer heap.
+  bool armed_;
+};
+
+// A wait on a `steady_timer`.
+template <typename ReceiverId>
+class epoll_context::timer_wait_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  using stop_token = stdexec::stop_token_of_t<stdexec::env_of_t<receiver_t>>;
+  using timer_t = epoll_context::steady_timer;
+
+ public:
+  struct __t : public stdexec::__immovable,
+               private timer_t::waiter,
+               private epoll_context::stop_op {
+    using __id = timer_wait_op;
+
+    // Constructor.
+    __t(receiver_t receiver, timer_t& timer) noexcept
+        : receiver_(static_cast<receiver_t&&>(receiver)),
+          timer_(timer),
+          state_(0),
+          stop_callback_() {
+      this->complete_ = &complete;
+    }
+
+    friend void tag_invoke(stdexec::start_t, __t& self) noexcept {
+      if constexpr (!stdexec::unstoppable_token<stop_token>) {
+        self.stop_callback_.__construct(
+            stdexec::get_stop_token(stdexec::get_env(self.receiver_)),
+            cancel_callback{self});
+      }
+      self.timer_.wait(static_cast<typename timer_t::waiter*>(&self));
+    }
+
+   private:
+    // Complete the operation unless a stop has been requested, in which case
+    // the stop operation completes it.
+    static void complete(typename timer_t::waiter* w, bool expired) noexcept {
+      auto& self = *static_cast<__t*>(w);
+      if constexpr (!stdexec::unstoppable_token<stop_token>) {
+        self.stop_callback_.__destruct();
+      }
+      auto old_state =
+          self.state_.fetch_add(operation_ended, std::memory_order_acq_rel);
+      if ((old_state & request_stopped_mask) != 0) {
+        return;
+      }
+      if (expired) {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_));
+      } else {
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      }
+    }
+
+    // Send the stopped signal to the downstream receiver.
+    static void complete_with_stop(operation_base* op) noexcept {
+      auto& self = *static_cast<__t*>(static_cast<stop_op*>(op));
+      auto& w = static_cast<typename timer_t::waiter&>(self);
+      if (!w.enqueued_.load()) {
+        self.timer_.remove(&w);
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      } else {
+        // Wait for the pending wait to reach the timer first.
+        static_cast<stop_op&>(self).execute_ = &complete_with_stop;
+        self.timer_.context().schedule_local(static_cast<stop_op*>(op));
+      }
+    }
+
+    // A thread requests that this operation should be stopped.
+    void request_stop() noexcept {
+      auto old_state =
+          state_.fetch_add(request_stopped, std::memory_order_acq_rel);
+      if ((old_state & operation_ended_mask) == 0) {
+        static_cast<stop_op*>(this)->execute_ = &complete_with_stop;
+        timer_.context().schedule_remote(static_cast<stop_op*>(this));
+      }
+    }
+
+    // Use theses to synchronize the stopping thread and the io thread.
+    static constexpr uint32_t operation_ended = 0x00010000;
+    static constexpr uint32_t operation_ended_mask = 0xFFFF0000;
+    static constexpr uint32_t request_stopped = 0x1;
+    static constexpr uint32_t request_stopped_mask = 0xFFFF;
+
+    // The cancel callback.
+    struct cancel_callback {
+      __t& op_;
+
+      void operator()() noexcept { op_.request_stop(); }
+    };
+
+    receiver_t receiver_;
+    timer_t& timer_;
+    std::atomic<uint32_t> state_;
+    exec::__manual_lifetime<
+        typename stop_token::template callback_type<cancel_callback>>
+        stop_callback_;
+  };
+};
+
+class timer_wait_sender {
+  template <typename Receiver>
+  using op_t =
+      stdexec::__t<epoll_context::timer_wait_op<stdexec::__id<Receiver>>>;
+  using timer_t = epoll_context::steady_timer;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = timer_wait_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.timer_};
+    }
+
+    explicit constexpr __t(timer_t& timer) noexcept : timer_(timer) {}
+
+   private:
+    timer_t& timer_;
+  };
+};
+}  // namespace __epoll
+
+using steady_timer = __epoll::epoll_context::steady_timer;
+}  // namespace net
+
+#endif  // EPOLL_STEADY_TIMER_HPP_
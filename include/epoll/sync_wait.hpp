@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_SYNC_WAIT_HPP_
+#define EPOLL_SYNC_WAIT_HPP_
+
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <system_error>  // NOLINT
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "epoll/epoll_context.hpp"
+#include "epoll/start_detached.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+template <typename... Values>
+using sync_wait_tuple = std::tuple<std::decay_t<Values>...>;
+
+// The sender must have at most one value completion.
+template <typename... Tuples>
+struct sync_wait_single_impl {};
+
+template <>
+struct sync_wait_single_impl<> {
+  using type = std::tuple<>;
+};
+
+template <typename Tuple>
+struct sync_wait_single_impl<Tuple> {
+  using type = Tuple;
+};
+
+template <typename... Tuples>
+using sync_wait_single = typename sync_wait_single_impl<Tuples...>::type;
+
+template <typename Sender>
+using sync_wait_result_t = std::optional<stdexec::value_types_of_t<
+    Sender, detached_env, sync_wait_tuple, sync_wait_single>>;
+
+// The state of `sync_wait`. The sender is started by the first operation
+// executed by the loop, so the operations it starts are scheduled on the
+// local queue. A completion from another thread is published through the
+// remote queue, the loop leaves once `done_` is set on the calling thread.
+template <typename Sender>
+class epoll_context::sync_wait_op {
+  using result_t = sync_wait_result_t<Sender>;
+  using value_t = typename result_t::value_type;
+
+  struct receiver {
+    using is_receiver = void;
+    using __t = receiver;
+    using __id = receiver;
+
+    template <typename... Values>
+    friend void tag_invoke(stdexec::set_value_t, receiver&& self,
+                           Values&&... values) noexcept {
+      try {
+        self.op_->result_.template emplace<1>(
+            static_cast<Values&&>(values)...);
+      } catch (...) {
+        self.op_->result_.template emplace<2>(std::current_exception());
+      }
+      self.op_->wake();
+    }
+
+    template <typename Error>
+    friend void tag_invoke(stdexec::set_error_t, receiver&& self,
+                           Error&& error) noexcept {
+      self.op_->result_.template emplace<2>(
+          as_exception_ptr(static_cast<Error&&>(error)));
+      self.op_->wake();
+    }
+
+    friend void tag_invoke(stdexec::set_stopped_t, receiver&& self) noexcept {
+      self.op_->wake();
+    }
+
+    friend auto tag_invoke(stdexec::get_env_t, const receiver& self) noexcept
+        -> detached_env {
+      return {&self.op_->context_};
+    }
+
+    sync_wait_op* op_;
+  };
+
+ public:
+  sync_wait_op(epoll_context& context, Sender&& sender)
+      : context_(context),
+        done_(false),
+        result_(),
+        op_(stdexec::connect(static_cast<Sender&&>(sender), receiver{this})) {}
+
+  // Run the context on the calling thread until the sender completes.
+  result_t run() {
+    start_.execute_ = &sync_wait_op::on_start;
+    context_.schedule_local(&start_);
+    while (!done_) {
+      (void)context_.run_one();
+    }
+    if (result_.index() == 2) {
+      std::rethrow_exception(std::get<2>(static_cast<variant_t&&>(result_)));
+    }
+    if (result_.index() == 1) {
+      return result_t{std::get<1>(static_cast<variant_t&&>(result_))};
+    }
+    return std::nullopt;
+  }
+
+ private:
+  // A start or wake operation of this state.
+  struct step : operation_base {
+    sync_wait_op* op_;
+  };
+
+  static void on_start(operation_base* op) noexcept {
+    stdexec::start(static_cast<step*>(op)->op_->op_);
+  }
+
+  static void on_wake(operation_base* op) noexcept {
+    static_cast<step*>(op)->op_->done_ = true;
+  }
+
+  void wake() noexcept {
+    if (context_.is_running_on_io_thread()) {
+      done_ = true;
+    } else {
+      wake_.execute_ = &sync_wait_op::on_wake;
+      context_.schedule_remote(&wake_);
+    }
+  }
+
+  // Errors are rethrown like `stdexec::sync_wait` does.
+  template <typename Error>
+  static std::exception_ptr as_exception_ptr(Error&& error) noexcept {
+    if constexpr (std::is_same_v<std::decay_t<Error>, std::exception_ptr>) {
+      return error;
+    } else if constexpr (std::is_same_v<std::decay_t<Error>,
+                                        std::error_code>) {
+      return std::make_exception_ptr(std::system_error(error));
+    } else {
+      return std::make_exception_ptr(static_cast<Error&&>(error));
+    }
+  }
+
+  using variant_t = std::variant<std::monostate, value_t, std::exception_ptr>;
+
+  epoll_context& context_;
+  bool done_;
+  variant_t result_;
+  step start_{{}, this};
+  step wake_{{}, this};
+  stdexec::connect_result_t<Sender, receiver> op_;
+};
+
+struct sync_wait_t {
+  // Start `sender` and run `context` on the calling thread until it
+  // completes, so that the operations started by the sender are executed
+  // inline without waking up another thread. Returns the values of the sender,
+  // or nullopt if it is stopped; errors are thrown like
+  // `stdexec::sync_wait` does. The context must not be running on another
+  // thread nor be requested to stop.
+  template <stdexec::sender_in<detached_env> Sender>
+  auto operator()(epoll_context& context, Sender&& sender) const
+      -> sync_wait_result_t<std::remove_cvref_t<Sender>> {
+    if (context.is_running()) {
+      throw std::runtime_error("net::sync_wait() called on a running context");
+    }
+    if (context.stop_requested()) {
+      throw std::runtime_error("net::sync_wait() called on a stopped context");
+    }
+    epoll_context::sync_wait_op<std::remove_cvref_t<Sender>> op{
+        context,
+        std::remove_cvref_t<Sender>(static_cast<Sender&&>(sender))};
+    return op.run();
+  }
+};
+}  // namespace __epoll
+
+inline constexpr __epoll::sync_wait_t sync_wait{};
+}  // namespace net
+
+#endif  // EPOLL_SYNC_WAIT_HPP_
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_TCP_INFO_SAMPLER_HPP_
+#define EPOLL_TCP_INFO_SAMPLER_HPP_
+
+#include <algorithm>
+#include <chrono>    // NOLINT
+#include <concepts>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "connection_table.hpp"
+#include "epoll/epoll_context.hpp"
+#include "ip/tcp.hpp"
+
+namespace net {
+
+// The last TCP_INFO sample of a connection, kept by a `tcp_info_sampler` so
+// that deciding a batch size or a pace costs no getsockopt, e.g.
+//
+//   queue.set_rate_limit(c.tcp_sample().window_rate(),
+//                        c.tcp_sample().window_bytes());
+class tcp_info_cache {
+ public:
+  // The latest sample, all zeros until the first one.
+  const ip::tcp::info& tcp_sample() const noexcept { return sample_; }
+
+  // The loop time of the latest sample, the epoch until the first one.
+  epoll_context::time_point tcp_sampled_at() const noexcept {
+    return sampled_at_;
+  }
+
+  // Whether the connection has been sampled.
+  bool has_tcp_sample() const noexcept {
+    return sampled_at_ != epoll_context::time_point{};
+  }
+
+ private:
+  template <typename T, typename SocketOf, std::size_t SlabSize>
+    requires std::derived_from<T, tcp_info_cache>
+  friend class tcp_info_sampler;
+
+  ip::tcp::info sample_;
+  epoll_context::time_point sampled_at_;
+};
+
+// Reads TCP_INFO for the connections of a table a few at a time, so the cost
+// per iteration of the run loop stays bounded however many connections
+// there are. Runs as a loop task of the context: every `interval` a pass
+// samples the table in batches of `batch_size` connections, one batch per
+// iteration, and caches each sample in the connection. `socket_of(T&)`
+// returns the tcp socket of a connection, closed sockets are skipped.
+//
+// Only used from the io thread, or while the context is not running.
+template <typename T, typename SocketOf, std::size_t SlabSize = 1024>
+  requires std::derived_from<T, tcp_info_cache>
+class tcp_info_sampler : private epoll_context::loop_task {
+ public:
+  using table_t = connection_table<T, SlabSize>;
+  using handle = typename table_t::handle;
+
+  // Constructor.
+  tcp_info_sampler(epoll_context& context, table_t& table,
+                   std::chrono::nanoseconds interval, SocketOf socket_of,
+                   std::size_t batch_size = 64) noexcept
+      : context_(context),
+        table_(table),
+        interval_(std::max<std::chrono::nanoseconds>(
+            interval, std::chrono::milliseconds(1))),
+        socket_of_(static_cast<SocketOf&&>(socket_of)),
+        batch_size_(std::max<std::size_t>(batch_size, 1)),
+        cursor_(0),
+        sample_count_(0),
+        error_count_(0),
+        running_(false) {
+    this->execute_ = &tcp_info_sampler::sample;
+  }
+
+  tcp_info_sampler(const tcp_info_sampler&) = delete;
+  tcp_info_sampler& operator=(const tcp_info_sampler&) = delete;
+
+  // Destructor.
+  ~tcp_info_sampler() { stop(); }
+
+  // Start sampling, the first pass begins in the next iteration.
+  void start() noexcept {
+    if (running_) {
+      return;
+    }
+    running_ = true;
+    cursor_ = 0;
+    this->due_ = context_.loop_now();
+    context_.add_loop_task(this);
+  }
+
+  // Stop sampling.
+  void stop() noexcept {
+    if (!running_) {
+      return;
+    }
+    running_ = false;
+    context_.remove_loop_task(this);
+  }
+
+  // Whether the sampler is started.
+  bool is_running() const noexcept { return running_; }
+
+  // The count of samples taken.
+  std::uint64_t sample_count() const noexcept { return sample_count_; }
+
+  // The count of getsockopt calls which failed, e.g. for a socket which isn't
+  // connected.
+  std::uint64_t error_count() const noexcept { return error_count_; }
+
+ private:
+  static void sample(epoll_context::loop_task* task) noexcept {
+    auto& self = static_cast<tcp_info_sampler&>(*task);
+    const epoll_context::time_point now = self.context_.loop_now();
+    const std::size_t end =
+        std::min(self.cursor_ + self.batch_size_, self.table_.size());
+    for (; self.cursor_ < end; ++self.cursor_) {
+      T& connection = *self.table_.get(self.table_.at_position(self.cursor_));
+      auto& socket = self.socket_of_(connection);
+      if (!socket.is_open()) {
+        continue;
+      }
+      tcp_info_cache& cache = connection;
+      if (socket.get_option(cache.sample_).success()) {
+        cache.sampled_at_ = now;
+        ++self.sample_count_;
+      } else {
+        ++self.error_count_;
+      }
+    }
+
+    if (self.cursor_ < self.table_.size()) {
+      // Continue in the next iteration.
+      self.due_ = now;
+    } else {
+      self.cursor_ = 0;
+      self.due_ = now + self.interval_;
+    }
+  }
+
+  epoll_context& context_;
+  table_t& table_;
+  std::chrono::nanoseconds interval_;
+  SocketOf socket_of_;
+  std::size_t batch_size_;
+
+  // The position in the table the current pass continues from.
+  std::size_t cursor_;
+  std::uint64_t sample_count_;
+  std::uint64_t error_count_;
+  bool running_;
+};
+
+}  // namespace net
+
+#endif  // EPOLL_TCP_INFO_SAMPLER_HPP_
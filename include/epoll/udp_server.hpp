@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_UDP_SERVER_HPP_
+#define EPOLL_UDP_SERVER_HPP_
+
+#include <sys/socket.h>
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <system_error>  // NOLINT
+#include <vector>
+
+#include "status-code/system_code.hpp"
+
+#include "buffer.hpp"
+#include "datagram_batch.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/reactor_pool.hpp"
+#include "epoll/socket_recv_batch_op.hpp"
+#include "epoll/socket_send_batch_op.hpp"
+#include "socket_base.hpp"
+#include "stat_counter.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __epoll {
+// A datagram server spread over the contexts of a reactor_pool. Every context
+// gets its own socket bound to the same endpoint with SO_REUSEPORT, so the
+// kernel balances the flows among them and no datagram crosses threads.
+//
+// Each shard receives with recvmmsg into a batch of buffers allocated once,
+// hands the datagrams to its own copy of the handler and sends the replies
+// the handler queued with one sendmmsg, then receives the next batch. The
+// handler is called on the io thread of the shard as
+//
+//   handler(const datagram_batch<Protocol>& received, std::size_t count,
+//           datagram_batch<Protocol>& replies)
+//
+// where the first `count` datagrams of `received` are valid. The replies may
+// point into the received buffers, they are sent before the buffers are
+// reused.
+template <typename Protocol, typename Handler>
+class udp_server {
+ public:
+  using protocol_type = Protocol;
+  using endpoint_type = typename Protocol::endpoint;
+  using socket_type = typename Protocol::socket;
+  using batch_type = datagram_batch<Protocol>;
+
+  struct options {
+    // The count of datagrams received or sent with one syscall.
+    std::size_t batch_size = 64;
+
+    // The size of each receive buffer, longer datagrams are truncated.
+    std::size_t max_datagram_size = 2048;
+
+    // SO_RCVBUF of each socket, zero keeps the system default.
+    int receive_buffer_size = 0;
+  };
+
+  struct statistics {
+    // The count of datagrams received.
+    std::uint64_t received = 0;
+
+    // The count of replies sent.
+    std::uint64_t sent = 0;
+
+    // The count of recvmmsg calls which returned datagrams.
+    std::uint64_t batches = 0;
+
+    // The count of failed receives and sends.
+    std::uint64_t errors = 0;
+  };
+
+  // Open one socket for each context of `pool`, all of them bound to
+  // `endpoint`. If the port of `endpoint` is zero, the first socket picks one
+  // and the others share it. Throws an error when a socket can't be opened.
+  udp_server(reactor_pool& pool, const endpoint_type& endpoint,
+             const Handler& handler, const options& opts = {})
+      : options_(opts), stop_source_(), shards_(), running_(0) {
+    assert(options_.batch_size > 0 && options_.max_datagram_size > 0);
+    shards_.reserve(pool.size());
+    endpoint_type local = endpoint;
+    for (std::size_t i = 0; i < pool.size(); ++i) {
+      auto& s = shards_.emplace_back(
+          std::make_unique<shard>(*this, pool.context(i), handler));
+      open(s->socket_, local);
+      if (i == 0) {
+        auto bound = s->socket_.local_endpoint();
+        if (bound.has_error()) {
+          throw_error(bound.error(), "getsockname");
+        }
+        local = bound.value();
+      }
+    }
+  }
+
+  udp_server(const udp_server&) = delete;
+  udp_server& operator=(const udp_server&) = delete;
+
+  // Destructor. Stops the shards and waits for them, so the contexts of a
+  // started server must still be running.
+  ~udp_server() {
+    request_stop();
+    wait();
+  }
+
+  // Start serving on every shard. May be called from any thread, the shards
+  // begin once their contexts run.
+  void start() noexcept {
+    running_.store(shards_.size(), std::memory_order_relaxed);
+    for (auto& s : shards_) {
+      s->receive();
+    }
+  }
+
+  // Ask every shard to stop. A shard in the middle of a batch stops after
+  // sending its replies.
+  void request_stop() noexcept { stop_source_.request_stop(); }
+
+  // Block until every shard has stopped.
+  void wait() noexcept {
+    for (auto n = running_.load(std::memory_order_acquire); n != 0;
+         n = running_.load(std::memory_order_acquire)) {
+      running_.wait(n, std::memory_order_acquire);
+    }
+  }
+
+  // The count of shards, one for each context of the pool.
+  std::size_t size() const noexcept { return shards_.size(); }
+
+  // The endpoint the sockets are bound to.
+  endpoint_type local_endpoint() const noexcept {
+    return shards_.front()->socket_.local_endpoint().value();
+  }
+
+  // Get the socket of the shard at `index`, e.g. to set more options before
+  // start().
+  socket_type& socket(std::size_t index) noexcept {
+    assert(index < shards_.size());
+    return shards_[index]->socket_;
+  }
+
+  // The error that stopped the shard at `index`, empty if it stopped on
+  // request.
+  std::error_code error(std::size_t index) const noexcept {
+    assert(index < shards_.size());
+    return shards_[index]->error_;
+  }
+
+  // The statistics of the shard at `index`, may be read from any thread.
+  statistics stats(std::size_t index) const noexcept {
+    assert(index < shards_.size());
+    const shard& s = *shards_[index];
+    return {.received = s.received_.load(),
+            .sent = s.sent_.load(),
+            .batches = s.batches_.load(),
+            .errors = s.errors_.load()};
+  }
+
+  // The statistics summed over all shards.
+  statistics stats() const noexcept {
+    statistics total;
+    for (std::size_t i = 0; i < shards_.size(); ++i) {
+      statistics s = stats(i);
+      total.received += s.received;
+      total.sent += s.sent;
+      total.batches += s.batches;
+      total.errors += s.errors;
+    }
+    return total;
+  }
+
+ private:
+  struct shard;
+
+  // The environment of the operations of a shard, which are cancelled by
+  // request_stop().
+  struct env {
+    friend auto tag_invoke(stdexec::get_stop_token_t, const env& self) noexcept
+        -> stdexec::in_place_stop_token {
+      return self.token_;
+    }
+
+    stdexec::in_place_stop_token token_;
+  };
+
+  struct recv_receiver {
+    using is_receiver = void;
+    using __t = recv_receiver;
+    using __id = recv_receiver;
+
+    friend void tag_invoke(stdexec::set_value_t, recv_receiver&& self,
+                           std::size_t count) noexcept {
+      self.shard_->on_received(count);
+    }
+
+    friend void tag_invoke(stdexec::set_error_t, recv_receiver&& self,
+                           std::error_code&& ec) noexcept {
+      self.shard_->on_receive_error(ec);
+    }
+
+    friend void tag_invoke(stdexec::set_stopped_t,
+                           recv_receiver&& self) noexcept {
+      self.shard_->finish();
+    }
+
+    friend auto tag_invoke(stdexec::get_env_t,
+                           const recv_receiver& self) noexcept -> env {
+      return {self.shard_->server_.stop_source_.get_token()};
+    }
+
+    shard* shard_;
+  };
+
+  struct send_receiver {
+    using is_receiver = void;
+    using __t = send_receiver;
+    using __id = send_receiver;
+
+    friend void tag_invoke(stdexec::set_value_t, send_receiver&& self,
+                           std::size_t count) noexcept {
+      self.shard_->sent_.add(count);
+      self.shard_->receive();
+    }
+
+    // The replies are dropped, serving goes on.
+    friend void tag_invoke(stdexec::set_error_t, send_receiver&& self,
+                           std::error_code&&) noexcept {
+      self.shard_->errors_.add();
+      self.shard_->receive();
+    }
+
+    friend void tag_invoke(stdexec::set_stopped_t,
+                           send_receiver&& self) noexcept {
+      self.shard_->finish();
+    }
+
+    friend auto tag_invoke(stdexec::get_env_t,
+                           const send_receiver& self) noexcept -> env {
+      return {self.shard_->server_.stop_source_.get_token()};
+    }
+
+    shard* shard_;
+  };
+
+  using recv_op_t = stdexec::__t<epoll_context::socket_recv_batch_op<
+      stdexec::__id<recv_receiver>, Protocol>>;
+  using send_op_t = stdexec::__t<epoll_context::socket_send_batch_op<
+      stdexec::__id<send_receiver>, Protocol>>;
+
+  // The socket, buffers and handler of one context. Only touched by its io
+  // thread once started, except for the counters.
+  struct shard {
+    shard(udp_server& server, epoll_context& context, const Handler& handler)
+        : server_(server),
+          socket_(context),
+          handler_(handler),
+          storage_(server.options_.batch_size *
+                   server.options_.max_datagram_size),
+          received_batch_(server.options_.batch_size),
+          replies_(server.options_.batch_size) {
+      const std::size_t size = server.options_.max_datagram_size;
+      for (std::size_t i = 0; i < server.options_.batch_size; ++i) {
+        received_batch_.push_back(mutable_buffer(&storage_[i * size], size));
+      }
+    }
+
+    // Receive the next batch, unless the server is stopping. The operation
+    // of the previous batch has completed, so its state is reused.
+    void receive() noexcept {
+      if (server_.stop_source_.stop_requested()) {
+        finish();
+        return;
+      }
+      recv_op_.emplace(recv_receiver{this}, socket_, received_batch_);
+      stdexec::start(*recv_op_);
+    }
+
+    void on_received(std::size_t count) noexcept {
+      received_.add(count);
+      batches_.add();
+      replies_.clear();
+      handler_(static_cast<const batch_type&>(received_batch_), count,
+               replies_);
+      if (replies_.empty()) {
+        receive();
+        return;
+      }
+      send_op_.emplace(send_receiver{this}, socket_, replies_);
+      stdexec::start(*send_op_);
+    }
+
+    // ICMP errors of earlier sends are reported by the next receive on an
+    // unconnected socket and don't concern the other peers.
+    void on_receive_error(const std::error_code& ec) noexcept {
+      errors_.add();
+      if (ec == std::errc::connection_refused ||
+          ec == std::errc::connection_reset ||
+          ec == std::errc::host_unreachable ||
+          ec == std::errc::network_unreachable) {
+        receive();
+        return;
+      }
+      error_ = ec;
+      finish();
+    }
+
+    void finish() noexcept {
+      if (server_.running_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        server_.running_.notify_all();
+      }
+    }
+
+    udp_server& server_;
+    socket_type socket_;
+    Handler handler_;
+    std::vector<std::byte> storage_;
+    batch_type received_batch_;
+    batch_type replies_;
+    std::optional<recv_op_t> recv_op_;
+    std::optional<send_op_t> send_op_;
+    std::error_code error_;
+    stat_counter<true> received_;
+    stat_counter<true> sent_;
+    stat_counter<true> batches_;
+    stat_counter<true> errors_;
+  };
+
+  void open(socket_type& socket, const endpoint_type& endpoint) {
+    if (auto ec = socket.open(endpoint.protocol()); ec.failure()) {
+      throw_error(ec, "socket");
+    }
+    if (auto ec = socket.set_option(socket_base::reuse_port{true});
+        ec.failure()) {
+      throw_error(ec, "SO_REUSEPORT");
+    }
+    if (options_.receive_buffer_size > 0) {
+      auto ec = socket.set_option(
+          socket_base::receive_buffer_size{options_.receive_buffer_size});
+      if (ec.failure()) {
+        throw_error(ec, "SO_RCVBUF");
+      }
+    }
+    if (auto ec = socket.bind(endpoint); ec.failure()) {
+      throw_error(ec, "bind");
+    }
+    if (auto ec = socket.set_non_blocking(true); ec.failure()) {
+      throw_error(ec, "FIONBIO");
+    }
+  }
+
+  [[noreturn]] static void throw_error(const system_error2::system_code& ec,
+                                       const char* what) {
+    throw std::system_error{static_cast<int>(ec.value()),
+                            std::system_category(), what};
+  }
+
+  options options_;
+
+  // Declared before the shards, whose operations hold its stop callbacks.
+  stdexec::in_place_stop_source stop_source_;
+  std::vector<std::unique_ptr<shard>> shards_;
+
+  // The count of started shards which haven't stopped yet.
+  std::atomic<std::size_t> running_;
+};
+
+template <typename Endpoint, typename Handler>
+udp_server(reactor_pool&, const Endpoint&, const Handler&)
+    -> udp_server<typename Endpoint::protocol_type, Handler>;
+
+template <typename Endpoint, typename Handler>
+udp_server(reactor_pool&, const Endpoint&, const Handler&,
+           const typename udp_server<typename Endpoint::protocol_type,
+                                     Handler>::options&)
+    -> udp_server<typename Endpoint::protocol_type, Handler>;
+}  // namespace __epoll
+
+using __epoll::udp_server;
+}  // namespace net
+
+#endif  // EPOLL_UDP_SERVER_HPP_
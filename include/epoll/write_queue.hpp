@@ -0,0 +1,664 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EPOLL_WRITE_QUEUE_HPP_
+#define EPOLL_WRITE_QUEUE_HPP_
+
+#include <sys/uio.h>
+
+#include <cassert>
+#include <concepts>      // NOLINT
+#include <cstddef>
+#include <cstdint>
+#include <system_error>  // NOLINT
+
+#include "status-code/system_code.hpp"
+
+#include "basic_socket.hpp"
+#include "buffer.hpp"
+#include "buffer_sequence_adapter.hpp"
+#include "compact_code.hpp"
+#include "epoll/epoll_context.hpp"
+#include "meta.hpp"
+#include "stdexec.hpp"
+#include "token_bucket.hpp"
+
+namespace net {
+namespace __epoll {
+
+// The outgoing queue of a stream socket. Writes submitted while the run loop
+// drains its local queue are gathered and flushed by a loop task right after
+// it, with one `sendmsg` of up to `max_buffers` iovecs for as many writes as
+// fit. Writes complete in submission order, each with its own byte count.
+// If the socket is full, the queue parks on the write slot of the socket's
+// descriptor state and resumes once epoll reports it writable, so another
+// operation may not wait for writability of the same socket meanwhile.
+//
+// The bytes queued but not yet handed to the kernel are counted, so that
+// producers may wait for the queue to fall below a mark before queueing
+// more instead of buffering without bound for a peer that stopped reading.
+// Only this count is waited on: the kernel send queue is bounded by
+// SO_SNDBUF, `send_backlog` reports both.
+//
+// A rate limit paces the queue with a token bucket: a flush sends at most
+// the tokens there are, and with none left it sleeps on a timer of the
+// context until a burst has accrued, rather than waiting on the write slot.
+// Delays of a coarse tick or more go into the timing wheel.
+//
+// Queued writes and waits can't be stopped. A failed `sendmsg` fails every
+// queued write, later writes on a broken stream would fail anyway. The queue
+// must be empty and without waiters when it's destroyed.
+template <typename Protocol>
+class epoll_context::write_queue {
+  using socket_t = typename Protocol::socket;
+
+ public:
+  // The base of a queued write.
+  struct entry : completion_op {
+    // Copy the remaining native buffers into `iov`, at most `room` of them.
+    std::size_t (*gather_)(entry*, iovec* iov, std::size_t room) noexcept;
+
+    // Consume up to `size` sent bytes, returns whether the write is done.
+    bool (*consume_)(entry*, std::size_t& size) noexcept;
+
+    // Notify the receiver of the write.
+    void (*complete_)(entry*, compact_code ec) noexcept;
+
+    write_queue* owner_ = nullptr;
+    entry* next_entry_ = nullptr;
+    // The bytes not yet sent, set to the size of the write before submit.
+    std::size_t remaining_ = 0;
+  };
+
+  // A wait for the queued bytes to fall below `limit_`.
+  struct waiter : completion_op {
+    void (*complete_)(waiter*) noexcept;
+
+    write_queue* owner_ = nullptr;
+    waiter* next_waiter_ = nullptr;
+    std::size_t limit_ = 0;
+  };
+
+  // Constructor.
+  explicit write_queue(basic_socket<Protocol>& socket) noexcept
+      : socket_(static_cast<socket_t&>(socket)),
+        context_(static_cast<epoll_context&>(socket.context())),
+        head_(nullptr),
+        tail_(nullptr),
+        waiters_(nullptr),
+        queued_bytes_(0),
+        flush_task_(*this),
+        writable_op_(*this),
+        bucket_(),
+        pace_timer_(*this),
+        scheduled_(false),
+        parked_(false),
+        paced_(false),
+        flushing_(false) {}
+
+  write_queue(const write_queue&) = delete;
+  write_queue& operator=(const write_queue&) = delete;
+
+  // Destructor.
+  ~write_queue() {
+    assert(head_ == nullptr);
+    assert(waiters_ == nullptr);
+    if (scheduled_) {
+      context_.remove_loop_task(&flush_task_);
+    }
+    if (paced_) {
+      assert(!pace_timer_.enqueued_);
+      context_.remove_timer(&pace_timer_);
+    }
+    if (parked_) {
+      if (void* data = socket_.descriptor_data()) {
+        static_cast<descriptor_state*>(data)->unpark(
+            descriptor_state::write_slot, &writable_op_);
+      }
+    }
+  }
+
+  // The underlying socket.
+  socket_t& socket() noexcept { return socket_; }
+
+  // Whether no write is queued.
+  bool empty() const noexcept { return head_ == nullptr; }
+
+  // The bytes of the queued writes not yet handed to the kernel. Read it on
+  // the io thread.
+  std::size_t queued_bytes() const noexcept { return queued_bytes_; }
+
+  // The queued bytes plus the bytes in the kernel send queue of the socket.
+  result<std::size_t> send_backlog() const noexcept {
+    auto res = socket_.unsent();
+    if (res.has_error()) {
+      return res;
+    }
+    return queued_bytes_ + res.value();
+  }
+
+  // Queue a write. From another thread the write is queued once the io
+  // thread picks it up.
+  void submit(entry* e) noexcept {
+    e->owner_ = this;
+    if (context_.is_running_on_io_thread()) {
+      push(e);
+    } else {
+      e->execute_ = [](operation_base* op) noexcept {
+        auto* e = static_cast<entry*>(static_cast<completion_op*>(op));
+        e->owner_->push(e);
+      };
+      context_.schedule_remote(e);
+    }
+  }
+
+  // Pace the queue to `bytes_per_second`, sending up to `burst` bytes at
+  // once. A zero rate removes the limit. Runs on the io thread.
+  void set_rate_limit(std::uint64_t bytes_per_second,
+                      std::uint64_t burst) noexcept {
+    assert(context_.is_running_on_io_thread());
+    assert(bytes_per_second == 0 || burst != 0);
+    bucket_.set_rate(bytes_per_second, burst, context_.loop_now());
+  }
+
+  // The token bucket pacing the queue.
+  const token_bucket& rate_limit() const noexcept { return bucket_; }
+
+  // Wait for the queued bytes to fall below `w->limit_`. From another thread
+  // the wait starts once the io thread picks it up.
+  void wait_below(waiter* w) noexcept {
+    w->owner_ = this;
+    if (context_.is_running_on_io_thread()) {
+      add_waiter(w);
+    } else {
+      w->execute_ = [](operation_base* op) noexcept {
+        auto* w = static_cast<waiter*>(static_cast<completion_op*>(op));
+        w->owner_->add_waiter(w);
+      };
+      context_.schedule_remote(w);
+    }
+  }
+
+ private:
+  struct flush_task : loop_task {
+    explicit flush_task(write_queue& queue) noexcept : queue_(queue) {
+      this->execute_ = [](loop_task* task) noexcept {
+        auto& queue = static_cast<flush_task*>(task)->queue_;
+        queue.context_.remove_loop_task(task);
+        queue.scheduled_ = false;
+        queue.flush();
+      };
+    }
+
+    write_queue& queue_;
+  };
+
+  struct writable_op : completion_op {
+    explicit writable_op(write_queue& queue) noexcept : queue_(queue) {
+      this->execute_ = [](operation_base* op) noexcept {
+        auto& queue = static_cast<writable_op*>(op)->queue_;
+        queue.parked_ = false;
+        if (descriptor_canceled(queue.socket_.descriptor_data())) {
+          // The socket was closed or the context drained.
+          queue.fail_all(errc::operation_canceled);
+          queue.release_waiters();
+        } else {
+          queue.flush();
+        }
+      };
+    }
+
+    write_queue& queue_;
+  };
+
+  struct pace_timer : schedule_at_base_op {
+    explicit pace_timer(write_queue& queue) noexcept
+        : schedule_at_base_op(queue.context_, time_point{}, false),
+          queue_(queue) {
+      this->execute_ = [](operation_base* op) noexcept {
+        auto& queue = static_cast<pace_timer*>(op)->queue_;
+        queue.paced_ = false;
+        queue.flush();
+      };
+    }
+
+    write_queue& queue_;
+  };
+
+  void push(entry* e) noexcept {
+    e->next_entry_ = nullptr;
+    if (tail_ == nullptr) {
+      head_ = e;
+    } else {
+      tail_->next_entry_ = e;
+    }
+    tail_ = e;
+    queued_bytes_ += e->remaining_;
+    // A flush in progress or a parked or paced queue picks up the write by
+    // itself.
+    if (!scheduled_ && !parked_ && !paced_ && !flushing_) {
+      schedule_flush();
+    }
+  }
+
+  void schedule_flush() noexcept {
+    scheduled_ = true;
+    flush_task_.due_ = context_.loop_now();
+    context_.add_loop_task(&flush_task_);
+  }
+
+  void add_waiter(waiter* w) noexcept {
+    if (queued_bytes_ < w->limit_) {
+      w->complete_(w);
+      return;
+    }
+    w->next_waiter_ = waiters_;
+    waiters_ = w;
+  }
+
+  // Complete the waits whose mark the queue fell below. Completions may
+  // queue more writes or wait again.
+  void release_waiters() noexcept {
+    waiter* ready = nullptr;
+    waiter** link = &waiters_;
+    while (*link != nullptr) {
+      waiter* w = *link;
+      if (queued_bytes_ < w->limit_) {
+        *link = w->next_waiter_;
+        w->next_waiter_ = ready;
+        ready = w;
+      } else {
+        link = &w->next_waiter_;
+      }
+    }
+    while (ready != nullptr) {
+      waiter* w = ready;
+      ready = w->next_waiter_;
+      w->next_waiter_ = nullptr;
+      w->complete_(w);
+    }
+  }
+
+  // Send the queued writes until the queue is empty or the socket is full.
+  void flush() noexcept {
+    flushing_ = true;
+    while (head_ != nullptr) {
+      std::size_t count = 0;
+      std::size_t bytes = 0;
+      for (entry* e = head_; e != nullptr && count < max_iovs;
+           e = e->next_entry_) {
+        std::size_t n = e->gather_(e, iov_ + count, max_iovs - count);
+        for (std::size_t i = count; i < count + n; ++i) {
+          bytes += iov_[i].iov_len;
+        }
+        count += n;
+      }
+
+      if (bucket_.limited() && bytes != 0) {
+        bucket_.refill(context_.loop_now());
+        std::uint64_t tokens = bucket_.tokens();
+        if (tokens == 0) {
+          wait_tokens(bytes);
+          break;
+        }
+        if (tokens < bytes) {
+          count = clip(count, tokens);
+          bytes = tokens;
+        }
+      }
+
+      std::size_t sent = 0;
+      if (bytes != 0) {
+        auto res = socket_.non_blocking_sendmsg(iov_, count, 0);
+        if (res.has_error()) {
+          compact_code ec{res.error()};
+          if (ec == errc::resource_unavailable_try_again ||
+              ec == errc::operation_would_block) {
+            wait_writable();
+          } else {
+            fail_all(ec);
+          }
+          break;
+        }
+        sent = res.value();
+        if (sent == 0) {
+          fail_all(errc::broken_pipe);
+          break;
+        }
+        queued_bytes_ -= sent;
+        bucket_.consume(sent);
+      }
+
+      // Complete the writes covered by the sent bytes in order. Completions
+      // may queue more writes, which are appended behind.
+      while (head_ != nullptr) {
+        entry* e = head_;
+        std::size_t before = sent;
+        bool done = e->consume_(e, sent);
+        e->remaining_ -= before - sent;
+        if (!done) {
+          break;
+        }
+        pop();
+        e->complete_(e, errc::success);
+      }
+    }
+    flushing_ = false;
+    release_waiters();
+  }
+
+  // Park on the write slot until the socket is writable. If another
+  // operation holds the slot, retry in the next iteration of the run loop.
+  void wait_writable() noexcept {
+    system_error2::system_code ec{errc::success};
+    descriptor_state* state = context_.register_descriptor(
+        socket_.native_handle(), socket_.descriptor_data(), ec);
+    if (state == nullptr) {
+      fail_all(ec);
+      return;
+    }
+    if (state->park(descriptor_state::write_slot, &writable_op_)) {
+      parked_ = true;
+    } else {
+      schedule_flush();
+    }
+  }
+
+  // Sleep until the bucket holds `bytes` tokens, or a burst if that's less.
+  void wait_tokens(std::size_t bytes) noexcept {
+    auto delay = bucket_.time_until(bytes);
+    paced_ = true;
+    pace_timer_.due_time_ = context_.loop_now() + delay;
+    pace_timer_.coarse_ = delay >= coarse_timer_tick;
+    context_.schedule_at_impl(&pace_timer_);
+  }
+
+  // Cut the gathered iovecs down to `size` bytes, returns their new count.
+  std::size_t clip(std::size_t count, std::size_t size) noexcept {
+    std::size_t i = 0;
+    while (i + 1 < count && size > iov_[i].iov_len) {
+      size -= iov_[i].iov_len;
+      ++i;
+    }
+    iov_[i].iov_len = size;
+    return i + 1;
+  }
+
+  void fail_all(compact_code ec) noexcept {
+    while (head_ != nullptr) {
+      entry* e = pop();
+      queued_bytes_ -= e->remaining_;
+      e->complete_(e, ec);
+    }
+  }
+
+  entry* pop() noexcept {
+    entry* e = head_;
+    head_ = e->next_entry_;
+    if (head_ == nullptr) {
+      tail_ = nullptr;
+    }
+    e->next_entry_ = nullptr;
+    return e;
+  }
+
+  static constexpr std::size_t max_iovs =
+      buffer_sequence_adapter_base::max_buffers;
+
+  socket_t& socket_;
+  epoll_context& context_;
+  entry* head_;
+  entry* tail_;
+  waiter* waiters_;
+  std::size_t queued_bytes_;
+  flush_task flush_task_;
+  writable_op writable_op_;
+  token_bucket bucket_;
+  pace_timer pace_timer_;
+  bool scheduled_;
+  bool parked_;
+  // Whether `pace_timer_` is armed or has fired but not run yet.
+  bool paced_;
+  bool flushing_;
+  iovec iov_[max_iovs];
+};
+
+// A write queued on a `write_queue`.
+template <typename ReceiverId, typename Protocol, typename Buffers>
+class epoll_context::socket_send_queued_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  using queue_t = epoll_context::write_queue<Protocol>;
+  using bufs_t = buffer_sequence_adapter<const_buffer, Buffers>;
+
+ public:
+  struct __t : public stdexec::__immovable, private queue_t::entry {
+    using __id = socket_send_queued_op;
+
+    // Constructor.
+    __t(receiver_t receiver, queue_t& queue, Buffers buffers) noexcept
+        : receiver_(static_cast<receiver_t&&>(receiver)),
+          queue_(queue),
+          buffers_(buffers),
+          bufs_(buffers_),
+          bytes_transferred_(0) {
+      this->gather_ = &gather;
+      this->consume_ = &consume;
+      this->complete_ = &complete;
+      this->remaining_ = net::buffer_size(buffers_);
+    }
+
+    friend void tag_invoke(stdexec::start_t, __t& self) noexcept {
+      self.queue_.submit(&self);
+    }
+
+   private:
+    static std::size_t gather(typename queue_t::entry* e, iovec* iov,
+                              std::size_t room) noexcept {
+      auto& self = *static_cast<__t*>(e);
+      std::size_t n = self.bufs_.count() < room ? self.bufs_.count() : room;
+      for (std::size_t i = 0; i < n; ++i) {
+        iov[i] = self.bufs_.buffers()[i];
+      }
+      return n;
+    }
+
+    static bool consume(typename queue_t::entry* e,
+                        std::size_t& size) noexcept {
+      auto& self = *static_cast<__t*>(e);
+      std::size_t n =
+          size < self.bufs_.total_size() ? size : self.bufs_.total_size();
+      self.bufs_.consume(n);
+      self.bytes_transferred_ += n;
+      size -= n;
+      // Sequences longer than a single call takes are walked window by
+      // window.
+      while (self.bufs_.all_empty()) {
+        if (!self.bufs_.refill()) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    static void complete(typename queue_t::entry* e,
+                         compact_code ec) noexcept {
+      auto& self = *static_cast<__t*>(e);
+      if (ec == errc::success) {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                           self.bytes_transferred_);
+      } else if (ec.domain() ==
+                 system_error2::quick_status_code_from_enum_domain<
+                     net::network_errc>) {
+        stdexec::set_error(
+            static_cast<receiver_t&&>(self.receiver_),
+            make_error_code(static_cast<net::network_errc>(ec.value())));
+      } else {
+        stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                           make_error_code(static_cast<std::errc>(ec.value())));
+      }
+    }
+
+    receiver_t receiver_;
+    queue_t& queue_;
+    Buffers buffers_;
+    bufs_t bufs_;
+    std::size_t bytes_transferred_;
+  };
+};
+
+template <typename Protocol, typename Buffers>
+class send_queued_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<epoll_context::socket_send_queued_op<
+      stdexec::__id<Receiver>, Protocol, Buffers>>;
+  using queue_t = epoll_context::write_queue<Protocol>;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = send_queued_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(size_t),
+                                       stdexec::set_error_t(std::error_code&&)>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.queue_, self.buffers_};
+    }
+
+    constexpr __t(queue_t& queue, Buffers buffers) noexcept
+        : queue_(queue), buffers_(buffers) {}
+
+   private:
+    queue_t& queue_;
+    Buffers buffers_;
+  };
+};
+
+// A wait for the queued bytes of a `write_queue` to fall below a mark.
+template <typename ReceiverId, typename Protocol>
+class epoll_context::write_queue_wait_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  using queue_t = epoll_context::write_queue<Protocol>;
+
+ public:
+  struct __t : public stdexec::__immovable, private queue_t::waiter {
+    using __id = write_queue_wait_op;
+
+    // Constructor.
+    __t(receiver_t receiver, queue_t& queue, std::size_t limit) noexcept
+        : receiver_(static_cast<receiver_t&&>(receiver)), queue_(queue) {
+      this->complete_ = &complete;
+      this->limit_ = limit;
+    }
+
+    friend void tag_invoke(stdexec::start_t, __t& self) noexcept {
+      self.queue_.wait_below(&self);
+    }
+
+   private:
+    static void complete(typename queue_t::waiter* w) noexcept {
+      auto& self = *static_cast<__t*>(w);
+      stdexec::set_value(static_cast<receiver_t&&>(self.receiver_));
+    }
+
+    receiver_t receiver_;
+    queue_t& queue_;
+  };
+};
+
+template <typename Protocol>
+class wait_writable_below_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<
+      epoll_context::write_queue_wait_op<stdexec::__id<Receiver>, Protocol>>;
+  using queue_t = epoll_context::write_queue<Protocol>;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = wait_writable_below_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.queue_, self.limit_};
+    }
+
+    constexpr __t(queue_t& queue, std::size_t limit) noexcept
+        : queue_(queue), limit_(limit) {}
+
+   private:
+    queue_t& queue_;
+    std::size_t limit_;
+  };
+};
+
+// Queue all bytes of `buffers` on `queue`. Completes with the total size of
+// `buffers` once they are sent, after the writes queued before.
+struct async_send_queued_t {
+  template <transport_protocol Protocol, const_buffer_sequence Buffers>
+  constexpr auto operator()(epoll_context::write_queue<Protocol>& queue,
+                            Buffers buffers) const noexcept
+      -> stdexec::__t<send_queued_sender<Protocol, Buffers>> {
+    return {queue, buffers};
+  }
+};
+
+// Wait until fewer than `bytes` are queued on `queue`, completes on its
+// context. Completes at once if the queue already is below the mark, and
+// when a failed or canceled flush empties the queue.
+struct async_wait_writable_below_t {
+  template <transport_protocol Protocol>
+  constexpr auto operator()(epoll_context::write_queue<Protocol>& queue,
+                            std::size_t bytes) const noexcept
+      -> stdexec::__t<wait_writable_below_sender<Protocol>> {
+    return {queue, bytes};
+  }
+};
+}  // namespace __epoll
+
+template <typename Protocol>
+using write_queue = __epoll::epoll_context::write_queue<Protocol>;
+
+inline constexpr __epoll::async_send_queued_t async_send_queued{};
+inline constexpr __epoll::async_wait_writable_below_t
+    async_wait_writable_below{};
+}  // namespace net
+
+#endif  // EPOLL_WRITE_QUEUE_HPP_
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef ERROR_CHANNEL_HPP_
+#define ERROR_CHANNEL_HPP_
+
+#include <concepts>      // NOLINT
+#include <system_error>  // NOLINT
+
+#include "compact_code.hpp"
+#include "net_error.hpp"
+#include "status-code/generic_code.hpp"
+#include "status-code/system_code.hpp"
+
+namespace net {
+
+// The types a socket operation can complete with on its error channel.
+// `std::error_code` is what most stdexec code expects. `system_code` is what
+// the operations produce, so no category has to be looked up when an error
+// is delivered, and errors like ECONNRESET can be told apart with a single
+// comparison against `errc`.
+template <typename Error>
+concept error_channel =
+    std::same_as<Error, std::error_code> ||
+    std::same_as<Error, system_error2::system_code>;
+
+// Convert the result of an operation into the error type of its channel.
+template <error_channel Error>
+Error to_error(compact_code ec) noexcept {
+  const bool network =
+      ec.domain() ==
+      system_error2::quick_status_code_from_enum_domain<network_errc>;
+  if constexpr (std::same_as<Error, std::error_code>) {
+    if (network) {
+      return make_error_code(static_cast<network_errc>(ec.value()));
+    }
+    return make_error_code(static_cast<std::errc>(ec.value()));
+  } else {
+    if (network) {
+      return system_error2::system_code{
+          ::status_code(static_cast<network_errc>(ec.value()))};
+    }
+    return system_error2::system_code{system_error2::generic_code(
+        static_cast<system_error2::errc>(ec.value()))};
+  }
+}
+
+template <error_channel Error>
+Error to_error(system_error2::system_code&& ec) noexcept {
+  if constexpr (std::same_as<Error, std::error_code>) {
+    return {static_cast<int>(ec.value()), std::system_category()};
+  } else {
+    return static_cast<system_error2::system_code&&>(ec);
+  }
+}
+
+}  // namespace net
+
+#endif  // ERROR_CHANNEL_HPP_
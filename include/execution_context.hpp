@@ -22,8 +22,10 @@ namespace net {
 // The context of epoll/io_uring etc can inherit from this class, and then the
 // `basic_socket` can be constructed normally. Note that we chose `inheritance`
 // over `template` to avoid providing an extra template parameter when
-// constructing the `basic_socket`. Therefore, this class is used only as a
-// convenience in constructing sockets and has no other unique features.
+// constructing the `basic_socket`. Therefore, this class is mostly a
+// convenience in constructing sockets. The only feature it offers is a hook
+// which lets the context release the per-descriptor state it associated with a
+// socket.
 class execution_context {
  public:
   // Default constructor.
@@ -43,7 +45,17 @@ class execution_context {
       default;
 
   // Destructor.
-  constexpr ~execution_context() noexcept = default;
+  constexpr virtual ~execution_context() noexcept = default;
+
+  // Called by a socket right before its descriptor is closed or released. The
+  // `descriptor_data` is the opaque per-descriptor state which the context
+  // attached to the socket, the context should release it and reset it to
+  // nullptr.
+  virtual void deregister_descriptor(int descriptor,
+                                     void*& descriptor_data) noexcept {
+    (void)descriptor;
+    descriptor_data = nullptr;
+  }
 };
 
 }  // namespace net
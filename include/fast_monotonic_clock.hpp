@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef FAST_MONOTONIC_CLOCK_HPP_
+#define FAST_MONOTONIC_CLOCK_HPP_
+
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdint>
+
+#include "monotonic_clock.hpp"
+
+namespace net {
+
+// A cheaper alternative to `monotonic_clock` for code which samples the clock
+// many times per operation, e.g. latency histograms and tracing. The time is
+// derived from the time stamp counter, calibrated against CLOCK_MONOTONIC once
+// per process and re-anchored to it every `reanchor_interval` per thread, so
+// its time points can be mixed with those of `monotonic_clock`. Falls back to
+// CLOCK_MONOTONIC on cpus without an invariant time stamp counter.
+class fast_monotonic_clock {
+ public:
+  using rep = monotonic_clock::rep;
+  using ratio = monotonic_clock::ratio;
+  using duration = monotonic_clock::duration;
+  using time_point = monotonic_clock::time_point;
+
+  // Steady clock flag, always true. Time points never decrease on one thread.
+  static constexpr bool is_steady = true;
+
+  // How long the time stamp counter is extrapolated before it's re-anchored
+  // to CLOCK_MONOTONIC.
+  static constexpr auto reanchor_interval = std::chrono::milliseconds(100);
+
+  // Get the current time.
+  static time_point now() noexcept;
+
+  // Whether the time is derived from the time stamp counter.
+  static bool is_tsc_based() noexcept {
+    return calibration().ticks_per_us != 0;
+  }
+
+  // The raw time stamp counter, or CLOCK_MONOTONIC in nanoseconds if the
+  // counter isn't used. Cheaper than `now` for stamps which are converted
+  // later, if ever, with `ticks_to_nanoseconds`. The counter is calibrated by
+  // the first call of `is_tsc_based` or `now`, make one before recording
+  // ticks.
+  static std::uint64_t ticks() noexcept {
+    return calibration().ticks_per_us != 0
+               ? read_tsc()
+               : static_cast<std::uint64_t>(clock_nanoseconds());
+  }
+
+  // Convert a difference of `ticks` to nanoseconds.
+  static std::chrono::nanoseconds ticks_to_nanoseconds(
+      std::uint64_t ticks) noexcept {
+    const calibration_data& cal = calibration();
+    if (cal.ticks_per_us == 0) {
+      return std::chrono::nanoseconds(static_cast<std::int64_t>(ticks));
+    }
+    return std::chrono::nanoseconds(static_cast<std::int64_t>(
+        static_cast<unsigned __int128>(ticks) * cal.mult >>
+        calibration_data::shift));
+  }
+
+ private:
+  // Converts ticks to nanoseconds as `ticks * mult >> shift`.
+  struct calibration_data {
+    std::uint64_t ticks_per_us = 0;
+    std::uint64_t mult = 0;
+    static constexpr unsigned shift = 24;
+  };
+
+  // The pair of readings time is extrapolated from.
+  struct anchor {
+    std::uint64_t ticks = 0;
+    std::int64_t nanoseconds = 0;
+    std::int64_t last = 0;
+  };
+
+  static std::int64_t clock_nanoseconds() noexcept {
+    timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1'000'000'000 + ts.tv_nsec;
+  }
+
+  static std::uint64_t read_tsc() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+  }
+
+  static bool has_invariant_tsc() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) == 0) {
+      return false;
+    }
+    return (edx & (1u << 8)) != 0;
+#else
+    return false;
+#endif
+  }
+
+  // Measure the frequency of the time stamp counter over a few milliseconds.
+  // Done once per process.
+  static const calibration_data& calibration() noexcept {
+    static const calibration_data data = [] {
+      calibration_data result;
+      if (!has_invariant_tsc()) {
+        return result;
+      }
+      constexpr std::int64_t window = 10'000'000;  // 10ms
+      const std::int64_t ns0 = clock_nanoseconds();
+      const std::uint64_t tsc0 = read_tsc();
+      std::int64_t ns1 = ns0;
+      std::uint64_t tsc1 = tsc0;
+      while (ns1 - ns0 < window) {
+        ns1 = clock_nanoseconds();
+        tsc1 = read_tsc();
+      }
+      const std::uint64_t ticks = tsc1 - tsc0;
+      const auto elapsed = static_cast<std::uint64_t>(ns1 - ns0);
+      if (ticks < elapsed / 1000) {
+        // Slower than 1MHz, not worth it.
+        return result;
+      }
+      result.ticks_per_us = std::max<std::uint64_t>(ticks * 1000 / elapsed, 1);
+      result.mult = (elapsed << calibration_data::shift) / ticks;
+      return result;
+    }();
+    return data;
+  }
+};
+
+inline fast_monotonic_clock::time_point fast_monotonic_clock::now() noexcept {
+  const calibration_data& cal = calibration();
+  if (cal.ticks_per_us == 0) {
+    return monotonic_clock::now();
+  }
+
+  static thread_local anchor base;
+  const std::uint64_t reanchor_ticks =
+      cal.ticks_per_us *
+      std::chrono::duration_cast<std::chrono::microseconds>(reanchor_interval)
+          .count();
+  const std::uint64_t tsc = read_tsc();
+  std::int64_t ns = 0;
+  if (base.ticks == 0 || tsc - base.ticks >= reanchor_ticks) {
+    base.nanoseconds = clock_nanoseconds();
+    base.ticks = read_tsc();
+    ns = base.nanoseconds;
+  } else {
+    ns = base.nanoseconds +
+         static_cast<std::int64_t>(((tsc - base.ticks) * cal.mult) >>
+                                   calibration_data::shift);
+  }
+
+  // Re-anchoring may step back by the drift accumulated since the last anchor.
+  ns = std::max(ns, base.last);
+  base.last = ns;
+  return time_point::from_seconds_and_nanoseconds(ns / 1'000'000'000,
+                                                  ns % 1'000'000'000);
+}
+
+}  // namespace net
+
+#endif  // FAST_MONOTONIC_CLOCK_HPP_
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef FILE_IO_POOL_HPP_
+#define FILE_IO_POOL_HPP_
+
+#include <cstddef>
+
+#include "resolver_pool.hpp"
+
+namespace net {
+
+// The workers which run blocking file reads and writes on behalf of I/O
+// threads, so a slow disk stalls a worker instead of a whole context. It's a
+// pool of its own, a burst of disk I/O doesn't queue behind slow name lookups
+// and the other way round. The count of workers bounds the blocking calls in
+// flight, further jobs wait in the queue.
+class file_io_pool : public resolver_pool {
+ public:
+  // The count of workers of the shared pool.
+  static constexpr std::size_t default_thread_count = 4;
+
+  // Start `thread_count` workers.
+  explicit file_io_pool(std::size_t thread_count = default_thread_count)
+      : resolver_pool(thread_count) {}
+
+  // The pool used when none is given, started on first use.
+  static file_io_pool& shared() {
+    static file_io_pool pool;
+    return pool;
+  }
+};
+
+}  // namespace net
+
+#endif  // FILE_IO_POOL_HPP_
@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef FLIGHT_RECORDER_HPP_
+#define FLIGHT_RECORDER_HPP_
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "fast_monotonic_clock.hpp"
+#include "monotonic_clock.hpp"
+
+namespace net {
+
+// The events kept by a `flight_recorder`. The argument of the op events is the
+// descriptor, the one of the others is given with each event.
+enum class flight_event : std::uint8_t {
+  // An operation is started on the io thread.
+  op_start,
+  // It would block and waits on its descriptor.
+  op_park,
+  // The descriptor is reported ready.
+  op_wakeup,
+  // It completes, the kind carries no errno, see the USDT probes for those.
+  op_complete,
+  // It is stopped on the io thread.
+  op_cancel,
+  // A timer elapsed, the argument is zero.
+  timer_fire,
+  // Operations queued by other threads are collected, the argument is their
+  // count.
+  remote_drain,
+  // The loop starts waiting for events, the argument is the timeout in
+  // milliseconds, -1 if none.
+  wait_begin,
+  // The wait returns, the argument is the count of events.
+  wait_end
+};
+
+// A fixed-size ring of the latest events of a run loop, to find out what the
+// loop was doing right before a latency spike. Recording an event is a read of
+// the time stamp counter and four plain stores. Only one thread records, any
+// thread can take a snapshot at any time, e.g. after the loop is stuck, and
+// `dump` may be called from a signal handler.
+//
+// Recorders register themselves, `dump_all` writes all of them and
+// `install_signal_handler` makes a signal do that.
+class flight_recorder {
+ public:
+  // A recorded event.
+  struct entry {
+    flight_event event;
+    // The kind of operation, the `op_kind` of epoll_context.
+    std::uint8_t kind;
+    std::int32_t arg;
+    monotonic_clock::time_point time;
+  };
+
+  // The most recorders `dump_all` knows about.
+  static constexpr std::size_t max_registered = 64;
+
+  // Constructor. `capacity` is rounded up to a power of two.
+  explicit flight_recorder(std::size_t capacity)
+      : mask_(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1),
+        slots_(std::make_unique<slot[]>(mask_ + 1)),
+        head_(0),
+        committed_(0) {
+    // Calibrate the clock before the first event.
+    (void)fast_monotonic_clock::is_tsc_based();
+    for (auto& registered : registry()) {
+      const flight_recorder* expected = nullptr;
+      if (registered.compare_exchange_strong(expected, this,
+                                             std::memory_order_release)) {
+        break;
+      }
+    }
+  }
+
+  flight_recorder(const flight_recorder&) = delete;
+  flight_recorder& operator=(const flight_recorder&) = delete;
+
+  // Destructor.
+  ~flight_recorder() {
+    for (auto& registered : registry()) {
+      const flight_recorder* expected = this;
+      if (registered.compare_exchange_strong(expected, nullptr,
+                                             std::memory_order_acq_rel)) {
+        break;
+      }
+    }
+  }
+
+  // Record `event`. Must only be called by the recording thread.
+  void record(flight_event event, std::int32_t arg,
+              std::uint8_t kind = 0) noexcept {
+    const std::uint64_t index = head_.load(std::memory_order_relaxed);
+    // Claim the slot before overwriting it, so readers can tell which of
+    // the entries they copied may be torn.
+    head_.store(index + 1, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot& s = slots_[index & mask_];
+    s.ticks.store(fast_monotonic_clock::ticks(), std::memory_order_relaxed);
+    s.data.store(pack(event, kind, arg), std::memory_order_relaxed);
+    committed_.store(index + 1, std::memory_order_release);
+  }
+
+  // The count of entries kept.
+  constexpr std::size_t capacity() const noexcept { return mask_ + 1; }
+
+  // The count of events recorded so far.
+  std::uint64_t recorded() const noexcept {
+    return committed_.load(std::memory_order_acquire);
+  }
+
+  // The kept events, oldest first. Can be called from any thread.
+  std::vector<entry> snapshot() const {
+    std::vector<entry> result;
+    result.reserve(capacity());
+    const std::uint64_t now_ticks = fast_monotonic_clock::ticks();
+    const monotonic_clock::time_point now = monotonic_clock::now();
+    for_each_entry([&](std::uint64_t ticks, std::uint64_t data) noexcept {
+      result.push_back(
+          {.event = static_cast<flight_event>(data >> 56),
+           .kind = static_cast<std::uint8_t>(data >> 48),
+           .arg = static_cast<std::int32_t>(static_cast<std::uint32_t>(data)),
+           .time = now - fast_monotonic_clock::ticks_to_nanoseconds(
+                             now_ticks - std::min(ticks, now_ticks))});
+    });
+    return result;
+  }
+
+  // Write the kept events to `fd` as text, one per line, oldest first:
+  //
+  //   <event> kind=<kind> arg=<arg> age=<nanoseconds>ns
+  //
+  // Async-signal-safe, it neither allocates nor locks.
+  void dump(int fd) const noexcept {
+    const std::uint64_t now_ticks = fast_monotonic_clock::ticks();
+    line_writer out{fd};
+    out.append("flight recorder ");
+    out.append_number(reinterpret_cast<std::uintptr_t>(this));
+    out.append(" events=");
+    out.append_number(recorded());
+    out.flush();
+    for_each_entry([&](std::uint64_t ticks, std::uint64_t data) noexcept {
+      out.append(name(static_cast<flight_event>(data >> 56)));
+      out.append(" kind=");
+      out.append_number((data >> 48) & 0xff);
+      out.append(" arg=");
+      out.append_signed(
+          static_cast<std::int32_t>(static_cast<std::uint32_t>(data)));
+      out.append(" age=");
+      out.append_number(static_cast<std::uint64_t>(
+          fast_monotonic_clock::ticks_to_nanoseconds(
+              now_ticks - std::min(ticks, now_ticks))
+              .count()));
+      out.append("ns");
+      out.flush();
+    });
+  }
+
+  // Dump every registered recorder to `fd`. Async-signal-safe.
+  static void dump_all(int fd) noexcept {
+    for (auto& registered : registry()) {
+      if (const flight_recorder* r =
+              registered.load(std::memory_order_acquire)) {
+        r->dump(fd);
+      }
+    }
+  }
+
+  // Dump every registered recorder to stderr when `signo` is delivered, e.g.
+  // SIGUSR2. Returns false if the handler can't be installed.
+  static bool install_signal_handler(int signo) noexcept {
+    struct sigaction action = {};
+    action.sa_handler = [](int) {
+      // The dump may clobber errno of the interrupted code.
+      int saved_errno = errno;
+      dump_all(STDERR_FILENO);
+      errno = saved_errno;
+    };
+    ::sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    return ::sigaction(signo, &action, nullptr) == 0;
+  }
+
+  // The name of `event`.
+  static constexpr const char* name(flight_event event) noexcept {
+    switch (event) {
+      case flight_event::op_start:
+        return "op_start";
+      case flight_event::op_park:
+        return "op_park";
+      case flight_event::op_wakeup:
+        return "op_wakeup";
+      case flight_event::op_complete:
+        return "op_complete";
+      case flight_event::op_cancel:
+        return "op_cancel";
+      case flight_event::timer_fire:
+        return "timer_fire";
+      case flight_event::remote_drain:
+        return "remote_drain";
+      case flight_event::wait_begin:
+        return "wait_begin";
+      case flight_event::wait_end:
+        return "wait_end";
+    }
+    return "unknown";
+  }
+
+ private:
+  // One event, written with relaxed stores so that readers racing with the
+  // recording thread copy torn entries instead of invoking undefined
+  // behavior, and drop them afterwards.
+  struct slot {
+    std::atomic<std::uint64_t> ticks{0};
+    std::atomic<std::uint64_t> data{0};
+  };
+
+  // A line assembled on the stack and written with a single write call.
+  class line_writer {
+   public:
+    explicit line_writer(int fd) noexcept : fd_(fd), size_(0) {}
+
+    void append(const char* text) noexcept {
+      while (*text != '\0' && size_ < sizeof(buffer_) - 1) {
+        buffer_[size_++] = *text++;
+      }
+    }
+
+    void append_number(std::uint64_t value) noexcept {
+      char digits[20];
+      int count = 0;
+      do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+      } while (value != 0);
+      while (count > 0 && size_ < sizeof(buffer_) - 1) {
+        buffer_[size_++] = digits[--count];
+      }
+    }
+
+    void append_signed(std::int64_t value) noexcept {
+      if (value < 0) {
+        append("-");
+        append_number(static_cast<std::uint64_t>(-(value + 1)) + 1);
+      } else {
+        append_number(static_cast<std::uint64_t>(value));
+      }
+    }
+
+    // Write the line and start the next one.
+    void flush() noexcept {
+      buffer_[size_++] = '\n';
+      (void)::write(fd_, buffer_, size_);
+      size_ = 0;
+    }
+
+   private:
+    int fd_;
+    std::size_t size_;
+    char buffer_[128];
+  };
+
+  static constexpr std::uint64_t pack(flight_event event, std::uint8_t kind,
+                                      std::int32_t arg) noexcept {
+    return (static_cast<std::uint64_t>(event) << 56) |
+           (static_cast<std::uint64_t>(kind) << 48) |
+           static_cast<std::uint32_t>(arg);
+  }
+
+  // Call `f(ticks, data)` for each kept entry which was not overwritten
+  // while being copied, oldest first.
+  template <typename F>
+  void for_each_entry(F&& f) const noexcept {
+    const std::uint64_t committed = committed_.load(std::memory_order_acquire);
+    const std::uint64_t size = std::min<std::uint64_t>(committed, capacity());
+    std::uint64_t begin = committed - size;
+    // Copy first, so the check below covers the whole copy.
+    struct copied {
+      std::uint64_t ticks;
+      std::uint64_t data;
+    };
+    constexpr std::uint64_t chunk = 64;
+    while (begin < committed) {
+      copied entries[chunk];
+      const std::uint64_t end = std::min(begin + chunk, committed);
+      for (std::uint64_t i = begin; i < end; ++i) {
+        const slot& s = slots_[i & mask_];
+        entries[i - begin] = {s.ticks.load(std::memory_order_relaxed),
+                              s.data.load(std::memory_order_relaxed)};
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      // The slots of the entries before `head - capacity` may have been
+      // claimed by the recording thread in the meantime.
+      const std::uint64_t head = head_.load(std::memory_order_relaxed);
+      const std::uint64_t valid = head > capacity() ? head - capacity() : 0;
+      for (std::uint64_t i = std::max(begin, valid); i < end; ++i) {
+        f(entries[i - begin].ticks, entries[i - begin].data);
+      }
+      begin = end;
+    }
+  }
+
+  using registry_type =
+      std::array<std::atomic<const flight_recorder*>, max_registered>;
+
+  static registry_type& registry() noexcept {
+    static registry_type recorders = {};
+    return recorders;
+  }
+
+  const std::size_t mask_;
+  const std::unique_ptr<slot[]> slots_;
+
+  // The count of claimed slots.
+  std::atomic<std::uint64_t> head_;
+
+  // The count of completely written slots.
+  std::atomic<std::uint64_t> committed_;
+};
+
+}  // namespace net
+
+#endif  // FLIGHT_RECORDER_HPP_
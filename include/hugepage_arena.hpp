@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HUGEPAGE_ARENA_HPP_
+#define HUGEPAGE_ARENA_HPP_
+
+#include <sys/mman.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <system_error>  // NOLINT
+
+namespace net {
+
+// A fixed region of anonymous memory backed by 2MB pages, from which pools
+// carve their blocks once. Explicit hugepages (MAP_HUGETLB) are tried first;
+// if none are reserved, the region is aligned to 2MB and the kernel is asked
+// to back it with transparent hugepages (MADV_HUGEPAGE). Memory is only given
+// back when the arena is destroyed. Not thread safe.
+class hugepage_arena {
+ public:
+  static constexpr std::size_t huge_page_size = 2 * 1024 * 1024;
+
+  // How the arena is mapped.
+  struct options {
+    // Try MAP_HUGETLB before falling back to transparent hugepages.
+    bool explicit_hugepages = true;
+
+    // Fault in the whole arena while mapping it, so the first use of a block
+    // doesn't stall on page faults.
+    bool prefault = true;
+  };
+
+  // Constructor. `size` is rounded up to a multiple of `huge_page_size`.
+  // Throws std::system_error if no memory can be mapped.
+  explicit hugepage_arena(std::size_t size) : hugepage_arena(size, options{}) {}
+
+  hugepage_arena(std::size_t size, options opts)
+      : base_(nullptr),
+        size_(round_up(size == 0 ? 1 : size, huge_page_size)),
+        used_(0),
+        hugetlb_(false) {
+    map(opts);
+  }
+
+  hugepage_arena(const hugepage_arena&) = delete;
+  hugepage_arena& operator=(const hugepage_arena&) = delete;
+
+  // Destructor unmaps the whole arena.
+  ~hugepage_arena() { ::munmap(base_, size_); }
+
+  // Carve `size` bytes aligned to `align`. Returns nullptr once the arena is
+  // exhausted.
+  void* allocate(std::size_t size,
+                 std::size_t align = alignof(std::max_align_t)) noexcept {
+    const std::size_t offset = round_up(used_, align);
+    if (offset > size_ || size > size_ - offset) {
+      return nullptr;
+    }
+    used_ = offset + size;
+    return base_ + offset;
+  }
+
+  // Whether `p` points into the arena.
+  bool contains(const void* p) const noexcept {
+    auto addr = reinterpret_cast<std::uintptr_t>(p);
+    auto base = reinterpret_cast<std::uintptr_t>(base_);
+    return addr >= base && addr < base + size_;
+  }
+
+  // The size of the arena.
+  std::size_t size() const noexcept { return size_; }
+
+  // The count of bytes carved so far.
+  std::size_t used() const noexcept { return used_; }
+
+  // Whether the arena is backed by explicit hugepages. Otherwise the kernel
+  // backs it with transparent hugepages if they are enabled.
+  bool uses_hugetlb() const noexcept { return hugetlb_; }
+
+ private:
+  static constexpr std::size_t round_up(std::size_t n,
+                                        std::size_t align) noexcept {
+    return (n + align - 1) / align * align;
+  }
+
+  void map(options opts) {
+    const int populate = opts.prefault ? MAP_POPULATE : 0;
+    if (opts.explicit_hugepages) {
+      void* addr =
+          ::mmap(nullptr, size_, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | populate, -1, 0);
+      if (addr != MAP_FAILED) {
+        base_ = static_cast<std::byte*>(addr);
+        hugetlb_ = true;
+        return;
+      }
+    }
+
+    // Over-allocate by one hugepage and trim both ends, so the region starts
+    // on a 2MB boundary where the kernel can use whole hugepages.
+    void* addr = ::mmap(nullptr, size_ + huge_page_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+      throw std::system_error{static_cast<int>(errno), std::system_category(),
+                              "mmap"};
+    }
+    auto* raw = static_cast<std::byte*>(addr);
+    auto* aligned = reinterpret_cast<std::byte*>(
+        round_up(reinterpret_cast<std::uintptr_t>(raw), huge_page_size));
+    const std::size_t head = static_cast<std::size_t>(aligned - raw);
+    if (head != 0) {
+      ::munmap(raw, head);
+    }
+    if (head != huge_page_size) {
+      ::munmap(aligned + size_, huge_page_size - head);
+    }
+    base_ = aligned;
+
+    // Only hints, failing to apply them doesn't matter.
+    (void)::madvise(base_, size_, MADV_HUGEPAGE);
+    if (opts.prefault) {
+      prefault();
+    }
+  }
+
+  // Touch every page, so they are faulted in now instead of during traffic.
+  void prefault() noexcept {
+#ifdef MADV_POPULATE_WRITE
+    if (::madvise(base_, size_, MADV_POPULATE_WRITE) == 0) {
+      return;
+    }
+#endif
+    constexpr std::size_t page_size = 4096;
+    for (std::size_t i = 0; i < size_; i += page_size) {
+      *static_cast<volatile std::byte*>(base_ + i) = std::byte{0};
+    }
+  }
+
+  std::byte* base_;
+  std::size_t size_;
+  std::size_t used_;
+  bool hugetlb_;
+};
+
+}  // namespace net
+
+#endif  // HUGEPAGE_ARENA_HPP_
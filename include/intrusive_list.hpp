@@ -36,6 +36,8 @@ class intrusive_list {
 
   [[nodiscard]] bool empty() const noexcept { return head_ == nullptr; }
 
+  [[nodiscard]] T* front() const noexcept { return head_; }
+
   void swap(intrusive_list& other) noexcept {
     std::swap(head_, other.head_);
     std::swap(tail_, other.tail_);
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INTRUSIVE_PAIRING_HEAP_HPP_
+#define INTRUSIVE_PAIRING_HEAP_HPP_
+
+namespace net {
+
+// An intrusive min pairing heap ordered by the 'SortKey' field of the items.
+// `insert`, `top` and `decrease` are O(1), `pop` is amortized O(log n).
+// `remove` unlinks the item in O(1) by handle and then merges its children.
+//
+// Each item keeps its first child in 'Child' and its next sibling in 'Next'.
+// 'Prev' points to the previous sibling, or to the parent if the item is the
+// first child. The root has no 'Prev' and no 'Next'.
+template <typename T, T* T::*Child, T* T::*Next, T* T::*Prev, typename Key,
+          Key T::*SortKey>
+class intrusive_pairing_heap {
+ public:
+  // Constructor.
+  constexpr intrusive_pairing_heap() noexcept : root_(nullptr) {}
+
+  // Destructor.
+  constexpr ~intrusive_pairing_heap() noexcept = default;
+
+  // Check whether this heap is empty.
+  constexpr bool empty() const noexcept { return root_ == nullptr; }
+
+  // Get head items of this heap.
+  constexpr T* top() const noexcept { return root_; }
+
+  // Pop head items of this heap.
+  constexpr T* pop() noexcept {
+    T* item = root_;
+    root_ = merge_pairs(item->*Child);
+    item->*Child = nullptr;
+    return item;
+  }
+
+  // Insert new items into this heap.
+  constexpr void insert(T* item) noexcept {
+    item->*Child = nullptr;
+    item->*Next = nullptr;
+    item->*Prev = nullptr;
+    root_ = root_ == nullptr ? item : meld(root_, item);
+  }
+
+  // Reposition an item whose key has been lowered in place. Its subtree
+  // still holds keys no smaller than the new one, so it's cut off and melded
+  // with the root as a whole.
+  constexpr void decrease(T* item) noexcept {
+    if (item == root_) {
+      return;
+    }
+    unlink(item);
+    item->*Next = nullptr;
+    item->*Prev = nullptr;
+    root_ = meld(root_, item);
+  }
+
+  // Remove an item from this heap.
+  constexpr void remove(T* item) noexcept {
+    if (item == root_) {
+      pop();
+      return;
+    }
+
+    unlink(item);
+    T* children = merge_pairs(item->*Child);
+    if (children != nullptr) {
+      root_ = meld(root_, children);
+    }
+    item->*Child = nullptr;
+    item->*Next = nullptr;
+    item->*Prev = nullptr;
+  }
+
+ private:
+  // Unlink a non-root item together with its subtree.
+  static constexpr void unlink(T* item) noexcept {
+    T* prev = item->*Prev;
+    T* next = item->*Next;
+    if (prev->*Child == item) {
+      prev->*Child = next;
+    } else {
+      prev->*Next = next;
+    }
+    if (next != nullptr) {
+      next->*Prev = prev;
+    }
+  }
+
+  // Meld two roots, the one with the bigger key becomes the first child of the
+  // other one.
+  static constexpr T* meld(T* lhs, T* rhs) noexcept {
+    if (rhs->*SortKey < lhs->*SortKey) {
+      T* tmp = lhs;
+      lhs = rhs;
+      rhs = tmp;
+    }
+    T* first_child = lhs->*Child;
+    rhs->*Next = first_child;
+    rhs->*Prev = lhs;
+    if (first_child != nullptr) {
+      first_child->*Prev = rhs;
+    }
+    lhs->*Child = rhs;
+    return lhs;
+  }
+
+  // Merge a list of siblings into one root with the standard two-pass scheme.
+  // Meld the siblings pairwise from left to right, then meld the results from
+  // right to left.
+  static constexpr T* merge_pairs(T* first) noexcept {
+    // The pairs are chained in reverse order through 'Next'.
+    T* pairs = nullptr;
+    while (first != nullptr) {
+      T* lhs = first;
+      T* rhs = lhs->*Next;
+      lhs->*Next = nullptr;
+      lhs->*Prev = nullptr;
+      if (rhs == nullptr) {
+        lhs->*Next = pairs;
+        pairs = lhs;
+        break;
+      }
+      first = rhs->*Next;
+      rhs->*Next = nullptr;
+      rhs->*Prev = nullptr;
+      T* merged = meld(lhs, rhs);
+      merged->*Next = pairs;
+      pairs = merged;
+    }
+
+    if (pairs == nullptr) {
+      return nullptr;
+    }
+    T* result = pairs;
+    pairs = pairs->*Next;
+    result->*Next = nullptr;
+    while (pairs != nullptr) {
+      T* next = pairs->*Next;
+      pairs->*Next = nullptr;
+      result = meld(result, pairs);
+      pairs = next;
+    }
+    return result;
+  }
+
+  T* root_;
+};
+
+}  // namespace net
+#endif  // INTRUSIVE_PAIRING_HEAP_HPP_
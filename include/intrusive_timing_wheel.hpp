@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INTRUSIVE_TIMING_WHEEL_HPP_
+#define INTRUSIVE_TIMING_WHEEL_HPP_
+
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+namespace net {
+
+// An intrusive hashed hierarchical timing wheel keyed by the 'SortKey' field of
+// the items. The time is divided into ticks, an item expires at the first tick
+// boundary not earlier than its key, so items never expire early but may
+// expire up to one tick late. `insert` and `remove` are O(1).
+//
+// Level `l` has `slot_count` slots each spanning `slot_count^l` ticks. Items
+// move to a lower level when the wheel reaches their slot. Items which are too
+// far away are parked in the top level and re-hashed every round.
+//
+// 'Next' and 'Prev' link the items of one slot, 'Slot' records which slot the
+// item lives in. 'Key' must be default constructible to the origin of time and
+// the difference of two keys must be a std::chrono::duration.
+template <typename T, T* T::*Next, T* T::*Prev, std::uint32_t T::*Slot,
+          typename Key, Key T::*SortKey>
+class intrusive_timing_wheel {
+ public:
+  using duration =
+      decltype(std::declval<const Key&>() - std::declval<const Key&>());
+
+  static constexpr std::uint32_t level_count = 4;
+  static constexpr std::uint32_t slot_bits = 6;
+  static constexpr std::uint32_t slot_count = 1U << slot_bits;
+  static constexpr std::uint32_t slot_mask = slot_count - 1;
+
+  // Constructor.
+  explicit constexpr intrusive_timing_wheel(duration tick) noexcept
+      : tick_(tick), current_tick_(0), size_(0), occupied_{}, slots_{} {
+    assert(tick.count() > 0);
+  }
+
+  // Destructor.
+  constexpr ~intrusive_timing_wheel() noexcept = default;
+
+  // Check whether this wheel is empty.
+  constexpr bool empty() const noexcept { return size_ == 0; }
+
+  // The count of items in this wheel.
+  constexpr std::size_t size() const noexcept { return size_; }
+
+  // The duration of one tick.
+  constexpr duration tick() const noexcept { return tick_; }
+
+  // Move the wheel to `now` without expiring anything. Must only be called
+  // when the wheel is empty, so that the items inserted later are hashed
+  // relative to the current time.
+  constexpr void reset(const Key& now) noexcept {
+    assert(empty());
+    current_tick_ = floor_tick(now);
+  }
+
+  // Insert new items into this wheel.
+  constexpr void insert(T* item) noexcept {
+    ++size_;
+    link(item, ceil_tick(item->*SortKey));
+  }
+
+  // Remove an item from this wheel.
+  constexpr void remove(T* item) noexcept {
+    assert(size_ > 0);
+    --size_;
+    unlink(item);
+  }
+
+  // Expire all items whose tick is not later than `now`, calling `f` with each
+  // of them after it has been removed from the wheel.
+  template <typename F>
+  constexpr void advance(const Key& now, F&& f) noexcept {
+    const std::int64_t target = floor_tick(now);
+    while (current_tick_ < target) {
+      std::optional<std::int64_t> next = next_event_tick();
+      if (!next || *next > target) {
+        current_tick_ = target;
+        break;
+      }
+      current_tick_ = *next;
+      for (std::uint32_t level = level_count - 1; level > 0; --level) {
+        if (is_level_boundary(level)) {
+          cascade(level, f);
+        }
+      }
+      expire(slot_index(0, current_tick_), f);
+    }
+  }
+
+  // The earliest time at which `advance` has some work to do, either expiring
+  // items or moving items to a lower level. Returns nothing if empty.
+  constexpr std::optional<Key> next_expiry() const noexcept {
+    std::optional<std::int64_t> next = next_event_tick();
+    if (!next) {
+      return std::nullopt;
+    }
+    return Key{} + tick_ * *next;
+  }
+
+ private:
+  constexpr std::int64_t floor_tick(const Key& key) const noexcept {
+    return (key - Key{}) / tick_;
+  }
+
+  constexpr std::int64_t ceil_tick(const Key& key) const noexcept {
+    const duration since_origin = key - Key{};
+    std::int64_t tick = since_origin / tick_;
+    return since_origin % tick_ == duration::zero() ? tick : tick + 1;
+  }
+
+  static constexpr std::uint32_t slot_index(std::uint32_t level,
+                                            std::int64_t tick) noexcept {
+    return static_cast<std::uint32_t>(tick >> (level * slot_bits)) & slot_mask;
+  }
+
+  constexpr bool is_level_boundary(std::uint32_t level) const noexcept {
+    const std::int64_t span = std::int64_t{1} << (level * slot_bits);
+    return (current_tick_ & (span - 1)) == 0;
+  }
+
+  // Hash the item into a slot relative to the current tick. Items that are
+  // already due are put into the next tick.
+  constexpr void link(T* item, std::int64_t expiry) noexcept {
+    if (expiry <= current_tick_) {
+      expiry = current_tick_ + 1;
+    }
+    const std::int64_t delta = expiry - current_tick_;
+    std::uint32_t level = 0;
+    while (level + 1 < level_count &&
+           delta >= (std::int64_t{1} << ((level + 1) * slot_bits))) {
+      ++level;
+    }
+    constexpr std::int64_t max_delta =
+        (std::int64_t{1} << (level_count * slot_bits)) - 1;
+    if (delta > max_delta) {
+      expiry = current_tick_ + max_delta;
+    }
+
+    const std::uint32_t slot = level * slot_count + slot_index(level, expiry);
+    T* head = slots_[slot];
+    item->*Slot = slot;
+    item->*Prev = nullptr;
+    item->*Next = head;
+    if (head != nullptr) {
+      head->*Prev = item;
+    }
+    slots_[slot] = item;
+    occupied_[level] |= std::uint64_t{1} << (slot & slot_mask);
+  }
+
+  constexpr void unlink(T* item) noexcept {
+    const std::uint32_t slot = item->*Slot;
+    T* prev = item->*Prev;
+    T* next = item->*Next;
+    if (prev != nullptr) {
+      prev->*Next = next;
+    } else {
+      slots_[slot] = next;
+      if (next == nullptr) {
+        occupied_[slot / slot_count] &=
+            ~(std::uint64_t{1} << (slot & slot_mask));
+      }
+    }
+    if (next != nullptr) {
+      next->*Prev = prev;
+    }
+    item->*Next = nullptr;
+    item->*Prev = nullptr;
+  }
+
+  // Take all items out of a slot.
+  constexpr T* take(std::uint32_t level, std::uint32_t index) noexcept {
+    occupied_[level] &= ~(std::uint64_t{1} << index);
+    return std::exchange(slots_[level * slot_count + index], nullptr);
+  }
+
+  // Re-hash the items of the current slot of `level` into the lower levels.
+  template <typename F>
+  constexpr void cascade(std::uint32_t level, F& f) noexcept {
+    T* item = take(level, slot_index(level, current_tick_));
+    while (item != nullptr) {
+      T* next = item->*Next;
+      const std::int64_t expiry = ceil_tick(item->*SortKey);
+      if (expiry <= current_tick_) {
+        --size_;
+        item->*Next = nullptr;
+        item->*Prev = nullptr;
+        f(item);
+      } else {
+        link(item, expiry);
+      }
+      item = next;
+    }
+  }
+
+  template <typename F>
+  constexpr void expire(std::uint32_t index, F& f) noexcept {
+    T* item = take(0, index);
+    while (item != nullptr) {
+      T* next = item->*Next;
+      --size_;
+      item->*Next = nullptr;
+      item->*Prev = nullptr;
+      f(item);
+      item = next;
+    }
+  }
+
+  // The first tick after the current one at which an occupied slot is reached.
+  constexpr std::optional<std::int64_t> next_event_tick() const noexcept {
+    std::optional<std::int64_t> result;
+    for (std::uint32_t level = 0; level < level_count; ++level) {
+      if (occupied_[level] == 0) {
+        continue;
+      }
+      const std::uint32_t shift = level * slot_bits;
+      const std::int64_t current = current_tick_ >> shift;
+      const std::uint32_t index = slot_index(level, current_tick_);
+
+      // Bit `k` of `rotated` is the slot `k + 1` steps after the current one.
+      const std::uint64_t rotated = std::rotr(
+          occupied_[level], static_cast<int>((index + 1) & slot_mask));
+      const std::int64_t steps = std::countr_zero(rotated) + 1;
+      const std::int64_t tick = (current + steps) << shift;
+      if (!result || tick < *result) {
+        result = tick;
+      }
+    }
+    return result;
+  }
+
+  duration tick_;
+  std::int64_t current_tick_;
+  std::size_t size_;
+  std::uint64_t occupied_[level_count];
+  T* slots_[level_count * slot_count];
+};
+
+}  // namespace net
+#endif  // INTRUSIVE_TIMING_WHEEL_HPP_
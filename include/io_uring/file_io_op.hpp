@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef IO_URING_FILE_IO_OP_HPP_
+#define IO_URING_FILE_IO_OP_HPP_
+
+#include <linux/io_uring.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <system_error>  // NOLINT
+#include <type_traits>
+
+#include "buffer.hpp"
+#include "buffer_sequence_adapter.hpp"
+#include "io_uring/io_uring_context.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __io_uring {
+
+// Read or write a file at an offset with a native request. Unlike the epoll
+// backend, no thread blocks on the disk, the ring runs the request.
+template <typename ReceiverId, typename Buffers, bool Write>
+class io_uring_context::file_io_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  using base_t = stdexec::__t<io_uring_context::io_base_op<ReceiverId>>;
+  using buffer_t = std::conditional_t<Write, const_buffer, mutable_buffer>;
+  using bufs_t = buffer_sequence_adapter<buffer_t, Buffers>;
+
+ public:
+  struct __t : public base_t {
+    using __id = file_io_op;
+
+    // Constructor.
+    constexpr __t(receiver_t receiver, io_uring_context& context, int file,
+                  std::uint64_t offset, Buffers buffers) noexcept
+        : base_t(static_cast<receiver_t&&>(receiver), context, op_vtable),
+          file_(file),
+          offset_(offset),
+          buffers_(buffers) {}
+
+   private:
+    static void prepare(base_t* base, io_uring_sqe& sqe) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      sqe.fd = self.file_;
+      sqe.off = self.offset_;
+      if constexpr (bufs_t::is_single_buffer) {
+        sqe.opcode = Write ? IORING_OP_WRITE : IORING_OP_READ;
+        sqe.addr =
+            reinterpret_cast<std::uintptr_t>(self.buffers_.buffers()->iov_base);
+        sqe.len = static_cast<std::uint32_t>(self.buffers_.buffers()->iov_len);
+      } else {
+        // The iovecs must stay alive until the request completes.
+        sqe.opcode = Write ? IORING_OP_WRITEV : IORING_OP_READV;
+        sqe.addr = reinterpret_cast<std::uintptr_t>(self.buffers_.buffers());
+        sqe.len = static_cast<std::uint32_t>(self.buffers_.count());
+      }
+    }
+
+    static void complete(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      int res = self.result();
+      if (res >= 0) {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                           static_cast<size_t>(res));
+      } else if (res == -ECANCELED) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      } else {
+        stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                           make_error_code(static_cast<std::errc>(-res)));
+      }
+    }
+
+    static constexpr typename base_t::op_vtable op_vtable{&prepare, &complete};
+    int file_;
+    std::uint64_t offset_;
+    bufs_t buffers_;
+  };
+};
+
+template <typename Buffers, bool Write>
+class file_io_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<
+      io_uring_context::file_io_op<stdexec::__id<Receiver>, Buffers, Write>>;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = file_io_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(size_t),
+                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.context_, self.file_,
+              self.offset_, self.buffers_};
+    }
+
+    constexpr __t(io_uring_context& context, int file, std::uint64_t offset,
+                  Buffers buffers) noexcept
+        : context_(context), file_(file), offset_(offset), buffers_(buffers) {}
+
+   private:
+    io_uring_context& context_;
+    int file_;
+    std::uint64_t offset_;
+    Buffers buffers_;
+  };
+};
+
+// Same as `net::async_read_file_at` of the epoll backend.
+struct async_read_file_at_t {
+  template <mutable_buffer_sequence Buffers>
+  constexpr auto operator()(io_uring_context& context, int file,
+                            std::uint64_t offset,
+                            Buffers buffers) const noexcept
+      -> stdexec::__t<file_io_sender<Buffers, false>> {
+    return {context, file, offset, buffers};
+  }
+};
+
+// Same as `net::async_write_file_at` of the epoll backend.
+struct async_write_file_at_t {
+  template <const_buffer_sequence Buffers>
+  constexpr auto operator()(io_uring_context& context, int file,
+                            std::uint64_t offset,
+                            Buffers buffers) const noexcept
+      -> stdexec::__t<file_io_sender<Buffers, true>> {
+    return {context, file, offset, buffers};
+  }
+};
+}  // namespace __io_uring
+
+namespace uring {
+inline constexpr __io_uring::async_read_file_at_t async_read_file_at{};
+inline constexpr __io_uring::async_write_file_at_t async_write_file_at{};
+}  // namespace uring
+}  // namespace net
+
+#endif  // IO_URING_FILE_IO_OP_HPP_
@@ -0,0 +1,940 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef IO_URING_IO_URING_CONTEXT_HPP_
+#define IO_URING_IO_URING_CONTEXT_HPP_
+
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <system_error>  // NOLINT
+#include <utility>
+
+#include "stdexec.hpp"
+
+#include "atomic_intrusive_queue.hpp"
+#include "eventfd_interrupter.hpp"
+#include "execution_context.hpp"
+#include "monotonic_clock.hpp"
+
+namespace net {
+namespace __io_uring {
+// An execution context driven by io_uring. Like epoll_context, only one thread
+// is allowed to run the context, which is called io thread. Socket operations
+// are submitted to the kernel as a whole instead of waiting for readiness and
+// then issuing the syscall, and many submissions are flushed by a single
+// `io_uring_enter` call.
+class io_uring_context final : public execution_context {
+ public:
+  // The scheduler of this context. Both `schedule_at`, `schedule_after` and
+  // `schedule` customization point object are supported by this scheduler.
+  class scheduler;
+
+  // The base class for all the types of operations that this context can
+  // perform. Note that operations will be executed by context in the order they
+  // are committed.
+  struct operation_base {
+    // Default constructor.
+    constexpr operation_base() noexcept
+        : enqueued_(false), next_(nullptr), execute_(nullptr) {}
+
+    // Destructor.
+    constexpr ~operation_base() = default;
+
+    // The flag determines whether the current operation is in a remote or local
+    // queue.
+    std::atomic_bool enqueued_;
+
+    // The `next_` pointer points to the next operation on the operation queue,
+    operation_base* next_;
+
+    // The `execute_` pointer points to the actual function to be executed.
+    void (*execute_)(operation_base*) noexcept;  // NOLINT
+  };
+
+  // The operation which owns a submission. The `user_data` of the submission
+  // is the address of this operation, and `result_` receives the result of
+  // the completion.
+  struct completion_op : operation_base {
+    int result_ = 0;
+  };
+
+  // The stop operation.
+  struct stop_op : operation_base {};
+
+  // The base class of operations which submit exactly one request to the ring.
+  template <typename ReceiverId>
+  class io_base_op;
+
+  // Socket operation that accepts a new connection.
+  template <typename ReceiverId, typename Protocol>
+  class socket_accept_op;
+
+  // recv some operation.
+  template <typename ReceiverId, typename Protocol, typename Buffers>
+  class socket_recv_some_op;
+
+  // send some operation.
+  template <typename ReceiverId, typename Protocol, typename Buffers>
+  class socket_send_some_op;
+
+  // Read or write a file at an offset.
+  template <typename ReceiverId, typename Buffers, bool Write>
+  class file_io_op;
+
+  // The time_point type used by scheduler.
+  using time_point = monotonic_clock::time_point;
+
+  // The queue of operations.
+  using operation_queue = stdexec::__intrusive_queue<&operation_base::next_>;
+
+  // Constructor. `entries` is the size of the submission queue. Throws an error
+  // when the ring can't be set up.
+  explicit io_uring_context(unsigned entries = 256)
+      : ring_fd_(),                                //
+        sq_ring_(),                                //
+        cq_ring_(),                                //
+        sqes_(),                                   //
+        sq_head_(nullptr),                         //
+        sq_tail_(nullptr),                         //
+        sq_mask_(0),                               //
+        sq_entries_(0),                            //
+        sq_array_(nullptr),                        //
+        sqe_array_(nullptr),                       //
+        cq_head_(nullptr),                         //
+        cq_tail_(nullptr),                         //
+        cq_mask_(0),                               //
+        cqe_array_(nullptr),                       //
+        unsubmitted_(0),                           //
+        interrupter_(),                            //
+        interrupter_armed_(false),                 //
+        processed_remote_queue_submitted_(false),  //
+        local_queue_(),                            //
+        remote_queue_(),                           //
+        stop_source_(std::in_place),               //
+        is_running_(false) {
+    setup_ring(entries);
+    arm_interrupter();
+  }
+
+  // Destructor.
+  ~io_uring_context() = default;
+
+  // Execute all operations submitted to this context.
+  void run();
+
+  // Request to stop the context. Note that the context may block on the
+  // io_uring_enter call, so we must use interrupt to wake up the context.
+  void request_stop() {
+    stop_source_->request_stop();
+    interrupter_.interrupt();
+  }
+
+  // Whether this context have been request to stop.
+  bool stop_requested() const noexcept {
+    return stop_source_->stop_requested();
+  }
+
+  // Get this context associated stop token.
+  stdexec::in_place_stop_token get_stop_token() const noexcept {
+    return stop_source_->get_token();
+  }
+
+  // Check whether this context is running.
+  bool is_running() const noexcept {
+    return is_running_.load(std::memory_order_relaxed);
+  }
+
+  // CPO: get_scheduler.
+  constexpr scheduler get_scheduler() noexcept;
+
+ private:
+  // A memory region shared with the kernel.
+  class mapped_region {
+   public:
+    constexpr mapped_region() noexcept : data_(nullptr), size_(0) {}
+
+    mapped_region(int fd, std::size_t size, off_t offset) : size_(size) {
+      data_ = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd, offset);
+      if (data_ == MAP_FAILED) {
+        data_ = nullptr;
+        throw std::system_error{static_cast<int>(errno),
+                                std::system_category(), "io_uring mmap"};
+      }
+    }
+
+    mapped_region(mapped_region&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr)),
+          size_(std::exchange(other.size_, 0)) {}
+
+    mapped_region& operator=(mapped_region&& other) noexcept {
+      if (this != &other) {
+        reset();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+      }
+      return *this;
+    }
+
+    ~mapped_region() { reset(); }
+
+    // Get the address at `offset` bytes from the start of this region.
+    template <typename T>
+    T* at(std::size_t offset) const noexcept {
+      return reinterpret_cast<T*>(static_cast<char*>(data_) + offset);
+    }
+
+   private:
+    void reset() noexcept {
+      if (data_ != nullptr) {
+        ::munmap(data_, size_);
+        data_ = nullptr;
+      }
+    }
+
+    void* data_;
+    std::size_t size_;
+  };
+
+  // The thread that calls `context.run()` is called io thread, and other
+  // threads are remote threads. This function checks which thread is using the
+  // context.
+  bool is_running_on_io_thread() const noexcept;
+
+  // Schedule the operation to the local queue if called on the io thread,
+  // otherwise to the remote queue.
+  void schedule_impl(operation_base* op) noexcept;
+
+  // Schedule the operation to the local queue.
+  void schedule_local(operation_base* op) noexcept;
+
+  // Move all contents from remote queue to local queue.
+  void schedule_local(operation_queue ops) noexcept;
+
+  // Schedule the operation to the remote queue.
+  void schedule_remote(operation_base* op) noexcept;
+
+  // Execute all items on the local queue.
+  // Won't run other items that were enqueued during the execution of the items
+  // that were already enqueued. This bounds the amount of work to a finite
+  // amount.
+  std::size_t execute_local() noexcept;
+
+  // Collect the contents of the remote queue and pass them to local queue.
+  // Returns true means remote queue is emtpy before we collect.
+  bool try_schedule_remote_to_local() noexcept;
+
+  // Get a free submission queue entry. The entry is submitted to the kernel on
+  // the next `io_uring_enter` call. Returns nullptr if the submission queue is
+  // still full after flushing it. Must be called from the I/O thread.
+  io_uring_sqe* get_sqe() noexcept;
+
+  // Submit a request which cancels the submission of `op`. Must be called from
+  // the I/O thread.
+  void submit_cancel(completion_op* op) noexcept;
+
+  // Submit all pending entries and wait for at least `min_complete`
+  // completions.
+  void enter(unsigned min_complete);
+
+  // Move all available completions to the local queue.
+  void acquire_completion_queue_items() noexcept;
+
+  // Poll the interrupter so that remote threads can wake up the io thread.
+  // Leaves `interrupter_armed_` false if the submission queue is full, the
+  // run loop retries then.
+  void arm_interrupter() noexcept;
+
+  // Set up the io_uring instance and map its queues. Throws an error when
+  // setup fails.
+  void setup_ring(unsigned entries);
+
+  // The `user_data` of the cancellation requests, whose completions are
+  // ignored.
+  static constexpr std::uint64_t cancel_user_data = 0;
+
+  // The `user_data` of the interrupter poll request.
+  std::uint64_t interrupter_user_data() const noexcept {
+    return reinterpret_cast<std::uintptr_t>(&interrupter_);
+  }
+
+  // The io_uring file descriptor.
+  exec::safe_file_descriptor ring_fd_;
+
+  // The memory shared with the kernel.
+  mapped_region sq_ring_;
+  mapped_region cq_ring_;
+  mapped_region sqes_;
+
+  // The submission queue.
+  unsigned* sq_head_;
+  unsigned* sq_tail_;
+  unsigned sq_mask_;
+  unsigned sq_entries_;
+  unsigned* sq_array_;
+  io_uring_sqe* sqe_array_;
+
+  // The completion queue.
+  unsigned* cq_head_;
+  unsigned* cq_tail_;
+  unsigned cq_mask_;
+  io_uring_cqe* cqe_array_;
+
+  // The count of entries not yet submitted to the kernel.
+  unsigned unsubmitted_;
+
+  // Notifying a remote thread to wake up from `io_uring_enter`.
+  eventfd_interrupter interrupter_;
+
+  // Whether the interrupter is being polled.
+  bool interrupter_armed_;
+
+  // Whether the operation submitted by the remote thread has been processed.
+  bool processed_remote_queue_submitted_;
+
+  // Local queue for operations that are ready to execute.
+  operation_queue local_queue_;
+
+  // Queue of operations enqueued by remote threads.
+  atomic_intrusive_queue<&operation_base::next_> remote_queue_;
+
+  // The stop source.
+  std::optional<stdexec::in_place_stop_source> stop_source_;
+
+  // Whether this context is running.
+  std::atomic_bool is_running_;
+};
+
+// The base class of operations which submit exactly one request to the ring.
+// Subclasses provide how to prepare the request and how to complete the
+// receiver with the result. Cancellation is done by an extra cancel request,
+// every step of the cancellation runs on the io thread.
+template <typename ReceiverId>
+class io_uring_context::io_base_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+
+ public:
+  struct __t : public stdexec::__immovable,
+               private io_uring_context::completion_op,
+               private io_uring_context::stop_op {
+    using __id = io_base_op;
+    using stop_token = stdexec::stop_token_of_t<stdexec::env_of_t<receiver_t>>;
+
+    // Subclasses should provide these necessary functions.
+    struct op_vtable {
+      // Fill the submission queue entry.
+      void (*prepare)(__t*, io_uring_sqe&) noexcept = nullptr;  // NOLINT
+
+      // The request is complete, notify the downstream receiver based on the
+      // value of `result_`.
+      void (*complete)(__t*) noexcept = nullptr;  // NOLINT
+    };
+
+    struct cancel_callback {
+      __t& op_;
+
+      void operator()() noexcept { op_.request_stop(); }
+    };
+
+    // Constructor.
+    __t(receiver_t receiver, io_uring_context& context,
+        const op_vtable& vtable) noexcept
+        : receiver_(static_cast<receiver_t&&>(receiver)),
+          context_(context),
+          op_vtable_(&vtable),
+          stop_requested_(false),
+          completed_(false),
+          stop_executed_(false),
+          stop_callback_() {}
+
+    friend void tag_invoke(stdexec::start_t, __t& self) noexcept {
+      self.start_impl();
+    }
+
+    // The result of the request, negative errno on failure.
+    constexpr int result() const noexcept {
+      return static_cast<const completion_op&>(*this).result_;
+    }
+
+    void start_impl() noexcept {
+      if (!context_.is_running_on_io_thread()) {
+        static_cast<completion_op*>(this)->execute_ =
+            &__t::on_schedule_complete;
+        context_.schedule_remote(static_cast<completion_op*>(this));
+      } else {
+        submit();
+      }
+    }
+
+    // io_uring_context starts to execute this operation in the io thread.
+    static void on_schedule_complete(operation_base* op) noexcept {
+      static_cast<__t*>(static_cast<completion_op*>(op))->submit();
+    }
+
+    void submit() noexcept {
+      assert(context_.is_running_on_io_thread());
+      if constexpr (!stdexec::unstoppable_token<stop_token>) {
+        if (stdexec::get_stop_token(stdexec::get_env(receiver_))
+                .stop_requested()) {
+          stdexec::set_stopped(static_cast<receiver_t&&>(receiver_));
+          return;
+        }
+      }
+
+      io_uring_sqe* sqe = context_.get_sqe();
+      if (sqe == nullptr) {
+        static_cast<completion_op*>(this)->result_ = -EBUSY;
+        op_vtable_->complete(this);
+        return;
+      }
+      op_vtable_->prepare(this, *sqe);
+      sqe->user_data =
+          reinterpret_cast<std::uintptr_t>(static_cast<completion_op*>(this));
+      static_cast<completion_op*>(this)->execute_ = &__t::on_completion;
+
+      if constexpr (!stdexec::unstoppable_token<stop_token>) {
+        stop_callback_.__construct(
+            stdexec::get_stop_token(stdexec::get_env(receiver_)),
+            cancel_callback{*this});
+      }
+    }
+
+    // The completion of the request has been reaped.
+    static void on_completion(operation_base* op) noexcept {
+      auto& self = *static_cast<__t*>(static_cast<completion_op*>(op));
+      if constexpr (!stdexec::unstoppable_token<stop_token>) {
+        // Wait for a concurrent stop request to finish.
+        self.stop_callback_.__destruct();
+      }
+      if (self.stop_requested_.load(std::memory_order_acquire) &&
+          !self.stop_executed_) {
+        // The stop operation is on its way, let it complete the operation.
+        self.completed_ = true;
+        return;
+      }
+      self.op_vtable_->complete(&self);
+    }
+
+    static void on_stop(operation_base* op) noexcept {
+      auto& self = *static_cast<__t*>(static_cast<stop_op*>(op));
+      self.stop_executed_ = true;
+      if (self.completed_) {
+        self.op_vtable_->complete(&self);
+        return;
+      }
+      // The request completes with -ECANCELED, or with its own result if it
+      // has completed in the meantime.
+      self.context_.submit_cancel(static_cast<completion_op*>(&self));
+    }
+
+    // Any thread requests that this operation should be stopped.
+    void request_stop() noexcept {
+      stop_requested_.store(true, std::memory_order_release);
+      static_cast<stop_op*>(this)->execute_ = &__t::on_stop;
+      context_.schedule_impl(static_cast<stop_op*>(this));
+    }
+
+    receiver_t receiver_;
+    io_uring_context& context_;
+    const op_vtable* op_vtable_;
+    std::atomic<bool> stop_requested_;
+
+    // Only accessed by the io thread.
+    bool completed_;
+    bool stop_executed_;
+    exec::__manual_lifetime<
+        typename stop_token::template callback_type<cancel_callback>>
+        stop_callback_;
+  };
+};
+
+// The scheduler with returned by `stdexec::get_schedule` customization point
+// object.
+class io_uring_context::scheduler {
+  // The envrionment of scheduler.
+  struct schedule_env {
+    friend auto tag_invoke(
+        stdexec::get_completion_scheduler_t<stdexec::set_value_t>,
+        const schedule_env& env) noexcept -> scheduler {
+      return scheduler{env.context};
+    }
+
+    explicit constexpr schedule_env(io_uring_context& ctx) noexcept
+        : context(ctx) {}
+
+    io_uring_context& context;
+  };  // schedule_env
+
+  template <typename ReceiverId>
+  class schedule_op {
+    using receiver_t = stdexec::__t<ReceiverId>;
+
+   public:
+    struct __t : private operation_base {
+      using __id = schedule_op;
+      using stop_token =
+          stdexec::stop_token_of_t<stdexec::env_of_t<receiver_t>&>;
+
+      constexpr __t(io_uring_context& context, receiver_t r)
+          : context_(context), receiver_(static_cast<receiver_t&&>(r)) {
+        execute_ = &execute_impl;
+      }
+
+      friend void tag_invoke(stdexec::start_t, __t& op) noexcept {
+        op.context_.schedule_impl(&op);
+      }
+
+     private:
+      static constexpr void execute_impl(operation_base* p) noexcept {
+        auto& self = *static_cast<__t*>(p);
+        if constexpr (!std::unstoppable_token<stop_token>) {
+          auto stop_token =
+              stdexec::get_stop_token(stdexec::get_env(self.receiver_));
+          if (stop_token.stop_requested()) {
+            stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+            return;
+          }
+        }
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_));
+      }
+
+      io_uring_context& context_;
+      STDEXEC_NO_UNIQUE_ADDRESS receiver_t receiver_;
+    };
+  };  // schedule_op.
+
+  class schedule_sender {
+    template <typename Receiver>
+    using op_t = stdexec::__t<schedule_op<stdexec::__id<Receiver>>>;
+
+   public:
+    struct __t {
+      using is_sender = void;
+      using __id = schedule_sender;
+      using completion_signatures =
+          stdexec::completion_signatures<stdexec::set_value_t(),  //
+                                         stdexec::set_stopped_t()>;
+
+      template <typename Env>
+      friend auto tag_invoke(stdexec::get_completion_signatures_t,
+                             const __t& self, Env&&) noexcept
+          -> completion_signatures;
+
+      friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+          -> schedule_env {
+        return self.env_;
+      }
+
+      template <stdexec::__decays_to<__t> Sender,
+                stdexec::receiver_of<completion_signatures> Receiver>
+      friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                             Receiver receiver) noexcept -> op_t<Receiver> {
+        return {static_cast<__t&&>(self).env_.context,
+                static_cast<Receiver&&>(receiver)};
+      }
+
+      explicit constexpr __t(schedule_env env) noexcept : env_(env) {}
+
+     private:
+      schedule_env env_;
+    };
+  };  // schedule_sender.
+
+  // The timer is an `IORING_OP_TIMEOUT` request at an absolute time point.
+  template <typename ReceiverId>
+  class schedule_at_op {
+    using receiver_t = stdexec::__t<ReceiverId>;
+    using base_t = stdexec::__t<io_base_op<ReceiverId>>;
+
+   public:
+    struct __t : public base_t {
+      using __id = schedule_at_op;
+
+      constexpr __t(io_uring_context& context, const time_point& due_time,
+                    receiver_t r) noexcept
+          : base_t(static_cast<receiver_t&&>(r), context, op_vtable),
+            timespec_{.tv_sec = due_time.seconds(),
+                      .tv_nsec = due_time.nanoseconds()} {}
+
+     private:
+      static void prepare(base_t* base, io_uring_sqe& sqe) noexcept {
+        auto& self = *static_cast<__t*>(base);
+        sqe.opcode = IORING_OP_TIMEOUT;
+        sqe.fd = -1;
+        sqe.addr = reinterpret_cast<std::uintptr_t>(&self.timespec_);
+        sqe.len = 1;
+        sqe.off = 0;
+        sqe.timeout_flags = IORING_TIMEOUT_ABS;
+      }
+
+      static void complete(base_t* base) noexcept {
+        auto& self = *static_cast<__t*>(base);
+        if (self.result() == -ETIME || self.result() == 0) {
+          stdexec::set_value(static_cast<receiver_t&&>(self.receiver_));
+        } else {
+          // Cancelled, or the kernel refused the timer.
+          stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+        }
+      }
+
+      static constexpr typename base_t::op_vtable op_vtable{&prepare,
+                                                            &complete};
+      __kernel_timespec timespec_;
+    };
+  };  // schedule_at_op.
+
+  class schedule_at_sender {
+    template <typename Receiver>
+    using op_t = stdexec::__t<schedule_at_op<stdexec::__id<Receiver>>>;
+
+   public:
+    struct __t {
+      using is_sender = void;
+      using __id = schedule_at_sender;
+      using completion_signatures =
+          stdexec::completion_signatures<stdexec::set_value_t(),
+                                         stdexec::set_stopped_t()>;
+
+      template <typename Env>
+      friend auto tag_invoke(stdexec::get_completion_signatures_t,
+                             const __t& self, Env&&) noexcept
+          -> completion_signatures;
+
+      friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+          -> schedule_env {
+        return self.env_;
+      }
+
+      template <stdexec::__decays_to<__t> Sender,
+                stdexec::receiver_of<completion_signatures> Receiver>
+      friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                             Receiver receiver) noexcept -> op_t<Receiver> {
+        return {static_cast<__t&&>(self).env_.context,  //
+                static_cast<__t&&>(self).due_time_,     //
+                static_cast<Receiver&&>(receiver)};
+      }
+
+      constexpr __t(schedule_env env, const time_point& due_time) noexcept
+          : env_(env), due_time_(due_time) {}
+
+     private:
+      schedule_env env_;
+      time_point due_time_;
+    };
+  };  // schedule_at_sender
+
+ public:
+  // Constructors.
+  explicit constexpr scheduler(io_uring_context& context) noexcept
+      : context_(&context) {}
+
+  constexpr scheduler(const scheduler&) noexcept = default;
+
+  constexpr scheduler& operator=(const scheduler&) = default;
+
+  constexpr ~scheduler() = default;
+
+  friend auto tag_invoke(exec::now_t, const scheduler&) noexcept -> time_point {
+    return monotonic_clock::now();
+  }
+
+  friend auto tag_invoke(stdexec::schedule_t, const scheduler& sched) noexcept
+      -> stdexec::__t<schedule_sender> {
+    return stdexec::__t<schedule_sender>{schedule_env{*sched.context_}};
+  }
+
+  friend auto tag_invoke(exec::schedule_at_t,     //
+                         const scheduler& sched,  //
+                         const time_point& due_time) noexcept
+      -> stdexec::__t<schedule_at_sender> {
+    return {schedule_env{*sched.context_}, due_time};
+  }
+
+  friend auto tag_invoke(exec::schedule_after_t,  //
+                         const scheduler& sched,  //
+                         std::chrono::nanoseconds duration) noexcept
+      -> stdexec::__t<schedule_at_sender> {
+    return {schedule_env{*sched.context_}, monotonic_clock::now() + duration};
+  }
+
+ private:
+  friend bool operator==(scheduler a, scheduler b) noexcept {
+    return a.context_ == b.context_;
+  }
+
+  friend bool operator!=(scheduler a, scheduler b) noexcept {
+    return a.context_ != b.context_;
+  }
+
+  io_uring_context* context_;
+};
+
+inline constexpr io_uring_context::scheduler
+io_uring_context::get_scheduler() noexcept {
+  return scheduler{*this};
+}
+
+inline void io_uring_context::setup_ring(unsigned entries) {
+  io_uring_params params = {};
+  int fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+  if (fd < 0) {
+    throw std::system_error{static_cast<int>(errno), std::system_category(),
+                            "io_uring_setup"};
+  }
+  ring_fd_ = exec::safe_file_descriptor{fd};
+
+  std::size_t sq_size =
+      params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  std::size_t cq_size =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+    sq_size = cq_size = std::max(sq_size, cq_size);
+    sq_ring_ = mapped_region{ring_fd_, sq_size, IORING_OFF_SQ_RING};
+  } else {
+    sq_ring_ = mapped_region{ring_fd_, sq_size, IORING_OFF_SQ_RING};
+    cq_ring_ = mapped_region{ring_fd_, cq_size, IORING_OFF_CQ_RING};
+  }
+  const mapped_region& cq_ring =
+      (params.features & IORING_FEAT_SINGLE_MMAP) != 0 ? sq_ring_ : cq_ring_;
+  sqes_ = mapped_region{ring_fd_, params.sq_entries * sizeof(io_uring_sqe),
+                        IORING_OFF_SQES};
+
+  sq_head_ = sq_ring_.at<unsigned>(params.sq_off.head);
+  sq_tail_ = sq_ring_.at<unsigned>(params.sq_off.tail);
+  sq_mask_ = *sq_ring_.at<unsigned>(params.sq_off.ring_mask);
+  sq_entries_ = *sq_ring_.at<unsigned>(params.sq_off.ring_entries);
+  sq_array_ = sq_ring_.at<unsigned>(params.sq_off.array);
+  sqe_array_ = sqes_.at<io_uring_sqe>(0);
+  cq_head_ = cq_ring.at<unsigned>(params.cq_off.head);
+  cq_tail_ = cq_ring.at<unsigned>(params.cq_off.tail);
+  cq_mask_ = *cq_ring.at<unsigned>(params.cq_off.ring_mask);
+  cqe_array_ = cq_ring.at<io_uring_cqe>(params.cq_off.cqes);
+}
+
+// The context run by the current thread. An inline variable, so that every
+// translation unit sees the same slot and recognizes the io thread.
+inline thread_local io_uring_context* current_thread_context = nullptr;
+
+inline bool io_uring_context::is_running_on_io_thread() const noexcept {
+  return this == current_thread_context;
+}
+
+inline io_uring_sqe* io_uring_context::get_sqe() noexcept {
+  unsigned head = std::atomic_ref<unsigned>(*sq_head_).load(
+      std::memory_order_acquire);
+  unsigned tail = *sq_tail_;
+  if (tail - head >= sq_entries_) {
+    // Flush the submission queue to make room for the new entry.
+    if (::syscall(__NR_io_uring_enter, static_cast<int>(ring_fd_),
+                  unsubmitted_, 0, 0, nullptr, 0) >= 0) {
+      unsubmitted_ = 0;
+    }
+    head = std::atomic_ref<unsigned>(*sq_head_).load(std::memory_order_acquire);
+    if (tail - head >= sq_entries_) {
+      return nullptr;
+    }
+  }
+
+  unsigned index = tail & sq_mask_;
+  io_uring_sqe* sqe = &sqe_array_[index];
+  *sqe = io_uring_sqe{};
+  sq_array_[index] = index;
+  std::atomic_ref<unsigned>(*sq_tail_).store(tail + 1,
+                                             std::memory_order_release);
+  ++unsubmitted_;
+  return sqe;
+}
+
+inline void io_uring_context::submit_cancel(completion_op* op) noexcept {
+  io_uring_sqe* sqe = get_sqe();
+  if (sqe == nullptr) {
+    // The request will complete by itself sooner or later.
+    return;
+  }
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->addr = reinterpret_cast<std::uintptr_t>(op);
+  sqe->user_data = cancel_user_data;
+}
+
+inline void io_uring_context::arm_interrupter() noexcept {
+  io_uring_sqe* sqe = get_sqe();
+  interrupter_armed_ = sqe != nullptr;
+  if (sqe == nullptr) {
+    return;
+  }
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = interrupter_.read_descriptor();
+  sqe->poll32_events = POLLIN;
+  sqe->user_data = interrupter_user_data();
+}
+
+inline void io_uring_context::enter(unsigned min_complete) {
+  unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+  if (unsubmitted_ == 0 && flags == 0) {
+    return;
+  }
+  long result = ::syscall(__NR_io_uring_enter, static_cast<int>(ring_fd_),
+                          unsubmitted_, min_complete, flags, nullptr, 0);
+  if (result < 0) {
+    if (errno == EINTR || errno == EBUSY || errno == EAGAIN) {
+      // Reap the completions and retry next time.
+      return;
+    }
+    throw std::system_error{static_cast<int>(errno), std::system_category(),
+                            "io_uring_enter"};
+  }
+  unsubmitted_ -= static_cast<unsigned>(result);
+}
+
+inline void io_uring_context::acquire_completion_queue_items() noexcept {
+  unsigned head = *cq_head_;
+  unsigned tail =
+      std::atomic_ref<unsigned>(*cq_tail_).load(std::memory_order_acquire);
+
+  // temporary queue of newly completed items.
+  operation_queue completion_queue;
+  for (; head != tail; ++head) {
+    const io_uring_cqe& cqe = cqe_array_[head & cq_mask_];
+    if (cqe.user_data == cancel_user_data) {
+      continue;
+    }
+    if (cqe.user_data == interrupter_user_data()) {
+      // Level triggered, clear the signal before polling again.
+      interrupter_.reset();
+      processed_remote_queue_submitted_ = false;
+      arm_interrupter();
+      continue;
+    }
+    auto* op = reinterpret_cast<completion_op*>(cqe.user_data);
+    op->result_ = cqe.res;
+    assert(op->enqueued_.load() == false);
+    op->enqueued_ = true;
+    completion_queue.push_back(op);
+  }
+  std::atomic_ref<unsigned>(*cq_head_).store(head, std::memory_order_release);
+  schedule_local(std::move(completion_queue));
+}
+
+inline std::size_t io_uring_context::execute_local() noexcept {
+  if (local_queue_.empty()) {
+    return 0;
+  }
+  std::size_t count = 0;
+  auto pending = std::move(local_queue_);
+  while (!pending.empty()) {
+    auto* item = pending.pop_front();
+    assert(item->enqueued_);
+    item->enqueued_ = false;
+    std::exchange(item->next_, nullptr);
+    item->execute_(item);
+    ++count;
+  }
+  return count;
+}
+
+inline void io_uring_context::run() {
+  // Only one thread of execution is allowed to drive the io context.
+  bool expected_running = false;
+  if (!is_running_.compare_exchange_strong(expected_running, true,
+                                           std::memory_order_relaxed)) {
+    throw std::runtime_error(
+        "io_uring_context::run() called on a running context");
+  }
+  exec::scope_guard set_not_running{[&]() noexcept {  //
+    is_running_.store(false, std::memory_order_relaxed);
+  }};
+
+  auto* old_context = std::exchange(current_thread_context, this);
+  exec::scope_guard g{[=]() noexcept {
+    std::exchange(current_thread_context, old_context);
+  }};
+
+  while (true) {
+    execute_local();
+    if (stop_source_->stop_requested()) {
+      break;
+    }
+    if (!processed_remote_queue_submitted_) {
+      processed_remote_queue_submitted_ = try_schedule_remote_to_local();
+    }
+    if (!interrupter_armed_) {
+      arm_interrupter();
+    }
+    // Don't block while remote threads can't wake up the io thread.
+    enter(local_queue_.empty() && interrupter_armed_ ? 1 : 0);
+    acquire_completion_queue_items();
+  }
+}
+
+inline void io_uring_context::schedule_impl(operation_base* op) noexcept {
+  assert(op != nullptr);
+  if (is_running_on_io_thread()) {
+    schedule_local(op);
+  } else {
+    schedule_remote(op);
+  }
+}
+
+inline void io_uring_context::schedule_local(operation_base* op) noexcept {
+  assert(op->execute_ != nullptr);
+  assert(!op->enqueued_);
+  op->enqueued_ = true;
+  local_queue_.push_back(op);
+}
+
+inline void io_uring_context::schedule_local(operation_queue ops) noexcept {
+  // Do not adjust the enqueued flag, which is still true because the ops will
+  // immediately be transferred from the remote queue to the local queue.
+  local_queue_.append(std::move(ops));
+}
+
+inline void io_uring_context::schedule_remote(operation_base* op) noexcept {
+  assert(!op->enqueued_.load());
+  op->enqueued_ = true;
+  if (remote_queue_.enqueue(op)) {
+    // We were the first to queue an item and the I/O thread is not
+    // going to check the queue until we notify it that new items
+    // have been enqueued remotely by writing to the eventfd.
+    interrupter_.interrupt();
+  }
+}
+
+inline bool io_uring_context::try_schedule_remote_to_local() noexcept {
+  (void)remote_queue_.try_mark_active();
+  auto queued_items = remote_queue_.try_mark_inactive_or_dequeue_all();
+  if (!queued_items.empty()) {
+    schedule_local(std::move(queued_items));
+    return false;
+  }
+  return true;
+}
+};  // namespace __io_uring
+
+using io_uring_context = __io_uring::io_uring_context;
+}  // namespace net
+
+#endif  // IO_URING_IO_URING_CONTEXT_HPP_
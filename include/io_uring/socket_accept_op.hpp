@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef IO_URING_SOCKET_ACCEPT_OP_HPP_
+#define IO_URING_SOCKET_ACCEPT_OP_HPP_
+
+#include <linux/io_uring.h>
+#include <sys/socket.h>
+
+#include <cerrno>
+#include <system_error>  // NOLINT
+
+#include "basic_socket_acceptor.hpp"
+#include "io_uring/io_uring_context.hpp"
+#include "meta.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __io_uring {
+
+template <typename ReceiverId, typename Protocol>
+class io_uring_context::socket_accept_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  using base_t = stdexec::__t<io_uring_context::io_base_op<ReceiverId>>;
+  using acceptor_t = basic_socket_acceptor<Protocol>;
+  using socket_t = typename Protocol::socket;
+
+ public:
+  struct __t : public base_t {
+    using __id = socket_accept_op;
+
+    // Constructor.
+    constexpr __t(receiver_t receiver, acceptor_t& acceptor) noexcept
+        : base_t(static_cast<receiver_t&&>(receiver),
+                 static_cast<io_uring_context&>(acceptor.context()),
+                 op_vtable),
+          acceptor_(acceptor) {}
+
+   private:
+    static void prepare(base_t* base, io_uring_sqe& sqe) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      sqe.opcode = IORING_OP_ACCEPT;
+      sqe.fd = self.acceptor_.native_handle();
+      sqe.addr = 0;
+      sqe.addr2 = 0;
+      sqe.accept_flags = SOCK_CLOEXEC;
+    }
+
+    static void complete(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      int res = self.result();
+      if (res >= 0) {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                           socket_t{self.context_, self.acceptor_.protocol(),
+                                    res});
+      } else if (res == -ECANCELED) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      } else {
+        stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                           std::error_code{-res, std::system_category()});
+      }
+    }
+
+    static constexpr typename base_t::op_vtable op_vtable{&prepare, &complete};
+    acceptor_t& acceptor_;
+  };
+};
+
+template <typename Protocol>
+class accept_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<
+      io_uring_context::socket_accept_op<stdexec::__id<Receiver>, Protocol>>;
+  using acceptor_t = basic_socket_acceptor<Protocol>;
+  using socket_t = typename Protocol::socket;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = accept_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(socket_t&&),
+                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t,
+                           const __t& self, Env) -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.acceptor_};
+    }
+
+    // Constructors.
+    explicit constexpr __t(acceptor_t& acceptor) : acceptor_(acceptor) {}
+
+   private:
+    acceptor_t& acceptor_;
+  };
+};
+
+struct async_accept_t {
+  template <transport_protocol Protocol>
+  constexpr auto operator()(basic_socket_acceptor<Protocol>& acceptor)
+      const noexcept -> stdexec::__t<accept_sender<Protocol>> {
+    return stdexec::__t<accept_sender<Protocol>>{acceptor};
+  }
+};
+}  // namespace __io_uring
+
+namespace uring {
+// Socket operations whose acceptor or socket is associated with an
+// io_uring_context.
+inline constexpr __io_uring::async_accept_t async_accept{};
+}  // namespace uring
+}  // namespace net
+
+#endif  // IO_URING_SOCKET_ACCEPT_OP_HPP_
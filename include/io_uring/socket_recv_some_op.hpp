@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef IO_URING_SOCKET_RECV_SOME_OP_HPP_
+#define IO_URING_SOCKET_RECV_SOME_OP_HPP_
+
+#include <linux/io_uring.h>
+#include <sys/socket.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <system_error>  // NOLINT
+
+#include "basic_socket.hpp"
+#include "buffer.hpp"
+#include "buffer_sequence_adapter.hpp"
+#include "io_uring/io_uring_context.hpp"
+#include "meta.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __io_uring {
+
+template <typename ReceiverId, typename Protocol, typename Buffers>
+class io_uring_context::socket_recv_some_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  using base_t = stdexec::__t<io_uring_context::io_base_op<ReceiverId>>;
+  using socket_t = typename Protocol::socket;
+  using bufs_t = buffer_sequence_adapter<mutable_buffer, Buffers>;
+
+ public:
+  struct __t : public base_t {
+    using __id = socket_recv_some_op;
+
+    // Constructor.
+    constexpr __t(receiver_t receiver, basic_socket<Protocol>& socket,
+                  Buffers buffers) noexcept
+        : base_t(static_cast<receiver_t&&>(receiver),
+                 static_cast<io_uring_context&>(socket.context()),
+                 op_vtable),
+          socket_(static_cast<socket_t&>(socket)),
+          buffers_(buffers),
+          msg_{} {}
+
+   private:
+    static void prepare(base_t* base, io_uring_sqe& sqe) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      sqe.fd = self.socket_.native_handle();
+      if constexpr (bufs_t::is_single_buffer) {
+        sqe.opcode = IORING_OP_RECV;
+        sqe.addr =
+            reinterpret_cast<std::uintptr_t>(self.buffers_.buffers()->iov_base);
+        sqe.len = static_cast<std::uint32_t>(self.buffers_.buffers()->iov_len);
+      } else {
+        // The iovecs must stay alive until the request completes.
+        self.msg_.msg_iov = self.buffers_.buffers();
+        self.msg_.msg_iovlen = self.buffers_.count();
+        sqe.opcode = IORING_OP_RECVMSG;
+        sqe.addr = reinterpret_cast<std::uintptr_t>(&self.msg_);
+        sqe.len = 1;
+      }
+    }
+
+    static void complete(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      int res = self.result();
+      if (res >= 0) {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                           static_cast<size_t>(res));
+      } else if (res == -ECANCELED) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      } else {
+        stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                           make_error_code(static_cast<std::errc>(-res)));
+      }
+    }
+
+    static constexpr typename base_t::op_vtable op_vtable{&prepare, &complete};
+    socket_t& socket_;
+    bufs_t buffers_;
+    ::msghdr msg_;
+  };
+};
+
+template <typename Protocol, typename Buffers>
+class recv_some_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<io_uring_context::socket_recv_some_op<
+      stdexec::__id<Receiver>, Protocol, Buffers>>;
+  using socket_t = typename Protocol::socket;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = recv_some_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(size_t),
+                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.socket_, self.buffers_};
+    }
+
+    constexpr __t(basic_socket<Protocol>& socket,  // NOLINT
+                  Buffers buffers) noexcept
+        : socket_(static_cast<socket_t&>(socket)), buffers_(buffers) {}
+
+   private:
+    socket_t& socket_;
+    Buffers buffers_;
+  };
+};
+
+struct async_recv_some_t {
+  template <transport_protocol Protocol, mutable_buffer_sequence Buffers>
+  constexpr auto operator()(basic_socket<Protocol>& socket,
+                            Buffers buffers) const noexcept
+      -> stdexec::__t<recv_some_sender<Protocol, Buffers>> {
+    return {socket, buffers};
+  }
+};
+}  // namespace __io_uring
+
+namespace uring {
+inline constexpr __io_uring::async_recv_some_t async_recv_some{};
+}  // namespace uring
+}  // namespace net
+
+#endif  // IO_URING_SOCKET_RECV_SOME_OP_HPP_
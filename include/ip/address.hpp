@@ -16,7 +16,11 @@
 #ifndef IP_ADDRESS_HPP_
 #define IP_ADDRESS_HPP_
 
+#include <algorithm>
+#include <charconv>
 #include <string>
+#include <string_view>
+#include <system_error>  // NOLINT
 #include <variant>
 
 #include "ip/address_v4.hpp"
@@ -83,6 +87,17 @@ class address {
   // Get the address as an IP version 6 address.
   constexpr address_v6 to_v6() const { return std::get<v6_index>(address_); }
 
+  // The length of the longest text form of either version.
+  static constexpr std::size_t max_chars = address_v6::max_chars;
+
+  // Write the address to [first, last), without a terminating null. Fails
+  // with `std::errc::value_too_large` if it doesn't fit.
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    return std::visit(
+        [first, last](auto&& addr) { return addr.to_chars(first, last); },
+        address_);
+  }
+
   // Get the address as a string.
   std::string to_string() const {
     return std::visit([](auto&& addr) { return addr.to_string(); }, address_);
@@ -135,23 +150,48 @@ class address {
   address_variant address_;
 };
 
+// Parse an address from the characters at the beginning of [first, last),
+// as IPv6 if they contain a ':' before the first character that can't belong
+// to an address and as IPv4 otherwise.
+inline std::from_chars_result from_chars(const char* first, const char* last,
+                                         address& addr) noexcept {
+  const char* end = __chars::scan(first, last, true);
+  std::from_chars_result result;
+  if (std::find(first, end, ':') != end) {
+    address_v6 v6;
+    result = from_chars(first, last, v6);
+    if (result.ec == std::errc{}) {
+      addr = v6;
+    }
+  } else {
+    address_v4 v4;
+    result = from_chars(first, last, v4);
+    if (result.ec == std::errc{}) {
+      addr = v4;
+    }
+  }
+  return result;
+}
+
 // Create an address from an IPv4 address string in dotted decimal form,
 // or from an IPv6 address in hexadecimal notation.
-inline constexpr address make_address(const char* str) noexcept {
-  // TODO(xiaoming) Implement
-  return {};
+inline address make_address(std::string_view str) noexcept {
+  if (str.find(':') != std::string_view::npos) {
+    return address{make_address_v6(str)};
+  }
+  return address{make_address_v4(str)};
 }
 
 // Create an address from an IPv4 address string in dotted decimal form,
 // or from an IPv6 address in hexadecimal notation.
-inline address make_address(const std::string& str) {
-  return make_address(str.c_str());
+inline address make_address(const char* str) noexcept {
+  return make_address(std::string_view{str});
 }
 
 // Create an address from an IPv4 address string in dotted decimal form,
 // or from an IPv6 address in hexadecimal notation.
-inline address make_address(std::string_view str) {
-  return make_address(static_cast<std::string>(str));
+inline address make_address(const std::string& str) noexcept {
+  return make_address(std::string_view{str});
 }
 
 }  // namespace ip
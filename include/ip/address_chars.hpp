@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef IP_ADDRESS_CHARS_HPP_
+#define IP_ADDRESS_CHARS_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace net::ip::__chars {
+// Formatting and parsing of the text forms of IP addresses, without locale,
+// allocation or libc calls. The parsers accept exactly what `inet_pton`
+// accepts, the formatters produce exactly what `inet_ntop` produces.
+
+// The decimal digits of every octet, padded to three characters, followed by
+// the count of digits.
+inline constexpr auto octet_table = [] {
+  std::array<std::array<char, 4>, 256> table{};
+  for (int i = 0; i < 256; ++i) {
+    auto& entry = table[i];
+    if (i >= 100) {
+      entry = {static_cast<char>('0' + i / 100),
+               static_cast<char>('0' + i / 10 % 10),
+               static_cast<char>('0' + i % 10), 3};
+    } else if (i >= 10) {
+      entry = {static_cast<char>('0' + i / 10), static_cast<char>('0' + i % 10),
+               0, 2};
+    } else {
+      entry = {static_cast<char>('0' + i), 0, 0, 1};
+    }
+  }
+  return table;
+}();
+
+// Write the decimal form of `octet` at `p`. Three characters are always
+// written, so `p` needs room for them. Returns the end of the digits.
+inline char* write_octet(char* p, unsigned char octet) noexcept {
+  const auto& entry = octet_table[octet];
+  std::memcpy(p, entry.data(), 3);
+  return p + entry[3];
+}
+
+// Write the dotted decimal form of `bytes` at `p`, which needs room for 16
+// characters. Returns the end of the text.
+inline char* write_v4(char* p, const unsigned char* bytes) noexcept {
+  p = write_octet(p, bytes[0]);
+  *p++ = '.';
+  p = write_octet(p, bytes[1]);
+  *p++ = '.';
+  p = write_octet(p, bytes[2]);
+  *p++ = '.';
+  return write_octet(p, bytes[3]);
+}
+
+// Write `word` in lower case hex without leading zeros at `p`.
+inline char* write_hex(char* p, std::uint16_t word) noexcept {
+  constexpr char digits[] = "0123456789abcdef";
+  int shift = word >= 0x1000 ? 12 : word >= 0x100 ? 8 : word >= 0x10 ? 4 : 0;
+  for (; shift >= 0; shift -= 4) {
+    *p++ = digits[(word >> shift) & 0xF];
+  }
+  return p;
+}
+
+// Write the text form of the IPv6 address `bytes` at `p`, which needs room
+// for 48 characters. The longest run of two or more zero words is compressed
+// to "::", and IPv4-mapped and -compatible addresses end in dotted decimal.
+inline char* write_v6(char* p, const unsigned char* bytes) noexcept {
+  std::uint16_t words[8];
+  for (int i = 0; i < 8; ++i) {
+    words[i] =
+        static_cast<std::uint16_t>((bytes[2 * i] << 8) | bytes[2 * i + 1]);
+  }
+  int best_base = -1;
+  int best_len = 0;
+  for (int i = 0; i < 8;) {
+    if (words[i] != 0) {
+      ++i;
+      continue;
+    }
+    int j = i;
+    while (j < 8 && words[j] == 0) {
+      ++j;
+    }
+    if (j - i > best_len) {
+      best_base = i;
+      best_len = j - i;
+    }
+    i = j;
+  }
+  if (best_len < 2) {
+    best_base = -1;
+  }
+
+  for (int i = 0; i < 8; ++i) {
+    if (best_base != -1 && i >= best_base && i < best_base + best_len) {
+      if (i == best_base) {
+        *p++ = ':';
+      }
+      continue;
+    }
+    if (i != 0) {
+      *p++ = ':';
+    }
+    if (i == 6 && best_base == 0 &&
+        (best_len == 6 || (best_len == 5 && words[5] == 0xffff))) {
+      return write_v4(p, bytes + 12);
+    }
+    p = write_hex(p, words[i]);
+  }
+  if (best_base != -1 && best_base + best_len == 8) {
+    *p++ = ':';
+  }
+  return p;
+}
+
+// The value of every hex digit, and -1 for any other character.
+inline constexpr auto hex_table = [] {
+  std::array<signed char, 256> table{};
+  for (int c = 0; c < 256; ++c) {
+    table[c] = c >= '0' && c <= '9'   ? static_cast<signed char>(c - '0')
+               : c >= 'a' && c <= 'f' ? static_cast<signed char>(c - 'a' + 10)
+               : c >= 'A' && c <= 'F' ? static_cast<signed char>(c - 'A' + 10)
+                                      : -1;
+  }
+  return table;
+}();
+
+// The value of a hex digit, or -1.
+constexpr int hex_value(char c) noexcept {
+  return hex_table[static_cast<unsigned char>(c)];
+}
+
+// The end of the run of characters starting at `p` that may belong to an
+// address, the parsers below only look at this run.
+inline const char* scan(const char* p, const char* last, bool v6) noexcept {
+  while (p != last && ((*p >= '0' && *p <= '9') || *p == '.' ||
+                       (v6 && (*p == ':' || hex_value(*p) >= 0)))) {
+    ++p;
+  }
+  return p;
+}
+
+// Parse four dotted decimal octets at the beginning of [p, last) into four
+// bytes. Octets must not have leading zeros. Returns the end of the last
+// octet, or null if the text is malformed.
+constexpr const char* parse_v4_prefix(const char* p, const char* last,
+                                      unsigned char* out) noexcept {
+  for (int octet = 0; octet < 4; ++octet) {
+    if (octet != 0) {
+      if (p == last || *p != '.') {
+        return nullptr;
+      }
+      ++p;
+    }
+    if (p == last || static_cast<unsigned char>(*p - '0') > 9) {
+      return nullptr;
+    }
+    unsigned value = static_cast<unsigned>(*p++ - '0');
+    if (p != last && static_cast<unsigned char>(*p - '0') <= 9) {
+      if (value == 0) {
+        return nullptr;
+      }
+      value = value * 10 + static_cast<unsigned>(*p++ - '0');
+      if (p != last && static_cast<unsigned char>(*p - '0') <= 9) {
+        value = value * 10 + static_cast<unsigned>(*p++ - '0');
+        if (value > 255) {
+          return nullptr;
+        }
+      }
+    }
+    out[octet] = static_cast<unsigned char>(value);
+  }
+  return p;
+}
+
+// Parse the dotted decimal text [p, last) into four bytes. Returns false if
+// the text is malformed.
+constexpr bool parse_v4(const char* p, const char* last,
+                        unsigned char* out) noexcept {
+  return parse_v4_prefix(p, last, out) == last;
+}
+
+// Parse an IPv6 address at the beginning of [p, last) into sixteen bytes.
+// Returns the end of the address, or null if the text is malformed.
+constexpr const char* parse_v6_prefix(const char* p, const char* last,
+                                      unsigned char* out) noexcept {
+  unsigned char bytes[16]{};
+  int count = 0;
+  int gap = -1;
+  if (p != last && *p == ':') {
+    if (last - p < 2 || p[1] != ':') {
+      return nullptr;
+    }
+    p += 2;
+    gap = 0;
+  }
+  while (p != last) {
+    const char* start = p;
+    unsigned value = 0;
+    int digits = 0;
+    for (int v; p != last && digits < 5 && (v = hex_value(*p)) >= 0; ++p) {
+      value = value * 16 + static_cast<unsigned>(v);
+      ++digits;
+    }
+    if (p != last && *p == '.') {
+      // The address ends with an IPv4 address.
+      if (count > 12 ||
+          (p = parse_v4_prefix(start, last, bytes + count)) == nullptr) {
+        return nullptr;
+      }
+      count += 4;
+      break;
+    }
+    if (digits == 0) {
+      // Nothing follows a "::".
+      if (gap == count && p == start) {
+        break;
+      }
+      return nullptr;
+    }
+    if (digits > 4 || count == 16) {
+      return nullptr;
+    }
+    bytes[count++] = static_cast<unsigned char>(value >> 8);
+    bytes[count++] = static_cast<unsigned char>(value);
+    if (p == last || *p != ':') {
+      break;
+    }
+    ++p;
+    if (p != last && *p == ':') {
+      if (gap != -1) {
+        return nullptr;
+      }
+      gap = count;
+      ++p;
+    } else if (p == last || hex_value(*p) < 0) {
+      return nullptr;
+    }
+  }
+  if (gap != -1) {
+    if (count == 16) {
+      return nullptr;
+    }
+    int tail = count - gap;
+    for (int i = 0; i < tail; ++i) {
+      bytes[15 - i] = bytes[count - 1 - i];
+      bytes[count - 1 - i] = 0;
+    }
+  } else if (count != 16) {
+    return nullptr;
+  }
+  for (int i = 0; i < 16; ++i) {
+    out[i] = bytes[i];
+  }
+  return p;
+}
+
+// Parse the IPv6 text [p, last) into sixteen bytes. Returns false if the
+// text is malformed.
+constexpr bool parse_v6(const char* p, const char* last,
+                        unsigned char* out) noexcept {
+  return parse_v6_prefix(p, last, out) == last;
+}
+}  // namespace net::ip::__chars
+
+#endif  // IP_ADDRESS_CHARS_HPP_
@@ -0,0 +1,288 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef IP_ADDRESS_CLASSIFIER_HPP_
+#define IP_ADDRESS_CLASSIFIER_HPP_
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "ip/address_v4.hpp"
+#include "ip/address_v6.hpp"
+#include "ip/network_v4.hpp"
+#include "ip/network_v6.hpp"
+
+namespace net {
+namespace ip {
+// Classifies batches of addresses, e.g. the sources of the datagrams of one
+// recvmmsg, for ingress filtering. Every address gets a byte of class flags:
+// the special purpose ranges below, and whether it's in one of a small set
+// of listed networks.
+//
+// Every class is a masked compare, so IPv4 addresses are classified 8 at a
+// time with AVX2, or 4 at a time with SSE2, and an IPv6 address with a few
+// 128-bit compares. The instruction set is picked at compile time, e.g.
+// -mavx2, with a scalar fallback elsewhere. IPv4-mapped IPv6 addresses are
+// classified as their IPv4 address.
+class address_classifier {
+ public:
+  // 127.0.0.0/8 and ::1.
+  static constexpr std::uint8_t loopback = 0x01;
+
+  // The private networks of RFC 1918 and the unique local fc00::/7.
+  static constexpr std::uint8_t private_network = 0x02;
+
+  // 224.0.0.0/4 and ff00::/8.
+  static constexpr std::uint8_t multicast = 0x04;
+
+  // 0.0.0.0 and ::.
+  static constexpr std::uint8_t unspecified = 0x08;
+
+  // 169.254.0.0/16 and fe80::/10.
+  static constexpr std::uint8_t link_local = 0x10;
+
+  // In one of the inserted networks.
+  static constexpr std::uint8_t listed = 0x20;
+
+  // The maximum count of inserted networks of each family.
+  static constexpr std::size_t max_networks = 16;
+
+  // Constructor, no listed network.
+  address_classifier() noexcept : v4_count_(0), v6_count_(0) {
+    add_v4(0x7f000000, 8, loopback);
+    add_v4(0x0a000000, 8, private_network);
+    add_v4(0xac100000, 12, private_network);
+    add_v4(0xc0a80000, 16, private_network);
+    add_v4(0xe0000000, 4, multicast);
+    add_v4(0x00000000, 32, unspecified);
+    add_v4(0xa9fe0000, 16, link_local);
+    add_v6(address_v6::loopback().to_bytes(), 128, loopback);
+    add_v6(address_v6::bytes_type{0xfc}, 7, private_network);
+    add_v6(address_v6::bytes_type{0xff}, 8, multicast);
+    add_v6(address_v6::bytes_type{}, 128, unspecified);
+    add_v6(address_v6::bytes_type{0xfe, 0x80}, 10, link_local);
+  }
+
+  // Add `net` to the listed networks. Returns false if there are already
+  // `max_networks` of its family.
+  bool insert(const network_v4& net) noexcept {
+    if (v4_count_ == builtin_v4 + max_networks) {
+      return false;
+    }
+    add_v4(net.network().to_uint(), net.prefix_length(), listed);
+    return true;
+  }
+
+  // Add `net` to the listed networks. Returns false if there are already
+  // `max_networks` of its family.
+  bool insert(const network_v6& net) noexcept {
+    if (v6_count_ == builtin_v6 + max_networks) {
+      return false;
+    }
+    add_v6(net.network().to_bytes(), net.prefix_length(), listed);
+    return true;
+  }
+
+  // The class flags of `addr`.
+  std::uint8_t classify(const address_v4& addr) const noexcept {
+    return classify_v4(std::bit_cast<std::uint32_t>(addr.to_bytes()));
+  }
+
+  // The class flags of `addr`.
+  std::uint8_t classify(const address_v6& addr) const noexcept {
+    const address_v6::bytes_type bytes = addr.to_bytes();
+#if defined(__SSE2__)
+    const __m128i value =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes.data()));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(value, mapped_mask()),
+                                         mapped_prefix())) == 0xffff) {
+      return classify_v4(load_v4(bytes.data() + 12));
+    }
+    std::uint8_t classes = 0;
+    for (std::size_t i = 0; i < v6_count_; ++i) {
+      const __m128i masked = _mm_and_si128(
+          value,
+          _mm_load_si128(reinterpret_cast<const __m128i*>(v6_[i].mask)));
+      const __m128i eq = _mm_cmpeq_epi8(
+          masked,
+          _mm_load_si128(reinterpret_cast<const __m128i*>(v6_[i].prefix)));
+      if (_mm_movemask_epi8(eq) == 0xffff) {
+        classes |= v6_[i].flag;
+      }
+    }
+    return classes;
+#else
+    if (addr.is_v4_mapped()) {
+      return classify_v4(load_v4(bytes.data() + 12));
+    }
+    std::uint8_t classes = 0;
+    for (std::size_t i = 0; i < v6_count_; ++i) {
+      bool match = true;
+      for (std::size_t j = 0; j < 16; ++j) {
+        match &= (bytes[j] & v6_[i].mask[j]) == v6_[i].prefix[j];
+      }
+      classes |= match ? v6_[i].flag : 0;
+    }
+    return classes;
+#endif
+  }
+
+  // Store the class flags of `count` addresses into `classes`.
+  void classify(const address_v4* addrs, std::size_t count,
+                std::uint8_t* classes) const noexcept {
+    static_assert(sizeof(address_v4) == sizeof(std::uint32_t));
+    std::size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= count; i += 8) {
+      const __m256i value =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(addrs + i));
+      __m256i flags = _mm256_setzero_si256();
+      for (std::size_t r = 0; r < v4_count_; ++r) {
+        const __m256i eq = _mm256_cmpeq_epi32(
+            _mm256_and_si256(value, _mm256_set1_epi32(v4_[r].mask)),
+            _mm256_set1_epi32(v4_[r].prefix));
+        flags = _mm256_or_si256(
+            flags, _mm256_and_si256(eq, _mm256_set1_epi32(v4_[r].flag)));
+      }
+      // Narrow the 32-bit flags to bytes, 4 in each 128-bit lane.
+      const __m256i bytes = _mm256_packus_epi16(
+          _mm256_packs_epi32(flags, flags), _mm256_setzero_si256());
+      const std::uint32_t low =
+          static_cast<std::uint32_t>(_mm256_extract_epi32(bytes, 0));
+      const std::uint32_t high =
+          static_cast<std::uint32_t>(_mm256_extract_epi32(bytes, 4));
+      std::memcpy(classes + i, &low, 4);
+      std::memcpy(classes + i + 4, &high, 4);
+    }
+#endif
+#if defined(__SSE2__)
+    for (; i + 4 <= count; i += 4) {
+      const __m128i value =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(addrs + i));
+      __m128i flags = _mm_setzero_si128();
+      for (std::size_t r = 0; r < v4_count_; ++r) {
+        const __m128i eq = _mm_cmpeq_epi32(
+            _mm_and_si128(value, _mm_set1_epi32(v4_[r].mask)),
+            _mm_set1_epi32(v4_[r].prefix));
+        flags =
+            _mm_or_si128(flags, _mm_and_si128(eq, _mm_set1_epi32(v4_[r].flag)));
+      }
+      const __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(flags, flags),
+                                             _mm_setzero_si128());
+      const std::uint32_t packed =
+          static_cast<std::uint32_t>(_mm_cvtsi128_si32(bytes));
+      std::memcpy(classes + i, &packed, 4);
+    }
+#endif
+    for (; i < count; ++i) {
+      classes[i] = classify(addrs[i]);
+    }
+  }
+
+  // Store the class flags of `count` addresses into `classes`.
+  void classify(const address_v6* addrs, std::size_t count,
+                std::uint8_t* classes) const noexcept {
+    for (std::size_t i = 0; i < count; ++i) {
+      classes[i] = classify(addrs[i]);
+    }
+  }
+
+ private:
+  // The count of special purpose ranges of each family.
+  static constexpr std::size_t builtin_v4 = 7;
+  static constexpr std::size_t builtin_v6 = 5;
+
+  // A masked compare of an IPv4 address in network order, loaded as a
+  // native integer.
+  struct rule_v4 {
+    std::int32_t mask;
+    std::int32_t prefix;
+    std::int32_t flag;
+  };
+
+  // A masked compare of the bytes of an IPv6 address.
+  struct rule_v6 {
+    alignas(16) std::uint8_t mask[16];
+    alignas(16) std::uint8_t prefix[16];
+    std::uint8_t flag;
+  };
+
+  static std::uint32_t load_v4(const unsigned char* bytes) noexcept {
+    std::uint32_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+  }
+
+  // `value` is the address in network order loaded as a native integer.
+  std::uint8_t classify_v4(std::uint32_t value) const noexcept {
+    std::uint8_t classes = 0;
+    for (std::size_t r = 0; r < v4_count_; ++r) {
+      const auto mask = static_cast<std::uint32_t>(v4_[r].mask);
+      const auto prefix = static_cast<std::uint32_t>(v4_[r].prefix);
+      classes |= (value & mask) == prefix ? v4_[r].flag : 0;
+    }
+    return classes;
+  }
+
+  // Add the IPv4 network `prefix`/`length`, given in host order.
+  void add_v4(std::uint32_t prefix, int length, std::uint8_t flag) noexcept {
+    const std::uint32_t mask =
+        length == 0 ? 0 : ~std::uint32_t{0} << (32 - length);
+    auto native = [](std::uint32_t host) noexcept {
+      return std::bit_cast<std::int32_t>(address_v4{host}.to_bytes());
+    };
+    v4_[v4_count_++] = {native(mask), native(prefix & mask), flag};
+  }
+
+  void add_v6(const address_v6::bytes_type& prefix, int length,
+              std::uint8_t flag) noexcept {
+    rule_v6& rule = v6_[v6_count_++];
+    for (int i = 0; i < 16; ++i) {
+      const int bits = std::min(std::max(length - i * 8, 0), 8);
+      rule.mask[i] = static_cast<std::uint8_t>(0xff00 >> bits);
+      rule.prefix[i] = prefix[i] & rule.mask[i];
+    }
+    rule.flag = flag;
+  }
+
+#if defined(__SSE2__)
+  // ::ffff:0:0/96.
+  static __m128i mapped_mask() noexcept {
+    return _mm_setr_epi32(-1, -1, -1, 0);
+  }
+
+  static __m128i mapped_prefix() noexcept {
+    return _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1, -1, 0, 0, 0, 0);
+  }
+#endif
+
+  std::array<rule_v4, builtin_v4 + max_networks> v4_;
+  std::size_t v4_count_;
+  std::array<rule_v6, builtin_v6 + max_networks> v6_;
+  std::size_t v6_count_;
+};
+
+}  // namespace ip
+}  // namespace net
+
+#endif  // IP_ADDRESS_CLASSIFIER_HPP_
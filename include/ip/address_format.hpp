@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef IP_ADDRESS_FORMAT_HPP_
+#define IP_ADDRESS_FORMAT_HPP_
+
+#include <version>
+#if defined(__cpp_lib_format)
+#include <format>
+#endif
+
+#include "fmt/format.h"
+
+#include "ip/address.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/address_v6.hpp"
+
+namespace net::ip::__chars {
+// Formats an address by writing it to a stack buffer with `to_chars` and
+// copying that to the output, so nothing is allocated. No format spec is
+// accepted, the library reports any as an error.
+template <typename Address>
+struct address_formatter {
+  template <typename ParseContext>
+  constexpr auto parse(ParseContext& ctx) {
+    return ctx.begin();
+  }
+
+  template <typename FormatContext>
+  auto format(const Address& addr, FormatContext& ctx) const {
+    char text[Address::max_chars];
+    const char* end = addr.to_chars(text, text + sizeof(text)).ptr;
+    auto out = ctx.out();
+    for (const char* p = text; p != end; ++p) {
+      *out++ = *p;
+    }
+    return out;
+  }
+};
+}  // namespace net::ip::__chars
+
+template <>
+struct fmt::formatter<net::ip::address_v4>
+    : net::ip::__chars::address_formatter<net::ip::address_v4> {};
+
+template <>
+struct fmt::formatter<net::ip::address_v6>
+    : net::ip::__chars::address_formatter<net::ip::address_v6> {};
+
+template <>
+struct fmt::formatter<net::ip::address>
+    : net::ip::__chars::address_formatter<net::ip::address> {};
+
+#if defined(__cpp_lib_format)
+template <>
+struct std::formatter<net::ip::address_v4>
+    : net::ip::__chars::address_formatter<net::ip::address_v4> {};
+
+template <>
+struct std::formatter<net::ip::address_v6>
+    : net::ip::__chars::address_formatter<net::ip::address_v6> {};
+
+template <>
+struct std::formatter<net::ip::address>
+    : net::ip::__chars::address_formatter<net::ip::address> {};
+#endif
+
+#endif  // IP_ADDRESS_FORMAT_HPP_
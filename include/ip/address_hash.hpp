@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef IP_ADDRESS_HASH_HPP_
+#define IP_ADDRESS_HASH_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace net::ip::__hash {
+// Hashing of IP addresses in the style of wyhash: the key is folded into two
+// 64-bit words which are multiplied into a 128-bit product, and the halves of
+// the product are xor-ed. Every input bit reaches every output bit, so the
+// low bits used by power-of-two tables stay well distributed even for keys
+// that differ only in a few bits, like the hosts of one IPv6 /64.
+
+inline constexpr std::uint64_t secret[4] = {
+    0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull,
+    0x589965cc75374cc3ull};
+
+// Multiply `a` and `b` and fold the 128-bit product into 64 bits.
+constexpr std::uint64_t mum(std::uint64_t a, std::uint64_t b) noexcept {
+  const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+  return static_cast<std::uint64_t>(product) ^
+         static_cast<std::uint64_t>(product >> 64);
+}
+
+// Hash an IPv4 address given as an integer. `seed` carries anything else
+// that is part of the key, such as a port.
+constexpr std::size_t hash_v4(std::uint32_t addr, std::uint64_t seed) noexcept {
+  const std::uint64_t a = (static_cast<std::uint64_t>(addr) << 32) | addr;
+  return static_cast<std::size_t>(
+      mum(secret[1] ^ 4, mum(a ^ secret[1], seed ^ secret[0])));
+}
+
+// Hash the sixteen bytes of an IPv6 address. `seed` carries anything else
+// that is part of the key, such as the scope ID and a port.
+inline std::size_t hash_v6(const unsigned char* bytes,
+                           std::uint64_t seed) noexcept {
+  std::uint64_t a;
+  std::uint64_t b;
+  std::memcpy(&a, bytes, sizeof(a));
+  std::memcpy(&b, bytes + 8, sizeof(b));
+  return static_cast<std::size_t>(
+      mum(secret[1] ^ 16, mum(a ^ secret[1], b ^ seed ^ secret[0])));
+}
+}  // namespace net::ip::__hash
+
+#endif  // IP_ADDRESS_HASH_HPP_
@@ -19,9 +19,14 @@
 #include <arpa/inet.h>
 
 #include <array>
+#include <charconv>
 #include <cstring>
 #include <string>
+#include <string_view>
+#include <system_error>  // NOLINT
 
+#include "ip/address_chars.hpp"
+#include "ip/address_hash.hpp"
 #include "ip/socket_types.hpp"
 #include "utils.hpp"
 
@@ -86,14 +91,26 @@ class address_v4 {
     }
   }
 
+  // The length of the longest text form, "255.255.255.255".
+  static constexpr std::size_t max_chars = 15;
+
+  // Write the address in dotted decimal form to [first, last), without a
+  // terminating null. Fails with `std::errc::value_too_large` if it doesn't
+  // fit.
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    char text[max_chars + 1];
+    const std::size_t size =
+        static_cast<std::size_t>(__chars::write_v4(text, bytes_.data()) - text);
+    if (static_cast<std::size_t>(last - first) < size) {
+      return {last, std::errc::value_too_large};
+    }
+    std::memcpy(first, text, size);
+    return {first + size, std::errc{}};
+  }
+
   std::string to_string() const {
-    char src[max_address_v4_string_len];
-    ::snprintf(src, sizeof(src), "%d.%d.%d.%d",
-               static_cast<int>(bytes_[0]),  //
-               static_cast<int>(bytes_[1]),  //
-               static_cast<int>(bytes_[2]),  //
-               static_cast<int>(bytes_[3]));
-    return src;
+    char text[max_chars + 1];
+    return std::string(text, to_chars(text, text + max_chars).ptr);
   }
 
   // Determine whether the address is a loopback address. which corresponds to
@@ -160,22 +177,38 @@ inline constexpr address_v4 make_address_v4(
   return address_v4(addr);
 }
 
-// Create an IPv4 address from an IP address string in dotted decimal form.
-// Bytes is in network order.
-inline address_v4 make_address_v4(const char* addr) noexcept {
+// Parse an IPv4 address in dotted decimal form from the characters at the
+// beginning of [first, last) which may belong to one. On success `ptr` points
+// past them, otherwise `addr` is unchanged and `ec` is
+// `std::errc::invalid_argument`.
+inline std::from_chars_result from_chars(const char* first, const char* last,
+                                         address_v4& addr) noexcept {
   address_v4::bytes_type bytes;
-  return ::inet_pton(AF_INET, addr, &bytes[0]) > 0 ? address_v4(bytes)
-                                                   : address_v4{};
+  const char* end = __chars::parse_v4_prefix(first, last, bytes.data());
+  if (end == nullptr || __chars::scan(end, last, false) != end) {
+    return {first, std::errc::invalid_argument};
+  }
+  addr = address_v4(bytes);
+  return {end, std::errc{}};
 }
 
 // Create an IPv4 address from an IP address string in dotted decimal form.
-inline address_v4 make_address_v4(const std::string& str) noexcept {
-  return make_address_v4(str.c_str());
+inline address_v4 make_address_v4(std::string_view str) noexcept {
+  address_v4 addr;
+  auto [ptr, ec] = from_chars(str.data(), str.data() + str.size(), addr);
+  return ec == std::errc{} && ptr == str.data() + str.size() ? addr
+                                                              : address_v4{};
 }
 
 // Create an IPv4 address from an IP address string in dotted decimal form.
-inline address_v4 make_address_v4(std::string_view str) noexcept {
-  return make_address_v4(static_cast<std::string>(str));
+// Bytes is in network order.
+inline address_v4 make_address_v4(const char* addr) noexcept {
+  return make_address_v4(std::string_view{addr});
+}
+
+// Create an IPv4 address from an IP address string in dotted decimal form.
+inline address_v4 make_address_v4(const std::string& str) noexcept {
+  return make_address_v4(std::string_view{str});
 }
 
 };  // namespace ip
@@ -184,8 +217,8 @@ inline address_v4 make_address_v4(std::string_view str) noexcept {
 template <>
 struct std::hash<net::ip::address_v4> {
   std::size_t operator()(const net::ip::address_v4& addr) const noexcept {
-    return std::hash<unsigned int>()(addr.to_uint());
-  };
+    return net::ip::__hash::hash_v4(addr.to_uint(), 0);
+  }
 };
 
 #endif  // IP_ADDRESS_V4_HPP_
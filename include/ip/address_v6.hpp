@@ -19,8 +19,14 @@
 #include <arpa/inet.h>
 
 #include <array>
+#include <charconv>
+#include <cstring>
 #include <string>
+#include <string_view>
+#include <system_error>  // NOLINT
 
+#include "ip/address_chars.hpp"
+#include "ip/address_hash.hpp"
 #include "ip/address_v4.hpp"
 #include "ip/socket_types.hpp"
 #include "utils.hpp"
@@ -83,13 +89,28 @@ class address_v6 {
         address_v4::bytes_type{bytes_[12], bytes_[13], bytes_[14], bytes_[15]});
   }
 
+  // The length of the longest text form,
+  // "ffff:ffff:ffff:ffff:ffff:ffff:255.255.255.255".
+  static constexpr std::size_t max_chars = 45;
+
+  // Write the address in the form of RFC 5952 to [first, last), without the
+  // scope ID and a terminating null. Fails with `std::errc::value_too_large`
+  // if it doesn't fit.
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    char text[max_chars + 3];
+    const std::size_t size =
+        static_cast<std::size_t>(__chars::write_v6(text, bytes_.data()) - text);
+    if (static_cast<std::size_t>(last - first) < size) {
+      return {last, std::errc::value_too_large};
+    }
+    std::memcpy(first, text, size);
+    return {first + size, std::errc{}};
+  }
+
   // Get the address as a string.
   std::string to_string() const noexcept {
-    char addr_str[max_address_v6_string_len];
-    ::in6_addr src = std::bit_cast<in6_addr>(bytes_);
-    const char* addr =
-        ::inet_ntop(AF_INET6, &src, addr_str, max_address_v6_string_len);
-    return addr ? addr : std::string{};
+    char text[max_chars];
+    return std::string(text, to_chars(text, text + max_chars).ptr);
   }
 
   // Determine whether the address is a loopback address.
@@ -204,54 +225,63 @@ inline constexpr address_v6 make_address_v6(const address_v6::bytes_type& bytes,
   return address_v6(bytes, scope_id);
 }
 
-// Create an IPv6 address from an IP address string.
-inline address_v6 make_address_v6(const char* str) noexcept {
-  const char* if_name = ::strchr(str, '%');
-  const char* p = str;
-  char addr_buf[max_address_v6_string_len]{};
-
-  if (if_name) {
-    // Too long, just return unspecified.
-    if (if_name - str > max_address_v6_string_len) {
-      return address_v6{};
-    }
+// Parse an IPv6 address from the characters at the beginning of
+// [first, last) which may belong to one. A scope ID isn't parsed. On success
+// `ptr` points past them, otherwise `addr` is unchanged and `ec` is
+// `std::errc::invalid_argument`.
+inline std::from_chars_result from_chars(const char* first, const char* last,
+                                         address_v6& addr) noexcept {
+  address_v6::bytes_type bytes;
+  const char* end = __chars::parse_v6_prefix(first, last, bytes.data());
+  if (end == nullptr || __chars::scan(end, last, true) != end) {
+    return {first, std::errc::invalid_argument};
+  }
+  addr = address_v6(bytes);
+  return {end, std::errc{}};
+}
 
-    // Split.
-    ::memcpy(addr_buf, str, if_name - str);
-    addr_buf[if_name - str] = '\0';
-    p = addr_buf;
+// Create an IPv6 address from an IP address string, optionally followed by
+// "%" and a scope ID or the name of a network interface.
+inline address_v6 make_address_v6(std::string_view str) noexcept {
+  const char* last = str.data() + str.size();
+  address_v6 addr;
+  auto [ptr, ec] = from_chars(str.data(), last, addr);
+  if (ec != std::errc{}) {
+    return address_v6{};
+  }
+  if (ptr == last) {
+    return addr;
+  }
+  if (*ptr != '%') {
+    return address_v6{};
   }
 
-  ::in6_addr addr;
-  if (::inet_pton(AF_INET6, p, &addr) > 0) {
-    scope_id_type scope_id = 0;
-
-    // Get scope id by network interface name.
-    if (if_name) {
-      bool is_link_local =
-          addr.s6_addr[0] == 0xfe && ((addr.s6_addr[1] & 0xc0) == 0x80);
-      bool is_multicast_link_local =
-          addr.s6_addr[0] == 0xff && addr.s6_addr[1] == 0x02;
-      if (is_link_local || is_multicast_link_local) {
-        scope_id = if_nametoindex(if_name + 1);
-      }
-      if (scope_id == 0) {
-        scope_id = atoi(if_name + 1);
-      }
+  // Get scope id by network interface name.
+  std::string_view name{ptr + 1, static_cast<std::size_t>(last - ptr - 1)};
+  scope_id_type scope_id = 0;
+  if (addr.is_link_local() || addr.is_multicast_link_local()) {
+    char if_name[IF_NAMESIZE];
+    if (name.size() < sizeof(if_name)) {
+      std::memcpy(if_name, name.data(), name.size());
+      if_name[name.size()] = '\0';
+      scope_id = ::if_nametoindex(if_name);
     }
-    return address_v6{std::bit_cast<address_v6::bytes_type>(addr), scope_id};
   }
-  return address_v6{};
+  if (scope_id == 0) {
+    std::from_chars(name.data(), name.data() + name.size(), scope_id);
+  }
+  addr.scope_id(scope_id);
+  return addr;
 }
 
-// Create IPv6 address from an IP address string.
-inline address_v6 make_address_v6(const std::string& str) noexcept {
-  return make_address_v6(str.c_str());
+// Create an IPv6 address from an IP address string.
+inline address_v6 make_address_v6(const char* str) noexcept {
+  return make_address_v6(std::string_view{str});
 }
 
-// Create an IPv6 address from an IP address string.
-inline address_v6 make_address_v6(std::string_view str) noexcept {
-  return make_address_v6(static_cast<std::string>(str));
+// Create IPv6 address from an IP address string.
+inline address_v6 make_address_v6(const std::string& str) noexcept {
+  return make_address_v6(std::string_view{str});
 }
 
 // Tag type used for distinguishing overloads that deal in IPv4-mapped IPv6
@@ -284,22 +314,7 @@ inline address_v6 make_address_v6(v4_mapped_t, const address_v4& v4_addr) {
 template <>
 struct std::hash<net::ip::address_v6> {
   std::size_t operator()(const net::ip::address_v6& addr) const noexcept {
-    const net::ip::address_v6::bytes_type bytes = addr.to_bytes();
-    std::size_t result = static_cast<std::size_t>(addr.scope_id());
-    combine_4_bytes(result, &bytes[0]);
-    combine_4_bytes(result, &bytes[4]);
-    combine_4_bytes(result, &bytes[8]);
-    combine_4_bytes(result, &bytes[12]);
-    return result;
-  }
-
- private:
-  static void combine_4_bytes(std::size_t& seed, const unsigned char* bytes) {
-    const std::size_t bytes_hash = (static_cast<std::size_t>(bytes[0]) << 24) |
-                                   (static_cast<std::size_t>(bytes[1]) << 16) |
-                                   (static_cast<std::size_t>(bytes[2]) << 8) |
-                                   (static_cast<std::size_t>(bytes[3]));
-    seed ^= bytes_hash + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    return net::ip::__hash::hash_v6(addr.to_bytes().data(), addr.scope_id());
   }
 };
 
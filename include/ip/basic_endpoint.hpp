@@ -16,11 +16,23 @@
 #ifndef IP_BASIC_ENDPOINT_HPP_
 #define IP_BASIC_ENDPOINT_HPP_
 
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <bit>       // NOLINT
+#include <compare>   // NOLINT
+#include <cstdint>
+#include <cstring>
+
 #include "ip/address.hpp"
+#include "ip/address_hash.hpp"
+#include "utils.hpp"
 
 namespace net {
 namespace ip {
-// Describes an endpoint for a version-independent IP socket.
+// Describes an endpoint for a version-independent IP socket. The endpoint is
+// kept in its native form, so the kernel can write a source address straight
+// into data() and nothing has to be converted until it is inspected.
 template <typename InternetProtocol>
 class basic_endpoint {
  public:
@@ -28,117 +40,221 @@ class basic_endpoint {
   using protocol_type = InternetProtocol;
 
   // Default constructor.
-  constexpr basic_endpoint() noexcept
-      : protocol_{protocol_type::v6()}, address_{}, port_{0} {}
+  basic_endpoint() noexcept : data_{} { data_.v6.sin6_family = AF_INET6; }
 
   // Construct an endpoint using a port number, specified in the host's byte
   // order. The IP address will be the any address (INADDR_ANY or in6addr_any)
   // which IP version associated with given protocol. This constructor would
   // typically be used for accepting new connections.
-  constexpr basic_endpoint(const protocol_type& internet_protocol,
-                           port_type port) noexcept
-      : protocol_(internet_protocol), address_(), port_(port) {
+  basic_endpoint(const protocol_type& internet_protocol,
+                 port_type port) noexcept
+      : data_{} {
     if (internet_protocol.family() == AF_INET) {
-      address_ = address_v4{};
+      data_.v4.sin_family = AF_INET;
+    } else {
+      data_.v6.sin6_family = AF_INET6;
     }
+    set_port(port);
   }
 
   // Construct an endpoint using a port number and an IP address.
   // This constructor may be used for accepting connections on a specific
   // interface or for making a connection to a remote endpoint.
-  constexpr basic_endpoint(const address& addr, port_type port) noexcept
-      : protocol_(addr.is_v4() ? protocol_type::v4() : protocol_type::v6()),
-        address_(addr),
-        port_(port) {}
+  basic_endpoint(const address& addr, port_type port) noexcept : data_{} {
+    set_address(addr);
+    set_port(port);
+  }
 
   // Construct an endpoint using a port number and an IP address v4.
-  constexpr basic_endpoint(const address_v4& addr_v4, port_type port) noexcept
-      : protocol_(protocol_type::v4()), address_(addr_v4), port_(port) {}
+  basic_endpoint(const address_v4& addr_v4, port_type port) noexcept
+      : data_{} {
+    set_address_v4(addr_v4);
+    set_port(port);
+  }
 
   // Construct an endpoint using a port number and an IP address v6.
-  constexpr basic_endpoint(const address_v6& addr_v6, port_type port) noexcept
-      : protocol_(protocol_type::v6()), address_(addr_v6), port_(port) {}
+  basic_endpoint(const address_v6& addr_v6, port_type port) noexcept
+      : data_{} {
+    set_address_v6(addr_v6);
+    set_port(port);
+  }
 
   // Set the IPv4 address using native type. This will also set protocol and
   // port. Note the port and address of native_addr is always net work order.
-  explicit constexpr basic_endpoint(const ::sockaddr_in& native_addr)
-      : protocol_(protocol_type::v4()) {
-    if constexpr (std::endian::native == std::endian::little) {
-      port_ = utils::byteswap(native_addr.sin_port);
-      address_ = address_v4(utils::byteswap(native_addr.sin_addr.s_addr));
-    } else {
-      port_ = native_addr.sin_port;
-      address_ = address_v4(native_addr.sin_addr.s_addr);
-    }
+  explicit basic_endpoint(const ::sockaddr_in& native_addr) noexcept
+      : data_{} {
+    data_.v4 = native_addr;
   }
 
   // Set the IPv6 address using native type. This will also set protocol and
   // port.
-  explicit constexpr basic_endpoint(const ::sockaddr_in6& native_addr)
-      : protocol_(protocol_type::v6()),
-        address_(address_v6(std::bit_cast<address_v6::bytes_type>(
-                                native_addr.sin6_addr.s6_addr),
-                            native_addr.sin6_scope_id)) {
-    if constexpr (std::endian::native == std::endian::little) {
-      port_ = utils::byteswap(native_addr.sin6_port);
-    } else {
-      port_ = native_addr.sin6_port;
-    }
+  explicit basic_endpoint(const ::sockaddr_in6& native_addr) noexcept
+      : data_{} {
+    data_.v6 = native_addr;
   }
 
   // Copy constructor.
-  constexpr basic_endpoint(const basic_endpoint& other) noexcept = default;
+  basic_endpoint(const basic_endpoint& other) noexcept = default;
 
   // Move constructor.
-  constexpr basic_endpoint(basic_endpoint&& other) noexcept = default;
+  basic_endpoint(basic_endpoint&& other) noexcept = default;
 
   // Assign from another endpoint.
-  constexpr basic_endpoint& operator=(const basic_endpoint& other) noexcept =
-      default;
+  basic_endpoint& operator=(const basic_endpoint& other) noexcept = default;
 
   // Move-assign from another endpoint.
-  constexpr basic_endpoint& operator=(basic_endpoint&& other) noexcept =
-      default;
+  basic_endpoint& operator=(basic_endpoint&& other) noexcept = default;
 
   // The protocol associated with the endpoint.
-  constexpr protocol_type protocol() const noexcept { return protocol_; }
+  protocol_type protocol() const noexcept {
+    return is_v4() ? protocol_type::v4() : protocol_type::v6();
+  }
 
   // Get the port associated with the endpoint. The port is always in the host's
   // byte order.
-  constexpr port_type port() const noexcept { return port_; }
+  port_type port() const noexcept {
+    return to_host(is_v4() ? data_.v4.sin_port : data_.v6.sin6_port);
+  }
 
   // Set the port associated with the endpoint. The port is always in the host's
   // byte order.
-  constexpr void set_port(port_type port) noexcept { port_ = port; }
+  void set_port(port_type port) noexcept {
+    if (is_v4()) {
+      data_.v4.sin_port = to_host(port);
+    } else {
+      data_.v6.sin6_port = to_host(port);
+    }
+  }
 
   // Get the IP address associated with the endpoint.
-  constexpr class address address() const noexcept { return address_; }
+  class address address() const noexcept {
+    if (is_v4()) {
+      return ip::address(address_v4(to_host(data_.v4.sin_addr.s_addr)));
+    }
+    return ip::address(address_v6(
+        std::bit_cast<address_v6::bytes_type>(data_.v6.sin6_addr.s6_addr),
+        static_cast<scope_id_type>(data_.v6.sin6_scope_id)));
+  }
 
-  // Set the IP address associated with the endpoint.
-  constexpr void set_address(const class address& addr) noexcept {
-    address_ = addr;
+  // Set the IP address associated with the endpoint. The port is kept.
+  void set_address(const class address& addr) noexcept {
+    if (addr.is_v4()) {
+      set_address_v4(addr.to_v4());
+    } else {
+      set_address_v6(addr.to_v6());
+    }
   }
 
   // Get the address in the native type.
-  ::socklen_t native_address(::sockaddr_storage* storage) const {
-    return address_.native_address(storage, port_);
+  ::socklen_t native_address(::sockaddr_storage* storage) const noexcept {
+    std::memcpy(storage, &data_, size());
+    return size();
+  }
+
+  // The native address, which a system call may also write to, with up to
+  // capacity() bytes.
+  ::sockaddr* data() noexcept { return &data_.base; }
+
+  // The native address.
+  const ::sockaddr* data() const noexcept { return &data_.base; }
+
+  // The size of the native address.
+  ::socklen_t size() const noexcept {
+    return is_v4() ? sizeof(::sockaddr_in) : sizeof(::sockaddr_in6);
+  }
+
+  // The size of the storage behind data().
+  static constexpr ::socklen_t capacity() noexcept { return sizeof(data_); }
+
+  // Whether the native address belongs to a supported family. It may not
+  // after a system call wrote to data().
+  bool is_valid() const noexcept {
+    return data_.base.sa_family == AF_INET ||
+           data_.base.sa_family == AF_INET6;
   }
 
   // Compare two endpoints for equality.
-  constexpr bool operator==(const basic_endpoint&) const noexcept = default;
+  friend bool operator==(const basic_endpoint& a,
+                         const basic_endpoint& b) noexcept {
+    if (a.data_.base.sa_family != b.data_.base.sa_family) {
+      return false;
+    }
+    if (a.is_v4()) {
+      return a.data_.v4.sin_addr.s_addr == b.data_.v4.sin_addr.s_addr &&
+             a.data_.v4.sin_port == b.data_.v4.sin_port;
+    }
+    return std::memcmp(&a.data_.v6.sin6_addr, &b.data_.v6.sin6_addr,
+                       sizeof(::in6_addr)) == 0 &&
+           a.data_.v6.sin6_scope_id == b.data_.v6.sin6_scope_id &&
+           a.data_.v6.sin6_port == b.data_.v6.sin6_port;
+  }
 
-  // Compare endpoints for ordering.
-  constexpr auto operator<=>(const basic_endpoint&) const noexcept = default;
+  // Compare endpoints for ordering: IPv4 before IPv6, then by address, scope
+  // ID and port in host byte order.
+  friend std::strong_ordering operator<=>(const basic_endpoint& a,
+                                          const basic_endpoint& b) noexcept {
+    if (a.is_v4() != b.is_v4()) {
+      return a.is_v4() ? std::strong_ordering::less
+                       : std::strong_ordering::greater;
+    }
+    if (a.is_v4()) {
+      const std::uint32_t a_addr = to_host(a.data_.v4.sin_addr.s_addr);
+      const std::uint32_t b_addr = to_host(b.data_.v4.sin_addr.s_addr);
+      if (a_addr != b_addr) {
+        return a_addr <=> b_addr;
+      }
+    } else {
+      const int c = std::memcmp(&a.data_.v6.sin6_addr, &b.data_.v6.sin6_addr,
+                                sizeof(::in6_addr));
+      if (c != 0) {
+        return c <=> 0;
+      }
+      if (a.data_.v6.sin6_scope_id != b.data_.v6.sin6_scope_id) {
+        return a.data_.v6.sin6_scope_id <=> b.data_.v6.sin6_scope_id;
+      }
+    }
+    return a.port() <=> b.port();
+  }
 
  private:
-  // The associated protocol.
-  protocol_type protocol_;
+  friend struct std::hash<basic_endpoint>;
+
+  // Convert between network and host byte order.
+  template <std::integral T>
+  static constexpr T to_host(T value) noexcept {
+    if constexpr (std::endian::native == std::endian::little) {
+      return utils::byteswap(value);
+    } else {
+      return value;
+    }
+  }
 
-  // Version-independent address.
-  class address address_;
+  bool is_v4() const noexcept { return data_.base.sa_family == AF_INET; }
 
-  // Port number, specified in the host's byte order.
-  port_type port_;
+  void set_address_v4(const address_v4& addr) noexcept {
+    const ::in_port_t port = data_.v4.sin_port;
+    data_.v4 = ::sockaddr_in{};
+    data_.v4.sin_family = AF_INET;
+    data_.v4.sin_port = port;
+    data_.v4.sin_addr.s_addr = to_host(addr.to_uint());
+  }
+
+  void set_address_v6(const address_v6& addr) noexcept {
+    const ::in_port_t port = data_.v6.sin6_port;
+    const address_v6::bytes_type bytes = addr.to_bytes();
+    data_.v6 = ::sockaddr_in6{};
+    data_.v6.sin6_family = AF_INET6;
+    data_.v6.sin6_port = port;
+    std::memcpy(&data_.v6.sin6_addr, bytes.data(), bytes.size());
+    data_.v6.sin6_scope_id = addr.scope_id();
+  }
+
+  // The native address. The port sits at the same offset in both forms.
+  union {
+    ::sockaddr base;
+    ::sockaddr_in v4;
+    ::sockaddr_in6 v6;
+  } data_;
 };
 
 }  // namespace ip
@@ -150,9 +266,17 @@ template <typename InternetProtocol>
 struct hash<net::ip::basic_endpoint<InternetProtocol>> {
   std::size_t operator()(
       const net::ip::basic_endpoint<InternetProtocol>& ep) const noexcept {
-    std::size_t hash1 = std::hash<net::ip::address>()(ep.address());
-    std::size_t hash2 = std::hash<port_type>()(ep.port());
-    return hash1 ^ (hash2 + 0x9e3779b9 + (hash1 << 6) + (hash1 >> 2));
+    // The port is hashed together with the address, rather than combining
+    // two hashes, so that it costs no extra multiplication.
+    const std::uint64_t port = static_cast<std::uint64_t>(ep.port()) << 32;
+    if (ep.is_v4()) {
+      return net::ip::__hash::hash_v4(
+          net::ip::basic_endpoint<InternetProtocol>::to_host(
+              ep.data_.v4.sin_addr.s_addr),
+          port);
+    }
+    return net::ip::__hash::hash_v6(ep.data_.v6.sin6_addr.s6_addr,
+                                    port | ep.data_.v6.sin6_scope_id);
   }
 };
 
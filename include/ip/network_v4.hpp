@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef IP_NETWORK_V4_HPP_
+#define IP_NETWORK_V4_HPP_
+
+#include <cassert>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <system_error>  // NOLINT
+
+#include "ip/address_v4.hpp"
+
+namespace net {
+namespace ip {
+// An IPv4 network, an address and the length of its prefix, e.g.
+// 192.168.0.0/16. The address may have host bits set, `canonical` clears
+// them.
+class network_v4 {
+ public:
+  // Default constructor, 0.0.0.0/0.
+  constexpr network_v4() noexcept : address_(), prefix_length_(0) {}
+
+  // Construct a network from an address and a prefix length of at most 32.
+  constexpr network_v4(const address_v4& addr, int prefix_length) noexcept
+      : address_(addr), prefix_length_(prefix_length) {
+    assert(prefix_length >= 0 && prefix_length <= 32);
+  }
+
+  constexpr bool operator==(const network_v4&) const noexcept = default;
+
+  // The address the network was made of.
+  constexpr address_v4 address() const noexcept { return address_; }
+
+  // The length of the prefix.
+  constexpr int prefix_length() const noexcept { return prefix_length_; }
+
+  // The mask of the prefix.
+  constexpr address_v4 netmask() const noexcept { return address_v4(mask()); }
+
+  // The first address of the network.
+  constexpr address_v4 network() const noexcept {
+    return address_v4(address_.to_uint() & mask());
+  }
+
+  // The last address of the network.
+  constexpr address_v4 broadcast() const noexcept {
+    return address_v4(address_.to_uint() | ~mask());
+  }
+
+  // The network with the host bits of the address cleared.
+  constexpr network_v4 canonical() const noexcept {
+    return network_v4(network(), prefix_length_);
+  }
+
+  // Whether the network is a single address.
+  constexpr bool is_host() const noexcept { return prefix_length_ == 32; }
+
+  // Whether `addr` is in the network.
+  constexpr bool contains(const address_v4& addr) const noexcept {
+    return ((addr.to_uint() ^ address_.to_uint()) & mask()) == 0;
+  }
+
+  // Whether every address of `other` is in the network, including when
+  // both are the same.
+  constexpr bool is_subnet_of(const network_v4& other) const noexcept {
+    return prefix_length_ >= other.prefix_length_ &&
+           other.contains(address_);
+  }
+
+  // The length of the longest text form, "255.255.255.255/32".
+  static constexpr std::size_t max_chars = address_v4::max_chars + 3;
+
+  // Write the network as "address/prefix length" to [first, last), without
+  // a terminating null. Fails with `std::errc::value_too_large` if it
+  // doesn't fit.
+  std::to_chars_result to_chars(char* first, char* last) const noexcept {
+    char text[max_chars];
+    char* p = address_.to_chars(text, text + max_chars).ptr;
+    *p++ = '/';
+    p = std::to_chars(p, text + max_chars, prefix_length_).ptr;
+    const auto size = static_cast<std::size_t>(p - text);
+    if (static_cast<std::size_t>(last - first) < size) {
+      return {last, std::errc::value_too_large};
+    }
+    std::memcpy(first, text, size);
+    return {first + size, std::errc{}};
+  }
+
+  std::string to_string() const {
+    char text[max_chars];
+    return std::string(text, to_chars(text, text + max_chars).ptr);
+  }
+
+ private:
+  constexpr address_v4::uint_type mask() const noexcept {
+    return prefix_length_ == 0 ? 0 : ~address_v4::uint_type{0}
+                                         << (32 - prefix_length_);
+  }
+
+  address_v4 address_;
+  int prefix_length_;
+};
+
+// Create an IPv4 network from an address and a prefix length.
+inline constexpr network_v4 make_network_v4(const address_v4& addr,
+                                            int prefix_length) noexcept {
+  return network_v4(addr, prefix_length);
+}
+
+// Parse an IPv4 network in the form "address/prefix length" from the
+// characters at the beginning of [first, last). On success `ptr` points past
+// them, otherwise `net` is unchanged and `ec` is `std::errc::invalid_argument`.
+inline std::from_chars_result from_chars(const char* first, const char* last,
+                                         network_v4& net) noexcept {
+  address_v4 addr;
+  auto [p, ec] = from_chars(first, last, addr);
+  if (ec != std::errc{} || p == last || *p != '/' || p + 1 == last ||
+      p[1] < '0' || p[1] > '9' || (p[1] == '0' && p + 2 != last &&
+                                   p[2] >= '0' && p[2] <= '9')) {
+    return {first, std::errc::invalid_argument};
+  }
+  int prefix_length = 0;
+  auto length = std::from_chars(p + 1, last, prefix_length);
+  if (length.ec != std::errc{} || prefix_length > 32) {
+    return {first, std::errc::invalid_argument};
+  }
+  net = network_v4(addr, prefix_length);
+  return {length.ptr, std::errc{}};
+}
+
+// Create an IPv4 network from a string in the form "address/prefix length".
+// On failure `ec` is set and the result is 0.0.0.0/32, which matches no
+// peer.
+inline network_v4 make_network_v4(std::string_view str,
+                                  std::error_code& ec) noexcept {
+  network_v4 net;
+  auto [ptr, err] = from_chars(str.data(), str.data() + str.size(), net);
+  if (err != std::errc{} || ptr != str.data() + str.size()) {
+    ec = std::make_error_code(std::errc::invalid_argument);
+    return network_v4(address_v4(), 32);
+  }
+  ec.clear();
+  return net;
+}
+}  // namespace ip
+}  // namespace net
+
+#endif  // IP_NETWORK_V4_HPP_
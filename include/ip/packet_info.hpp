@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef IP_PACKET_INFO_HPP_
+#define IP_PACKET_INFO_HPP_
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <cstddef>
+#include <cstring>
+
+#include "ip/address.hpp"
+
+namespace net {
+namespace ip {
+
+// The destination address of a received datagram and the interface it
+// arrived on, reported by the kernel when `udp::packet_info` is enabled. For
+// a multicast datagram the destination is the group, so one socket can serve
+// many groups.
+struct packet_info {
+  // The size of the ancillary data to reserve for every datagram.
+  static constexpr std::size_t control_size = CMSG_SPACE(sizeof(::in6_pktinfo));
+
+  // The destination address. IPv4 mapped addresses, which an IPv6 socket
+  // reports for IPv4 datagrams, are converted to IPv4.
+  address destination;
+
+  // The index of the interface.
+  unsigned interface_index = 0;
+
+  // Find the packet info in the ancillary data of `msg`. Returns false if the
+  // kernel didn't report any.
+  static bool parse(const ::msghdr& msg, packet_info& info) noexcept {
+    for (::cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(const_cast<::msghdr*>(&msg), cmsg)) {
+      if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO) {
+        ::in_pktinfo pktinfo;
+        std::memcpy(&pktinfo, CMSG_DATA(cmsg), sizeof(pktinfo));
+        address_v4::bytes_type bytes;
+        std::memcpy(bytes.data(), &pktinfo.ipi_addr, bytes.size());
+        info.destination = address_v4{bytes};
+        info.interface_index = static_cast<unsigned>(pktinfo.ipi_ifindex);
+        return true;
+      }
+      if (cmsg->cmsg_level == IPPROTO_IPV6 &&
+          cmsg->cmsg_type == IPV6_PKTINFO) {
+        ::in6_pktinfo pktinfo;
+        std::memcpy(&pktinfo, CMSG_DATA(cmsg), sizeof(pktinfo));
+        address_v6::bytes_type bytes;
+        std::memcpy(bytes.data(), &pktinfo.ipi6_addr, bytes.size());
+        address_v6 destination{bytes};
+        if (destination.is_v4_mapped()) {
+          info.destination = make_address_v4(v4_mapped_t::v4_mapped, destination);
+        } else {
+          info.destination = destination;
+        }
+        info.interface_index = pktinfo.ipi6_ifindex;
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+}  // namespace ip
+}  // namespace net
+
+#endif  // IP_PACKET_INFO_HPP_
@@ -46,6 +46,10 @@ static constexpr uint32_t datagram_oriented = 16;
 // The socket may have been dup()-ed.
 static constexpr uint32_t possible_dup = 32;
 
+// Only one of the contexts waiting on the socket should be woken up for each
+// event, e.g. an acceptor shared by several epoll_contexts.
+static constexpr uint32_t exclusive_wakeup = 64;
+
 // The maximum length of the queue of pending incoming connections.
 static constexpr int max_listen_connections = SOMAXCONN;
 
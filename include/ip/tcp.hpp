@@ -16,9 +16,17 @@
 #ifndef IP_TCP_HPP_
 #define IP_TCP_HPP_
 
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include <chrono>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+
 #include "basic_socket_acceptor.hpp"
 #include "basic_stream_socket.hpp"
 #include "ip/basic_endpoint.hpp"
+#include "socket_base.hpp"
 #include "socket_option.hpp"
 
 namespace net {
@@ -38,6 +46,48 @@ class tcp {
   // The tcp resolver type.
   // using resolver = basic_resolver<tcp>;
 
+  // Socket option for a client socket to defer the connect to the first
+  // send, which then goes out with the SYN. Lets a plain `connect` use fast
+  // open, `async_connect_with_data` does without it.
+  using fast_open_connect =
+      socket_option::boolean<IPPROTO_TCP, TCP_FASTOPEN_CONNECT>;
+
+  // Socket option to send segments as soon as possible, disabling Nagle.
+  using no_delay = socket_option::boolean<IPPROTO_TCP, TCP_NODELAY>;
+
+  // Socket option to hold back partial segments until it's cleared again.
+  using cork = socket_option::boolean<IPPROTO_TCP, TCP_CORK>;
+
+  // Socket option to ack received segments immediately. Not sticky, the
+  // kernel may fall back to delayed acks, so set it again after receives.
+  using quick_ack = socket_option::boolean<IPPROTO_TCP, TCP_QUICKACK>;
+
+  // Socket option for a listening socket to accept a connection only once
+  // data arrived, waiting at most the given seconds.
+  using defer_accept = socket_option::integer<IPPROTO_TCP, TCP_DEFER_ACCEPT>;
+
+  // Socket option for a listening socket to accept data in the SYN, the value
+  // is the length of the queue of pending fast open requests.
+  using fast_open = socket_option::integer<IPPROTO_TCP, TCP_FASTOPEN>;
+
+  // Socket option to report writability only while fewer than the given
+  // bytes are not sent yet, which keeps the send queue short.
+  using notsent_low_water_mark =
+      socket_option::integer<IPPROTO_TCP, TCP_NOTSENT_LOWAT>;
+
+  // Socket option to drop the connection once sent data stays unacked for
+  // the given milliseconds.
+  using user_timeout = socket_option::integer<IPPROTO_TCP, TCP_USER_TIMEOUT>;
+
+  // Socket option to read the state of the connection kept by the kernel,
+  // TCP_INFO. Only gettable.
+  class info;
+
+  // The generic socket options tuned along with the tcp ones.
+  using busy_poll = socket_base::busy_poll;
+  using incoming_cpu = socket_base::incoming_cpu;
+  using zero_copy = socket_base::zero_copy;
+
   // Construct with a specific family.
   constexpr explicit tcp(int protocol_family) noexcept
       : family_(protocol_family) {}
@@ -71,7 +121,109 @@ class tcp {
   int family_;
 };
 
+class tcp::info {
+ public:
+  // Default constructor, every value is zero.
+  constexpr info() noexcept : value_{} {}
+
+  // The smoothed round trip time.
+  constexpr std::chrono::microseconds rtt() const noexcept {
+    return std::chrono::microseconds(value_.tcpi_rtt);
+  }
+
+  // The variance of the round trip time.
+  constexpr std::chrono::microseconds rtt_variance() const noexcept {
+    return std::chrono::microseconds(value_.tcpi_rttvar);
+  }
+
+  // The congestion window in segments.
+  constexpr std::uint32_t congestion_window() const noexcept {
+    return value_.tcpi_snd_cwnd;
+  }
+
+  // The slow start threshold in segments.
+  constexpr std::uint32_t slow_start_threshold() const noexcept {
+    return value_.tcpi_snd_ssthresh;
+  }
+
+  // The maximum segment size of sends.
+  constexpr std::uint32_t mss() const noexcept { return value_.tcpi_snd_mss; }
+
+  // The segments sent but not acknowledged yet.
+  constexpr std::uint32_t unacked() const noexcept {
+    return value_.tcpi_unacked;
+  }
+
+  // The segments retransmitted over the life of the connection.
+  constexpr std::uint32_t total_retransmits() const noexcept {
+    return value_.tcpi_total_retrans;
+  }
+
+  // The state of the connection, e.g. TCP_ESTABLISHED.
+  constexpr int state() const noexcept { return value_.tcpi_state; }
+
+  // The bytes the congestion window lets be in flight.
+  constexpr std::uint64_t window_bytes() const noexcept {
+    return static_cast<std::uint64_t>(value_.tcpi_snd_cwnd) *
+           value_.tcpi_snd_mss;
+  }
+
+  // The rate the congestion window allows per round trip in bytes per
+  // second, zero before the first round trip was measured.
+  constexpr std::uint64_t window_rate() const noexcept {
+    return value_.tcpi_rtt == 0 ? 0
+                                : window_bytes() * 1'000'000 / value_.tcpi_rtt;
+  }
+
+  // The whole structure, for the fields without an accessor.
+  constexpr const ::tcp_info& get() const noexcept { return value_; }
+
+  // Get the level of the socket option.
+  template <typename Protocol>
+  constexpr int level(const Protocol&) const {
+    return IPPROTO_TCP;
+  }
+
+  // Get the name of the socket option.
+  template <typename Protocol>
+  constexpr int name(const Protocol&) const {
+    return TCP_INFO;
+  }
+
+  // Get the address of the tcp_info data.
+  template <typename Protocol>
+  constexpr ::tcp_info* data(const Protocol&) {
+    return &value_;
+  }
+
+  // Get the address of the tcp_info data.
+  template <typename Protocol>
+  constexpr const ::tcp_info* data(const Protocol&) const {
+    return &value_;
+  }
+
+  // Get the size of the tcp_info data. Older kernels fill in less, the rest
+  // stays zero.
+  template <typename Protocol>
+  constexpr std::size_t size(const Protocol&) const {
+    return sizeof(value_);
+  }
+
+ private:
+  ::tcp_info value_;
+};
+
 }  // namespace ip
+
+namespace socket_option {
+template <>
+inline constexpr bool inherited_by_accept<ip::tcp::no_delay> = true;
+template <>
+inline constexpr bool inherited_by_accept<ip::tcp::notsent_low_water_mark> =
+    true;
+template <>
+inline constexpr bool inherited_by_accept<ip::tcp::user_timeout> = true;
+}  // namespace socket_option
 }  // namespace net
 
 #endif  // IP_TCP_HPP_
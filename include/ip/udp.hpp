@@ -16,6 +16,8 @@
 #ifndef IP_UDP_HPP_
 #define IP_UDP_HPP_
 
+#include <netinet/udp.h>
+
 #include "basic_datagram_socket.hpp"
 #include "ip/basic_endpoint.hpp"
 #include "socket_option.hpp"
@@ -35,6 +37,46 @@ class udp {
   // The udp resolver type.
   // using resolver = basic_resolver<udp>;
 
+  // Socket option to let the kernel split every datagram sent into segments
+  // of the given size (UDP GSO). Zero disables segmentation.
+  using segment_size = socket_option::integer<SOL_UDP, UDP_SEGMENT>;
+
+  // Socket option to receive datagrams coalesced by the kernel (UDP GRO). The
+  // segment size is then reported by async_recv_segments.
+  using generic_receive_offload = socket_option::boolean<SOL_UDP, UDP_GRO>;
+
+  // Socket option to join a multicast group, on a given interface or on the
+  // one the kernel routes the group to. Note that Linux limits the groups an
+  // IPv4 socket can join by `net.ipv4.igmp_max_memberships`, which defaults
+  // to 20.
+  using join_group =
+      socket_option::multicast_request<IP_ADD_MEMBERSHIP, IPV6_JOIN_GROUP>;
+
+  // Socket option to leave a multicast group.
+  using leave_group =
+      socket_option::multicast_request<IP_DROP_MEMBERSHIP, IPV6_LEAVE_GROUP>;
+
+  // Socket option to deliver the multicast datagrams sent by this host back
+  // to its own sockets.
+  using multicast_loopback =
+      socket_option::family_boolean<IPPROTO_IP, IP_MULTICAST_LOOP,
+                                    IPPROTO_IPV6, IPV6_MULTICAST_LOOP>;
+
+  // Socket option to receive the datagrams of the groups joined by any
+  // socket of the host, the default, rather than only of the groups joined
+  // by this socket. Turn it off when a socket bound to the wildcard address
+  // serves a set of groups.
+  using multicast_all =
+      socket_option::family_boolean<IPPROTO_IP, IP_MULTICAST_ALL,
+                                    IPPROTO_IPV6, IPV6_MULTICAST_ALL>;
+
+  // Socket option to report the destination address and the interface of
+  // every received datagram, see `ip::packet_info` and
+  // `datagram_batch::packet_info`.
+  using packet_info =
+      socket_option::family_boolean<IPPROTO_IP, IP_PKTINFO, IPPROTO_IPV6,
+                                    IPV6_RECVPKTINFO>;
+
   // Construct with a specific family.
   constexpr explicit udp(int protocol_family) noexcept
       : family_(protocol_family) {}
@@ -0,0 +1,929 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef KQUEUE_KQUEUE_CONTEXT_HPP_
+#define KQUEUE_KQUEUE_CONTEXT_HPP_
+
+#include <fcntl.h>
+#include <sys/event.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <system_error>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "stdexec.hpp"
+
+#include "atomic_intrusive_queue.hpp"
+#include "execution_context.hpp"
+#include "intrusive_heap.hpp"
+#include "monotonic_clock.hpp"
+
+namespace net {
+namespace __kqueue {
+// An execution context driven by kqueue, for the BSDs where epoll is not
+// available. Like epoll_context, only one thread is allowed to run the
+// context, which is called io thread. Operations try their syscall first and
+// only wait for readiness when it would block, the waits are one-shot filters
+// which are collected into a changelist and submitted by the `kevent` call
+// that also waits for the events. Timers are kept in a heap by the context,
+// which bounds the wait by the earliest due time.
+class kqueue_context final : public execution_context {
+ public:
+  // The scheduler of this context. Both `schedule_at`, `schedule_after` and
+  // `schedule` customization point object are supported by this scheduler.
+  class scheduler;
+
+  // The base class for all the types of operations that this context can
+  // perform. Note that operations will be executed by context in the order they
+  // are committed.
+  struct operation_base {
+    // Default constructor.
+    constexpr operation_base() noexcept
+        : enqueued_(false), next_(nullptr), execute_(nullptr) {}
+
+    // Destructor.
+    constexpr ~operation_base() = default;
+
+    // The flag determines whether the current operation is in a remote or local
+    // queue.
+    std::atomic_bool enqueued_;
+
+    // The `next_` pointer points to the next operation on the operation queue,
+    operation_base* next_;
+
+    // The `execute_` pointer points to the actual function to be executed.
+    void (*execute_)(operation_base*) noexcept;  // NOLINT
+  };
+
+  // The operation which waits for a filter or a timer. Only touched by the io
+  // thread.
+  struct completion_op : operation_base {
+    // Whether the filter or the timer is still armed.
+    bool waiting_ = false;
+
+    // The error reported by kevent when the filter can't be added.
+    int error_ = 0;
+  };
+
+  // The stop operation.
+  struct stop_op : operation_base {};
+
+  // The time_point type used by scheduler.
+  using time_point = monotonic_clock::time_point;
+
+  // A node of the timer heap, completing `op_` once `due_time_` has passed.
+  struct timer_node {
+    timer_node* timer_next_ = nullptr;
+    timer_node* timer_prev_ = nullptr;
+    time_point due_time_;
+    completion_op* op_ = nullptr;
+  };
+
+  // The base class of operations which wait for readiness or a timer until
+  // their work can be done.
+  template <typename ReceiverId>
+  class io_base_op;
+
+  // Socket operation that accepts a new connection.
+  template <typename ReceiverId, typename Protocol>
+  class socket_accept_op;
+
+  // recv some operation.
+  template <typename ReceiverId, typename Protocol, typename Buffers>
+  class socket_recv_some_op;
+
+  // send some operation.
+  template <typename ReceiverId, typename Protocol, typename Buffers>
+  class socket_send_some_op;
+
+  // The queue of operations.
+  using operation_queue = stdexec::__intrusive_queue<&operation_base::next_>;
+
+  // The heap of timers, ordered by due time.
+  using timer_heap =
+      intrusive_heap<timer_node, &timer_node::timer_next_,
+                     &timer_node::timer_prev_, time_point,
+                     &timer_node::due_time_>;
+
+  // The default count of events one kevent call can return, which is also
+  // the size of the changelist submitted at once.
+  static constexpr std::size_t default_event_batch_size = 256;
+
+  // Constructor. `batch_size` is the count of events one kevent call can
+  // return. Throws an error when the kqueue can't be created.
+  explicit kqueue_context(std::size_t batch_size = default_event_batch_size)
+      : kqueue_fd_(-1),                            //
+        changes_(),                                //
+        events_(std::max<std::size_t>(batch_size, 1)),
+        timers_(),                                 //
+        processed_remote_queue_submitted_(false),  //
+        local_queue_(),                            //
+        remote_queue_(),                           //
+        stop_source_(std::in_place),               //
+        is_running_(false) {
+    changes_.reserve(events_.size());
+    setup_kqueue();
+  }
+
+  // Destructor.
+  ~kqueue_context() {
+    if (kqueue_fd_ >= 0) {
+      ::close(kqueue_fd_);
+    }
+  }
+
+  // Execute all operations submitted to this context.
+  void run();
+
+  // Request to stop the context. Note that the context may block on the
+  // kevent call, so we must use interrupt to wake up the context.
+  void request_stop() {
+    stop_source_->request_stop();
+    interrupt();
+  }
+
+  // Whether this context have been request to stop.
+  bool stop_requested() const noexcept {
+    return stop_source_->stop_requested();
+  }
+
+  // Get this context associated stop token.
+  stdexec::in_place_stop_token get_stop_token() const noexcept {
+    return stop_source_->get_token();
+  }
+
+  // Check whether this context is running.
+  bool is_running() const noexcept {
+    return is_running_.load(std::memory_order_relaxed);
+  }
+
+  // CPO: get_scheduler.
+  constexpr scheduler get_scheduler() noexcept;
+
+ private:
+  // The thread that calls `context.run()` is called io thread, and other
+  // threads are remote threads. This function checks which thread is using the
+  // context.
+  bool is_running_on_io_thread() const noexcept;
+
+  // Schedule the operation to the local queue if called on the io thread,
+  // otherwise to the remote queue.
+  void schedule_impl(operation_base* op) noexcept;
+
+  // Schedule the operation to the local queue.
+  void schedule_local(operation_base* op) noexcept;
+
+  // Move all contents from remote queue to local queue.
+  void schedule_local(operation_queue ops) noexcept;
+
+  // Schedule the operation to the remote queue.
+  void schedule_remote(operation_base* op) noexcept;
+
+  // Execute all items on the local queue.
+  // Won't run other items that were enqueued during the execution of the items
+  // that were already enqueued. This bounds the amount of work to a finite
+  // amount.
+  std::size_t execute_local() noexcept;
+
+  // Collect the contents of the remote queue and pass them to local queue.
+  // Returns true means remote queue is emtpy before we collect.
+  bool try_schedule_remote_to_local() noexcept;
+
+  // Wait until `op` can make progress on the `filter` of `descriptor`. The
+  // one-shot filter is added by the next kevent call. Only one operation can
+  // wait on a filter of a descriptor at a time. Must be called from the I/O
+  // thread.
+  void arm_filter(completion_op* op, int descriptor, short filter) noexcept;
+
+  // Remove the filter armed by `arm_filter`. Must be called from the I/O
+  // thread.
+  void disarm_filter(int descriptor, short filter) noexcept;
+
+  // Complete `node->op_` once its due time has passed. Must be called from the
+  // I/O thread.
+  void arm_timer(timer_node* node) noexcept;
+
+  // Remove a timer armed by `arm_timer`. Must be called from the I/O thread.
+  void disarm_timer(timer_node* node) noexcept;
+
+  // Append a change to the changelist, submitting the changelist first if it
+  // is full.
+  void add_change(const struct kevent& change) noexcept;
+
+  // Submit the changelist and wait for the events until `timeout`, nullptr
+  // means forever. Returns the errno of kevent, zero on success.
+  int submit_changes(const ::timespec* timeout) noexcept;
+
+  // Like `submit_changes`, but throws an error when kevent fails.
+  void wait_events(const ::timespec* timeout);
+
+  // Move the operations whose filter has fired to the local queue.
+  void acquire_completion_queue_items(int count) noexcept;
+
+  // Move the operations whose timer has elapsed to the local queue.
+  void acquire_elapsed_timers() noexcept;
+
+  // The timeout of the next kevent call: zero if there is work to do, the
+  // earliest due time of the timers or nullptr to wait forever.
+  const ::timespec* next_timeout(::timespec& storage) const noexcept;
+
+  // Wake up the io thread from kevent.
+  void interrupt() noexcept;
+
+  // Create the kqueue and the user event used to interrupt it. Throws an
+  // error when setup fails.
+  void setup_kqueue();
+
+  // The identifier of the user event which interrupts the kevent call.
+  static constexpr uintptr_t interrupter_ident = 0;
+
+  // The kqueue file descriptor.
+  int kqueue_fd_;
+
+  // The changes submitted by the next kevent call.
+  std::vector<struct kevent> changes_;
+
+  // The events returned by one kevent call.
+  std::vector<struct kevent> events_;
+
+  // The armed timers. Only touched by the io thread.
+  timer_heap timers_;
+
+  // Whether the operation submitted by the remote thread has been processed.
+  bool processed_remote_queue_submitted_;
+
+  // Local queue for operations that are ready to execute.
+  operation_queue local_queue_;
+
+  // Queue of operations enqueued by remote threads.
+  atomic_intrusive_queue<&operation_base::next_> remote_queue_;
+
+  // The stop source.
+  std::optional<stdexec::in_place_stop_source> stop_source_;
+
+  // Whether this context is running.
+  std::atomic_bool is_running_;
+};
+
+// The base class of operations which wait for readiness or a timer until
+// their work can be done. Subclasses provide how to try the work, how to wait
+// and how to complete the receiver. Every step, the cancellation included,
+// runs on the io thread.
+template <typename ReceiverId>
+class kqueue_context::io_base_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+
+ public:
+  struct __t : public stdexec::__immovable,
+               private kqueue_context::completion_op,
+               private kqueue_context::stop_op {
+    using __id = io_base_op;
+    using stop_token = stdexec::stop_token_of_t<stdexec::env_of_t<receiver_t>>;
+
+    // Subclasses should provide these necessary functions.
+    struct op_vtable {
+      // Try the work, returns false if it would block.
+      bool (*perform)(__t*) noexcept = nullptr;  // NOLINT
+
+      // Wait until the work can make progress.
+      void (*arm)(__t*) noexcept = nullptr;  // NOLINT
+
+      // Stop waiting.
+      void (*disarm)(__t*) noexcept = nullptr;  // NOLINT
+
+      // The work is done, notify the downstream receiver based on its result.
+      void (*complete)(__t*) noexcept = nullptr;  // NOLINT
+    };
+
+    struct cancel_callback {
+      __t& op_;
+
+      void operator()() noexcept { op_.request_stop(); }
+    };
+
+    // Constructor.
+    __t(receiver_t receiver, kqueue_context& context,
+        const op_vtable& vtable) noexcept
+        : receiver_(static_cast<receiver_t&&>(receiver)),
+          context_(context),
+          op_vtable_(&vtable),
+          stop_requested_(false),
+          stop_executed_(false),
+          ready_pending_(false),
+          stop_callback_() {}
+
+    friend void tag_invoke(stdexec::start_t, __t& self) noexcept {
+      self.start_impl();
+    }
+
+    // The error reported by kevent when the wait can't be set up, zero if
+    // none.
+    constexpr int wait_error() const noexcept {
+      return static_cast<const completion_op&>(*this).error_;
+    }
+
+    // The completion op which the filters and timers are armed with.
+    constexpr completion_op* as_completion_op() noexcept {
+      return static_cast<completion_op*>(this);
+    }
+
+    void start_impl() noexcept {
+      if (!context_.is_running_on_io_thread()) {
+        as_completion_op()->execute_ = &__t::on_schedule_complete;
+        context_.schedule_remote(as_completion_op());
+      } else {
+        begin();
+      }
+    }
+
+    // kqueue_context starts to execute this operation in the io thread.
+    static void on_schedule_complete(operation_base* op) noexcept {
+      static_cast<__t*>(static_cast<completion_op*>(op))->begin();
+    }
+
+    void begin() noexcept {
+      assert(context_.is_running_on_io_thread());
+      if constexpr (!stdexec::unstoppable_token<stop_token>) {
+        if (stdexec::get_stop_token(stdexec::get_env(receiver_))
+                .stop_requested()) {
+          stdexec::set_stopped(static_cast<receiver_t&&>(receiver_));
+          return;
+        }
+      }
+      if (op_vtable_->perform(this)) {
+        op_vtable_->complete(this);
+      } else {
+        wait();
+      }
+    }
+
+    void wait() noexcept {
+      as_completion_op()->waiting_ = true;
+      as_completion_op()->execute_ = &__t::on_ready;
+      op_vtable_->arm(this);
+      if constexpr (!stdexec::unstoppable_token<stop_token>) {
+        stop_callback_.__construct(
+            stdexec::get_stop_token(stdexec::get_env(receiver_)),
+            cancel_callback{*this});
+      }
+    }
+
+    // The filter has fired or the timer has elapsed.
+    static void on_ready(operation_base* op) noexcept {
+      auto& self = *static_cast<__t*>(static_cast<completion_op*>(op));
+      if constexpr (!stdexec::unstoppable_token<stop_token>) {
+        // Wait for a concurrent stop request to finish.
+        self.stop_callback_.__destruct();
+      }
+      if (self.stop_requested_.load(std::memory_order_acquire)) {
+        if (self.stop_executed_) {
+          stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+        } else {
+          // The stop operation is on its way, let it complete the operation.
+          self.ready_pending_ = true;
+        }
+        return;
+      }
+      if (self.wait_error() != 0 || self.op_vtable_->perform(&self)) {
+        self.op_vtable_->complete(&self);
+      } else {
+        // A spurious wakeup, wait again.
+        self.wait();
+      }
+    }
+
+    static void on_stop(operation_base* op) noexcept {
+      auto& self = *static_cast<__t*>(static_cast<stop_op*>(op));
+      self.stop_executed_ = true;
+      if (self.as_completion_op()->waiting_) {
+        self.as_completion_op()->waiting_ = false;
+        self.op_vtable_->disarm(&self);
+        if constexpr (!stdexec::unstoppable_token<stop_token>) {
+          self.stop_callback_.__destruct();
+        }
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      } else if (self.ready_pending_) {
+        stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      }
+      // Otherwise `on_ready` is queued and completes the operation.
+    }
+
+    // Any thread requests that this operation should be stopped.
+    void request_stop() noexcept {
+      stop_requested_.store(true, std::memory_order_release);
+      static_cast<stop_op*>(this)->execute_ = &__t::on_stop;
+      context_.schedule_impl(static_cast<stop_op*>(this));
+    }
+
+    receiver_t receiver_;
+    kqueue_context& context_;
+    const op_vtable* op_vtable_;
+    std::atomic<bool> stop_requested_;
+
+    // Only accessed by the io thread.
+    bool stop_executed_;
+    bool ready_pending_;
+    exec::__manual_lifetime<
+        typename stop_token::template callback_type<cancel_callback>>
+        stop_callback_;
+  };
+};
+
+// The scheduler with returned by `stdexec::get_schedule` customization point
+// object.
+class kqueue_context::scheduler {
+  // The envrionment of scheduler.
+  struct schedule_env {
+    friend auto tag_invoke(
+        stdexec::get_completion_scheduler_t<stdexec::set_value_t>,
+        const schedule_env& env) noexcept -> scheduler {
+      return scheduler{env.context};
+    }
+
+    explicit constexpr schedule_env(kqueue_context& ctx) noexcept
+        : context(ctx) {}
+
+    kqueue_context& context;
+  };  // schedule_env
+
+  template <typename ReceiverId>
+  class schedule_op {
+    using receiver_t = stdexec::__t<ReceiverId>;
+
+   public:
+    struct __t : private operation_base {
+      using __id = schedule_op;
+      using stop_token =
+          stdexec::stop_token_of_t<stdexec::env_of_t<receiver_t>&>;
+
+      constexpr __t(kqueue_context& context, receiver_t r)
+          : context_(context), receiver_(static_cast<receiver_t&&>(r)) {
+        execute_ = &execute_impl;
+      }
+
+      friend void tag_invoke(stdexec::start_t, __t& op) noexcept {
+        op.context_.schedule_impl(&op);
+      }
+
+     private:
+      static constexpr void execute_impl(operation_base* p) noexcept {
+        auto& self = *static_cast<__t*>(p);
+        if constexpr (!std::unstoppable_token<stop_token>) {
+          auto stop_token =
+              stdexec::get_stop_token(stdexec::get_env(self.receiver_));
+          if (stop_token.stop_requested()) {
+            stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+            return;
+          }
+        }
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_));
+      }
+
+      kqueue_context& context_;
+      STDEXEC_NO_UNIQUE_ADDRESS receiver_t receiver_;
+    };
+  };  // schedule_op.
+
+  class schedule_sender {
+    template <typename Receiver>
+    using op_t = stdexec::__t<schedule_op<stdexec::__id<Receiver>>>;
+
+   public:
+    struct __t {
+      using is_sender = void;
+      using __id = schedule_sender;
+      using completion_signatures =
+          stdexec::completion_signatures<stdexec::set_value_t(),  //
+                                         stdexec::set_stopped_t()>;
+
+      template <typename Env>
+      friend auto tag_invoke(stdexec::get_completion_signatures_t,
+                             const __t& self, Env&&) noexcept
+          -> completion_signatures;
+
+      friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+          -> schedule_env {
+        return self.env_;
+      }
+
+      template <stdexec::__decays_to<__t> Sender,
+                stdexec::receiver_of<completion_signatures> Receiver>
+      friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                             Receiver receiver) noexcept -> op_t<Receiver> {
+        return {static_cast<__t&&>(self).env_.context,
+                static_cast<Receiver&&>(receiver)};
+      }
+
+      explicit constexpr __t(schedule_env env) noexcept : env_(env) {}
+
+     private:
+      schedule_env env_;
+    };
+  };  // schedule_sender.
+
+  // The timer waits in the heap of the context, which computes the timeout
+  // of the kevent call from the earliest due time.
+  template <typename ReceiverId>
+  class schedule_at_op {
+    using receiver_t = stdexec::__t<ReceiverId>;
+    using base_t = stdexec::__t<io_base_op<ReceiverId>>;
+
+   public:
+    struct __t : public base_t {
+      using __id = schedule_at_op;
+
+      __t(kqueue_context& context, const time_point& due_time,
+          receiver_t r) noexcept
+          : base_t(static_cast<receiver_t&&>(r), context, op_vtable),
+            timer_() {
+        timer_.due_time_ = due_time;
+        timer_.op_ = this->as_completion_op();
+      }
+
+     private:
+      static bool perform(base_t* base) noexcept {
+        auto& self = *static_cast<__t*>(base);
+        return monotonic_clock::now() >= self.timer_.due_time_;
+      }
+
+      static void arm(base_t* base) noexcept {
+        auto& self = *static_cast<__t*>(base);
+        self.context_.arm_timer(&self.timer_);
+      }
+
+      static void disarm(base_t* base) noexcept {
+        auto& self = *static_cast<__t*>(base);
+        self.context_.disarm_timer(&self.timer_);
+      }
+
+      static void complete(base_t* base) noexcept {
+        auto& self = *static_cast<__t*>(base);
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_));
+      }
+
+      static constexpr typename base_t::op_vtable op_vtable{
+          &perform, &arm, &disarm, &complete};
+      timer_node timer_;
+    };
+  };  // schedule_at_op.
+
+  class schedule_at_sender {
+    template <typename Receiver>
+    using op_t = stdexec::__t<schedule_at_op<stdexec::__id<Receiver>>>;
+
+   public:
+    struct __t {
+      using is_sender = void;
+      using __id = schedule_at_sender;
+      using completion_signatures =
+          stdexec::completion_signatures<stdexec::set_value_t(),
+                                         stdexec::set_stopped_t()>;
+
+      template <typename Env>
+      friend auto tag_invoke(stdexec::get_completion_signatures_t,
+                             const __t& self, Env&&) noexcept
+          -> completion_signatures;
+
+      friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+          -> schedule_env {
+        return self.env_;
+      }
+
+      template <stdexec::__decays_to<__t> Sender,
+                stdexec::receiver_of<completion_signatures> Receiver>
+      friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                             Receiver receiver) noexcept -> op_t<Receiver> {
+        return {static_cast<__t&&>(self).env_.context,  //
+                static_cast<__t&&>(self).due_time_,     //
+                static_cast<Receiver&&>(receiver)};
+      }
+
+      constexpr __t(schedule_env env, const time_point& due_time) noexcept
+          : env_(env), due_time_(due_time) {}
+
+     private:
+      schedule_env env_;
+      time_point due_time_;
+    };
+  };  // schedule_at_sender
+
+ public:
+  // Constructors.
+  explicit constexpr scheduler(kqueue_context& context) noexcept
+      : context_(&context) {}
+
+  constexpr scheduler(const scheduler&) noexcept = default;
+
+  constexpr scheduler& operator=(const scheduler&) = default;
+
+  constexpr ~scheduler() = default;
+
+  friend auto tag_invoke(exec::now_t, const scheduler&) noexcept -> time_point {
+    return monotonic_clock::now();
+  }
+
+  friend auto tag_invoke(stdexec::schedule_t, const scheduler& sched) noexcept
+      -> stdexec::__t<schedule_sender> {
+    return stdexec::__t<schedule_sender>{schedule_env{*sched.context_}};
+  }
+
+  friend auto tag_invoke(exec::schedule_at_t,     //
+                         const scheduler& sched,  //
+                         const time_point& due_time) noexcept
+      -> stdexec::__t<schedule_at_sender> {
+    return {schedule_env{*sched.context_}, due_time};
+  }
+
+  friend auto tag_invoke(exec::schedule_after_t,  //
+                         const scheduler& sched,  //
+                         std::chrono::nanoseconds duration) noexcept
+      -> stdexec::__t<schedule_at_sender> {
+    return {schedule_env{*sched.context_}, monotonic_clock::now() + duration};
+  }
+
+ private:
+  friend bool operator==(scheduler a, scheduler b) noexcept {
+    return a.context_ == b.context_;
+  }
+
+  friend bool operator!=(scheduler a, scheduler b) noexcept {
+    return a.context_ != b.context_;
+  }
+
+  kqueue_context* context_;
+};
+
+inline constexpr kqueue_context::scheduler
+kqueue_context::get_scheduler() noexcept {
+  return scheduler{*this};
+}
+
+inline void kqueue_context::setup_kqueue() {
+  kqueue_fd_ = ::kqueue();
+  if (kqueue_fd_ < 0) {
+    throw std::system_error{static_cast<int>(errno), std::system_category(),
+                            "kqueue"};
+  }
+  ::fcntl(kqueue_fd_, F_SETFD, FD_CLOEXEC);
+
+  // The user event is edge triggered, NOTE_TRIGGER fires it once.
+  struct kevent change;
+  EV_SET(&change, interrupter_ident, EVFILT_USER, EV_ADD | EV_CLEAR, 0, 0,
+         nullptr);
+  if (::kevent(kqueue_fd_, &change, 1, nullptr, 0, nullptr) < 0) {
+    int error = errno;
+    ::close(std::exchange(kqueue_fd_, -1));
+    throw std::system_error{error, std::system_category(), "kevent"};
+  }
+}
+
+// The context run by the current thread. An inline variable, so that every
+// translation unit sees the same slot and recognizes the io thread.
+inline thread_local kqueue_context* current_thread_context = nullptr;
+
+inline bool kqueue_context::is_running_on_io_thread() const noexcept {
+  return this == current_thread_context;
+}
+
+inline void kqueue_context::interrupt() noexcept {
+  struct kevent change;
+  EV_SET(&change, interrupter_ident, EVFILT_USER, 0, NOTE_TRIGGER, 0, nullptr);
+  ::kevent(kqueue_fd_, &change, 1, nullptr, 0, nullptr);
+}
+
+inline void kqueue_context::arm_filter(completion_op* op, int descriptor,
+                                       short filter) noexcept {
+  struct kevent change;
+  EV_SET(&change, descriptor, filter, EV_ADD | EV_ONESHOT, 0, 0, op);
+  add_change(change);
+}
+
+inline void kqueue_context::disarm_filter(int descriptor,
+                                          short filter) noexcept {
+  // A filter which has fired in the meantime is gone, the resulting ENOENT
+  // carries no operation and is ignored.
+  struct kevent change;
+  EV_SET(&change, descriptor, filter, EV_DELETE, 0, 0, nullptr);
+  add_change(change);
+}
+
+inline void kqueue_context::arm_timer(timer_node* node) noexcept {
+  timers_.insert(node);
+}
+
+inline void kqueue_context::disarm_timer(timer_node* node) noexcept {
+  timers_.remove(node);
+}
+
+inline void kqueue_context::add_change(const struct kevent& change) noexcept {
+  if (changes_.size() == changes_.capacity()) {
+    // Submit the full changelist without waiting, the errors it reports are
+    // delivered as events.
+    ::timespec zero{};
+    (void)submit_changes(&zero);
+  }
+  changes_.push_back(change);
+}
+
+inline int kqueue_context::submit_changes(const ::timespec* timeout) noexcept {
+  int result = ::kevent(kqueue_fd_, changes_.data(),
+                        static_cast<int>(changes_.size()), events_.data(),
+                        static_cast<int>(events_.size()), timeout);
+  if (result < 0) {
+    // The changelist has been applied if the wait was interrupted.
+    if (errno == EINTR) {
+      changes_.clear();
+    }
+    return errno;
+  }
+  changes_.clear();
+  acquire_completion_queue_items(result);
+  return 0;
+}
+
+inline void kqueue_context::wait_events(const ::timespec* timeout) {
+  int error = submit_changes(timeout);
+  if (error != 0 && error != EINTR) {
+    throw std::system_error{error, std::system_category(), "kevent"};
+  }
+}
+
+inline void kqueue_context::acquire_completion_queue_items(int count) noexcept {
+  // temporary queue of newly completed items.
+  operation_queue completion_queue;
+  for (int i = 0; i < count; ++i) {
+    const struct kevent& event = events_[i];
+    if (event.filter == EVFILT_USER) {
+      // Let the run loop check for the remote-queued items next time.
+      processed_remote_queue_submitted_ = false;
+      continue;
+    }
+    auto* op = static_cast<completion_op*>(event.udata);
+    if (op == nullptr) {
+      // The error of a removed filter.
+      continue;
+    }
+    // A stopped operation removes its filter before it's destroyed, which
+    // also discards the pending event.
+    assert(op->waiting_);
+    op->waiting_ = false;
+    if ((event.flags & EV_ERROR) != 0) {
+      op->error_ = static_cast<int>(event.data);
+    }
+    assert(op->enqueued_.load() == false);
+    op->enqueued_ = true;
+    completion_queue.push_back(op);
+  }
+  schedule_local(std::move(completion_queue));
+}
+
+inline void kqueue_context::acquire_elapsed_timers() noexcept {
+  if (timers_.empty()) {
+    return;
+  }
+  const time_point now = monotonic_clock::now();
+  while (!timers_.empty() && timers_.top()->due_time_ <= now) {
+    completion_op* op = timers_.pop()->op_;
+    op->waiting_ = false;
+    schedule_local(op);
+  }
+}
+
+inline const ::timespec* kqueue_context::next_timeout(
+    ::timespec& storage) const noexcept {
+  if (!local_queue_.empty()) {
+    storage = ::timespec{};
+    return &storage;
+  }
+  if (timers_.empty()) {
+    return nullptr;
+  }
+  auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      timers_.top()->due_time_ - monotonic_clock::now());
+  if (remaining.count() < 0) {
+    remaining = std::chrono::nanoseconds{0};
+  }
+  storage.tv_sec = static_cast<time_t>(remaining.count() / 1'000'000'000);
+  storage.tv_nsec = static_cast<long>(remaining.count() % 1'000'000'000);
+  return &storage;
+}
+
+inline std::size_t kqueue_context::execute_local() noexcept {
+  if (local_queue_.empty()) {
+    return 0;
+  }
+  std::size_t count = 0;
+  auto pending = std::move(local_queue_);
+  while (!pending.empty()) {
+    auto* item = pending.pop_front();
+    assert(item->enqueued_);
+    item->enqueued_ = false;
+    std::exchange(item->next_, nullptr);
+    item->execute_(item);
+    ++count;
+  }
+  return count;
+}
+
+inline void kqueue_context::run() {
+  // Only one thread of execution is allowed to drive the io context.
+  bool expected_running = false;
+  if (!is_running_.compare_exchange_strong(expected_running, true,
+                                           std::memory_order_relaxed)) {
+    throw std::runtime_error(
+        "kqueue_context::run() called on a running context");
+  }
+  exec::scope_guard set_not_running{[&]() noexcept {  //
+    is_running_.store(false, std::memory_order_relaxed);
+  }};
+
+  auto* old_context = std::exchange(current_thread_context, this);
+  exec::scope_guard g{[=]() noexcept {
+    std::exchange(current_thread_context, old_context);
+  }};
+
+  while (true) {
+    execute_local();
+    if (stop_source_->stop_requested()) {
+      break;
+    }
+    if (!processed_remote_queue_submitted_) {
+      processed_remote_queue_submitted_ = try_schedule_remote_to_local();
+    }
+    ::timespec timeout;
+    wait_events(next_timeout(timeout));
+    acquire_elapsed_timers();
+  }
+}
+
+inline void kqueue_context::schedule_impl(operation_base* op) noexcept {
+  assert(op != nullptr);
+  if (is_running_on_io_thread()) {
+    schedule_local(op);
+  } else {
+    schedule_remote(op);
+  }
+}
+
+inline void kqueue_context::schedule_local(operation_base* op) noexcept {
+  assert(op->execute_ != nullptr);
+  assert(!op->enqueued_);
+  op->enqueued_ = true;
+  local_queue_.push_back(op);
+}
+
+inline void kqueue_context::schedule_local(operation_queue ops) noexcept {
+  // Do not adjust the enqueued flag, which is still true because the ops will
+  // immediately be transferred from the remote queue to the local queue.
+  local_queue_.append(std::move(ops));
+}
+
+inline void kqueue_context::schedule_remote(operation_base* op) noexcept {
+  assert(!op->enqueued_.load());
+  op->enqueued_ = true;
+  if (remote_queue_.enqueue(op)) {
+    // We were the first to queue an item and the I/O thread is not
+    // going to check the queue until we notify it that new items
+    // have been enqueued remotely by triggering the user event.
+    interrupt();
+  }
+}
+
+inline bool kqueue_context::try_schedule_remote_to_local() noexcept {
+  (void)remote_queue_.try_mark_active();
+  auto queued_items = remote_queue_.try_mark_inactive_or_dequeue_all();
+  if (!queued_items.empty()) {
+    schedule_local(std::move(queued_items));
+    return false;
+  }
+  return true;
+}
+};  // namespace __kqueue
+
+using kqueue_context = __kqueue::kqueue_context;
+}  // namespace net
+
+#endif  // KQUEUE_KQUEUE_CONTEXT_HPP_
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef KQUEUE_SOCKET_ACCEPT_OP_HPP_
+#define KQUEUE_SOCKET_ACCEPT_OP_HPP_
+
+#include <sys/event.h>
+#include <sys/socket.h>
+
+#include <cerrno>
+#include <system_error>  // NOLINT
+
+#include "basic_socket_acceptor.hpp"
+#include "kqueue/kqueue_context.hpp"
+#include "meta.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __kqueue {
+
+template <typename ReceiverId, typename Protocol>
+class kqueue_context::socket_accept_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  using base_t = stdexec::__t<kqueue_context::io_base_op<ReceiverId>>;
+  using acceptor_t = basic_socket_acceptor<Protocol>;
+  using socket_t = typename Protocol::socket;
+
+ public:
+  struct __t : public base_t {
+    using __id = socket_accept_op;
+
+    // Constructor.
+    constexpr __t(receiver_t receiver, acceptor_t& acceptor) noexcept
+        : base_t(static_cast<receiver_t&&>(receiver),
+                 static_cast<kqueue_context&>(acceptor.context()),
+                 op_vtable),
+          acceptor_(acceptor),
+          accepted_(-1),
+          error_(0) {}
+
+   private:
+    // The accepted sockets are put into non-blocking mode by accept4 itself,
+    // the acceptor the first time it's waited on.
+    static bool perform(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      if (!self.acceptor_.is_non_blocking()) {
+        if (auto ec = self.acceptor_.set_non_blocking(true); ec.failure()) {
+          self.error_ = static_cast<int>(ec.value());
+          return true;
+        }
+      }
+      while (true) {
+        int fd = ::accept4(self.acceptor_.native_handle(), nullptr, nullptr,
+                           SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd >= 0) {
+          self.accepted_ = fd;
+          return true;
+        }
+        if (errno == EINTR || errno == ECONNABORTED) {
+          continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+          return false;
+        }
+        self.error_ = errno;
+        return true;
+      }
+    }
+
+    static void arm(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      self.context_.arm_filter(self.as_completion_op(),
+                               self.acceptor_.native_handle(), EVFILT_READ);
+    }
+
+    static void disarm(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      self.context_.disarm_filter(self.acceptor_.native_handle(), EVFILT_READ);
+    }
+
+    static void complete(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      int error = self.wait_error() != 0 ? self.wait_error() : self.error_;
+      if (error == 0) {
+        stdexec::set_value(
+            static_cast<receiver_t&&>(self.receiver_),
+            socket_t{self.context_, self.acceptor_.protocol(), self.accepted_});
+      } else {
+        stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                           std::error_code{error, std::system_category()});
+      }
+    }
+
+    static constexpr typename base_t::op_vtable op_vtable{&perform, &arm,
+                                                          &disarm, &complete};
+    acceptor_t& acceptor_;
+    int accepted_;
+    int error_;
+  };
+};
+
+template <typename Protocol>
+class accept_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<
+      kqueue_context::socket_accept_op<stdexec::__id<Receiver>, Protocol>>;
+  using acceptor_t = basic_socket_acceptor<Protocol>;
+  using socket_t = typename Protocol::socket;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = accept_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(socket_t&&),
+                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t,
+                           const __t& self, Env) -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.acceptor_};
+    }
+
+    // Constructors.
+    explicit constexpr __t(acceptor_t& acceptor) : acceptor_(acceptor) {}
+
+   private:
+    acceptor_t& acceptor_;
+  };
+};
+
+struct async_accept_t {
+  template <transport_protocol Protocol>
+  constexpr auto operator()(basic_socket_acceptor<Protocol>& acceptor)
+      const noexcept -> stdexec::__t<accept_sender<Protocol>> {
+    return stdexec::__t<accept_sender<Protocol>>{acceptor};
+  }
+};
+}  // namespace __kqueue
+
+namespace kq {
+// Socket operations whose acceptor or socket is associated with a
+// kqueue_context.
+inline constexpr __kqueue::async_accept_t async_accept{};
+}  // namespace kq
+}  // namespace net
+
+#endif  // KQUEUE_SOCKET_ACCEPT_OP_HPP_
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LATENCY_HISTOGRAM_HPP_
+#define LATENCY_HISTOGRAM_HPP_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+
+namespace net {
+
+// A log-linear histogram of latencies in nanoseconds, in the style of
+// HdrHistogram. Each power of two is split into `sub_bucket_count / 2` linear
+// buckets, so a value is known within 1/16 of itself, in a fixed array of
+// counters. Latencies beyond `max_value` are counted as `max_value`.
+//
+// Only one thread may record into a histogram, with plain loads and stores of
+// relaxed atomics, while any thread may read it. Histograms of different
+// threads are combined with `merge`.
+class latency_histogram {
+ public:
+  static constexpr unsigned sub_bucket_bits = 5;
+  static constexpr std::uint64_t sub_bucket_count = 1u << sub_bucket_bits;
+  static constexpr unsigned max_bits = 36;
+
+  // About 68.7 seconds.
+  static constexpr std::uint64_t max_value = (std::uint64_t{1} << max_bits) - 1;
+
+  static constexpr std::size_t bucket_count =
+      (max_bits - sub_bucket_bits + 2) * (sub_bucket_count / 2);
+
+  latency_histogram() noexcept = default;
+
+  latency_histogram(const latency_histogram&) = delete;
+  latency_histogram& operator=(const latency_histogram&) = delete;
+
+  // Record a latency. Must only be called by the owning thread.
+  void record(std::chrono::nanoseconds latency) noexcept {
+    const auto value = latency.count() < 0
+                           ? std::uint64_t{0}
+                           : static_cast<std::uint64_t>(latency.count());
+    add(counts_[index_of(value)], 1);
+    add(total_, 1);
+  }
+
+  // Add the counts of `other` to this histogram. Must only be called by the
+  // owning thread of this histogram, `other` may be recorded meanwhile.
+  void merge(const latency_histogram& other) noexcept {
+    std::uint64_t total = 0;
+    for (std::size_t i = 0; i < bucket_count; ++i) {
+      const std::uint64_t n = other.counts_[i].load(std::memory_order_relaxed);
+      if (n != 0) {
+        add(counts_[i], n);
+        total += n;
+      }
+    }
+    add(total_, total);
+  }
+
+  // The count of recorded latencies.
+  std::uint64_t count() const noexcept {
+    return total_.load(std::memory_order_relaxed);
+  }
+
+  // The count of latencies recorded in the bucket `index`.
+  std::uint64_t count_at(std::size_t index) const noexcept {
+    return counts_[index].load(std::memory_order_relaxed);
+  }
+
+  // The latency which `percentile` percent of the recorded ones don't
+  // exceed, as the highest value of its bucket. Zero if nothing has been
+  // recorded.
+  std::chrono::nanoseconds percentile(double percentile) const noexcept {
+    const std::uint64_t total = count();
+    if (total == 0) {
+      return std::chrono::nanoseconds::zero();
+    }
+    percentile = std::clamp(percentile, 0.0, 100.0);
+    auto rank = static_cast<std::uint64_t>(
+        percentile / 100.0 * static_cast<double>(total) + 0.5);
+    rank = rank == 0 ? 1 : rank;
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < bucket_count; ++i) {
+      seen += count_at(i);
+      if (seen >= rank) {
+        return std::chrono::nanoseconds(highest_value_at(i));
+      }
+    }
+    // Counted concurrently with a record.
+    return std::chrono::nanoseconds(max_value);
+  }
+
+  // The bucket counting `value`.
+  static constexpr std::size_t index_of(std::uint64_t value) noexcept {
+    value = value > max_value ? max_value : value;
+    const int width = std::bit_width(value);
+    const unsigned shift =
+        width > static_cast<int>(sub_bucket_bits) ? width - sub_bucket_bits : 0;
+    return shift * (sub_bucket_count / 2) + (value >> shift);
+  }
+
+  // The lowest and highest values counted by the bucket `index`.
+  static constexpr std::uint64_t lowest_value_at(std::size_t index) noexcept {
+    const unsigned shift = shift_at(index);
+    return (index - shift * (sub_bucket_count / 2)) << shift;
+  }
+
+  static constexpr std::uint64_t highest_value_at(std::size_t index) noexcept {
+    const unsigned shift = shift_at(index);
+    return lowest_value_at(index) + (std::uint64_t{1} << shift) - 1;
+  }
+
+ private:
+  static constexpr unsigned shift_at(std::size_t index) noexcept {
+    return index < sub_bucket_count
+               ? 0
+               : static_cast<unsigned>(index / (sub_bucket_count / 2)) - 1;
+  }
+
+  static void add(std::atomic<std::uint64_t>& counter,
+                  std::uint64_t n) noexcept {
+    counter.store(counter.load(std::memory_order_relaxed) + n,
+                  std::memory_order_relaxed);
+  }
+
+  std::array<std::atomic<std::uint64_t>, bucket_count> counts_{};
+  std::atomic<std::uint64_t> total_{0};
+};
+
+}  // namespace net
+
+#endif  // LATENCY_HISTOGRAM_HPP_
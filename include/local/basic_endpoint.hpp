@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LOCAL_BASIC_ENDPOINT_HPP_
+#define LOCAL_BASIC_ENDPOINT_HPP_
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+
+namespace net {
+namespace local {
+// Describes an endpoint of a unix domain socket. The address is a filesystem
+// path, or a name in the abstract namespace if the path starts with '\0', or
+// empty for an unnamed socket. Like the ip endpoint it's kept in its native
+// form, so the kernel can write a source address straight into data().
+template <typename Protocol>
+class basic_endpoint {
+ public:
+  // Associated protocol.
+  using protocol_type = Protocol;
+
+  // Default constructor, an unnamed endpoint.
+  basic_endpoint() noexcept : data_{}, size_(path_offset) {
+    data_.sun_family = AF_UNIX;
+  }
+
+  // Construct an endpoint with the given path, which must be shorter than
+  // `max_path_length` bytes.
+  basic_endpoint(std::string_view path) noexcept  // NOLINT
+      : basic_endpoint() {
+    set_path(path);
+  }
+
+  basic_endpoint(const char* path) noexcept  // NOLINT
+      : basic_endpoint(std::string_view{path}) {}
+
+  // Construct from a native address of `size` bytes.
+  basic_endpoint(const ::sockaddr_un& addr, ::socklen_t size) noexcept
+      : data_(addr),
+        size_(std::clamp<::socklen_t>(size, path_offset, capacity())) {}
+
+  // The longest path, not counting the terminating null of a filesystem
+  // path.
+  static constexpr std::size_t max_path_length =
+      sizeof(::sockaddr_un::sun_path);
+
+  // The protocol associated with the endpoint.
+  constexpr protocol_type protocol() const noexcept { return protocol_type{}; }
+
+  // The path, with the leading '\0' of an abstract name.
+  std::string_view path() const noexcept {
+    std::size_t length = size_ - path_offset;
+    if (length > 0 && data_.sun_path[0] != '\0') {
+      // A filesystem path may carry its terminating null.
+      length = ::strnlen(data_.sun_path, length);
+    }
+    return {data_.sun_path, length};
+  }
+
+  // Set the path, which must be shorter than `max_path_length` bytes.
+  void set_path(std::string_view path) noexcept {
+    assert(path.size() < max_path_length);
+    const std::size_t length = std::min(path.size(), max_path_length - 1);
+    std::memcpy(data_.sun_path, path.data(), length);
+    data_.sun_path[length] = '\0';
+    // Abstract names are sized exactly, they may contain nulls.
+    const bool abstract = length > 0 && path[0] == '\0';
+    size_ = static_cast<::socklen_t>(path_offset + length + (abstract ? 0 : 1));
+  }
+
+  // Whether the endpoint names an address in the abstract namespace.
+  bool is_abstract() const noexcept {
+    return size_ > path_offset && data_.sun_path[0] == '\0';
+  }
+
+  // Get the address in the native type.
+  ::socklen_t native_address(::sockaddr_storage* storage) const noexcept {
+    std::memcpy(storage, &data_, size_);
+    return size_;
+  }
+
+  // The native address, which a system call may also write to, with up to
+  // capacity() bytes. Call resize() with the length it reported.
+  ::sockaddr* data() noexcept { return reinterpret_cast<::sockaddr*>(&data_); }
+
+  // The native address.
+  const ::sockaddr* data() const noexcept {
+    return reinterpret_cast<const ::sockaddr*>(&data_);
+  }
+
+  // The size of the native address.
+  ::socklen_t size() const noexcept { return size_; }
+
+  // Set the size of the native address after a system call wrote to data().
+  void resize(::socklen_t size) noexcept {
+    size_ = std::clamp<::socklen_t>(size, path_offset, capacity());
+  }
+
+  // The size of the storage behind data().
+  static constexpr ::socklen_t capacity() noexcept { return sizeof(data_); }
+
+  // Whether the native address is a unix domain one. It may not after a
+  // system call wrote to data().
+  bool is_valid() const noexcept { return data_.sun_family == AF_UNIX; }
+
+  // Compare two endpoints for equality.
+  friend bool operator==(const basic_endpoint& a,
+                         const basic_endpoint& b) noexcept {
+    return a.path() == b.path();
+  }
+
+ private:
+  // The offset of the path in the native address.
+  static constexpr ::socklen_t path_offset = offsetof(::sockaddr_un, sun_path);
+
+  ::sockaddr_un data_;
+  ::socklen_t size_;
+};
+
+}  // namespace local
+}  // namespace net
+
+#endif  // LOCAL_BASIC_ENDPOINT_HPP_
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LOCAL_CONNECT_PAIR_HPP_
+#define LOCAL_CONNECT_PAIR_HPP_
+
+#include <sys/socket.h>
+
+#include "basic_socket.hpp"
+#include "status-code/system_code.hpp"
+
+namespace net {
+namespace local {
+// Open a pair of connected unix domain sockets with socketpair(2), e.g. to
+// hand one end to a child process. Both are close-on-exec.
+template <typename Protocol>
+system_error2::system_code connect_pair(
+    basic_socket<Protocol>& socket1, basic_socket<Protocol>& socket2) noexcept {
+  const Protocol protocol{};
+  int fds[2];
+  if (::socketpair(protocol.family(), protocol.type() | SOCK_CLOEXEC,
+                   protocol.protocol(), fds) != 0) {
+    return system_error2::posix_code::current();
+  }
+  socket1.assign(protocol, fds[0]);
+  socket2.assign(protocol, fds[1]);
+  return system_error2::errc::success;
+}
+
+}  // namespace local
+}  // namespace net
+
+#endif  // LOCAL_CONNECT_PAIR_HPP_
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LOCAL_DATAGRAM_PROTOCOL_HPP_
+#define LOCAL_DATAGRAM_PROTOCOL_HPP_
+
+#include <sys/socket.h>
+
+#include "basic_datagram_socket.hpp"
+#include "local/basic_endpoint.hpp"
+
+namespace net {
+namespace local {
+// Encapsulates the flags needed for datagram-oriented unix domain sockets.
+// Datagrams are reliable and keep their order, unlike udp.
+class datagram_protocol {
+ public:
+  // The type of a unix domain endpoint.
+  using endpoint = basic_endpoint<datagram_protocol>;
+
+  // The unix domain datagram socket type.
+  using socket = basic_datagram_socket<datagram_protocol>;
+
+  // Obtain an identifier for the type of the protocol.
+  constexpr int type() const noexcept { return SOCK_DGRAM; }
+
+  // Obtain an identifier for the protocol.
+  constexpr int protocol() const noexcept { return 0; }
+
+  // Obtain an identifier for the protocol family.
+  constexpr int family() const noexcept { return AF_UNIX; }
+
+  // Compare two protocols for equality.
+  constexpr friend bool operator==(const datagram_protocol&,
+                                   const datagram_protocol&) {
+    return true;
+  }
+
+  // Compare two protocols for inequality.
+  constexpr friend bool operator!=(const datagram_protocol&,
+                                   const datagram_protocol&) {
+    return false;
+  }
+};
+
+}  // namespace local
+}  // namespace net
+
+#endif  // LOCAL_DATAGRAM_PROTOCOL_HPP_
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LOCAL_STREAM_PROTOCOL_HPP_
+#define LOCAL_STREAM_PROTOCOL_HPP_
+
+#include <sys/socket.h>
+
+#include "basic_socket_acceptor.hpp"
+#include "basic_stream_socket.hpp"
+#include "local/basic_endpoint.hpp"
+
+namespace net {
+namespace local {
+// Encapsulates the flags needed for stream-oriented unix domain sockets.
+// Besides being cheaper than loopback tcp, they pass descriptors, see
+// `async_send_fds`.
+class stream_protocol {
+ public:
+  // The type of a unix domain endpoint.
+  using endpoint = basic_endpoint<stream_protocol>;
+
+  // The unix domain stream socket type.
+  using socket = basic_stream_socket<stream_protocol>;
+
+  // The unix domain acceptor type.
+  using acceptor = basic_socket_acceptor<stream_protocol>;
+
+  // Obtain an identifier for the type of the protocol.
+  constexpr int type() const noexcept { return SOCK_STREAM; }
+
+  // Obtain an identifier for the protocol.
+  constexpr int protocol() const noexcept { return 0; }
+
+  // Obtain an identifier for the protocol family.
+  constexpr int family() const noexcept { return AF_UNIX; }
+
+  // Compare two protocols for equality.
+  constexpr friend bool operator==(const stream_protocol&,
+                                   const stream_protocol&) {
+    return true;
+  }
+
+  // Compare two protocols for inequality.
+  constexpr friend bool operator!=(const stream_protocol&,
+                                   const stream_protocol&) {
+    return false;
+  }
+};
+
+}  // namespace local
+}  // namespace net
+
+#endif  // LOCAL_STREAM_PROTOCOL_HPP_
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LOOP_PROFILER_HPP_
+#define LOOP_PROFILER_HPP_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "fast_monotonic_clock.hpp"
+#include "latency_histogram.hpp"
+#include "monotonic_clock.hpp"
+
+namespace net {
+
+// The phases of one iteration of a run loop.
+enum class loop_phase : std::uint8_t {
+  // Executing the operations of the local queue.
+  execute_local,
+  // Reaping elapsed timers and re-arming the timer.
+  update_timers,
+  // Running the loop tasks.
+  loop_tasks,
+  // Moving the remote queue to the local queue.
+  collect_remote,
+  // Waiting in epoll_wait, or spinning on it.
+  wait,
+  // Handing the returned events to the parked operations.
+  dispatch
+};
+
+inline constexpr std::size_t loop_phase_count = 6;
+
+// Splits the time of a run loop into its phases. The loop calls `mark` at the
+// end of each phase, which attributes the time since the previous mark to
+// that phase, read from the time stamp counter through
+// `fast_monotonic_clock`. Each phase has a histogram of its durations and a
+// total, and the last phases can be kept in a ring buffer to be dumped.
+//
+// Only the loop thread marks phases. Histograms and totals can be read from
+// any thread, the trace only while the loop isn't running. If `Enabled` is
+// false, the profiler is an empty type and marks compile to nothing.
+template <bool Enabled>
+class loop_profiler {
+ public:
+  // One phase in the trace.
+  struct trace_entry {
+    loop_phase phase;
+    monotonic_clock::time_point start;
+    std::chrono::nanoseconds duration;
+  };
+
+  // Start timing, the next mark ends the first phase.
+  void start() noexcept { last_ = fast_monotonic_clock::now(); }
+
+  // End `phase`. A phase which was skipped passes `ran` as false, its time
+  // isn't recorded.
+  void mark(loop_phase phase, bool ran = true) noexcept {
+    const monotonic_clock::time_point now = fast_monotonic_clock::now();
+    if (ran) {
+      const std::chrono::nanoseconds elapsed{
+          (now.seconds() - last_.seconds()) * 1'000'000'000 +
+          (now.nanoseconds() - last_.nanoseconds())};
+      auto& stats = phases_[static_cast<std::size_t>(phase)];
+      stats.histogram.record(elapsed);
+      stats.total.store(
+          stats.total.load(std::memory_order_relaxed) +
+              static_cast<std::uint64_t>(elapsed.count()),
+          std::memory_order_relaxed);
+      if (!trace_.empty()) {
+        trace_[trace_next_ % trace_.size()] = {phase, last_, elapsed};
+        ++trace_next_;
+      }
+    }
+    last_ = now;
+  }
+
+  // The durations of `phase`.
+  const latency_histogram& histogram(loop_phase phase) const noexcept {
+    return phases_[static_cast<std::size_t>(phase)].histogram;
+  }
+
+  // The time spent in `phase` so far.
+  std::chrono::nanoseconds total(loop_phase phase) const noexcept {
+    return std::chrono::nanoseconds(
+        phases_[static_cast<std::size_t>(phase)].total.load(
+            std::memory_order_relaxed));
+  }
+
+  // Keep the last `capacity` phases, zero turns the trace off. Must not be
+  // called while the loop is running.
+  void set_trace_capacity(std::size_t capacity) {
+    trace_.assign(capacity, trace_entry{});
+    trace_next_ = 0;
+  }
+
+  // The kept phases, oldest first. Must not be called while the loop is
+  // running.
+  std::vector<trace_entry> trace() const {
+    std::vector<trace_entry> result;
+    const std::size_t size = std::min(trace_next_, trace_.size());
+    result.reserve(size);
+    for (std::size_t i = trace_next_ - size; i < trace_next_; ++i) {
+      result.push_back(trace_[i % trace_.size()]);
+    }
+    return result;
+  }
+
+ private:
+  struct phase_stats {
+    latency_histogram histogram;
+    std::atomic<std::uint64_t> total{0};
+  };
+
+  monotonic_clock::time_point last_;
+  std::array<phase_stats, loop_phase_count> phases_;
+  std::vector<trace_entry> trace_;
+  std::size_t trace_next_ = 0;
+};
+
+template <>
+class loop_profiler<false> {
+ public:
+  struct trace_entry {
+    loop_phase phase;
+    monotonic_clock::time_point start;
+    std::chrono::nanoseconds duration;
+  };
+
+  void start() noexcept {}
+
+  void mark(loop_phase, bool = true) noexcept {}
+
+  const latency_histogram& histogram(loop_phase) const noexcept {
+    static const latency_histogram empty;
+    return empty;
+  }
+
+  std::chrono::nanoseconds total(loop_phase) const noexcept {
+    return std::chrono::nanoseconds::zero();
+  }
+
+  void set_trace_capacity(std::size_t) {}
+
+  std::vector<trace_entry> trace() const { return {}; }
+};
+
+}  // namespace net
+
+#endif  // LOOP_PROFILER_HPP_
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MAPPED_FILE_HPP_
+#define MAPPED_FILE_HPP_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <system_error>  // NOLINT
+#include <utility>
+
+#include "buffer.hpp"
+
+namespace net {
+
+// A read-only file mapped into memory. Regions of the file are handed out as
+// `const_buffer` sequences that share a reference count on the mapping, so a
+// send in flight keeps the pages mapped even if the `mapped_file` is gone.
+// The reference count is atomic, regions may be copied to and released on
+// other threads.
+class mapped_file {
+  struct mapping {
+    std::atomic<std::size_t> refs;
+    void* addr;
+    std::size_t size;
+  };
+
+ public:
+  // How the file is mapped.
+  struct options {
+    // Tell the kernel the pages are read in order, so it reads ahead more
+    // aggressively and drops the pages behind earlier (MADV_SEQUENTIAL).
+    bool sequential = true;
+
+    // Fault in the whole file while mapping it (MAP_POPULATE), so the first
+    // send doesn't stall on page faults.
+    bool populate = false;
+  };
+
+  // A range of the mapped file. It models `const_buffer_sequence` with a
+  // single buffer and can be passed to the send operations directly.
+  class region {
+   public:
+    using value_type = const_buffer;
+    using const_iterator = const const_buffer*;
+
+    // Constructor. The default region is empty.
+    region() noexcept : mapping_(nullptr), buffer_() {}
+
+    region(const region& other) noexcept
+        : mapping_(other.mapping_), buffer_(other.buffer_) {
+      retain();
+    }
+
+    region(region&& other) noexcept
+        : mapping_(std::exchange(other.mapping_, nullptr)),
+          buffer_(std::exchange(other.buffer_, const_buffer{})) {}
+
+    region& operator=(const region& other) noexcept {
+      region copy{other};
+      swap(copy);
+      return *this;
+    }
+
+    region& operator=(region&& other) noexcept {
+      region moved{static_cast<region&&>(other)};
+      swap(moved);
+      return *this;
+    }
+
+    // Destructor.
+    ~region() { release(); }
+
+    const_iterator begin() const noexcept { return &buffer_; }
+
+    const_iterator end() const noexcept { return &buffer_ + 1; }
+
+    const_buffer buffer() const noexcept { return buffer_; }
+
+    const void* data() const noexcept { return buffer_.data(); }
+
+    std::size_t size() const noexcept { return buffer_.size(); }
+
+    // A part of this region, clamped to its end.
+    region subregion(std::size_t offset, std::size_t size) const noexcept {
+      region sub{*this};
+      sub.buffer_ = net::buffer(buffer_ + offset, size);
+      return sub;
+    }
+
+    // The count of regions sharing the mapping.
+    std::size_t use_count() const noexcept {
+      return mapping_ ? mapping_->refs.load(std::memory_order_relaxed) : 0;
+    }
+
+   private:
+    friend class mapped_file;
+
+    // Take over a reference of `m`.
+    region(mapping* m, const_buffer buffer) noexcept
+        : mapping_(m), buffer_(buffer) {}
+
+    void swap(region& other) noexcept {
+      std::swap(mapping_, other.mapping_);
+      std::swap(buffer_, other.buffer_);
+    }
+
+    void retain() noexcept {
+      if (mapping_ != nullptr) {
+        mapping_->refs.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+    void release() noexcept {
+      if (mapping_ != nullptr &&
+          mapping_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        ::munmap(mapping_->addr, mapping_->size);
+        delete mapping_;
+      }
+      mapping_ = nullptr;
+    }
+
+    mapping* mapping_;
+    const_buffer buffer_;
+  };
+
+  // Constructor. The default file is empty.
+  mapped_file() noexcept = default;
+
+  // Map the file at `path`. Throws an error when the file can't be opened or
+  // mapped.
+  explicit mapped_file(const char* path) : mapped_file(path, options{}) {}
+
+  mapped_file(const char* path, options opts) {
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      throw std::system_error{static_cast<int>(errno), std::system_category(),
+                              "open"};
+    }
+    try {
+      map(fd, opts);
+    } catch (...) {
+      ::close(fd);
+      throw;
+    }
+    ::close(fd);
+  }
+
+  // Map the whole file behind the descriptor `fd`, which may be closed
+  // afterwards. Throws an error when the file can't be mapped.
+  mapped_file(int fd, options opts) { map(fd, opts); }
+
+  // The size of the file.
+  std::size_t size() const noexcept { return whole_.size(); }
+
+  // The bytes of the file.
+  const void* data() const noexcept { return whole_.data(); }
+
+  // The whole file as a region.
+  const region& whole() const noexcept { return whole_; }
+
+  // A range of the file, clamped to its end.
+  region subregion(std::size_t offset, std::size_t size) const noexcept {
+    return whole_.subregion(offset, size);
+  }
+
+ private:
+  void map(int fd, options opts) {
+    struct ::stat st;
+    if (::fstat(fd, &st) != 0) {
+      throw std::system_error{static_cast<int>(errno), std::system_category(),
+                              "fstat"};
+    }
+    auto size = static_cast<std::size_t>(st.st_size);
+    // An empty file can't be mapped, it's just an empty region.
+    if (size == 0) {
+      return;
+    }
+    int flags = MAP_PRIVATE | (opts.populate ? MAP_POPULATE : 0);
+    void* addr = ::mmap(nullptr, size, PROT_READ, flags, fd, 0);
+    if (addr == MAP_FAILED) {
+      throw std::system_error{static_cast<int>(errno), std::system_category(),
+                              "mmap"};
+    }
+    if (opts.sequential) {
+      // Only a hint, failing to apply it doesn't matter.
+      (void)::madvise(addr, size, MADV_SEQUENTIAL);
+    }
+    mapping* m = nullptr;
+    try {
+      m = new mapping{.refs{1}, .addr = addr, .size = size};
+    } catch (...) {
+      ::munmap(addr, size);
+      throw;
+    }
+    whole_ = region{m, const_buffer{addr, size}};
+  }
+
+  region whole_;
+};
+
+}  // namespace net
+
+#endif  // MAPPED_FILE_HPP_
@@ -26,8 +26,6 @@ template <typename Protocol>
 concept transport_protocol = requires(Protocol& proto) {
                                typename Protocol::endpoint;
                                typename Protocol::socket;
-                               { Protocol::v4() } -> std::same_as<Protocol>;
-                               { Protocol::v6() } -> std::same_as<Protocol>;
                                { proto.type() } -> std::same_as<int>;
                                { proto.protocol() } -> std::same_as<int>;
                                { proto.family() } -> std::same_as<int>;
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MONOTONIC_ARENA_HPP_
+#define MONOTONIC_ARENA_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+namespace net {
+
+// A bump allocator for objects which die together, e.g. everything a request
+// handler allocates until the response is sent. Memory is carved from blocks
+// obtained with `malloc`, a full block is chained to a new one twice as
+// large. `deallocate` only gives back the latest allocation, everything else
+// is released at once by `reset`. Not thread safe.
+//
+// Expose an arena to the senders of a request with `with_allocator`.
+class monotonic_arena {
+ public:
+  // The allocator handing out the memory of an arena.
+  template <typename T>
+  class allocator;
+
+  // The size of the first block by default.
+  static constexpr std::size_t default_block_size = 4096;
+
+  // Constructor. The first block of `initial_size` bytes is allocated up
+  // front. Throws std::bad_alloc.
+  explicit monotonic_arena(std::size_t initial_size = default_block_size)
+      : current_(nullptr), ptr_(nullptr), end_(nullptr), capacity_(0) {
+    add_block(std::max<std::size_t>(initial_size, sizeof(block)));
+  }
+
+  monotonic_arena(const monotonic_arena&) = delete;
+  monotonic_arena& operator=(const monotonic_arena&) = delete;
+
+  // Destructor releases the blocks.
+  ~monotonic_arena() { release_blocks(current_); }
+
+  // Allocate `size` bytes aligned to `align`. Throws std::bad_alloc.
+  void* allocate(std::size_t size,
+                 std::size_t align = alignof(std::max_align_t)) {
+    char* p = align_up(ptr_, align);
+    if (size > static_cast<std::size_t>(end_ - p)) {
+      add_block(std::max(current_->size_ * 2, sizeof(block) + size + align));
+      p = align_up(ptr_, align);
+    }
+    ptr_ = p + size;
+    return p;
+  }
+
+  // Give back `size` bytes at `p` if they are the latest allocation, so a
+  // growing container doesn't leave its old storage behind.
+  void deallocate(void* p, std::size_t size) noexcept {
+    if (static_cast<char*>(p) + size == ptr_) {
+      ptr_ = static_cast<char*>(p);
+    }
+  }
+
+  // Release every allocation. If more than one block was needed, they are
+  // replaced by a single block of their total size, so the next round of
+  // allocations of the same size is carved from one block.
+  void reset() noexcept {
+    if (current_->prev_ != nullptr) {
+      const std::size_t total = capacity_;
+      release_blocks(std::exchange(current_, nullptr));
+      capacity_ = 0;
+      if (block* b = static_cast<block*>(std::malloc(total))) {
+        use_block(b, total);
+        return;
+      }
+      // Out of memory, fall back to the smallest block.
+      add_block(default_block_size);
+      return;
+    }
+    ptr_ = reinterpret_cast<char*>(current_ + 1);
+  }
+
+  // The bytes handed out from the current block, with the alignment padding.
+  std::size_t bytes_used() const noexcept {
+    return static_cast<std::size_t>(
+        ptr_ - reinterpret_cast<const char*>(current_ + 1));
+  }
+
+  // The total size of the blocks.
+  std::size_t capacity() const noexcept { return capacity_; }
+
+  // The count of blocks.
+  std::size_t block_count() const noexcept {
+    std::size_t count = 0;
+    for (const block* b = current_; b != nullptr; b = b->prev_) {
+      ++count;
+    }
+    return count;
+  }
+
+  // Get an allocator of this arena.
+  template <typename T = std::byte>
+  constexpr allocator<T> get_allocator() noexcept;
+
+ private:
+  // The header of a block, the memory handed out follows it.
+  struct alignas(std::max_align_t) block {
+    block* prev_;
+    std::size_t size_;
+  };
+
+  static char* align_up(char* p, std::size_t align) noexcept {
+    const auto address = reinterpret_cast<std::uintptr_t>(p);
+    return p + ((align - address % align) % align);
+  }
+
+  void add_block(std::size_t size) {
+    auto* b = static_cast<block*>(std::malloc(size));
+    if (b == nullptr) {
+      throw std::bad_alloc{};
+    }
+    use_block(b, size);
+  }
+
+  void use_block(block* b, std::size_t size) noexcept {
+    b->prev_ = current_;
+    b->size_ = size;
+    current_ = b;
+    ptr_ = reinterpret_cast<char*>(b + 1);
+    end_ = reinterpret_cast<char*>(b) + size;
+    capacity_ += size;
+  }
+
+  static void release_blocks(block* b) noexcept {
+    while (b != nullptr) {
+      std::free(std::exchange(b, b->prev_));
+    }
+  }
+
+  block* current_;
+  char* ptr_;
+  char* end_;
+  std::size_t capacity_;
+};
+
+template <typename T>
+class monotonic_arena::allocator {
+ public:
+  using value_type = T;
+
+  explicit constexpr allocator(monotonic_arena& arena) noexcept
+      : arena_(&arena) {}
+
+  template <typename U>
+  constexpr allocator(const allocator<U>& other) noexcept  // NOLINT
+      : arena_(other.arena_) {}
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* p, std::size_t n) noexcept {
+    arena_->deallocate(p, n * sizeof(T));
+  }
+
+  // The arena this allocator hands out.
+  constexpr monotonic_arena& arena() const noexcept { return *arena_; }
+
+  template <typename U>
+  friend constexpr bool operator==(const allocator& a,
+                                   const allocator<U>& b) noexcept {
+    return &a.arena() == &b.arena();
+  }
+
+ private:
+  template <typename U>
+  friend class allocator;
+
+  monotonic_arena* arena_;
+};
+
+template <typename T>
+inline constexpr monotonic_arena::allocator<T>
+monotonic_arena::get_allocator() noexcept {
+  return allocator<T>{*this};
+}
+
+}  // namespace net
+
+#endif  // MONOTONIC_ARENA_HPP_
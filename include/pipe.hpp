@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef PIPE_HPP_
+#define PIPE_HPP_
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <system_error>  // NOLINT
+
+#include "exec/linux/safe_file_descriptor.hpp"
+#include "status-code/result.hpp"
+#include "status-code/system_code.hpp"
+
+namespace net {
+
+// A non-blocking pipe used as the kernel buffer of splice(2), which moves
+// data between two descriptors without copying it to user space. A pipe can
+// be reused by operations one after another.
+class pipe {
+ public:
+  // Constructor. Throws an error when the pipe can't be created.
+  pipe() {
+    int fds[2];
+    if (::pipe2(fds, O_NONBLOCK | O_CLOEXEC) != 0) {
+      throw std::system_error{static_cast<int>(errno), std::system_category(),
+                              "pipe2"};
+    }
+    read_end_.reset(fds[0]);
+    write_end_.reset(fds[1]);
+  }
+
+  pipe(const pipe&) = delete;
+  pipe& operator=(const pipe&) = delete;
+
+  // The read end of the pipe.
+  int read_end() const noexcept { return read_end_.native_handle(); }
+
+  // The write end of the pipe.
+  int write_end() const noexcept { return write_end_.native_handle(); }
+
+  // Move up to `count` bytes from `fd` into the pipe.
+  system_error2::result<std::size_t> splice_from(int fd,
+                                                 std::size_t count) noexcept {
+    return splice(fd, write_end(), count);
+  }
+
+  // Move up to `count` bytes from the pipe to `fd`.
+  system_error2::result<std::size_t> splice_to(int fd,
+                                               std::size_t count) noexcept {
+    return splice(read_end(), fd, count);
+  }
+
+ private:
+  static system_error2::result<std::size_t> splice(int in, int out,
+                                                   std::size_t count) noexcept {
+    while (true) {
+      ::ssize_t result = ::splice(in, nullptr, out, nullptr, count,
+                                  SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+      if (result >= 0) {
+        return static_cast<std::size_t>(result);
+      }
+      if (errno != EINTR) {
+        return system_error2::posix_code::current();
+      }
+    }
+  }
+
+  exec::safe_file_descriptor read_end_;
+  exec::safe_file_descriptor write_end_;
+};
+
+}  // namespace net
+
+#endif  // PIPE_HPP_
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef POSIX_STREAM_DESCRIPTOR_HPP_
+#define POSIX_STREAM_DESCRIPTOR_HPP_
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <utility>
+
+#include "exec/linux/safe_file_descriptor.hpp"
+#include "execution_context.hpp"
+#include "net_error.hpp"
+#include "status-code/result.hpp"
+#include "status-code/system_code.hpp"
+
+namespace net::posix {
+
+// A stream-oriented file descriptor other than a socket, e.g. a pipe to a
+// child process, an eventfd or a character device, owned for the reactor of
+// its context like a socket. Reads and writes don't block once
+// `set_non_blocking(true)` has been called, which the asynchronous
+// operations need.
+class stream_descriptor {
+ public:
+  using native_handle_type = int;
+  using context_type = execution_context;
+
+  // Constructor.
+  explicit stream_descriptor(context_type& ctx) noexcept
+      : descriptor_(), descriptor_data_(nullptr), context_(&ctx) {}
+
+  // Take ownership of `fd`.
+  stream_descriptor(context_type& ctx, native_handle_type fd) noexcept
+      : descriptor_(fd), descriptor_data_(nullptr), context_(&ctx) {}
+
+  // Move constructor.
+  stream_descriptor(stream_descriptor&& o) noexcept
+      : descriptor_(static_cast<exec::safe_file_descriptor&&>(o.descriptor_)),
+        descriptor_data_(std::exchange(o.descriptor_data_, nullptr)),
+        context_(o.context_) {}
+
+  // Move assign.
+  stream_descriptor& operator=(stream_descriptor&& o) noexcept {
+    release_descriptor_data();
+    descriptor_ = static_cast<exec::safe_file_descriptor&&>(o.descriptor_);
+    descriptor_data_ = std::exchange(o.descriptor_data_, nullptr);
+    context_ = o.context_;
+    return *this;
+  }
+
+  // Destructor. Closes the descriptor.
+  ~stream_descriptor() { release_descriptor_data(); }
+
+  stream_descriptor(const stream_descriptor&) = delete;
+  stream_descriptor& operator=(const stream_descriptor&) = delete;
+
+  // Get associated context.
+  context_type& context() noexcept { return *context_; }
+
+  // Get the native descriptor.
+  native_handle_type native_handle() const noexcept {
+    return descriptor_.native_handle();
+  }
+
+  // Get the opaque per-descriptor state attached by the associated context.
+  void*& descriptor_data() noexcept { return descriptor_data_; }
+
+  // Whether a descriptor is owned.
+  bool is_open() const noexcept { return descriptor_.native_handle() != -1; }
+
+  // Take ownership of `fd`, closing the descriptor owned so far.
+  void assign(native_handle_type fd) noexcept {
+    release_descriptor_data();
+    descriptor_.reset(fd);
+  }
+
+  // Close the descriptor.
+  system_error2::system_code close() noexcept {
+    if (!is_open()) {
+      return system_error2::errc::bad_file_descriptor;
+    }
+    release_descriptor_data();
+    descriptor_.reset();
+    return system_error2::errc::success;
+  }
+
+  // Set or clear O_NONBLOCK.
+  system_error2::system_code set_non_blocking(bool mode) noexcept {
+    int flags = ::fcntl(native_handle(), F_GETFL, 0);
+    if (flags < 0) {
+      return system_error2::posix_code::current();
+    }
+    flags = mode ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    if (::fcntl(native_handle(), F_SETFL, flags) != 0) {
+      return system_error2::posix_code::current();
+    }
+    return system_error2::errc::success;
+  }
+
+  // Read into `count` buffers. A closed write end reads as
+  // `network_errc::eof`.
+  system_error2::result<std::size_t> read_some(const ::iovec* bufs,
+                                               std::size_t count) noexcept {
+    while (true) {
+      ::ssize_t n = ::readv(native_handle(), bufs, static_cast<int>(count));
+      if (n > 0) {
+        return static_cast<std::size_t>(n);
+      }
+      if (n == 0) {
+        return network_errc::eof;
+      }
+      if (errno != EINTR) {
+        return system_error2::posix_code::current();
+      }
+    }
+  }
+
+  // Write from `count` buffers. Writing to a pipe whose read end is closed
+  // raises SIGPIPE unless the signal is ignored.
+  system_error2::result<std::size_t> write_some(const ::iovec* bufs,
+                                                std::size_t count) noexcept {
+    while (true) {
+      ::ssize_t n = ::writev(native_handle(), bufs, static_cast<int>(count));
+      if (n >= 0) {
+        return static_cast<std::size_t>(n);
+      }
+      if (errno != EINTR) {
+        return system_error2::posix_code::current();
+      }
+    }
+  }
+
+ private:
+  // Let the associated context release the per-descriptor state before the
+  // descriptor is closed or given away.
+  void release_descriptor_data() noexcept {
+    if (descriptor_data_ != nullptr) {
+      context_->deregister_descriptor(descriptor_, descriptor_data_);
+    }
+  }
+
+  exec::safe_file_descriptor descriptor_;
+  void* descriptor_data_;
+  context_type* context_;
+};
+
+}  // namespace net::posix
+
+#endif  // POSIX_STREAM_DESCRIPTOR_HPP_
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef RECYCLING_ALLOCATOR_HPP_
+#define RECYCLING_ALLOCATOR_HPP_
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+namespace net {
+
+// Per-thread cache of recently freed memory blocks, the stdexec-era port of
+// the recycling in `thread_info_base.h`. Each purpose owns a few slots, and a
+// block freed on a thread is handed to the next allocation of the same purpose
+// on that thread while it's still hot in the cache of the core. Every block
+// records its size in a trailing byte, so it can be freed on any thread and
+// recycled by whichever thread frees it.
+//
+// An epoll_context installs its own instance as the current one of its io
+// thread while it runs. Other threads have no current instance and go to the
+// heap directly.
+class thread_info_base {
+ public:
+  // Purposes of the cached memory, each with its own range of slots.
+  struct operation_tag {
+    static constexpr int begin_index = 0;
+    static constexpr int end_index = 4;
+  };
+
+  struct buffer_tag {
+    static constexpr int begin_index = 4;
+    static constexpr int end_index = 6;
+  };
+
+  struct timer_tag {
+    static constexpr int begin_index = 6;
+    static constexpr int end_index = 8;
+  };
+
+  struct frame_tag {
+    static constexpr int begin_index = 8;
+    static constexpr int end_index = 10;
+  };
+
+  // The count of slots.
+  static constexpr int cache_size = 10;
+
+  // The granularity of block sizes. Blocks larger than `chunk_size *
+  // UCHAR_MAX` bytes are never cached.
+  static constexpr std::size_t chunk_size = 16;
+
+  // Constructor.
+  thread_info_base() noexcept : reusable_memory_{} {}
+
+  thread_info_base(const thread_info_base&) = delete;
+  thread_info_base& operator=(const thread_info_base&) = delete;
+
+  // Destructor releases the cached blocks.
+  ~thread_info_base() {
+    for (void*& pointer : reusable_memory_) {
+      std::free(std::exchange(pointer, nullptr));
+    }
+  }
+
+  // The instance of the calling thread, or nullptr.
+  static thread_info_base*& current() noexcept {
+    static thread_local thread_info_base* instance = nullptr;
+    return instance;
+  }
+
+  // Allocate `size` bytes aligned to `align`, reusing a cached block of
+  // `this_thread` if one is large enough.
+  template <typename Purpose>
+  static void* allocate(thread_info_base* this_thread, std::size_t size,
+                        std::size_t align = __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+    const std::size_t chunks = (size + chunk_size - 1) / chunk_size;
+    if (this_thread != nullptr) {
+      for (int i = Purpose::begin_index; i < Purpose::end_index; ++i) {
+        void* const pointer = this_thread->reusable_memory_[i];
+        if (pointer == nullptr) {
+          continue;
+        }
+        auto* const mem = static_cast<unsigned char*>(pointer);
+        if (static_cast<std::size_t>(mem[0]) >= chunks &&
+            reinterpret_cast<std::size_t>(pointer) % align == 0) {
+          this_thread->reusable_memory_[i] = nullptr;
+          mem[size] = mem[0];
+          return pointer;
+        }
+      }
+
+      // None fits, drop one so the cache follows the current sizes.
+      for (int i = Purpose::begin_index; i < Purpose::end_index; ++i) {
+        if (void* pointer = std::exchange(this_thread->reusable_memory_[i],
+                                          nullptr)) {
+          std::free(pointer);
+          break;
+        }
+      }
+    }
+
+    void* const pointer = aligned_alloc(align, chunks * chunk_size + 1);
+    auto* const mem = static_cast<unsigned char*>(pointer);
+    mem[size] = (chunks <= UCHAR_MAX) ? static_cast<unsigned char>(chunks) : 0;
+    return pointer;
+  }
+
+  // Free a block got from `allocate` with the same `size`, caching it on
+  // `this_thread` if a slot is free.
+  template <typename Purpose>
+  static void deallocate(thread_info_base* this_thread, void* pointer,
+                         std::size_t size) noexcept {
+    if (this_thread != nullptr && size <= chunk_size * UCHAR_MAX) {
+      for (int i = Purpose::begin_index; i < Purpose::end_index; ++i) {
+        if (this_thread->reusable_memory_[i] == nullptr) {
+          auto* const mem = static_cast<unsigned char*>(pointer);
+          mem[0] = mem[size];
+          this_thread->reusable_memory_[i] = pointer;
+          return;
+        }
+      }
+    }
+    std::free(pointer);
+  }
+
+ private:
+  // Allocate at least `size` bytes aligned to `align`. Throws std::bad_alloc.
+  static void* aligned_alloc(std::size_t align, std::size_t size) {
+    align = std::max<std::size_t>(align, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+    size = (size + align - 1) / align * align;
+    void* pointer = std::aligned_alloc(align, size);
+    if (pointer == nullptr) {
+      throw std::bad_alloc{};
+    }
+    return pointer;
+  }
+
+  void* reusable_memory_[cache_size];
+};
+
+// A stateless allocator recycling memory through the `thread_info_base` of
+// the calling thread. Use `Purpose` to keep e.g. buffers from evicting
+// operation states.
+template <typename T, typename Purpose = thread_info_base::operation_tag>
+class recycling_allocator {
+ public:
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = recycling_allocator<U, Purpose>;
+  };
+
+  constexpr recycling_allocator() noexcept = default;
+
+  template <typename U>
+  constexpr recycling_allocator(  // NOLINT
+      const recycling_allocator<U, Purpose>&) noexcept {}
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(thread_info_base::allocate<Purpose>(
+        thread_info_base::current(), sizeof(T) * n, alignof(T)));
+  }
+
+  void deallocate(T* p, std::size_t n) noexcept {
+    thread_info_base::deallocate<Purpose>(thread_info_base::current(), p,
+                                          sizeof(T) * n);
+  }
+
+  template <typename U>
+  friend constexpr bool operator==(
+      const recycling_allocator&,
+      const recycling_allocator<U, Purpose>&) noexcept {
+    return true;
+  }
+};
+
+}  // namespace net
+
+#endif  // RECYCLING_ALLOCATOR_HPP_
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef RESOLVER_POOL_HPP_
+#define RESOLVER_POOL_HPP_
+
+#include <netdb.h>
+
+#include <cassert>
+#include <condition_variable>  // NOLINT
+#include <cstddef>
+#include <mutex>               // NOLINT
+#include <string>
+#include <system_error>        // NOLINT
+#include <thread>              // NOLINT
+#include <vector>
+
+namespace net {
+
+// The error category of getaddrinfo failures, whose values are `EAI_*` codes.
+class resolver_category : public std::error_category {
+ public:
+  const char* name() const noexcept override { return "net.resolver"; }
+
+  std::string message(int value) const override {
+    return ::gai_strerror(value);
+  }
+};
+
+inline const std::error_category& resolver_category() {
+  static class resolver_category category;
+  return category;
+}
+
+// Make an error code from the result of getaddrinfo. `EAI_SYSTEM` is reported
+// with the saved `errno` in the system category.
+inline std::error_code make_resolver_error_code(int result,
+                                                int saved_errno) noexcept {
+  if (result == EAI_SYSTEM) {
+    return {saved_errno, std::system_category()};
+  }
+  return {result, resolver_category()};
+}
+
+// A few threads which run blocking calls such as getaddrinfo on behalf of I/O
+// threads, so a slow name server stalls a worker instead of a whole context.
+// Jobs are intrusive and run in the order they are submitted. Jobs still
+// queued when the pool is destroyed are run before the workers exit.
+class resolver_pool {
+ public:
+  // A unit of work. `run_` is called on a worker thread.
+  struct job {
+    job* next_ = nullptr;
+    void (*run_)(job*) noexcept = nullptr;  // NOLINT
+  };
+
+  // The count of workers of the shared pool.
+  static constexpr std::size_t default_thread_count = 2;
+
+  // Start `thread_count` workers.
+  explicit resolver_pool(std::size_t thread_count = default_thread_count)
+      : head_(nullptr), tail_(nullptr), stopping_(false) {
+    assert(thread_count > 0);
+    threads_.reserve(thread_count);
+    for (std::size_t i = 0; i < thread_count; ++i) {
+      threads_.emplace_back([this] { work(); });
+    }
+  }
+
+  resolver_pool(const resolver_pool&) = delete;
+  resolver_pool& operator=(const resolver_pool&) = delete;
+
+  // Run the remaining jobs and join the workers.
+  ~resolver_pool() {
+    {
+      std::lock_guard lock{mutex_};
+      stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  // The pool used when none is given, started on first use.
+  static resolver_pool& shared() {
+    static resolver_pool pool;
+    return pool;
+  }
+
+  // Queue `j` to be run by one of the workers. Can be called from any thread.
+  void submit(job* j) {
+    assert(j->run_ != nullptr);
+    j->next_ = nullptr;
+    {
+      std::lock_guard lock{mutex_};
+      if (tail_ == nullptr) {
+        head_ = j;
+      } else {
+        tail_->next_ = j;
+      }
+      tail_ = j;
+    }
+    cv_.notify_one();
+  }
+
+ private:
+  void work() {
+    std::unique_lock lock{mutex_};
+    while (true) {
+      cv_.wait(lock, [this] { return head_ != nullptr || stopping_; });
+      if (head_ == nullptr) {
+        return;
+      }
+      job* j = head_;
+      head_ = j->next_;
+      if (head_ == nullptr) {
+        tail_ = nullptr;
+      }
+      lock.unlock();
+      j->run_(j);
+      lock.lock();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+
+  // The queued jobs.
+  job* head_;
+  job* tail_;
+
+  // Set by the destructor, the workers exit once the queue is empty.
+  bool stopping_;
+
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace net
+
+#endif  // RESOLVER_POOL_HPP_
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SHARDED_INTRUSIVE_QUEUE_HPP_
+#define SHARDED_INTRUSIVE_QUEUE_HPP_
+
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+
+#include "stdexec/__detail/__intrusive_queue.hpp"
+
+namespace net {
+template <auto Next>
+class sharded_intrusive_queue;
+
+// A variant of `atomic_intrusive_queue` that spreads the producers over
+// several lanes, each a list on its own cache line, so that many threads
+// enqueueing at once don't all fight over one head. Each thread always uses
+// the same lane, so the items of one producer keep their order, but items of
+// different producers may be dequeued in any order.
+//
+// The consumer marks itself inactive with a flag separate from the lanes. A
+// producer pushes its item, then checks the flag, while the consumer sets the
+// flag, then checks the lanes. Both sides use sequentially consistent
+// operations, so either the producer sees the consumer inactive and wakes it
+// up, or the consumer sees the item. Both may happen, costing one spurious
+// wakeup.
+template <typename Item, Item* Item::*Next>
+class sharded_intrusive_queue<Next> {
+ public:
+  // The lane count is rounded up to a power of two.
+  explicit sharded_intrusive_queue(std::size_t lane_count)
+      : lanes_(std::make_unique<lane[]>(std::bit_ceil(lane_count))),
+        mask_(std::bit_ceil(lane_count) - 1),
+        inactive_(false) {}
+
+  ~sharded_intrusive_queue() {
+    // Check that all items in this queue have been dequeued.
+    assert(empty());
+  }
+
+  sharded_intrusive_queue(const sharded_intrusive_queue&) = delete;
+  sharded_intrusive_queue& operator=(const sharded_intrusive_queue&) = delete;
+
+  // The count of lanes.
+  std::size_t lane_count() const noexcept { return mask_ + 1; }
+
+  // Whether there is no item in the queue. Can be called from any thread, the
+  // result may be outdated as soon as it returns.
+  [[nodiscard]] bool empty() const noexcept {
+    for (std::size_t i = 0; i <= mask_; ++i) {
+      if (lanes_[i].head_.load(std::memory_order_relaxed) != nullptr) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Returns true if the consumer was inactive and has been marked active.
+  [[nodiscard]] bool try_mark_active() noexcept {
+    return inactive_.load(std::memory_order_relaxed) &&
+           inactive_.exchange(false, std::memory_order_acquire);
+  }
+
+  // Enqueue an item to the lane of the calling thread. Returns true if the
+  // consumer is inactive and needs to be woken up by the caller.
+  [[nodiscard]] bool enqueue(Item* item) noexcept {
+    std::atomic<Item*>& head = lanes_[lane_index() & mask_].head_;
+    Item* old_value = head.load(std::memory_order_relaxed);
+    do {
+      item->*Next = old_value;
+    } while (!head.compare_exchange_weak(old_value, item,
+                                         std::memory_order_seq_cst,
+                                         std::memory_order_relaxed));
+    return inactive_.load(std::memory_order_seq_cst) &&
+           inactive_.exchange(false, std::memory_order_acq_rel);
+  }
+
+  // Dequeue all items of all lanes, each lane in the order it was enqueued.
+  [[nodiscard]] stdexec::__intrusive_queue<Next> dequeue_all() noexcept {
+    stdexec::__intrusive_queue<Next> items;
+    for (std::size_t i = 0; i <= mask_; ++i) {
+      std::atomic<Item*>& head = lanes_[i].head_;
+      if (head.load(std::memory_order_relaxed) == nullptr) {
+        continue;
+      }
+      Item* value = head.exchange(nullptr, std::memory_order_acquire);
+      items.append(stdexec::__intrusive_queue<Next>::make_reversed(value));
+    }
+    return items;
+  }
+
+  // Either mark the consumer inactive if all lanes are empty, or dequeue
+  // their items and stay active.
+  [[nodiscard]] stdexec::__intrusive_queue<Next>
+  try_mark_inactive_or_dequeue_all() noexcept {
+    inactive_.store(true, std::memory_order_seq_cst);
+    for (std::size_t i = 0; i <= mask_; ++i) {
+      if (lanes_[i].head_.load(std::memory_order_seq_cst) != nullptr) {
+        // A producer seeing the flag in the meantime wakes us up for
+        // nothing.
+        inactive_.store(false, std::memory_order_relaxed);
+        return dequeue_all();
+      }
+    }
+    return {};
+  }
+
+ private:
+  struct alignas(64) lane {
+    std::atomic<Item*> head_{nullptr};
+  };
+
+  // The lane of the calling thread, assigned round robin on first use.
+  static std::size_t lane_index() noexcept {
+    static std::atomic<std::size_t> next_lane{0};
+    thread_local const std::size_t index =
+        next_lane.fetch_add(1, std::memory_order_relaxed);
+    return index;
+  }
+
+  std::unique_ptr<lane[]> lanes_;
+  std::size_t mask_;
+  alignas(64) std::atomic<bool> inactive_;
+};
+
+}  // namespace net
+
+#endif  // SHARDED_INTRUSIVE_QUEUE_HPP_
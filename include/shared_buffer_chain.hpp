@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SHARED_BUFFER_CHAIN_HPP_
+#define SHARED_BUFFER_CHAIN_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "buffer.hpp"
+
+namespace net {
+
+// A chain of views into reference counted blocks of immutable bytes. Copying,
+// slicing and joining chains only adjusts reference counts, so the same
+// payload can be handed to the send operations of many connections without
+// copying it, e.g. behind a header built for each connection.
+//
+// The chain models `const_buffer_sequence` and can be passed to the send
+// operations directly. The reference counts are atomic, a chain may be copied
+// to and released on other threads.
+class shared_buffer_chain {
+  // The header of a block, the bytes follow it.
+  struct block {
+    std::atomic<std::size_t> refs;
+    std::size_t size;
+
+    std::byte* data() noexcept {
+      return reinterpret_cast<std::byte*>(this + 1);
+    }
+  };
+
+ public:
+  // A view into a block. Converts to `const_buffer`.
+  class segment {
+   public:
+    segment(const segment& other) noexcept
+        : block_(other.block_), buffer_(other.buffer_) {
+      retain();
+    }
+
+    segment(segment&& other) noexcept
+        : block_(std::exchange(other.block_, nullptr)),
+          buffer_(std::exchange(other.buffer_, const_buffer{})) {}
+
+    segment& operator=(const segment& other) noexcept {
+      segment copy{other};
+      swap(copy);
+      return *this;
+    }
+
+    segment& operator=(segment&& other) noexcept {
+      segment moved{static_cast<segment&&>(other)};
+      swap(moved);
+      return *this;
+    }
+
+    // Destructor.
+    ~segment() { release(); }
+
+    operator const_buffer() const noexcept { return buffer_; }  // NOLINT
+
+    const void* data() const noexcept { return buffer_.data(); }
+
+    std::size_t size() const noexcept { return buffer_.size(); }
+
+    // The count of segments sharing the block.
+    std::size_t use_count() const noexcept {
+      return block_->refs.load(std::memory_order_relaxed);
+    }
+
+   private:
+    friend class shared_buffer_chain;
+
+    // Take over a reference of `b`.
+    segment(block* b, const_buffer buffer) noexcept
+        : block_(b), buffer_(buffer) {}
+
+    void swap(segment& other) noexcept {
+      std::swap(block_, other.block_);
+      std::swap(buffer_, other.buffer_);
+    }
+
+    void retain() noexcept {
+      if (block_ != nullptr) {
+        block_->refs.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+    void release() noexcept {
+      if (block_ != nullptr &&
+          block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        block_->~block();
+        ::operator delete(block_);
+      }
+      block_ = nullptr;
+    }
+
+    block* block_;
+    const_buffer buffer_;
+  };
+
+  using value_type = segment;
+  using const_iterator = std::vector<segment>::const_iterator;
+
+  // Constructor. The default chain is empty.
+  shared_buffer_chain() noexcept = default;
+
+  // Copy `bytes` into a new block.
+  static shared_buffer_chain copy(const_buffer bytes) {
+    shared_buffer_chain chain;
+    if (bytes.size() != 0) {
+      block* b = allocate(bytes.size());
+      std::memcpy(b->data(), bytes.data(), bytes.size());
+      chain.segments_.push_back(segment{b, const_buffer{b->data(), b->size}});
+      chain.size_ = bytes.size();
+    }
+    return chain;
+  }
+
+  // The segments of the chain.
+  const_iterator begin() const noexcept { return segments_.begin(); }
+
+  const_iterator end() const noexcept { return segments_.end(); }
+
+  // The count of bytes of the chain.
+  std::size_t size() const noexcept { return size_; }
+
+  bool empty() const noexcept { return size_ == 0; }
+
+  // The count of segments of the chain.
+  std::size_t segment_count() const noexcept { return segments_.size(); }
+
+  // Append the segments of `other`, sharing its blocks.
+  void append(const shared_buffer_chain& other) {
+    segments_.insert(segments_.end(), other.segments_.begin(),
+                     other.segments_.end());
+    size_ += other.size_;
+  }
+
+  // Prepend the segments of `other`, sharing its blocks.
+  void prepend(const shared_buffer_chain& other) {
+    segments_.insert(segments_.begin(), other.segments_.begin(),
+                     other.segments_.end());
+    size_ += other.size_;
+  }
+
+  // Prepend a copy of `bytes`, e.g. a header of a single connection.
+  void prepend(const_buffer bytes) { prepend(copy(bytes)); }
+
+  // A chain of `length` bytes starting at `offset`, sharing the blocks.
+  shared_buffer_chain slice(
+      std::size_t offset,
+      std::size_t length = (std::numeric_limits<std::size_t>::max)()) const {
+    shared_buffer_chain chain;
+    for (const segment& s : segments_) {
+      if (length == 0) {
+        break;
+      }
+      if (offset >= s.size()) {
+        offset -= s.size();
+        continue;
+      }
+      const std::size_t n = std::min(s.size() - offset, length);
+      segment part{s};
+      part.buffer_ = const_buffer{
+          static_cast<const std::byte*>(s.data()) + offset, n};
+      chain.segments_.push_back(static_cast<segment&&>(part));
+      chain.size_ += n;
+      length -= n;
+      offset = 0;
+    }
+    return chain;
+  }
+
+  // Drop `n` bytes from the front, e.g. after a partial send.
+  void consume(std::size_t n) { *this = slice(n); }
+
+ private:
+  // Allocate a block of `size` bytes with one reference.
+  static block* allocate(std::size_t size) {
+    void* memory = ::operator new(sizeof(block) + size);
+    return new (memory) block{{1}, size};
+  }
+
+  std::vector<segment> segments_;
+  std::size_t size_ = 0;
+};
+
+}  // namespace net
+
+#endif  // SHARED_BUFFER_CHAIN_HPP_
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SIZE_CLASS_POOL_HPP_
+#define SIZE_CLASS_POOL_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+#include "hugepage_arena.hpp"
+
+namespace net {
+
+// A cache of freed memory blocks, grouped by power-of-two size classes from
+// `min_block_size` to `max_block_size`. Blocks are allocated individually with
+// `::operator new` in the size of their class, so a block can always be handed
+// back to `::operator delete` instead of the pool, e.g. by a thread which
+// doesn't own the pool. Larger requests bypass the cache. Not thread safe.
+//
+// Blocks may also be carved up front from a `hugepage_arena` with `reserve`.
+// Those always return to the cache and must never reach `::operator delete`,
+// check them with `owns`.
+class size_class_pool {
+ public:
+  // The smallest and the largest cached block.
+  static constexpr std::size_t min_block_size = 64;
+  static constexpr std::size_t class_count = 7;
+  static constexpr std::size_t max_block_size = min_block_size
+                                                << (class_count - 1);
+
+  // Constructor. At most `max_cached_per_class` free blocks are kept for each
+  // size class.
+  explicit size_class_pool(std::size_t max_cached_per_class = 1024) noexcept
+      : max_cached_per_class_(max_cached_per_class),
+        free_lists_{},
+        cached_counts_{},
+        reuse_count_(0),
+        arena_(nullptr) {}
+
+  size_class_pool(const size_class_pool&) = delete;
+  size_class_pool& operator=(const size_class_pool&) = delete;
+
+  // Destructor releases the cached blocks.
+  ~size_class_pool() { release(); }
+
+  // Get a block of at least `size` bytes.
+  void* allocate(std::size_t size) {
+    const std::size_t index = class_index(size);
+    if (index < class_count && free_lists_[index] != nullptr) {
+      block* b = free_lists_[index];
+      free_lists_[index] = b->next;
+      --cached_counts_[index];
+      ++reuse_count_;
+      return b;
+    }
+    return allocate_block(size);
+  }
+
+  // Give back a block of `size` bytes got from `allocate` or
+  // `allocate_block`.
+  void deallocate(void* p, std::size_t size) noexcept {
+    const std::size_t index = class_index(size);
+    if (index < class_count &&
+        (cached_counts_[index] < max_cached_per_class_ || owns(p))) {
+      push(index, p);
+      return;
+    }
+    ::operator delete(p);
+  }
+
+  // Allocate a block of the size class of `size` without the cache.
+  static void* allocate_block(std::size_t size) {
+    return ::operator new(block_size(size));
+  }
+
+  // The size of the blocks serving `size` bytes.
+  static constexpr std::size_t block_size(std::size_t size) noexcept {
+    if (size > max_block_size) {
+      return size;
+    }
+    std::size_t result = min_block_size;
+    while (result < size) {
+      result <<= 1;
+    }
+    return result;
+  }
+
+  // Allocate `blocks_per_class` blocks of every size class into the cache
+  // from the heap, written once if `prefault` is true so their pages are
+  // faulted in now. Blocks beyond `max_cached_per_class` are freed once they
+  // are given back.
+  void reserve(std::size_t blocks_per_class, bool prefault = false) {
+    for (std::size_t i = 0; i < class_count; ++i) {
+      const std::size_t size = min_block_size << i;
+      for (std::size_t n = 0; n < blocks_per_class; ++n) {
+        void* p = allocate_block(size);
+        if (prefault) {
+          std::memset(p, 0, size);
+        }
+        push(i, p);
+      }
+    }
+  }
+
+  // Carve `blocks_per_class` blocks of every size class from `arena` into
+  // the cache. Returns false if the arena ran out of room. The arena must
+  // outlive the pool and be the only one reserved from.
+  bool reserve(hugepage_arena& arena, std::size_t blocks_per_class) noexcept {
+    arena_ = &arena;
+    for (std::size_t i = 0; i < class_count; ++i) {
+      const std::size_t size = min_block_size << i;
+      for (std::size_t n = 0; n < blocks_per_class; ++n) {
+        void* p = arena.allocate(size, min_block_size);
+        if (p == nullptr) {
+          return false;
+        }
+        push(i, p);
+      }
+    }
+    return true;
+  }
+
+  // The bytes of the arena blocks of all size classes, see `reserve`.
+  static constexpr std::size_t reserve_size(
+      std::size_t blocks_per_class) noexcept {
+    return ((min_block_size << class_count) - min_block_size) *
+           blocks_per_class;
+  }
+
+  // Whether `p` is a block carved from the arena of this pool.
+  bool owns(const void* p) const noexcept {
+    return arena_ != nullptr && arena_->contains(p);
+  }
+
+  // Release all cached blocks, except those carved from the arena.
+  void release() noexcept {
+    for (std::size_t i = 0; i < class_count; ++i) {
+      block* kept = nullptr;
+      std::size_t kept_count = 0;
+      while (block* b = free_lists_[i]) {
+        free_lists_[i] = b->next;
+        if (owns(b)) {
+          b->next = kept;
+          kept = b;
+          ++kept_count;
+        } else {
+          ::operator delete(b);
+        }
+      }
+      free_lists_[i] = kept;
+      cached_counts_[i] = kept_count;
+    }
+  }
+
+  // The count of blocks currently cached.
+  std::size_t cached_count() const noexcept {
+    std::size_t count = 0;
+    for (std::size_t n : cached_counts_) {
+      count += n;
+    }
+    return count;
+  }
+
+  // The count of allocations served from the cache.
+  std::uint64_t reuse_count() const noexcept { return reuse_count_; }
+
+ private:
+  struct block {
+    block* next;
+  };
+
+  // Put the block `p` into the cache of class `index`.
+  void push(std::size_t index, void* p) noexcept {
+    auto* b = static_cast<block*>(p);
+    b->next = free_lists_[index];
+    free_lists_[index] = b;
+    ++cached_counts_[index];
+  }
+
+  // The size class of `size`, or `class_count` if it's not cached.
+  static constexpr std::size_t class_index(std::size_t size) noexcept {
+    if (size > max_block_size) {
+      return class_count;
+    }
+    std::size_t index = 0;
+    for (std::size_t s = min_block_size; s < size; s <<= 1) {
+      ++index;
+    }
+    return index;
+  }
+
+  std::size_t max_cached_per_class_;
+  std::array<block*, class_count> free_lists_;
+  std::array<std::size_t, class_count> cached_counts_;
+  std::uint64_t reuse_count_;
+  hugepage_arena* arena_;
+};
+
+}  // namespace net
+
+#endif  // SIZE_CLASS_POOL_HPP_
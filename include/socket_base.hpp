@@ -17,6 +17,9 @@
 #define SOCKET_BASE_HPP_
 
 #include <fcntl.h>
+#include <linux/net_tstamp.h>
+
+#include <chrono>  // NOLINT
 
 #include "exec/linux/safe_file_descriptor.hpp"
 #include "io_control.hpp"
@@ -73,6 +76,29 @@ class socket_base {
   // Specifies that the data marks the end of a record.
   static const message_flags message_end_of_record = MSG_EOR;
 
+  // The kernel receive timestamps of some data, as CLOCK_REALTIME since the
+  // epoch. Zero if the kernel reported none of the kind.
+  struct receive_timestamps {
+    // Taken by the kernel when the packet arrived.
+    std::chrono::nanoseconds software{};
+
+    // Taken by the network card, in the clock of the card.
+    std::chrono::nanoseconds hardware{};
+
+    // The time the data waited in the kernel until `now`, e.g. read just
+    // after the receive. Zero without a software timestamp.
+    std::chrono::nanoseconds queueing_delay(
+        std::chrono::system_clock::time_point now =
+            std::chrono::system_clock::now()) const noexcept {
+      if (software.count() == 0) {
+        return {};
+      }
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 now.time_since_epoch()) -
+             software;
+    }
+  };
+
   // Socket option to permit sending of broadcast messages.
   using broadcast = socket_option::boolean<SOL_SOCKET, SO_BROADCAST>;
 
@@ -102,6 +128,33 @@ class socket_base {
   // already in use.
   using reuse_address = socket_option::boolean<SOL_SOCKET, SO_REUSEADDR>;
 
+  // Socket option to allow multiple sockets to be bound to the same address,
+  // the kernel distributes incoming connections or datagrams among them.
+  using reuse_port = socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+
+  // Socket option to busy poll the device queue for the given microseconds
+  // when a receive finds no data.
+  using busy_poll = socket_option::integer<SOL_SOCKET, SO_BUSY_POLL>;
+
+  // Socket option to get the cpu a connection's packets are processed on, or
+  // on a listening socket of a reuseport group, the cpu it prefers to accept
+  // connections from.
+  using incoming_cpu = socket_option::integer<SOL_SOCKET, SO_INCOMING_CPU>;
+
+  // Socket option to select the kernel timestamps of the socket, a mask of
+  // SOF_TIMESTAMPING_* flags. Receive timestamps need both a source, e.g.
+  // SOF_TIMESTAMPING_RX_SOFTWARE, and a report flag, e.g.
+  // SOF_TIMESTAMPING_SOFTWARE or SOF_TIMESTAMPING_RAW_HARDWARE.
+  using timestamping = socket_option::integer<SOL_SOCKET, SO_TIMESTAMPING>;
+
+  // Socket option to allow sends with MSG_ZEROCOPY.
+  using zero_copy = socket_option::boolean<SOL_SOCKET, SO_ZEROCOPY>;
+
+  // Socket option to cap the pacing rate of the socket in bytes per second.
+  // TCP paces by itself, other protocols need the fq qdisc on the device.
+  using max_pacing_rate =
+      socket_option::unsigned_integer64<SOL_SOCKET, SO_MAX_PACING_RATE>;
+
   // Socket option to specify whether the socket lingers on close if unsent
   // data is present.
   using linger = socket_option::linger<SOL_SOCKET, SO_LINGER>;
@@ -118,6 +171,30 @@ class socket_base {
   // blocking.
   using bytes_readable = io_control::bytes_readable;
 };
+
+namespace socket_option {
+// Linux copies these from the listening socket into the accepted one.
+template <>
+inline constexpr bool inherited_by_accept<socket_base::keep_alive> = true;
+template <>
+inline constexpr bool inherited_by_accept<socket_base::send_buffer_size> =
+    true;
+template <>
+inline constexpr bool inherited_by_accept<socket_base::receive_buffer_size> =
+    true;
+template <>
+inline constexpr bool
+    inherited_by_accept<socket_base::receive_low_water_mark> = true;
+template <>
+inline constexpr bool inherited_by_accept<socket_base::busy_poll> = true;
+template <>
+inline constexpr bool inherited_by_accept<socket_base::zero_copy> = true;
+template <>
+inline constexpr bool inherited_by_accept<socket_base::max_pacing_rate> =
+    true;
+template <>
+inline constexpr bool inherited_by_accept<socket_base::linger> = true;
+}  // namespace socket_option
 }  // namespace net
 
 #endif  // SOCKET_BASE_HPP_
@@ -16,11 +16,15 @@
 #ifndef SOCKET_OPTION_HPP_
 #define SOCKET_OPTION_HPP_
 
+#include <netinet/in.h>
 #include <sys/socket.h>
 
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <exception>
 
+#include "ip/address.hpp"
 #include "ip/socket_types.hpp"
 
 namespace net {
@@ -138,6 +142,59 @@ class integer {
   int value_;
 };
 
+// Helper template for implementing 64-bit unsigned integer options.
+template <int Level, int Name>
+class unsigned_integer64 {
+ public:
+  // Default constructor.
+  constexpr unsigned_integer64() : value_(0) {}
+
+  // Construct with a specific option value.
+  explicit constexpr unsigned_integer64(std::uint64_t v) : value_(v) {}
+
+  // Set the value of the option.
+  constexpr unsigned_integer64& operator=(std::uint64_t v) {
+    value_ = v;
+    return *this;
+  }
+
+  // Get the current value of the option.
+  constexpr std::uint64_t value() const { return value_; }
+
+  // Get the level of the socket option.
+  template <typename Protocol>
+  constexpr int level(const Protocol&) const {
+    return Level;
+  }
+
+  // Get the name of the socket option.
+  template <typename Protocol>
+  constexpr int name(const Protocol&) const {
+    return Name;
+  }
+
+  // Get the address of the option data.
+  template <typename Protocol>
+  constexpr std::uint64_t* data(const Protocol&) {
+    return &value_;
+  }
+
+  // Get the address of the option data.
+  template <typename Protocol>
+  constexpr const std::uint64_t* data(const Protocol&) const {
+    return &value_;
+  }
+
+  // Get the size of the option data.
+  template <typename Protocol>
+  constexpr std::size_t size(const Protocol&) const {
+    return sizeof(value_);
+  }
+
+ private:
+  std::uint64_t value_;
+};
+
 // Helper template for implementing linger options.
 template <int Level, int Name>
 class linger {
@@ -197,6 +254,136 @@ class linger {
   ::linger value_;
 };
 
+// Helper template for implementing boolean options whose level and name
+// depend on the family of the protocol.
+template <int Level4, int Name4, int Level6, int Name6>
+class family_boolean {
+ public:
+  // Default constructor.
+  constexpr family_boolean() : value_(0) {}
+
+  // Construct with a specific option value.
+  explicit constexpr family_boolean(bool v) : value_(v ? 1 : 0) {}
+
+  // Set the current value of the boolean.
+  constexpr family_boolean& operator=(bool v) {
+    value_ = v ? 1 : 0;
+    return *this;
+  }
+
+  // Get the current value of the boolean.
+  constexpr bool value() const { return !!value_; }
+
+  // Convert to bool.
+  constexpr operator bool() const { return !!value_; }
+
+  // Test for false.
+  constexpr bool operator!() const { return !value_; }
+
+  // Get the level of the socket option.
+  template <typename Protocol>
+  constexpr int level(const Protocol& protocol) const {
+    return protocol.family() == AF_INET6 ? Level6 : Level4;
+  }
+
+  // Get the name of the socket option.
+  template <typename Protocol>
+  constexpr int name(const Protocol& protocol) const {
+    return protocol.family() == AF_INET6 ? Name6 : Name4;
+  }
+
+  // Get the address of the boolean data.
+  template <typename Protocol>
+  constexpr int* data(const Protocol&) {
+    return &value_;
+  }
+
+  // Get the address of the boolean data.
+  template <typename Protocol>
+  constexpr const int* data(const Protocol&) const {
+    return &value_;
+  }
+
+  // Get the size of the boolean data.
+  template <typename Protocol>
+  constexpr std::size_t size(const Protocol&) const {
+    return sizeof(value_);
+  }
+
+ private:
+  int value_;
+};
+
+// Helper template for implementing the options which join or leave a
+// multicast group. The level and name depend on the family of the group, so
+// an IPv6 socket can join IPv4 groups too.
+template <int Name4, int Name6>
+class multicast_request {
+ public:
+  // Construct a request for `group` on the interface with index
+  // `interface_index`, or on the interface the kernel routes the group to if
+  // it's 0.
+  explicit multicast_request(const ip::address& group,
+                             unsigned interface_index = 0) noexcept
+      : ipv6_(group.is_v6()), v4_{}, v6_{} {
+    if (ipv6_) {
+      const auto bytes = group.to_v6().to_bytes();
+      std::memcpy(&v6_.ipv6mr_multiaddr, bytes.data(), bytes.size());
+      v6_.ipv6mr_interface = interface_index;
+    } else {
+      const auto bytes = group.to_v4().to_bytes();
+      std::memcpy(&v4_.imr_multiaddr, bytes.data(), bytes.size());
+      v4_.imr_ifindex = static_cast<int>(interface_index);
+    }
+  }
+
+  // Construct a request for the IPv4 `group` on the interface which has the
+  // address `interface`.
+  multicast_request(const ip::address_v4& group,
+                    const ip::address_v4& interface) noexcept
+      : ipv6_(false), v4_{}, v6_{} {
+    const auto bytes = group.to_bytes();
+    std::memcpy(&v4_.imr_multiaddr, bytes.data(), bytes.size());
+    const auto local = interface.to_bytes();
+    std::memcpy(&v4_.imr_address, local.data(), local.size());
+  }
+
+  // Get the level of the socket option.
+  template <typename Protocol>
+  constexpr int level(const Protocol&) const {
+    return ipv6_ ? IPPROTO_IPV6 : IPPROTO_IP;
+  }
+
+  // Get the name of the socket option.
+  template <typename Protocol>
+  constexpr int name(const Protocol&) const {
+    return ipv6_ ? Name6 : Name4;
+  }
+
+  // Get the address of the request data.
+  template <typename Protocol>
+  constexpr const void* data(const Protocol&) const {
+    return ipv6_ ? static_cast<const void*>(&v6_)
+                 : static_cast<const void*>(&v4_);
+  }
+
+  // Get the size of the request data.
+  template <typename Protocol>
+  constexpr std::size_t size(const Protocol&) const {
+    return ipv6_ ? sizeof(v6_) : sizeof(v4_);
+  }
+
+ private:
+  bool ipv6_;
+  ::ip_mreqn v4_;
+  ::ipv6_mreq v6_;
+};
+
+// Whether sockets accepted by a listening socket inherit `Option` from it,
+// so setting it once on the acceptor covers every connection.
+template <typename Option>
+inline constexpr bool inherited_by_accept = false;
+
 }  // namespace socket_option
 }  // namespace net
 
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOCKET_OPTION_SET_HPP_
+#define SOCKET_OPTION_SET_HPP_
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+
+#include "status-code/system_code.hpp"
+
+#include "basic_socket.hpp"
+#include "basic_socket_acceptor.hpp"
+#include "socket_option.hpp"
+
+namespace net {
+
+// A fixed list of socket options, captured once and set on every socket of
+// a kind in one call, e.g. for each accepted connection. The options an
+// accepted socket inherits from its listener are set once on the acceptor
+// with `apply_inherited`, then `apply_accepted` sets only the others.
+//
+//   socket_option_set tuning{ip::tcp::no_delay{true},
+//                            ip::tcp::user_timeout{5000},
+//                            ip::tcp::quick_ack{true}};
+//   tuning.apply_inherited(acceptor);
+//   ...
+//   tuning.apply_accepted(socket);  // Only quick_ack, one setsockopt.
+//
+// Accept with SOCK_NONBLOCK instead of calling `set_non_blocking` after.
+template <typename... Options>
+class socket_option_set {
+ public:
+  // The count of options `apply_accepted` sets.
+  static constexpr std::size_t accepted_count =
+      (std::size_t{0} + ... +
+       (socket_option::inherited_by_accept<Options> ? 0 : 1));
+
+  explicit constexpr socket_option_set(Options... options) noexcept
+      : options_(options...) {}
+
+  // Set every option on `socket`. Stops at the first failure.
+  template <typename Protocol>
+  system_code apply(basic_socket<Protocol>& socket) const noexcept {
+    return apply_if<all>(socket);
+  }
+
+  // Set the options accepted sockets inherit on the listening `acceptor`.
+  template <typename Protocol>
+  system_code apply_inherited(
+      basic_socket_acceptor<Protocol>& acceptor) const noexcept {
+    return apply_if<inherited>(acceptor);
+  }
+
+  // Set the options which an accepted `socket` doesn't inherit.
+  template <typename Protocol>
+  system_code apply_accepted(basic_socket<Protocol>& socket) const noexcept {
+    return apply_if<not_inherited>(socket);
+  }
+
+  const std::tuple<Options...>& options() const noexcept { return options_; }
+
+ private:
+  enum selection { all, inherited, not_inherited };
+
+  template <selection Which, typename Option>
+  static constexpr bool selected() noexcept {
+    if constexpr (Which == all) {
+      return true;
+    } else {
+      return socket_option::inherited_by_accept<Option> == (Which == inherited);
+    }
+  }
+
+  template <selection Which, typename Protocol>
+  system_code apply_if(basic_socket<Protocol>& socket) const noexcept {
+    system_code ec{errc::success};
+    std::apply(
+        [&](const auto&... option) {
+          // Short-circuits on the first failure.
+          static_cast<void>(
+              (... && (!selected<Which, std::decay_t<decltype(option)>>() ||
+                       (ec = socket.set_option(option)).success())));
+        },
+        options_);
+    return ec;
+  }
+
+  std::tuple<Options...> options_;
+};
+
+template <typename... Options>
+socket_option_set(Options...) -> socket_option_set<Options...>;
+
+}  // namespace net
+
+#endif  // SOCKET_OPTION_SET_HPP_
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef STAT_COUNTER_HPP_
+#define STAT_COUNTER_HPP_
+
+#include <atomic>
+#include <cstdint>
+
+namespace net {
+
+// A statistics counter which can be read from any thread. If `Enabled` is
+// false, the counter is an empty type, updates compile to nothing and it
+// always reads zero.
+template <bool Enabled>
+class stat_counter {
+ public:
+  // Add `n`. Only one thread may update the counter, so this is a plain load
+  // and store rather than a locked read-modify-write.
+  void add(std::uint64_t n = 1) noexcept {
+    value_.store(value_.load(std::memory_order_relaxed) + n,
+                 std::memory_order_relaxed);
+  }
+
+  // Add `n` from any thread.
+  void add_shared(std::uint64_t n = 1) noexcept {
+    value_.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  std::uint64_t load() const noexcept {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<std::uint64_t> value_{0};
+};
+
+template <>
+class stat_counter<false> {
+ public:
+  void add(std::uint64_t = 1) noexcept {}
+
+  void add_shared(std::uint64_t = 1) noexcept {}
+
+  std::uint64_t load() const noexcept { return 0; }
+};
+
+}  // namespace net
+
+#endif  // STAT_COUNTER_HPP_
@@ -0,0 +1,378 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TASK_HPP_
+#define TASK_HPP_
+
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "recycling_allocator.hpp"
+#include "stdexec.hpp"
+
+namespace net {
+namespace __task {
+
+template <typename T>
+class task;
+
+template <typename T>
+class promise;
+
+template <typename T, typename ReceiverId>
+class task_op;
+
+// The value completion of a task of `T`.
+template <typename T>
+struct value_signature {
+  using type = stdexec::set_value_t(T);
+};
+
+template <>
+struct value_signature<void> {
+  using type = stdexec::set_value_t();
+};
+
+// The environment a task gives to the senders it awaits.
+struct env {
+  stdexec::in_place_stop_token token_;
+
+  friend auto tag_invoke(stdexec::get_stop_token_t, const env& self) noexcept
+      -> stdexec::in_place_stop_token {
+    return self.token_;
+  }
+};
+
+// The part of the promise which doesn't depend on the result type.
+class promise_base {
+ public:
+  // Frames come from the recycling cache of the calling thread, which is the
+  // one of the context on its io thread. A frame freed on another thread goes
+  // to the cache of that thread, or to the heap.
+  static void* operator new(std::size_t size) {
+    return thread_info_base::allocate<thread_info_base::frame_tag>(
+        thread_info_base::current(), size);
+  }
+
+  static void operator delete(void* pointer, std::size_t size) noexcept {
+    thread_info_base::deallocate<thread_info_base::frame_tag>(
+        thread_info_base::current(), pointer, size);
+  }
+
+  // Resume the awaiting coroutine, or complete the receiver of the task.
+  struct final_awaiter {
+    constexpr bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<Promise> handle) noexcept {
+      promise_base& self = handle.promise();
+      if (self.on_done_ != nullptr) {
+        // The receiver may destroy the frame.
+        self.on_done_(self.owner_);
+        return std::noop_coroutine();
+      }
+      return self.continuation_;
+    }
+
+    constexpr void await_resume() const noexcept {}
+  };
+
+  // Tasks are lazy, they run once awaited or started.
+  constexpr std::suspend_always initial_suspend() const noexcept { return {}; }
+
+  constexpr final_awaiter final_suspend() const noexcept { return {}; }
+
+  void unhandled_exception() noexcept {
+    exception_ = std::current_exception();
+  }
+
+  // An awaited sender completed with stopped. The stop propagates to the
+  // awaiting coroutine, up to the receiver of the outermost task.
+  std::coroutine_handle<> unhandled_stopped() noexcept {
+    return on_stopped_(owner_);
+  }
+
+  friend auto tag_invoke(stdexec::get_env_t, const promise_base& self) noexcept
+      -> env {
+    return {self.token_};
+  }
+
+ protected:
+  template <typename T>
+  friend class task;
+
+  template <typename T, typename ReceiverId>
+  friend class task_op;
+
+  // The coroutine awaiting this task.
+  std::coroutine_handle<> continuation_;
+  // Set by the operation state of an outermost task, which completes its
+  // receiver in `on_done_` instead of resuming a continuation.
+  void (*on_done_)(void* owner) noexcept = nullptr;
+  std::coroutine_handle<> (*on_stopped_)(void* owner) noexcept = nullptr;
+  // The awaiting coroutine or the operation state.
+  void* owner_ = nullptr;
+  stdexec::in_place_stop_token token_;
+  std::exception_ptr exception_;
+};
+
+template <typename T>
+class result_storage {
+ public:
+  template <typename U = T>
+    requires std::convertible_to<U, T>
+  void return_value(U&& value) noexcept(
+      std::is_nothrow_constructible_v<T, U>) {
+    value_.emplace(static_cast<U&&>(value));
+  }
+
+ protected:
+  T take() { return static_cast<T&&>(*value_); }
+
+ private:
+  std::optional<T> value_;
+};
+
+template <>
+class result_storage<void> {
+ public:
+  constexpr void return_void() const noexcept {}
+
+ protected:
+  constexpr void take() const noexcept {}
+};
+
+// A lazily started coroutine completing with a `T`. Awaiting a sender resumes
+// the task inline wherever the sender completes, for the epoll senders that is
+// the io thread, with no hop through a scheduler. An error of the sender is
+// thrown from the `co_await`, a stop propagates without resuming the task.
+//
+// Awaiting another task transfers to it directly and shares the stop token.
+// A task is itself a sender completing with the result, an exception_ptr, or
+// stopped, so the outermost one is started with e.g. `start_detached`.
+template <typename T = void>
+class task {
+ public:
+  using promise_type = promise<T>;
+  using handle_type = std::coroutine_handle<promise_type>;
+
+  using is_sender = void;
+  using completion_signatures = stdexec::completion_signatures<
+      typename value_signature<T>::type,
+      stdexec::set_error_t(std::exception_ptr), stdexec::set_stopped_t()>;
+
+  // Constructor.
+  explicit task(handle_type handle) noexcept : handle_(handle) {}
+
+  task(task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+
+  task& operator=(task&& other) noexcept {
+    if (this != &other) {
+      if (handle_) {
+        handle_.destroy();
+      }
+      handle_ = std::exchange(other.handle_, {});
+    }
+    return *this;
+  }
+
+  // Destructor.
+  ~task() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  // Awaited by another task.
+  class awaiter {
+   public:
+    explicit awaiter(handle_type handle) noexcept : handle_(handle) {}
+
+    awaiter(awaiter&& other) noexcept
+        : handle_(std::exchange(other.handle_, {})) {}
+
+    ~awaiter() {
+      if (handle_) {
+        handle_.destroy();
+      }
+    }
+
+    constexpr bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+      requires std::derived_from<Promise, promise_base>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<Promise> parent) noexcept {
+      promise_base& self = handle_.promise();
+      self.continuation_ = parent;
+      self.on_stopped_ = [](void* owner) noexcept {
+        return std::coroutine_handle<Promise>::from_address(owner)
+            .promise()
+            .unhandled_stopped();
+      };
+      self.owner_ = parent.address();
+      self.token_ = static_cast<promise_base&>(parent.promise()).token_;
+      return handle_;
+    }
+
+    T await_resume() { return handle_.promise().result(); }
+
+   private:
+    handle_type handle_;
+  };
+
+  awaiter operator co_await() && noexcept {
+    return awaiter{std::exchange(handle_, {})};
+  }
+
+  template <typename Env>
+  friend auto tag_invoke(stdexec::get_completion_signatures_t, task&& self,
+                         Env&&) noexcept -> completion_signatures;
+
+  friend auto tag_invoke(stdexec::get_env_t, const task& self) noexcept
+      -> stdexec::empty_env {
+    return {};
+  }
+
+  template <stdexec::receiver_of<completion_signatures> Receiver>
+  friend auto tag_invoke(stdexec::connect_t, task&& self,
+                         Receiver receiver) noexcept
+      -> stdexec::__t<task_op<T, stdexec::__id<Receiver>>> {
+    return {std::exchange(self.handle_, {}),
+            static_cast<Receiver&&>(receiver)};
+  }
+
+ private:
+  handle_type handle_;
+};
+
+template <typename T>
+class promise : public promise_base, public result_storage<T> {
+ public:
+  task<T> get_return_object() noexcept {
+    return task<T>{std::coroutine_handle<promise>::from_promise(*this)};
+  }
+
+  // Senders are awaited through `stdexec::as_awaitable`, tasks as they are.
+  template <typename Awaitable>
+  decltype(auto) await_transform(Awaitable&& awaitable) {
+    return stdexec::as_awaitable(static_cast<Awaitable&&>(awaitable), *this);
+  }
+
+  // The result, or the exception which escaped the coroutine.
+  T result() {
+    if (exception_) {
+      std::rethrow_exception(exception_);
+    }
+    return this->take();
+  }
+};
+
+// Runs an outermost task for a receiver.
+template <typename T, typename ReceiverId>
+class task_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  using stop_token = stdexec::stop_token_of_t<stdexec::env_of_t<receiver_t>>;
+  using handle_type = typename task<T>::handle_type;
+
+ public:
+  struct __t : public stdexec::__immovable {
+    using __id = task_op;
+
+    // Constructor.
+    __t(handle_type handle, receiver_t receiver) noexcept
+        : handle_(handle), receiver_(static_cast<receiver_t&&>(receiver)) {
+      promise_base& promise = handle_.promise();
+      promise.on_done_ = &on_done;
+      promise.on_stopped_ = &on_stopped;
+      promise.owner_ = this;
+    }
+
+    // Destructor.
+    ~__t() {
+      if (handle_) {
+        handle_.destroy();
+      }
+    }
+
+    friend void tag_invoke(stdexec::start_t, __t& self) noexcept {
+      self.start_impl();
+    }
+
+   private:
+    void start_impl() noexcept {
+      promise_base& promise = handle_.promise();
+      if constexpr (std::same_as<stop_token, stdexec::in_place_stop_token>) {
+        promise.token_ = stdexec::get_stop_token(stdexec::get_env(receiver_));
+      } else if constexpr (!stdexec::unstoppable_token<stop_token>) {
+        stop_callback_.emplace(
+            stdexec::get_stop_token(stdexec::get_env(receiver_)),
+            forward_stop{stop_source_});
+        promise.token_ = stop_source_.get_token();
+      }
+      handle_.resume();
+    }
+
+    static void on_done(void* owner) noexcept {
+      auto& self = *static_cast<__t*>(owner);
+      self.stop_callback_.reset();
+      try {
+        if constexpr (std::is_void_v<T>) {
+          self.handle_.promise().result();
+          stdexec::set_value(static_cast<receiver_t&&>(self.receiver_));
+        } else {
+          stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                             self.handle_.promise().result());
+        }
+      } catch (...) {
+        stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                           std::current_exception());
+      }
+    }
+
+    static std::coroutine_handle<> on_stopped(void* owner) noexcept {
+      auto& self = *static_cast<__t*>(owner);
+      self.stop_callback_.reset();
+      stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+      return std::noop_coroutine();
+    }
+
+    // Forwards a stop request of the receiver to the task.
+    struct forward_stop {
+      stdexec::in_place_stop_source& source_;
+
+      void operator()() noexcept { source_.request_stop(); }
+    };
+
+    handle_type handle_;
+    receiver_t receiver_;
+    stdexec::in_place_stop_source stop_source_;
+    std::optional<typename stop_token::template callback_type<forward_stop>>
+        stop_callback_;
+  };
+};
+}  // namespace __task
+
+using __task::task;
+}  // namespace net
+
+#endif  // TASK_HPP_
@@ -0,0 +1,429 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef THREAD_POOL_CONTEXT_HPP_
+#define THREAD_POOL_CONTEXT_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "stdexec.hpp"
+
+#include "work_stealing_deque.hpp"
+
+namespace net {
+// A pool of worker threads for CPU bound work next to an io context. Each
+// worker owns a Chase-Lev deque and a LIFO slot, idle workers steal from the
+// others and park on a futex when there is nothing to steal.
+//
+// Hop over with `stdexec::on(pool.get_scheduler(), work)` or
+// `stdexec::transfer`, and back with the io context's scheduler. The way
+// back is `epoll_context`'s remote queue, which only writes the eventfd when
+// the io thread is asleep.
+class thread_pool_context {
+ public:
+  struct task_base {
+    task_base* next_ = nullptr;
+    void (*execute_)(task_base*) noexcept = nullptr;
+  };
+
+  class scheduler;
+
+  // Starts `threads` workers, each with a deque of `deque_capacity` tasks.
+  // Tasks that do not fit into a deque go to the shared injection queue.
+  explicit thread_pool_context(
+      std::size_t threads = std::thread::hardware_concurrency(),
+      std::size_t deque_capacity = 256);
+
+  thread_pool_context(const thread_pool_context&) = delete;
+  thread_pool_context& operator=(const thread_pool_context&) = delete;
+
+  // Requests stop and joins the workers. Tasks still queued are dropped.
+  ~thread_pool_context();
+
+  scheduler get_scheduler() noexcept;
+
+  // Workers return as soon as they finish the task at hand.
+  void request_stop() noexcept;
+
+  bool stop_requested() const noexcept {
+    return stop_.load(std::memory_order_acquire);
+  }
+
+  std::size_t thread_count() const noexcept { return workers_.size(); }
+
+  bool is_running_on_worker() const noexcept {
+    return current_worker_ != nullptr && current_worker_->pool == this;
+  }
+
+  // Enqueues `task`. From a worker of this pool the task goes to the LIFO
+  // slot, as it most likely works on data that is hot in this cache.
+  void schedule(task_base* task) noexcept;
+
+ private:
+  struct worker {
+    worker(thread_pool_context& p, std::size_t i, std::size_t capacity)
+        : pool(&p),
+          index(i),
+          deque(capacity),
+          rng(0x9e3779b97f4a7c15ULL * (i + 1)) {}
+
+    thread_pool_context* pool;
+    std::size_t index;
+    work_stealing_deque<task_base> deque;
+    // Stealable, so a task is not stuck behind a long running one.
+    std::atomic<task_base*> lifo_slot{nullptr};
+    std::uint64_t rng;
+    std::uint32_t tick = 0;
+    std::thread thread;
+  };
+
+  // Check the injection queue first every this many tasks, so that remote
+  // work is not starved by tasks spawning tasks.
+  static constexpr std::uint32_t injection_interval = 61;
+
+  void run(worker& self) noexcept;
+  task_base* find_task(worker& self) noexcept;
+  task_base* take_injected(worker& self) noexcept;
+  task_base* steal(worker& self) noexcept;
+  void push_local(worker& self, task_base* task) noexcept;
+  void inject(task_base* first, task_base* last) noexcept;
+  bool has_visible_work() const noexcept;
+  void park() noexcept;
+  void notify_one() noexcept;
+
+  static std::uint64_t next_random(worker& self) noexcept {
+    self.rng ^= self.rng << 13;
+    self.rng ^= self.rng >> 7;
+    self.rng ^= self.rng << 17;
+    return self.rng;
+  }
+
+  static inline thread_local worker* current_worker_ = nullptr;
+
+  std::vector<std::unique_ptr<worker>> workers_;
+  // A Treiber stack of tasks scheduled from outside the pool.
+  alignas(64) std::atomic<task_base*> injected_{nullptr};
+  // Bumped on every wake, the futex parked workers wait on.
+  alignas(64) std::atomic<std::uint32_t> epoch_{0};
+  std::atomic<std::uint32_t> sleepers_{0};
+  std::atomic<bool> stop_{false};
+};
+
+class thread_pool_context::scheduler {
+  struct schedule_env {
+    friend auto tag_invoke(
+        stdexec::get_completion_scheduler_t<stdexec::set_value_t>,
+        const schedule_env& env) noexcept -> scheduler {
+      return scheduler{*env.pool};
+    }
+
+    thread_pool_context* pool;
+  };  // schedule_env
+
+  template <typename ReceiverId>
+  class schedule_op {
+    using receiver_t = stdexec::__t<ReceiverId>;
+
+   public:
+    struct __t : private task_base {
+      using __id = schedule_op;
+      using stop_token =
+          stdexec::stop_token_of_t<stdexec::env_of_t<receiver_t>&>;
+
+      __t(thread_pool_context& pool, receiver_t r)
+          : pool_(pool), receiver_(static_cast<receiver_t&&>(r)) {
+        execute_ = &execute_impl;
+      }
+
+      friend void tag_invoke(stdexec::start_t, __t& op) noexcept {
+        op.pool_.schedule(&op);
+      }
+
+     private:
+      static void execute_impl(task_base* p) noexcept {
+        auto& self = *static_cast<__t*>(p);
+        if constexpr (!std::unstoppable_token<stop_token>) {
+          auto stop_token =
+              stdexec::get_stop_token(stdexec::get_env(self.receiver_));
+          if (stop_token.stop_requested()) {
+            stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+            return;
+          }
+        }
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_));
+      }
+
+      thread_pool_context& pool_;
+      STDEXEC_NO_UNIQUE_ADDRESS receiver_t receiver_;
+    };
+  };  // schedule_op
+
+  class schedule_sender {
+    template <typename Receiver>
+    using op_t = stdexec::__t<schedule_op<stdexec::__id<Receiver>>>;
+
+   public:
+    struct __t {
+      using is_sender = void;
+      using __id = schedule_sender;
+      using completion_signatures =
+          stdexec::completion_signatures<stdexec::set_value_t(),  //
+                                         stdexec::set_stopped_t()>;
+
+      template <typename Env>
+      friend auto tag_invoke(stdexec::get_completion_signatures_t,
+                             const __t& self, Env&&) noexcept
+          -> completion_signatures;
+
+      friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+          -> schedule_env {
+        return schedule_env{self.pool_};
+      }
+
+      template <stdexec::__decays_to<__t> Sender,
+                stdexec::receiver_of<completion_signatures> Receiver>
+      friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                             Receiver receiver) noexcept -> op_t<Receiver> {
+        return {*self.pool_, static_cast<Receiver&&>(receiver)};
+      }
+
+      explicit __t(thread_pool_context& pool) noexcept : pool_(&pool) {}
+
+     private:
+      thread_pool_context* pool_;
+    };
+  };  // schedule_sender
+
+ public:
+  explicit scheduler(thread_pool_context& pool) noexcept : pool_(&pool) {}
+
+  friend auto tag_invoke(stdexec::schedule_t, const scheduler& sched) noexcept
+      -> stdexec::__t<schedule_sender> {
+    return stdexec::__t<schedule_sender>{*sched.pool_};
+  }
+
+  friend bool operator==(scheduler a, scheduler b) noexcept {
+    return a.pool_ == b.pool_;
+  }
+
+  friend bool operator!=(scheduler a, scheduler b) noexcept {
+    return !(a == b);
+  }
+
+ private:
+  thread_pool_context* pool_;
+};
+
+inline thread_pool_context::thread_pool_context(std::size_t threads,
+                                                std::size_t deque_capacity) {
+  threads = std::max<std::size_t>(threads, 1);
+  workers_.reserve(threads);
+  for (std::size_t i = 0; i < threads; ++i) {
+    workers_.push_back(std::make_unique<worker>(*this, i, deque_capacity));
+  }
+  // Start only once `workers_` is complete, thieves walk all of it.
+  for (auto& w : workers_) {
+    w->thread = std::thread([this, p = w.get()] { run(*p); });
+  }
+}
+
+inline thread_pool_context::~thread_pool_context() {
+  request_stop();
+  for (auto& w : workers_) {
+    if (w->thread.joinable()) {
+      w->thread.join();
+    }
+  }
+}
+
+inline auto thread_pool_context::get_scheduler() noexcept -> scheduler {
+  return scheduler{*this};
+}
+
+inline void thread_pool_context::request_stop() noexcept {
+  stop_.store(true, std::memory_order_seq_cst);
+  epoch_.fetch_add(1, std::memory_order_seq_cst);
+  epoch_.notify_all();
+}
+
+inline void thread_pool_context::schedule(task_base* task) noexcept {
+  worker* self = current_worker_;
+  if (self != nullptr && self->pool == this) {
+    push_local(*self, task);
+    return;
+  }
+  task->next_ = nullptr;
+  inject(task, task);
+  notify_one();
+}
+
+inline void thread_pool_context::push_local(worker& self,
+                                            task_base* task) noexcept {
+  task_base* displaced =
+      self.lifo_slot.exchange(task, std::memory_order_acq_rel);
+  if (displaced == nullptr) {
+    // Only the owner runs this soon, no one else needs to wake up for it.
+    return;
+  }
+  if (!self.deque.push(displaced)) {
+    displaced->next_ = nullptr;
+    inject(displaced, displaced);
+  }
+  notify_one();
+}
+
+inline void thread_pool_context::inject(task_base* first,
+                                        task_base* last) noexcept {
+  task_base* head = injected_.load(std::memory_order_relaxed);
+  do {
+    last->next_ = head;
+  } while (!injected_.compare_exchange_weak(head, first,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed));
+}
+
+inline auto thread_pool_context::take_injected(worker& self) noexcept
+    -> task_base* {
+  if (injected_.load(std::memory_order_relaxed) == nullptr) {
+    return nullptr;
+  }
+  task_base* head = injected_.exchange(nullptr, std::memory_order_acquire);
+  if (head == nullptr) {
+    return nullptr;
+  }
+  // The stack is newest first. Pushing in that order leaves the oldest at
+  // the bottom, where the owner pops next, and the newest for the thieves.
+  task_base* task = head;
+  head = head->next_;
+  while (head != nullptr) {
+    task_base* next = head->next_;
+    if (!self.deque.push(head)) {
+      task_base* last = head;
+      while (last->next_ != nullptr) {
+        last = last->next_;
+      }
+      inject(head, last);
+      break;
+    }
+    head = next;
+  }
+  if (!self.deque.empty()) {
+    notify_one();
+  }
+  return task;
+}
+
+inline auto thread_pool_context::steal(worker& self) noexcept -> task_base* {
+  const std::size_t n = workers_.size();
+  const std::size_t start = next_random(self) % n;
+  for (std::size_t i = 0; i < n; ++i) {
+    worker& victim = *workers_[(start + i) % n];
+    if (&victim == &self) {
+      continue;
+    }
+    if (task_base* task = victim.deque.steal()) {
+      return task;
+    }
+    if (victim.lifo_slot.load(std::memory_order_relaxed) != nullptr) {
+      if (task_base* task =
+              victim.lifo_slot.exchange(nullptr, std::memory_order_acq_rel)) {
+        return task;
+      }
+    }
+  }
+  return nullptr;
+}
+
+inline auto thread_pool_context::find_task(worker& self) noexcept
+    -> task_base* {
+  if (++self.tick % injection_interval == 0) {
+    if (task_base* task = take_injected(self)) {
+      return task;
+    }
+  }
+  if (task_base* task =
+          self.lifo_slot.exchange(nullptr, std::memory_order_acq_rel)) {
+    return task;
+  }
+  if (task_base* task = self.deque.pop()) {
+    return task;
+  }
+  if (task_base* task = take_injected(self)) {
+    return task;
+  }
+  return steal(self);
+}
+
+inline bool thread_pool_context::has_visible_work() const noexcept {
+  if (injected_.load(std::memory_order_seq_cst) != nullptr) {
+    return true;
+  }
+  return std::any_of(workers_.begin(), workers_.end(), [](const auto& w) {
+    return !w->deque.empty() ||
+           w->lifo_slot.load(std::memory_order_seq_cst) != nullptr;
+  });
+}
+
+inline void thread_pool_context::park() noexcept {
+  // Announce the sleeper before the last look at the queues, so a producer
+  // either sees it and bumps the epoch, or the look sees the new task.
+  sleepers_.fetch_add(1, std::memory_order_seq_cst);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  const std::uint32_t epoch = epoch_.load(std::memory_order_seq_cst);
+  if (!has_visible_work() && !stop_requested()) {
+    epoch_.wait(epoch, std::memory_order_seq_cst);
+  }
+  sleepers_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+inline void thread_pool_context::notify_one() noexcept {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleepers_.load(std::memory_order_seq_cst) == 0) {
+    return;
+  }
+  epoch_.fetch_add(1, std::memory_order_seq_cst);
+  epoch_.notify_one();
+}
+
+inline void thread_pool_context::run(worker& self) noexcept {
+  current_worker_ = &self;
+  while (!stop_requested()) {
+    task_base* task = find_task(self);
+    if (task == nullptr) {
+      // One more round of stealing before going to sleep, work often shows
+      // up right after a worker runs dry.
+      std::this_thread::yield();
+      task = find_task(self);
+    }
+    if (task == nullptr) {
+      park();
+      continue;
+    }
+    task->execute_(task);
+  }
+  current_worker_ = nullptr;
+}
+
+}  // namespace net
+
+#endif  // THREAD_POOL_CONTEXT_HPP_
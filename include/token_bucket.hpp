@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TOKEN_BUCKET_HPP_
+#define TOKEN_BUCKET_HPP_
+
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <limits>
+
+#include "monotonic_clock.hpp"
+
+namespace net {
+
+// A token bucket counting bytes. Tokens accrue at `rate` bytes per second up
+// to `burst`, a send consumes as many as it sent. Time is passed in, so the
+// bucket follows whatever clock the caller runs on, e.g. the loop time of a
+// context. A bucket without a rate is unlimited.
+//
+// Refills only advance the refill time by the time the added tokens took,
+// so frequent refills at a low rate don't lose the fractions.
+class token_bucket {
+ public:
+  using time_point = monotonic_clock::time_point;
+  using duration = monotonic_clock::duration;
+
+  // Constructor, an unlimited bucket.
+  constexpr token_bucket() noexcept
+      : rate_(0), burst_(0), tokens_(0), last_() {}
+
+  // Constructor, the bucket starts full at `now`.
+  token_bucket(std::uint64_t rate, std::uint64_t burst, time_point now) noexcept
+      : rate_(rate), burst_(burst), tokens_(burst), last_(now) {}
+
+  // Whether the bucket limits the rate.
+  constexpr bool limited() const noexcept { return rate_ != 0; }
+
+  // The bytes per second.
+  constexpr std::uint64_t rate() const noexcept { return rate_; }
+
+  // The largest number of tokens.
+  constexpr std::uint64_t burst() const noexcept { return burst_; }
+
+  // The tokens at the last refill.
+  constexpr std::uint64_t tokens() const noexcept {
+    return limited() ? tokens_ : std::numeric_limits<std::uint64_t>::max();
+  }
+
+  // Add the tokens accrued until `now`.
+  void refill(time_point now) noexcept {
+    if (!limited() || now <= last_) {
+      return;
+    }
+    if (tokens_ >= burst_) {
+      last_ = now;
+      return;
+    }
+    auto elapsed = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_)
+            .count());
+    std::uint64_t missing = burst_ - tokens_;
+    if (elapsed >= nanoseconds_for(missing)) {
+      tokens_ = burst_;
+      last_ = now;
+      return;
+    }
+    // Below `missing` as `elapsed` is below the time to fill the bucket.
+    auto added = static_cast<std::uint64_t>(
+        static_cast<unsigned __int128>(elapsed) * rate_ /
+        nanoseconds_per_second);
+    if (added != 0) {
+      tokens_ += added;
+      last_ += std::chrono::nanoseconds(static_cast<std::int64_t>(
+          static_cast<unsigned __int128>(added) * nanoseconds_per_second /
+          rate_));
+    }
+  }
+
+  // Take `n` tokens, at most as many as there are.
+  void consume(std::uint64_t n) noexcept {
+    if (limited()) {
+      tokens_ = n < tokens_ ? tokens_ - n : 0;
+    }
+  }
+
+  // The time from the last refill until the bucket holds `n` tokens, `n` is
+  // capped at the burst.
+  duration time_until(std::uint64_t n) const noexcept {
+    if (!limited()) {
+      return duration::zero();
+    }
+    if (n > burst_) {
+      n = burst_;
+    }
+    if (tokens_ >= n) {
+      return duration::zero();
+    }
+    auto ns = std::chrono::nanoseconds(nanoseconds_for(n - tokens_));
+    return std::chrono::ceil<duration>(ns);
+  }
+
+  // Change the rate and burst, the tokens are capped at the new burst. A
+  // zero rate makes the bucket unlimited.
+  void set_rate(std::uint64_t rate, std::uint64_t burst,
+                time_point now) noexcept {
+    if (!limited()) {
+      tokens_ = burst;
+    } else {
+      refill(now);
+    }
+    rate_ = rate;
+    burst_ = burst;
+    if (tokens_ > burst_) {
+      tokens_ = burst_;
+    }
+    last_ = now;
+  }
+
+ private:
+  static constexpr std::uint64_t nanoseconds_per_second = 1'000'000'000;
+
+  // The nanoseconds `n` tokens take to accrue, rounded up.
+  std::uint64_t nanoseconds_for(std::uint64_t n) const noexcept {
+    return static_cast<std::uint64_t>(
+        (static_cast<unsigned __int128>(n) * nanoseconds_per_second +
+         rate_ - 1) /
+        rate_);
+  }
+
+  std::uint64_t rate_;
+  std::uint64_t burst_;
+  std::uint64_t tokens_;
+  time_point last_;
+};
+
+}  // namespace net
+
+#endif  // TOKEN_BUCKET_HPP_
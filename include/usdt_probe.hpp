@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef USDT_PROBE_HPP_
+#define USDT_PROBE_HPP_
+
+// Static probes for tracing with bpftrace, perf or SystemTap, e.g.
+//
+//   bpftrace -e 'usdt:./server:net:op_park { @[arg1] = count(); }'
+//
+// Define NET_USDT_PROBES to compile them in. A probe is a single nop in the
+// code and a note in the ELF file until a tracer attaches to it, its
+// arguments are only read by the tracer. Without NET_USDT_PROBES, or if
+// <sys/sdt.h> isn't installed, probes compile to nothing.
+//
+// The probes of the provider `net`:
+//   op_start(op, fd, kind)        an operation is started.
+//   op_park(op, fd, kind)         it would block and waits on its descriptor.
+//   op_wakeup(op, fd, kind)       epoll reported the descriptor ready.
+//   op_complete(op, fd, kind, ec) it completes with the errno `ec`.
+//   op_cancel(op, fd, kind)       it is stopped on the io thread.
+//   epoll_wakeup(events)          epoll_wait returned `events`.
+//   timer_fire(op)                a timer elapsed.
+//   remote_enqueue(op)            an operation is queued by another thread.
+// `kind` is the `op_kind` of the operation.
+
+#if defined(NET_USDT_PROBES) && __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+
+#define NET_USDT_PROBE(name, ...) STAP_PROBEV(net, name, __VA_ARGS__)
+#else
+#define NET_USDT_PROBE(name, ...) static_cast<void>(0)
+#endif
+
+#endif  // USDT_PROBE_HPP_
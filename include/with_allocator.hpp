@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef WITH_ALLOCATOR_HPP_
+#define WITH_ALLOCATOR_HPP_
+
+#include <concepts>  // NOLINT
+#include <type_traits>
+
+#include "stdexec.hpp"
+
+namespace net {
+namespace __with_allocator {
+// The environment of the wrapped sender: `get_allocator` returns the given
+// allocator, other queries are answered by the environment of the receiver,
+// e.g. the stop token.
+template <typename Env, typename Allocator>
+struct env {
+  friend auto tag_invoke(stdexec::get_allocator_t, const env& self) noexcept
+      -> Allocator {
+    return self.allocator_;
+  }
+
+  template <typename Tag, typename... Args>
+    requires(!std::same_as<Tag, stdexec::get_allocator_t> &&
+             stdexec::__callable<Tag, const Env&, Args...>)
+  friend auto tag_invoke(Tag tag, const env& self, Args&&... args) noexcept(
+      stdexec::__nothrow_callable<Tag, const Env&, Args...>)
+      -> stdexec::__call_result_t<Tag, const Env&, Args...> {
+    return static_cast<Tag&&>(tag)(self.base_, static_cast<Args&&>(args)...);
+  }
+
+  Env base_;
+  Allocator allocator_;
+};
+
+template <typename ReceiverId, typename Allocator>
+class receiver {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  using env_t = env<stdexec::env_of_t<receiver_t>, Allocator>;
+
+ public:
+  struct __t {
+    using is_receiver = void;
+    using __id = receiver;
+
+    template <typename... Values>
+    friend void tag_invoke(stdexec::set_value_t, __t&& self,
+                           Values&&... values) noexcept {
+      stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                         static_cast<Values&&>(values)...);
+    }
+
+    template <typename Error>
+    friend void tag_invoke(stdexec::set_error_t, __t&& self,
+                           Error&& error) noexcept {
+      stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                         static_cast<Error&&>(error));
+    }
+
+    friend void tag_invoke(stdexec::set_stopped_t, __t&& self) noexcept {
+      stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+    }
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> env_t {
+      return {stdexec::get_env(self.receiver_), self.allocator_};
+    }
+
+    receiver_t receiver_;
+    Allocator allocator_;
+  };
+};
+
+template <typename SenderId, typename Allocator>
+class sender {
+  using sender_t = stdexec::__t<SenderId>;
+  template <typename Receiver>
+  using receiver_t =
+      stdexec::__t<receiver<stdexec::__id<Receiver>, Allocator>>;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = sender;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, const __t&,
+                           Env&&) noexcept
+        -> stdexec::completion_signatures_of_t<
+            sender_t, env<std::remove_cvref_t<Env>, Allocator>>;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::env_of_t<const sender_t&> {
+      return stdexec::get_env(self.sender_);
+    }
+
+    // The operation state is the one of the wrapped sender.
+    template <stdexec::receiver Receiver>
+    friend auto tag_invoke(stdexec::connect_t, __t&& self, Receiver receiver)
+        -> stdexec::connect_result_t<sender_t, receiver_t<Receiver>> {
+      return stdexec::connect(
+          static_cast<sender_t&&>(self.sender_),
+          receiver_t<Receiver>{static_cast<Receiver&&>(receiver),
+                               self.allocator_});
+    }
+
+    template <stdexec::receiver Receiver>
+      requires std::copy_constructible<sender_t>
+    friend auto tag_invoke(stdexec::connect_t, const __t& self,
+                           Receiver receiver)
+        -> stdexec::connect_result_t<const sender_t&, receiver_t<Receiver>> {
+      return stdexec::connect(
+          self.sender_, receiver_t<Receiver>{static_cast<Receiver&&>(receiver),
+                                             self.allocator_});
+    }
+
+    sender_t sender_;
+    Allocator allocator_;
+  };
+};
+
+struct with_allocator_t {
+  // Make `allocator` the answer to `get_allocator` in the environment of
+  // `sender` and of every sender it starts, e.g. a `monotonic_arena` for the
+  // allocations of one request.
+  template <stdexec::sender Sender, typename Allocator>
+  constexpr auto operator()(Sender&& sender, Allocator allocator) const
+      -> stdexec::__t<__with_allocator::sender<
+          stdexec::__id<std::remove_cvref_t<Sender>>, Allocator>> {
+    return {static_cast<Sender&&>(sender), allocator};
+  }
+};
+}  // namespace __with_allocator
+
+inline constexpr __with_allocator::with_allocator_t with_allocator{};
+}  // namespace net
+
+#endif  // WITH_ALLOCATOR_HPP_
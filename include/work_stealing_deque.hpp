@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WORK_STEALING_DEQUE_HPP_
+#define WORK_STEALING_DEQUE_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace net {
+// A bounded Chase-Lev deque of pointers. The owning thread pushes and pops
+// at the bottom, LIFO, while any other thread may steal from the top, FIFO.
+// Follows "Correct and Efficient Work-Stealing for Weak Memory Models" by
+// Lê et al. The capacity is fixed, `push` fails when the deque is full.
+template <typename T>
+class work_stealing_deque {
+ public:
+  // The capacity is rounded up to a power of two.
+  explicit work_stealing_deque(std::size_t capacity)
+      : slots_(std::make_unique<std::atomic<T*>[]>(
+            std::bit_ceil(std::max<std::size_t>(capacity, 2)))),
+        mask_(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1),
+        top_(0),
+        bottom_(0) {}
+
+  work_stealing_deque(const work_stealing_deque&) = delete;
+  work_stealing_deque& operator=(const work_stealing_deque&) = delete;
+
+  std::size_t capacity() const noexcept { return mask_ + 1; }
+
+  // The count of items, may be outdated as soon as it returns.
+  std::size_t size() const noexcept {
+    const std::int64_t b = bottom_.load(std::memory_order_relaxed);
+    const std::int64_t t = top_.load(std::memory_order_relaxed);
+    return b > t ? static_cast<std::size_t>(b - t) : 0;
+  }
+
+  bool empty() const noexcept { return size() == 0; }
+
+  // Push `item` at the bottom. Owner only. Returns false if the deque is full.
+  bool push(T* item) noexcept {
+    const std::int64_t b = bottom_.load(std::memory_order_relaxed);
+    const std::int64_t t = top_.load(std::memory_order_acquire);
+    if (b - t > static_cast<std::int64_t>(mask_)) {
+      return false;
+    }
+    slots_[b & mask_].store(item, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Pop the most recently pushed item. Owner only. Returns nullptr if the
+  // deque is empty or a thief took the last item.
+  T* pop() noexcept {
+    const std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    T* item = slots_[b & mask_].load(std::memory_order_relaxed);
+    if (t == b) {
+      // The last item, race the thieves for it.
+      if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+        item = nullptr;
+      }
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return item;
+  }
+
+  // Steal the least recently pushed item. Any thread. Returns nullptr if the
+  // deque is empty or another thread won the race for the item.
+  T* steal() noexcept {
+    std::int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const std::int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) {
+      return nullptr;
+    }
+    T* item = slots_[t & mask_].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return item;
+  }
+
+ private:
+  std::unique_ptr<std::atomic<T*>[]> slots_;
+  std::size_t mask_;
+  // Thieves touch `top_`, the owner mostly `bottom_`, keep them apart.
+  alignas(64) std::atomic<std::int64_t> top_;
+  alignas(64) std::atomic<std::int64_t> bottom_;
+};
+
+}  // namespace net
+
+#endif  // WORK_STEALING_DEQUE_HPP_
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef XDP_RECV_BATCH_OP_HPP_
+#define XDP_RECV_BATCH_OP_HPP_
+
+#include <cstddef>
+#include <system_error>  // NOLINT
+
+#include "datagram_batch.hpp"
+#include "meta.hpp"
+#include "stdexec.hpp"
+#include "xdp/xdp_context.hpp"
+
+namespace net {
+namespace __xdp {
+
+// Receive up to `batch.size()` datagrams from the RX ring, waiting until at
+// least one has arrived. The payloads are copied into the buffers of the
+// batch, which are filled the same way as by recvmmsg.
+template <typename ReceiverId, typename Protocol>
+class xdp_context::recv_batch_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  using base_t = stdexec::__t<xdp_context::io_base_op<ReceiverId>>;
+  using batch_t = datagram_batch<Protocol>;
+
+ public:
+  struct __t : public base_t {
+    using __id = recv_batch_op;
+
+    // Constructor.
+    constexpr __t(receiver_t receiver, xdp_context& context,
+                  batch_t& batch) noexcept
+        : base_t(static_cast<receiver_t&&>(receiver), context, op_vtable,
+                 &xdp_context::receivers_),
+          count_(0),
+          batch_(batch) {
+      batch_.prepare_receive();
+    }
+
+   private:
+    static bool perform(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      self.count_ = self.context_.receive(self.batch_.native_messages(),
+                                          self.batch_.size());
+      return self.count_ != 0 || self.batch_.empty();
+    }
+
+    static void complete(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                         self.count_);
+    }
+
+    static constexpr typename base_t::op_vtable op_vtable{&perform,
+                                                          &complete};
+    std::size_t count_;
+    batch_t& batch_;
+  };
+};
+
+template <typename Protocol>
+class recv_batch_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<
+      xdp_context::recv_batch_op<stdexec::__id<Receiver>, Protocol>>;
+  using batch_t = datagram_batch<Protocol>;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = recv_batch_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(size_t),
+                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.context_, self.batch_};
+    }
+
+    constexpr __t(xdp_context& context, batch_t& batch) noexcept
+        : context_(context), batch_(batch) {}
+
+   private:
+    xdp_context& context_;
+    batch_t& batch_;
+  };
+};
+
+// Receive datagrams into the buffers of `batch`. Completes with the count of
+// datagrams received, their lengths and sources are stored in the batch.
+struct async_recv_batch_t {
+  template <transport_protocol Protocol>
+  constexpr auto operator()(xdp_context& context,
+                            datagram_batch<Protocol>& batch) const noexcept
+      -> stdexec::__t<recv_batch_sender<Protocol>> {
+    return {context, batch};
+  }
+};
+}  // namespace __xdp
+
+namespace xdp {
+inline constexpr __xdp::async_recv_batch_t async_recv_batch{};
+}  // namespace xdp
+}  // namespace net
+
+#endif  // XDP_RECV_BATCH_OP_HPP_
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef XDP_SEND_BATCH_OP_HPP_
+#define XDP_SEND_BATCH_OP_HPP_
+
+#include <cstddef>
+#include <system_error>  // NOLINT
+
+#include "datagram_batch.hpp"
+#include "meta.hpp"
+#include "stdexec.hpp"
+#include "xdp/xdp_context.hpp"
+
+namespace net {
+namespace __xdp {
+
+// Put up to `batch.size()` datagrams on the TX ring, waiting until at least
+// one frame is free. The payloads are copied into the frames, so the buffers
+// can be reused as soon as the operation completes. Like sendmmsg, an error
+// is only reported for the first datagram.
+template <typename ReceiverId, typename Protocol>
+class xdp_context::send_batch_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+  using base_t = stdexec::__t<xdp_context::io_base_op<ReceiverId>>;
+  using batch_t = datagram_batch<Protocol>;
+
+ public:
+  struct __t : public base_t {
+    using __id = send_batch_op;
+
+    // Constructor.
+    constexpr __t(receiver_t receiver, xdp_context& context,
+                  batch_t& batch) noexcept
+        : base_t(static_cast<receiver_t&&>(receiver), context, op_vtable,
+                 &xdp_context::senders_),
+          count_(0),
+          ec_(),
+          batch_(batch) {}
+
+   private:
+    static bool perform(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      self.count_ = self.context_.send(self.batch_.native_messages(),
+                                       self.batch_.size(), self.ec_);
+      return self.count_ != 0 || self.ec_ || self.batch_.empty();
+    }
+
+    static void complete(base_t* base) noexcept {
+      auto& self = *static_cast<__t*>(base);
+      if (self.ec_) {
+        stdexec::set_error(static_cast<receiver_t&&>(self.receiver_),
+                           static_cast<std::error_code&&>(self.ec_));
+      } else {
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_),
+                           self.count_);
+      }
+    }
+
+    static constexpr typename base_t::op_vtable op_vtable{&perform,
+                                                          &complete};
+    std::size_t count_;
+    std::error_code ec_;
+    batch_t& batch_;
+  };
+};
+
+template <typename Protocol>
+class send_batch_sender {
+  template <typename Receiver>
+  using op_t = stdexec::__t<
+      xdp_context::send_batch_op<stdexec::__id<Receiver>, Protocol>>;
+  using batch_t = datagram_batch<Protocol>;
+
+ public:
+  struct __t {
+    using is_sender = void;
+    using __id = send_batch_sender;
+    using completion_signatures =
+        stdexec::completion_signatures<stdexec::set_value_t(size_t),
+                                       stdexec::set_error_t(std::error_code&&),
+                                       stdexec::set_stopped_t()>;
+
+    template <typename Env>
+    friend auto tag_invoke(stdexec::get_completion_signatures_t, __t&& self,
+                           Env&&) noexcept -> completion_signatures;
+
+    friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+        -> stdexec::empty_env {
+      return {};
+    }
+
+    template <stdexec::__decays_to<__t> Sender,
+              stdexec::receiver_of<completion_signatures> Receiver>
+    friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                           Receiver receiver) noexcept -> op_t<Receiver> {
+      return {static_cast<Receiver&&>(receiver), self.context_, self.batch_};
+    }
+
+    constexpr __t(xdp_context& context, batch_t& batch) noexcept
+        : context_(context), batch_(batch) {}
+
+   private:
+    xdp_context& context_;
+    batch_t& batch_;
+  };
+};
+
+// Send the datagrams of `batch` to their peers, which must have sent a
+// datagram to the context before. Completes with the count of datagrams
+// sent, their lengths are stored in the batch.
+struct async_send_batch_t {
+  template <transport_protocol Protocol>
+  constexpr auto operator()(xdp_context& context,
+                            datagram_batch<Protocol>& batch) const noexcept
+      -> stdexec::__t<send_batch_sender<Protocol>> {
+    return {context, batch};
+  }
+};
+}  // namespace __xdp
+
+namespace xdp {
+inline constexpr __xdp::async_send_batch_t async_send_batch{};
+}  // namespace xdp
+}  // namespace net
+
+#endif  // XDP_SEND_BATCH_OP_HPP_
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef XDP_UDP_FRAME_HPP_
+#define XDP_UDP_FRAME_HPP_
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace net::xdp {
+
+// The link, network and transport addresses of a UDP datagram carried in an
+// Ethernet frame. The IP addresses are in network order, an IPv4 address
+// takes the first four bytes, the ports are in host order.
+struct udp_frame_addresses {
+  std::uint8_t source_mac[6];
+  std::uint8_t destination_mac[6];
+  int family;
+  std::uint8_t source_ip[16];
+  std::uint8_t destination_ip[16];
+  std::uint16_t source_port;
+  std::uint16_t destination_port;
+
+  // The addresses of a reply to this datagram.
+  udp_frame_addresses reversed() const noexcept {
+    udp_frame_addresses r = *this;
+    std::memcpy(r.source_mac, destination_mac, 6);
+    std::memcpy(r.destination_mac, source_mac, 6);
+    std::memcpy(r.source_ip, destination_ip, 16);
+    std::memcpy(r.destination_ip, source_ip, 16);
+    r.source_port = destination_port;
+    r.destination_port = source_port;
+    return r;
+  }
+};
+
+namespace __udp_frame {
+inline constexpr std::size_t ethernet_size = 14;
+inline constexpr std::size_t ipv4_size = 20;
+inline constexpr std::size_t ipv6_size = 40;
+inline constexpr std::size_t udp_size = 8;
+inline constexpr std::uint16_t ethertype_ipv4 = 0x0800;
+inline constexpr std::uint16_t ethertype_ipv6 = 0x86dd;
+
+inline std::uint16_t load16(const std::uint8_t* p) noexcept {
+  return static_cast<std::uint16_t>((p[0] << 8) | p[1]);
+}
+
+inline void store16(std::uint8_t* p, std::uint16_t v) noexcept {
+  p[0] = static_cast<std::uint8_t>(v >> 8);
+  p[1] = static_cast<std::uint8_t>(v);
+}
+
+// Add the 16-bit big endian words of `size` bytes at `p` to `sum`.
+inline std::uint64_t add_words(std::uint64_t sum, const std::uint8_t* p,
+                               std::size_t size) noexcept {
+  for (; size >= 2; p += 2, size -= 2) {
+    sum += load16(p);
+  }
+  if (size != 0) {
+    sum += static_cast<std::uint64_t>(p[0]) << 8;
+  }
+  return sum;
+}
+
+// Fold a sum of words into the one's complement checksum.
+inline std::uint16_t fold(std::uint64_t sum) noexcept {
+  while ((sum >> 16) != 0) {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  return static_cast<std::uint16_t>(~sum);
+}
+}  // namespace __udp_frame
+
+// The size of the Ethernet, IP and UDP headers in front of the payload.
+inline constexpr std::size_t udp_frame_header_size(int family) noexcept {
+  using namespace __udp_frame;  // NOLINT
+  return ethernet_size + (family == AF_INET ? ipv4_size : ipv6_size) +
+         udp_size;
+}
+
+// Parse an untagged Ethernet frame of `size` bytes carrying an unfragmented
+// UDP datagram over IPv4 or over IPv6 without extension headers. On success
+// the addresses are stored in `addrs`, the payload lies at `*payload` with
+// `*payload_size` bytes, and true is returned.
+inline bool parse_udp_frame(const std::uint8_t* frame, std::size_t size,
+                            udp_frame_addresses& addrs,
+                            const std::uint8_t** payload,
+                            std::size_t* payload_size) noexcept {
+  using namespace __udp_frame;  // NOLINT
+  if (size < ethernet_size) {
+    return false;
+  }
+  const std::uint8_t* ip = frame + ethernet_size;
+  const std::size_t ip_room = size - ethernet_size;
+  const std::uint8_t* udp = nullptr;
+  std::size_t udp_room = 0;
+  switch (load16(frame + 12)) {
+    case ethertype_ipv4: {
+      if (ip_room < ipv4_size || (ip[0] >> 4) != 4) {
+        return false;
+      }
+      const std::size_t header = (ip[0] & 0x0f) * 4u;
+      const std::size_t total = load16(ip + 2);
+      if (header < ipv4_size || total < header || total > ip_room ||
+          ip[9] != IPPROTO_UDP || (load16(ip + 6) & 0x3fff) != 0) {
+        return false;
+      }
+      addrs.family = AF_INET;
+      std::memcpy(addrs.source_ip, ip + 12, 4);
+      std::memcpy(addrs.destination_ip, ip + 16, 4);
+      udp = ip + header;
+      udp_room = total - header;
+      break;
+    }
+    case ethertype_ipv6: {
+      if (ip_room < ipv6_size || (ip[0] >> 4) != 6 || ip[6] != IPPROTO_UDP) {
+        return false;
+      }
+      const std::size_t length = load16(ip + 4);
+      if (length > ip_room - ipv6_size) {
+        return false;
+      }
+      addrs.family = AF_INET6;
+      std::memcpy(addrs.source_ip, ip + 8, 16);
+      std::memcpy(addrs.destination_ip, ip + 24, 16);
+      udp = ip + ipv6_size;
+      udp_room = length;
+      break;
+    }
+    default:
+      return false;
+  }
+  if (udp_room < udp_size) {
+    return false;
+  }
+  const std::size_t length = load16(udp + 4);
+  if (length < udp_size || length > udp_room) {
+    return false;
+  }
+  std::memcpy(addrs.destination_mac, frame, 6);
+  std::memcpy(addrs.source_mac, frame + 6, 6);
+  addrs.source_port = load16(udp);
+  addrs.destination_port = load16(udp + 2);
+  *payload = udp + udp_size;
+  *payload_size = length - udp_size;
+  return true;
+}
+
+// Write the Ethernet, IP and UDP headers for the `payload_size` bytes which
+// are already at `frame + udp_frame_header_size(addrs.family)`, including
+// both checksums. Returns the size of the frame.
+inline std::size_t write_udp_frame_headers(std::uint8_t* frame,
+                                           const udp_frame_addresses& addrs,
+                                           std::size_t payload_size) noexcept {
+  using namespace __udp_frame;  // NOLINT
+  std::memcpy(frame, addrs.destination_mac, 6);
+  std::memcpy(frame + 6, addrs.source_mac, 6);
+  std::uint8_t* ip = frame + ethernet_size;
+  const std::uint16_t udp_length =
+      static_cast<std::uint16_t>(udp_size + payload_size);
+  std::uint8_t* udp = nullptr;
+  std::uint64_t sum = 0;
+  if (addrs.family == AF_INET) {
+    store16(frame + 12, ethertype_ipv4);
+    ip[0] = 0x45;
+    ip[1] = 0;
+    store16(ip + 2, static_cast<std::uint16_t>(ipv4_size + udp_length));
+    store16(ip + 4, 0);
+    store16(ip + 6, 0x4000);  // Don't fragment.
+    ip[8] = 64;
+    ip[9] = IPPROTO_UDP;
+    store16(ip + 10, 0);
+    std::memcpy(ip + 12, addrs.source_ip, 4);
+    std::memcpy(ip + 16, addrs.destination_ip, 4);
+    store16(ip + 10, fold(add_words(0, ip, ipv4_size)));
+    sum = add_words(sum, ip + 12, 8);
+    udp = ip + ipv4_size;
+  } else {
+    store16(frame + 12, ethertype_ipv6);
+    ip[0] = 0x60;
+    ip[1] = ip[2] = ip[3] = 0;
+    store16(ip + 4, udp_length);
+    ip[6] = IPPROTO_UDP;
+    ip[7] = 64;
+    std::memcpy(ip + 8, addrs.source_ip, 16);
+    std::memcpy(ip + 24, addrs.destination_ip, 16);
+    sum = add_words(sum, ip + 8, 32);
+    udp = ip + ipv6_size;
+  }
+  store16(udp, addrs.source_port);
+  store16(udp + 2, addrs.destination_port);
+  store16(udp + 4, udp_length);
+  store16(udp + 6, 0);
+  sum += IPPROTO_UDP + udp_length;
+  std::uint16_t checksum = fold(add_words(sum, udp, udp_length));
+  // A zero checksum means none, send all ones instead.
+  store16(udp + 6, checksum == 0 ? 0xffff : checksum);
+  return ethernet_size + (addrs.family == AF_INET ? ipv4_size : ipv6_size) +
+         udp_length;
+}
+
+// A direct mapped cache of the addresses to reply to peers with, learned
+// from the datagrams they sent. A peer is identified by its IP address and
+// port, and a peer which collides with a newer one is forgotten.
+class udp_peer_cache {
+ public:
+  // Construct an empty cache with room for `capacity` peers, rounded up to a
+  // power of two.
+  explicit udp_peer_cache(std::size_t capacity)
+      : entries_(round_up(capacity)) {
+    for (udp_frame_addresses& entry : entries_) {
+      entry.family = AF_UNSPEC;
+    }
+  }
+
+  // Remember the addresses to reply to the sender of a datagram with the
+  // addresses `received`.
+  void learn(const udp_frame_addresses& received) noexcept {
+    entries_[index(received.family, received.source_ip,
+                   received.source_port)] = received.reversed();
+  }
+
+  // Find the addresses to send a datagram to the peer at `ip` and `port`,
+  // returns nullptr if it's unknown.
+  const udp_frame_addresses* find(int family, const std::uint8_t* ip,
+                                  std::uint16_t port) const noexcept {
+    const udp_frame_addresses& entry = entries_[index(family, ip, port)];
+    if (entry.family != family || entry.destination_port != port ||
+        std::memcmp(entry.destination_ip, ip, ip_size(family)) != 0) {
+      return nullptr;
+    }
+    return &entry;
+  }
+
+  // The count of peers which can be remembered.
+  std::size_t capacity() const noexcept { return entries_.size(); }
+
+ private:
+  static std::size_t round_up(std::size_t capacity) noexcept {
+    std::size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    return size;
+  }
+
+  static std::size_t ip_size(int family) noexcept {
+    return family == AF_INET ? 4 : 16;
+  }
+
+  // FNV-1a of the address and the port.
+  std::size_t index(int family, const std::uint8_t* ip,
+                    std::uint16_t port) const noexcept {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (std::size_t i = 0; i < ip_size(family); ++i) {
+      hash = (hash ^ ip[i]) * 1099511628211ull;
+    }
+    hash = (hash ^ (port & 0xff)) * 1099511628211ull;
+    hash = (hash ^ (port >> 8)) * 1099511628211ull;
+    return static_cast<std::size_t>(hash) & (entries_.size() - 1);
+  }
+
+  std::vector<udp_frame_addresses> entries_;
+};
+
+}  // namespace net::xdp
+
+#endif  // XDP_UDP_FRAME_HPP_
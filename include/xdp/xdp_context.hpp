@@ -0,0 +1,848 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef XDP_XDP_CONTEXT_HPP_
+#define XDP_XDP_CONTEXT_HPP_
+
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>  // NOLINT
+#include <utility>
+
+#include "stdexec.hpp"
+
+#include "atomic_intrusive_queue.hpp"
+#include "eventfd_interrupter.hpp"
+#include "execution_context.hpp"
+#include "intrusive_list.hpp"
+#include "xdp/udp_frame.hpp"
+#include "xdp/xdp_program.hpp"
+#include "xdp/xsk_socket.hpp"
+
+namespace net {
+namespace __xdp {
+// An execution context which exchanges UDP datagrams over an AF_XDP socket,
+// bypassing the kernel network stack. The context owns the socket of one
+// receive queue of an interface and an XDP program which redirects the UDP
+// datagrams of that queue to it, everything else still reaches the kernel.
+// Like epoll_context, only one thread is allowed to run the context, which is
+// called io thread, and it polls the rings of the socket between operations.
+//
+// There is no ARP or neighbor discovery: the link and network addresses to
+// reply to a peer are learned from the datagrams it sent, and sending to a
+// peer which hasn't been heard from fails with host_unreachable.
+class xdp_context final : public execution_context {
+ public:
+  // The scheduler of this context, which supports `schedule`.
+  class scheduler;
+
+  struct options {
+    // The name of the network interface.
+    std::string interface;
+
+    // The receive queue of the interface.
+    std::uint32_t queue = 0;
+
+    // Only datagrams to this port are redirected, or all UDP datagrams if 0.
+    std::uint16_t port = 0;
+
+    // The count of descriptors of every ring, a power of two. The UMEM has
+    // twice as many frames.
+    std::uint32_t ring_size = 2048;
+
+    // The size of every frame of the UMEM.
+    std::uint32_t frame_size = 2048;
+
+    // Whether the driver must map the UMEM for DMA.
+    bool zero_copy = false;
+
+    // The XDP_FLAGS_* to attach the program with, e.g. XDP_FLAGS_SKB_MODE for
+    // drivers without native XDP support.
+    std::uint32_t attach_flags = 0;
+
+    // The program shared by the contexts of all queues of the interface. If
+    // null, the context loads one for its own queue.
+    std::shared_ptr<xdp::xdp_program> program;
+
+    // The count of peers whose addresses are remembered.
+    std::size_t peer_capacity = 4096;
+
+    // Spin on the rings instead of sleeping in poll() when idle.
+    bool busy_poll = false;
+  };
+
+  // The base class for all the types of operations that this context can
+  // perform. Note that operations will be executed by context in the order they
+  // are committed.
+  struct operation_base {
+    // Default constructor.
+    constexpr operation_base() noexcept
+        : enqueued_(false), next_(nullptr), execute_(nullptr) {}
+
+    // Destructor.
+    constexpr ~operation_base() = default;
+
+    // The flag determines whether the current operation is in a remote or local
+    // queue.
+    std::atomic_bool enqueued_;
+
+    // The `next_` pointer points to the next operation on the operation queue,
+    operation_base* next_;
+
+    // The `execute_` pointer points to the actual function to be executed.
+    void (*execute_)(operation_base*) noexcept;  // NOLINT
+  };
+
+  // An operation which waits for the rings, it's executed again whenever the
+  // rings may let it make progress.
+  struct wait_op : operation_base {
+    wait_op* next_waiting_ = nullptr;
+    wait_op* prev_waiting_ = nullptr;
+  };
+
+  // The stop operation.
+  struct stop_op : operation_base {};
+
+  // The base class of operations which wait for the rings.
+  template <typename ReceiverId>
+  class io_base_op;
+
+  // Receive a batch of datagrams.
+  template <typename ReceiverId, typename Protocol>
+  class recv_batch_op;
+
+  // Send a batch of datagrams.
+  template <typename ReceiverId, typename Protocol>
+  class send_batch_op;
+
+  // The queue of operations.
+  using operation_queue = stdexec::__intrusive_queue<&operation_base::next_>;
+
+  // The list of operations waiting for the rings.
+  using wait_list = intrusive_list<wait_op, &wait_op::next_waiting_,
+                                   &wait_op::prev_waiting_>;
+
+  // Constructor. Throws an error when the interface doesn't exist, or the
+  // socket can't be bound or the program can't be attached.
+  explicit xdp_context(const options& opts)
+      : ifindex_(interface_index(opts.interface)),
+        queue_(opts.queue),
+        busy_poll_(opts.busy_poll),
+        xsk_({.ifindex = ifindex_,
+              .queue = opts.queue,
+              .ring_size = opts.ring_size,
+              .frame_size = opts.frame_size,
+              .zero_copy = opts.zero_copy}),
+        program_(opts.program),
+        peers_(opts.peer_capacity),
+        interrupter_(),
+        processed_remote_queue_submitted_(false),
+        local_queue_(),
+        remote_queue_(),
+        receivers_(),
+        senders_(),
+        stop_source_(std::in_place),
+        is_running_(false) {
+    if (program_ == nullptr) {
+      program_ = std::make_shared<xdp::xdp_program>(
+          ifindex_, opts.queue + 1, opts.port, opts.attach_flags);
+    }
+    program_->insert(queue_, xsk_.native_handle());
+  }
+
+  // Destructor. The datagrams of the queue are passed to the kernel again.
+  ~xdp_context() { program_->erase(queue_); }
+
+  // Execute all operations submitted to this context.
+  void run();
+
+  // Request to stop the context. Note that the context may block on the
+  // poll call, so we must use interrupt to wake up the context.
+  void request_stop() {
+    stop_source_->request_stop();
+    interrupter_.interrupt();
+  }
+
+  // Whether this context have been request to stop.
+  bool stop_requested() const noexcept {
+    return stop_source_->stop_requested();
+  }
+
+  // Get this context associated stop token.
+  stdexec::in_place_stop_token get_stop_token() const noexcept {
+    return stop_source_->get_token();
+  }
+
+  // Check whether this context is running.
+  bool is_running() const noexcept {
+    return is_running_.load(std::memory_order_relaxed);
+  }
+
+  // CPO: get_scheduler.
+  constexpr scheduler get_scheduler() noexcept;
+
+ private:
+  // Get the index of the interface `name`. Throws an error if it doesn't
+  // exist.
+  static int interface_index(const std::string& name) {
+    unsigned index = ::if_nametoindex(name.c_str());
+    if (index == 0) {
+      throw std::system_error{static_cast<int>(errno), std::system_category(),
+                              "if_nametoindex"};
+    }
+    return static_cast<int>(index);
+  }
+
+  // The thread that calls `context.run()` is called io thread, and other
+  // threads are remote threads. This function checks which thread is using the
+  // context.
+  bool is_running_on_io_thread() const noexcept;
+
+  // Schedule the operation to the local queue if called on the io thread,
+  // otherwise to the remote queue.
+  void schedule_impl(operation_base* op) noexcept;
+
+  // Schedule the operation to the local queue.
+  void schedule_local(operation_base* op) noexcept;
+
+  // Move all contents from remote queue to local queue.
+  void schedule_local(operation_queue ops) noexcept;
+
+  // Schedule the operation to the remote queue.
+  void schedule_remote(operation_base* op) noexcept;
+
+  // Execute all items on the local queue.
+  // Won't run other items that were enqueued during the execution of the items
+  // that were already enqueued. This bounds the amount of work to a finite
+  // amount.
+  std::size_t execute_local() noexcept;
+
+  // Collect the contents of the remote queue and pass them to local queue.
+  // Returns true means remote queue is emtpy before we collect.
+  bool try_schedule_remote_to_local() noexcept;
+
+  // Execute the operations of `waiting` which were waiting before this call.
+  static void wake_up(wait_list& waiting) noexcept;
+
+  // Wake up the waiting operations which can make progress. Returns true if
+  // any was woken up.
+  bool process_rings() noexcept;
+
+  // Sleep in poll() until the rings or the interrupter are ready, unless
+  // busy polling.
+  void wait();
+
+  // Receive up to `count` datagrams into the messages, the same way as
+  // recvmmsg. Returns the count of datagrams.
+  std::size_t receive(::mmsghdr* msgs, std::size_t count) noexcept;
+
+  // Send up to `count` datagrams of the messages, the same way as sendmmsg.
+  // Returns the count of datagrams, 0 with `ec` cleared when the rings are
+  // full.
+  std::size_t send(::mmsghdr* msgs, std::size_t count,
+                   std::error_code& ec) noexcept;
+
+  // The index of the interface.
+  int ifindex_;
+
+  // The receive queue.
+  std::uint32_t queue_;
+
+  // Whether to spin instead of sleeping.
+  bool busy_poll_;
+
+  // The AF_XDP socket.
+  xdp::xsk_socket xsk_;
+
+  // The program which redirects the datagrams to the socket.
+  std::shared_ptr<xdp::xdp_program> program_;
+
+  // The addresses to reply to peers with.
+  xdp::udp_peer_cache peers_;
+
+  // Notifying a remote thread to wake up from `poll`.
+  eventfd_interrupter interrupter_;
+
+  // Whether the operation submitted by the remote thread has been processed.
+  bool processed_remote_queue_submitted_;
+
+  // Local queue for operations that are ready to execute.
+  operation_queue local_queue_;
+
+  // Queue of operations enqueued by remote threads.
+  atomic_intrusive_queue<&operation_base::next_> remote_queue_;
+
+  // The operations waiting for datagrams.
+  wait_list receivers_;
+
+  // The operations waiting for free frames.
+  wait_list senders_;
+
+  // The stop source.
+  std::optional<stdexec::in_place_stop_source> stop_source_;
+
+  // Whether this context is running.
+  std::atomic_bool is_running_;
+};
+
+// The base class of operations which wait for the rings. Subclasses provide
+// how to make progress and how to complete the receiver with the outcome.
+// Every step runs on the io thread, a stop request is forwarded by a stop
+// operation.
+template <typename ReceiverId>
+class xdp_context::io_base_op {
+  using receiver_t = stdexec::__t<ReceiverId>;
+
+ public:
+  struct __t : public stdexec::__immovable,
+               private xdp_context::wait_op,
+               private xdp_context::stop_op {
+    using __id = io_base_op;
+    using stop_token = stdexec::stop_token_of_t<stdexec::env_of_t<receiver_t>>;
+
+    // Subclasses should provide these necessary functions.
+    struct op_vtable {
+      // Try to make progress, returns false to wait for the rings.
+      bool (*perform)(__t*) noexcept = nullptr;  // NOLINT
+
+      // The operation is done, notify the downstream receiver.
+      void (*complete)(__t*) noexcept = nullptr;  // NOLINT
+    };
+
+    struct cancel_callback {
+      __t& op_;
+
+      void operator()() noexcept { op_.request_stop(); }
+    };
+
+    // Constructor. The operation waits on the `waiting` list of the context.
+    __t(receiver_t receiver, xdp_context& context, const op_vtable& vtable,
+        wait_list xdp_context::*waiting) noexcept
+        : receiver_(static_cast<receiver_t&&>(receiver)),
+          context_(context),
+          op_vtable_(&vtable),
+          waiting_(waiting),
+          stop_requested_(false),
+          parked_(false),
+          completed_(false),
+          stop_executed_(false),
+          stop_callback_() {}
+
+    friend void tag_invoke(stdexec::start_t, __t& self) noexcept {
+      self.start_impl();
+    }
+
+    void start_impl() noexcept {
+      static_cast<wait_op*>(this)->execute_ = &__t::on_schedule_complete;
+      if (!context_.is_running_on_io_thread()) {
+        context_.schedule_remote(static_cast<wait_op*>(this));
+      } else {
+        perform();
+      }
+    }
+
+    // xdp_context starts to execute this operation in the io thread.
+    static void on_schedule_complete(operation_base* op) noexcept {
+      static_cast<__t*>(static_cast<wait_op*>(op))->perform();
+    }
+
+    void perform() noexcept {
+      assert(context_.is_running_on_io_thread());
+      if constexpr (!stdexec::unstoppable_token<stop_token>) {
+        if (stdexec::get_stop_token(stdexec::get_env(receiver_))
+                .stop_requested()) {
+          stdexec::set_stopped(static_cast<receiver_t&&>(receiver_));
+          return;
+        }
+      }
+      if (op_vtable_->perform(this)) {
+        op_vtable_->complete(this);
+        return;
+      }
+      park();
+      if constexpr (!stdexec::unstoppable_token<stop_token>) {
+        stop_callback_.__construct(
+            stdexec::get_stop_token(stdexec::get_env(receiver_)),
+            cancel_callback{*this});
+      }
+    }
+
+    void park() noexcept {
+      static_cast<wait_op*>(this)->execute_ = &__t::on_ready;
+      (context_.*waiting_).push_back(static_cast<wait_op*>(this));
+      parked_ = true;
+    }
+
+    // The context has taken this operation off its list, the rings may let
+    // it make progress.
+    static void on_ready(operation_base* op) noexcept {
+      auto& self = *static_cast<__t*>(static_cast<wait_op*>(op));
+      self.parked_ = false;
+      if (!self.op_vtable_->perform(&self)) {
+        self.park();
+        return;
+      }
+      if constexpr (!stdexec::unstoppable_token<stop_token>) {
+        // Wait for a concurrent stop request to finish.
+        self.stop_callback_.__destruct();
+      }
+      if (self.stop_requested_.load(std::memory_order_acquire) &&
+          !self.stop_executed_) {
+        // The stop operation is on its way, let it complete the operation.
+        self.completed_ = true;
+        return;
+      }
+      self.op_vtable_->complete(&self);
+    }
+
+    static void on_stop(operation_base* op) noexcept {
+      auto& self = *static_cast<__t*>(static_cast<stop_op*>(op));
+      self.stop_executed_ = true;
+      if (self.completed_) {
+        self.op_vtable_->complete(&self);
+        return;
+      }
+      assert(self.parked_);
+      (self.context_.*self.waiting_).remove(static_cast<wait_op*>(&self));
+      self.parked_ = false;
+      if constexpr (!stdexec::unstoppable_token<stop_token>) {
+        self.stop_callback_.__destruct();
+      }
+      stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+    }
+
+    // Any thread requests that this operation should be stopped.
+    void request_stop() noexcept {
+      stop_requested_.store(true, std::memory_order_release);
+      static_cast<stop_op*>(this)->execute_ = &__t::on_stop;
+      context_.schedule_impl(static_cast<stop_op*>(this));
+    }
+
+    receiver_t receiver_;
+    xdp_context& context_;
+    const op_vtable* op_vtable_;
+    wait_list xdp_context::*waiting_;
+    std::atomic<bool> stop_requested_;
+
+    // Only accessed by the io thread.
+    bool parked_;
+    bool completed_;
+    bool stop_executed_;
+    exec::__manual_lifetime<
+        typename stop_token::template callback_type<cancel_callback>>
+        stop_callback_;
+  };
+};
+
+// The scheduler with returned by `stdexec::get_schedule` customization point
+// object.
+class xdp_context::scheduler {
+  // The envrionment of scheduler.
+  struct schedule_env {
+    friend auto tag_invoke(
+        stdexec::get_completion_scheduler_t<stdexec::set_value_t>,
+        const schedule_env& env) noexcept -> scheduler {
+      return scheduler{env.context};
+    }
+
+    explicit constexpr schedule_env(xdp_context& ctx) noexcept
+        : context(ctx) {}
+
+    xdp_context& context;
+  };  // schedule_env
+
+  template <typename ReceiverId>
+  class schedule_op {
+    using receiver_t = stdexec::__t<ReceiverId>;
+
+   public:
+    struct __t : private operation_base {
+      using __id = schedule_op;
+      using stop_token =
+          stdexec::stop_token_of_t<stdexec::env_of_t<receiver_t>&>;
+
+      constexpr __t(xdp_context& context, receiver_t r)
+          : context_(context), receiver_(static_cast<receiver_t&&>(r)) {
+        execute_ = &execute_impl;
+      }
+
+      friend void tag_invoke(stdexec::start_t, __t& op) noexcept {
+        op.context_.schedule_impl(&op);
+      }
+
+     private:
+      static constexpr void execute_impl(operation_base* p) noexcept {
+        auto& self = *static_cast<__t*>(p);
+        if constexpr (!std::unstoppable_token<stop_token>) {
+          auto stop_token =
+              stdexec::get_stop_token(stdexec::get_env(self.receiver_));
+          if (stop_token.stop_requested()) {
+            stdexec::set_stopped(static_cast<receiver_t&&>(self.receiver_));
+            return;
+          }
+        }
+        stdexec::set_value(static_cast<receiver_t&&>(self.receiver_));
+      }
+
+      xdp_context& context_;
+      STDEXEC_NO_UNIQUE_ADDRESS receiver_t receiver_;
+    };
+  };  // schedule_op.
+
+  class schedule_sender {
+    template <typename Receiver>
+    using op_t = stdexec::__t<schedule_op<stdexec::__id<Receiver>>>;
+
+   public:
+    struct __t {
+      using is_sender = void;
+      using __id = schedule_sender;
+      using completion_signatures =
+          stdexec::completion_signatures<stdexec::set_value_t(),  //
+                                         stdexec::set_stopped_t()>;
+
+      template <typename Env>
+      friend auto tag_invoke(stdexec::get_completion_signatures_t,
+                             const __t& self, Env&&) noexcept
+          -> completion_signatures;
+
+      friend auto tag_invoke(stdexec::get_env_t, const __t& self) noexcept
+          -> schedule_env {
+        return self.env_;
+      }
+
+      template <stdexec::__decays_to<__t> Sender,
+                stdexec::receiver_of<completion_signatures> Receiver>
+      friend auto tag_invoke(stdexec::connect_t, Sender&& self,
+                             Receiver receiver) noexcept -> op_t<Receiver> {
+        return {static_cast<__t&&>(self).env_.context,
+                static_cast<Receiver&&>(receiver)};
+      }
+
+      explicit constexpr __t(schedule_env env) noexcept : env_(env) {}
+
+     private:
+      schedule_env env_;
+    };
+  };  // schedule_sender.
+
+ public:
+  // Constructors.
+  explicit constexpr scheduler(xdp_context& context) noexcept
+      : context_(&context) {}
+
+  constexpr scheduler(const scheduler&) noexcept = default;
+
+  constexpr scheduler& operator=(const scheduler&) = default;
+
+  constexpr ~scheduler() = default;
+
+  friend auto tag_invoke(stdexec::schedule_t, const scheduler& sched) noexcept
+      -> stdexec::__t<schedule_sender> {
+    return stdexec::__t<schedule_sender>{schedule_env{*sched.context_}};
+  }
+
+  // The context this scheduler schedules on.
+  constexpr xdp_context& context() const noexcept { return *context_; }
+
+ private:
+  friend bool operator==(scheduler a, scheduler b) noexcept {
+    return a.context_ == b.context_;
+  }
+
+  friend bool operator!=(scheduler a, scheduler b) noexcept {
+    return a.context_ != b.context_;
+  }
+
+  xdp_context* context_;
+};
+
+inline constexpr xdp_context::scheduler xdp_context::get_scheduler() noexcept {
+  return scheduler{*this};
+}
+
+// The context run by the current thread. An inline variable, so that every
+// translation unit sees the same slot and recognizes the io thread.
+inline thread_local xdp_context* current_thread_context = nullptr;
+
+inline bool xdp_context::is_running_on_io_thread() const noexcept {
+  return this == current_thread_context;
+}
+
+inline std::size_t xdp_context::receive(::mmsghdr* msgs,
+                                        std::size_t count) noexcept {
+  std::size_t received = 0;
+  auto deliver = [&](const std::uint8_t* frame, std::size_t size) noexcept {
+    xdp::udp_frame_addresses addrs;
+    const std::uint8_t* payload = nullptr;
+    std::size_t payload_size = 0;
+    if (!xdp::parse_udp_frame(frame, size, addrs, &payload, &payload_size)) {
+      return;
+    }
+    peers_.learn(addrs);
+    ::msghdr& msg = msgs[received].msg_hdr;
+    std::size_t copied = 0;
+    for (std::size_t i = 0; i < msg.msg_iovlen && copied < payload_size;
+         ++i) {
+      std::size_t n = std::min(msg.msg_iov[i].iov_len, payload_size - copied);
+      std::memcpy(msg.msg_iov[i].iov_base, payload + copied, n);
+      copied += n;
+    }
+    msg.msg_flags = copied < payload_size ? MSG_TRUNC : 0;
+    msgs[received].msg_len = static_cast<unsigned>(copied);
+    if (msg.msg_name != nullptr) {
+      if (addrs.family == AF_INET && msg.msg_namelen >= sizeof(sockaddr_in)) {
+        ::sockaddr_in peer{};
+        peer.sin_family = AF_INET;
+        peer.sin_port = htons(addrs.source_port);
+        std::memcpy(&peer.sin_addr, addrs.source_ip, 4);
+        std::memcpy(msg.msg_name, &peer, sizeof(peer));
+        msg.msg_namelen = sizeof(peer);
+      } else if (addrs.family == AF_INET6 &&
+                 msg.msg_namelen >= sizeof(sockaddr_in6)) {
+        ::sockaddr_in6 peer{};
+        peer.sin6_family = AF_INET6;
+        peer.sin6_port = htons(addrs.source_port);
+        std::memcpy(&peer.sin6_addr, addrs.source_ip, 16);
+        std::memcpy(msg.msg_name, &peer, sizeof(peer));
+        msg.msg_namelen = sizeof(peer);
+      } else {
+        msg.msg_namelen = 0;
+      }
+    }
+    ++received;
+  };
+  // Frames which aren't valid UDP datagrams are dropped, so try again.
+  while (received < count && xsk_.readable()) {
+    xsk_.receive(count - received, deliver);
+  }
+  return received;
+}
+
+inline std::size_t xdp_context::send(::mmsghdr* msgs, std::size_t count,
+                                     std::error_code& ec) noexcept {
+  std::size_t sent = 0;
+  ec.clear();
+  xsk_.transmit(count, [&](std::uint8_t* frame,
+                           std::size_t capacity) noexcept -> std::size_t {
+    ::msghdr& msg = msgs[sent].msg_hdr;
+    const xdp::udp_frame_addresses* addrs = nullptr;
+    const auto* name = static_cast<const ::sockaddr*>(msg.msg_name);
+    if (name != nullptr && name->sa_family == AF_INET) {
+      const auto* peer = static_cast<const ::sockaddr_in*>(msg.msg_name);
+      addrs = peers_.find(
+          AF_INET, reinterpret_cast<const std::uint8_t*>(&peer->sin_addr),
+          ntohs(peer->sin_port));
+    } else if (name != nullptr && name->sa_family == AF_INET6) {
+      const auto* peer = static_cast<const ::sockaddr_in6*>(msg.msg_name);
+      const auto* ip = reinterpret_cast<const std::uint8_t*>(&peer->sin6_addr);
+      if (IN6_IS_ADDR_V4MAPPED(&peer->sin6_addr)) {
+        addrs = peers_.find(AF_INET, ip + 12, ntohs(peer->sin6_port));
+      } else {
+        addrs = peers_.find(AF_INET6, ip, ntohs(peer->sin6_port));
+      }
+    }
+    if (addrs == nullptr) {
+      ec = std::make_error_code(std::errc::host_unreachable);
+      return 0;
+    }
+    const std::size_t header = xdp::udp_frame_header_size(addrs->family);
+    std::size_t size = 0;
+    for (std::size_t i = 0; i < msg.msg_iovlen; ++i) {
+      size += msg.msg_iov[i].iov_len;
+    }
+    if (size > capacity - header || size > 0xffff - 8) {
+      ec = std::make_error_code(std::errc::message_size);
+      return 0;
+    }
+    std::size_t offset = header;
+    for (std::size_t i = 0; i < msg.msg_iovlen; ++i) {
+      std::memcpy(frame + offset, msg.msg_iov[i].iov_base,
+                  msg.msg_iov[i].iov_len);
+      offset += msg.msg_iov[i].iov_len;
+    }
+    msgs[sent].msg_len = static_cast<unsigned>(size);
+    ++sent;
+    return xdp::write_udp_frame_headers(frame, *addrs, size);
+  });
+  if (sent != 0) {
+    // Like sendmmsg, the error of a later datagram is only reported when
+    // none has been sent.
+    ec.clear();
+  }
+  return sent;
+}
+
+inline void xdp_context::wake_up(wait_list& waiting) noexcept {
+  wait_list ready{std::move(waiting)};
+  while (!ready.empty()) {
+    wait_op* op = ready.pop_front();
+    op->execute_(op);
+  }
+}
+
+inline bool xdp_context::process_rings() noexcept {
+  bool progress = false;
+  if (!senders_.empty() && xsk_.reclaim() != 0) {
+    wake_up(senders_);
+    progress = true;
+  }
+  if (!receivers_.empty() && xsk_.readable()) {
+    wake_up(receivers_);
+    progress = true;
+  }
+  return progress;
+}
+
+inline void xdp_context::wait() {
+  ::pollfd fds[2] = {
+      {.fd = interrupter_.read_descriptor(), .events = POLLIN, .revents = 0},
+      // Polling the socket also wakes up the kernel to fill the RX ring.
+      {.fd = receivers_.empty() ? -1 : xsk_.native_handle(),
+       .events = POLLIN,
+       .revents = 0}};
+  // Sent frames are reclaimed without any event, so senders spin.
+  int timeout = busy_poll_ || !senders_.empty() ? 0 : -1;
+  if (!senders_.empty()) {
+    xsk_.wake_transmit();
+  }
+  if (busy_poll_ && !receivers_.empty()) {
+    xsk_.wake_receive();
+  }
+  int result = ::poll(fds, 2, timeout);
+  if (result < 0) {
+    if (errno == EINTR) {
+      return;
+    }
+    throw std::system_error{static_cast<int>(errno), std::system_category(),
+                            "poll"};
+  }
+  if ((fds[0].revents & POLLIN) != 0) {
+    interrupter_.reset();
+    processed_remote_queue_submitted_ = false;
+  }
+}
+
+inline std::size_t xdp_context::execute_local() noexcept {
+  if (local_queue_.empty()) {
+    return 0;
+  }
+  std::size_t count = 0;
+  auto pending = std::move(local_queue_);
+  while (!pending.empty()) {
+    auto* item = pending.pop_front();
+    assert(item->enqueued_);
+    item->enqueued_ = false;
+    std::exchange(item->next_, nullptr);
+    item->execute_(item);
+    ++count;
+  }
+  return count;
+}
+
+inline void xdp_context::run() {
+  // Only one thread of execution is allowed to drive the io context.
+  bool expected_running = false;
+  if (!is_running_.compare_exchange_strong(expected_running, true,
+                                           std::memory_order_relaxed)) {
+    throw std::runtime_error("xdp_context::run() called on a running context");
+  }
+  exec::scope_guard set_not_running{[&]() noexcept {  //
+    is_running_.store(false, std::memory_order_relaxed);
+  }};
+
+  auto* old_context = std::exchange(current_thread_context, this);
+  exec::scope_guard g{[=]() noexcept {
+    std::exchange(current_thread_context, old_context);
+  }};
+
+  while (true) {
+    execute_local();
+    if (stop_source_->stop_requested()) {
+      break;
+    }
+    if (!processed_remote_queue_submitted_) {
+      processed_remote_queue_submitted_ = try_schedule_remote_to_local();
+    }
+    if (process_rings() || !local_queue_.empty()) {
+      continue;
+    }
+    wait();
+  }
+}
+
+inline void xdp_context::schedule_impl(operation_base* op) noexcept {
+  assert(op != nullptr);
+  if (is_running_on_io_thread()) {
+    schedule_local(op);
+  } else {
+    schedule_remote(op);
+  }
+}
+
+inline void xdp_context::schedule_local(operation_base* op) noexcept {
+  assert(op->execute_ != nullptr);
+  assert(!op->enqueued_);
+  op->enqueued_ = true;
+  local_queue_.push_back(op);
+}
+
+inline void xdp_context::schedule_local(operation_queue ops) noexcept {
+  // Do not adjust the enqueued flag, which is still true because the ops will
+  // immediately be transferred from the remote queue to the local queue.
+  local_queue_.append(std::move(ops));
+}
+
+inline void xdp_context::schedule_remote(operation_base* op) noexcept {
+  assert(!op->enqueued_.load());
+  op->enqueued_ = true;
+  if (remote_queue_.enqueue(op)) {
+    // We were the first to queue an item and the I/O thread is not
+    // going to check the queue until we notify it that new items
+    // have been enqueued remotely by writing to the eventfd.
+    interrupter_.interrupt();
+  }
+}
+
+inline bool xdp_context::try_schedule_remote_to_local() noexcept {
+  (void)remote_queue_.try_mark_active();
+  auto queued_items = remote_queue_.try_mark_inactive_or_dequeue_all();
+  if (!queued_items.empty()) {
+    schedule_local(std::move(queued_items));
+    return false;
+  }
+  return true;
+}
+};  // namespace __xdp
+
+using xdp_context = __xdp::xdp_context;
+}  // namespace net
+
+#endif  // XDP_XDP_CONTEXT_HPP_
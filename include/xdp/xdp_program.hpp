@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef XDP_XDP_PROGRAM_HPP_
+#define XDP_XDP_PROGRAM_HPP_
+
+#include <arpa/inet.h>
+#include <linux/bpf.h>
+#include <linux/if_link.h>
+#include <netinet/in.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <system_error>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "exec/linux/safe_file_descriptor.hpp"
+
+namespace net::xdp {
+
+// An XDP program attached to a network interface, which redirects UDP
+// datagrams to the AF_XDP socket bound to the receive queue they arrive on,
+// and passes every other frame to the kernel stack. Only untagged frames
+// carrying IPv4 without options or IPv6 without extension headers are
+// redirected. The program and the queue to socket map are released, and the
+// program detached, on destruction.
+class xdp_program {
+ public:
+  // Load the program for interface `ifindex` with `queue_count` receive
+  // queues and attach it with the XDP_FLAGS_* `flags`. Only datagrams to
+  // `port` are redirected, or all UDP datagrams if `port` is 0. Throws an
+  // error when the program can't be loaded or attached.
+  xdp_program(int ifindex, std::uint32_t queue_count, std::uint16_t port,
+              std::uint32_t flags = 0)
+      : map_(), program_(), link_() {
+    ::bpf_attr attr{};
+    attr.map_type = BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof(std::uint32_t);
+    attr.value_size = sizeof(std::uint32_t);
+    attr.max_entries = queue_count;
+    map_ = exec::safe_file_descriptor{checked_bpf(BPF_MAP_CREATE, attr)};
+
+    std::vector<::bpf_insn> insns = udp_redirect_instructions(port, map_);
+    attr = ::bpf_attr{};
+    attr.prog_type = BPF_PROG_TYPE_XDP;
+    attr.expected_attach_type = BPF_XDP;
+    attr.insns = reinterpret_cast<std::uintptr_t>(insns.data());
+    attr.insn_cnt = static_cast<std::uint32_t>(insns.size());
+    attr.license = reinterpret_cast<std::uintptr_t>("GPL");
+    program_ = exec::safe_file_descriptor{checked_bpf(BPF_PROG_LOAD, attr)};
+
+    attr = ::bpf_attr{};
+    attr.link_create.prog_fd = static_cast<std::uint32_t>(program_);
+    attr.link_create.target_ifindex = static_cast<std::uint32_t>(ifindex);
+    attr.link_create.attach_type = BPF_XDP;
+    attr.link_create.flags = flags;
+    link_ = exec::safe_file_descriptor{checked_bpf(BPF_LINK_CREATE, attr)};
+  }
+
+  // Redirect the datagrams arriving on `queue` to the AF_XDP socket `xsk`.
+  // Throws an error when the queue is out of range.
+  void insert(std::uint32_t queue, int xsk) {
+    ::bpf_attr attr{};
+    std::uint32_t value = static_cast<std::uint32_t>(xsk);
+    attr.map_fd = static_cast<std::uint32_t>(map_);
+    attr.key = reinterpret_cast<std::uintptr_t>(&queue);
+    attr.value = reinterpret_cast<std::uintptr_t>(&value);
+    attr.flags = BPF_ANY;
+    checked_bpf(BPF_MAP_UPDATE_ELEM, attr);
+  }
+
+  // Pass the datagrams arriving on `queue` to the kernel stack again.
+  void erase(std::uint32_t queue) noexcept {
+    ::bpf_attr attr{};
+    attr.map_fd = static_cast<std::uint32_t>(map_);
+    attr.key = reinterpret_cast<std::uintptr_t>(&queue);
+    (void)bpf(BPF_MAP_DELETE_ELEM, attr);
+  }
+
+  // The instructions of the program which looks up the socket in the map
+  // `map_fd`.
+  static std::vector<::bpf_insn> udp_redirect_instructions(std::uint16_t port,
+                                                           int map_fd) {
+    // Loads from the packet are in network order, so constants are too.
+    enum label { ipv6, check_port, pass, count };
+    std::vector<::bpf_insn> insns;
+    std::vector<std::pair<std::size_t, label>> jumps;
+    std::int16_t labels[count] = {};
+    auto emit = [&](std::uint8_t code, std::uint8_t dst, std::uint8_t src,
+                    std::int16_t off, std::int32_t imm) {
+      insns.push_back(::bpf_insn{.code = code,
+                                 .dst_reg = dst,
+                                 .src_reg = src,
+                                 .off = off,
+                                 .imm = imm});
+    };
+    auto jump = [&](std::uint8_t op, std::uint8_t dst, std::int32_t imm,
+                    label to) {
+      jumps.emplace_back(insns.size(), to);
+      emit(BPF_JMP | op | BPF_K, dst, 0, 0, imm);
+    };
+    auto bind = [&](label l) {
+      labels[l] = static_cast<std::int16_t>(insns.size());
+    };
+    auto load = [&](std::uint8_t size, std::int16_t offset) {
+      emit(BPF_LDX | BPF_MEM | size, BPF_REG_4, BPF_REG_2, offset, 0);
+    };
+    auto bounds = [&](std::int32_t size) {
+      emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0);
+      emit(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, size);
+      jumps.emplace_back(insns.size(), pass);
+      emit(BPF_JMP | BPF_JGT | BPF_X, BPF_REG_4, BPF_REG_3, 0, 0);
+    };
+
+    // r2 = data, r3 = data_end, r6 = ctx.
+    emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_6, BPF_REG_1, 0, 0);
+    emit(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_2, BPF_REG_1,
+         offsetof(::xdp_md, data), 0);
+    emit(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_3, BPF_REG_1,
+         offsetof(::xdp_md, data_end), 0);
+    // Ethernet, IPv4 and UDP headers.
+    bounds(42);
+    load(BPF_H, 12);
+    jump(BPF_JEQ, BPF_REG_4, htons(0x86dd), ipv6);
+    jump(BPF_JNE, BPF_REG_4, htons(0x0800), pass);
+    load(BPF_B, 14);
+    jump(BPF_JNE, BPF_REG_4, 0x45, pass);
+    load(BPF_B, 23);
+    jump(BPF_JNE, BPF_REG_4, IPPROTO_UDP, pass);
+    // Fragments, but the first one, have no UDP header.
+    load(BPF_H, 20);
+    emit(BPF_ALU64 | BPF_AND | BPF_K, BPF_REG_4, 0, 0, htons(0x3fff));
+    jump(BPF_JNE, BPF_REG_4, 0, pass);
+    load(BPF_H, 36);
+    jump(BPF_JA, 0, 0, check_port);
+    // Ethernet, IPv6 and UDP headers.
+    bind(ipv6);
+    bounds(62);
+    load(BPF_B, 20);
+    jump(BPF_JNE, BPF_REG_4, IPPROTO_UDP, pass);
+    load(BPF_H, 56);
+    bind(check_port);
+    if (port != 0) {
+      jump(BPF_JNE, BPF_REG_4, htons(port), pass);
+    }
+    // return bpf_redirect_map(&map, ctx->rx_queue_index, XDP_PASS);
+    emit(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_2, BPF_REG_6,
+         offsetof(::xdp_md, rx_queue_index), 0);
+    emit(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, map_fd);
+    emit(0, 0, 0, 0, 0);
+    emit(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_3, 0, 0, XDP_PASS);
+    emit(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map);
+    emit(BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+    bind(pass);
+    emit(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, XDP_PASS);
+    emit(BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+
+    for (auto [index, to] : jumps) {
+      insns[index].off =
+          static_cast<std::int16_t>(labels[to] - static_cast<int>(index) - 1);
+    }
+    return insns;
+  }
+
+ private:
+  static int bpf(int cmd, ::bpf_attr& attr) noexcept {
+    return static_cast<int>(::syscall(__NR_bpf, cmd, &attr, sizeof(attr)));
+  }
+
+  static int checked_bpf(int cmd, ::bpf_attr& attr) {
+    int result = bpf(cmd, attr);
+    if (result < 0) {
+      throw std::system_error{static_cast<int>(errno), std::system_category(),
+                              "bpf"};
+    }
+    return result;
+  }
+
+  // The map from receive queues to AF_XDP sockets.
+  exec::safe_file_descriptor map_;
+
+  // The loaded program.
+  exec::safe_file_descriptor program_;
+
+  // The attachment to the interface, released first to detach the program.
+  exec::safe_file_descriptor link_;
+};
+
+}  // namespace net::xdp
+
+#endif  // XDP_XDP_PROGRAM_HPP_
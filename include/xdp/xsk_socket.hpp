@@ -0,0 +1,375 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef XDP_XSK_SOCKET_HPP_
+#define XDP_XSK_SOCKET_HPP_
+
+#include <linux/if_xdp.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <system_error>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "exec/linux/safe_file_descriptor.hpp"
+
+namespace net::xdp {
+
+// An AF_XDP socket bound to one receive queue of a network interface, with
+// its own UMEM. The UMEM is split into two halves of `ring_size` frames: the
+// frames of the first half cycle between the fill and the RX ring, the frames
+// of the second half between a free list, the TX and the completion ring.
+// Frames are handed back to the kernel as soon as they have been received, so
+// callers copy what they want to keep. Not thread safe.
+class xsk_socket {
+ public:
+  struct options {
+    // The index of the network interface.
+    int ifindex = 0;
+
+    // The receive queue of the interface.
+    std::uint32_t queue = 0;
+
+    // The count of descriptors of every ring, a power of two.
+    std::uint32_t ring_size = 2048;
+
+    // The size of every frame, a power of two no less than 2048 and no more
+    // than the page size.
+    std::uint32_t frame_size = 2048;
+
+    // Whether the driver must map the UMEM for DMA. Otherwise frames are
+    // copied between the UMEM and the driver's buffers.
+    bool zero_copy = false;
+  };
+
+  // Create the socket and its rings, and bind it. Throws an error on
+  // failure, e.g. when AF_XDP is not supported or `zero_copy` is requested
+  // from a driver which can't do it.
+  explicit xsk_socket(const options& opts)
+      : frame_size_(opts.frame_size),
+        ring_size_(opts.ring_size),
+        umem_(),
+        fd_(),
+        fill_(),
+        completion_(),
+        rx_(),
+        tx_(),
+        free_frames_() {
+    assert(opts.ring_size != 0 &&
+           (opts.ring_size & (opts.ring_size - 1)) == 0);
+    const std::size_t frames = 2 * static_cast<std::size_t>(opts.ring_size);
+    umem_ = mapped_region{-1, frames * frame_size_, 0};
+    int fd = ::socket(AF_XDP, SOCK_RAW | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+      throw_errno("socket");
+    }
+    fd_ = exec::safe_file_descriptor{fd};
+
+    ::xdp_umem_reg reg{};
+    reg.addr = reinterpret_cast<std::uintptr_t>(umem_.at<void>(0));
+    reg.len = frames * frame_size_;
+    reg.chunk_size = frame_size_;
+    set_option(XDP_UMEM_REG, &reg, sizeof(reg));
+    set_option(XDP_UMEM_FILL_RING, &opts.ring_size, sizeof(std::uint32_t));
+    set_option(XDP_UMEM_COMPLETION_RING, &opts.ring_size,
+               sizeof(std::uint32_t));
+    set_option(XDP_RX_RING, &opts.ring_size, sizeof(std::uint32_t));
+    set_option(XDP_TX_RING, &opts.ring_size, sizeof(std::uint32_t));
+
+    ::xdp_mmap_offsets off{};
+    ::socklen_t len = sizeof(off);
+    if (::getsockopt(fd_, SOL_XDP, XDP_MMAP_OFFSETS, &off, &len) != 0) {
+      throw_errno("getsockopt");
+    }
+    fill_.map(fd_, off.fr, opts.ring_size, sizeof(std::uint64_t),
+              XDP_UMEM_PGOFF_FILL_RING);
+    completion_.map(fd_, off.cr, opts.ring_size, sizeof(std::uint64_t),
+                    XDP_UMEM_PGOFF_COMPLETION_RING);
+    rx_.map(fd_, off.rx, opts.ring_size, sizeof(::xdp_desc),
+            XDP_PGOFF_RX_RING);
+    tx_.map(fd_, off.tx, opts.ring_size, sizeof(::xdp_desc),
+            XDP_PGOFF_TX_RING);
+
+    // The kernel needs the fill ring stocked before frames can arrive.
+    for (std::uint32_t i = 0; i < opts.ring_size; ++i) {
+      fill_.at<std::uint64_t>(i) = std::uint64_t{i} * frame_size_;
+    }
+    fill_.produce(opts.ring_size);
+    free_frames_.reserve(opts.ring_size);
+    for (std::uint32_t i = opts.ring_size; i < frames; ++i) {
+      free_frames_.push_back(std::uint64_t{i} * frame_size_);
+    }
+
+    ::sockaddr_xdp addr{};
+    addr.sxdp_family = AF_XDP;
+    addr.sxdp_flags = static_cast<std::uint16_t>(
+        (opts.zero_copy ? XDP_ZEROCOPY : XDP_COPY) | XDP_USE_NEED_WAKEUP);
+    addr.sxdp_ifindex = static_cast<std::uint32_t>(opts.ifindex);
+    addr.sxdp_queue_id = opts.queue;
+    if (::bind(fd_, reinterpret_cast<::sockaddr*>(&addr), sizeof(addr)) != 0) {
+      throw_errno("bind");
+    }
+  }
+
+  // Get the native socket, which is readable when the RX ring is not empty.
+  int native_handle() const noexcept { return fd_; }
+
+  // The size of every frame.
+  std::size_t frame_size() const noexcept { return frame_size_; }
+
+  // Whether the RX ring has frames.
+  bool readable() const noexcept { return rx_.available() != 0; }
+
+  // Call `f(data, size)` for up to `max` received frames, then give the
+  // frames back to the kernel. Returns the count of frames.
+  template <typename F>
+  std::size_t receive(std::size_t max, F&& f) {
+    std::uint32_t count = rx_.available();
+    if (count > max) {
+      count = static_cast<std::uint32_t>(max);
+    }
+    // The fill ring has room for every frame which is on the RX ring.
+    for (std::uint32_t i = 0; i < count; ++i) {
+      const ::xdp_desc& desc = rx_.at<::xdp_desc>(i);
+      f(static_cast<const std::uint8_t*>(umem_.at<void>(desc.addr)),
+        static_cast<std::size_t>(desc.len));
+      fill_.at<std::uint64_t>(i) = desc.addr - (desc.addr % frame_size_);
+    }
+    rx_.consume(count);
+    fill_.produce(count);
+    return count;
+  }
+
+  // Call `f(frame, capacity)` for up to `max` free frames, which returns the
+  // size of the frame it has written, or 0 to stop. The frames are put on
+  // the TX ring and the kernel is woken up if needed. Returns the count of
+  // frames to be sent.
+  template <typename F>
+  std::size_t transmit(std::size_t max, F&& f) {
+    if (free_frames_.size() < max) {
+      reclaim();
+    }
+    std::uint32_t room = tx_.room();
+    std::size_t count = 0;
+    while (count < max && count < room && !free_frames_.empty()) {
+      std::uint64_t frame = free_frames_.back();
+      std::size_t size =
+          f(static_cast<std::uint8_t*>(umem_.at<void>(frame)), frame_size_);
+      if (size == 0) {
+        break;
+      }
+      free_frames_.pop_back();
+      tx_.at<::xdp_desc>(static_cast<std::uint32_t>(count)) = {
+          .addr = frame, .len = static_cast<std::uint32_t>(size), .options = 0};
+      ++count;
+    }
+    if (count != 0) {
+      tx_.produce(static_cast<std::uint32_t>(count));
+      wake_transmit();
+    }
+    return count;
+  }
+
+  // Move the frames which have been sent to the free list. Returns the count
+  // of frames.
+  std::size_t reclaim() noexcept {
+    std::uint32_t count = completion_.available();
+    for (std::uint32_t i = 0; i < count; ++i) {
+      free_frames_.push_back(completion_.at<std::uint64_t>(i));
+    }
+    completion_.consume(count);
+    return count;
+  }
+
+  // Whether frames are still on the TX or the completion ring.
+  bool transmitting() const noexcept {
+    return free_frames_.size() != ring_size_;
+  }
+
+  // Wake up the kernel to go on filling the RX ring, if it asks for it.
+  void wake_receive() noexcept {
+    if (fill_.needs_wakeup()) {
+      (void)::recvfrom(fd_, nullptr, 0, MSG_DONTWAIT, nullptr, nullptr);
+    }
+  }
+
+  // Wake up the kernel to send the frames on the TX ring, if it asks for it.
+  void wake_transmit() noexcept {
+    if (tx_.needs_wakeup()) {
+      (void)::sendto(fd_, nullptr, 0, MSG_DONTWAIT, nullptr, 0);
+    }
+  }
+
+ private:
+  // A memory region shared with the kernel, anonymous if the descriptor is
+  // negative.
+  class mapped_region {
+   public:
+    constexpr mapped_region() noexcept : data_(nullptr), size_(0) {}
+
+    mapped_region(int fd, std::size_t size, off_t offset) : size_(size) {
+      int flags = fd < 0 ? MAP_PRIVATE | MAP_ANONYMOUS : MAP_SHARED;
+      data_ = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                     flags | MAP_POPULATE, fd, offset);
+      if (data_ == MAP_FAILED) {
+        data_ = nullptr;
+        throw_errno("mmap");
+      }
+    }
+
+    mapped_region(mapped_region&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr)),
+          size_(std::exchange(other.size_, 0)) {}
+
+    mapped_region& operator=(mapped_region&& other) noexcept {
+      if (this != &other) {
+        reset();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+      }
+      return *this;
+    }
+
+    ~mapped_region() { reset(); }
+
+    // Get the address at `offset` bytes from the start of this region.
+    template <typename T>
+    T* at(std::size_t offset) const noexcept {
+      return reinterpret_cast<T*>(static_cast<char*>(data_) + offset);
+    }
+
+   private:
+    void reset() noexcept {
+      if (data_ != nullptr) {
+        ::munmap(data_, size_);
+        data_ = nullptr;
+      }
+    }
+
+    void* data_;
+    std::size_t size_;
+  };
+
+  // A single producer single consumer ring shared with the kernel. The
+  // cached index is the one owned by this side: the consumer index of the
+  // RX and completion rings, the producer index of the fill and TX rings.
+  class ring {
+   public:
+    constexpr ring() noexcept
+        : region_(),
+          producer_(nullptr),
+          consumer_(nullptr),
+          flags_(nullptr),
+          descriptors_(nullptr),
+          descriptor_size_(0),
+          size_(0),
+          owned_(0) {}
+
+    void map(int fd, const ::xdp_ring_offset& off, std::uint32_t size,
+             std::size_t descriptor_size, off_t page_offset) {
+      region_ = mapped_region{fd, off.desc + size * descriptor_size,
+                              page_offset};
+      producer_ = region_.at<std::uint32_t>(off.producer);
+      consumer_ = region_.at<std::uint32_t>(off.consumer);
+      flags_ = region_.at<std::uint32_t>(off.flags);
+      descriptors_ = region_.at<char>(off.desc);
+      descriptor_size_ = descriptor_size;
+      size_ = size;
+      owned_ = 0;
+    }
+
+    // The count of entries a consumer can read.
+    std::uint32_t available() const noexcept {
+      return std::atomic_ref<std::uint32_t>(*producer_).load(
+                 std::memory_order_acquire) -
+             owned_;
+    }
+
+    // The count of entries a producer can write.
+    std::uint32_t room() const noexcept {
+      return size_ - (owned_ - std::atomic_ref<std::uint32_t>(*consumer_).load(
+                                   std::memory_order_acquire));
+    }
+
+    // The entry `i` places past the owned index.
+    template <typename T>
+    T& at(std::uint32_t i) const noexcept {
+      return *reinterpret_cast<T*>(descriptors_ +
+                                   ((owned_ + i) & (size_ - 1)) *
+                                       descriptor_size_);
+    }
+
+    void consume(std::uint32_t count) noexcept {
+      owned_ += count;
+      std::atomic_ref<std::uint32_t>(*consumer_).store(
+          owned_, std::memory_order_release);
+    }
+
+    void produce(std::uint32_t count) noexcept {
+      owned_ += count;
+      std::atomic_ref<std::uint32_t>(*producer_).store(
+          owned_, std::memory_order_release);
+    }
+
+    bool needs_wakeup() const noexcept {
+      return (std::atomic_ref<std::uint32_t>(*flags_).load(
+                  std::memory_order_relaxed) &
+              XDP_RING_NEED_WAKEUP) != 0;
+    }
+
+   private:
+    mapped_region region_;
+    std::uint32_t* producer_;
+    std::uint32_t* consumer_;
+    std::uint32_t* flags_;
+    char* descriptors_;
+    std::size_t descriptor_size_;
+    std::uint32_t size_;
+    std::uint32_t owned_;
+  };
+
+  void set_option(int name, const void* value, ::socklen_t size) {
+    if (::setsockopt(fd_, SOL_XDP, name, value, size) != 0) {
+      throw_errno("setsockopt");
+    }
+  }
+
+  [[noreturn]] static void throw_errno(const char* what) {
+    throw std::system_error{static_cast<int>(errno), std::system_category(),
+                            what};
+  }
+
+  std::size_t frame_size_;
+  std::uint32_t ring_size_;
+  mapped_region umem_;
+  exec::safe_file_descriptor fd_;
+  ring fill_;
+  ring completion_;
+  ring rx_;
+  ring tx_;
+
+  // The offsets of the frames of the second half which can be sent.
+  std::vector<std::uint64_t> free_frames_;
+};
+
+}  // namespace net::xdp
+
+#endif  // XDP_XSK_SOCKET_HPP_
@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TESTS_IO_THREAD_HPP_
+#define TESTS_IO_THREAD_HPP_
+
+#include <tuple>
+#include <type_traits>
+
+#include "stdexec.hpp"
+
+#include "epoll/epoll_context.hpp"
+
+// Run `fn` on the io thread of `ctx` and return its result.
+template <typename Fn>
+auto on_io_thread(net::epoll_context& ctx, Fn fn) {
+  auto result = stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler()) |
+                                   stdexec::then(static_cast<Fn&&>(fn)));
+  if constexpr (!std::is_void_v<std::invoke_result_t<Fn>>) {
+    return std::get<0>(result.value());
+  }
+}
+
+#endif  // TESTS_IO_THREAD_HPP_
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TESTS_TCP_CONNECTION_HPP_
+#define TESTS_TCP_CONNECTION_HPP_
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+
+#include "epoll/epoll_context.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/tcp.hpp"
+
+// A connected pair of sockets, the server side is non-blocking.
+struct connection {
+  // Connect through a temporary acceptor listening on `port`.
+  connection(net::epoll_context& ctx, port_type port)
+      : client(ctx), server(ctx) {
+    system_error2::system_code ec{};
+    net::ip::tcp::acceptor acceptor{ctx, {net::ip::address_v4::any(), port},
+                                    ec};
+    REQUIRE(ec.success());
+    connect(acceptor, port);
+  }
+
+  // Connect through `acceptor`, which listens on `port`.
+  connection(net::epoll_context& ctx, net::ip::tcp::acceptor& acceptor,
+             port_type port)
+      : client(ctx), server(ctx) {
+    connect(acceptor, port);
+  }
+
+  net::ip::tcp::socket client;
+  net::ip::tcp::socket server;
+
+ private:
+  void connect(net::ip::tcp::acceptor& acceptor, port_type port) {
+    REQUIRE(client.open(net::ip::tcp::v4()).success());
+    REQUIRE(client.connect({net::ip::address_v4::loopback(), port}).success());
+    auto accepted = acceptor.accept();
+    REQUIRE(accepted.has_value());
+    server = std::move(accepted.value());
+    REQUIRE(server.set_non_blocking(true).success());
+  }
+};
+
+// Receive exactly `size` bytes on a blocking socket.
+inline std::string recv_all(net::ip::tcp::socket& socket, std::size_t size) {
+  std::string data(size, '\0');
+  std::size_t received = 0;
+  while (received < size) {
+    auto res = socket.sync_recv(data.data() + received, size - received, 0);
+    REQUIRE(res.has_value());
+    REQUIRE(res.value() != 0);
+    received += res.value();
+  }
+  return data;
+}
+
+#endif  // TESTS_TCP_CONNECTION_HPP_
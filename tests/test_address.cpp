@@ -21,12 +21,15 @@
 #include <vector>
 
 #include "catch2/catch_test_macros.hpp"
+#include "fmt/format.h"
 
 #include "ip/address.hpp"
+#include "ip/address_format.hpp"
 #include "ip/address_v4.hpp"
 
 using net::ip::address;
 using net::ip::address_v6;
+using net::ip::make_address;
 using net::ip::make_address_v4;
 using net::ip::make_address_v6;
 
@@ -108,3 +111,31 @@ TEST_CASE("hash address should work", "address.hash") {
   addresses[address(make_address_v6(multicast))] = true;
   CHECK(addresses[address(make_address_v6(multicast))] == true);
 }
+
+TEST_CASE("[make_address should pick the version by the text]",
+          "[address.make_address]") {
+  CHECK(make_address("127.0.0.1").is_v4());
+  CHECK(make_address("127.0.0.1") == address(make_address_v4("127.0.0.1")));
+  CHECK(make_address(std::string{"::1"}).is_v6());
+  CHECK(make_address(std::string_view{"::ffff:1.2.3.4"}) ==
+        address(make_address_v6("::ffff:1.2.3.4")));
+  CHECK(make_address("1.2.3").is_unspecified());
+}
+
+TEST_CASE("[to_chars and from_chars should work for both versions]",
+          "[address.to_chars]") {
+  for (const char* text : {"10.0.0.1", "fe80::1", "::ffff:10.0.0.1"}) {
+    const std::string input{text};
+    address addr;
+    auto [ptr, ec] =
+        from_chars(input.data(), input.data() + input.size(), addr);
+    CHECK(ec == std::errc{});
+    CHECK(ptr == input.data() + input.size());
+
+    char out[address::max_chars];
+    auto result = addr.to_chars(out, out + sizeof(out));
+    CHECK(result.ec == std::errc{});
+    CHECK(std::string(out, result.ptr) == input);
+    CHECK(fmt::format("{}", addr) == input);
+  }
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "ip/address_classifier.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/address_v6.hpp"
+#include "ip/network_v4.hpp"
+#include "ip/network_v6.hpp"
+
+using net::ip::address_classifier;
+using net::ip::address_v4;
+using net::ip::address_v6;
+using net::ip::make_address_v4;
+using net::ip::make_address_v6;
+using net::ip::make_network_v4;
+using net::ip::make_network_v6;
+
+TEST_CASE("[classify should flag the special purpose IPv4 ranges]",
+          "[address_classifier.v4]") {
+  address_classifier classifier;
+  auto classify = [&](const char* text) {
+    return classifier.classify(make_address_v4(text));
+  };
+  CHECK(classify("127.0.0.1") == address_classifier::loopback);
+  CHECK(classify("10.1.2.3") == address_classifier::private_network);
+  CHECK(classify("172.16.0.1") == address_classifier::private_network);
+  CHECK(classify("172.31.255.255") == address_classifier::private_network);
+  CHECK(classify("172.32.0.1") == 0);
+  CHECK(classify("192.168.1.1") == address_classifier::private_network);
+  CHECK(classify("224.0.0.1") == address_classifier::multicast);
+  CHECK(classify("239.255.255.255") == address_classifier::multicast);
+  CHECK(classify("0.0.0.0") == address_classifier::unspecified);
+  CHECK(classify("169.254.1.1") == address_classifier::link_local);
+  CHECK(classify("8.8.8.8") == 0);
+}
+
+TEST_CASE("[classify should flag the special purpose IPv6 ranges]",
+          "[address_classifier.v6]") {
+  address_classifier classifier;
+  auto classify = [&](const char* text) {
+    return classifier.classify(make_address_v6(text));
+  };
+  CHECK(classify("::1") == address_classifier::loopback);
+  CHECK(classify("fd00::1") == address_classifier::private_network);
+  CHECK(classify("fc00::1") == address_classifier::private_network);
+  CHECK(classify("ff02::1") == address_classifier::multicast);
+  CHECK(classify("::") == address_classifier::unspecified);
+  CHECK(classify("fe80::1") == address_classifier::link_local);
+  CHECK(classify("febf::1") == address_classifier::link_local);
+  CHECK(classify("fec0::1") == 0);
+  CHECK(classify("2001:db8::1") == 0);
+
+  // IPv4-mapped addresses are classified as IPv4.
+  CHECK(classify("::ffff:127.0.0.1") == address_classifier::loopback);
+  CHECK(classify("::ffff:10.0.0.1") == address_classifier::private_network);
+  CHECK(classify("::ffff:0.0.0.0") == address_classifier::unspecified);
+}
+
+TEST_CASE("[listed networks should be flagged]", "[address_classifier]") {
+  address_classifier classifier;
+  REQUIRE(classifier.insert(
+      make_network_v4(make_address_v4("203.0.113.0"), 24)));
+  REQUIRE(classifier.insert(
+      make_network_v4(make_address_v4("10.0.0.0"), 16)));
+  REQUIRE(classifier.insert(
+      make_network_v6(make_address_v6("2001:db8::"), 32)));
+
+  CHECK(classifier.classify(make_address_v4("203.0.113.7")) ==
+        address_classifier::listed);
+  CHECK(classifier.classify(make_address_v4("203.0.114.7")) == 0);
+  CHECK(classifier.classify(make_address_v4("10.0.1.1")) ==
+        (address_classifier::listed | address_classifier::private_network));
+  CHECK(classifier.classify(make_address_v6("2001:db8:1::1")) ==
+        address_classifier::listed);
+  CHECK(classifier.classify(make_address_v6("2001:db9::1")) == 0);
+  CHECK(classifier.classify(make_address_v6("::ffff:203.0.113.1")) ==
+        address_classifier::listed);
+
+  auto test_net = make_network_v4(make_address_v4("198.51.100.0"), 24);
+  for (std::size_t i = 2; i < address_classifier::max_networks; ++i) {
+    CHECK(classifier.insert(test_net));
+  }
+  CHECK_FALSE(classifier.insert(test_net));
+}
+
+TEST_CASE("[classify of a batch should match classify of each address]",
+          "[address_classifier.batch]") {
+  address_classifier classifier;
+  REQUIRE(classifier.insert(
+      make_network_v4(make_address_v4("100.64.0.0"), 10)));
+  REQUIRE(classifier.insert(
+      make_network_v6(make_address_v6("2001:db8::"), 32)));
+
+  // Random addresses, most of them forced into a special range.
+  std::mt19937 engine{7};
+  const unsigned char v4_heads[] = {127, 10, 172, 192, 224, 0, 169, 100, 8};
+  const unsigned char v6_heads[] = {0x00, 0xfc, 0xfd, 0xff, 0xfe, 0x20};
+  for (std::size_t count : {0, 1, 3, 4, 7, 8, 9, 64, 67}) {
+    std::vector<address_v4> v4(count);
+    std::vector<address_v6> v6(count);
+    for (std::size_t i = 0; i < count; ++i) {
+      address_v4::bytes_type b4;
+      for (auto& byte : b4) {
+        byte = static_cast<unsigned char>(engine());
+      }
+      b4[0] = v4_heads[engine() % sizeof(v4_heads)];
+      if (b4[0] == 0 || engine() % 8 == 0) {
+        b4 = address_v4::bytes_type{b4[0], 0, 0, 0};
+      }
+      v4[i] = address_v4{b4};
+
+      address_v6::bytes_type b6;
+      for (auto& byte : b6) {
+        byte = engine() % 2 == 0 ? 0 : static_cast<unsigned char>(engine());
+      }
+      b6[0] = v6_heads[engine() % sizeof(v6_heads)];
+      if (engine() % 4 == 0) {
+        // IPv4-mapped.
+        b6 = address_v6::bytes_type{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff,
+                                    0xff, b4[0], b4[1], b4[2], b4[3]};
+      }
+      v6[i] = address_v6{b6};
+    }
+
+    std::vector<std::uint8_t> classes(count + 1, 0xee);
+    classifier.classify(v4.data(), count, classes.data());
+    for (std::size_t i = 0; i < count; ++i) {
+      CHECK(classes[i] == classifier.classify(v4[i]));
+      CHECK(((classes[i] & address_classifier::loopback) != 0) ==
+            v4[i].is_loopback());
+      CHECK(((classes[i] & address_classifier::multicast) != 0) ==
+            v4[i].is_multicast());
+    }
+    CHECK(classes[count] == 0xee);
+
+    classifier.classify(v6.data(), count, classes.data());
+    for (std::size_t i = 0; i < count; ++i) {
+      if (!v6[i].is_v4_mapped()) {
+        CHECK(((classes[i] & address_classifier::loopback) != 0) ==
+              v6[i].is_loopback());
+        CHECK(((classes[i] & address_classifier::multicast) != 0) ==
+              v6[i].is_multicast());
+        CHECK(((classes[i] & address_classifier::link_local) != 0) ==
+              v6[i].is_link_local());
+      }
+    }
+    CHECK(classes[count] == 0xee);
+  }
+}
@@ -13,15 +13,22 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <arpa/inet.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
 
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <memory>
+#include <random>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "catch2/catch_test_macros.hpp"
 
+#include "ip/address_format.hpp"
 #include "ip/address_v4.hpp"
 
 using net::ip::address_v4;
@@ -196,3 +203,94 @@ TEST_CASE("hash address_v4", "address_v4.hash") {
   CHECK(addresses[make_address_v4("120.121.122.123")] == true);
   CHECK(addresses[make_address_v4("1.1.1.1")] == true);
 }
+
+TEST_CASE("[to_chars should match inet_ntop]", "[address_v4.to_chars]") {
+  std::mt19937 gen{41};
+  for (int i = 0; i < 10000; ++i) {
+    address_v4::bytes_type bytes;
+    for (auto& byte : bytes) {
+      byte = static_cast<unsigned char>(i < 256 ? i : gen());
+    }
+    char expected[INET_ADDRSTRLEN];
+    REQUIRE(::inet_ntop(AF_INET, bytes.data(), expected, sizeof(expected)));
+
+    char text[address_v4::max_chars];
+    auto [ptr, ec] = address_v4(bytes).to_chars(text, text + sizeof(text));
+    REQUIRE(ec == std::errc{});
+    CHECK(std::string(text, ptr) == expected);
+  }
+}
+
+TEST_CASE("[to_chars should fail if the buffer is too small]",
+          "[address_v4.to_chars]") {
+  char text[address_v4::max_chars];
+  address_v4 addr = make_address_v4("255.255.255.255");
+  CHECK(addr.to_chars(text, text + 14).ec == std::errc::value_too_large);
+  auto [ptr, ec] = addr.to_chars(text, text + 15);
+  CHECK(ec == std::errc{});
+  CHECK(std::string(text, ptr) == "255.255.255.255");
+}
+
+TEST_CASE("[from_chars should accept what inet_pton accepts]",
+          "[address_v4.from_chars]") {
+  const std::vector<std::string> inputs{
+      "0.0.0.0",   "255.255.255.255", "1.2.3.4",    "01.2.3.4",
+      "1.2.3.04",  "256.1.1.1",       "1.2.3",      "1.2.3.4.",
+      ".1.2.3.4",  "1..2.3",          "1.2.3.4.5",  "1.2.3.1000",
+      "",          "a.b.c.d",         "1.2.3.-4",   "00.0.0.0",
+      "10.0.0.255"};
+  for (const auto& input : inputs) {
+    unsigned char expected[4];
+    bool valid = ::inet_pton(AF_INET, input.c_str(), expected) > 0;
+
+    address_v4 addr;
+    auto [ptr, ec] =
+        from_chars(input.data(), input.data() + input.size(), addr);
+    bool parsed = ec == std::errc{} && ptr == input.data() + input.size();
+    CHECK(parsed == valid);
+    if (valid) {
+      CHECK(std::memcmp(addr.to_bytes().data(), expected, 4) == 0);
+    }
+  }
+
+  std::mt19937 gen{41};
+  const char alphabet[] = "0123456789..";
+  for (int i = 0; i < 10000; ++i) {
+    std::string input;
+    for (std::size_t n = gen() % 16; n != 0; --n) {
+      input += alphabet[gen() % (sizeof(alphabet) - 1)];
+    }
+    unsigned char expected[4];
+    bool valid = ::inet_pton(AF_INET, input.c_str(), expected) > 0;
+    CHECK(make_address_v4(input) ==
+          (valid ? address_v4(address_v4::bytes_type{
+                       expected[0], expected[1], expected[2], expected[3]})
+                 : address_v4{}));
+  }
+}
+
+TEST_CASE("[from_chars should stop at the end of the address]",
+          "[address_v4.from_chars]") {
+  const std::string input = "10.1.2.3:8080";
+  address_v4 addr;
+  auto [ptr, ec] = from_chars(input.data(), input.data() + input.size(), addr);
+  CHECK(ec == std::errc{});
+  CHECK(ptr == input.data() + 8);
+  CHECK(addr.to_string() == "10.1.2.3");
+  CHECK(make_address_v4(input).is_unspecified());
+}
+
+TEST_CASE("[address_v4 should be formattable]", "[address_v4.format]") {
+  CHECK(fmt::format("{}", make_address_v4("192.168.1.20")) == "192.168.1.20");
+}
+
+TEST_CASE("[hash should spread the hosts of one network]",
+          "[address_v4.hash]") {
+  std::vector<int> buckets(1024);
+  for (uint32_t host = 0; host < 1024 * 64; ++host) {
+    address_v4 addr = make_address_v4((10u << 24) | (host << 8));
+    ++buckets[std::hash<address_v4>()(addr) % buckets.size()];
+  }
+  CHECK(*std::max_element(buckets.begin(), buckets.end()) < 64 * 2);
+  CHECK(*std::min_element(buckets.begin(), buckets.end()) > 64 / 2);
+}
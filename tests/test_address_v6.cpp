@@ -13,17 +13,24 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <arpa/inet.h>
 #include <net/if.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
 
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <memory>
+#include <random>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "catch2/catch_test_macros.hpp"
 #include "fmt/format.h"
 
+#include "ip/address_format.hpp"
 #include "ip/address_v6.hpp"
 
 using net::ip::address_v4;
@@ -294,3 +301,160 @@ TEST_CASE("hash address_v6 should work", "address_v6.hash") {
   CHECK(addresses[make_address_v6(multicast)] == true);
   CHECK(addresses[make_address_v6(multicast_global)] == true);
 }
+
+TEST_CASE("[to_chars should match inet_ntop]", "[address_v6.to_chars]") {
+  const std::vector<address_v6::bytes_type> specials{
+      unspecified, loopback,  link_local, site_local, v4_mapped, multicast,
+      address_v6::bytes_type{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4},
+      address_v6::bytes_type{0, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0},
+      address_v6::bytes_type{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0},
+      address_v6::bytes_type{0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0xff, 0xff, 1, 2, 3,
+                             4}};
+  auto check = [](const address_v6::bytes_type& bytes) {
+    char expected[INET6_ADDRSTRLEN];
+    REQUIRE(::inet_ntop(AF_INET6, bytes.data(), expected, sizeof(expected)));
+
+    char text[address_v6::max_chars];
+    auto [ptr, ec] = address_v6(bytes).to_chars(text, text + sizeof(text));
+    REQUIRE(ec == std::errc{});
+    CHECK(std::string(text, ptr) == expected);
+  };
+  for (const auto& bytes : specials) {
+    check(bytes);
+  }
+
+  // Mostly zero words, to exercise the choice of the run compressed.
+  std::mt19937 gen{41};
+  for (int i = 0; i < 100000; ++i) {
+    address_v6::bytes_type bytes;
+    for (std::size_t j = 0; j < bytes.size(); j += 2) {
+      if (gen() % 3 != 0) {
+        continue;
+      }
+      const unsigned word = gen() % 4 == 0 ? 0xffff : gen();
+      bytes[j] = static_cast<unsigned char>(gen() % 2 ? word >> 8 : 0);
+      bytes[j + 1] = static_cast<unsigned char>(word);
+    }
+    check(bytes);
+  }
+}
+
+TEST_CASE("[to_chars should fail if the buffer is too small]",
+          "[address_v6.to_chars]") {
+  char text[address_v6::max_chars];
+  address_v6 addr = make_address_v6("fe80::1112:1314");
+  CHECK(addr.to_chars(text, text + 14).ec == std::errc::value_too_large);
+  auto [ptr, ec] = addr.to_chars(text, text + 15);
+  CHECK(ec == std::errc{});
+  CHECK(std::string(text, ptr) == "fe80::1112:1314");
+}
+
+TEST_CASE("[from_chars should accept what inet_pton accepts]",
+          "[address_v6.from_chars]") {
+  const std::vector<std::string> inputs{
+      "::",
+      "::1",
+      "1::",
+      "1:2:3:4:5:6:7:8",
+      "1:2:3:4:5:6:7::",
+      "::2:3:4:5:6:7:8",
+      "1:2:3:4:5:6:7:8:9",
+      "1::2::3",
+      ":1::2",
+      "1::2:",
+      ":::",
+      "1:::2",
+      "12345::",
+      "FFFF:abcd::0",
+      "::ffff:1.2.3.4",
+      "::1.2.3.4",
+      "1:2:3:4:5:6:1.2.3.4",
+      "1:2:3:4:5:6:7:1.2.3.4",
+      "::1.2.3",
+      "::1.2.3.4:5",
+      "::01.2.3.4",
+      "1.2.3.4::",
+      "g::",
+      "",
+      ":",
+  };
+  auto check = [](const std::string& input) {
+    unsigned char expected[16];
+    bool valid = ::inet_pton(AF_INET6, input.c_str(), expected) > 0;
+
+    address_v6 addr;
+    auto [ptr, ec] =
+        from_chars(input.data(), input.data() + input.size(), addr);
+    bool parsed = ec == std::errc{} && ptr == input.data() + input.size();
+    CHECK(parsed == valid);
+    if (valid && parsed) {
+      CHECK(std::memcmp(addr.to_bytes().data(), expected, 16) == 0);
+    }
+  };
+  for (const auto& input : inputs) {
+    INFO(input);
+    check(input);
+  }
+
+  std::mt19937 gen{41};
+  const char alphabet[] = "0123456789abcdefABCDEF::::...";
+  for (int i = 0; i < 100000; ++i) {
+    std::string input;
+    for (std::size_t n = gen() % 24; n != 0; --n) {
+      input += alphabet[gen() % (sizeof(alphabet) - 1)];
+    }
+    INFO(input);
+    check(input);
+  }
+}
+
+TEST_CASE("[to_chars and from_chars should round trip]",
+          "[address_v6.from_chars]") {
+  std::mt19937 gen{41};
+  for (int i = 0; i < 10000; ++i) {
+    address_v6::bytes_type bytes;
+    for (auto& byte : bytes) {
+      byte = gen() % 2 ? static_cast<unsigned char>(gen()) : 0;
+    }
+    char text[address_v6::max_chars];
+    auto end = address_v6(bytes).to_chars(text, text + sizeof(text)).ptr;
+    address_v6 addr;
+    auto [ptr, ec] = from_chars(text, end, addr);
+    CHECK(ec == std::errc{});
+    CHECK(ptr == end);
+    CHECK(addr.to_bytes() == bytes);
+  }
+}
+
+TEST_CASE("[make_address_v6 should parse a numeric scope id]",
+          "[address_v6.make_address_v6]") {
+  CHECK(make_address_v6("fe80::1%42").scope_id() == 42);
+  CHECK(make_address_v6(std::string_view{"fe80::1%42"}).to_string() ==
+        "fe80::1");
+  CHECK(make_address_v6("fe80::1 ").is_unspecified());
+}
+
+TEST_CASE("[address_v6 should be formattable]", "[address_v6.format]") {
+  CHECK(fmt::format("{}", make_address_v6("::ffff:127.0.0.1")) ==
+        "::ffff:127.0.0.1");
+  CHECK(fmt::format("[{}]:80", make_address_v6("fe80::1%1")) ==
+        "[fe80::1]:80");
+}
+
+TEST_CASE("[hash should spread the hosts of one /64]", "[address_v6.hash]") {
+  // Hosts of the same /64 differ only in their last bytes, and should still
+  // spread over the buckets of a power-of-two table.
+  std::vector<int> buckets(1024);
+  address_v6::bytes_type bytes{0x20, 0x01, 0x0d, 0xb8};
+  for (int host = 0; host < 1024 * 64; ++host) {
+    bytes[14] = static_cast<unsigned char>(host >> 8);
+    bytes[15] = static_cast<unsigned char>(host);
+    ++buckets[std::hash<address_v6>()(address_v6(bytes)) % buckets.size()];
+  }
+  CHECK(*std::max_element(buckets.begin(), buckets.end()) < 64 * 2);
+  CHECK(*std::min_element(buckets.begin(), buckets.end()) > 64 / 2);
+
+  // The scope ID is part of the address.
+  CHECK(std::hash<address_v6>()(address_v6(bytes, 1)) !=
+        std::hash<address_v6>()(address_v6(bytes, 2)));
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstddef>
+#include <cstdlib>
+#include <iterator>
+#include <new>
+#include <thread>  // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "buffer.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_accept_op.hpp"
+#include "epoll/socket_io_base_op.hpp"
+#include "epoll/socket_recv_some_op.hpp"
+#include "epoll/socket_send_some_op.hpp"
+#include "ip/tcp.hpp"
+#include "stdexec.hpp"
+#include "stdexec/execution.hpp"
+
+// Counts the allocations of every thread while `counting` is set. The hot
+// path of the context must not allocate once sockets are registered and the
+// operation pools are warm.
+namespace {
+std::atomic<bool> counting{false};
+std::atomic<std::size_t> allocations{0};
+
+void* counted_allocate(std::size_t size) {
+  if (counting.load(std::memory_order_relaxed)) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (void* p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+// The count of allocations made while running `fn`.
+template <typename Fn>
+std::size_t count_allocations(Fn&& fn) {
+  allocations.store(0, std::memory_order_relaxed);
+  counting.store(true, std::memory_order_relaxed);
+  fn();
+  counting.store(false, std::memory_order_relaxed);
+  return allocations.load(std::memory_order_relaxed);
+}
+}  // namespace
+
+void* operator new(std::size_t size) { return counted_allocate(size); }
+
+void* operator new[](std::size_t size) { return counted_allocate(size); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete[](void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+using net::epoll_context;
+using namespace std::chrono_literals;  // NOLINT
+
+TEST_CASE("[the echo path should not allocate after warmup]",
+          "[allocations.echo]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  // Connect a client to a server socket over loopback.
+  system_error2::system_code ec{system_error2::errc::success};
+  net::ip::tcp::acceptor acceptor{
+      ctx, {net::ip::address_v4::loopback(), 0}, ec, true};
+  REQUIRE(ec.success());
+  REQUIRE(acceptor.set_non_blocking(true).success());
+  auto local = acceptor.local_endpoint();
+  REQUIRE(local.has_value());
+  net::ip::tcp::socket client{ctx};
+  REQUIRE(client.open(net::ip::tcp::v4()).success());
+  REQUIRE(client.connect(local.value()).success());
+  auto accepted = stdexec::sync_wait(net::async_accept(acceptor));
+  REQUIRE(accepted.has_value());
+  auto& [server] = *accepted;
+  REQUIRE(client.set_non_blocking(true).success());
+
+  char request[64] = {};
+  char echo[64];
+  char reply[64];
+  auto send_request = [&] {
+    stdexec::sync_wait(net::async_send_some(client, net::buffer(request)));
+  };
+  auto recv_request = [&] {
+    stdexec::sync_wait(net::async_recv_some(server, net::buffer(echo)));
+  };
+  auto send_echo = [&] {
+    stdexec::sync_wait(net::async_send_some(server, net::buffer(echo)));
+  };
+  auto recv_echo = [&] {
+    stdexec::sync_wait(net::async_recv_some(client, net::buffer(reply)));
+  };
+  auto schedule = [&] {
+    stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler()));
+  };
+  auto timer = [&] {
+    stdexec::sync_wait(exec::schedule_after(ctx.get_scheduler(), 1us));
+  };
+
+  // Register the descriptors and fill the operation pools.
+  for (int i = 0; i < 16; ++i) {
+    send_request();
+    recv_request();
+    send_echo();
+    recv_echo();
+    schedule();
+    timer();
+  }
+
+  // Check each operation on its own, so one regression shows all the
+  // allocating operations at once.
+  std::size_t per_op[] = {
+      count_allocations(send_request), count_allocations(recv_request),
+      count_allocations(send_echo),    count_allocations(recv_echo),
+      count_allocations(schedule),     count_allocations(timer)};
+  const char* names[] = {"send_some (client)", "recv_some (server)",
+                         "send_some (server)", "recv_some (client)",
+                         "schedule",           "schedule_after"};
+  for (std::size_t i = 0; i < std::size(per_op); ++i) {
+    INFO(names[i] << ": " << per_op[i] << " allocations");
+    CHECK(per_op[i] == 0);
+  }
+
+  std::size_t iteration = count_allocations([&] {
+    for (int i = 0; i < 100; ++i) {
+      send_request();
+      recv_request();
+      send_echo();
+      recv_echo();
+    }
+  });
+  CHECK(iteration == 0);
+}
@@ -17,6 +17,8 @@
 #include <netinet/in.h>
 #include <sys/socket.h>
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -226,3 +228,75 @@ TEST_CASE("hash basic_endpoint", "basic_endpoint.hash") {
   table[ep] = true;
   CHECK(table[ep] == true);
 }
+
+TEST_CASE("hash basic_endpoint should depend on the port",
+          "basic_endpoint.hash") {
+  using hasher = std::hash<basic_endpoint<mock_protocol>>;
+  const basic_endpoint<mock_protocol> ep0{make_address_v4("10.0.0.1"), 80};
+  const basic_endpoint<mock_protocol> ep1{make_address_v4("10.0.0.1"), 80};
+  CHECK(hasher()(ep0) == hasher()(ep1));
+
+  // Ephemeral ports of one peer should spread over the buckets of a
+  // power-of-two table.
+  std::vector<int> buckets(256);
+  for (int port = 32768; port < 32768 + 256 * 64; ++port) {
+    basic_endpoint<mock_protocol> ep{make_address_v6("2001:db8::1"),
+                                     static_cast<port_type>(port)};
+    ++buckets[hasher()(ep) % buckets.size()];
+  }
+  CHECK(*std::max_element(buckets.begin(), buckets.end()) < 64 * 2);
+}
+
+TEST_CASE("[endpoint should be written in place through data()]",
+          "[basic_endpoint.native]") {
+  basic_endpoint<mock_protocol> ep;
+  CHECK(ep.size() == sizeof(::sockaddr_in6));
+  CHECK(basic_endpoint<mock_protocol>::capacity() >= sizeof(::sockaddr_in6));
+
+  // As recvfrom would.
+  ::sockaddr_in native{};
+  native.sin_family = AF_INET;
+  native.sin_port = htons(5353);
+  native.sin_addr.s_addr = htonl(0x0a000001);
+  std::memcpy(ep.data(), &native, sizeof(native));
+  CHECK(ep.is_valid());
+  CHECK(ep.size() == sizeof(::sockaddr_in));
+  CHECK(ep.protocol() == mock_protocol::v4());
+  CHECK(ep.port() == 5353);
+  CHECK(ep.address() == net::ip::address(make_address_v4("10.0.0.1")));
+
+  ep.data()->sa_family = AF_UNIX;
+  CHECK_FALSE(ep.is_valid());
+}
+
+TEST_CASE("[native_address should keep the scope ID]",
+          "[basic_endpoint.native]") {
+  basic_endpoint<mock_protocol> ep{make_address_v6("fe80::1%3"), 443};
+  ::sockaddr_storage storage;
+  CHECK(ep.native_address(&storage) == sizeof(::sockaddr_in6));
+  auto native = *reinterpret_cast<::sockaddr_in6*>(&storage);
+  CHECK(native.sin6_scope_id == 3);
+  CHECK(basic_endpoint<mock_protocol>{native} == ep);
+  CHECK(ep.address().to_v6().scope_id() == 3);
+}
+
+TEST_CASE("[set_address should keep the port]", "[basic_endpoint.native]") {
+  basic_endpoint<mock_protocol> ep{make_address_v6("::1"), 8080};
+  ep.set_address(net::ip::address(make_address_v4("127.0.0.1")));
+  CHECK(ep.protocol() == mock_protocol::v4());
+  CHECK(ep.port() == 8080);
+  ep.set_port(8081);
+  ep.set_address(net::ip::address(make_address_v6("::2")));
+  CHECK(ep.protocol() == mock_protocol::v6());
+  CHECK(ep.port() == 8081);
+}
+
+TEST_CASE("[IPv4 endpoints should order before IPv6 ones]",
+          "basic_endpoint.comparision") {
+  basic_endpoint<mock_protocol> v4{make_address_v4("255.255.255.255"), 1};
+  basic_endpoint<mock_protocol> v6{make_address_v6("::"), 0};
+  CHECK(v4 < v6);
+  CHECK(v4 != v6);
+  CHECK(basic_endpoint<mock_protocol>{make_address_v4("1.0.0.2"), 1} <
+        basic_endpoint<mock_protocol>{make_address_v4("2.0.0.1"), 0});
+}
@@ -108,16 +108,16 @@ TEST_CASE(
   mock_socket socket{};
   CHECK(socket.descriptor_ == -1);
   CHECK(socket.state_ == 0);
-  CHECK(socket.protocol_ == std::nullopt);
-  CHECK(&socket.context_ == &mock_context);
+  CHECK(!socket.has_protocol());
+  CHECK(socket.context_ == &mock_context);
 }
 
 TEST_CASE("[context() should return associated context]",
           "[basic_socket.context]") {
   mock_socket socket{};
   CHECK(&socket.context() == &mock_context);
-  CHECK(&socket.context_ == &mock_context);
-  CHECK(&socket.context_ == &socket.context());
+  CHECK(socket.context_ == &mock_context);
+  CHECK(socket.context_ == &socket.context());
 }
 
 TEST_CASE("[native_handle() should return correct file descriptor]",
@@ -137,25 +137,25 @@ TEST_CASE("[protocol() should return associated protocol]",
           "[basic_socket.protocol]") {
   mock_socket socket{};
   // IPv4/TCP
-  socket.protocol_ = mock_protocol::v4();
+  socket.store_protocol(mock_protocol::v4());
   CHECK(socket.protocol().family() == AF_INET);
   CHECK(socket.protocol().type() == SOCK_STREAM);
   CHECK(socket.protocol().protocol() == IPPROTO_IP);
 
   // IPv6/TCP
-  socket.protocol_ = mock_protocol::v6();
+  socket.store_protocol(mock_protocol::v6());
   CHECK(socket.protocol().family() == AF_INET6);
   CHECK(socket.protocol().type() == SOCK_STREAM);
   CHECK(socket.protocol().protocol() == IPPROTO_IP);
 
   // IPv4/UDP
-  socket.protocol_ = mock_protocol{AF_INET, SOCK_DGRAM, IPPROTO_IP};
+  socket.store_protocol(mock_protocol{AF_INET, SOCK_DGRAM, IPPROTO_IP});
   CHECK(socket.protocol().family() == AF_INET);
   CHECK(socket.protocol().type() == SOCK_DGRAM);
   CHECK(socket.protocol().protocol() == IPPROTO_IP);
 
   // IPv6/UDP
-  socket.protocol_ = mock_protocol{AF_INET6, SOCK_DGRAM, IPPROTO_IP};
+  socket.store_protocol(mock_protocol{AF_INET6, SOCK_DGRAM, IPPROTO_IP});
   CHECK(socket.protocol().family() == AF_INET6);
   CHECK(socket.protocol().type() == SOCK_DGRAM);
   CHECK(socket.protocol().protocol() == IPPROTO_IP);
@@ -167,6 +167,34 @@ TEST_CASE("[state() should return associated state]", "[basic_socket.state]") {
   CHECK(socket.state() == 1);
 }
 
+TEST_CASE("[set_state() should keep the packed socket type]",
+          "[basic_socket.state]") {
+  mock_socket socket{};
+  socket.store_protocol(mock_protocol::v6_udp());
+  socket.set_state(non_blocking | datagram_oriented);
+  CHECK(socket.state() == (non_blocking | datagram_oriented));
+  socket.set_state(0);
+  CHECK(socket.state() == 0);
+  CHECK(socket.protocol() == mock_protocol::v6_udp());
+}
+
+TEST_CASE("[A default constructed socket is a null socket]",
+          "[basic_socket.ctor]") {
+  basic_socket<mock_protocol> socket{};
+  CHECK(socket.is_null());
+  CHECK(!socket.is_open());
+  CHECK(!socket.has_protocol());
+  CHECK(socket.state() == 0);
+
+  mock_socket other{};
+  other.store_protocol(mock_protocol::v4());
+  socket = std::move(other);
+  CHECK(!socket.is_null());
+  CHECK(socket.has_protocol());
+  CHECK(socket.protocol() == mock_protocol::v4());
+  CHECK(&socket.context() == &mock_context);
+}
+
 TEST_CASE("[move constructor should work]", "[basic_socket.ctor]") {
   mock_socket socket{};
   socket.descriptor_.reset(12);
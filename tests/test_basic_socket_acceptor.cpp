@@ -13,6 +13,11 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <linux/filter.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
 #include <optional>
 #include <system_error>  // NOLINT
 
@@ -28,7 +33,7 @@ TEST_CASE("[Default constructor]", "[basic_socket_acceptor.ctor]") {
   net::basic_socket_acceptor<mock_protocol> acceptor{ctx};
   CHECK(!acceptor.is_open());
   CHECK(acceptor.state() == 0);
-  CHECK(acceptor.protocol_ == std::nullopt);
+  CHECK(!acceptor.has_protocol());
 }
 
 TEST_CASE("[Construct acceptor using an endpoint]",
@@ -55,3 +60,79 @@ TEST_CASE("[Construct acceptor using an endpoint and reuse the address]",
   CHECK(option.value() == 1);
   CHECK(acceptor.close().success());
 }
+
+TEST_CASE("[Construct acceptor using an endpoint and reuse the port]",
+          "[basic_socket_acceptor.ctor]") {
+  net::execution_context ctx{};
+  mock_protocol::endpoint endpoint{net::ip::address_v4::any(), 80};
+  system_error2::system_code ec;
+  net::basic_socket_acceptor<mock_protocol> acceptor{ctx, endpoint, ec, true,
+                                                     true};
+  CHECK(ec.success());
+  net::socket_base::reuse_port option{};
+  CHECK(acceptor.get_option(option).success());
+  CHECK(option.value() == 1);
+  CHECK(acceptor.close().success());
+}
+
+TEST_CASE("[Construct acceptor using a native socket]",
+          "[basic_socket_acceptor.ctor]") {
+  net::execution_context ctx{};
+  mock_protocol::endpoint endpoint{net::ip::address_v4::any(), 80};
+  system_error2::system_code ec;
+  net::basic_socket_acceptor<mock_protocol> origin{ctx, endpoint, ec};
+  REQUIRE(ec.success());
+  int fd = ::dup(origin.native_handle());
+  REQUIRE(fd >= 0);
+
+  net::basic_socket_acceptor<mock_protocol> acceptor{ctx, origin.protocol(),
+                                                     fd};
+  CHECK(acceptor.is_open());
+  CHECK(acceptor.native_handle() == fd);
+  CHECK(acceptor.close().success());
+}
+
+TEST_CASE("[set_exclusive_wakeup() should toggle the exclusive state]",
+          "[basic_socket_acceptor.exclusive_wakeup]") {
+  net::execution_context ctx{};
+  net::basic_socket_acceptor<mock_protocol> acceptor{ctx};
+  CHECK_FALSE(acceptor.is_exclusive_wakeup());
+  acceptor.set_exclusive_wakeup(true);
+  CHECK(acceptor.is_exclusive_wakeup());
+  acceptor.set_exclusive_wakeup(false);
+  CHECK_FALSE(acceptor.is_exclusive_wakeup());
+}
+
+TEST_CASE("[attach_reuseport_cbpf() should pick the acceptor of the group]",
+          "[basic_socket_acceptor.reuseport]") {
+  net::execution_context ctx{};
+  mock_protocol::endpoint endpoint{net::ip::address_v4::any(), 12391};
+  system_error2::system_code ec;
+  net::basic_socket_acceptor<mock_protocol> first{ctx, endpoint, ec, true,
+                                                  true};
+  REQUIRE(ec.success());
+  net::basic_socket_acceptor<mock_protocol> second{ctx, endpoint, ec, true,
+                                                   true};
+  REQUIRE(ec.success());
+  REQUIRE(first.set_non_blocking(true).success());
+  REQUIRE(second.set_non_blocking(true).success());
+
+  // Every connection goes to the second acceptor.
+  sock_filter code[] = {BPF_STMT(BPF_RET | BPF_K, 1)};
+  REQUIRE(first.attach_reuseport_cbpf(code, 1).success());
+
+  for (int i = 0; i < 4; ++i) {
+    int client = ::socket(AF_INET, SOCK_STREAM, 0);
+    REQUIRE(client >= 0);
+    ::sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(12391);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    REQUIRE(::connect(client, reinterpret_cast<::sockaddr*>(&addr),
+                      sizeof(addr)) == 0);
+    CHECK(second.accept().has_value());
+    CHECK_FALSE(first.accept().has_value());
+    ::close(client);
+  }
+  CHECK(first.detach_reuseport_bpf().success());
+}
@@ -26,5 +26,5 @@ TEST_CASE("[Default constructor]", "[basic_stream_socket.ctor]") {
   net::basic_stream_socket<mock_protocol> socket{ctx};
   CHECK(!socket.is_open());
   CHECK(socket.state() == 0);
-  CHECK(socket.protocol_ == std::nullopt);
+  CHECK(!socket.has_protocol());
 }
@@ -14,7 +14,9 @@
  * limitations under the License.
  */
 #include <concepts>
+#include <array>
 #include <cstring>
+#include <vector>
 
 #include "catch2/catch_test_macros.hpp"
 
@@ -305,3 +307,61 @@ TEST_CASE("const_buffer should satisfy const_buffer_sequence",
   CHECK(!const_buffer_sequence<const std::vector<char>>);
   CHECK(!const_buffer_sequence<const std::string>);
 }
+
+TEST_CASE("buffer_copy should copy every fragment size exactly",
+          "buffer.buffer_copy") {
+  std::vector<unsigned char> source(256);
+  for (std::size_t i = 0; i < source.size(); ++i) {
+    source[i] = static_cast<unsigned char>(i * 7 + 1);
+  }
+  for (std::size_t n = 0; n <= 2 * net::small_copy_threshold + 2; ++n) {
+    std::vector<unsigned char> target(n + 2, 0xee);
+    CHECK(net::buffer_copy(net::buffer(target.data() + 1, n),
+                           net::buffer(source.data(), n)) == n);
+    CHECK(target.front() == 0xee);
+    CHECK(target.back() == 0xee);
+    CHECK(std::memcmp(target.data() + 1, source.data(), n) == 0);
+  }
+}
+
+TEST_CASE("buffer_copy should gather many small fragments",
+          "buffer.buffer_copy") {
+  std::vector<unsigned char> source(512);
+  for (std::size_t i = 0; i < source.size(); ++i) {
+    source[i] = static_cast<unsigned char>(i);
+  }
+  std::vector<const_buffer> fragments;
+  std::size_t offset = 0;
+  for (std::size_t size = 1; offset + size <= source.size(); ++size) {
+    fragments.emplace_back(source.data() + offset, size);
+    offset += size;
+  }
+  std::vector<unsigned char> target(offset);
+  CHECK(net::buffer_copy(net::buffer(target), fragments) == offset);
+  CHECK(std::memcmp(target.data(), source.data(), offset) == 0);
+}
+
+TEST_CASE("buffer_find should find a delimiter spanning buffers",
+          "buffer.buffer_find") {
+  std::string first = "hello\r";
+  std::string second = "\nworld\r\n";
+  std::array<const_buffer, 2> sequence{net::buffer(first),
+                                       net::buffer(second)};
+  CHECK(net::buffer_find(sequence, "\r\n") == 5);
+  CHECK(net::buffer_find(sequence, "\r\n", 6) == 12);
+  CHECK(net::buffer_find(sequence, "world") == 7);
+  CHECK(net::buffer_find(sequence, "\r\r") == std::string_view::npos);
+  CHECK(net::buffer_find(net::buffer(first), "\r\n") ==
+        std::string_view::npos);
+  CHECK(net::buffer_find(net::buffer(first), "") == 0);
+}
+
+TEST_CASE("dynamic buffers should satisfy dynamic_buffer_sequence",
+          "buffer.concept") {
+  CHECK(net::dynamic_buffer_sequence<
+        net::dynamic_string_buffer<char, std::char_traits<char>,
+                                   std::allocator<char>>>);
+  CHECK(net::dynamic_buffer_sequence<
+        net::dynamic_vector_buffer<char, std::allocator<char>>>);
+  CHECK(!net::dynamic_buffer_sequence<std::string>);
+}
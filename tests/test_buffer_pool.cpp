@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "buffer_pool.hpp"
+
+using net::buffer_lease;
+using net::buffer_pool;
+
+TEST_CASE("[buffer_pool should lease and reuse blocks]", "[buffer_pool]") {
+  buffer_pool pool{100, 4};
+  buffer_lease lease = pool.acquire();
+  REQUIRE(lease);
+  CHECK(lease.capacity() == 100);
+  CHECK(lease.size() == 0);
+  CHECK(reinterpret_cast<std::uintptr_t>(lease.data()) %
+            alignof(std::max_align_t) ==
+        0);
+  lease.resize(42);
+  CHECK(lease.buffer().size() == 42);
+  CHECK(pool.block_count() == 4);
+  CHECK(pool.leased_count() == 1);
+
+  std::byte* data = lease.data();
+  lease.release();
+  CHECK(!lease);
+  CHECK(pool.leased_count() == 0);
+
+  // Released blocks are handed out again before new chunks are allocated.
+  std::set<std::byte*> seen;
+  std::vector<buffer_lease> leases;
+  for (int i = 0; i < 4; ++i) {
+    leases.push_back(pool.acquire());
+    seen.insert(leases.back().data());
+  }
+  CHECK(seen.count(data) == 1);
+  CHECK(seen.size() == 4);
+  CHECK(pool.block_count() == 4);
+
+  leases.push_back(pool.acquire());
+  CHECK(pool.block_count() == 8);
+  CHECK(pool.acquired_count() == 6);
+}
+
+TEST_CASE("[buffer_lease should move its block]", "[buffer_pool]") {
+  buffer_pool pool{64, 2};
+  buffer_lease a = pool.acquire();
+  std::byte* data = a.data();
+  buffer_lease b = std::move(a);
+  CHECK(!a);
+  CHECK(b.data() == data);
+  a = pool.acquire();
+  a = std::move(b);
+  CHECK(a.data() == data);
+  CHECK(pool.leased_count() == 1);
+}
+
+TEST_CASE("[buffer_pool should take back blocks released on other threads]",
+          "[buffer_pool]") {
+  buffer_pool pool{64, 8};
+  std::vector<buffer_lease> leases;
+  for (int i = 0; i < 8; ++i) {
+    leases.push_back(pool.acquire());
+  }
+  std::thread([leases = std::move(leases)]() mutable {
+    leases.clear();
+  }).join();
+  CHECK(pool.leased_count() == 0);
+  leases.clear();
+  for (int i = 0; i < 8; ++i) {
+    leases.push_back(pool.acquire());
+  }
+  CHECK(pool.block_count() == 8);
+}
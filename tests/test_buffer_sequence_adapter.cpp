@@ -13,8 +13,10 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <array>
 #include <concepts>
 #include <cstring>
+#include <vector>
 
 #include "catch2/catch_test_macros.hpp"
 
@@ -26,6 +28,14 @@ using net::buffer_sequence_adapter;
 using net::const_buffer;
 using net::mutable_buffer;
 
+namespace {
+// A sequence of many small fragments.
+struct fragments : std::vector<const_buffer> {};
+}  // namespace
+
+template <>
+inline constexpr int net::max_buffers_per_call<fragments> = 1024;
+
 TEST_CASE("buffer_sequence_adapter with different mutable_buffer",
           "buffer.buffer_sequence_adapter") {
   char raw_data[1024];
@@ -78,3 +88,94 @@ TEST_CASE("buffer_sequence_adapter with const_buffer sequence",
   CHECK(bufs_type::first(vec).data() == vec[0].data());
   CHECK(bufs_type::first(vec).size() == buffer_size(vec[0]));
 }
+
+TEST_CASE("buffer_sequence_adapter consume should advance in place",
+          "buffer.buffer_sequence_adapter") {
+  char data1[8], data2[4], data3[8];
+  std::vector<mutable_buffer> vec{buffer(data1), buffer(data2), buffer(data3)};
+  buffer_sequence_adapter<mutable_buffer, std::vector<mutable_buffer>> b1{vec};
+  b1.consume(3);
+  CHECK(b1.count() == 3);
+  CHECK(b1.buffers()->iov_base == data1 + 3);
+  CHECK(b1.buffers()->iov_len == 5);
+  CHECK(b1.total_size() == 17);
+
+  // Fully consumed buffers are skipped.
+  b1.consume(9);
+  CHECK(b1.count() == 1);
+  CHECK(b1.buffers()->iov_base == data3);
+  CHECK(b1.total_size() == 8);
+  b1.consume(100);
+  CHECK(b1.count() == 0);
+  CHECK(b1.all_empty());
+
+  buffer_sequence_adapter<mutable_buffer, mutable_buffer> b2{buffer(data1)};
+  b2.consume(6);
+  CHECK(b2.buffers()->iov_base == data1 + 6);
+  CHECK(b2.buffers()->iov_len == 2);
+  CHECK(b2.total_size() == 2);
+}
+
+TEST_CASE("buffer_sequence_adapter refill should walk a long sequence",
+          "buffer.buffer_sequence_adapter") {
+  char data[200];
+  std::vector<mutable_buffer> vec;
+  for (char& c : data) {
+    vec.push_back(buffer(&c, 1));
+  }
+  using bufs_type =
+      buffer_sequence_adapter<mutable_buffer, std::vector<mutable_buffer>>;
+  bufs_type b1{vec};
+  CHECK(b1.count() == net::buffer_sequence_adapter_base::max_buffers);
+  CHECK(b1.more());
+
+  // Nothing is translated before the current buffers are consumed.
+  CHECK(!b1.refill());
+  std::size_t total = 0;
+  do {
+    CHECK(b1.buffers()->iov_base == data + total);
+    total += b1.total_size();
+    b1.consume(b1.total_size());
+  } while (b1.refill());
+  CHECK(total == 200);
+  CHECK(!b1.more());
+  CHECK(b1.all_empty());
+}
+
+TEST_CASE("buffer_sequence_adapter should take more buffers when allowed",
+          "buffer.buffer_sequence_adapter") {
+  char data[300];
+  fragments frags;
+  for (const char& c : data) {
+    frags.push_back(buffer(&c, 1));
+  }
+  buffer_sequence_adapter<const_buffer, fragments> b1{frags};
+  CHECK(b1.count() == 300);
+  CHECK(b1.total_size() == 300);
+  CHECK(!b1.more());
+
+  buffer_sequence_adapter<const_buffer, std::vector<const_buffer>, 16> b2{
+      frags};
+  CHECK(b2.count() == 16);
+  CHECK(b2.more());
+}
+
+TEST_CASE("buffer_sequence_adapter should size fixed sequences exactly",
+          "buffer.buffer_sequence_adapter") {
+  char data1[4], data2[8], data3[2];
+  std::array<const_buffer, 4> arr{buffer(data1), const_buffer{}, buffer(data2),
+                                  buffer(data3)};
+  using bufs_type = buffer_sequence_adapter<const_buffer, decltype(arr)>;
+  STATIC_REQUIRE(sizeof(bufs_type) ==
+                 4 * sizeof(::iovec) + 2 * sizeof(std::size_t));
+
+  bufs_type b1{arr};
+  CHECK(b1.count() == 4);
+  CHECK(b1.total_size() == 14);
+  CHECK(!b1.more());
+  b1.consume(6);
+  CHECK(b1.count() == 2);
+  CHECK(b1.buffers()->iov_base == data2 + 2);
+  CHECK(b1.total_size() == 8);
+  CHECK(bufs_type::first(arr).data() == data1);
+}
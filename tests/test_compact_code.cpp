@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cerrno>
+#include <system_error>  // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "compact_code.hpp"
+#include "error_channel.hpp"
+#include "net_error.hpp"
+#include "status-code/generic_code.hpp"
+#include "status-code/posix_code.hpp"
+#include "status-code/system_code.hpp"
+
+using net::compact_code;
+using system_error2::errc;
+
+TEST_CASE("[compact_code should fit in four bytes]", "[compact_code]") {
+  STATIC_REQUIRE(sizeof(compact_code) == 4);
+  compact_code code;
+  CHECK(code.success());
+  CHECK(code == errc::success);
+}
+
+TEST_CASE("[compact_code should keep errno values of system codes]",
+          "[compact_code]") {
+  compact_code code = system_error2::system_code{errc::timed_out};
+  CHECK(code.failure());
+  CHECK(code == errc::timed_out);
+  CHECK(code.value() == ETIMEDOUT);
+  CHECK(code.domain() == system_error2::generic_code_domain);
+
+  code = system_error2::system_code{system_error2::posix_code(EAGAIN)};
+  CHECK(code == errc::resource_unavailable_try_again);
+
+  code = errc::success;
+  CHECK(code.success());
+}
+
+TEST_CASE("[compact_code should tell network errors apart]",
+          "[compact_code]") {
+  compact_code code =
+      system_error2::system_code{::status_code(net::network_errc::eof)};
+  CHECK(code.failure());
+  CHECK(code == net::network_errc::eof);
+  CHECK(!(code == errc::success));
+  CHECK(code.value() == static_cast<int>(net::network_errc::eof));
+  CHECK(code.domain() ==
+        system_error2::quick_status_code_from_enum_domain<net::network_errc>);
+}
+
+TEST_CASE("[to_error should convert compact codes to either channel]",
+          "[compact_code.to_error]") {
+  const compact_code reset{errc::connection_reset};
+  CHECK(net::to_error<std::error_code>(reset) ==
+        std::errc::connection_reset);
+  CHECK(net::to_error<system_error2::system_code>(reset) ==
+        errc::connection_reset);
+
+  const compact_code eof{net::network_errc::eof};
+  CHECK(net::to_error<std::error_code>(eof) == net::network_errc::eof);
+  CHECK(net::to_error<system_error2::system_code>(eof).domain() ==
+        system_error2::quick_status_code_from_enum_domain<net::network_errc>);
+
+  CHECK(net::to_error<std::error_code>(
+            system_error2::system_code{errc::connection_aborted}) ==
+        std::errc::connection_aborted);
+  CHECK(net::to_error<system_error2::system_code>(
+            system_error2::system_code{errc::connection_aborted}) ==
+        errc::connection_aborted);
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <memory>
+#include <set>
+#include <vector>
+#include <string>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "connection_table.hpp"
+#include "monotonic_clock.hpp"
+
+using net::connection_table;
+
+TEST_CASE("[connection_table should insert, find and erase objects]",
+          "[connection_table]") {
+  connection_table<std::string, 4> table;
+  CHECK(table.empty());
+  CHECK(table.get({}) == nullptr);
+
+  auto [h1, s1] = table.emplace("one");
+  auto [h2, s2] = table.emplace("two");
+  CHECK(table.size() == 2);
+  CHECK(table.capacity() == 4);
+  CHECK(*table.get(h1) == "one");
+  CHECK(table.get(h2) == &s2);
+  CHECK(!(h1 == h2));
+
+  CHECK(table.erase(h1));
+  CHECK(!table.erase(h1));
+  CHECK(table.get(h1) == nullptr);
+  CHECK(table.size() == 1);
+
+  // The slot is reused with a new generation, the old handle stays stale.
+  auto [h3, s3] = table.emplace("three");
+  CHECK(h3.index() == h1.index());
+  CHECK(h3.generation() != h1.generation());
+  CHECK(table.get(h1) == nullptr);
+  CHECK(*table.get(h3) == "three");
+  CHECK(table.get(connection_table<std::string, 4>::handle::from_value(
+            h3.value())) == &s3);
+}
+
+TEST_CASE("[connection_table should keep addresses stable when growing]",
+          "[connection_table]") {
+  connection_table<int, 2> table;
+  auto [h, first] = table.emplace(42);
+  for (int i = 0; i < 100; ++i) {
+    table.emplace(i);
+  }
+  CHECK(table.capacity() >= 101);
+  CHECK(table.get(h) == &first);
+  CHECK(first == 42);
+}
+
+TEST_CASE("[connection_table should reserve slots up front]",
+          "[connection_table]") {
+  connection_table<int, 4> table;
+  table.reserve(10);
+  CHECK(table.capacity() == 12);
+  CHECK(table.empty());
+  for (int i = 0; i < 12; ++i) {
+    table.emplace(i);
+  }
+  CHECK(table.capacity() == 12);
+  table.reserve(4);
+  CHECK(table.capacity() == 12);
+}
+
+TEST_CASE("[connection_table should iterate the live objects]",
+          "[connection_table]") {
+  connection_table<int, 8> table;
+  std::vector<connection_table<int, 8>::handle> handles;
+  for (int i = 0; i < 20; ++i) {
+    handles.push_back(table.emplace(i).first);
+  }
+  for (int i = 0; i < 20; i += 2) {
+    CHECK(table.erase(handles[i]));
+  }
+
+  std::set<int> seen;
+  table.for_each([&](auto h, int& value) {
+    CHECK(table.get(h) == &value);
+    seen.insert(value);
+  });
+  CHECK(seen.size() == 10);
+  CHECK(*seen.begin() == 1);
+
+  for (std::size_t i = 0; i < table.size(); ++i) {
+    CHECK(table.contains(table.at_position(i)));
+  }
+}
+
+TEST_CASE("[connection_table should destroy the objects it holds]",
+          "[connection_table]") {
+  auto counter = std::make_shared<int>(0);
+  {
+    connection_table<std::shared_ptr<int>> table;
+    auto h = table.emplace(counter).first;
+    table.emplace(counter);
+    CHECK(counter.use_count() == 3);
+    table.erase(h);
+    CHECK(counter.use_count() == 2);
+  }
+  CHECK(counter.use_count() == 1);
+}
+
+TEST_CASE("[connection_table should keep the traffic in dense columns]",
+          "[connection_table.traffic]") {
+  connection_table<int, 4> table;
+  auto h1 = table.emplace(1).first;
+  auto h2 = table.emplace(2).first;
+  auto h3 = table.emplace(3).first;
+  using time_point = net::monotonic_clock::time_point;
+  const auto now = time_point::from_seconds_and_nanoseconds(2, 500);
+  table.add_received(h1, 100, now);
+  table.add_received(h1, 20, now);
+  table.add_sent(h2, 7, now);
+  table.add_received(h3, 3, now);
+
+  auto traffic = table.traffic();
+  REQUIRE(traffic.bytes_in.size() == 3);
+  CHECK(traffic.bytes_in[0] == 120);
+  CHECK(traffic.ops_in[0] == 2);
+  CHECK(traffic.bytes_out[1] == 7);
+  CHECK(traffic.ops_out[1] == 1);
+  CHECK(traffic.last_activity[1] == 2'000'000'500);
+
+  // The last connection takes the position of the erased one, with its
+  // counters. Stale handles aren't counted.
+  CHECK(table.erase(h1));
+  table.add_received(h1, 1000, now);
+  traffic = table.traffic();
+  REQUIRE(traffic.bytes_in.size() == 2);
+  CHECK(table.at_position(0) == h3);
+  CHECK(traffic.bytes_in[0] == 3);
+  CHECK(traffic.bytes_out[1] == 7);
+
+  // A new connection starts from zero.
+  auto h4 = table.emplace(4).first;
+  traffic = table.traffic();
+  CHECK(table.at_position(2) == h4);
+  CHECK(traffic.bytes_in[2] == 0);
+  CHECK(traffic.last_activity[2] == 0);
+
+  table.reset_traffic();
+  traffic = table.traffic();
+  CHECK(traffic.bytes_in[0] == 0);
+  CHECK(traffic.bytes_out[1] == 0);
+  CHECK(traffic.last_activity[1] == 2'000'000'500);
+}
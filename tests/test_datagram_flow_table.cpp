@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sys/poll.h>
+#include <sys/socket.h>
+
+#include <cstddef>
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+
+#include "datagram_flow_table.hpp"
+#include "execution_context.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/udp.hpp"
+
+using net::ip::udp;
+using system_error2::errc;
+using system_error2::system_code;
+
+namespace {
+struct flow_state {
+  explicit flow_state(int id = 0) : id(id) {}
+
+  int id;
+  std::size_t datagrams = 0;
+};
+
+// Whether `socket` has a datagram to read within a second.
+bool readable(udp::socket& socket) {
+  pollfd fds{socket.native_handle(), POLLIN, 0};
+  return ::poll(&fds, 1, 1000) == 1;
+}
+
+udp::socket make_listener(net::execution_context& ctx) {
+  udp::socket listener{ctx};
+  REQUIRE(listener.open(udp::v4()).success());
+  REQUIRE(listener.set_option(net::socket_base::reuse_port{true}).success());
+  REQUIRE(
+      listener.bind(udp::endpoint{net::ip::address_v4::loopback(), 0})
+          .success());
+  return listener;
+}
+
+udp::socket make_client(net::execution_context& ctx,
+                        const udp::endpoint& peer) {
+  udp::socket client{ctx};
+  REQUIRE(client.open(udp::v4()).success());
+  REQUIRE(client.connect(peer).success());
+  return client;
+}
+}  // namespace
+
+TEST_CASE("[connect_flow() should share the local endpoint of the listener]",
+          "[basic_datagram_socket.connect_flow]") {
+  net::execution_context ctx{};
+  udp::socket listener = make_listener(ctx);
+  auto local = listener.local_endpoint().value();
+  udp::socket client = make_client(ctx, local);
+
+  system_code ec{errc::success};
+  udp::socket flow =
+      listener.connect_flow(client.local_endpoint().value(), ec);
+  REQUIRE(ec.success());
+  CHECK(&flow.context() == &ctx);
+  CHECK(flow.local_endpoint().value() == local);
+  CHECK(flow.peer_endpoint().value() == client.local_endpoint().value());
+
+  // The kernel prefers the connected socket for datagrams of the peer.
+  REQUIRE(client.send("a", 1, 0).value() == 1);
+  REQUIRE(readable(flow));
+  char byte = 0;
+  CHECK(flow.recv(&byte, 1, MSG_DONTWAIT).value() == 1);
+  CHECK(byte == 'a');
+  CHECK(!readable(listener));
+
+  // Replies come from the shared endpoint.
+  REQUIRE(flow.send("b", 1, 0).value() == 1);
+  REQUIRE(readable(client));
+  CHECK(client.recv(&byte, 1, MSG_DONTWAIT).value() == 1);
+  CHECK(byte == 'b');
+
+  flow.close();
+  client.close();
+  listener.close();
+}
+
+TEST_CASE("[connect_flow() needs SO_REUSEPORT on the listener]",
+          "[basic_datagram_socket.connect_flow]") {
+  net::execution_context ctx{};
+  udp::socket listener{ctx};
+  REQUIRE(listener.open(udp::v4()).success());
+  REQUIRE(listener.bind(udp::endpoint{net::ip::address_v4::loopback(), 0})
+              .success());
+
+  system_code ec{errc::success};
+  udp::socket flow = listener.connect_flow(
+      udp::endpoint{net::ip::address_v4::loopback(), 9}, ec);
+  CHECK(ec.failure());
+  CHECK(!flow.is_open());
+  listener.close();
+}
+
+TEST_CASE("[route() should spawn a flow for a new peer only once]",
+          "[datagram_flow_table.route]") {
+  net::execution_context ctx{};
+  udp::socket listener = make_listener(ctx);
+  udp::socket client = make_client(ctx, listener.local_endpoint().value());
+  const udp::endpoint peer = client.local_endpoint().value();
+
+  net::datagram_flow_table<udp, flow_state> flows{listener};
+  system_code ec{errc::success};
+  auto [entry, spawned] = flows.route(peer, ec, 7);
+  REQUIRE(ec.success());
+  REQUIRE(entry != nullptr);
+  CHECK(spawned);
+  CHECK(entry->flow.id == 7);
+  CHECK(entry->socket.is_open());
+  CHECK(flows.size() == 1);
+
+  auto [again, spawned_again] = flows.route(peer, ec, 8);
+  CHECK(again == entry);
+  CHECK(!spawned_again);
+  CHECK(entry->flow.id == 7);
+  CHECK(flows.find(peer) == entry);
+
+  REQUIRE(client.send("c", 1, 0).value() == 1);
+  CHECK(readable(entry->socket));
+
+  CHECK(flows.erase(peer));
+  CHECK(!flows.erase(peer));
+  CHECK(flows.find(peer) == nullptr);
+  CHECK(flows.size() == 0);
+  client.close();
+  listener.close();
+}
+
+TEST_CASE("[route() should leave peers beyond max_flows to the listener]",
+          "[datagram_flow_table.route]") {
+  net::execution_context ctx{};
+  udp::socket listener = make_listener(ctx);
+  net::datagram_flow_table<udp, flow_state> flows{listener, 1};
+
+  system_code ec{errc::success};
+  udp::endpoint first{net::ip::address_v4::loopback(), 40001};
+  udp::endpoint second{net::ip::address_v4::loopback(), 40002};
+  CHECK(flows.route(first, ec).first != nullptr);
+  CHECK(ec.success());
+  CHECK(flows.route(second, ec).first == nullptr);
+  CHECK(ec == errc::too_many_files_open);
+  CHECK(flows.size() == 1);
+  CHECK(flows.erase(first));
+  listener.close();
+}
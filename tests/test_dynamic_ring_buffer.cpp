@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "buffer.hpp"
+#include "dynamic_ring_buffer.hpp"
+
+using net::dynamic_ring_buffer;
+
+namespace {
+// Append `s` to the output sequence of `ring` and commit it.
+void write(dynamic_ring_buffer& ring, const std::string& s) {
+  auto bufs = ring.prepare(s.size());
+  CHECK(net::buffer_copy(bufs, net::buffer(s)) == s.size());
+  ring.commit(s.size());
+}
+
+// Copy the input sequence of `ring`.
+std::string read(const dynamic_ring_buffer& ring) {
+  std::string s(ring.size(), '\0');
+  CHECK(net::buffer_copy(net::buffer(s), ring.data()) == s.size());
+  return s;
+}
+}  // namespace
+
+TEST_CASE("[dynamic_ring_buffer should wrap around without moving bytes]",
+          "[dynamic_ring_buffer]") {
+  dynamic_ring_buffer ring{16};
+  write(ring, "0123456789");
+  ring.consume(8);
+  CHECK(read(ring) == "89");
+
+  // The output sequence wraps around the end of the ring.
+  write(ring, "abcdefghij");
+  CHECK(ring.capacity() == 16);
+  CHECK(ring.data()[0].size() == 8);
+  CHECK(ring.data()[1].size() == 4);
+  CHECK(read(ring) == "89abcdefghij");
+
+  ring.consume(12);
+  CHECK(ring.size() == 0);
+  CHECK(ring.data()[0].size() == 0);
+}
+
+TEST_CASE("[dynamic_ring_buffer should grow and keep the input sequence]",
+          "[dynamic_ring_buffer]") {
+  dynamic_ring_buffer ring{8, 64};
+  write(ring, "abcdef");
+  ring.consume(4);
+  write(ring, "ghijklmnopqrst");
+  CHECK(ring.capacity() >= 16);
+  CHECK(read(ring) == "efghijklmnopqrst");
+  CHECK_THROWS_AS(ring.prepare(64), std::length_error);
+}
+
+TEST_CASE("[dynamic_ring_buffer should keep sequences contiguous when "
+          "double mapped]",
+          "[dynamic_ring_buffer]") {
+  dynamic_ring_buffer ring{4096, 1 << 20, true};
+  if (!ring.is_double_mapped()) {
+    WARN("double mapping is not available");
+    return;
+  }
+  const std::size_t capacity = ring.capacity();
+  std::string block(capacity - 10, 'x');
+  write(ring, block);
+  ring.consume(block.size() - 2);
+
+  // Written across the end of the first mapping.
+  write(ring, "0123456789abcde");
+  auto data = ring.data();
+  CHECK(data[1].size() == 0);
+  CHECK(data[0].size() == 17);
+  CHECK(std::memcmp(static_cast<const char*>(data[0].data()) + 2,
+                    "0123456789abcde", 15) == 0);
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "stdexec.hpp"
+
+#include "epoll/async_scope.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/sync_wait.hpp"
+
+using net::epoll_context;
+using namespace std::chrono_literals;  // NOLINT
+
+TEST_CASE("[join should complete once every spawned operation completed]",
+          "[epoll_async_scope.join]") {
+  epoll_context ctx{};
+  net::async_scope scope{ctx};
+  int done = 0;
+  for (int i = 0; i < 3; ++i) {
+    scope.spawn(stdexec::schedule(ctx.get_scheduler()) |
+                stdexec::then([&done]() noexcept { ++done; }));
+  }
+  scope.spawn(exec::schedule_after(ctx.get_scheduler(), 20ms) |
+              stdexec::then([&done]() noexcept { ++done; }));
+  CHECK(scope.size() == 4);
+
+  // Spawned operations count as outstanding work of the context.
+  CHECK(ctx.outstanding_work() == 4);
+
+  int done_at_join = 0;
+  auto start = std::chrono::steady_clock::now();
+  net::sync_wait(ctx, scope.join() | stdexec::then([&]() noexcept {
+                        done_at_join = done;
+                      }));
+  CHECK(std::chrono::steady_clock::now() - start >= 20ms);
+  CHECK(done_at_join == 4);
+  CHECK(scope.empty());
+  CHECK(ctx.outstanding_work() == 0);
+}
+
+TEST_CASE("[join should complete right away on an empty scope]",
+          "[epoll_async_scope.join]") {
+  epoll_context ctx{};
+  net::async_scope scope{ctx};
+  bool joined = false;
+  net::sync_wait(ctx, scope.join() | stdexec::then([&joined]() noexcept {
+                        joined = true;
+                      }));
+  CHECK(joined);
+}
+
+TEST_CASE("[operations spawned by spawned operations should be joined]",
+          "[epoll_async_scope.spawn]") {
+  epoll_context ctx{};
+  net::async_scope scope{ctx};
+  bool inner_done = false;
+  bool on_io_thread = false;
+  scope.spawn(stdexec::schedule(ctx.get_scheduler()) |
+              stdexec::then([&]() noexcept {
+                on_io_thread = epoll_context::current() == &ctx;
+                scope.spawn(
+                    exec::schedule_after(ctx.get_scheduler(), 10ms) |
+                    stdexec::then([&inner_done]() noexcept {
+                      inner_done = true;
+                    }));
+              }));
+
+  // Both joins wait for the inner operation.
+  bool first = false;
+  bool second = false;
+  net::sync_wait(ctx, stdexec::when_all(
+                          scope.join() | stdexec::then([&]() noexcept {
+                            first = inner_done;
+                          }),
+                          scope.join() | stdexec::then([&]() noexcept {
+                            second = inner_done;
+                          })));
+  CHECK(on_io_thread);
+  CHECK(first);
+  CHECK(second);
+  CHECK(scope.empty());
+}
+
+TEST_CASE("[spawned operations should be allocated from the context pool]",
+          "[epoll_async_scope.allocator]") {
+  epoll_context ctx{};
+  net::async_scope scope{ctx};
+  scope.spawn(stdexec::schedule(ctx.get_scheduler()));
+  net::sync_wait(ctx, scope.join());
+
+  // The state of the first operation is reused by the second.
+  const auto reused = ctx.operation_pool().reuse_count();
+  scope.spawn(stdexec::schedule(ctx.get_scheduler()));
+  net::sync_wait(ctx, scope.join());
+  CHECK(ctx.operation_pool().reuse_count() > reused);
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <system_error>  // NOLINT
+#include <utility>
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "buffer.hpp"
+#include "epoll/cancellation_group.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_recv_some_op.hpp"
+#include "epoll/socket_wait_op.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/tcp.hpp"
+#include "socket_base.hpp"
+#include "tcp_connection.hpp"
+
+using net::epoll_context;
+using wait_type = net::socket_base::wait_type;
+
+constexpr port_type mock_port = 12396;
+
+namespace {
+// Records how the operation completed. Its environment has no stop token, so
+// the operations register no stop callback.
+struct result_receiver {
+  using is_receiver = void;
+  using __t = result_receiver;
+  using __id = result_receiver;
+
+  friend void tag_invoke(stdexec::set_value_t, result_receiver&& self,
+                         auto...) noexcept {
+    *self.result_ = "value";
+  }
+
+  friend void tag_invoke(stdexec::set_error_t, result_receiver&& self,
+                         auto...) noexcept {
+    *self.result_ = "error";
+  }
+
+  friend void tag_invoke(stdexec::set_stopped_t,
+                         result_receiver&& self) noexcept {
+    *self.result_ = "stopped";
+  }
+
+  friend stdexec::empty_env tag_invoke(stdexec::get_env_t,
+                                       const result_receiver&) noexcept {
+    return {};
+  }
+
+  std::string* result_;
+};
+}  // namespace
+
+TEST_CASE("[cancel_all should stop the operations of every member at once]",
+          "[epoll_cancellation_group]") {
+  epoll_context ctx{};
+  auto* old_context =
+      std::exchange(net::__epoll::current_thread_context, &ctx);
+  connection conn{ctx, mock_port};
+  REQUIRE(conn.client.set_non_blocking(true).success());
+
+  net::cancellation_group group{ctx};
+  CHECK(group.add(conn.server));
+  CHECK(group.add(conn.client));
+  CHECK(group.size() == 2);
+
+  // Nothing to read on either side, both receives park.
+  char server_buf[16];
+  char client_buf[16];
+  std::string server_result;
+  std::string client_result;
+  auto server_recv = stdexec::connect(
+      net::async_recv_some(conn.server,
+                           net::buffer(server_buf, sizeof(server_buf))),
+      result_receiver{&server_result});
+  auto client_recv = stdexec::connect(
+      net::async_recv_some(conn.client,
+                           net::buffer(client_buf, sizeof(client_buf))),
+      result_receiver{&client_result});
+  stdexec::start(server_recv);
+  stdexec::start(client_recv);
+  ctx.execute_local();
+  CHECK(server_result.empty());
+  CHECK(client_result.empty());
+
+  group.cancel_all();
+  CHECK(group.canceled());
+  ctx.execute_local();
+  CHECK(server_result == "stopped");
+  CHECK(client_result == "stopped");
+
+  // Later operations which would wait fail the same way.
+  std::string wait_result;
+  auto wait = stdexec::connect(
+      net::async_wait(conn.server, wait_type::wait_read),
+      result_receiver{&wait_result});
+  stdexec::start(wait);
+  ctx.execute_local();
+  CHECK(wait_result == "stopped");
+
+  group.clear();
+  CHECK(group.size() == 0);
+  CHECK_FALSE(group.canceled());
+  net::__epoll::current_thread_context = old_context;
+}
+
+TEST_CASE("[cancel_all should leave the sockets outside the group alone]",
+          "[epoll_cancellation_group]") {
+  epoll_context ctx{};
+  auto* old_context =
+      std::exchange(net::__epoll::current_thread_context, &ctx);
+  connection conn{ctx, mock_port + 1};
+  REQUIRE(conn.client.set_non_blocking(true).success());
+
+  net::cancellation_group<1> group{ctx};
+  CHECK(group.add(conn.server));
+  CHECK_FALSE(group.add(conn.client));
+  group.remove(conn.server);
+  CHECK(group.size() == 0);
+  CHECK(group.add(conn.client));
+
+  char buf[16];
+  std::string result;
+  auto recv = stdexec::connect(
+      net::async_recv_some(conn.server, net::buffer(buf, sizeof(buf))),
+      result_receiver{&result});
+  stdexec::start(recv);
+  ctx.execute_local();
+
+  // A member which has never waited has nothing to cancel.
+  group.cancel_all();
+  ctx.execute_local();
+  CHECK(result.empty());
+
+  // The data completes the receive.
+  std::string payload = "hi";
+  REQUIRE(conn.client.sync_send(payload.data(), payload.size(), 0)
+              .has_value());
+  ctx.run_for(std::chrono::milliseconds(100));
+  CHECK(result == "value");
+  net::__epoll::current_thread_context = old_context;
+}
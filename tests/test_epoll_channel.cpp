@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <chrono>  // NOLINT
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "stdexec.hpp"
+
+#include "epoll/channel.hpp"
+#include "epoll/epoll_context.hpp"
+
+using net::epoll_context;
+
+TEST_CASE("[channel should deliver messages sent before the receive]",
+          "[epoll_channel]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  net::channel<std::string> channel{ctx};
+
+  channel.send("hello");
+  channel.send("world");
+  auto [first] = stdexec::sync_wait(net::async_receive(channel)).value();
+  auto [second] = stdexec::sync_wait(net::async_receive(channel)).value();
+  CHECK(first == "hello");
+  CHECK(second == "world");
+  ctx.request_stop();
+}
+
+TEST_CASE("[channel should complete a waiting receive on the io thread]",
+          "[epoll_channel]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  net::channel<std::unique_ptr<int>> channel{ctx};
+
+  std::jthread sender([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    channel.send(std::make_unique<int>(42));
+  });
+  auto [result] =
+      stdexec::sync_wait(net::async_receive(channel) |
+                         stdexec::then([&](std::unique_ptr<int> p) {
+                           return std::pair{*p, ctx.is_running_on_io_thread()};
+                         }))
+          .value();
+  CHECK(result.first == 42);
+  CHECK(result.second);
+  ctx.request_stop();
+}
+
+TEST_CASE("[channel should keep the order of every producer]",
+          "[epoll_channel]") {
+  constexpr int producers = 4;
+  constexpr int per_producer = 10000;
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  net::channel<std::pair<int, int>> channel{ctx};
+
+  std::vector<std::jthread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&channel, p] {
+      for (int i = 0; i < per_producer; ++i) {
+        channel.send({p, i});
+      }
+    });
+  }
+  std::vector<int> next(producers, 0);
+  bool in_order = true;
+  for (int i = 0; i < producers * per_producer; ++i) {
+    auto [message] = stdexec::sync_wait(net::async_receive(channel)).value();
+    in_order = in_order && message.second == next[message.first];
+    ++next[message.first];
+  }
+  CHECK(in_order);
+  ctx.request_stop();
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <chrono>        // NOLINT
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+#include <type_traits>
+#include <utility>
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "epoll/connection_pool.hpp"
+#include "epoll/epoll_context.hpp"
+#include "io_thread.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/tcp.hpp"
+
+using net::epoll_context;
+using net::ip::tcp;
+using pool_t = net::connection_pool<tcp>;
+using namespace std::chrono_literals;  // NOLINT
+
+constexpr port_type mock_port = 12394;
+
+namespace {
+// Acquire a connection and give it back, returning its descriptor.
+int acquire_and_release(pool_t& pool, const tcp::endpoint& peer) {
+  auto [fd] = stdexec::sync_wait(net::async_acquire(pool, peer) |
+                                 stdexec::then([&](tcp::socket socket) {
+                                   int fd = socket.native_handle();
+                                   pool.release(peer, std::move(socket));
+                                   return fd;
+                                 }))
+                  .value();
+  return fd;
+}
+}  // namespace
+
+TEST_CASE("[connection_pool should reuse released connections]",
+          "[epoll_connection_pool.reuse]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  const tcp::endpoint peer{net::ip::address_v4::loopback(), mock_port};
+  system_error2::system_code ec{};
+  tcp::acceptor acceptor{ctx, {net::ip::address_v4::any(), mock_port}, ec};
+  REQUIRE(ec.success());
+
+  pool_t pool{ctx};
+  const int first = acquire_and_release(pool, peer);
+  auto server = acceptor.accept();
+  REQUIRE(server.has_value());
+  const int second = acquire_and_release(pool, peer);
+  CHECK(first == second);
+
+  auto stats = on_io_thread(ctx, [&] { return pool.stats(); });
+  CHECK(stats.misses == 1);
+  CHECK(stats.hits == 1);
+  CHECK(on_io_thread(ctx, [&] { return pool.idle_count(peer); }) == 1);
+
+  // A connection closed by the peer isn't handed out again.
+  server.value().close();
+  std::this_thread::sleep_for(10ms);
+  acquire_and_release(pool, peer);
+  stats = on_io_thread(ctx, [&] { return pool.stats(); });
+  CHECK(stats.stale == 1);
+  CHECK(stats.misses == 2);
+  CHECK(acceptor.accept().has_value());
+
+  on_io_thread(ctx, [&] { pool.clear(); });
+  CHECK(on_io_thread(ctx, [&] { return pool.idle_count(); }) == 0);
+}
+
+TEST_CASE("[connection_pool should keep within its limits]",
+          "[epoll_connection_pool.limits]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  const tcp::endpoint peer{net::ip::address_v4::loopback(), mock_port + 1};
+  system_error2::system_code ec{};
+  tcp::acceptor acceptor{ctx, {net::ip::address_v4::any(), mock_port + 1},
+                         ec};
+  REQUIRE(ec.success());
+
+  pool_t pool{ctx, {.max_idle_per_endpoint = 1}};
+  auto [a, b] = stdexec::sync_wait(stdexec::when_all(
+                                       net::async_acquire(pool, peer),
+                                       net::async_acquire(pool, peer)))
+                    .value();
+  const int newest = b.native_handle();
+  on_io_thread(ctx, [&] {
+    pool.release(peer, std::move(a));
+    pool.release(peer, std::move(b));
+  });
+  CHECK(on_io_thread(ctx, [&] { return pool.stats().overflows; }) == 1);
+  CHECK(on_io_thread(ctx, [&] { return pool.idle_count(); }) == 1);
+  CHECK(acquire_and_release(pool, peer) == newest);
+}
+
+TEST_CASE("[connection_pool should evict connections idle for too long]",
+          "[epoll_connection_pool.evict]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  const tcp::endpoint peer{net::ip::address_v4::loopback(), mock_port + 2};
+  system_error2::system_code ec{};
+  tcp::acceptor acceptor{ctx, {net::ip::address_v4::any(), mock_port + 2},
+                         ec};
+  REQUIRE(ec.success());
+
+  pool_t pool{ctx, {.idle_timeout = 1ms, .health_interval = 1ms}};
+  acquire_and_release(pool, peer);
+  std::this_thread::sleep_for(50ms);
+  auto stats = on_io_thread(ctx, [&] { return pool.stats(); });
+  CHECK(stats.evictions == 1);
+  CHECK(on_io_thread(ctx, [&] { return pool.idle_count(); }) == 0);
+  CHECK(pool.checking_ == false);
+}
@@ -17,13 +17,16 @@
 
 #include <chrono>    // NOLINT
 #include <concepts>  // NOLINT
+#include <memory>
 #include <stdexcept>
 #include <thread>  // NOLINT
+#include <vector>
 
 #include "catch2/catch_test_macros.hpp"
 
 #include "epoll/epoll_context.hpp"
 #include "epoll/socket_io_base_op.hpp"
+#include "fast_monotonic_clock.hpp"
 #include "fmt/core.h"
 #include "ip/socket_types.hpp"
 #include "ip/tcp.hpp"
@@ -76,7 +79,6 @@ TEST_CASE(
   CHECK(ctx.interrupter_.read_descriptor() != invalid_socket_fd);
   CHECK(ctx.timers_.empty());
   CHECK(ctx.current_earliest_due_time_ == std::nullopt);
-  CHECK(ctx.processed_remote_queue_submitted_ == false);
   CHECK(ctx.timers_are_dirty_ == false);
   CHECK(ctx.local_queue_.empty());
   CHECK(ctx.remote_queue_.head_ == nullptr);
@@ -114,6 +116,7 @@ TEST_CASE("[default constructor of epoll_context::schedule_at_base_op]",
   epoll_context ctx{};
   monotonic_clock::time_point tp = monotonic_clock::now() + 100ms;
   epoll_context::schedule_at_base_op op{ctx, tp, false};
+  CHECK(op.timer_child_ == nullptr);
   CHECK(op.timer_next_ == nullptr);
   CHECK(op.timer_prev_ == nullptr);
   CHECK(&op.context_ == &ctx);
@@ -207,6 +210,174 @@ TEST_CASE(
   CHECK(ctx.stop_requested());
 }
 
+TEST_CASE("[execute_local() should keep the leftovers in order]",
+          "[epoll_context.execute_local]") {
+  int n = 0;
+  int m = 0;
+  increment_operation opn{n};
+  increment_operation opm{m};
+  epoll_context ctx{};
+  ctx.schedule_local(&opn);
+  ctx.schedule_local(&opm);
+  CHECK(ctx.execute_local(1) == 1);
+  CHECK(n == 1);
+  CHECK(m == 0);
+  CHECK(ctx.local_queue_.front() == &opm);
+  CHECK(ctx.execute_local(1) == 1);
+  CHECK(m == 1);
+  CHECK(ctx.local_queue_.empty());
+}
+
+TEST_CASE("[execute_local() should run completions before continuations]",
+          "[epoll_context.execute_local]") {
+  int n = 0;
+  int m = 0;
+  increment_operation continuation{n};
+  increment_operation completion{m};
+  epoll_context ctx{};
+  auto* old_context =
+      std::exchange(net::__epoll::current_thread_context, &ctx);
+  ctx.set_local_budget(1);
+  ctx.schedule_continuation(&continuation);
+  ctx.schedule_local(&completion);
+  CHECK(ctx.execute_local() == 1);
+  CHECK(m == 1);
+  CHECK(n == 0);
+  CHECK(ctx.execute_local() == 1);
+  CHECK(n == 1);
+  CHECK(ctx.continuation_queue_.empty());
+  net::__epoll::current_thread_context = old_context;
+}
+
+TEST_CASE("[execute_local() should run the queues by priority]",
+          "[epoll_context.execute_local]") {
+  int n = 0;
+  std::vector<int> order;
+  epoll_context ctx{};
+  auto* old_context =
+      std::exchange(net::__epoll::current_thread_context, &ctx);
+  auto record = [&order](int i) {
+    return stdexec::then([&order, i]() noexcept { order.push_back(i); });
+  };
+  using priority = epoll_context::priority;
+  auto low = stdexec::connect(
+      stdexec::schedule(ctx.get_scheduler(priority::low)) | record(3),
+      empty_receiver{});
+  auto normal = stdexec::connect(
+      stdexec::schedule(ctx.get_scheduler()) | record(2), empty_receiver{});
+  auto high = stdexec::connect(
+      stdexec::schedule(ctx.get_scheduler(priority::high)) | record(0),
+      empty_receiver{});
+  increment_operation completion{n};
+  stdexec::start(low);
+  stdexec::start(normal);
+  ctx.schedule_local(&completion);
+  stdexec::start(high);
+  CHECK(ctx.execute_local() == 4);
+  CHECK(order == std::vector<int>{0, 2, 3});
+  CHECK(n == 1);
+  net::__epoll::current_thread_context = old_context;
+}
+
+TEST_CASE("[remote threads should schedule at every priority]",
+          "[epoll_context.schedule]") {
+  epoll_context ctx;
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard guard{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  using priority = epoll_context::priority;
+  for (auto p : {priority::high, priority::normal, priority::low}) {
+    CHECK(stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler(p))));
+  }
+  CHECK(ctx.get_scheduler(priority::high) != ctx.get_scheduler());
+  CHECK(ctx.get_scheduler(priority::normal) == ctx.get_scheduler());
+}
+
+TEST_CASE("[execute_local() should stop once its time budget is used up]",
+          "[epoll_context.execute_local]") {
+  int n = 0;
+  std::vector<std::unique_ptr<increment_operation>> ops;
+  epoll_context ctx{};
+  // Each reading of the clock advances it by 1ms.
+  static monotonic_clock::time_point fake_now{};
+  fake_now = monotonic_clock::now();
+  ctx.set_clock([]() noexcept { return fake_now += 1ms; });
+  ctx.set_local_budget(1000, 1ms);
+  for (int i = 0; i < 40; ++i) {
+    ops.push_back(std::make_unique<increment_operation>(n));
+    ctx.schedule_local(ops.back().get());
+  }
+  // The deadline is checked every 16 operations.
+  CHECK(ctx.execute_local() == 16);
+  CHECK(ctx.execute_local() == 16);
+  CHECK(ctx.execute_local() == 8);
+  CHECK(n == 40);
+}
+
+TEST_CASE("[poll() should execute ready operations without blocking]",
+          "[epoll_context.poll]") {
+  epoll_context ctx{};
+  CHECK(ctx.poll() == 0);
+
+  int n = 0;
+  increment_operation op1{n};
+  increment_operation op2{n};
+  ctx.schedule_remote(&op1);
+  ctx.schedule_remote(&op2);
+  CHECK(ctx.poll() == 2);
+  CHECK(n == 2);
+  CHECK(ctx.is_running() == false);
+}
+
+TEST_CASE("[run_one() should block until one operation is executed]",
+          "[epoll_context.run_one]") {
+  epoll_context ctx{};
+  int n = 0;
+  increment_operation op1{n};
+  increment_operation op2{n};
+  std::jthread producer([&] {
+    std::this_thread::sleep_for(20ms);
+    ctx.schedule_remote(&op1);
+  });
+  CHECK(ctx.run_one() == 1);
+  CHECK(n == 1);
+
+  ctx.schedule_remote(&op2);
+  CHECK(ctx.run_one() == 1);
+  CHECK(n == 2);
+}
+
+TEST_CASE("[run_for() should return after the duration]",
+          "[epoll_context.run_for]") {
+  epoll_context ctx{};
+  auto start = monotonic_clock::now();
+  CHECK(ctx.run_for(30ms) == 0);
+  auto elapsed = monotonic_clock::now() - start;
+  CHECK(elapsed >= 30ms);
+  CHECK(elapsed < 1s);
+
+  // Timers elapsed within the duration are executed.
+  bool fired = false;
+  auto s = exec::schedule_after(ctx.get_scheduler(), 10ms) |
+           stdexec::then([&fired] { fired = true; });
+  stdexec::start_detached(std::move(s));
+  ctx.run_for(100ms);
+  CHECK(fired);
+}
+
+TEST_CASE("[run_until() should return when stop is requested]",
+          "[epoll_context.run_until]") {
+  epoll_context ctx{};
+  std::jthread stopper([&ctx] {
+    std::this_thread::sleep_for(20ms);
+    ctx.request_stop();
+  });
+  auto start = monotonic_clock::now();
+  ctx.run_until(monotonic_clock::now() + 10s);
+  CHECK(monotonic_clock::now() - start < 5s);
+}
+
 TEST_CASE("schedule_remote() should return correct operation",
           "[epoll_context.schedule]") {
   int n = 10;
@@ -274,29 +445,271 @@ TEST_CASE("this function shouldn't block when local_queue_ is not empty",
 }
 
 TEST_CASE(
-    "interrupt() should wakeup context and set "
-    "processed_remote_queue_submitted flag to false",
+    "interrupt() should wakeup context which marked the remote queue inactive "
+    "before blocking",
     "[epoll_context.acquire_completion_queue_items]") {
   epoll_context ctx;
-  CHECK(ctx.processed_remote_queue_submitted_ == false);
-  ctx.processed_remote_queue_submitted_ = true;
   std::jthread io_thread([&ctx] {
     ctx.acquire_completion_queue_items();
-    CHECK(ctx.processed_remote_queue_submitted_ == false);
+    CHECK(ctx.remote_queue_.head_ == ctx.remote_queue_.inactive_value());
   });
   ctx.interrupt();
 }
 
+TEST_CASE(
+    "[remote items should be collected instead of blocking if the queue can't "
+    "be marked inactive]",
+    "[epoll_context.acquire_completion_queue_items]") {
+  int n = 10;
+  increment_operation op{n};
+  epoll_context ctx;
+  ctx.schedule_remote(&op);
+  CHECK(ctx.remote_queue_statistics().interrupt_count == 0);
+  ctx.acquire_completion_queue_items();
+  CHECK(ctx.execute_local() == 1);
+  CHECK(n == 11);
+  CHECK(ctx.remote_queue_statistics().item_count == 1);
+  CHECK(ctx.remote_queue_statistics().saved_interrupt_count == 1);
+}
+
+TEST_CASE("[remote threads should only interrupt a sleeping context]",
+          "[epoll_context.schedule]") {
+  epoll_context ctx;
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard guard{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  for (int i = 0; i < 100; ++i) {
+    CHECK(stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler())));
+  }
+  auto stats = ctx.remote_queue_statistics();
+  CHECK(stats.item_count == 100);
+  CHECK(stats.interrupt_count <= 100);
+  CHECK(stats.item_count ==
+        stats.interrupt_count + stats.saved_interrupt_count);
+}
+
+TEST_CASE("[remote queue lanes should deliver the items of many threads]",
+          "[epoll_context.schedule]") {
+  epoll_context ctx{epoll_context::default_event_batch_size, false, 4};
+  REQUIRE(ctx.remote_lanes_ != nullptr);
+  CHECK(ctx.remote_lanes_->lane_count() == 4);
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard guard{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  {
+    std::vector<std::jthread> producers;
+    for (int t = 0; t < 8; ++t) {
+      producers.emplace_back([&ctx] {
+        for (int i = 0; i < 100; ++i) {
+          (void)stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler()));
+        }
+      });
+    }
+  }
+  auto stats = ctx.remote_queue_statistics();
+  CHECK(stats.item_count == 800);
+  CHECK(stats.interrupt_count <= 800);
+}
+
+TEST_CASE("[epoll_wait batches should be recorded in statistics]",
+          "[epoll_context.acquire_completion_queue_items]") {
+  epoll_context ctx{4};
+  CHECK(ctx.event_batch_statistics().batch_size == 4);
+  empty_op op;
+  ctx.schedule_local(&op);
+  ctx.interrupt();
+  ctx.acquire_completion_queue_items();
+  auto stats = ctx.event_batch_statistics();
+  CHECK(stats.wait_count == 1);
+  CHECK(stats.event_count == 1);
+  CHECK(stats.last_batch_fill == 1);
+  CHECK(stats.full_batch_count == 0);
+  CHECK(stats.batch_size == 4);
+  (void)ctx.local_queue_.pop_front();
+  op.enqueued_ = false;
+}
+
+TEST_CASE("[stats should count the work of the run loop]",
+          "[epoll_context.stats]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard guard{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  for (int i = 0; i < 10; ++i) {
+    CHECK(stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler())));
+  }
+  sync_wait(exec::schedule_after(ctx.get_scheduler(), 1ms));
+
+  auto stats = ctx.stats();
+  CHECK(stats.remote_ops >= 11);
+  CHECK(stats.wait_calls > 0);
+  CHECK(stats.timer_rearms > 0);
+  if constexpr (epoll_context::stats_enabled) {
+    CHECK(stats.loop_iterations > 0);
+    CHECK(stats.local_ops >= stats.remote_ops);
+    CHECK(stats.timer_inserts == 1);
+    CHECK(stats.timer_fires == 1);
+    CHECK(stats.timer_removes == 0);
+  } else {
+    CHECK(stats.loop_iterations == 0);
+    CHECK(stats.local_ops == 0);
+  }
+}
+
+TEST_CASE("[current() should tell the io thread in every translation unit]",
+          "[epoll_context.current]") {
+  epoll_context ctx{};
+  CHECK(epoll_context::current() == nullptr);
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard guard{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  // The same slot is seen by the context and by this test.
+  epoll_context::operation_base misrouted;
+  misrouted.execute_ = [](epoll_context::operation_base*) noexcept {};
+  epoll_context* current = nullptr;
+  stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler()) |
+                     stdexec::then([&] {
+                       current = epoll_context::current();
+                       ctx.schedule_remote(&misrouted);
+                     }));
+  CHECK(current == &ctx);
+  CHECK(epoll_context::current() == nullptr);
+
+  // Only the remote submission of the io thread itself is counted.
+  CHECK(stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler())));
+  CHECK(ctx.stats().io_thread_remote_ops ==
+        (epoll_context::stats_enabled ? 1 : 0));
+}
+
+TEST_CASE("[adaptive batch should grow when full and shrink when idle]",
+          "[epoll_context.acquire_completion_queue_items]") {
+  epoll_context ctx{1024, true};
+  const std::size_t min = epoll_context::min_event_batch_size;
+  CHECK(ctx.event_batch_statistics().batch_size == min);
+
+  ctx.update_event_batch(min);
+  CHECK(ctx.event_batch_statistics().batch_size == min * 2);
+  CHECK(ctx.event_batch_statistics().full_batch_count == 1);
+  for (int i = 0; i < 10; ++i) {
+    ctx.update_event_batch(ctx.event_batch_statistics().batch_size);
+  }
+  CHECK(ctx.event_batch_statistics().batch_size == 1024);
+
+  // Half full keeps the size.
+  ctx.update_event_batch(512);
+  CHECK(ctx.event_batch_statistics().batch_size == 1024);
+  for (int i = 0; i < 10; ++i) {
+    ctx.update_event_batch(1);
+  }
+  CHECK(ctx.event_batch_statistics().batch_size == min);
+  CHECK(ctx.event_batch_statistics().wait_count == 22);
+}
+
+TEST_CASE("[spinning should return when the remote queue is not empty]",
+          "[epoll_context.acquire_completion_queue_items]") {
+  epoll_context ctx;
+
+  // Nothing arrives, the budget runs out.
+  ctx.set_spin_budget(std::chrono::microseconds(100));
+  while (ctx.wait_events(0) > 0) {
+  }
+  CHECK(ctx.spin_wait_events() == -1);
+
+  // A remote item ends spinning without blocking.
+  ctx.set_spin_budget(std::chrono::seconds(10));
+  empty_op op;
+  (void)ctx.remote_queue_.enqueue(&op);
+  CHECK(ctx.spin_wait_events() == 0);
+  (void)ctx.remote_queue_.dequeue_all();
+}
+
+TEST_CASE("[spin budget should keep remote scheduling working]",
+          "[epoll_context.run]") {
+  epoll_context ctx;
+  ctx.set_spin_budget(std::chrono::microseconds(200));
+  ctx.set_socket_busy_poll(std::chrono::microseconds(50));
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard guard{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  for (int i = 0; i < 1000; ++i) {
+    CHECK(stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler())));
+  }
+  stdexec::sync_wait(exec::schedule_after(ctx.get_scheduler(), 1ms));
+}
+
 TEST_CASE("timer event should wakeup context",
           "[epoll_context.acquire_completion_queue_items]") {
   epoll_context ctx;
-  CHECK(ctx.processed_remote_queue_submitted_ == false);
-  ctx.processed_remote_queue_submitted_ = true;
   std::jthread io_thread([&ctx] {
     ctx.acquire_completion_queue_items();
-    CHECK(ctx.processed_remote_queue_submitted_ == false);
+    CHECK(ctx.timers_are_dirty_);
   });
-  ctx.interrupt();
+  ctx.set_timer(monotonic_clock::now() + 10ms);
+}
+
+TEST_CASE("[descriptor is registered to epoll once and released on close]",
+          "[epoll_context.descriptor_state]") {
+  epoll_context ctx;
+  auto* old_context =
+      std::exchange(net::__epoll::current_thread_context, &ctx);
+  net::ip::udp::socket socket{ctx};
+  CHECK(socket.open(net::ip::udp::v4()).success());
+
+  system_error2::system_code ec{system_error2::errc::success};
+  auto* state = ctx.register_descriptor(socket.native_handle(),
+                                        socket.descriptor_data(), ec);
+  REQUIRE(state != nullptr);
+  CHECK(ec.success());
+  CHECK(socket.descriptor_data() == state);
+  CHECK(state->descriptor_ == socket.native_handle());
+
+  // The descriptor is already in epoll, so registering it again just returns
+  // the attached state.
+  epoll_event event = {};
+  CHECK(::epoll_ctl(ctx.epoll_fd_, EPOLL_CTL_ADD, socket.native_handle(),
+                    &event) == -1);
+  CHECK(errno == EEXIST);
+  CHECK(ctx.register_descriptor(socket.native_handle(),
+                                socket.descriptor_data(), ec) == state);
+
+  // Closing the socket recycles the state.
+  CHECK(socket.close().success());
+  CHECK(socket.descriptor_data() == nullptr);
+  CHECK(ctx.free_descriptor_states_ == state);
+  CHECK(state->descriptor_ == -1);
+  net::__epoll::current_thread_context = old_context;
+}
+
+TEST_CASE("[epoll event should wakeup the operation parked on the slot]",
+          "[epoll_context.descriptor_state]") {
+  epoll_context ctx;
+  auto* old_context =
+      std::exchange(net::__epoll::current_thread_context, &ctx);
+  net::ip::udp::socket socket{ctx};
+  CHECK(socket.open(net::ip::udp::v4()).success());
+
+  system_error2::system_code ec{system_error2::errc::success};
+  auto* state = ctx.register_descriptor(socket.native_handle(),
+                                        socket.descriptor_data(), ec);
+  REQUIRE(state != nullptr);
+
+  // A fresh udp socket is writable, but nobody is waiting for reading.
+  int cnt = 0;
+  epoll_context::completion_op op{};
+  op.execute_ = [](epoll_context::operation_base*) noexcept {};
+  state->park(epoll_context::descriptor_state::write_slot, &op);
+  ctx.acquire_completion_queue_items();
+  CHECK(state->ops_[epoll_context::descriptor_state::write_slot] == nullptr);
+  CHECK(ctx.local_queue_.front() == &op);
+  cnt += ctx.execute_local();
+  CHECK(cnt == 1);
+  net::__epoll::current_thread_context = old_context;
 }
 
 TEST_CASE(
@@ -333,7 +746,6 @@ TEST_CASE("remove timers from heap", "[epoll_context.timers]") {
   ctx.timers_.insert(&op);
   ctx.timers_.insert(&op2);
   CHECK(ctx.timers_.top() == &op);
-  CHECK(ctx.timers_.top()->timer_next_ == &op2);
   ctx.remove_timer(&op);
   CHECK(ctx.timers_.empty() == false);
   CHECK(ctx.timers_.top() == &op2);
@@ -394,8 +806,9 @@ TEST_CASE(
         10 * monotonic_clock::ratio::den);
 
   // 5. Timers still in the heap.
-  CHECK(ctx.timers_.top() == &op);
-  CHECK(ctx.timers_.top()->timer_next_ == &op2);
+  CHECK(ctx.timers_.pop() == &op);
+  CHECK(ctx.timers_.pop() == &op2);
+  CHECK(ctx.timers_.empty());
 }
 
 TEST_CASE(
@@ -422,8 +835,6 @@ TEST_CASE(
   // 1. the order of timer in the timer heap has been adjusted.
   CHECK(ctx.timers_.empty() == false);
   CHECK(ctx.timers_.top() == &op);
-  CHECK(ctx.timers_.top()->timer_next_ == &old_op);
-  CHECK(ctx.timers_.top()->timer_next_->timer_next_ == &op2);
 
   // 2. current_earliest_due_timer_ should have value since there is an active
   // timer.
@@ -441,9 +852,10 @@ TEST_CASE(
 
   // 5. Timers still in the heap.
   CHECK(ctx.timers_.empty() == false);
-  CHECK(ctx.timers_.top() == &op);
-  CHECK(ctx.timers_.top()->timer_next_ == &old_op);
-  CHECK(ctx.timers_.top()->timer_next_->timer_next_ == &op2);
+  CHECK(ctx.timers_.pop() == &op);
+  CHECK(ctx.timers_.pop() == &old_op);
+  CHECK(ctx.timers_.pop() == &op2);
+  CHECK(ctx.timers_.empty());
 }
 
 TEST_CASE(
@@ -470,8 +882,6 @@ TEST_CASE(
   // 1. Added two timers to the heap.
   CHECK(ctx.timers_.empty() == false);
   CHECK(ctx.timers_.top() == &old_op);
-  CHECK(ctx.timers_.top()->timer_next_ == &op);
-  CHECK(ctx.timers_.top()->timer_next_->timer_next_ == &op2);
 
   // 2. current_earliest_due_timer_ should have value since there is an active
   // timer.
@@ -489,9 +899,67 @@ TEST_CASE(
 
   // 5. Timers still in the heap.
   CHECK(ctx.timers_.empty() == false);
-  CHECK(ctx.timers_.top() == &old_op);
-  CHECK(ctx.timers_.top()->timer_next_ == &op);
-  CHECK(ctx.timers_.top()->timer_next_->timer_next_ == &op2);
+  CHECK(ctx.timers_.pop() == &old_op);
+  CHECK(ctx.timers_.pop() == &op);
+  CHECK(ctx.timers_.pop() == &op2);
+  CHECK(ctx.timers_.empty());
+}
+
+TEST_CASE("[timer slack should round deadlines and suppress re-arms]",
+          "[epoll_context.timers]") {
+  epoll_context ctx;
+  ctx.set_timer_slack(1ms);
+  monotonic_clock::time_point now = monotonic_clock::now();
+  auto base = monotonic_clock::time_point::from_seconds_and_nanoseconds(
+      now.seconds() + 10, 0);
+
+  epoll_context::schedule_at_base_op op{ctx, base + 700us, false};
+  ctx.timers_.insert(&op);
+  ctx.timers_are_dirty_ = true;
+  ctx.update_timers();
+  CHECK(ctx.timer_statistics().rearm_count == 1);
+  CHECK(*ctx.current_earliest_due_time_ == base + 1ms);
+
+  // In the same slack window, no re-arm.
+  epoll_context::schedule_at_base_op op2{ctx, base + 300us, false};
+  ctx.timers_.insert(&op2);
+  ctx.timers_are_dirty_ = true;
+  ctx.update_timers();
+  CHECK(ctx.timer_statistics().rearm_count == 1);
+  CHECK(*ctx.current_earliest_due_time_ == base + 1ms);
+
+  // An earlier window needs one.
+  epoll_context::schedule_at_base_op op3{ctx, base - 300us, false};
+  ctx.timers_.insert(&op3);
+  ctx.timers_are_dirty_ = true;
+  ctx.update_timers();
+  CHECK(ctx.timer_statistics().rearm_count == 2);
+  CHECK(*ctx.current_earliest_due_time_ == base);
+
+  // Deadlines which don't fit in nanoseconds are left alone.
+  CHECK(ctx.apply_timer_slack(monotonic_clock::time_point::max()) ==
+        monotonic_clock::time_point::max());
+
+  ctx.timers_.remove(&op);
+  ctx.timers_.remove(&op2);
+  ctx.timers_.remove(&op3);
+}
+
+TEST_CASE("[wait_timeout mode should fire timers without the timerfd]",
+          "[epoll_context.timers]") {
+  epoll_context ctx;
+  ctx.set_timer_mode(epoll_context::timer_mode::wait_timeout);
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  for (int i = 0; i < 3; ++i) {
+    const auto start = monotonic_clock::now();
+    sync_wait(exec::schedule_after(ctx.get_scheduler(), 20ms));
+    CHECK(monotonic_clock::now() - start >= 20ms);
+  }
+  CHECK(ctx.timer_statistics().rearm_count == 0);
 }
 
 TEST_CASE("[default constructor of schedule_env]",
@@ -664,6 +1132,49 @@ TEST_CASE("`schedule_after` 0s", "epoll_context.scheduler") {
   stdexec::sync_wait(std::move(s));
 }
 
+TEST_CASE(
+    "CPO Example: `schedule_after_coarse` should schedule operation to queue "
+    "no earlier than a relative time",
+    "epoll_context.scheduler") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  auto start = monotonic_clock::now();
+  auto s = net::schedule_after_coarse(ctx.get_scheduler(), 100ms)  //
+           | stdexec::then([&start] {
+               int elapsed = (monotonic_clock::now() - start).count();
+               // The timer may be one tick of the timing wheel late.
+               CHECK(elapsed <= 0.115 * monotonic_clock::ratio::den);
+               CHECK(elapsed >= 0.1 * monotonic_clock::ratio::den);
+             });
+  stdexec::sync_wait(std::move(s));
+  CHECK(ctx.coarse_timers_.empty());
+}
+
+TEST_CASE("`schedule_after_coarse` can be cancelled",
+          "epoll_context.scheduler") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  auto start = monotonic_clock::now();
+  auto s = exec::when_any(net::schedule_after_coarse(ctx.get_scheduler(), 60s),
+                          exec::schedule_after(ctx.get_scheduler(), 10ms));
+  stdexec::sync_wait(std::move(s));
+  CHECK((monotonic_clock::now() - start).count() <
+        monotonic_clock::ratio::den);
+
+  // The cancelled coarse timer has been removed from the timing wheel.
+  auto check = stdexec::schedule(ctx.get_scheduler())  //
+               | stdexec::then([&ctx] { CHECK(ctx.coarse_timers_.empty()); });
+  stdexec::sync_wait(std::move(check));
+}
+
 TEST_CASE("`schedule_at 10000-times` ", "epoll_context.scheduler") {
   epoll_context ctx{};
   std::jthread io_thread([&ctx] { ctx.run(); });
@@ -815,6 +1326,133 @@ TEST_CASE(
   }
 }
 
+TEST_CASE("[inline scheduler should complete inline on the io thread]",
+          "[epoll_context.scheduler]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  CHECK(ctx.get_inline_scheduler() != ctx.get_scheduler());
+  CHECK(ctx.get_inline_scheduler() == ctx.get_inline_scheduler());
+
+  bool inline_ran = false;
+  bool queued_ran = false;
+  bool deep_ran = false;
+  bool deep_ran_inline = true;
+  sync_wait(schedule(ctx.get_scheduler()) | then([&] {
+              start_detached(schedule(ctx.get_inline_scheduler()) |
+                             then([&] { inline_ran = true; }));
+              CHECK(inline_ran);
+              CHECK(ctx.inline_depth_ == 0);
+
+              start_detached(schedule(ctx.get_scheduler()) |
+                             then([&] { queued_ran = true; }));
+              CHECK(!queued_ran);
+
+              // Too deep to complete inline.
+              ctx.inline_depth_ = epoll_context::max_inline_depth;
+              start_detached(schedule(ctx.get_inline_scheduler()) |
+                             then([&] { deep_ran = true; }));
+              deep_ran_inline = deep_ran;
+              ctx.inline_depth_ = 0;
+            }));
+  CHECK(!deep_ran_inline);
+  sync_wait(schedule(ctx.get_scheduler()));
+  CHECK(queued_ran);
+  CHECK(deep_ran);
+}
+
+TEST_CASE("[inline scheduler should go through the queue from remote threads]",
+          "[epoll_context.scheduler]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  auto id = std::this_thread::get_id();
+  sync_wait(schedule(ctx.get_inline_scheduler()) | then([id] {
+              CHECK(std::this_thread::get_id() != id);
+            }));
+}
+
+TEST_CASE("[loop_now should be cached once per loop iteration]",
+          "[epoll_context.timers]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  auto sched = ctx.get_scheduler();
+
+  // Remote threads read the clock.
+  const auto before = monotonic_clock::now();
+  CHECK(net::loop_now(sched) >= before);
+
+  // The io thread sees the same time during one iteration.
+  sync_wait(schedule(sched) | then([&ctx, sched] {
+              const auto cached = net::loop_now(sched);
+              std::this_thread::sleep_for(10ms);
+              CHECK(net::loop_now(sched) == cached);
+              CHECK(ctx.loop_now() == cached);
+              CHECK(monotonic_clock::now() > cached);
+            }));
+
+  // And a later time during the next one.
+  monotonic_clock::time_point first, second;
+  sync_wait(schedule(sched) | then([&first, sched] {
+              first = net::loop_now(sched);
+            }));
+  std::this_thread::sleep_for(10ms);
+  sync_wait(schedule(sched) | then([&second, sched] {
+              second = net::loop_now(sched);
+            }));
+  CHECK(second > first);
+}
+
+TEST_CASE("[set_clock should replace the time source of the context]",
+          "[epoll_context.timers]") {
+  epoll_context ctx{};
+  ctx.set_clock(&fast_monotonic_clock::now);
+  CHECK(ctx.now() >= monotonic_clock::now() - 1ms);
+
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  const auto start = monotonic_clock::now();
+  sync_wait(exec::schedule_after(ctx.get_scheduler(), 50ms));
+  CHECK(monotonic_clock::now() - start >= 50ms);
+}
+
+TEST_CASE("[epoll_context should reserve its pools as options tell]",
+          "[epoll_context.options]") {
+  epoll_context ctx{epoll_context::options{.event_batch_size = 64,
+                                           .expected_connections = 100,
+                                           .operations_per_class = 8,
+                                           .recv_block_size = 4096,
+                                           .recv_blocks = 128,
+                                           .prefault = true}};
+  CHECK(ctx.events_.size() == 64);
+  CHECK(ctx.descriptor_states_.size() == 100);
+  CHECK(ctx.operation_pool().cached_count() ==
+        8 * net::size_class_pool::class_count);
+  CHECK(ctx.recv_buffer_pool().block_size() == 4096);
+  CHECK(ctx.recv_buffer_pool().block_count() >= 128);
+
+  // Registering the expected connections takes the reserved states.
+  auto* old_context =
+      std::exchange(net::__epoll::current_thread_context, &ctx);
+  net::ip::udp::socket socket{ctx};
+  CHECK(socket.open(net::ip::udp::v4()).success());
+  system_error2::system_code ec{system_error2::errc::success};
+  CHECK(ctx.register_descriptor(socket.native_handle(),
+                                socket.descriptor_data(), ec) != nullptr);
+  CHECK(ctx.descriptor_states_.size() == 100);
+  CHECK(socket.close().success());
+  net::__epoll::current_thread_context = old_context;
+}
+
 TEST_CASE("CPO example: now should return current time point",
           "epoll_context.timers") {
   epoll_context ctx{};
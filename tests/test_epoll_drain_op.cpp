@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+
+#include "buffer.hpp"
+#include "epoll/drain_op.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_accept_op.hpp"
+#include "epoll/socket_recv_some_op.hpp"
+#include "ip/tcp.hpp"
+#include "stdexec.hpp"
+#include "stdexec/execution.hpp"
+#include "tcp_connection.hpp"
+
+using namespace stdexec;       // NOLINT
+using namespace net;           // NOLINT
+using namespace net::__epoll;  // NOLINT
+using namespace std;           // NOLINT
+using namespace exec;          // NOLINT
+
+constexpr port_type mock_port = 12712;
+
+TEST_CASE("[work_started() and work_finished() should count the work]",
+          "[epoll_drain_op.work]") {
+  epoll_context ctx{};
+  CHECK(ctx.outstanding_work() == 0);
+  ctx.work_started();
+  ctx.work_started();
+  CHECK(ctx.outstanding_work() == 2);
+  ctx.work_finished();
+  ctx.work_finished();
+  CHECK(ctx.outstanding_work() == 0);
+  CHECK_FALSE(ctx.draining());
+}
+
+TEST_CASE("[drain should complete at once and return from run() when idle]",
+          "[epoll_drain_op]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  const auto start = chrono::steady_clock::now();
+  sync_wait(async_drain(ctx, 10s));
+  io_thread.join();
+  CHECK(chrono::steady_clock::now() - start < 5s);
+  CHECK_FALSE(ctx.draining());
+}
+
+TEST_CASE("[drain should wait for the work counted by work_started()]",
+          "[epoll_drain_op]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  ctx.work_started();
+  std::atomic_bool finished{false};
+  std::jthread worker([&] {
+    std::this_thread::sleep_for(50ms);
+    finished = true;
+    ctx.work_finished();
+  });
+  const auto start = chrono::steady_clock::now();
+  sync_wait(async_drain(ctx, 10s));
+  CHECK(finished);
+  CHECK(chrono::steady_clock::now() - start < 5s);
+  io_thread.join();
+}
+
+TEST_CASE("[drain should let parked operations complete before the deadline]",
+          "[epoll_drain_op]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  connection conn{ctx, mock_port};
+  ip::tcp::socket& client = conn.client;
+  ip::tcp::socket& server = conn.server;
+
+  // The peer answers once the drain has started.
+  std::jthread drainer([&] {
+    std::this_thread::sleep_for(50ms);
+    std::jthread sender([&] {
+      std::this_thread::sleep_for(50ms);
+      CHECK(::send(client.native_handle(), "ping", 4, 0) == 4);
+    });
+    sync_wait(async_drain(ctx, 10s));
+  });
+  char buf[16];
+  size_t received = 0;
+  sync_wait(async_recv_some(server, buffer(buf)) |
+            then([&](size_t n) noexcept { received = n; }) |
+            upon_error([](error_code&&) noexcept { CHECK(false); }) |
+            upon_stopped([]() noexcept { CHECK(false); }));
+  CHECK(received == 4);
+  drainer.join();
+  io_thread.join();
+}
+
+TEST_CASE("[drain should cancel accepts at once and the rest at the deadline]",
+          "[epoll_drain_op]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  system_error2::system_code ec{system_error2::errc::success};
+  ip::tcp::acceptor acceptor{
+      ctx, {ip::address_v4::loopback(), mock_port + 1}, ec, true};
+  REQUIRE(ec.success());
+  connection conn{ctx, acceptor, mock_port + 1};
+  ip::tcp::socket& server = conn.server;
+  REQUIRE(acceptor.set_non_blocking(true).success());
+
+  // Nothing is sent and nobody connects, so both operations stay parked.
+  const auto start = chrono::steady_clock::now();
+  chrono::steady_clock::time_point drain_started;
+  std::jthread drainer([&] {
+    std::this_thread::sleep_for(50ms);
+    drain_started = chrono::steady_clock::now();
+    sync_wait(async_drain(ctx, 300ms));
+  });
+  char buf[16];
+  chrono::steady_clock::duration recv_stopped{};
+  chrono::steady_clock::duration accept_stopped{};
+  sync_wait(when_all(
+      async_recv_some(server, buffer(buf)) |
+          then([](size_t) noexcept { CHECK(false); }) |
+          upon_error([](error_code&&) noexcept { CHECK(false); }) |
+          upon_stopped([&]() noexcept {
+            recv_stopped = chrono::steady_clock::now() - start;
+          }),
+      async_accept(acceptor) |
+          then([](ip::tcp::socket&&) noexcept { CHECK(false); }) |
+          upon_error([](error_code&&) noexcept { CHECK(false); }) |
+          upon_stopped([&]() noexcept {
+            accept_stopped = chrono::steady_clock::now() - start;
+          })));
+  drainer.join();
+  io_thread.join();
+  const auto drain_offset = drain_started - start;
+  CHECK(accept_stopped < drain_offset + 250ms);
+  CHECK(recv_stopped >= drain_offset + 300ms);
+  CHECK_FALSE(ctx.draining());
+}
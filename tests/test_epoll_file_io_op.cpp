@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <array>
+#include <future>        // NOLINT
+#include <string>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+#include <tuple>
+
+#include "catch2/catch_test_macros.hpp"
+#include "stdexec.hpp"
+
+#include "buffer.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/file_io_op.hpp"
+#include "file_io_pool.hpp"
+
+using net::epoll_context;
+
+TEST_CASE("[file_io sender should satisfy stdexec::sender]",
+          "[epoll_file_io_op.concept]") {
+  using net::__epoll::file_io_sender;
+  CHECK(stdexec::sender<stdexec::__t<file_io_sender<net::mutable_buffer,
+                                                    false>>>);
+  CHECK(stdexec::sender<stdexec::__t<file_io_sender<net::const_buffer,
+                                                    true>>>);
+}
+
+TEST_CASE("[write then read a file at offsets on the io thread]",
+          "[epoll_file_io_op]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  FILE* file = ::tmpfile();
+  REQUIRE(file != nullptr);
+  exec::scope_guard close_file{[file]() noexcept { ::fclose(file); }};
+  const int fd = ::fileno(file);
+
+  std::string head = "hello ";
+  std::string tail = "file";
+  std::array<net::const_buffer, 2> bufs{net::buffer(head), net::buffer(tail)};
+  std::thread::id completed_on;
+  auto [written] =
+      stdexec::sync_wait(
+          net::async_write_file_at(ctx, fd, 4, bufs) |
+          stdexec::then([&completed_on](std::size_t n) noexcept {
+            completed_on = std::this_thread::get_id();
+            return n;
+          }))
+          .value();
+  CHECK(written == 10);
+  CHECK(completed_on == io_thread.get_id());
+  // The file position is left alone.
+  CHECK(::lseek(fd, 0, SEEK_CUR) == 0);
+
+  std::string read(8, ' ');
+  auto [n] = stdexec::sync_wait(net::async_read_file_at(ctx, fd, 6,
+                                                         net::buffer(read)))
+                 .value();
+  CHECK(n == 8);
+  CHECK(read == "llo file");
+
+  // Reads are short at the end of the file, and empty past it.
+  std::tie(n) = stdexec::sync_wait(net::async_read_file_at(ctx, fd, 10,
+                                                            net::buffer(read)))
+                    .value();
+  CHECK(n == 4);
+  CHECK(read.substr(0, 4) == "file");
+  std::tie(n) = stdexec::sync_wait(net::async_read_file_at(ctx, fd, 100,
+                                                            net::buffer(read)))
+                    .value();
+  CHECK(n == 0);
+}
+
+TEST_CASE("[file_io should report the errors of the call]",
+          "[epoll_file_io_op]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  std::string buf(4, ' ');
+  std::error_code ec;
+  stdexec::sync_wait(
+      net::async_read_file_at(ctx, -1, 0, net::buffer(buf)) |
+      stdexec::then([](std::size_t) noexcept { CHECK(false); }) |
+      stdexec::upon_error([&ec](std::error_code&& e) noexcept { ec = e; }));
+  CHECK(ec == std::errc::bad_file_descriptor);
+}
+
+TEST_CASE("[a busy disk should not stall the context]",
+          "[epoll_file_io_op]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  FILE* file = ::tmpfile();
+  REQUIRE(file != nullptr);
+  exec::scope_guard close_file{[file]() noexcept { ::fclose(file); }};
+
+  // Occupy the only worker, as a slow disk would.
+  net::file_io_pool pool{1};
+  std::promise<void> release;
+  struct blocking_job : net::resolver_pool::job {
+    std::shared_future<void> released;
+  } job;
+  job.released = release.get_future().share();
+  job.run_ = [](net::resolver_pool::job* j) noexcept {
+    static_cast<blocking_job*>(j)->released.wait();
+  };
+  pool.submit(&job);
+
+  std::string data = "log line\n";
+  std::size_t written = 0;
+  std::jthread writer([&] {
+    stdexec::sync_wait(
+        net::async_write_file_at(ctx, pool, ::fileno(file), 0,
+                                 net::buffer(data)) |
+        stdexec::then([&](std::size_t n) noexcept { written = n; }));
+  });
+
+  // The context keeps serving other operations meanwhile.
+  for (int i = 0; i < 10; ++i) {
+    CHECK(stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler())));
+  }
+  CHECK(written == 0);
+
+  release.set_value();
+  writer.join();
+  CHECK(written == data.size());
+}
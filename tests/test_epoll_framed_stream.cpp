@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <array>
+#include <chrono>        // NOLINT
+#include <cstdint>
+#include <span>
+#include <string>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "buffer.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/framed_stream.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/tcp.hpp"
+#include "tcp_connection.hpp"
+
+using net::epoll_context;
+using namespace std::chrono_literals;  // NOLINT
+
+constexpr port_type mock_port = 12380;
+
+namespace {
+// Append a frame to `wire`.
+void append_frame(std::string& wire, const std::string& payload) {
+  auto size = static_cast<std::uint32_t>(payload.size());
+  wire.push_back(static_cast<char>(size >> 24));
+  wire.push_back(static_cast<char>(size >> 16));
+  wire.push_back(static_cast<char>(size >> 8));
+  wire.push_back(static_cast<char>(size));
+  wire += payload;
+}
+
+std::vector<std::string> read_frames(net::framed_stream<net::ip::tcp>& stream,
+                                     std::error_code* error = nullptr) {
+  std::vector<std::string> frames;
+  auto collect = [&frames](std::span<const net::const_buffer> batch) noexcept {
+    for (const auto& frame : batch) {
+      frames.emplace_back(static_cast<const char*>(frame.data()), frame.size());
+    }
+  };
+  stdexec::sync_wait(
+      net::async_read_frames(stream) | stdexec::then(collect) |
+      stdexec::upon_error([error](std::error_code&& ec) noexcept {
+        CHECK(error != nullptr);
+        if (error) {
+          *error = ec;
+        }
+      }));
+  return frames;
+}
+}  // namespace
+
+TEST_CASE("[async_read_frames should yield every complete frame at once]",
+          "[epoll_framed_stream]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  connection conn{ctx, mock_port};
+  net::framed_stream<net::ip::tcp> stream{conn.server};
+
+  std::string wire;
+  append_frame(wire, "one");
+  append_frame(wire, "");
+  append_frame(wire, "three");
+  append_frame(wire, "four");
+  // Everything but the last two bytes of the last frame.
+  CHECK(conn.client.sync_send(wire.data(), wire.size() - 2, 0).has_value());
+  std::this_thread::sleep_for(20ms);
+
+  CHECK(read_frames(stream) == std::vector<std::string>{"one", "", "three"});
+  CHECK(stream.buffered() == 6);
+
+  CHECK(conn.client.sync_send(wire.data() + wire.size() - 2, 2, 0).has_value());
+  CHECK(read_frames(stream) == std::vector<std::string>{"four"});
+  CHECK(stream.buffered() == 0);
+}
+
+TEST_CASE("[async_read_frames should fail on an oversized frame]",
+          "[epoll_framed_stream]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  connection conn{ctx, mock_port + 1};
+  net::framed_stream<net::ip::tcp> stream{conn.server, 8};
+
+  std::string wire;
+  append_frame(wire, "way too long");
+  CHECK(conn.client.sync_send(wire.data(), wire.size(), 0).has_value());
+
+  std::error_code error;
+  CHECK(read_frames(stream, &error).empty());
+  CHECK(error == std::make_error_code(std::errc::message_size));
+}
+
+TEST_CASE("[async_write_frames should send headers and payloads together]",
+          "[epoll_framed_stream]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  connection conn{ctx, mock_port + 2};
+  net::framed_stream<net::ip::tcp> stream{conn.server};
+
+  std::string first = "hello";
+  std::string second = "abc";
+  std::array<net::const_buffer, 2> payloads{net::buffer(first),
+                                            net::buffer(second)};
+  std::size_t sent = 0;
+  stdexec::sync_wait(
+      net::async_write_frames(stream, payloads) |
+      stdexec::then([&sent](std::size_t n) noexcept { sent = n; }) |
+      stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  CHECK(sent == 16);
+
+  std::string expected;
+  append_frame(expected, first);
+  append_frame(expected, second);
+  std::string received(expected.size(), '\0');
+  std::size_t offset = 0;
+  while (offset < received.size()) {
+    auto res = conn.client.sync_recv(received.data() + offset,
+                                     received.size() - offset, 0);
+    REQUIRE(res.has_value());
+    offset += res.value();
+  }
+  CHECK(received == expected);
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <chrono>  // NOLINT
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "connection_table.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/idle_sweeper.hpp"
+
+using namespace std::chrono_literals;  // NOLINT
+
+namespace {
+struct connection : net::idle_tracker {
+  explicit connection(net::epoll_context& ctx) : net::idle_tracker(ctx) {}
+
+  int id = 0;
+};
+}  // namespace
+
+TEST_CASE("[idle_sweeper should hand idle connections to the handler]",
+          "[idle_sweeper]") {
+  net::epoll_context ctx;
+  net::connection_table<connection> table;
+  for (int i = 0; i < 10; ++i) {
+    table.emplace(ctx).second.id = i;
+  }
+
+  std::vector<int> idle;
+  auto handler = [&](auto, connection& c) noexcept { idle.push_back(c.id); };
+  net::idle_sweeper<connection, decltype(handler)> sweeper{ctx, table, 20ms,
+                                                           handler, 3};
+  sweeper.start();
+  CHECK(sweeper.is_running());
+  ctx.run_for(30ms);
+
+  // Every connection is found once and counts as active afterwards.
+  CHECK(idle.size() == 10);
+  CHECK(sweeper.idle_count() == 10);
+  sweeper.stop();
+  CHECK(!sweeper.is_running());
+}
+
+TEST_CASE("[idle_sweeper should skip connections with recent activity]",
+          "[idle_sweeper]") {
+  net::epoll_context ctx;
+  net::connection_table<connection> table;
+  auto [active, a] = table.emplace(ctx);
+  auto [quiet, q] = table.emplace(ctx);
+
+  int idle = 0;
+  auto handler = [&](auto h, connection&) noexcept {
+    CHECK(h == quiet);
+    ++idle;
+  };
+  net::idle_sweeper<connection, decltype(handler)> sweeper{ctx, table, 40ms,
+                                                           handler};
+  sweeper.start();
+  auto deadline = std::chrono::steady_clock::now() + 60ms;
+  while (std::chrono::steady_clock::now() < deadline) {
+    ctx.run_for(5ms);
+    a.touch(ctx);
+  }
+  CHECK(idle == 1);
+}
+
+TEST_CASE("[idle_sweeper should allow the handler to erase connections]",
+          "[idle_sweeper]") {
+  net::epoll_context ctx;
+  net::connection_table<connection> table;
+  for (int i = 0; i < 100; ++i) {
+    table.emplace(ctx);
+  }
+
+  auto handler = [&](auto h, connection&) noexcept { table.erase(h); };
+  net::idle_sweeper<connection, decltype(handler)> sweeper{ctx, table, 10ms,
+                                                           handler, 16};
+  sweeper.start();
+  ctx.run_for(40ms);
+  CHECK(table.empty());
+  CHECK(sweeper.idle_count() == 100);
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "stdexec.hpp"
+
+#include "epoll/epoll_context.hpp"
+#include "epoll/loop_watchdog.hpp"
+
+using net::epoll_context;
+using net::loop_watchdog;
+using namespace std::chrono_literals;  // NOLINT
+
+TEST_CASE("[heartbeat should stay idle unless it's enabled]",
+          "[epoll_loop_watchdog.heartbeat]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  bool busy = true;
+  stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler()) |
+                     stdexec::then([&] { busy = ctx.read_heartbeat().busy; }));
+  CHECK(!busy);
+}
+
+TEST_CASE("[loop_watchdog should report an iteration blocking the io thread]",
+          "[epoll_loop_watchdog.stall]") {
+  epoll_context ctx{};
+  std::mutex mutex;
+  std::atomic<int> reports = 0;
+  loop_watchdog::stall last{};
+  loop_watchdog watchdog{20ms, [&](const loop_watchdog::stall& s) {
+                           std::lock_guard lock{mutex};
+                           last = s;
+                           reports.fetch_add(1);
+                         }};
+  watchdog.watch(ctx);
+  watchdog.start();
+
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  // An idle loop doesn't stall.
+  std::this_thread::sleep_for(60ms);
+  CHECK(watchdog.stall_count() == 0);
+
+  bool busy = false;
+  stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler()) |
+                     stdexec::then([&] {
+                       busy = ctx.read_heartbeat().busy;
+                       std::this_thread::sleep_for(100ms);
+                     }));
+  CHECK(busy);
+
+  // The stall is reported once, while it lasts.
+  CHECK(watchdog.stall_count() == 1);
+  CHECK(reports.load() == 1);
+  {
+    std::lock_guard lock{mutex};
+    CHECK(last.context == &ctx);
+    CHECK(last.duration >= 20ms);
+    CHECK(last.execute != nullptr);
+    CHECK(!loop_watchdog::describe(last.execute).empty());
+  }
+
+  watchdog.stop();
+  CHECK(watchdog.lag().count() > 0);
+  CHECK(watchdog.lag().percentile(100.0) >= 20ms);
+}
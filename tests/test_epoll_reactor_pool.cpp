@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <sched.h>
+
+#include <chrono>        // NOLINT
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "epoll/epoll_context.hpp"
+#include "epoll/reactor_pool.hpp"
+#include "epoll/socket_accept_op.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/tcp.hpp"
+
+using net::reactor_pool;
+using namespace std::chrono_literals;  // NOLINT
+
+constexpr port_type mock_port = 12320;
+
+TEST_CASE("[constructor]", "[epoll_reactor_pool.ctor]") {
+  reactor_pool pool{3};
+  CHECK(pool.size() == 3);
+  CHECK(&pool.context(0) != &pool.context(1));
+  CHECK(pool.threads_.empty());
+
+  reactor_pool zero{0};
+  CHECK(zero.size() == 1);
+}
+
+TEST_CASE("[run() should drive every context on its own thread]",
+          "[epoll_reactor_pool.run]") {
+  reactor_pool pool{2};
+  pool.run(false);
+  CHECK(pool.threads_.size() == 2);
+  CHECK_THROWS_AS(pool.run(false), std::runtime_error);
+
+  // Round-robin scheduling alternates between contexts.
+  auto thread_of = [](auto sched) {
+    auto [id] = stdexec::sync_wait(stdexec::schedule(sched) | stdexec::then([] {
+                                     return std::this_thread::get_id();
+                                   })).value();
+    return id;
+  };
+  auto first = thread_of(pool.get_scheduler());
+  auto second = thread_of(pool.get_scheduler());
+  auto third = thread_of(pool.get_scheduler());
+  CHECK(first != second);
+  CHECK(first == third);
+  CHECK(first != std::this_thread::get_id());
+}
+
+TEST_CASE("[run() can pin io threads to cores]", "[epoll_reactor_pool.run]") {
+  reactor_pool pool{2};
+  CHECK_NOTHROW(pool.run());
+  pool.request_stop();
+  pool.join();
+  CHECK(pool.threads_.empty());
+}
+
+TEST_CASE("[cpu() should map contexts onto the allowed cpus]",
+          "[epoll_reactor_pool.run]") {
+  reactor_pool pool{2};
+  REQUIRE(pool.cpu(0) >= 0);
+  CHECK(pool.index_of_cpu(pool.cpu(0)) == 0);
+  CHECK(pool.index_of_cpu(-1) == pool.size());
+
+  // The io thread is pinned before it runs the context.
+  pool.run();
+  auto sched = pool.context(0).get_scheduler();
+  auto [cpu] = stdexec::sync_wait(stdexec::schedule(sched) | stdexec::then([] {
+                                    return ::sched_getcpu();
+                                  }))
+                   .value();
+  CHECK(cpu == pool.cpu(0));
+}
+
+TEST_CASE("[get_least_loaded_scheduler() should pick the idle context]",
+          "[epoll_reactor_pool.scheduler]") {
+  reactor_pool pool{2};
+  CHECK(pool.get_least_loaded_scheduler() == pool.context(0).get_scheduler());
+  pool.context(0).descriptor_count_ = 5;
+  CHECK(pool.get_least_loaded_scheduler() == pool.context(1).get_scheduler());
+}
+
+TEST_CASE("[make_acceptors() should shard one endpoint over all contexts]",
+          "[epoll_reactor_pool.acceptor]") {
+  reactor_pool pool{2};
+  pool.run(false);
+
+  system_error2::system_code ec{};
+  net::ip::tcp::endpoint ep{net::ip::address_v4::any(), mock_port};
+  auto acceptors = pool.make_acceptors<net::ip::tcp>(ep, ec);
+  REQUIRE(ec.success());
+  REQUIRE(acceptors.size() == 2);
+  for (std::size_t i = 0; i < acceptors.size(); ++i) {
+    CHECK(&acceptors[i].context() == &pool.context(i));
+    CHECK(acceptors[i].set_non_blocking(true).success());
+    net::socket_base::reuse_port option{};
+    CHECK(acceptors[i].get_option(option).success());
+    CHECK(option.value() == 1);
+  }
+
+  std::jthread client_thread([&pool] {
+    net::ip::tcp::socket client{pool.context(0)};
+    CHECK(client.open(net::ip::tcp::v4()).success());
+    CHECK(
+        client.connect({net::ip::address_v4::loopback(), mock_port}).success());
+    std::this_thread::sleep_for(100ms);
+  });
+
+  // Whichever acceptor the kernel picked accepts the connection.
+  bool accepted = false;
+  stdexec::sync_wait(
+      exec::when_any(net::async_accept(acceptors[0]),
+                     net::async_accept(acceptors[1])) |
+      stdexec::then([&accepted](net::ip::tcp::socket&& socket) noexcept {
+        accepted = socket.is_open();
+      }) |
+      stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  CHECK(accepted);
+}
+
+TEST_CASE("[share_acceptor() should share one socket over all contexts]",
+          "[epoll_reactor_pool.acceptor]") {
+  reactor_pool pool{2};
+  pool.run(false);
+
+  system_error2::system_code ec{};
+  net::ip::tcp::endpoint ep{net::ip::address_v4::any(), mock_port + 1};
+  net::ip::tcp::acceptor origin{pool.context(0), ep, ec};
+  REQUIRE(ec.success());
+  auto acceptors =
+      pool.share_acceptor(net::ip::tcp::v4(), origin.native_handle(), ec);
+  REQUIRE(ec.success());
+  REQUIRE(acceptors.size() == 2);
+  for (std::size_t i = 0; i < acceptors.size(); ++i) {
+    CHECK(&acceptors[i].context() == &pool.context(i));
+    CHECK(acceptors[i].native_handle() != origin.native_handle());
+    CHECK(acceptors[i].is_exclusive_wakeup());
+  }
+
+  std::jthread client_thread([&pool] {
+    net::ip::tcp::socket client{pool.context(0)};
+    CHECK(client.open(net::ip::tcp::v4()).success());
+    CHECK(client.connect({net::ip::address_v4::loopback(), mock_port + 1})
+              .success());
+    std::this_thread::sleep_for(100ms);
+  });
+
+  bool accepted = false;
+  stdexec::sync_wait(
+      exec::when_any(net::async_accept(acceptors[0]),
+                     net::async_accept(acceptors[1])) |
+      stdexec::then([&accepted](net::ip::tcp::socket&& socket) noexcept {
+        accepted = socket.is_open();
+      }) |
+      stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  CHECK(accepted);
+}
+
+TEST_CASE("[steer_by_cpu() should set the incoming cpu of every acceptor]",
+          "[epoll_reactor_pool.acceptor]") {
+  reactor_pool pool{2};
+  pool.run();
+
+  system_error2::system_code ec{};
+  net::ip::tcp::endpoint ep{net::ip::address_v4::any(), mock_port + 2};
+  auto acceptors = pool.make_acceptors<net::ip::tcp>(ep, ec);
+  REQUIRE(ec.success());
+  pool.steer_by_cpu(acceptors, ec);
+  REQUIRE(ec.success());
+  for (std::size_t i = 0; i < acceptors.size(); ++i) {
+    net::socket_base::incoming_cpu option{};
+    CHECK(acceptors[i].get_option(option).success());
+    CHECK(option.value() == pool.cpu(i));
+  }
+
+  std::jthread client_thread([&pool] {
+    net::ip::tcp::socket client{pool.context(0)};
+    CHECK(client.open(net::ip::tcp::v4()).success());
+    CHECK(client.connect({net::ip::address_v4::loopback(), mock_port + 2})
+              .success());
+    std::this_thread::sleep_for(100ms);
+  });
+
+  bool accepted = false;
+  stdexec::sync_wait(
+      exec::when_any(net::async_accept(acceptors[0]),
+                     net::async_accept(acceptors[1])) |
+      stdexec::then([&accepted](net::ip::tcp::socket&& socket) noexcept {
+        accepted = socket.is_open();
+      }) |
+      stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  CHECK(accepted);
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <netdb.h>
+
+#include <algorithm>
+#include <chrono>        // NOLINT
+#include <future>        // NOLINT
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "stdexec.hpp"
+
+#include "epoll/epoll_context.hpp"
+#include "epoll/resolve_op.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/address_v6.hpp"
+#include "ip/tcp.hpp"
+#include "resolver_pool.hpp"
+
+using net::epoll_context;
+using net::ip::tcp;
+using namespace std::chrono_literals;  // NOLINT
+
+TEST_CASE("[async_resolve should resolve numeric hosts on the io thread]",
+          "[epoll_resolve_op]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  std::vector<tcp::endpoint> endpoints;
+  std::thread::id completed_on;
+  stdexec::sync_wait(
+      net::async_resolve<tcp>(ctx, "127.0.0.1", "8080") |
+      stdexec::then([&](std::vector<tcp::endpoint>&& result) noexcept {
+        endpoints = std::move(result);
+        completed_on = std::this_thread::get_id();
+      }) |
+      stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  REQUIRE(endpoints.size() == 1);
+  CHECK(endpoints[0] ==
+        tcp::endpoint{net::ip::address_v4::loopback(), 8080});
+  CHECK(completed_on == io_thread.get_id());
+
+  stdexec::sync_wait(
+      net::async_resolve<tcp>(ctx, "::1", "443") |
+      stdexec::then([&](std::vector<tcp::endpoint>&& result) noexcept {
+        endpoints = std::move(result);
+      }) |
+      stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  REQUIRE(endpoints.size() == 1);
+  CHECK(endpoints[0] == tcp::endpoint{net::ip::address_v6::loopback(), 443});
+}
+
+TEST_CASE("[async_resolve should report getaddrinfo errors]",
+          "[epoll_resolve_op]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  std::error_code ec;
+  stdexec::sync_wait(
+      net::async_resolve<tcp>(ctx, "127.0.0.1", "no-such-service") |
+      stdexec::then([](std::vector<tcp::endpoint>&&) noexcept {
+        CHECK(false);
+      }) |
+      stdexec::upon_error([&ec](std::error_code&& e) noexcept { ec = e; }));
+  CHECK(ec == std::error_code{EAI_SERVICE, net::resolver_category()});
+  CHECK_FALSE(ec.message().empty());
+}
+
+TEST_CASE("[a busy resolver should not stall the context]",
+          "[epoll_resolve_op]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  // Occupy the only worker, as a slow name server would.
+  net::resolver_pool pool{1};
+  std::promise<void> release;
+  struct blocking_job : net::resolver_pool::job {
+    std::shared_future<void> released;
+  } job;
+  job.released = release.get_future().share();
+  job.run_ = [](net::resolver_pool::job* j) noexcept {
+    static_cast<blocking_job*>(j)->released.wait();
+  };
+  pool.submit(&job);
+
+  std::size_t count = 0;
+  std::jthread resolver([&] {
+    stdexec::sync_wait(
+        net::async_resolve<tcp>(ctx, pool, "127.0.0.1", "80") |
+        stdexec::then([&](std::vector<tcp::endpoint>&& result) noexcept {
+          count = result.size();
+        }));
+  });
+
+  // The context keeps serving other operations meanwhile.
+  for (int i = 0; i < 10; ++i) {
+    CHECK(stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler())));
+  }
+  CHECK(count == 0);
+
+  release.set_value();
+  resolver.join();
+  CHECK(count == 1);
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <chrono>        // NOLINT
+#include <future>        // NOLINT
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "stdexec.hpp"
+
+#include "epoll/epoll_context.hpp"
+#include "epoll/resolver_cache.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/tcp.hpp"
+#include "resolver_pool.hpp"
+
+using net::epoll_context;
+using net::ip::tcp;
+using namespace std::chrono_literals;  // NOLINT
+
+namespace {
+using cache_t = net::resolver_cache<tcp>;
+
+// Read the statistics on the io thread, which owns the cache.
+cache_t::statistics stats_of(epoll_context& ctx, cache_t& cache) {
+  auto [stats] =
+      stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler()) |
+                         stdexec::then([&cache] { return cache.stats(); }))
+          .value();
+  return stats;
+}
+
+// Occupies the only worker of a pool, as a slow name server would.
+struct blocking_job : net::resolver_pool::job {
+  explicit blocking_job(net::resolver_pool& pool)
+      : released_(release_.get_future().share()) {
+    run_ = [](net::resolver_pool::job* j) noexcept {
+      static_cast<blocking_job*>(j)->released_.wait();
+    };
+    pool.submit(this);
+  }
+
+  void release() { release_.set_value(); }
+
+  std::promise<void> release_;
+  std::shared_future<void> released_;
+};
+}  // namespace
+
+TEST_CASE("[resolver_cache should answer repeated lookups from the cache]",
+          "[epoll_resolver_cache]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  cache_t cache{ctx};
+
+  std::vector<cache_t::results_type> results;
+  for (int i = 0; i < 3; ++i) {
+    stdexec::sync_wait(
+        net::async_resolve_cached(cache, "127.0.0.1", "8080") |
+        stdexec::then([&](cache_t::results_type&& r) noexcept {
+          results.push_back(std::move(r));
+        }) |
+        stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  }
+  REQUIRE(results.size() == 3);
+  REQUIRE(results[0]->size() == 1);
+  CHECK((*results[0])[0] ==
+        tcp::endpoint{net::ip::address_v4::loopback(), 8080});
+  CHECK(results[1] == results[0]);
+  CHECK(results[2] == results[0]);
+
+  auto stats = stats_of(ctx, cache);
+  CHECK(stats.misses == 1);
+  CHECK(stats.hits == 2);
+}
+
+TEST_CASE("[resolver_cache should cache failures]", "[epoll_resolver_cache]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  cache_t cache{ctx};
+
+  for (int i = 0; i < 2; ++i) {
+    std::error_code ec;
+    stdexec::sync_wait(
+        net::async_resolve_cached(cache, "127.0.0.1", "no-such-service") |
+        stdexec::then([](cache_t::results_type&&) noexcept { CHECK(false); }) |
+        stdexec::upon_error([&ec](std::error_code&& e) noexcept { ec = e; }));
+    CHECK(ec == std::error_code{EAI_SERVICE, net::resolver_category()});
+  }
+
+  auto stats = stats_of(ctx, cache);
+  CHECK(stats.misses == 1);
+  CHECK(stats.negative_hits == 1);
+}
+
+TEST_CASE("[resolver_cache should share one getaddrinfo between lookups]",
+          "[epoll_resolver_cache]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  net::resolver_pool pool{1};
+  cache_t cache{ctx, pool};
+
+  blocking_job job{pool};
+  std::size_t count = 0;
+  std::jthread lookups([&] {
+    auto lookup = [&] {
+      return net::async_resolve_cached(cache, "127.0.0.1", "80") |
+             stdexec::then([&count](cache_t::results_type&& r) noexcept {
+               count += r->size();
+             });
+    };
+    stdexec::sync_wait(stdexec::when_all(lookup(), lookup(), lookup()));
+  });
+
+  // Wait until every lookup has joined the fetch.
+  while (stats_of(ctx, cache).coalesced < 2) {
+    std::this_thread::sleep_for(1ms);
+  }
+  job.release();
+  lookups.join();
+  CHECK(count == 3);
+
+  auto stats = stats_of(ctx, cache);
+  CHECK(stats.misses == 1);
+  CHECK(stats.coalesced == 2);
+}
+
+TEST_CASE("[resolver_cache should resolve again once the ttl expires]",
+          "[epoll_resolver_cache]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  cache_t cache{ctx, cache_t::options{.ttl = 10ms}};
+
+  auto lookup = [&] {
+    stdexec::sync_wait(net::async_resolve_cached(cache, "127.0.0.1", "80") |
+                       stdexec::upon_error([](std::error_code&&) noexcept {
+                         CHECK(false);
+                       }));
+  };
+  lookup();
+  lookup();
+  std::this_thread::sleep_for(30ms);
+  lookup();
+
+  auto stats = stats_of(ctx, cache);
+  CHECK(stats.misses == 2);
+  CHECK(stats.hits == 1);
+}
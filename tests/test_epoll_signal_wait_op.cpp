@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <chrono>        // NOLINT
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "stdexec.hpp"
+
+#include "epoll/drain_op.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/signal_wait_op.hpp"
+#include "monotonic_clock.hpp"
+
+using net::epoll_context;
+using net::__epoll::signal_wait_sender;
+using namespace std::chrono_literals;  // NOLINT
+
+namespace {
+// Block SIGUSR1 and SIGUSR2 in the calling thread and the threads it starts.
+struct block_user_signals {
+  block_user_signals() noexcept {
+    ::sigset_t set;
+    ::sigemptyset(&set);
+    ::sigaddset(&set, SIGUSR1);
+    ::sigaddset(&set, SIGUSR2);
+    ::pthread_sigmask(SIG_BLOCK, &set, &old_);
+  }
+
+  ~block_user_signals() { ::pthread_sigmask(SIG_SETMASK, &old_, nullptr); }
+
+  ::sigset_t old_;
+};
+}  // namespace
+
+TEST_CASE("[signal_wait_sender::__t should satisfy stdexec::sender]",
+          "[epoll_signal_wait_op.concept]") {
+  CHECK(stdexec::sender<stdexec::__t<signal_wait_sender>>);
+}
+
+TEST_CASE("[async_wait_signal should complete with the signal received]",
+          "[epoll_signal_wait_op.wait]") {
+  block_user_signals blocked;
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  // A signal already pending completes the wait right away.
+  REQUIRE(::kill(::getpid(), SIGUSR2) == 0);
+  auto [first] =
+      stdexec::sync_wait(net::async_wait_signal(ctx, {SIGUSR1, SIGUSR2}))
+          .value();
+  CHECK(first == SIGUSR2);
+
+  // Otherwise the wait parks on the signalfd.
+  std::jthread sender([] {
+    std::this_thread::sleep_for(10ms);
+    ::kill(::getpid(), SIGUSR1);
+  });
+  auto [second] =
+      stdexec::sync_wait(net::async_wait_signal(ctx, {SIGUSR1, SIGUSR2}))
+          .value();
+  CHECK(second == SIGUSR1);
+  CHECK(ctx.descriptor_count() == 0);
+}
+
+TEST_CASE("[async_wait_signal should not hold up a drain]",
+          "[epoll_signal_wait_op.drain]") {
+  block_user_signals blocked;
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+
+  const auto start = net::monotonic_clock::now();
+  auto result = stdexec::sync_wait(stdexec::when_all(
+      net::async_wait_signal(ctx, {SIGUSR1}) |
+          stdexec::let_stopped([] { return stdexec::just(0); }),
+      exec::schedule_after(ctx.get_scheduler(), 10ms) |
+          stdexec::let_value([&ctx] { return net::async_drain(ctx, 10s); })));
+  REQUIRE(result.has_value());
+  CHECK(std::get<0>(result.value()) == 0);
+  CHECK(net::monotonic_clock::now() - start < 5s);
+}
@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <atomic>
+#include <chrono>        // NOLINT
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "epoll/admission_control.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_accept_each_op.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/network_v4.hpp"
+#include "ip/prefix_table.hpp"
+#include "ip/tcp.hpp"
+
+using net::epoll_context;
+using net::__epoll::accept_each_sender;
+using namespace std::chrono_literals;  // NOLINT
+
+constexpr port_type mock_port = 12340;
+
+namespace {
+struct count_handler {
+  void operator()(net::ip::tcp::socket&& socket) noexcept {
+    CHECK(socket.is_non_blocking());
+    ++count;
+  }
+
+  int count = 0;
+};
+
+void connect_clients(epoll_context& ctx, port_type port, int count,
+                     std::vector<net::ip::tcp::socket>& clients) {
+  for (int i = 0; i < count; ++i) {
+    auto& client = clients.emplace_back(ctx);
+    CHECK(client.open(net::ip::tcp::v4()).success());
+    CHECK(client.connect({net::ip::address_v4::loopback(), port}).success());
+  }
+}
+}  // namespace
+
+TEST_CASE("[accept_each_sender::__t should satisfy stdexec::sender]",
+          "[epoll_socket_accept_each_op.concept]") {
+  CHECK(stdexec::sender<
+        stdexec::__t<accept_each_sender<net::ip::tcp, count_handler>>>);
+}
+
+TEST_CASE("[async_accept_each should stay armed until stopped]",
+          "[epoll_socket_accept_each_op.stop]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  system_error2::system_code ec{};
+  net::ip::tcp::acceptor acceptor{
+      ctx, {net::ip::address_v4::any(), mock_port}, ec};
+  REQUIRE(ec.success());
+  CHECK(acceptor.set_non_blocking(true).success());
+
+  std::vector<net::ip::tcp::socket> clients;
+  std::jthread client_thread([&] {
+    connect_clients(ctx, mock_port, 3, clients);
+    std::this_thread::sleep_for(50ms);
+    connect_clients(ctx, mock_port, 2, clients);
+  });
+
+  std::atomic<int> count = 0;
+  bool stopped = false;
+  stdexec::sync_wait(exec::when_any(
+      net::async_accept_each(acceptor,
+                             [&count](net::ip::tcp::socket&& socket) {
+                               CHECK(socket.is_open());
+                               ++count;
+                             }) |
+          stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }),
+      exec::schedule_after(ctx.get_scheduler(), 300ms) |
+          stdexec::then([&stopped] { stopped = true; })));
+  CHECK(stopped);
+  CHECK(count == 5);
+
+  // The acceptor was registered once and is still usable.
+  CHECK(acceptor.descriptor_data() != nullptr);
+}
+
+TEST_CASE("[handler returning false should complete async_accept_each]",
+          "[epoll_socket_accept_each_op.value]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  system_error2::system_code ec{};
+  net::ip::tcp::acceptor acceptor{
+      ctx, {net::ip::address_v4::any(), mock_port + 1}, ec};
+  REQUIRE(ec.success());
+  CHECK(acceptor.set_non_blocking(true).success());
+
+  std::vector<net::ip::tcp::socket> clients;
+  std::jthread client_thread(
+      [&] { connect_clients(ctx, mock_port + 1, 4, clients); });
+
+  int count = 0;
+  auto result = stdexec::sync_wait(net::async_accept_each(
+      acceptor, [&count](net::ip::tcp::socket&&) { return ++count < 2; }));
+  CHECK(result.has_value());
+  CHECK(count == 2);
+}
+
+TEST_CASE("[async_accept_each should reset connections while overloaded]",
+          "[epoll_socket_accept_each_op.admission]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  system_error2::system_code ec{};
+  net::ip::tcp::acceptor acceptor{
+      ctx, {net::ip::address_v4::any(), 12405}, ec};
+  REQUIRE(ec.success());
+  CHECK(acceptor.set_non_blocking(true).success());
+
+  // The acceptor itself reaches the limit once it's registered.
+  net::admission_control admission{
+      {.max_descriptors = 1,
+       .on_overload = net::admission_control::action::reject}};
+  std::vector<net::ip::tcp::socket> clients;
+  std::jthread client_thread([&] {
+    std::this_thread::sleep_for(50ms);
+    connect_clients(ctx, 12405, 3, clients);
+  });
+
+  std::atomic<int> count = 0;
+  stdexec::sync_wait(exec::when_any(
+      net::async_accept_each(acceptor, admission,
+                             [&count](net::ip::tcp::socket&&) { ++count; }),
+      exec::schedule_after(ctx.get_scheduler(), 200ms)));
+  client_thread.join();
+  CHECK(count == 0);
+  CHECK(admission.stats().rejected == 3);
+  CHECK(admission.stats().admitted == 0);
+
+  // The peers see a reset.
+  char byte = 0;
+  auto res = clients[0].sync_recv(&byte, 1, 0);
+  REQUIRE(res.has_error());
+  CHECK(res.error() == system_error2::errc::connection_reset);
+}
+
+TEST_CASE("[async_accept_each should pause while the loop lags]",
+          "[epoll_socket_accept_each_op.admission]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  system_error2::system_code ec{};
+  net::ip::tcp::acceptor acceptor{
+      ctx, {net::ip::address_v4::any(), 12406}, ec};
+  REQUIRE(ec.success());
+  CHECK(acceptor.set_non_blocking(true).success());
+
+  // Any iteration lags behind a limit of one nanosecond.
+  net::admission_control admission{{.max_loop_lag = 1ns, .pause_time = 5ms}};
+  std::vector<net::ip::tcp::socket> clients;
+  std::jthread client_thread([&] {
+    std::this_thread::sleep_for(50ms);
+    connect_clients(ctx, 12406, 2, clients);
+  });
+
+  std::atomic<int> count = 0;
+  stdexec::sync_wait(exec::when_any(
+      net::async_accept_each(acceptor, admission,
+                             [&count](net::ip::tcp::socket&&) { ++count; }),
+      exec::schedule_after(ctx.get_scheduler(), 200ms)));
+  client_thread.join();
+  CHECK(count == 0);
+  CHECK(admission.stats().pauses > 1);
+  CHECK(ctx.loop_tasks_.empty());
+
+  // The connections wait in the backlog.
+  CHECK(acceptor.non_blocking_accept(SOCK_NONBLOCK).has_value());
+  CHECK(acceptor.non_blocking_accept(SOCK_NONBLOCK).has_value());
+}
+
+TEST_CASE("[async_accept_each should reset peers its filter refuses]",
+          "[epoll_socket_accept_each_op.admission]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  system_error2::system_code ec{};
+  net::ip::tcp::acceptor acceptor{
+      ctx, {net::ip::address_v4::any(), 12407}, ec};
+  REQUIRE(ec.success());
+  CHECK(acceptor.set_non_blocking(true).success());
+
+  // Deny the loopback network.
+  net::ip::prefix_table<bool> deny;
+  deny.insert(net::ip::network_v4{net::ip::address_v4::loopback(), 8}, true);
+  deny.build();
+  net::admission_control admission{
+      {.peer_filter = [](const void* arg, const ::sockaddr_storage& addr,
+                         ::socklen_t size) noexcept {
+         return static_cast<const net::ip::prefix_table<bool>*>(arg)->find(
+                    addr, size) == nullptr;
+       },
+       .peer_filter_arg = &deny}};
+  std::vector<net::ip::tcp::socket> clients;
+  std::jthread client_thread([&] {
+    std::this_thread::sleep_for(50ms);
+    connect_clients(ctx, 12407, 2, clients);
+  });
+
+  std::atomic<int> count = 0;
+  stdexec::sync_wait(exec::when_any(
+      net::async_accept_each(acceptor, admission,
+                             [&count](net::ip::tcp::socket&&) { ++count; }),
+      exec::schedule_after(ctx.get_scheduler(), 200ms)));
+  client_thread.join();
+  CHECK(count == 0);
+  CHECK(admission.stats().filtered == 2);
+  CHECK(admission.stats().rejected == 0);
+}
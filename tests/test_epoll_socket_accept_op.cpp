@@ -13,9 +13,12 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <fcntl.h>
+
 #include <chrono>  // NOLINT
 #include <exception>
 #include <thread>  // NOLINT
+#include <vector>
 
 #include "catch2/catch_test_macros.hpp"
 #include "fmt/format.h"
@@ -34,6 +37,7 @@
 #include "test_common/receivers.hpp"
 
 using net::epoll_context;
+using net::__epoll::accept_many_sender;
 using net::__epoll::accept_sender;
 using stdexec::sync_wait;
 
@@ -49,9 +53,9 @@ TEST_CASE("[constructor]", "[epoll_socket_accept_op.ctor]") {
 
   operation op{empty_receiver{}, acceptor};
   (void)op.receiver_;
-  CHECK(op.socket_.is_open() == false);
-  CHECK(op.acceptor_.is_open() == false);
-  CHECK(&op.context_ == &acceptor.context_);
+  CHECK(op.accepted_.is_open() == false);
+  CHECK(&op.socket_ == &acceptor);
+  CHECK(&op.context() == acceptor.context_);
   CHECK(op.ec_ == system_error2::errc::success);
 }
 
@@ -129,3 +133,65 @@ TEST_CASE("[Example: accept IPv4 request]",
 
   sync_wait(std::move(s));
 }
+
+TEST_CASE("[accepted sockets should be non-blocking]",
+          "[epoll_socket_accept_op.accept4]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  system_error2::system_code ec{system_error2::errc::success};
+  net::ip::tcp::acceptor acceptor{
+      ctx, {net::ip::address_v4::any(), mock_port + 1}, ec, true};
+  REQUIRE(ec.success());
+  CHECK(acceptor.set_non_blocking(true).success());
+
+  net::ip::tcp::socket client{ctx};
+  CHECK(client.open(net::ip::tcp::v4()).success());
+  CHECK(client.connect({net::ip::address_v4::loopback(), mock_port + 1})
+            .success());
+
+  auto [peer] = sync_wait(net::async_accept(acceptor)).value();
+  CHECK(peer.is_non_blocking());
+  int flags = ::fcntl(peer.native_handle(), F_GETFL);
+  CHECK((flags & O_NONBLOCK) != 0);
+  CHECK((::fcntl(peer.native_handle(), F_GETFD) & FD_CLOEXEC) != 0);
+}
+
+TEST_CASE("[async_accept_many should drain the backlog in one wakeup]",
+          "[epoll_socket_accept_op.accept_many]") {
+  CHECK(stdexec::sender<stdexec::__t<accept_many_sender<net::ip::tcp>>>);
+
+  epoll_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  system_error2::system_code ec{system_error2::errc::success};
+  net::ip::tcp::acceptor acceptor{
+      ctx, {net::ip::address_v4::any(), mock_port + 2}, ec, true};
+  REQUIRE(ec.success());
+  CHECK(acceptor.set_non_blocking(true).success());
+
+  std::vector<net::ip::tcp::socket> clients;
+  for (int i = 0; i < 5; ++i) {
+    auto& client = clients.emplace_back(ctx);
+    CHECK(client.open(net::ip::tcp::v4()).success());
+    CHECK(client.connect({net::ip::address_v4::loopback(), mock_port + 2})
+              .success());
+  }
+  std::this_thread::sleep_for(50ms);
+
+  // At most `max_count` connections are accepted.
+  auto [first] = sync_wait(net::async_accept_many(acceptor, 3)).value();
+  CHECK(first.size() == 3);
+  auto [second] = sync_wait(net::async_accept_many(acceptor, 16)).value();
+  CHECK(second.size() == 2);
+  for (auto& socket : second) {
+    CHECK(socket.is_open());
+    CHECK(socket.is_non_blocking());
+  }
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <exception>
+#include <optional>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_connect_any_op.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/address_v6.hpp"
+#include "ip/tcp.hpp"
+
+using net::epoll_context;
+using net::ip::tcp;
+
+constexpr port_type mock_port = 12392;
+
+TEST_CASE("[connect_any_sender::__t should satisfy stdexec::sender]",
+          "[epoll_socket_connect_any_op.concept]") {
+  auto factory = [](const tcp::endpoint&) -> tcp::socket {
+    std::terminate();
+  };
+  CHECK(stdexec::sender<stdexec::__t<
+            net::__epoll::connect_any_sender<tcp, decltype(factory)>>>);
+}
+
+TEST_CASE("[interleave_families should alternate the address families]",
+          "[epoll_socket_connect_any_op.interleave]") {
+  const tcp::endpoint a6{net::ip::address_v6::loopback(), 1};
+  const tcp::endpoint b6{net::ip::address_v6::loopback(), 2};
+  const tcp::endpoint c6{net::ip::address_v6::loopback(), 3};
+  const tcp::endpoint a4{net::ip::address_v4::loopback(), 1};
+  const tcp::endpoint b4{net::ip::address_v4::loopback(), 2};
+
+  std::vector<tcp::endpoint> endpoints{a6, b6, c6, a4, b4};
+  net::__epoll::interleave_families(endpoints);
+  CHECK(endpoints == std::vector<tcp::endpoint>{a6, a4, b6, b4, c6});
+
+  endpoints = {a4, a6, b4, b6, b4};
+  net::__epoll::interleave_families(endpoints);
+  CHECK(endpoints == std::vector<tcp::endpoint>{a4, a6, b4, b6, b4});
+}
+
+TEST_CASE("[async_connect_any should skip endpoints which refuse]",
+          "[epoll_socket_connect_any_op.async_connect_any]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  system_error2::system_code ec{};
+  tcp::acceptor acceptor{ctx, {net::ip::address_v4::any(), mock_port}, ec};
+  REQUIRE(ec.success());
+
+  const tcp::endpoint refused{net::ip::address_v4::loopback(), mock_port + 1};
+  const tcp::endpoint listening{net::ip::address_v4::loopback(), mock_port};
+  int made = 0;
+  auto factory = [&ctx, &made](const tcp::endpoint&) {
+    ++made;
+    return tcp::socket{ctx};
+  };
+
+  std::optional<tcp::endpoint> peer;
+  stdexec::sync_wait(
+      net::async_connect_any(ctx, factory,
+                             std::vector<tcp::endpoint>{refused, listening}) |
+      stdexec::then([&](tcp::socket&& socket, tcp::endpoint ep) noexcept {
+        CHECK(socket.is_open());
+        peer = ep;
+      }) |
+      stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  REQUIRE(peer.has_value());
+  CHECK(*peer == listening);
+  CHECK(made == 2);
+  CHECK(acceptor.accept().has_value());
+}
+
+TEST_CASE("[async_connect_any should report the error of the last attempt]",
+          "[epoll_socket_connect_any_op.async_connect_any]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  auto factory = [&ctx](const tcp::endpoint&) { return tcp::socket{ctx}; };
+  std::vector<tcp::endpoint> endpoints{
+      {net::ip::address_v4::loopback(), mock_port + 2},
+      {net::ip::address_v4::loopback(), mock_port + 3}};
+
+  std::error_code error{};
+  stdexec::sync_wait(
+      net::async_connect_any(ctx, factory, endpoints) |
+      stdexec::then([](tcp::socket&&, tcp::endpoint) noexcept {
+        CHECK(false);
+      }) |
+      stdexec::upon_error(
+          [&error](std::error_code&& ec) noexcept { error = ec; }));
+  CHECK(error == std::errc::connection_refused);
+
+  error = {};
+  stdexec::sync_wait(
+      net::async_connect_any(ctx, factory, std::vector<tcp::endpoint>{}) |
+      stdexec::then([](tcp::socket&&, tcp::endpoint) noexcept {
+        CHECK(false);
+      }) |
+      stdexec::upon_error(
+          [&error](std::error_code&& ec) noexcept { error = ec; }));
+  CHECK(error == std::errc::host_unreachable);
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_connect_op.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/tcp.hpp"
+
+using net::epoll_context;
+using net::__epoll::connect_sender;
+
+constexpr port_type mock_port = 12342;
+
+TEST_CASE("[connect_sender::__t should satisfy stdexec::sender]",
+          "[epoll_socket_connect_op.concept]") {
+  CHECK(stdexec::sender<stdexec::__t<connect_sender<net::ip::tcp>>>);
+}
+
+TEST_CASE("[async_connect should connect to a listening peer]",
+          "[epoll_socket_connect_op.async_connect]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  system_error2::system_code ec{};
+  net::ip::tcp::acceptor acceptor{ctx, {net::ip::address_v4::any(), mock_port},
+                                  ec};
+  REQUIRE(ec.success());
+
+  net::ip::tcp::socket client{ctx};
+  REQUIRE(client.open(net::ip::tcp::v4()).success());
+  bool connected = false;
+  stdexec::sync_wait(
+      net::async_connect(client, {net::ip::address_v4::loopback(), mock_port}) |
+      stdexec::then([&connected]() noexcept { connected = true; }) |
+      stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  CHECK(connected);
+  CHECK(client.is_non_blocking());
+
+  auto peer = acceptor.accept();
+  REQUIRE(peer.has_value());
+  auto local = client.local_endpoint();
+  auto remote = peer.value().peer_endpoint();
+  REQUIRE(local.has_value());
+  REQUIRE(remote.has_value());
+  CHECK(local.value().port() == remote.value().port());
+
+  const auto& latency = ctx.latency(epoll_context::op_kind::connect);
+  CHECK(latency.total.count() == (epoll_context::latency_enabled ? 1 : 0));
+  CHECK(latency.ready_to_complete.count() <= latency.total.count());
+}
+
+TEST_CASE("[async_connect should complete with the error of the connect]",
+          "[epoll_socket_connect_op.async_connect]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  // Nobody listens on this port.
+  net::ip::tcp::socket client{ctx};
+  REQUIRE(client.open(net::ip::tcp::v4()).success());
+  std::error_code error{};
+  stdexec::sync_wait(
+      net::async_connect(client,
+                         {net::ip::address_v4::loopback(), mock_port + 1}) |
+      stdexec::then([]() noexcept { CHECK(false); }) |
+      stdexec::upon_error(
+          [&error](std::error_code&& ec) noexcept { error = ec; }));
+  CHECK(error == std::errc::connection_refused);
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <string>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "buffer.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_connect_with_data_op.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/tcp.hpp"
+
+using net::epoll_context;
+using net::__epoll::connect_with_data_sender;
+
+constexpr port_type mock_port = 12393;
+
+TEST_CASE("[connect_with_data_sender::__t should satisfy stdexec::sender]",
+          "[epoll_socket_connect_with_data_op.concept]") {
+  CHECK(stdexec::sender<stdexec::__t<
+            connect_with_data_sender<net::ip::tcp, net::const_buffer>>>);
+}
+
+TEST_CASE("[async_connect_with_data should deliver the first bytes]",
+          "[epoll_socket_connect_with_data_op.async_connect_with_data]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  system_error2::system_code ec{};
+  net::ip::tcp::acceptor acceptor{ctx, {net::ip::address_v4::any(), mock_port},
+                                  ec};
+  REQUIRE(ec.success());
+  REQUIRE(acceptor.set_option(net::ip::tcp::fast_open{16}).success());
+
+  // The first connect gets the cookie, the second one may use it. Either
+  // way the bytes arrive.
+  const std::string request = "GET / HTTP/1.1\r\n\r\n";
+  for (int i = 0; i < 2; ++i) {
+    net::ip::tcp::socket client{ctx};
+    REQUIRE(client.open(net::ip::tcp::v4()).success());
+    std::size_t sent = 0;
+    stdexec::sync_wait(
+        net::async_connect_with_data(
+            client, {net::ip::address_v4::loopback(), mock_port},
+            net::buffer(request)) |
+        stdexec::then([&sent](std::size_t n) noexcept { sent = n; }) |
+        stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+    CHECK(sent == request.size());
+
+    auto peer = acceptor.accept();
+    REQUIRE(peer.has_value());
+    std::string received(request.size(), '\0');
+    auto n = peer.value().sync_recv(received.data(), received.size(), 0);
+    REQUIRE(n.has_value());
+    CHECK(received.substr(0, n.value()) == request.substr(0, n.value()));
+  }
+}
+
+TEST_CASE("[async_connect_with_data should complete with the error]",
+          "[epoll_socket_connect_with_data_op.async_connect_with_data]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  // Nobody listens on this port.
+  net::ip::tcp::socket client{ctx};
+  REQUIRE(client.open(net::ip::tcp::v4()).success());
+  const std::string request = "ping";
+  std::error_code error{};
+  stdexec::sync_wait(
+      net::async_connect_with_data(
+          client, {net::ip::address_v4::loopback(), mock_port + 1},
+          net::buffer(request)) |
+      stdexec::then([](std::size_t) noexcept { CHECK(false); }) |
+      stdexec::upon_error(
+          [&error](std::error_code&& ec) noexcept { error = ec; }));
+  CHECK(error == std::errc::connection_refused);
+}
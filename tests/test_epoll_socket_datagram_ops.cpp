@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <array>
+#include <string>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "buffer.hpp"
+#include "datagram_batch.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_recv_batch_op.hpp"
+#include "epoll/socket_recv_from_op.hpp"
+#include "epoll/socket_send_batch_op.hpp"
+#include "epoll/socket_send_to_op.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/udp.hpp"
+#include "udp_socket.hpp"
+
+using net::epoll_context;
+using net::ip::udp;
+
+constexpr port_type mock_port = 12344;
+
+TEST_CASE("[datagram senders should satisfy stdexec::sender]",
+          "[epoll_socket_datagram_ops.concept]") {
+  using net::__epoll::recv_batch_sender;
+  using net::__epoll::recv_from_sender;
+  using net::__epoll::send_batch_sender;
+  using net::__epoll::send_to_sender;
+  CHECK(stdexec::sender<
+        stdexec::__t<recv_from_sender<udp, net::mutable_buffer>>>);
+  CHECK(stdexec::sender<
+        stdexec::__t<recv_from_sender<udp, net::mutable_buffer, true>>>);
+  CHECK(stdexec::sender<stdexec::__t<send_to_sender<udp, net::const_buffer>>>);
+  CHECK(stdexec::sender<stdexec::__t<recv_batch_sender<udp>>>);
+  CHECK(stdexec::sender<stdexec::__t<send_batch_sender<udp>>>);
+}
+
+TEST_CASE("[async_recv_from should receive what async_send_to sent]",
+          "[epoll_socket_datagram_ops.recv_from]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  udp::socket server = make_udp_socket(ctx, mock_port);
+  udp::socket client = make_udp_socket(ctx, mock_port + 1);
+  std::array<char, 16> rbuf{};
+  std::string wbuf = "hello";
+
+  std::size_t received = 0;
+  std::size_t sent = 0;
+  udp::endpoint source{};
+  stdexec::sync_wait(stdexec::when_all(
+      net::async_recv_from(server, net::buffer(rbuf)) |
+          stdexec::then([&](std::size_t size, udp::endpoint&& ep) noexcept {
+            received = size;
+            source = ep;
+          }),
+      net::async_send_to(client, net::buffer(wbuf),
+                         {net::ip::address_v4::loopback(), mock_port}) |
+          stdexec::then([&sent](std::size_t size) noexcept { sent = size; })));
+  CHECK(sent == wbuf.size());
+  CHECK(received == wbuf.size());
+  CHECK(std::string(rbuf.data(), received) == wbuf);
+  CHECK(source.port() == mock_port + 1);
+  CHECK(source.address() == net::ip::address{net::ip::address_v4::loopback()});
+}
+
+TEST_CASE("[async_send_batch and async_recv_batch should exchange a batch]",
+          "[epoll_socket_datagram_ops.batch]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  udp::socket server = make_udp_socket(ctx, mock_port + 2);
+  udp::socket client = make_udp_socket(ctx, mock_port + 3);
+  udp::endpoint peer{net::ip::address_v4::loopback(), mock_port + 2};
+
+  std::array<std::string, 3> messages{"a", "bb", "ccc"};
+  net::datagram_batch<udp> out{4};
+  for (auto& message : messages) {
+    CHECK(out.push_back(net::buffer(message), peer));
+  }
+  CHECK(out.size() == 3);
+
+  std::array<std::array<char, 8>, 4> storage{};
+  net::datagram_batch<udp> in{4};
+  for (auto& buf : storage) {
+    CHECK(in.push_back(net::buffer(buf)));
+  }
+  CHECK(in.full());
+  CHECK_FALSE(in.push_back(net::buffer(storage[0])));
+
+  std::size_t sent = 0;
+  stdexec::sync_wait(
+      net::async_send_batch(client, out) |
+      stdexec::then([&sent](std::size_t count) noexcept { sent = count; }));
+  CHECK(sent == 3);
+
+  // Datagrams sent over loopback are queued at once, one recvmmsg takes all.
+  std::size_t received = 0;
+  stdexec::sync_wait(
+      net::async_recv_batch(server, in) |
+      stdexec::then([&received](std::size_t count) noexcept {
+        received = count;
+      }));
+  REQUIRE(received == 3);
+  for (std::size_t i = 0; i < received; ++i) {
+    CHECK(in.length(i) == messages[i].size());
+    CHECK(std::string(storage[i].data(), in.length(i)) == messages[i]);
+    CHECK_FALSE(in.truncated(i));
+    auto source = in.endpoint(i);
+    REQUIRE(source.has_value());
+    CHECK(source.value().port() == mock_port + 3);
+  }
+}
+
+TEST_CASE("[async_recv_batch should flag truncated datagrams]",
+          "[epoll_socket_datagram_ops.batch]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  udp::socket server = make_udp_socket(ctx, mock_port + 4);
+  udp::socket client = make_udp_socket(ctx, mock_port + 5);
+  std::array<char, 2> small{};
+  net::datagram_batch<udp> in{1};
+  CHECK(in.push_back(net::buffer(small)));
+
+  std::string wbuf = "too long";
+  std::size_t received = 0;
+  stdexec::sync_wait(stdexec::when_all(
+      net::async_recv_batch(server, in) |
+          stdexec::then([&received](std::size_t count) noexcept {
+            received = count;
+          }),
+      net::async_send_to(client, net::buffer(wbuf),
+                         {net::ip::address_v4::loopback(), mock_port + 4})));
+  REQUIRE(received == 1);
+  CHECK(in.truncated(0));
+  CHECK(in.length(0) == small.size());
+}
+
+TEST_CASE("[async_send_to with a segment size should send several datagrams]",
+          "[epoll_socket_datagram_ops.gso]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  udp::socket server = make_udp_socket(ctx, mock_port + 6);
+  udp::socket client = make_udp_socket(ctx, mock_port + 7);
+  std::string wbuf(2500, 'x');
+  std::size_t sent = 0;
+  stdexec::sync_wait(
+      net::async_send_to(client, net::buffer(wbuf),
+                         {net::ip::address_v4::loopback(), mock_port + 6},
+                         1000) |
+      stdexec::then([&sent](std::size_t size) noexcept { sent = size; }));
+  CHECK(sent == wbuf.size());
+
+  // Without GRO the receiver gets every segment as its own datagram.
+  std::array<char, 4096> rbuf{};
+  for (std::size_t expected : {1000, 1000, 500}) {
+    std::size_t received = 0;
+    stdexec::sync_wait(net::async_recv_from(server, net::buffer(rbuf)) |
+                       stdexec::then([&](std::size_t size,
+                                         udp::endpoint&&) noexcept {
+                         received = size;
+                       }));
+    CHECK(received == expected);
+  }
+}
+
+TEST_CASE("[async_recv_segments should report the size of GRO segments]",
+          "[epoll_socket_datagram_ops.gro]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  udp::socket server = make_udp_socket(ctx, mock_port + 8);
+  udp::socket client = make_udp_socket(ctx, mock_port + 9);
+  CHECK(server.set_option(udp::generic_receive_offload{true}).success());
+  udp::generic_receive_offload option{};
+  CHECK(server.get_option(option).success());
+  CHECK(option.value());
+
+  std::string wbuf(2500, 'x');
+  stdexec::sync_wait(
+      net::async_send_to(client, net::buffer(wbuf),
+                         {net::ip::address_v4::loopback(), mock_port + 8},
+                         1000));
+
+  // A locally generated GSO datagram reaches a GRO socket in one piece.
+  std::array<char, 65536> rbuf{};
+  std::size_t received = 0;
+  std::size_t segment_size = 0;
+  stdexec::sync_wait(
+      net::async_recv_segments(server, net::buffer(rbuf)) |
+      stdexec::then([&](std::size_t size, udp::endpoint&& source,
+                        std::size_t segment) noexcept {
+        received = size;
+        segment_size = segment;
+        CHECK(source.port() == mock_port + 9);
+      }));
+  CHECK(received == wbuf.size());
+  CHECK(segment_size == 1000);
+}
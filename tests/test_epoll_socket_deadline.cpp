@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <chrono>        // NOLINT
+#include <cstring>
+#include <string>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "buffer.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_recv_some_op.hpp"
+#include "epoll/socket_send_some_op.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/tcp.hpp"
+#include "monotonic_clock.hpp"
+#include "tcp_connection.hpp"
+
+using net::epoll_context;
+using net::monotonic_clock;
+using namespace std::chrono_literals;  // NOLINT
+
+constexpr port_type mock_port = 12370;
+
+TEST_CASE("[async_recv_some should time out when no data arrives]",
+          "[epoll_socket_deadline.recv_some]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  connection conn{ctx, mock_port};
+
+  char buf[64];
+  std::error_code error;
+  const auto start = monotonic_clock::now();
+  stdexec::sync_wait(
+      net::async_recv_some(conn.server, net::buffer(buf), start + 100ms) |
+      stdexec::then([](std::size_t) noexcept { CHECK(false); }) |
+      stdexec::upon_error(
+          [&error](std::error_code&& ec) noexcept { error = ec; }));
+  CHECK(error == std::errc::timed_out);
+  CHECK(monotonic_clock::now() - start >= 100ms);
+}
+
+TEST_CASE("[async_recv_some should complete before its deadline]",
+          "[epoll_socket_deadline.recv_some]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  connection conn{ctx, mock_port + 1};
+
+  std::jthread writer([&conn] {
+    std::this_thread::sleep_for(20ms);
+    CHECK(conn.client.sync_send("abc", 3, 0).has_value());
+  });
+
+  char buf[64];
+  std::size_t received = 0;
+  stdexec::sync_wait(
+      net::async_recv_some(conn.server, net::buffer(buf),
+                           monotonic_clock::now() + 1s) |
+      stdexec::then([&received](std::size_t size) noexcept {
+        received = size;
+      }) |
+      stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  CHECK(received == 3);
+  CHECK(std::memcmp(buf, "abc", 3) == 0);
+
+  // The cancelled deadline must not fire later.
+  std::this_thread::sleep_for(50ms);
+}
+
+TEST_CASE("[async_send_some with a deadline should send immediately]",
+          "[epoll_socket_deadline.send_some]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  connection conn{ctx, mock_port + 2};
+
+  std::size_t sent = 0;
+  stdexec::sync_wait(
+      net::async_send_some(conn.server, net::buffer("abc", 3),
+                           monotonic_clock::now() + 1s) |
+      stdexec::then([&sent](std::size_t size) noexcept { sent = size; }) |
+      stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  CHECK(sent == 3);
+}
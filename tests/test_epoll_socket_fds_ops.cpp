@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <unistd.h>
+
+#include <span>          // NOLINT
+#include <string_view>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "buffer.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_recv_fds_op.hpp"
+#include "epoll/socket_send_fds_op.hpp"
+#include "local/connect_pair.hpp"
+#include "local/stream_protocol.hpp"
+
+using net::epoll_context;
+using net::local::stream_protocol;
+using net::__epoll::recv_fds_sender;
+using net::__epoll::send_fds_sender;
+
+TEST_CASE("[fds senders should satisfy stdexec::sender]",
+          "[epoll_socket_fds_ops.concept]") {
+  CHECK(stdexec::sender<stdexec::__t<send_fds_sender<stream_protocol>>>);
+  CHECK(stdexec::sender<stdexec::__t<recv_fds_sender<stream_protocol>>>);
+}
+
+TEST_CASE("[async_send_fds should hand a descriptor to the peer]",
+          "[epoll_socket_fds_ops.pass]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  stream_protocol::socket s1{ctx}, s2{ctx};
+  REQUIRE(net::local::connect_pair(s1, s2).success());
+  REQUIRE(s1.set_non_blocking(true).success());
+  REQUIRE(s2.set_non_blocking(true).success());
+
+  int pipe_fds[2];
+  REQUIRE(::pipe(pipe_fds) == 0);
+  const int to_pass[1] = {pipe_fds[0]};
+  auto sent = stdexec::sync_wait(net::async_send_fds(
+      s1, net::buffer("x", 1), std::span<const int>(to_pass)));
+  REQUIRE(sent.has_value());
+  CHECK(std::get<0>(sent.value()) == 1);
+  ::close(pipe_fds[0]);
+
+  char byte = 0;
+  int received_fds[4] = {-1, -1, -1, -1};
+  auto received = stdexec::sync_wait(
+      net::async_recv_fds(s2, net::buffer(&byte, 1), received_fds));
+  REQUIRE(received.has_value());
+  auto [bytes, fd_count] = received.value();
+  CHECK(bytes == 1);
+  CHECK(byte == 'x');
+  REQUIRE(fd_count == 1);
+  CHECK(received_fds[1] == -1);
+
+  // The received descriptor reads what is written to the pipe.
+  REQUIRE(::write(pipe_fds[1], "handoff", 7) == 7);
+  char buf[7];
+  CHECK(::read(received_fds[0], buf, sizeof(buf)) == 7);
+  CHECK(std::string_view(buf, 7) == "handoff");
+  ::close(received_fds[0]);
+  ::close(pipe_fds[1]);
+}
+
+TEST_CASE("[async_send_fds should reject an empty message]",
+          "[epoll_socket_fds_ops.error]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  stream_protocol::socket s1{ctx}, s2{ctx};
+  REQUIRE(net::local::connect_pair(s1, s2).success());
+  REQUIRE(s1.set_non_blocking(true).success());
+
+  const int to_pass[1] = {STDIN_FILENO};
+  auto sent = stdexec::sync_wait(
+      net::async_send_fds(s1, net::const_buffer{}, to_pass)  //
+      | stdexec::upon_error([](std::error_code&& ec) noexcept {
+          return ec == std::errc::invalid_argument ? size_t{42} : size_t{0};
+        }));
+  REQUIRE(sent.has_value());
+  CHECK(std::get<0>(sent.value()) == 42);
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <string_view>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "buffer.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_migrate_op.hpp"
+#include "epoll/socket_recv_some_op.hpp"
+#include "local/connect_pair.hpp"
+#include "local/stream_protocol.hpp"
+
+using net::epoll_context;
+using net::local::stream_protocol;
+using net::__epoll::migrate_sender;
+
+namespace {
+// Get the id of the io thread of `ctx`.
+std::thread::id io_thread_of(epoll_context& ctx) {
+  auto [id] = stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler()) |
+                                 stdexec::then([] {
+                                   return std::this_thread::get_id();
+                                 }))
+                  .value();
+  return id;
+}
+}  // namespace
+
+TEST_CASE("[migrate_sender::__t should satisfy stdexec::sender]",
+          "[epoll_socket_migrate_op.concept]") {
+  CHECK(stdexec::sender<stdexec::__t<migrate_sender<stream_protocol>>>);
+}
+
+TEST_CASE("[async_migrate should move a registered socket to the target]",
+          "[epoll_socket_migrate_op.migrate]") {
+  epoll_context source{}, target{};
+  std::jthread source_thread([&source] { source.run(); });
+  std::jthread target_thread([&target] { target.run(); });
+  exec::scope_guard on_context_exit{[&]() noexcept {
+    source.request_stop();
+    target.request_stop();
+  }};
+
+  stream_protocol::socket s1{source}, s2{source};
+  REQUIRE(net::local::connect_pair(s1, s2).success());
+  REQUIRE(s2.set_non_blocking(true).success());
+
+  // Register the socket on the source context.
+  char buf[8];
+  REQUIRE(s1.send("a", 1, 0).value() == 1);
+  REQUIRE(stdexec::sync_wait(net::async_recv_some(s2, net::buffer(buf))));
+  REQUIRE(s2.descriptor_data() != nullptr);
+  CHECK(source.descriptor_count() == 1);
+
+  const auto target_id = io_thread_of(target);
+  auto migrated = stdexec::sync_wait(
+      net::async_migrate(s2, target.get_scheduler()) |
+      stdexec::then([] { return std::this_thread::get_id(); }));
+  REQUIRE(migrated.has_value());
+  CHECK(std::get<0>(migrated.value()) == target_id);
+  CHECK(&s2.context() == &target);
+  CHECK(s2.descriptor_data() != nullptr);
+  CHECK(source.descriptor_count() == 0);
+  CHECK(target.descriptor_count() == 1);
+
+  // The connection keeps working on the target.
+  REQUIRE(s1.send("moved", 5, 0).value() == 5);
+  auto received =
+      stdexec::sync_wait(net::async_recv_some(s2, net::buffer(buf)));
+  REQUIRE(received.has_value());
+  CHECK(std::string_view(buf, std::get<0>(received.value())) == "moved");
+}
+
+TEST_CASE("[async_migrate should refuse a socket with a pending operation]",
+          "[epoll_socket_migrate_op.busy]") {
+  epoll_context source{}, target{};
+  std::jthread source_thread([&source] { source.run(); });
+  std::jthread target_thread([&target] { target.run(); });
+  exec::scope_guard on_context_exit{[&]() noexcept {
+    source.request_stop();
+    target.request_stop();
+  }};
+
+  stream_protocol::socket s1{source}, s2{source};
+  REQUIRE(net::local::connect_pair(s1, s2).success());
+  REQUIRE(s2.set_non_blocking(true).success());
+
+  // The receive parks on the socket before the migration gets to it, and
+  // finishes once the migration has failed.
+  char buf[8];
+  auto result = stdexec::sync_wait(stdexec::when_all(
+      net::async_recv_some(s2, net::buffer(buf)),
+      net::async_migrate(s2, target.get_scheduler()) |
+          stdexec::then([] { return false; }) |
+          stdexec::upon_error([](std::error_code&& ec) noexcept {
+            return ec == std::errc::device_or_resource_busy;
+          }) |
+          stdexec::then([&s1](bool busy) {
+            (void)s1.send("x", 1, 0);
+            return busy;
+          })));
+  REQUIRE(result.has_value());
+  auto [bytes, busy] = result.value();
+  CHECK(bytes == 1);
+  CHECK(busy);
+  CHECK(&s2.context() == &source);
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <chrono>        // NOLINT
+#include <cstring>
+#include <string>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "buffer.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_recv_pooled_op.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/tcp.hpp"
+#include "tcp_connection.hpp"
+
+using net::epoll_context;
+using namespace std::chrono_literals;  // NOLINT
+
+constexpr port_type mock_port = 12374;
+
+TEST_CASE("[async_recv_pooled should claim a buffer only once data arrives]",
+          "[epoll_socket_recv_pooled_op]") {
+  epoll_context ctx{};
+  ctx.recv_buffer_pool().set_block_size(256);
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  connection conn{ctx, mock_port};
+
+  std::jthread writer([&conn] {
+    std::this_thread::sleep_for(50ms);
+    CHECK(conn.client.sync_send("hello", 5, 0).has_value());
+  });
+
+  std::string received;
+  stdexec::sync_wait(
+      net::async_recv_pooled(conn.server) |
+      stdexec::then([&received](net::buffer_lease lease) noexcept {
+        CHECK(lease.capacity() == 256);
+        received.assign(reinterpret_cast<const char*>(lease.data()),
+                        lease.size());
+      }) |
+      stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  CHECK(received == "hello");
+
+  // The first attempt would block, its block went back to the pool.
+  CHECK(ctx.recv_buffer_pool().acquired_count() == 2);
+  CHECK(ctx.recv_buffer_pool().leased_count() == 0);
+}
+
+TEST_CASE("[async_recv_pooled should complete with an empty lease on eof]",
+          "[epoll_socket_recv_pooled_op]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  connection conn{ctx, mock_port + 1};
+  conn.client.close();
+
+  bool empty = false;
+  stdexec::sync_wait(
+      net::async_recv_pooled(conn.server) |
+      stdexec::then([&empty](net::buffer_lease lease) noexcept {
+        empty = !lease;
+      }) |
+      stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  CHECK(empty);
+  CHECK(ctx.recv_buffer_pool().leased_count() == 0);
+}
@@ -13,8 +13,11 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <optional>      // NOLINT
+#include <string_view>   // NOLINT
 #include <system_error>  // NOLINT
 #include <thread>        // NOLINT
+#include <vector>
 
 #include "catch2/catch_test_macros.hpp"
 #include "execution_context.hpp"
@@ -316,4 +319,312 @@ TEST_CASE("[CPO: `start` performed operation]",
   std::this_thread::sleep_for(1.5s);
 }
 
+TEST_CASE("[async_recv_some_as should deliver system_code errors]",
+          "[recv_some_sender.error_channel]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  // The socket is never opened, so the receive fails at once.
+  net::ip::tcp::socket socket{ctx};
+  char buf[16];
+  system_error2::system_code error{system_error2::errc::success};
+  sync_wait(async_recv_some_as<system_error2::system_code>(socket,
+                                                           buffer(buf)) |
+            then([](size_t) noexcept { CHECK(false); }) |
+            upon_error([&error](system_error2::system_code&& ec) noexcept {
+              error = std::move(ec);
+            }));
+  CHECK(error == system_error2::errc::bad_file_descriptor);
+}
+
+TEST_CASE("[close() should cancel operations parked on the socket]",
+          "[epoll_socket_recv_some_op.close]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  system_error2::system_code ec{system_error2::errc::success};
+  ip::tcp::acceptor acceptor{
+      ctx, {ip::address_v4::loopback(), mock_port + 1}, ec, true};
+  REQUIRE(ec.success());
+  ip::tcp::socket client{ctx};
+  REQUIRE(client.open(ip::tcp::v4()).success());
+  REQUIRE(
+      client.connect({ip::address_v4::loopback(), mock_port + 1}).success());
+  auto accepted = acceptor.accept();
+  REQUIRE(accepted.has_value());
+  ip::tcp::socket server = std::move(accepted.value());
+  REQUIRE(server.set_non_blocking(true).success());
+  REQUIRE(acceptor.set_non_blocking(true).success());
+
+  // Nothing is sent and nobody connects, both operations stay parked until
+  // their sockets are closed from another thread.
+  std::jthread closer([&] {
+    std::this_thread::sleep_for(50ms);
+    CHECK(server.close().success());
+    CHECK(acceptor.close().success());
+  });
+  char buf[16];
+  bool recv_stopped = false;
+  bool accept_stopped = false;
+  sync_wait(when_all(
+      async_recv_some(server, buffer(buf)) |
+          then([](size_t) noexcept { CHECK(false); }) |
+          upon_error([](error_code&&) noexcept { CHECK(false); }) |
+          upon_stopped([&]() noexcept { recv_stopped = true; }),
+      async_accept(acceptor) |
+          then([](ip::tcp::socket&&) noexcept { CHECK(false); }) |
+          upon_error([](error_code&&) noexcept { CHECK(false); }) |
+          upon_stopped([&]() noexcept { accept_stopped = true; })));
+  CHECK(recv_stopped);
+  CHECK(accept_stopped);
+}
+
+TEST_CASE("[a stop from another thread should cancel a parked receive]",
+          "[epoll_socket_recv_some_op.stop]") {
+  epoll_context ctx{};
+  epoll_context other_ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  std::jthread other_thread([&]() { other_ctx.run(); });
+  exec::scope_guard on_exit{[&ctx, &other_ctx]() noexcept {
+    ctx.request_stop();
+    other_ctx.request_stop();
+  }};
+
+  system_error2::system_code ec{system_error2::errc::success};
+  ip::tcp::acceptor acceptor{
+      ctx, {ip::address_v4::loopback(), mock_port + 6}, ec, true};
+  REQUIRE(ec.success());
+  ip::tcp::socket client{ctx};
+  REQUIRE(client.open(ip::tcp::v4()).success());
+  REQUIRE(
+      client.connect({ip::address_v4::loopback(), mock_port + 6}).success());
+  auto accepted = acceptor.accept();
+  REQUIRE(accepted.has_value());
+  ip::tcp::socket server = std::move(accepted.value());
+  REQUIRE(server.set_non_blocking(true).success());
+
+  // The sibling stops on the thread of the other context once the receive
+  // is parked, so the stop request goes through the stop queue.
+  char buf[16];
+  bool recv_stopped = false;
+  sync_wait(when_all(
+      async_recv_some(server, buffer(buf)) |
+          then([](size_t) noexcept { CHECK(false); }) |
+          upon_error([](error_code&&) noexcept { CHECK(false); }) |
+          upon_stopped([&]() noexcept { recv_stopped = true; }),
+      stdexec::schedule(other_ctx.get_scheduler()) |
+          let_value([]() noexcept {
+            std::this_thread::sleep_for(50ms);
+            return just_stopped();
+          })));
+  CHECK(recv_stopped);
+  if constexpr (epoll_context::stats_enabled) {
+    CHECK(ctx.stats().remote_stops == 1);
+  }
+}
+
+TEST_CASE("[read budget should put off the reads of a busy socket]",
+          "[epoll_socket_recv_some_op.read_budget]") {
+  epoll_context ctx{};
+  ctx.set_read_budget(2);
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  system_error2::system_code ec{system_error2::errc::success};
+  ip::tcp::acceptor acceptor{
+      ctx, {ip::address_v4::loopback(), mock_port + 2}, ec, true};
+  REQUIRE(ec.success());
+  ip::tcp::socket client{ctx};
+  REQUIRE(client.open(ip::tcp::v4()).success());
+  REQUIRE(
+      client.connect({ip::address_v4::loopback(), mock_port + 2}).success());
+  auto accepted = acceptor.accept();
+  REQUIRE(accepted.has_value());
+  ip::tcp::socket server = std::move(accepted.value());
+  REQUIRE(server.set_non_blocking(true).success());
+
+  // The first receive registers the socket and waits for the data, the
+  // others complete inline until the budget is used up.
+  std::jthread sender([&] {
+    std::this_thread::sleep_for(50ms);
+    CHECK(client.sync_send("abcd", 4, 0).has_value());
+  });
+  char buf[1];
+  std::uint64_t iterations[3] = {};
+  auto recv_at = [&](int i) {
+    return async_recv_some(server, buffer(buf)) |
+           then([&, i](size_t n) noexcept {
+             CHECK(n == 1);
+             iterations[i] = ctx.loop_iteration_;
+           });
+  };
+  sync_wait(async_recv_some(server, buffer(buf)) |
+            let_value([&](size_t) { return recv_at(0); }) |
+            let_value([&]() { return recv_at(1); }) |
+            let_value([&]() { return recv_at(2); }));
+  CHECK(iterations[0] == iterations[1]);
+  CHECK(iterations[2] > iterations[1]);
+}
+
+TEST_CASE("[async_recv_some should grow a dynamic buffer by what is queued]",
+          "[epoll_socket_recv_some_op.dynamic]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  system_error2::system_code ec{system_error2::errc::success};
+  ip::tcp::acceptor acceptor{
+      ctx, {ip::address_v4::loopback(), mock_port + 3}, ec, true};
+  REQUIRE(ec.success());
+  ip::tcp::socket client{ctx};
+  REQUIRE(client.open(ip::tcp::v4()).success());
+  REQUIRE(
+      client.connect({ip::address_v4::loopback(), mock_port + 3}).success());
+  auto accepted = acceptor.accept();
+  REQUIRE(accepted.has_value());
+  ip::tcp::socket server = std::move(accepted.value());
+  REQUIRE(server.set_non_blocking(true).success());
+
+  // Everything queued is taken by one receive.
+  const std::string payload(3000, 'x');
+  REQUIRE(client.sync_send(payload.data(), payload.size(), 0).has_value());
+  while (server.available().value() < payload.size()) {
+    std::this_thread::yield();
+  }
+  std::string str = "head";
+  size_t received = 0;
+  auto recv = [&] {
+    sync_wait(async_recv_some(server, dynamic_buffer(str)) |
+              then([&](size_t n) noexcept { received = n; }) |
+              upon_error([](error_code&&) noexcept { CHECK(false); }));
+  };
+  recv();
+  CHECK(received == payload.size());
+  CHECK(str == "head" + payload);
+
+  // Nothing is queued, the receive waits without growing the buffer.
+  std::jthread sender([&] {
+    std::this_thread::sleep_for(50ms);
+    CHECK(client.sync_send("tail", 4, 0).has_value());
+  });
+  recv();
+  CHECK(received == 4);
+  CHECK(str == "head" + payload + "tail");
+
+  // The end of the stream is an error.
+  sender.join();
+  CHECK(client.close().success());
+  bool eof = false;
+  sync_wait(async_recv_some(server, dynamic_buffer(str)) |
+            then([](size_t) noexcept { CHECK(false); }) |
+            upon_error([&](error_code&& e) noexcept {
+              eof = e == make_error_code(network_errc::eof);
+            }));
+  CHECK(eof);
+  CHECK(str.size() == 4 + payload.size() + 4);
+}
+
+TEST_CASE("[inline io completions should complete the woken up receives]",
+          "[epoll_socket_recv_some_op.inline]") {
+  epoll_context ctx{};
+  ctx.set_inline_io_completions(true);
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  system_error2::system_code ec{system_error2::errc::success};
+  ip::tcp::acceptor acceptor{
+      ctx, {ip::address_v4::loopback(), mock_port + 4}, ec, true};
+  REQUIRE(ec.success());
+  ip::tcp::socket clients[2] = {ip::tcp::socket{ctx}, ip::tcp::socket{ctx}};
+  std::optional<ip::tcp::socket> servers[2];
+  for (int i = 0; i < 2; ++i) {
+    REQUIRE(clients[i].open(ip::tcp::v4()).success());
+    REQUIRE(clients[i]
+                .connect({ip::address_v4::loopback(), mock_port + 4})
+                .success());
+    auto accepted = acceptor.accept();
+    REQUIRE(accepted.has_value());
+    servers[i].emplace(std::move(accepted.value()));
+    REQUIRE(servers[i]->set_non_blocking(true).success());
+  }
+
+  // Both receives wait and are likely woken up by the same epoll_wait call.
+  // The first one closes its socket, releasing the descriptor state in the
+  // middle of the pass over the events.
+  std::jthread sender([&] {
+    std::this_thread::sleep_for(50ms);
+    CHECK(clients[0].sync_send("ab", 2, 0).has_value());
+    CHECK(clients[1].sync_send("cd", 2, 0).has_value());
+  });
+  char bufs[2][2];
+  size_t received = 0;
+  sync_wait(when_all(
+      async_recv_some(*servers[0], buffer(bufs[0])) |
+          then([&](size_t n) noexcept {
+            received += n;
+            CHECK(servers[0]->close().success());
+          }),
+      async_recv_some(*servers[1], buffer(bufs[1])) |
+          then([&](size_t n) noexcept { received += n; })));
+  CHECK(received == 4);
+  CHECK(std::string_view(bufs[0], 2) == "ab");
+  CHECK(std::string_view(bufs[1], 2) == "cd");
+}
+
+TEST_CASE("[flight recorder should record a parked receive]",
+          "[epoll_socket_recv_some_op.flight_recorder]") {
+  epoll_context ctx{};
+  CHECK(ctx.recorder() == nullptr);
+  ctx.enable_flight_recorder(256);
+  REQUIRE(ctx.recorder() != nullptr);
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  system_error2::system_code ec{system_error2::errc::success};
+  ip::tcp::acceptor acceptor{
+      ctx, {ip::address_v4::loopback(), mock_port + 5}, ec, true};
+  REQUIRE(ec.success());
+  ip::tcp::socket client{ctx};
+  REQUIRE(client.open(ip::tcp::v4()).success());
+  REQUIRE(
+      client.connect({ip::address_v4::loopback(), mock_port + 5}).success());
+  auto server = acceptor.accept();
+  REQUIRE(server.has_value());
+  REQUIRE(server->set_non_blocking(true).success());
+
+  std::jthread sender([&] {
+    std::this_thread::sleep_for(50ms);
+    CHECK(client.sync_send("ab", 2, 0).has_value());
+  });
+  char buf[2];
+  sync_wait(async_recv_some(*server, buffer(buf)));
+
+  // The receive was started by this thread, so it shows up in a drain.
+  std::vector<flight_event> events;
+  for (const auto& entry : ctx.recorder()->snapshot()) {
+    if (entry.event <= flight_event::op_cancel &&
+        entry.arg == server->native_handle()) {
+      CHECK(entry.kind == static_cast<uint8_t>(epoll_context::op_kind::recv));
+      events.push_back(entry.event);
+    }
+  }
+  CHECK(events == std::vector<flight_event>{flight_event::op_park,
+                                            flight_event::op_wakeup,
+                                            flight_event::op_complete});
+}
+
 // TEST_CASE("[]", "[epoll_socket_recv_some_op]") {}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <linux/net_tstamp.h>
+
+#include <array>
+#include <chrono>  // NOLINT
+#include <string>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "buffer.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_recv_timestamp_op.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/udp.hpp"
+#include "socket_base.hpp"
+#include "udp_socket.hpp"
+
+using net::epoll_context;
+using net::socket_base;
+using net::ip::udp;
+using namespace std::chrono_literals;  // NOLINT
+
+constexpr port_type mock_port = 12408;
+
+TEST_CASE("[recv_timestamp_sender should satisfy stdexec::sender]",
+          "[epoll_socket_recv_timestamp_op.concept]") {
+  CHECK(stdexec::sender<stdexec::__t<
+            net::__epoll::recv_timestamp_sender<udp, net::mutable_buffer>>>);
+}
+
+TEST_CASE("[async_recv_some_with_timestamp should report the rx timestamp]",
+          "[epoll_socket_recv_timestamp_op]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  udp::socket server = make_udp_socket(ctx, mock_port);
+  udp::socket client = make_udp_socket(ctx, mock_port + 1);
+  REQUIRE(server
+              .set_option(socket_base::timestamping{
+                  SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE})
+              .success());
+
+  std::string wbuf = "hello";
+  auto before = std::chrono::system_clock::now();
+  REQUIRE(
+      client.connect({net::ip::address_v4::loopback(), mock_port}).success());
+  REQUIRE(client.send(wbuf.data(), wbuf.size(), 0).has_value());
+  std::this_thread::sleep_for(10ms);
+
+  std::array<char, 16> rbuf{};
+  auto result = stdexec::sync_wait(
+      net::async_recv_some_with_timestamp(server, net::buffer(rbuf)));
+  REQUIRE(result.has_value());
+  auto [size, timestamps] = result.value();
+  CHECK(size == wbuf.size());
+  CHECK(std::string(rbuf.data(), size) == wbuf);
+  CHECK(timestamps.software >= before.time_since_epoch() - 1ms);
+  CHECK(timestamps.hardware.count() == 0);
+  // The datagram waited in the kernel for the sleep.
+  CHECK(timestamps.queueing_delay() >= 10ms);
+}
+
+TEST_CASE("[async_recv_some_with_timestamp without timestamping]",
+          "[epoll_socket_recv_timestamp_op]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  udp::socket server = make_udp_socket(ctx, mock_port + 2);
+  udp::socket client = make_udp_socket(ctx, mock_port + 3);
+  std::string wbuf = "x";
+  REQUIRE(client.connect({net::ip::address_v4::loopback(), mock_port + 2})
+              .success());
+  REQUIRE(client.send(wbuf.data(), wbuf.size(), 0).has_value());
+
+  std::array<char, 16> rbuf{};
+  auto result = stdexec::sync_wait(
+      net::async_recv_some_with_timestamp(server, net::buffer(rbuf)));
+  REQUIRE(result.has_value());
+  auto [size, timestamps] = result.value();
+  CHECK(size == 1);
+  CHECK(timestamps.software.count() == 0);
+  CHECK(timestamps.queueing_delay().count() == 0);
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <linux/tls.h>
+
+#include <cstdint>
+#include <string>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "buffer.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_recv_tls_record_op.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/tcp.hpp"
+#include "tcp_connection.hpp"
+
+using net::epoll_context;
+using net::__epoll::recv_tls_record_sender;
+
+constexpr port_type mock_port = 12377;
+
+TEST_CASE("[recv_tls_record_sender::__t should satisfy stdexec::sender]",
+          "[epoll_socket_recv_tls_record_op.concept]") {
+  CHECK(stdexec::sender<stdexec::__t<
+            recv_tls_record_sender<net::ip::tcp, net::mutable_buffer>>>);
+  CHECK(net::ktls_crypto_info<::tls12_crypto_info_aes_gcm_128>);
+  CHECK_FALSE(net::ktls_crypto_info<int>);
+}
+
+TEST_CASE("[async_recv_tls_record should tell the type of the records]",
+          "[epoll_socket_recv_tls_record_op.recv]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  connection conn{ctx, mock_port};
+  auto ec = conn.client.enable_tls();
+  if (ec == system_error2::errc::no_such_file_or_directory) {
+    WARN("the kernel has no TLS support");
+    return;
+  }
+  REQUIRE(ec.success());
+  REQUIRE(conn.server.enable_tls().success());
+
+  // Both sides use the same all-zero keys, as if negotiated by a handshake.
+  using direction = net::ip::tcp::socket::tls_direction;
+  ::tls12_crypto_info_aes_gcm_128 info{};
+  info.info.version = TLS_1_2_VERSION;
+  info.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+  REQUIRE(conn.client.set_tls_crypto(direction::tx, info).success());
+  REQUIRE(conn.server.set_tls_crypto(direction::rx, info).success());
+
+  std::string payload = "hello";
+  CHECK(conn.client.sync_send(payload.data(), payload.size(), 0).has_value());
+  const uint8_t alert[] = {1, 0};  // warning, close_notify
+  constexpr uint8_t alert_record = 21;
+  CHECK(conn.client.non_blocking_send_tls_record(alert, sizeof(alert),
+                                                 alert_record)
+            .has_value());
+
+  char buf[64] = {};
+  std::size_t received = 0;
+  uint8_t type = 0;
+  auto recv = [&] {
+    stdexec::sync_wait(
+        net::async_recv_tls_record(conn.server, net::buffer(buf)) |
+        stdexec::then([&](std::size_t n, uint8_t t) noexcept {
+          received = n;
+          type = t;
+        }) |
+        stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  };
+  recv();
+  CHECK(type == net::ip::tcp::socket::tls_application_data);
+  CHECK(std::string(buf, received) == "hello");
+  recv();
+  CHECK(type == alert_record);
+  CHECK(received == sizeof(alert));
+}
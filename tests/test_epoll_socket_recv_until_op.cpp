@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <chrono>        // NOLINT
+#include <cstring>
+#include <string>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "buffer.hpp"
+#include "dynamic_ring_buffer.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_recv_until_op.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/tcp.hpp"
+#include "tcp_connection.hpp"
+
+using net::epoll_context;
+using namespace std::chrono_literals;  // NOLINT
+
+constexpr port_type mock_port = 12376;
+
+TEST_CASE("[async_recv_until should wait for a delimiter split across sends]",
+          "[epoll_socket_recv_until_op]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  connection conn{ctx, mock_port};
+
+  std::jthread writer([&conn] {
+    for (const char* piece : {"GET / HTTP/1.1\r", "\nHost: a\r\n"}) {
+      std::this_thread::sleep_for(20ms);
+      CHECK(conn.client.sync_send(piece, std::strlen(piece), 0).has_value());
+    }
+  });
+
+  std::string data;
+  std::size_t length = 0;
+  stdexec::sync_wait(
+      net::async_recv_until(conn.server, net::dynamic_buffer(data), "\r\n") |
+      stdexec::then([&length](std::size_t n) noexcept { length = n; }) |
+      stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  CHECK(length == 16);
+  CHECK(data.substr(0, length) == "GET / HTTP/1.1\r\n");
+
+  // The rest of the request may already be in the buffer.
+  data.erase(0, length);
+  stdexec::sync_wait(
+      net::async_recv_until(conn.server, net::dynamic_buffer(data), "\r\n") |
+      stdexec::then([&length](std::size_t n) noexcept { length = n; }) |
+      stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  CHECK(data.substr(0, length) == "Host: a\r\n");
+}
+
+TEST_CASE("[async_recv_until should work with a referenced ring buffer]",
+          "[epoll_socket_recv_until_op]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  connection conn{ctx, mock_port + 1};
+  CHECK(conn.client.sync_send("one\ntwo\n", 8, 0).has_value());
+
+  net::dynamic_ring_buffer ring{16};
+  std::vector<std::string> lines;
+  for (int i = 0; i < 2; ++i) {
+    stdexec::sync_wait(
+        net::async_recv_until(conn.server, ring, "\n") |
+        stdexec::then([&](std::size_t n) noexcept {
+          std::string line(n, '\0');
+          net::buffer_copy(net::buffer(line), ring.data());
+          ring.consume(n);
+          lines.push_back(line);
+        }) |
+        stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  }
+  CHECK(lines == std::vector<std::string>{"one\n", "two\n"});
+}
+
+TEST_CASE("[async_recv_until should fail once the buffer is full]",
+          "[epoll_socket_recv_until_op]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  connection conn{ctx, mock_port + 2};
+  CHECK(conn.client.sync_send("no delimiter here", 17, 0).has_value());
+
+  std::string data;
+  std::error_code error;
+  stdexec::sync_wait(
+      net::async_recv_until(conn.server, net::dynamic_buffer(data, 8), "\n") |
+      stdexec::then([](std::size_t) noexcept { CHECK(false); }) |
+      stdexec::upon_error(
+          [&error](std::error_code&& ec) noexcept { error = ec; }));
+  CHECK(error == std::make_error_code(std::errc::no_buffer_space));
+  CHECK(data == "no delim");
+}
+
+TEST_CASE("[async_recv_until should fail with eof before the delimiter]",
+          "[epoll_socket_recv_until_op]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  connection conn{ctx, mock_port + 3};
+  CHECK(conn.client.sync_send("partial", 7, 0).has_value());
+  conn.client.close();
+
+  std::string data;
+  std::error_code error;
+  stdexec::sync_wait(
+      net::async_recv_until(conn.server, net::dynamic_buffer(data), "\n") |
+      stdexec::then([](std::size_t) noexcept { CHECK(false); }) |
+      stdexec::upon_error(
+          [&error](std::error_code&& ec) noexcept { error = ec; }));
+  CHECK(error == make_error_code(net::network_errc::eof));
+  CHECK(data == "partial");
+}
@@ -13,6 +13,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <latch>  // NOLINT
 #include <stdexcept>
 #include <system_error>  // NOLINT
 #include <thread>        // NOLINT
@@ -28,11 +29,13 @@
 #include "buffer_sequence_adapter.hpp"
 #include "epoll/epoll_context.hpp"
 #include "epoll/socket_accept_op.hpp"
+#include "epoll/socket_recv_some_op.hpp"
 #include "epoll/socket_send_some_op.hpp"
 #include "ip/tcp.hpp"
 #include "ip/udp.hpp"
 #include "stdexec.hpp"
 #include "stdexec/execution.hpp"
+#include "tcp_connection.hpp"
 #include "test_common/receivers.hpp"
 
 using namespace stdexec;       // NOLINT
@@ -261,6 +264,82 @@ TEST_CASE("[async_send_some with different stdexec stuffs should work]",
   stdexec::sync_wait(std::move(s10));
 }
 
+TEST_CASE("[async_send_some and async_recv_some can wait on the same socket]",
+          "[epoll_socket_send_some_op.full_duplex]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  // Create a connected pair of sockets.
+  system_error2::system_code ec{system_error2::errc::success};
+  ip::tcp::acceptor acceptor{ctx, {ip::address_v4::any(), mock_port}, ec, true};
+  REQUIRE(ec.success());
+  connection conn{ctx, acceptor, mock_port};
+  ip::tcp::socket& client = conn.client;
+  ip::tcp::socket& server = conn.server;
+
+  // Fill up the send buffer so that the next send has to wait.
+  std::string wbuf(64 * 1024, 'x');
+  size_t filled = 0;
+  for (auto res = server.non_blocking_send(wbuf.data(), wbuf.size(), 0);
+       res.has_value();
+       res = server.non_blocking_send(wbuf.data(), wbuf.size(), 0)) {
+    filled += res.value();
+  }
+
+  // Both operations are parked on the socket at the same time, then the peer
+  // sends something and drains the data. The slots belong to the io thread,
+  // so they are checked there, and the peer waits for the check.
+  std::latch parked{1};
+  bool hello_sent = false;
+  size_t drained = 0;
+  std::jthread client_thread([&client, &parked, &hello_sent, &drained,
+                              filled] {
+    parked.wait();
+    auto res = client.send("hello", 5, 0);
+    hello_sent = res.has_value() && res.value() == 5;
+    std::string buf(64 * 1024, ' ');
+    while (drained < filled) {
+      auto res = client.recv(buf.data(), buf.size(), 0);
+      if (!res.has_value()) {
+        break;
+      }
+      drained += res.value();
+    }
+  });
+
+  auto both_parked = [&server] {
+    auto* state =
+        static_cast<epoll_context::descriptor_state*>(server.descriptor_data());
+    return state != nullptr &&
+           state->ops_[epoll_context::descriptor_state::read_slot] != nullptr &&
+           state->ops_[epoll_context::descriptor_state::write_slot] != nullptr;
+  };
+  std::string rbuf(1024, ' ');
+  size_t received = 0;
+  size_t sent = 0;
+  sender auto s = when_all(
+      async_recv_some(server, buffer(rbuf))  //
+          | then([&received](size_t sz) noexcept { received = sz; }),
+      async_send_some(server, buffer(wbuf))  //
+          | then([&sent](size_t sz) noexcept { sent = sz; }),
+      schedule(ctx.get_scheduler())  //
+          | then(both_parked)        //
+          | repeat_effect_until()    //
+          | then([&parked]() noexcept { parked.count_down(); }));
+  sync_wait(std::move(s));
+  client_thread.join();
+  CHECK(received == 5);
+  CHECK(sent > 0);
+  CHECK(hello_sent);
+  CHECK(drained >= filled);
+  CHECK(server.close().success());
+  CHECK(client.close().success());
+  CHECK(acceptor.close().success());
+}
+
 // TODO: need async_connect cpo
 // TEST_CASE("[CPO: `start` performed operation]",
 //           "[epoll_socket_send_some_op.start]") {
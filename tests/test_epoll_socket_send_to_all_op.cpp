@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <chrono>        // NOLINT
+#include <string>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_send_to_all_op.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/tcp.hpp"
+#include "shared_buffer_chain.hpp"
+#include "tcp_connection.hpp"
+
+using net::epoll_context;
+using net::__epoll::send_to_all_sender;
+using namespace std::chrono_literals;  // NOLINT
+
+constexpr port_type mock_port = 12400;
+
+TEST_CASE("[send_to_all_sender::__t should satisfy stdexec::sender]",
+          "[epoll_socket_send_to_all_op.concept]") {
+  CHECK(stdexec::sender<stdexec::__t<
+            send_to_all_sender<net::ip::tcp, net::shared_buffer_chain>>>);
+}
+
+TEST_CASE("[async_send_to_all should send the payload to every socket]",
+          "[epoll_socket_send_to_all_op.send]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  connection first{ctx, mock_port};
+  connection second{ctx, mock_port + 1};
+  net::ip::tcp::socket closed{ctx};
+  std::vector<net::ip::tcp::socket*> sockets{&first.server, &closed,
+                                             &second.server};
+
+  std::string payload = "broadcast";
+  auto chain = net::shared_buffer_chain::copy(
+      net::buffer(payload.data(), payload.size()));
+
+  std::vector<std::error_code> results;
+  stdexec::sync_wait(
+      net::async_send_to_all(sockets, chain) |
+      stdexec::then([&results](std::vector<std::error_code> r) noexcept {
+        results = std::move(r);
+      }));
+  REQUIRE(results.size() == 3);
+  CHECK(!results[0]);
+  CHECK(results[1]);
+  CHECK(!results[2]);
+  CHECK(recv_all(first.client, payload.size()) == payload);
+  CHECK(recv_all(second.client, payload.size()) == payload);
+
+  // An empty set completes at once.
+  std::vector<net::ip::tcp::socket*> none{};
+  results.resize(1);
+  stdexec::sync_wait(
+      net::async_send_to_all(none, chain) |
+      stdexec::then([&results](std::vector<std::error_code> r) noexcept {
+        results = std::move(r);
+      }));
+  CHECK(results.empty());
+}
+
+TEST_CASE("[async_send_to_all should wait for the slow sockets]",
+          "[epoll_socket_send_to_all_op.wait]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  connection first{ctx, mock_port + 2};
+  connection second{ctx, mock_port + 3};
+  std::vector<net::ip::tcp::socket*> sockets{&first.server, &second.server};
+
+  // The payload doesn't fit the socket buffers, so both sockets are parked
+  // until the readers drain them.
+  std::string payload(8 * 1024 * 1024, 'x');
+  auto chain = net::shared_buffer_chain::copy(
+      net::buffer(payload.data(), payload.size()));
+  std::jthread reader([&] {
+    std::this_thread::sleep_for(50ms);
+    CHECK(recv_all(first.client, payload.size()) == payload);
+    CHECK(recv_all(second.client, payload.size()) == payload);
+  });
+
+  std::vector<std::error_code> results;
+  stdexec::sync_wait(
+      net::async_send_to_all(sockets, chain) |
+      stdexec::then([&results](std::vector<std::error_code> r) noexcept {
+        results = std::move(r);
+      }));
+  REQUIRE(results.size() == 2);
+  CHECK(!results[0]);
+  CHECK(!results[1]);
+}
+
+TEST_CASE("[async_send_to_all should be stopped while sockets are parked]",
+          "[epoll_socket_send_to_all_op.stop]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  connection first{ctx, mock_port + 4};
+  std::vector<net::ip::tcp::socket*> sockets{&first.server};
+  std::string payload(64 * 1024 * 1024, 'x');
+  auto chain = net::shared_buffer_chain::copy(
+      net::buffer(payload.data(), payload.size()));
+
+  bool stopped = false;
+  stdexec::sync_wait(exec::when_any(
+      net::async_send_to_all(sockets, chain) |
+          stdexec::then([](std::vector<std::error_code>) noexcept {
+            CHECK(false);
+          }),
+      exec::schedule_after(ctx.get_scheduler(), 50ms) |
+          stdexec::then([&stopped] { stopped = true; })));
+  CHECK(stopped);
+
+  // The operation has left the slot of the socket.
+  using descriptor_state = epoll_context::descriptor_state;
+  auto* state = static_cast<descriptor_state*>(first.server.descriptor_data());
+  REQUIRE(state != nullptr);
+  CHECK(state->ops_[descriptor_state::write_slot] == nullptr);
+}
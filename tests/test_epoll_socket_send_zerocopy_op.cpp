@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <string>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "buffer.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_send_zerocopy_op.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/tcp.hpp"
+#include "tcp_connection.hpp"
+
+using net::epoll_context;
+using net::__epoll::send_zerocopy_sender;
+
+constexpr port_type mock_port = 12354;
+
+TEST_CASE("[send_zerocopy_sender::__t should satisfy stdexec::sender]",
+          "[epoll_socket_send_zerocopy_op.concept]") {
+  CHECK(stdexec::sender<
+        stdexec::__t<send_zerocopy_sender<net::ip::tcp, net::const_buffer>>>);
+}
+
+TEST_CASE("[async_send_zerocopy should send everything and be notified]",
+          "[epoll_socket_send_zerocopy_op.send]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  connection conn{ctx, mock_port};
+  net::ip::tcp::socket& client = conn.client;
+  net::ip::tcp::socket& server = conn.server;
+
+  // The payload is larger than the socket buffers, so the operation has to
+  // wait for the peer in between.
+  std::string payload(4 * 1024 * 1024, 'z');
+  std::size_t drained = 0;
+  std::jthread reader([&client, &drained, total = payload.size() * 2] {
+    std::vector<char> buf(64 * 1024);
+    while (drained < total) {
+      auto res = client.sync_recv(buf.data(), buf.size(), 0);
+      if (!res.has_value() || res.value() == 0) {
+        break;
+      }
+      drained += res.value();
+    }
+  });
+
+  // Two operations in turn keep numbering the sends of the socket.
+  for (int i = 0; i < 2; ++i) {
+    std::size_t sent = 0;
+    stdexec::sync_wait(
+        net::async_send_zerocopy(server, net::buffer(payload)) |
+        stdexec::then([&sent](std::size_t size, bool) noexcept {
+          sent = size;
+        }) |
+        stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+    CHECK(sent == payload.size());
+  }
+  reader.join();
+  CHECK(drained == payload.size() * 2);
+  auto* state =
+      static_cast<epoll_context::descriptor_state*>(server.descriptor_data());
+  REQUIRE(state != nullptr);
+  CHECK(state->zerocopy_enabled_);
+  CHECK(state->zerocopy_sequence_ > 0);
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdio.h>
+#include <unistd.h>
+
+#include <string>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_sendfile_op.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/tcp.hpp"
+#include "tcp_connection.hpp"
+
+using net::epoll_context;
+using net::__epoll::sendfile_sender;
+
+constexpr port_type mock_port = 12356;
+
+TEST_CASE("[sendfile_sender::__t should satisfy stdexec::sender]",
+          "[epoll_socket_sendfile_op.concept]") {
+  CHECK(stdexec::sender<stdexec::__t<sendfile_sender<net::ip::tcp>>>);
+}
+
+TEST_CASE("[async_sendfile should send the requested range of a file]",
+          "[epoll_socket_sendfile_op.sendfile]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  // The file is larger than the socket buffers, so the operation has to wait
+  // for the peer in between.
+  std::string content(4 * 1024 * 1024, 'f');
+  content.front() = 'a';
+  FILE* file = ::tmpfile();
+  REQUIRE(file != nullptr);
+  exec::scope_guard on_file_exit{[file]() noexcept { ::fclose(file); }};
+  REQUIRE(::write(::fileno(file), content.data(), content.size()) ==
+          static_cast<ssize_t>(content.size()));
+
+  connection conn{ctx, mock_port};
+  net::ip::tcp::socket& client = conn.client;
+  net::ip::tcp::socket& server = conn.server;
+
+  std::string received;
+  std::jthread reader([&client, &received] {
+    std::vector<char> buf(64 * 1024);
+    while (true) {
+      auto res = client.sync_recv(buf.data(), buf.size(), 0);
+      if (!res.has_value() || res.value() == 0) {
+        break;
+      }
+      received.append(buf.data(), res.value());
+    }
+  });
+
+  // Skip the first byte and ask for more than the rest of the file.
+  std::size_t sent = 0;
+  stdexec::sync_wait(
+      net::async_sendfile(server, ::fileno(file), 1, content.size()) |
+      stdexec::then([&sent](std::size_t size) noexcept { sent = size; }) |
+      stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  CHECK(sent == content.size() - 1);
+  using shutdown_type = net::socket_base::shutdown_type;
+  CHECK(server.shutdown(shutdown_type::shutdown_send).success());
+  reader.join();
+  CHECK(received == content.substr(1));
+}
+
+TEST_CASE("[async_sendfile should report an invalid file]",
+          "[epoll_socket_sendfile_op.sendfile]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  net::ip::tcp::socket socket{ctx};
+  REQUIRE(socket.open(net::ip::tcp::v4()).success());
+  bool failed = false;
+  stdexec::sync_wait(
+      net::async_sendfile(socket, -1, 0, 16) |
+      stdexec::then([](std::size_t) noexcept { CHECK(false); }) |
+      stdexec::upon_error(
+          [&failed](std::error_code&&) noexcept { failed = true; }));
+  CHECK(failed);
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <chrono>        // NOLINT
+#include <string>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_splice_op.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/tcp.hpp"
+#include "pipe.hpp"
+#include "tcp_connection.hpp"
+
+using net::epoll_context;
+using net::__epoll::splice_sender;
+using namespace std::chrono_literals;  // NOLINT
+
+constexpr port_type mock_port = 12357;
+
+TEST_CASE("[splice_sender::__t should satisfy stdexec::sender]",
+          "[epoll_socket_splice_op.concept]") {
+  CHECK(stdexec::sender<stdexec::__t<splice_sender<net::ip::tcp>>>);
+}
+
+TEST_CASE("[pipe should be created non-blocking]", "[pipe.ctor]") {
+  net::pipe pipe{};
+  CHECK(pipe.read_end() >= 0);
+  CHECK(pipe.write_end() >= 0);
+  char data = 0;
+  CHECK(::read(pipe.read_end(), &data, 1) < 0);
+  CHECK(errno == EAGAIN);
+}
+
+TEST_CASE("[async_splice should move data from one socket to another]",
+          "[epoll_socket_splice_op.splice]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  connection in{ctx, mock_port};
+  connection out{ctx, mock_port + 1};
+  net::pipe pipe{};
+
+  // The data arrives after the operation has started waiting.
+  std::jthread writer([&in] {
+    std::this_thread::sleep_for(100ms);
+    std::string payload = "spliced data";
+    CHECK(in.client.sync_send(payload.data(), payload.size(), 0).has_value());
+  });
+
+  std::size_t moved = 0;
+  stdexec::sync_wait(
+      net::async_splice(in.server, out.server, pipe, 64 * 1024) |
+      stdexec::then([&moved](std::size_t size) noexcept { moved = size; }) |
+      stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  CHECK(moved == 12);
+
+  char buf[64] = {};
+  auto res = out.client.sync_recv(buf, sizeof(buf), 0);
+  REQUIRE(res.has_value());
+  CHECK(std::string(buf, res.value()) == "spliced data");
+
+  // The source is closed by its peer.
+  writer.join();
+  CHECK(in.client.close().success());
+  moved = 1;
+  stdexec::sync_wait(
+      net::async_splice(in.server, out.server, pipe, 64 * 1024) |
+      stdexec::then([&moved](std::size_t size) noexcept { moved = size; }));
+  CHECK(moved == 0);
+}
+
+TEST_CASE("[async_splice should be stopped while waiting for data]",
+          "[epoll_socket_splice_op.stop]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  connection in{ctx, mock_port + 2};
+  connection out{ctx, mock_port + 3};
+  net::pipe pipe{};
+
+  bool stopped = false;
+  stdexec::sync_wait(exec::when_any(
+      net::async_splice(in.server, out.server, pipe, 1024) |
+          stdexec::then([](std::size_t) noexcept { CHECK(false); }) |
+          stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }),
+      exec::schedule_after(ctx.get_scheduler(), 50ms) |
+          stdexec::then([&stopped] { stopped = true; })));
+  CHECK(stopped);
+
+  // The operation has left the slot of the source.
+  using descriptor_state = epoll_context::descriptor_state;
+  auto* state = static_cast<descriptor_state*>(in.server.descriptor_data());
+  REQUIRE(state != nullptr);
+  CHECK(state->ops_[descriptor_state::read_slot] == nullptr);
+}
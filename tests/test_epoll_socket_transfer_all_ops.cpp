@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <array>
+#include <chrono>        // NOLINT
+#include <cstring>
+#include <string>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "buffer.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_recv_exactly_op.hpp"
+#include "epoll/socket_send_all_op.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/tcp.hpp"
+#include "net_error.hpp"
+#include "tcp_connection.hpp"
+
+using net::epoll_context;
+using net::__epoll::recv_exactly_sender;
+using net::__epoll::send_all_sender;
+using namespace std::chrono_literals;  // NOLINT
+
+constexpr port_type mock_port = 12362;
+
+TEST_CASE("[send_all_sender::__t and recv_exactly_sender::__t are senders]",
+          "[epoll_socket_transfer_all_ops.concept]") {
+  CHECK(stdexec::sender<
+        stdexec::__t<send_all_sender<net::ip::tcp, net::const_buffer>>>);
+  CHECK(stdexec::sender<stdexec::__t<
+            recv_exactly_sender<net::ip::tcp, net::mutable_buffer>>>);
+}
+
+TEST_CASE("[async_send_all should send a buffer sequence larger than the "
+          "socket buffers]",
+          "[epoll_socket_transfer_all_ops.send_all]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  connection conn{ctx, mock_port};
+
+  std::string head(16, 'h');
+  std::string body(4 * 1024 * 1024, 'b');
+  std::vector<net::const_buffer> bufs{net::buffer(head), net::buffer(body)};
+  std::size_t received = 0;
+  std::jthread reader([&conn, &received, total = head.size() + body.size()] {
+    std::vector<char> buf(64 * 1024);
+    while (received < total) {
+      auto res = conn.client.sync_recv(buf.data(), buf.size(), 0);
+      if (!res.has_value() || res.value() == 0) {
+        break;
+      }
+      received += res.value();
+    }
+  });
+
+  std::size_t sent = 0;
+  stdexec::sync_wait(
+      net::async_send_all(conn.server, bufs) |
+      stdexec::then([&sent](std::size_t size) noexcept { sent = size; }) |
+      stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  reader.join();
+  CHECK(sent == head.size() + body.size());
+  CHECK(received == sent);
+}
+
+TEST_CASE("[async_send_all should send more buffers than a single call takes]",
+          "[epoll_socket_transfer_all_ops.send_all]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  connection conn{ctx, mock_port + 3};
+
+  // Many small fragments, as a response builder emits them.
+  std::vector<std::string> fragments;
+  std::vector<net::const_buffer> bufs;
+  std::string expected;
+  for (int i = 0; i < 300; ++i) {
+    fragments.push_back(std::to_string(i) + ",");
+  }
+  for (const auto& fragment : fragments) {
+    bufs.push_back(net::buffer(fragment));
+    expected += fragment;
+  }
+
+  std::size_t sent = 0;
+  stdexec::sync_wait(
+      net::async_send_all(conn.server, bufs) |
+      stdexec::then([&sent](std::size_t size) noexcept { sent = size; }) |
+      stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  CHECK(sent == expected.size());
+
+  std::string received(expected.size(), '\0');
+  std::size_t offset = 0;
+  while (offset < received.size()) {
+    auto res = conn.client.sync_recv(received.data() + offset,
+                                     received.size() - offset, 0);
+    REQUIRE(res.has_value());
+    REQUIRE(res.value() != 0);
+    offset += res.value();
+  }
+  CHECK(received == expected);
+}
+
+TEST_CASE("[async_recv_exactly should wait for every byte]",
+          "[epoll_socket_transfer_all_ops.recv_exactly]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  connection conn{ctx, mock_port + 1};
+
+  // The data arrives in several pieces.
+  std::jthread writer([&conn] {
+    for (const char* piece : {"abc", "defg", "hij"}) {
+      std::this_thread::sleep_for(20ms);
+      CHECK(conn.client.sync_send(piece, std::strlen(piece), 0).has_value());
+    }
+  });
+
+  std::array<char, 4> first{};
+  std::array<char, 6> second{};
+  std::array<net::mutable_buffer, 2> bufs{net::buffer(first),
+                                          net::buffer(second)};
+  std::size_t received = 0;
+  stdexec::sync_wait(
+      net::async_recv_exactly(conn.server, bufs) |
+      stdexec::then([&received](std::size_t size) noexcept {
+        received = size;
+      }) |
+      stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  CHECK(received == 10);
+  CHECK(std::string(first.data(), first.size()) == "abcd");
+  CHECK(std::string(second.data(), second.size()) == "efghij");
+}
+
+TEST_CASE("[async_recv_exactly should report eof before the buffer is full]",
+          "[epoll_socket_transfer_all_ops.recv_exactly]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  connection conn{ctx, mock_port + 2};
+  CHECK(conn.client.sync_send("ab", 2, 0).has_value());
+  CHECK(conn.client.close().success());
+
+  char buf[8];
+  std::error_code error{};
+  stdexec::sync_wait(
+      net::async_recv_exactly(conn.server, net::buffer(buf)) |
+      stdexec::then([](std::size_t) noexcept { CHECK(false); }) |
+      stdexec::upon_error(
+          [&error](std::error_code&& ec) noexcept { error = ec; }));
+  CHECK(error == make_error_code(net::network_errc::eof));
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <chrono>        // NOLINT
+#include <string>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_wait_op.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/tcp.hpp"
+#include "socket_base.hpp"
+#include "tcp_connection.hpp"
+
+using net::epoll_context;
+using net::__epoll::wait_sender;
+using wait_type = net::socket_base::wait_type;
+using namespace std::chrono_literals;  // NOLINT
+
+constexpr port_type mock_port = 12367;
+
+TEST_CASE("[wait_sender::__t should satisfy stdexec::sender]",
+          "[epoll_socket_wait_op.concept]") {
+  CHECK(stdexec::sender<stdexec::__t<wait_sender<net::ip::tcp>>>);
+}
+
+TEST_CASE("[async_wait should complete once the socket is readable]",
+          "[epoll_socket_wait_op.wait]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  connection conn{ctx, mock_port};
+
+  // A fresh connection is writable right away.
+  bool writable = false;
+  stdexec::sync_wait(
+      net::async_wait(conn.server, wait_type::wait_write) |
+      stdexec::then([&writable]() noexcept { writable = true; }) |
+      stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  CHECK(writable);
+
+  // The data arrives after the operation has started waiting.
+  std::jthread writer([&conn] {
+    std::this_thread::sleep_for(100ms);
+    std::string payload = "ready";
+    CHECK(conn.client.sync_send(payload.data(), payload.size(), 0)
+              .has_value());
+  });
+  bool readable = false;
+  stdexec::sync_wait(
+      net::async_wait(conn.server, wait_type::wait_read) |
+      stdexec::then([&readable]() noexcept { readable = true; }) |
+      stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }));
+  CHECK(readable);
+
+  // Nothing has been read by the wait.
+  char buf[16] = {};
+  auto res = conn.server.sync_recv(buf, sizeof(buf), 0);
+  REQUIRE(res.has_value());
+  CHECK(std::string(buf, res.value()) == "ready");
+}
+
+TEST_CASE("[async_wait should be stopped while the socket is not ready]",
+          "[epoll_socket_wait_op.stop]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  connection conn{ctx, mock_port + 1};
+
+  bool stopped = false;
+  stdexec::sync_wait(exec::when_any(
+      net::async_wait(conn.server, wait_type::wait_read) |
+          stdexec::then([]() noexcept { CHECK(false); }) |
+          stdexec::upon_error([](std::error_code&&) noexcept { CHECK(false); }),
+      exec::schedule_after(ctx.get_scheduler(), 50ms) |
+          stdexec::then([&stopped] { stopped = true; })));
+  CHECK(stopped);
+
+  // The operation has left the read slot.
+  using descriptor_state = epoll_context::descriptor_state;
+  auto* state = static_cast<descriptor_state*>(conn.server.descriptor_data());
+  REQUIRE(state != nullptr);
+  CHECK(state->ops_[descriptor_state::read_slot] == nullptr);
+}
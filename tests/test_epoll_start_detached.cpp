@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <atomic>
+#include <thread>  // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "stdexec.hpp"
+
+#include "epoll/epoll_context.hpp"
+#include "epoll/start_detached.hpp"
+#include "size_class_pool.hpp"
+
+using net::epoll_context;
+using net::size_class_pool;
+
+TEST_CASE("[size_class_pool should recycle blocks of the same class]",
+          "[size_class_pool]") {
+  size_class_pool pool{2};
+  CHECK(size_class_pool::block_size(1) == 64);
+  CHECK(size_class_pool::block_size(65) == 128);
+  CHECK(size_class_pool::block_size(10000) == 10000);
+
+  void* p1 = pool.allocate(100);
+  void* p2 = pool.allocate(120);
+  void* p3 = pool.allocate(128);
+  pool.deallocate(p1, 100);
+  pool.deallocate(p2, 120);
+  // Beyond the cap of the class.
+  pool.deallocate(p3, 128);
+  CHECK(pool.cached_count() == 2);
+
+  CHECK(pool.allocate(128) == p2);
+  CHECK(pool.allocate(65) == p1);
+  CHECK(pool.reuse_count() == 2);
+  CHECK(pool.cached_count() == 0);
+  pool.deallocate(p1, 65);
+  pool.deallocate(p2, 128);
+
+  // Not cached.
+  void* big = pool.allocate(size_class_pool::max_block_size + 1);
+  pool.deallocate(big, size_class_pool::max_block_size + 1);
+  CHECK(pool.cached_count() == 2);
+}
+
+TEST_CASE("[start_detached should recycle operation states on the io thread]",
+          "[epoll_start_detached]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  constexpr int count = 1000;
+  std::atomic<int> completed = 0;
+  stdexec::sync_wait(
+      stdexec::schedule(ctx.get_scheduler()) |
+      stdexec::then([&ctx, &completed] {
+        for (int i = 0; i < count; ++i) {
+          net::start_detached(ctx, stdexec::schedule(ctx.get_scheduler()) |
+                                       stdexec::then([&completed] {
+                                         completed.fetch_add(1);
+                                       }));
+        }
+      }));
+  while (completed.load() < count) {
+    std::this_thread::yield();
+  }
+
+  // The next round reuses the freed operation states.
+  stdexec::sync_wait(
+      stdexec::schedule(ctx.get_scheduler()) |
+      stdexec::then([&ctx, &completed] {
+        for (int i = 0; i < count; ++i) {
+          net::start_detached(ctx, stdexec::schedule(ctx.get_scheduler()) |
+                                       stdexec::then([&completed] {
+                                         completed.fetch_add(1);
+                                       }));
+        }
+      }));
+  while (completed.load() < 2 * count) {
+    std::this_thread::yield();
+  }
+  stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler()));
+  CHECK(ctx.operation_pool().reuse_count() >= count);
+}
+
+TEST_CASE("[start_detached from a remote thread should use the heap]",
+          "[epoll_start_detached]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  std::atomic<bool> done = false;
+  net::start_detached(ctx, stdexec::schedule(ctx.get_scheduler()) |
+                               stdexec::then([&done] { done = true; }));
+  while (!done.load()) {
+    std::this_thread::yield();
+  }
+  stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler()));
+  // Freed on the io thread into the pool.
+  CHECK(ctx.operation_pool().cached_count() == 1);
+}
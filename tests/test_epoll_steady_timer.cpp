@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "stdexec.hpp"
+
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_wait_op.hpp"
+#include "epoll/steady_timer.hpp"
+#include "io_thread.hpp"
+
+using net::epoll_context;
+using net::__epoll::timer_wait_sender;
+using namespace std::chrono_literals;  // NOLINT
+
+TEST_CASE("[timer_wait_sender::__t should satisfy stdexec::sender]",
+          "[epoll_steady_timer.concept]") {
+  STATIC_REQUIRE(stdexec::sender<stdexec::__t<timer_wait_sender>>);
+}
+
+TEST_CASE("[a timer that has not been set should complete waits at once]",
+          "[epoll_steady_timer]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  net::steady_timer timer{ctx};
+
+  bool expired = false;
+  stdexec::sync_wait(net::async_wait(timer) |
+                     stdexec::then([&] { expired = true; }));
+  CHECK(expired);
+  ctx.request_stop();
+}
+
+TEST_CASE("[concurrent waits should complete together at the expiry]",
+          "[epoll_steady_timer]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  net::steady_timer timer{ctx};
+
+  const auto start = std::chrono::steady_clock::now();
+  on_io_thread(ctx, [&] { timer.expires_after(50ms); });
+  std::atomic<int> expired{0};
+  auto wait = [&] {
+    return net::async_wait(timer) | stdexec::then([&] {
+             CHECK(ctx.is_running_on_io_thread());
+             ++expired;
+           });
+  };
+  stdexec::sync_wait(stdexec::when_all(wait(), wait(), wait()));
+  CHECK(expired == 3);
+  CHECK(std::chrono::steady_clock::now() - start >= 40ms);
+  ctx.request_stop();
+}
+
+TEST_CASE("[pushing the expiry back should delay the pending waits]",
+          "[epoll_steady_timer]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  net::steady_timer timer{ctx};
+
+  on_io_thread(ctx, [&] { timer.expires_after(50ms); });
+  std::chrono::steady_clock::time_point last_rearm;
+  std::jthread keepalive([&] {
+    // Re-arm like a keepalive does on every packet.
+    for (int i = 0; i < 10; ++i) {
+      std::this_thread::sleep_for(10ms);
+      on_io_thread(ctx, [&] {
+        timer.expires_after(50ms);
+        last_rearm = std::chrono::steady_clock::now();
+      });
+    }
+  });
+  stdexec::sync_wait(net::async_wait(timer));
+  const auto expired = std::chrono::steady_clock::now();
+  keepalive.join();
+  CHECK(expired - last_rearm >= 40ms);
+  ctx.request_stop();
+}
+
+TEST_CASE("[pulling the expiry in should complete the pending waits early]",
+          "[epoll_steady_timer]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  net::steady_timer timer{ctx};
+
+  on_io_thread(ctx, [&] { timer.expires_after(10s); });
+  std::jthread rearm([&] {
+    std::this_thread::sleep_for(20ms);
+    on_io_thread(ctx, [&] { timer.expires_after(10ms); });
+  });
+  const auto start = std::chrono::steady_clock::now();
+  stdexec::sync_wait(net::async_wait(timer));
+  CHECK(std::chrono::steady_clock::now() - start < 5s);
+  ctx.request_stop();
+}
+
+TEST_CASE("[cancel should complete every pending wait with stopped]",
+          "[epoll_steady_timer]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  net::steady_timer timer{ctx};
+
+  on_io_thread(ctx, [&] { timer.expires_after(10s); });
+  std::atomic<int> stopped{0};
+  auto wait = [&] {
+    return net::async_wait(timer) | stdexec::then([] { CHECK(false); }) |
+           stdexec::upon_stopped([&] { ++stopped; });
+  };
+  std::jthread canceler([&] {
+    std::this_thread::sleep_for(20ms);
+    std::size_t canceled = 0;
+    on_io_thread(ctx, [&] { canceled = timer.cancel(); });
+    CHECK(canceled == 2);
+  });
+  stdexec::sync_wait(stdexec::when_all(wait(), wait()));
+  CHECK(stopped == 2);
+  ctx.request_stop();
+}
+
+TEST_CASE("[stopping one wait should leave the others waiting]",
+          "[epoll_steady_timer]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  net::steady_timer timer{ctx};
+
+  on_io_thread(ctx, [&] { timer.expires_after(200ms); });
+  bool stopped = false;
+  bool expired = false;
+  stdexec::sync_wait(stdexec::when_all(
+      exec::when_any(net::async_wait(timer) |
+                         stdexec::then([] { CHECK(false); }),
+                     exec::schedule_after(ctx.get_scheduler(), 20ms) |
+                         stdexec::then([&stopped] { stopped = true; })),
+      net::async_wait(timer) | stdexec::then([&expired] { expired = true; })));
+  CHECK(stopped);
+  CHECK(expired);
+  ctx.request_stop();
+}
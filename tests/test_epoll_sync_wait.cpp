@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <chrono>        // NOLINT
+#include <stdexcept>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "stdexec.hpp"
+
+#include "epoll/epoll_context.hpp"
+#include "epoll/sync_wait.hpp"
+
+using net::epoll_context;
+using namespace std::chrono_literals;  // NOLINT
+
+TEST_CASE("[net::sync_wait should return the values of the sender]",
+          "[epoll_sync_wait.value]") {
+  epoll_context ctx{};
+  auto [value] = net::sync_wait(ctx, stdexec::just(42)).value();
+  CHECK(value == 42);
+  CHECK(!ctx.is_running());
+}
+
+TEST_CASE("[net::sync_wait should run the context on the calling thread]",
+          "[epoll_sync_wait.inline]") {
+  epoll_context ctx{};
+  const std::thread::id caller = std::this_thread::get_id();
+  bool on_caller = false;
+  net::sync_wait(ctx, stdexec::schedule(ctx.get_scheduler()) |
+                          stdexec::then([&] {
+                            on_caller = std::this_thread::get_id() == caller &&
+                                        epoll_context::current() == &ctx;
+                          }));
+  CHECK(on_caller);
+
+  // Nothing was scheduled from another thread.
+  CHECK(ctx.remote_interrupt_count_.load() == 0);
+
+  // Timers are driven by the calling thread as well.
+  auto start = std::chrono::steady_clock::now();
+  CHECK(net::sync_wait(ctx, exec::schedule_after(ctx.get_scheduler(), 20ms))
+            .has_value());
+  CHECK(std::chrono::steady_clock::now() - start >= 20ms);
+}
+
+TEST_CASE("[net::sync_wait should rethrow errors and report stops]",
+          "[epoll_sync_wait.error]") {
+  epoll_context ctx{};
+  CHECK_THROWS_AS(
+      net::sync_wait(ctx, stdexec::just_error(std::make_error_code(
+                              std::errc::connection_reset))),
+      std::system_error);
+  CHECK(!net::sync_wait(ctx, stdexec::just_stopped()).has_value());
+}
+
+TEST_CASE("[net::sync_wait should wake up on a completion of another thread]",
+          "[epoll_sync_wait.remote]") {
+  epoll_context ctx{};
+  stdexec::run_loop loop{};
+  std::jthread worker([&loop] { loop.run(); });
+  auto [value] =
+      net::sync_wait(ctx, stdexec::schedule(loop.get_scheduler()) |
+                              stdexec::then([] { return 7; }))
+          .value();
+  CHECK(value == 7);
+  loop.finish();
+}
+
+TEST_CASE("[net::sync_wait should refuse a running context]",
+          "[epoll_sync_wait.running]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  while (!ctx.is_running()) {
+    std::this_thread::yield();
+  }
+  CHECK_THROWS_AS(net::sync_wait(ctx, stdexec::just()), std::runtime_error);
+  ctx.request_stop();
+}
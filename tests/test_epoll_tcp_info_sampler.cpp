@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <netinet/tcp.h>
+
+#include <chrono>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "connection_table.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/tcp_info_sampler.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/tcp.hpp"
+#include "tcp_connection.hpp"
+
+using namespace std::chrono_literals;  // NOLINT
+
+namespace {
+constexpr port_type mock_port = 12428;
+
+struct sampled_connection : net::tcp_info_cache {
+  explicit sampled_connection(net::epoll_context& ctx) : socket(ctx) {}
+
+  net::ip::tcp::socket socket;
+};
+
+auto socket_of = [](sampled_connection& c) noexcept -> net::ip::tcp::socket& {
+  return c.socket;
+};
+}  // namespace
+
+TEST_CASE("[tcp_info_sampler should cache a sample of every connection]",
+          "[tcp_info_sampler]") {
+  net::epoll_context ctx;
+  system_error2::system_code ec{};
+  net::ip::tcp::acceptor acceptor{
+      ctx, {net::ip::address_v4::loopback(), mock_port}, ec, true};
+  REQUIRE(ec.success());
+
+  net::connection_table<sampled_connection> table;
+  std::vector<connection> connections;
+  connections.reserve(5);
+  for (int i = 0; i < 5; ++i) {
+    auto& conn = connections.emplace_back(ctx, acceptor, mock_port);
+    table.emplace(ctx).second.socket = std::move(conn.server);
+  }
+  // A closed socket is skipped.
+  auto [closed, unused] = table.emplace(ctx);
+
+  net::tcp_info_sampler<sampled_connection, decltype(socket_of)> sampler{
+      ctx, table, 1s, socket_of, 2};
+  sampler.start();
+  CHECK(sampler.is_running());
+  ctx.run_for(20ms);
+
+  // Three batches make the first pass, the next one is a second away.
+  CHECK(sampler.sample_count() == 5);
+  CHECK(sampler.error_count() == 0);
+  table.for_each([&](auto h, sampled_connection& c) {
+    if (h == closed) {
+      CHECK(!c.has_tcp_sample());
+      return;
+    }
+    REQUIRE(c.has_tcp_sample());
+    CHECK(c.tcp_sample().state() == TCP_ESTABLISHED);
+    CHECK(c.tcp_sample().mss() > 0);
+  });
+  sampler.stop();
+  CHECK(!sampler.is_running());
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sys/poll.h>
+#include <sys/socket.h>
+
+#include <cstddef>
+#include <system_error>  // NOLINT
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+
+#include "datagram_batch.hpp"
+#include "epoll/reactor_pool.hpp"
+#include "epoll/udp_server.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/udp.hpp"
+
+using net::reactor_pool;
+using net::ip::udp;
+using batch_type = net::datagram_batch<udp>;
+
+namespace {
+// Replies with every datagram received.
+struct echo_handler {
+  void operator()(const batch_type& received, std::size_t count,
+                  batch_type& replies) noexcept {
+    for (std::size_t i = 0; i < count; ++i) {
+      if (auto peer = received.endpoint(i); peer.has_value()) {
+        replies.push_back(
+            net::const_buffer(received.buffer(i).data(), received.length(i)),
+            peer.value());
+      }
+    }
+  }
+};
+
+// Open a blocking client connected to `peer`.
+udp::socket connect_to(net::epoll_context& ctx, const udp::endpoint& peer) {
+  udp::socket client{ctx};
+  REQUIRE(client.open(udp::v4()).success());
+  REQUIRE(client.connect(peer).success());
+  return client;
+}
+}  // namespace
+
+TEST_CASE("[udp_server opens one socket per context on the same port]",
+          "[epoll_udp_server.ctor]") {
+  reactor_pool pool{3};
+  net::udp_server server{pool,
+                         udp::endpoint{net::ip::address_v4::loopback(), 0},
+                         echo_handler{}};
+  CHECK(server.size() == 3);
+  auto local = server.local_endpoint();
+  CHECK(local.port() != 0);
+  for (std::size_t i = 0; i < server.size(); ++i) {
+    CHECK(&server.socket(i).context() == &pool.context(i));
+    CHECK(server.socket(i).local_endpoint().value() == local);
+  }
+}
+
+TEST_CASE("[udp_server should hand batches to the handler and send replies]",
+          "[epoll_udp_server.echo]") {
+  reactor_pool pool{2};
+  pool.run(false);
+  net::udp_server server{pool,
+                         udp::endpoint{net::ip::address_v4::loopback(), 0},
+                         echo_handler{}, {.batch_size = 8}};
+  server.start();
+
+  constexpr std::size_t clients = 4;
+  constexpr std::size_t rounds = 16;
+  std::vector<udp::socket> sockets;
+  for (std::size_t i = 0; i < clients; ++i) {
+    sockets.push_back(connect_to(pool.context(0), server.local_endpoint()));
+  }
+  for (std::size_t r = 0; r < rounds; ++r) {
+    for (auto& client : sockets) {
+      char byte = static_cast<char>(r);
+      REQUIRE(client.send(&byte, 1, 0).value() == 1);
+      pollfd fds{client.native_handle(), POLLIN, 0};
+      REQUIRE(::poll(&fds, 1, 5000) == 1);
+      char reply = 0;
+      CHECK(client.recv(&reply, 1, 0).value() == 1);
+      CHECK(reply == byte);
+    }
+  }
+
+  server.request_stop();
+  server.wait();
+  auto stats = server.stats();
+  CHECK(stats.received == clients * rounds);
+  CHECK(stats.sent == clients * rounds);
+  CHECK(stats.batches >= 1);
+  CHECK(stats.errors == 0);
+  for (std::size_t i = 0; i < server.size(); ++i) {
+    CHECK(!server.error(i));
+  }
+  for (auto& client : sockets) {
+    client.close();
+  }
+}
+
+TEST_CASE("[udp_server should truncate datagrams longer than its buffers]",
+          "[epoll_udp_server.echo]") {
+  reactor_pool pool{1};
+  pool.run(false);
+  net::udp_server server{pool,
+                         udp::endpoint{net::ip::address_v4::loopback(), 0},
+                         echo_handler{}, {.max_datagram_size = 4}};
+  server.start();
+
+  auto client = connect_to(pool.context(0), server.local_endpoint());
+  REQUIRE(client.send("abcdefgh", 8, 0).value() == 8);
+  pollfd fds{client.native_handle(), POLLIN, 0};
+  REQUIRE(::poll(&fds, 1, 5000) == 1);
+  char reply[8] = {};
+  CHECK(client.recv(reply, sizeof(reply), 0).value() == 4);
+  client.close();
+}
@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <chrono>        // NOLINT
+#include <string>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+#include <tuple>
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "buffer.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/write_queue.hpp"
+#include "io_thread.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/tcp.hpp"
+#include "tcp_connection.hpp"
+
+using net::epoll_context;
+using namespace std::chrono_literals;  // NOLINT
+
+constexpr port_type mock_port = 12383;
+
+TEST_CASE("[async_send_queued should complete writes in order]",
+          "[epoll_write_queue]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  connection conn{ctx, mock_port};
+  net::write_queue<net::ip::tcp> queue{conn.server};
+
+  std::string first = "hello";
+  std::string second = ", ";
+  std::string third = "world";
+  // Started on the io thread in one go, so the writes share a flush.
+  auto writes =
+      stdexec::schedule(ctx.get_scheduler()) | stdexec::let_value([&] {
+        return stdexec::when_all(
+            net::async_send_queued(queue, net::buffer(first)),
+            net::async_send_queued(queue, net::buffer(second)),
+            net::async_send_queued(queue, net::buffer(third)));
+      });
+  auto result = stdexec::sync_wait(std::move(writes));
+  REQUIRE(result.has_value());
+  auto [n1, n2, n3] = result.value();
+  CHECK(n1 == 5);
+  CHECK(n2 == 2);
+  CHECK(n3 == 5);
+  CHECK(queue.empty());
+  CHECK(recv_all(conn.client, 12) == "hello, world");
+}
+
+TEST_CASE("[async_send_queued should wait for a full socket to drain]",
+          "[epoll_write_queue]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  connection conn{ctx, mock_port + 1};
+  net::write_queue<net::ip::tcp> queue{conn.server};
+
+  std::string large(8 * 1024 * 1024, 'x');
+  std::string tail = "end";
+  std::string received;
+  std::jthread reader([&] {
+    std::this_thread::sleep_for(50ms);
+    received = recv_all(conn.client, large.size() + tail.size());
+  });
+
+  auto result = stdexec::sync_wait(
+      stdexec::when_all(net::async_send_queued(queue, net::buffer(large)),
+                        net::async_send_queued(queue, net::buffer(tail))));
+  REQUIRE(result.has_value());
+  auto [n1, n2] = result.value();
+  CHECK(n1 == large.size());
+  CHECK(n2 == tail.size());
+  reader.join();
+  CHECK(received.size() == large.size() + tail.size());
+  CHECK(received.substr(large.size()) == "end");
+}
+
+TEST_CASE("[async_send_queued should fail queued writes on a broken stream]",
+          "[epoll_write_queue]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  connection conn{ctx, mock_port + 2};
+  net::write_queue<net::ip::tcp> queue{conn.server};
+  conn.client.close();
+  std::this_thread::sleep_for(20ms);
+
+  // The first write may still be accepted by the kernel before the reset.
+  std::string data(64 * 1024, 'x');
+  bool failed = false;
+  for (int i = 0; i < 64 && !failed; ++i) {
+    stdexec::sync_wait(
+        net::async_send_queued(queue, net::buffer(data)) |
+        stdexec::then([](std::size_t) noexcept {}) |
+        stdexec::upon_error([&failed](std::error_code&&) noexcept {
+          failed = true;
+        }));
+  }
+  CHECK(failed);
+  CHECK(queue.empty());
+}
+
+TEST_CASE("[async_wait_writable_below should wait for the queue to drain]",
+          "[epoll_write_queue]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  connection conn{ctx, mock_port + 3};
+  net::write_queue<net::ip::tcp> queue{conn.server};
+
+  // Nothing queued, the wait completes at once.
+  REQUIRE(stdexec::sync_wait(net::async_wait_writable_below(queue, 1)));
+
+  // The peer doesn't read yet, most of the write stays queued.
+  std::string large(8 * 1024 * 1024, 'x');
+  std::size_t sent = 0;
+  std::jthread writer([&] {
+    auto res =
+        stdexec::sync_wait(net::async_send_queued(queue, net::buffer(large)));
+    REQUIRE(res.has_value());
+    sent = std::get<0>(res.value());
+  });
+  std::size_t queued = 0;
+  for (int i = 0; i < 100 && queued == 0; ++i) {
+    std::this_thread::sleep_for(1ms);
+    queued = on_io_thread(ctx, [&queue] { return queue.queued_bytes(); });
+  }
+  REQUIRE(queued > 0);
+  auto backlog = on_io_thread(ctx, [&queue] { return queue.send_backlog(); });
+  REQUIRE(backlog.has_value());
+  CHECK(backlog.value() > queued);
+
+  std::string received;
+  std::jthread reader(
+      [&] { received = recv_all(conn.client, large.size()); });
+  auto left = stdexec::sync_wait(
+      net::async_wait_writable_below(queue, 1024 * 1024) |
+      stdexec::then([&queue] { return queue.queued_bytes(); }));
+  REQUIRE(left.has_value());
+  CHECK(std::get<0>(left.value()) < 1024 * 1024);
+  writer.join();
+  reader.join();
+  CHECK(sent == large.size());
+  CHECK(received.size() == large.size());
+  CHECK(queue.queued_bytes() == 0);
+}
+
+TEST_CASE("[a rate limit should pace the writes of write_queue]",
+          "[epoll_write_queue]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+  connection conn{ctx, mock_port + 4};
+  net::write_queue<net::ip::tcp> queue{conn.server};
+  stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler()) |
+                     stdexec::then([&queue] {
+                       queue.set_rate_limit(1024 * 1024, 64 * 1024);
+                     }));
+
+  // The first burst goes out at once, the rest at 1MB/s.
+  std::string data(256 * 1024, 'x');
+  std::string received;
+  std::jthread reader(
+      [&] { received = recv_all(conn.client, data.size()); });
+  auto start = std::chrono::steady_clock::now();
+  auto result =
+      stdexec::sync_wait(net::async_send_queued(queue, net::buffer(data)));
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  REQUIRE(result.has_value());
+  CHECK(std::get<0>(result.value()) == data.size());
+  CHECK(elapsed >= 150ms);
+  reader.join();
+  CHECK(received == data);
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "flight_recorder.hpp"
+
+using net::flight_event;
+using net::flight_recorder;
+
+TEST_CASE("[snapshot should return the recorded events oldest first]",
+          "[flight_recorder.snapshot]") {
+  flight_recorder recorder{5};
+  CHECK(recorder.capacity() == 8);
+  CHECK(recorder.snapshot().empty());
+
+  recorder.record(flight_event::op_start, 7, 1);
+  recorder.record(flight_event::op_park, 7, 1);
+  recorder.record(flight_event::wait_begin, -1);
+  CHECK(recorder.recorded() == 3);
+
+  auto entries = recorder.snapshot();
+  REQUIRE(entries.size() == 3);
+  CHECK(entries[0].event == flight_event::op_start);
+  CHECK(entries[0].kind == 1);
+  CHECK(entries[0].arg == 7);
+  CHECK(entries[1].event == flight_event::op_park);
+  CHECK(entries[2].event == flight_event::wait_begin);
+  CHECK(entries[2].arg == -1);
+  CHECK(entries[0].time <= entries[1].time);
+  CHECK(entries[1].time <= entries[2].time);
+}
+
+TEST_CASE("[snapshot should keep the latest events once the ring wraps]",
+          "[flight_recorder.snapshot]") {
+  flight_recorder recorder{4};
+  for (std::int32_t i = 0; i < 10; ++i) {
+    recorder.record(flight_event::remote_drain, i);
+  }
+  CHECK(recorder.recorded() == 10);
+
+  auto entries = recorder.snapshot();
+  REQUIRE(entries.size() == 4);
+  for (std::int32_t i = 0; i < 4; ++i) {
+    CHECK(entries[i].arg == 6 + i);
+  }
+}
+
+TEST_CASE("[snapshot should never return torn events while recording]",
+          "[flight_recorder.snapshot]") {
+  flight_recorder recorder{64};
+  std::atomic<bool> stop{false};
+  std::thread writer{[&] {
+    // The argument always matches the kind, a torn entry mixes them.
+    for (std::uint32_t i = 0; !stop.load(std::memory_order_relaxed); ++i) {
+      recorder.record(flight_event::op_complete,
+                      static_cast<std::int32_t>(i & 0xff),
+                      static_cast<std::uint8_t>(i & 0xff));
+    }
+  }};
+  for (int round = 0; round < 1000; ++round) {
+    for (const auto& entry : recorder.snapshot()) {
+      REQUIRE(entry.event == flight_event::op_complete);
+      REQUIRE(entry.arg == entry.kind);
+    }
+  }
+  stop.store(true, std::memory_order_relaxed);
+  writer.join();
+}
+
+TEST_CASE("[dump should write one line per event]",
+          "[flight_recorder.dump]") {
+  flight_recorder recorder{8};
+  recorder.record(flight_event::timer_fire, 0);
+  recorder.record(flight_event::wait_end, -12, 3);
+
+  int fds[2];
+  REQUIRE(::pipe(fds) == 0);
+  recorder.dump(fds[1]);
+  ::close(fds[1]);
+  std::string text;
+  char buffer[256];
+  ssize_t n = 0;
+  while ((n = ::read(fds[0], buffer, sizeof(buffer))) > 0) {
+    text.append(buffer, static_cast<std::size_t>(n));
+  }
+  ::close(fds[0]);
+
+  CHECK(text.find("events=2\n") != std::string::npos);
+  CHECK(text.find("timer_fire kind=0 arg=0 age=") != std::string::npos);
+  CHECK(text.find("wait_end kind=3 arg=-12 age=") != std::string::npos);
+  CHECK(text.find("ns\n") != std::string::npos);
+}
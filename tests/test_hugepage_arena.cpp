@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <thread>  // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "stdexec.hpp"
+
+#include "buffer_pool.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/start_detached.hpp"
+#include "hugepage_arena.hpp"
+#include "size_class_pool.hpp"
+
+using net::buffer_pool;
+using net::epoll_context;
+using net::hugepage_arena;
+using net::size_class_pool;
+
+TEST_CASE("[hugepage_arena should carve aligned blocks until it's full]",
+          "[hugepage_arena]") {
+  hugepage_arena arena{1};
+  CHECK(arena.size() == hugepage_arena::huge_page_size);
+  CHECK(arena.used() == 0);
+
+  void* a = arena.allocate(10);
+  void* b = arena.allocate(64, 64);
+  REQUIRE(a != nullptr);
+  REQUIRE(b != nullptr);
+  CHECK(reinterpret_cast<std::uintptr_t>(a) %
+            hugepage_arena::huge_page_size ==
+        0);
+  CHECK(reinterpret_cast<std::uintptr_t>(b) % 64 == 0);
+  CHECK(arena.contains(a));
+  CHECK(arena.contains(b));
+  int local = 0;
+  CHECK(!arena.contains(&local));
+
+  // The memory is writable.
+  static_cast<std::byte*>(b)[63] = std::byte{1};
+  CHECK(arena.allocate(hugepage_arena::huge_page_size) == nullptr);
+  CHECK(arena.allocate(arena.size() - arena.used(), 1) != nullptr);
+  CHECK(arena.allocate(1) == nullptr);
+}
+
+TEST_CASE("[hugepage_arena should fall back to transparent hugepages]",
+          "[hugepage_arena]") {
+  hugepage_arena arena{3 * hugepage_arena::huge_page_size,
+                       {.explicit_hugepages = false, .prefault = false}};
+  CHECK(!arena.uses_hugetlb());
+  CHECK(arena.size() == 3 * hugepage_arena::huge_page_size);
+  CHECK(arena.allocate(arena.size()) != nullptr);
+}
+
+TEST_CASE("[buffer_pool should carve its chunks from an arena]",
+          "[hugepage_arena.buffer_pool]") {
+  hugepage_arena arena{1};
+  buffer_pool pool{1024, 4};
+  pool.set_arena(&arena);
+  pool.reserve(8);
+  CHECK(pool.block_count() == 8);
+  CHECK(arena.used() == 2 * pool.chunk_size());
+
+  auto lease = pool.acquire();
+  CHECK(arena.contains(lease.data()));
+
+  // Chunks beyond the arena come from the heap.
+  pool.reserve((arena.size() / pool.chunk_size() + 1) * 4);
+  CHECK(pool.block_count() > arena.size() / pool.chunk_size() * 4);
+}
+
+TEST_CASE("[size_class_pool should keep the blocks of its arena]",
+          "[hugepage_arena.size_class_pool]") {
+  hugepage_arena arena{1};
+  size_class_pool pool{0};
+  REQUIRE(pool.reserve(arena, 2));
+  CHECK(arena.used() == size_class_pool::reserve_size(2));
+  CHECK(pool.cached_count() == 2 * size_class_pool::class_count);
+
+  void* p = pool.allocate(100);
+  CHECK(pool.owns(p));
+  CHECK(reinterpret_cast<std::uintptr_t>(p) % 64 == 0);
+
+  // Arena blocks are cached even beyond the limit, heap blocks are not.
+  pool.deallocate(p, 100);
+  void* q = size_class_pool::allocate_block(100);
+  CHECK(!pool.owns(q));
+  pool.deallocate(q, 100);
+  CHECK(pool.cached_count() == 2 * size_class_pool::class_count);
+
+  pool.release();
+  CHECK(pool.cached_count() == 2 * size_class_pool::class_count);
+}
+
+TEST_CASE("[epoll_context should serve operation states from the arena]",
+          "[hugepage_arena.epoll_context]") {
+  epoll_context ctx{};
+  ctx.recv_buffer_pool().set_block_size(4096);
+  ctx.reserve_hugepages(16, 64);
+  CHECK(ctx.recv_buffer_pool().block_count() >= 64);
+  CHECK(ctx.operation_pool().cached_count() ==
+        16 * size_class_pool::class_count);
+
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  std::atomic<bool> done = false;
+  stdexec::sync_wait(
+      stdexec::schedule(ctx.get_scheduler()) | stdexec::then([&] {
+        net::start_detached(ctx, stdexec::schedule(ctx.get_scheduler()) |
+                                     stdexec::then([&done] { done = true; }));
+      }));
+  while (!done.load()) {
+    std::this_thread::yield();
+  }
+  stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler()));
+  CHECK(ctx.operation_pool().reuse_count() >= 1);
+  CHECK(ctx.operation_pool().cached_count() ==
+        16 * size_class_pool::class_count);
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "intrusive_pairing_heap.hpp"
+
+namespace {
+struct item {
+  explicit item(int key) : key_(key) {}
+
+  item* child_ = nullptr;
+  item* next_ = nullptr;
+  item* prev_ = nullptr;
+  int key_;
+};
+
+using heap = net::intrusive_pairing_heap<item,          //
+                                         &item::child_,  //
+                                         &item::next_,   //
+                                         &item::prev_,   //
+                                         int,            //
+                                         &item::key_>;
+}  // namespace
+
+TEST_CASE("[default constructed heap should be empty]",
+          "[intrusive_pairing_heap]") {
+  heap h;
+  CHECK(h.empty());
+  CHECK(h.top() == nullptr);
+}
+
+TEST_CASE("[top should return the item with the smallest key]",
+          "[intrusive_pairing_heap]") {
+  item a{3};
+  item b{1};
+  item c{2};
+  heap h;
+  h.insert(&a);
+  CHECK(h.top() == &a);
+  h.insert(&b);
+  CHECK(h.top() == &b);
+  h.insert(&c);
+  CHECK(h.top() == &b);
+  CHECK(h.empty() == false);
+}
+
+TEST_CASE("[pop should return items in ascending order of key]",
+          "[intrusive_pairing_heap]") {
+  std::vector<item> items;
+  for (int i = 0; i < 100; ++i) {
+    items.emplace_back(i);
+  }
+  std::shuffle(items.begin(), items.end(), std::mt19937{42});
+
+  heap h;
+  for (auto& i : items) {
+    h.insert(&i);
+  }
+  for (int i = 0; i < 100; ++i) {
+    item* top = h.pop();
+    CHECK(top->key_ == i);
+    CHECK(top->child_ == nullptr);
+  }
+  CHECK(h.empty());
+}
+
+TEST_CASE("[remove the root of heap]", "[intrusive_pairing_heap]") {
+  item a{1};
+  item b{2};
+  heap h;
+  h.insert(&a);
+  h.insert(&b);
+  h.remove(&a);
+  CHECK(h.top() == &b);
+  h.remove(&b);
+  CHECK(h.empty());
+}
+
+TEST_CASE("[remove arbitrary items by handle]", "[intrusive_pairing_heap]") {
+  std::vector<item> items;
+  for (int i = 0; i < 200; ++i) {
+    items.emplace_back(i);
+  }
+  std::shuffle(items.begin(), items.end(), std::mt19937{7});
+
+  heap h;
+  for (auto& i : items) {
+    h.insert(&i);
+  }
+  // Pop once so that the heap has a multi-level shape.
+  CHECK(h.pop()->key_ == 0);
+
+  // Remove all odd keys.
+  for (auto& i : items) {
+    if (i.key_ % 2 == 1) {
+      h.remove(&i);
+      CHECK(i.child_ == nullptr);
+      CHECK(i.next_ == nullptr);
+      CHECK(i.prev_ == nullptr);
+    }
+  }
+  for (int i = 2; i < 200; i += 2) {
+    CHECK(h.pop()->key_ == i);
+  }
+  CHECK(h.empty());
+}
+
+TEST_CASE("[removed item can be inserted again]", "[intrusive_pairing_heap]") {
+  item a{1};
+  item b{2};
+  item c{3};
+  heap h;
+  h.insert(&a);
+  h.insert(&b);
+  h.insert(&c);
+  h.pop();
+  h.remove(&c);
+  c.key_ = 0;
+  h.insert(&c);
+  CHECK(h.pop() == &c);
+  CHECK(h.pop() == &b);
+  CHECK(h.empty());
+}
+
+TEST_CASE("[decrease should move items with a lowered key up]",
+          "[intrusive_pairing_heap]") {
+  std::vector<item> items;
+  items.reserve(100);
+  for (int i = 0; i < 100; ++i) {
+    items.emplace_back(1000 + i);
+  }
+  std::shuffle(items.begin(), items.end(), std::mt19937{11});
+
+  heap h;
+  for (auto& i : items) {
+    h.insert(&i);
+  }
+  // Pop once so that the heap has a multi-level shape.
+  int first = h.pop()->key_;
+  CHECK(first == 1000);
+
+  // Lower every key to the reverse order, including the root.
+  for (auto& i : items) {
+    if (i.key_ != first) {
+      i.key_ = 2000 - i.key_;
+      h.decrease(&i);
+    }
+  }
+  for (int i = 2000 - 1099; i < 1000; ++i) {
+    CHECK(h.pop()->key_ == i);
+  }
+  CHECK(h.empty());
+}
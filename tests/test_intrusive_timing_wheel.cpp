@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "intrusive_timing_wheel.hpp"
+#include "monotonic_clock.hpp"
+
+using net::monotonic_clock;
+using namespace std::chrono_literals;  // NOLINT
+
+namespace {
+struct item {
+  explicit item(monotonic_clock::time_point due_time) : due_time_(due_time) {}
+
+  item* next_ = nullptr;
+  item* prev_ = nullptr;
+  std::uint32_t slot_ = 0;
+  monotonic_clock::time_point due_time_;
+  bool expired_ = false;
+};
+
+using wheel = net::intrusive_timing_wheel<item,                         //
+                                          &item::next_,                 //
+                                          &item::prev_,                 //
+                                          &item::slot_,                 //
+                                          monotonic_clock::time_point,  //
+                                          &item::due_time_>;
+
+monotonic_clock::time_point at(std::chrono::milliseconds ms) {
+  return monotonic_clock::time_point{} + ms;
+}
+}  // namespace
+
+TEST_CASE("[default constructed wheel should be empty]",
+          "[intrusive_timing_wheel]") {
+  wheel w{10ms};
+  CHECK(w.empty());
+  CHECK(w.size() == 0);
+  CHECK(w.next_expiry().has_value() == false);
+}
+
+TEST_CASE("[items expire at the first tick not earlier than due time]",
+          "[intrusive_timing_wheel]") {
+  wheel w{10ms};
+  item a{at(25ms)};
+  w.insert(&a);
+  CHECK(w.size() == 1);
+  CHECK(w.next_expiry() == at(30ms));
+
+  std::vector<item*> expired;
+  auto on_expired = [&](item* i) { expired.push_back(i); };
+  w.advance(at(29ms), on_expired);
+  CHECK(expired.empty());
+  w.advance(at(30ms), on_expired);
+  CHECK(expired.size() == 1);
+  CHECK(expired[0] == &a);
+  CHECK(w.empty());
+}
+
+TEST_CASE("[removed items never expire]", "[intrusive_timing_wheel]") {
+  wheel w{10ms};
+  item a{at(20ms)};
+  item b{at(20ms)};
+  item c{at(50s)};
+  w.insert(&a);
+  w.insert(&b);
+  w.insert(&c);
+  w.remove(&a);
+  w.remove(&c);
+  CHECK(w.size() == 1);
+
+  std::vector<item*> expired;
+  w.advance(at(100s), [&](item* i) { expired.push_back(i); });
+  CHECK(expired.size() == 1);
+  CHECK(expired[0] == &b);
+  CHECK(w.empty());
+  CHECK(w.next_expiry().has_value() == false);
+}
+
+TEST_CASE("[items in higher levels cascade and expire on time]",
+          "[intrusive_timing_wheel]") {
+  const auto tick = 10ms;
+  wheel w{tick};
+  w.reset(at(1234ms));
+
+  std::mt19937 engine{42};
+  std::uniform_int_distribution<int> delay{0, 100'000'000};
+  std::vector<item> items;
+  items.reserve(1000);
+  for (int i = 0; i < 1000; ++i) {
+    items.emplace_back(at(1234ms + std::chrono::milliseconds(delay(engine))));
+  }
+  for (auto& i : items) {
+    w.insert(&i);
+  }
+
+  // Drive the wheel like the context does: wake up at the next expiry only.
+  monotonic_clock::time_point now = at(1234ms);
+  std::size_t count = 0;
+  while (auto next = w.next_expiry()) {
+    CHECK(now < *next);
+    now = *next;
+    w.advance(now, [&](item* i) {
+      CHECK(i->expired_ == false);
+      CHECK(i->due_time_ <= now);
+      CHECK(now - i->due_time_ < tick);
+      i->expired_ = true;
+      ++count;
+    });
+  }
+  CHECK(count == items.size());
+  CHECK(w.empty());
+}
+
+TEST_CASE("[items already due expire on the next tick]",
+          "[intrusive_timing_wheel]") {
+  wheel w{10ms};
+  w.reset(at(100ms));
+  item a{at(10ms)};
+  w.insert(&a);
+  CHECK(w.next_expiry() == at(110ms));
+
+  bool expired = false;
+  w.advance(at(110ms), [&](item*) { expired = true; });
+  CHECK(expired);
+}
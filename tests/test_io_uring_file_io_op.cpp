@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+
+#include <array>
+#include <string>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "stdexec.hpp"
+
+#include "buffer.hpp"
+#include "io_uring/file_io_op.hpp"
+#include "io_uring/io_uring_context.hpp"
+
+using net::io_uring_context;
+
+TEST_CASE("[io_uring file senders should satisfy stdexec::sender]",
+          "[io_uring_file_io_op.concept]") {
+  using net::__io_uring::file_io_sender;
+  CHECK(stdexec::sender<stdexec::__t<file_io_sender<net::mutable_buffer,
+                                                    false>>>);
+  CHECK(stdexec::sender<stdexec::__t<file_io_sender<net::const_buffer,
+                                                    true>>>);
+}
+
+TEST_CASE("[write then read a file at offsets with native requests]",
+          "[io_uring_file_io_op]") {
+  io_uring_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  FILE* file = ::tmpfile();
+  REQUIRE(file != nullptr);
+  exec::scope_guard close_file{[file]() noexcept { ::fclose(file); }};
+  const int fd = ::fileno(file);
+
+  std::string head = "hello ";
+  std::string tail = "ring";
+  std::array<net::const_buffer, 2> bufs{net::buffer(head), net::buffer(tail)};
+  auto [written] = stdexec::sync_wait(
+                       net::uring::async_write_file_at(ctx, fd, 2, bufs))
+                       .value();
+  CHECK(written == 10);
+
+  std::string read(6, ' ');
+  auto [n] = stdexec::sync_wait(net::uring::async_read_file_at(
+                                    ctx, fd, 6, net::buffer(read)))
+                 .value();
+  CHECK(n == 6);
+  CHECK(read == "o ring");
+
+  std::error_code ec;
+  stdexec::sync_wait(
+      net::uring::async_read_file_at(ctx, -1, 0, net::buffer(read)) |
+      stdexec::then([](std::size_t) noexcept { CHECK(false); }) |
+      stdexec::upon_error([&ec](std::error_code&& e) noexcept { ec = e; }));
+  CHECK(ec == std::errc::bad_file_descriptor);
+}
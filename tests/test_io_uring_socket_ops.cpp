@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <array>
+#include <chrono>        // NOLINT
+#include <string>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "buffer.hpp"
+#include "io_uring/io_uring_context.hpp"
+#include "io_uring/socket_accept_op.hpp"
+#include "io_uring/socket_recv_some_op.hpp"
+#include "io_uring/socket_send_some_op.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/tcp.hpp"
+
+using net::io_uring_context;
+using namespace std::chrono_literals;  // NOLINT
+
+constexpr port_type mock_port = 12330;
+
+TEST_CASE("[io_uring senders should satisfy stdexec::sender]",
+          "[io_uring_socket_ops.concept]") {
+  using net::__io_uring::accept_sender;
+  using net::__io_uring::recv_some_sender;
+  using net::__io_uring::send_some_sender;
+  CHECK(stdexec::sender<stdexec::__t<accept_sender<net::ip::tcp>>>);
+  CHECK(stdexec::sender<
+        stdexec::__t<recv_some_sender<net::ip::tcp, net::mutable_buffer>>>);
+  CHECK(stdexec::sender<
+        stdexec::__t<send_some_sender<net::ip::tcp, net::const_buffer>>>);
+}
+
+TEST_CASE("[accept, recv and send over loopback]",
+          "[io_uring_socket_ops.transfer]") {
+  io_uring_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  system_error2::system_code ec{};
+  net::ip::tcp::acceptor acceptor{
+      ctx, {net::ip::address_v4::any(), mock_port}, ec};
+  REQUIRE(ec.success());
+
+  std::jthread client_thread([&ctx] {
+    net::ip::tcp::socket client{ctx};
+    CHECK(client.open(net::ip::tcp::v4()).success());
+    CHECK(
+        client.connect({net::ip::address_v4::loopback(), mock_port}).success());
+
+    std::string hello = "hello io_uring";
+    std::string echoed(hello.size() * 2, ' ');
+    auto [sent] = stdexec::sync_wait(net::uring::async_send_some(
+                                         client, net::buffer(hello)))
+                      .value();
+    CHECK(sent == hello.size());
+
+    // The peer sends it back twice with one scatter request.
+    std::size_t received = 0;
+    while (received < echoed.size()) {
+      auto [n] = stdexec::sync_wait(
+                     net::uring::async_recv_some(
+                         client, net::buffer(echoed.data() + received,
+                                             echoed.size() - received)))
+                     .value();
+      REQUIRE(n > 0);
+      received += n;
+    }
+    CHECK(echoed == hello + hello);
+  });
+
+  auto [peer] = stdexec::sync_wait(net::uring::async_accept(acceptor)).value();
+  CHECK(peer.is_open());
+  CHECK(&peer.context() == &ctx);
+
+  std::string buf(14, ' ');
+  std::size_t received = 0;
+  while (received < buf.size()) {
+    auto [n] = stdexec::sync_wait(
+                   net::uring::async_recv_some(
+                       peer, net::buffer(buf.data() + received,
+                                         buf.size() - received)))
+                   .value();
+    REQUIRE(n > 0);
+    received += n;
+  }
+  CHECK(buf == "hello io_uring");
+
+  std::array<net::const_buffer, 2> bufs{net::buffer(buf), net::buffer(buf)};
+  auto [sent] =
+      stdexec::sync_wait(net::uring::async_send_some(peer, bufs)).value();
+  CHECK(sent == buf.size() * 2);
+}
+
+TEST_CASE("[accept should be cancelled by when_any]",
+          "[io_uring_socket_ops.cancel]") {
+  io_uring_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  system_error2::system_code ec{};
+  net::ip::tcp::acceptor acceptor{
+      ctx, {net::ip::address_v4::any(), mock_port + 1}, ec};
+  REQUIRE(ec.success());
+
+  bool accepted = false;
+  bool timeout = false;
+  stdexec::sync_wait(exec::when_any(
+      net::uring::async_accept(acceptor) |
+          stdexec::then([&](net::ip::tcp::socket&&) { accepted = true; }) |
+          stdexec::upon_error([](std::error_code&&) noexcept {}),
+      exec::schedule_after(ctx.get_scheduler(), 20ms) |
+          stdexec::then([&] { timeout = true; })));
+  CHECK(accepted == false);
+  CHECK(timeout);
+}
+
+TEST_CASE("[recv on a closed peer should complete with zero bytes]",
+          "[io_uring_socket_ops.recv]") {
+  io_uring_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  system_error2::system_code ec{};
+  net::ip::tcp::acceptor acceptor{
+      ctx, {net::ip::address_v4::any(), mock_port + 2}, ec};
+  REQUIRE(ec.success());
+
+  std::jthread client_thread([&ctx] {
+    net::ip::tcp::socket client{ctx};
+    CHECK(client.open(net::ip::tcp::v4()).success());
+    CHECK(client.connect({net::ip::address_v4::loopback(), mock_port + 2})
+              .success());
+  });
+
+  auto [peer] = stdexec::sync_wait(net::uring::async_accept(acceptor)).value();
+  char buf[16];
+  auto [n] = stdexec::sync_wait(
+                 net::uring::async_recv_some(peer, net::buffer(buf)))
+                 .value();
+  CHECK(n == 0);
+}
@@ -13,10 +13,15 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <netinet/tcp.h>
 #include <sys/socket.h>
 
+#include <cstdint>
+
 #include "catch2/catch_test_macros.hpp"
 
+#include "execution_context.hpp"
+#include "ip/address_v4.hpp"
 #include "ip/tcp.hpp"
 #include "meta.hpp"
 
@@ -46,3 +51,82 @@ TEST_CASE("[comparision of tcp]", "[tcp.operator=]") {
   CHECK(net::ip::tcp::v4() == net::ip::tcp::v4());
   CHECK(net::ip::tcp::v6() != net::ip::tcp::v4());
 }
+
+TEST_CASE("[tcp options should round trip through a socket]",
+          "[tcp.option]") {
+  net::execution_context ctx{};
+  net::ip::tcp::socket socket{ctx};
+  REQUIRE(socket.open(net::ip::tcp::v4()).success());
+
+  CHECK(socket.set_option(net::ip::tcp::no_delay{true}).success());
+  net::ip::tcp::no_delay no_delay{};
+  CHECK(socket.get_option(no_delay).success());
+  CHECK(no_delay.value());
+
+  CHECK(socket.set_option(net::ip::tcp::notsent_low_water_mark{16384})
+            .success());
+  net::ip::tcp::notsent_low_water_mark lowat{};
+  CHECK(socket.get_option(lowat).success());
+  CHECK(lowat.value() == 16384);
+
+  CHECK(socket.set_option(net::ip::tcp::user_timeout{5000}).success());
+  net::ip::tcp::user_timeout timeout{};
+  CHECK(socket.get_option(timeout).success());
+  CHECK(timeout.value() == 5000);
+
+  CHECK(socket.set_option(net::ip::tcp::cork{true}).success());
+  CHECK(socket.set_option(net::ip::tcp::quick_ack{true}).success());
+}
+
+TEST_CASE("[acceptor should pass inherited options to accepted sockets]",
+          "[tcp.option]") {
+  static_assert(
+      net::socket_option::inherited_by_accept<net::ip::tcp::no_delay>);
+  static_assert(
+      !net::socket_option::inherited_by_accept<net::ip::tcp::quick_ack>);
+
+  net::execution_context ctx{};
+  system_error2::system_code ec{};
+  net::ip::tcp::acceptor acceptor{
+      ctx, {net::ip::address_v4::loopback(), 12392}, ec};
+  REQUIRE(ec.success());
+  CHECK(acceptor.set_inherited_option(net::ip::tcp::no_delay{true}).success());
+  CHECK(acceptor.set_option(net::ip::tcp::defer_accept{1}).success());
+  CHECK(acceptor.set_option(net::ip::tcp::fast_open{16}).success());
+
+  net::ip::tcp::socket client{ctx};
+  REQUIRE(client.open(net::ip::tcp::v4()).success());
+  REQUIRE(client.connect({net::ip::address_v4::loopback(), 12392}).success());
+  // Deferred accepts wait for the first bytes.
+  char byte = 0;
+  REQUIRE(::send(client.native_handle(), &byte, 1, 0) == 1);
+  auto accepted = acceptor.accept();
+  REQUIRE(accepted.has_value());
+  net::ip::tcp::no_delay no_delay{};
+  CHECK(accepted.value().get_option(no_delay).success());
+  CHECK(no_delay.value());
+}
+
+TEST_CASE("[tcp::info should read the state of a connection]",
+          "[tcp.option]") {
+  net::execution_context ctx{};
+  system_error2::system_code ec{};
+  net::ip::tcp::acceptor acceptor{
+      ctx, {net::ip::address_v4::loopback(), 12426}, ec};
+  REQUIRE(ec.success());
+  net::ip::tcp::socket client{ctx};
+  REQUIRE(client.open(net::ip::tcp::v4()).success());
+  REQUIRE(client.connect({net::ip::address_v4::loopback(), 12426}).success());
+  auto accepted = acceptor.accept();
+  REQUIRE(accepted.has_value());
+
+  net::ip::tcp::info info{};
+  CHECK(info.window_rate() == 0);
+  REQUIRE(client.get_option(info).success());
+  CHECK(info.state() == TCP_ESTABLISHED);
+  CHECK(info.mss() > 0);
+  CHECK(info.congestion_window() > 0);
+  CHECK(info.window_bytes() ==
+        std::uint64_t{info.congestion_window()} * info.mss());
+  CHECK(info.get().tcpi_snd_mss == info.mss());
+}
@@ -13,10 +13,19 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <net/if.h>
+#include <netinet/in.h>
+#include <poll.h>
 #include <sys/socket.h>
 
+#include <cstring>
+
 #include "catch2/catch_test_macros.hpp"
 
+#include "datagram_batch.hpp"
+#include "execution_context.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/packet_info.hpp"
 #include "ip/udp.hpp"
 #include "meta.hpp"
 
@@ -46,3 +55,103 @@ TEST_CASE("[comparision of udp]", "[udp.operator=]") {
   CHECK(net::ip::udp::v4() == net::ip::udp::v4());
   CHECK(net::ip::udp::v6() != net::ip::udp::v4());
 }
+
+TEST_CASE("[multicast options should follow the family]",
+          "[udp.multicast_options]") {
+  using net::ip::udp;
+  udp::multicast_loopback loopback{true};
+  CHECK(loopback.value());
+  CHECK(loopback.level(udp::v4()) == IPPROTO_IP);
+  CHECK(loopback.name(udp::v4()) == IP_MULTICAST_LOOP);
+  CHECK(loopback.level(udp::v6()) == IPPROTO_IPV6);
+  CHECK(loopback.name(udp::v6()) == IPV6_MULTICAST_LOOP);
+
+  udp::packet_info info{true};
+  CHECK(info.name(udp::v4()) == IP_PKTINFO);
+  CHECK(info.name(udp::v6()) == IPV6_RECVPKTINFO);
+
+  // Joining follows the family of the group, not of the socket.
+  udp::join_group v4_group{net::ip::make_address("239.1.2.3"), 7};
+  CHECK(v4_group.level(udp::v6()) == IPPROTO_IP);
+  CHECK(v4_group.name(udp::v6()) == IP_ADD_MEMBERSHIP);
+  CHECK(v4_group.size(udp::v6()) == sizeof(::ip_mreqn));
+  ::ip_mreqn mreqn;
+  std::memcpy(&mreqn, v4_group.data(udp::v6()), sizeof(mreqn));
+  CHECK(mreqn.imr_ifindex == 7);
+  CHECK(mreqn.imr_multiaddr.s_addr == htonl(0xef010203));
+
+  udp::leave_group v6_group{net::ip::make_address("ff15::1"), 3};
+  CHECK(v6_group.level(udp::v4()) == IPPROTO_IPV6);
+  CHECK(v6_group.name(udp::v4()) == IPV6_LEAVE_GROUP);
+  ::ipv6_mreq mreq;
+  std::memcpy(&mreq, v6_group.data(udp::v4()), sizeof(mreq));
+  CHECK(mreq.ipv6mr_interface == 3);
+  CHECK(mreq.ipv6mr_multiaddr.s6_addr[0] == 0xff);
+}
+
+TEST_CASE("[a batch should report the group of every multicast datagram]",
+          "[udp.packet_info]") {
+  using net::ip::udp;
+  const unsigned lo = ::if_nametoindex("lo");
+  const auto group1 = net::ip::make_address("239.255.0.1");
+  const auto group2 = net::ip::make_address("239.255.0.2");
+  net::execution_context ctx{};
+
+  udp::socket receiver{ctx};
+  REQUIRE(receiver.open(udp::v4()).success());
+  REQUIRE(receiver.bind(udp::endpoint{net::ip::address_v4::any(), 0})
+              .success());
+  REQUIRE(receiver.set_option(udp::join_group{group1, lo}).success());
+  REQUIRE(receiver.set_option(udp::join_group{group2, lo}).success());
+  REQUIRE(receiver.set_option(udp::multicast_all{false}).success());
+  REQUIRE(receiver.set_option(udp::packet_info{true}).success());
+  const auto port = receiver.local_endpoint().value().port();
+
+  udp::socket sender{ctx};
+  REQUIRE(sender.open(udp::v4()).success());
+  ::ip_mreqn outbound{};
+  outbound.imr_ifindex = static_cast<int>(lo);
+  REQUIRE(::setsockopt(sender.native_handle(), IPPROTO_IP, IP_MULTICAST_IF,
+                       &outbound, sizeof(outbound)) == 0);
+  REQUIRE(sender.set_option(udp::multicast_loopback{true}).success());
+  const udp::endpoint to1{group1, port};
+  const udp::endpoint to2{group2, port};
+  REQUIRE(sender.sendto("a", 1, 0, to1.data(), to1.size()).has_value());
+  REQUIRE(sender.sendto("b", 1, 0, to2.data(), to2.size()).has_value());
+
+  net::datagram_batch<udp> batch{4, net::ip::packet_info::control_size};
+  char bytes[4] = {};
+  for (char& byte : bytes) {
+    batch.push_back(net::mutable_buffer(&byte, 1));
+  }
+  std::size_t count = 0;
+  while (count < 2) {
+    pollfd fds{receiver.native_handle(), POLLIN, 0};
+    REQUIRE(::poll(&fds, 1, 1000) == 1);
+    batch.prepare_receive();
+    auto res = receiver.non_blocking_recvmmsg(batch.native_messages() + count,
+                                              4 - count, MSG_DONTWAIT);
+    REQUIRE(res.has_value());
+    count += res.value();
+  }
+  for (std::size_t i = 0; i < 2; ++i) {
+    auto info = batch.packet_info(i);
+    REQUIRE(info.has_value());
+    CHECK(info.value().destination == (bytes[i] == 'a' ? group1 : group2));
+    CHECK(info.value().interface_index == lo);
+  }
+
+  // No report after leaving the group, or without room for it.
+  REQUIRE(receiver.set_option(udp::leave_group{group1, lo}).success());
+  net::datagram_batch<udp> plain{1};
+  plain.push_back(net::mutable_buffer(bytes, 1));
+  const udp::endpoint self{net::ip::address_v4::loopback(), port};
+  REQUIRE(receiver.sendto("c", 1, 0, self.data(), self.size()).has_value());
+  pollfd fds{receiver.native_handle(), POLLIN, 0};
+  REQUIRE(::poll(&fds, 1, 1000) == 1);
+  plain.prepare_receive();
+  REQUIRE(receiver.non_blocking_recvmmsg(plain.native_messages(), 1,
+                                         MSG_DONTWAIT)
+              .value() == 1);
+  CHECK(plain.packet_info(0).has_error());
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "stdexec.hpp"
+
+#include "kqueue/kqueue_context.hpp"
+#include "monotonic_clock.hpp"
+
+using net::kqueue_context;
+using net::monotonic_clock;
+using namespace std::chrono_literals;  // NOLINT
+
+TEST_CASE("[constructor should create the kqueue]", "[kqueue_context.ctor]") {
+  kqueue_context ctx{8};
+  CHECK(ctx.kqueue_fd_ >= 0);
+  CHECK(ctx.events_.size() == 8);
+  CHECK(ctx.changes_.capacity() >= 8);
+  CHECK(ctx.is_running() == false);
+  CHECK(ctx.stop_requested() == false);
+}
+
+TEST_CASE("[schedule should run on the io thread]",
+          "[kqueue_context.schedule]") {
+  kqueue_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  auto [id] = stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler()) |
+                                 stdexec::then([] {
+                                   return std::this_thread::get_id();
+                                 }))
+                  .value();
+  CHECK(id == io_thread.get_id());
+
+  // Run many times to make sure the user event keeps waking the context up.
+  for (int i = 0; i < 100; ++i) {
+    CHECK(stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler()))
+              .has_value());
+  }
+}
+
+TEST_CASE("[run() must not be called on a running context]",
+          "[kqueue_context.run]") {
+  kqueue_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler()));
+  CHECK_THROWS_AS(ctx.run(), std::runtime_error);
+  ctx.request_stop();
+}
+
+TEST_CASE("[schedule_after should complete after the duration]",
+          "[kqueue_context.schedule_after]") {
+  kqueue_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  auto start = monotonic_clock::now();
+  stdexec::sync_wait(exec::schedule_after(ctx.get_scheduler(), 50ms));
+  auto elapsed = monotonic_clock::now() - start;
+  CHECK(elapsed >= 50ms);
+  CHECK(elapsed < 500ms);
+
+  // A time point in the past completes immediately.
+  CHECK(stdexec::sync_wait(exec::schedule_at(ctx.get_scheduler(),
+                                             monotonic_clock::now() - 1s))
+            .has_value());
+}
+
+TEST_CASE("[schedule_after should be cancelled by when_any]",
+          "[kqueue_context.schedule_after]") {
+  kqueue_context ctx{};
+  std::jthread io_thread([&]() { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  auto start = monotonic_clock::now();
+  int which = 0;
+  stdexec::sync_wait(
+      exec::when_any(exec::schedule_after(ctx.get_scheduler(), 10s) |
+                         stdexec::then([&which] { which = 1; }),
+                     exec::schedule_after(ctx.get_scheduler(), 10ms) |
+                         stdexec::then([&which] { which = 2; })));
+  CHECK(which == 2);
+  CHECK(monotonic_clock::now() - start < 5s);
+
+  // The cancelled timer has left the heap.
+  auto [empty] = stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler()) |
+                                    stdexec::then([&ctx] {
+                                      return ctx.timers_.empty();
+                                    }))
+                     .value();
+  CHECK(empty);
+}
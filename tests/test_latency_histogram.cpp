@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>  // NOLINT
+#include <cstdint>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "latency_histogram.hpp"
+
+using net::latency_histogram;
+using namespace std::chrono_literals;  // NOLINT
+
+TEST_CASE("[latency_histogram buckets should tile the value range]",
+          "[latency_histogram]") {
+  for (std::size_t i = 1; i < latency_histogram::bucket_count; ++i) {
+    CHECK(latency_histogram::lowest_value_at(i) ==
+          latency_histogram::highest_value_at(i - 1) + 1);
+  }
+  CHECK(latency_histogram::highest_value_at(latency_histogram::bucket_count -
+                                            1) == latency_histogram::max_value);
+
+  const std::uint64_t values[] = {0,    1,      31,
+                                  32,   33,     1000,
+                                  4096, 123456, latency_histogram::max_value};
+  for (std::uint64_t v : values) {
+    const std::size_t i = latency_histogram::index_of(v);
+    CHECK(latency_histogram::lowest_value_at(i) <= v);
+    CHECK(v <= latency_histogram::highest_value_at(i));
+    // Within 1/16 of the value.
+    CHECK(latency_histogram::highest_value_at(i) -
+              latency_histogram::lowest_value_at(i) <=
+          v / 16);
+  }
+  CHECK(latency_histogram::index_of(latency_histogram::max_value + 1000) ==
+        latency_histogram::bucket_count - 1);
+}
+
+TEST_CASE("[latency_histogram should report percentiles]",
+          "[latency_histogram]") {
+  latency_histogram h;
+  CHECK(h.percentile(99) == 0ns);
+  for (int i = 1; i <= 1000; ++i) {
+    h.record(std::chrono::microseconds(i));
+  }
+  CHECK(h.count() == 1000);
+  const auto p50 = h.percentile(50);
+  CHECK(p50 >= 500us);
+  CHECK(p50 <= 500us + 500us / 16);
+  const auto p999 = h.percentile(99.9);
+  CHECK(p999 >= 999us);
+  CHECK(p999 <= 999us + 999us / 16);
+  CHECK(h.percentile(100) >= 1000us);
+  CHECK(h.percentile(0) <= 1000ns + 1000ns / 16);
+}
+
+TEST_CASE("[latency_histogram should merge the counts of another]",
+          "[latency_histogram]") {
+  latency_histogram a;
+  latency_histogram b;
+  a.record(10us);
+  b.record(10us);
+  b.record(1s);
+  a.merge(b);
+  CHECK(a.count() == 3);
+  CHECK(a.count_at(latency_histogram::index_of(10'000)) == 2);
+  CHECK(a.percentile(100) >= 1s);
+  CHECK(b.count() == 2);
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "buffer.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_accept_op.hpp"
+#include "epoll/socket_recv_some_op.hpp"
+#include "epoll/socket_send_some_op.hpp"
+#include "local/connect_pair.hpp"
+#include "local/datagram_protocol.hpp"
+#include "local/stream_protocol.hpp"
+#include "meta.hpp"
+
+using net::epoll_context;
+using net::local::datagram_protocol;
+using net::local::stream_protocol;
+
+TEST_CASE("[local protocols should satisfy transport_protocol]",
+          "[local.concept]") {
+  CHECK(net::transport_protocol<stream_protocol>);
+  CHECK(net::transport_protocol<datagram_protocol>);
+  CHECK(stream_protocol{}.family() == AF_UNIX);
+  CHECK(stream_protocol{}.type() == SOCK_STREAM);
+  CHECK(datagram_protocol{}.type() == SOCK_DGRAM);
+}
+
+TEST_CASE("[local endpoint should keep filesystem and abstract paths]",
+          "[local.endpoint]") {
+  stream_protocol::endpoint ep{"/tmp/net.sock"};
+  CHECK(ep.is_valid());
+  CHECK(ep.path() == "/tmp/net.sock");
+  CHECK_FALSE(ep.is_abstract());
+  CHECK(ep.size() ==
+        offsetof(::sockaddr_un, sun_path) + std::strlen("/tmp/net.sock") + 1);
+
+  using namespace std::string_view_literals;
+  stream_protocol::endpoint abstract{"\0net-abstract"sv};
+  CHECK(abstract.is_abstract());
+  CHECK(abstract.path() == "\0net-abstract"sv);
+  CHECK(abstract.size() == offsetof(::sockaddr_un, sun_path) + 13);
+  CHECK(abstract != ep);
+
+  ep.set_path("\0net-abstract"sv);
+  CHECK(ep == abstract);
+}
+
+TEST_CASE("[connect_pair should connect two local sockets]",
+          "[local.connect_pair]") {
+  epoll_context ctx{};
+  stream_protocol::socket s1{ctx}, s2{ctx};
+  REQUIRE(net::local::connect_pair(s1, s2).success());
+  CHECK(s1.is_open());
+  CHECK(s2.is_open());
+  CHECK(s1.send("ping", 4, 0).value() == 4);
+  char buf[4];
+  CHECK(s2.recv(buf, sizeof(buf), 0).value() == 4);
+  CHECK(std::string_view(buf, 4) == "ping");
+}
+
+TEST_CASE("[async_accept should accept local stream connections]",
+          "[local.accept]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  using namespace std::string_view_literals;
+  const stream_protocol::endpoint ep{"\0net-test-local-accept"sv};
+  system_error2::system_code ec{};
+  stream_protocol::acceptor acceptor{ctx, ep, ec, false};
+  REQUIRE(ec.success());
+  auto local = acceptor.local_endpoint();
+  REQUIRE(local.has_value());
+  CHECK(local.value() == ep);
+
+  stream_protocol::socket client{ctx};
+  REQUIRE(client.open(stream_protocol{}).success());
+  REQUIRE(client.connect(ep).success());
+
+  auto accepted = stdexec::sync_wait(net::async_accept(acceptor));
+  REQUIRE(accepted.has_value());
+  auto& [server] = accepted.value();
+  REQUIRE(server.is_open());
+
+  auto sent = stdexec::sync_wait(
+      net::async_send_some(client, net::buffer("hello", 5)));
+  REQUIRE(sent.has_value());
+  char buf[5];
+  auto received =
+      stdexec::sync_wait(net::async_recv_some(server, net::buffer(buf)));
+  REQUIRE(received.has_value());
+  CHECK(std::get<0>(received.value()) == 5);
+  CHECK(std::string_view(buf, 5) == "hello");
+}
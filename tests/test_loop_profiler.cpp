@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "loop_profiler.hpp"
+
+using net::loop_phase;
+using namespace std::chrono_literals;  // NOLINT
+
+TEST_CASE("[loop_profiler should attribute time to the marked phase]",
+          "[loop_profiler]") {
+  net::loop_profiler<true> profiler;
+  profiler.start();
+  std::this_thread::sleep_for(2ms);
+  profiler.mark(loop_phase::wait);
+  profiler.mark(loop_phase::dispatch);
+  profiler.mark(loop_phase::update_timers, false);
+
+  CHECK(profiler.histogram(loop_phase::wait).count() == 1);
+  CHECK(profiler.total(loop_phase::wait) >= 2ms);
+  CHECK(profiler.histogram(loop_phase::dispatch).count() == 1);
+  CHECK(profiler.total(loop_phase::dispatch) < 2ms);
+  CHECK(profiler.histogram(loop_phase::update_timers).count() == 0);
+  CHECK(profiler.total(loop_phase::update_timers) == 0ns);
+  CHECK(profiler.trace().empty());
+}
+
+TEST_CASE("[loop_profiler should keep the last phases in its trace]",
+          "[loop_profiler]") {
+  net::loop_profiler<true> profiler;
+  profiler.set_trace_capacity(3);
+  profiler.start();
+  profiler.mark(loop_phase::execute_local);
+  profiler.mark(loop_phase::update_timers);
+  profiler.mark(loop_phase::collect_remote);
+  profiler.mark(loop_phase::wait);
+
+  auto trace = profiler.trace();
+  REQUIRE(trace.size() == 3);
+  CHECK(trace[0].phase == loop_phase::update_timers);
+  CHECK(trace[1].phase == loop_phase::collect_remote);
+  CHECK(trace[2].phase == loop_phase::wait);
+  CHECK(trace[0].start <= trace[1].start);
+  CHECK(trace[1].start <= trace[2].start);
+}
+
+TEST_CASE("[disabled loop_profiler should record nothing]",
+          "[loop_profiler]") {
+  net::loop_profiler<false> profiler;
+  profiler.set_trace_capacity(3);
+  profiler.start();
+  profiler.mark(loop_phase::wait);
+  CHECK(profiler.histogram(loop_phase::wait).count() == 0);
+  CHECK(profiler.total(loop_phase::wait) == 0ns);
+  CHECK(profiler.trace().empty());
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <system_error>  // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "buffer.hpp"
+#include "mapped_file.hpp"
+
+using net::mapped_file;
+
+namespace {
+// A temporary file removed on destruction.
+struct temp_file {
+  explicit temp_file(const std::string& content) {
+    int fd = ::mkstemp(path);
+    REQUIRE(fd >= 0);
+    REQUIRE(::write(fd, content.data(), content.size()) ==
+            static_cast<ssize_t>(content.size()));
+    ::close(fd);
+  }
+
+  ~temp_file() { ::unlink(path); }
+
+  char path[32] = "/tmp/mapped_file_XXXXXX";
+};
+}  // namespace
+
+TEST_CASE("mapped_file should expose the file as a buffer sequence",
+          "[mapped_file]") {
+  temp_file file{"hello mapped world"};
+  mapped_file mapped{file.path, {.sequential = true, .populate = true}};
+  CHECK(mapped.size() == 18);
+  CHECK(std::memcmp(mapped.data(), "hello mapped world", 18) == 0);
+  CHECK(net::const_buffer_sequence<mapped_file::region>);
+
+  std::string copy(mapped.size(), '\0');
+  CHECK(net::buffer_copy(net::buffer(copy), mapped.whole()) == 18);
+  CHECK(copy == "hello mapped world");
+
+  auto middle = mapped.subregion(6, 6);
+  CHECK(std::string(static_cast<const char*>(middle.data()), middle.size()) ==
+        "mapped");
+  CHECK(mapped.subregion(12, 100).size() == 6);
+  CHECK(mapped.subregion(100, 1).size() == 0);
+}
+
+TEST_CASE("mapped_file regions should keep the mapping alive",
+          "[mapped_file]") {
+  temp_file file{"still here"};
+  mapped_file::region region;
+  {
+    mapped_file mapped{file.path};
+    region = mapped.subregion(6, 4);
+    CHECK(region.use_count() == 2);
+  }
+  CHECK(region.use_count() == 1);
+  CHECK(std::string(static_cast<const char*>(region.data()), region.size()) ==
+        "here");
+
+  mapped_file::region moved{std::move(region)};
+  CHECK(region.size() == 0);
+  CHECK(moved.use_count() == 1);
+}
+
+TEST_CASE("mapped_file should map an empty file as an empty region",
+          "[mapped_file]") {
+  temp_file file{""};
+  mapped_file mapped{file.path};
+  CHECK(mapped.size() == 0);
+  CHECK(mapped.whole().use_count() == 0);
+}
+
+TEST_CASE("mapped_file should throw when the file can't be opened",
+          "[mapped_file]") {
+  CHECK_THROWS_AS(mapped_file{"/nonexistent/mapped_file"}, std::system_error);
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "monotonic_arena.hpp"
+
+using net::monotonic_arena;
+
+TEST_CASE("[allocate should bump the pointer of the current block]",
+          "[monotonic_arena.allocate]") {
+  monotonic_arena arena{1024};
+  CHECK(arena.block_count() == 1);
+  CHECK(arena.capacity() == 1024);
+
+  auto* a = static_cast<char*>(arena.allocate(10, 1));
+  auto* b = static_cast<char*>(arena.allocate(6, 1));
+  CHECK(b == a + 10);
+  CHECK(arena.bytes_used() == 16);
+
+  // Aligned allocations skip the padding.
+  void* c = arena.allocate(8, 8);
+  CHECK(reinterpret_cast<std::uintptr_t>(c) % 8 == 0);
+  CHECK(arena.bytes_used() == 24);
+}
+
+TEST_CASE("[deallocate should only give back the latest allocation]",
+          "[monotonic_arena.deallocate]") {
+  monotonic_arena arena{1024};
+  void* a = arena.allocate(16);
+  void* b = arena.allocate(16);
+  arena.deallocate(a, 16);
+  CHECK(arena.bytes_used() == 32);
+  arena.deallocate(b, 16);
+  CHECK(arena.bytes_used() == 16);
+  CHECK(arena.allocate(16) == b);
+}
+
+TEST_CASE("[a full block should be chained to a larger one]",
+          "[monotonic_arena.grow]") {
+  monotonic_arena arena{256};
+  for (int i = 0; i < 10; ++i) {
+    arena.allocate(100);
+  }
+  CHECK(arena.block_count() > 1);
+  const std::size_t capacity = arena.capacity();
+  CHECK(capacity > 256);
+
+  // A request larger than twice the block gets a block of its own size.
+  arena.allocate(8192);
+  CHECK(arena.capacity() >= capacity + 8192);
+}
+
+TEST_CASE("[reset should merge the blocks into one]",
+          "[monotonic_arena.reset]") {
+  monotonic_arena arena{256};
+  void* first = arena.allocate(16);
+  arena.reset();
+  CHECK(arena.bytes_used() == 0);
+  CHECK(arena.allocate(16) == first);
+
+  for (int i = 0; i < 10; ++i) {
+    arena.allocate(100);
+  }
+  const std::size_t capacity = arena.capacity();
+  arena.reset();
+  CHECK(arena.block_count() == 1);
+  CHECK(arena.capacity() == capacity);
+
+  // The same allocations fit in the merged block.
+  for (int i = 0; i < 10; ++i) {
+    arena.allocate(100);
+  }
+  CHECK(arena.block_count() == 1);
+}
+
+TEST_CASE("[allocator should back standard containers]",
+          "[monotonic_arena.allocator]") {
+  monotonic_arena arena{};
+  using string_t =
+      std::basic_string<char, std::char_traits<char>,
+                        monotonic_arena::allocator<char>>;
+  std::vector<string_t, monotonic_arena::allocator<string_t>> headers{
+      arena.get_allocator<string_t>()};
+  for (int i = 0; i < 16; ++i) {
+    headers.emplace_back(std::string(40, 'a' + i).c_str(),
+                         arena.get_allocator<char>());
+  }
+  CHECK(headers.size() == 16);
+  CHECK(headers[15] == std::string(40, 'p').c_str());
+  CHECK(arena.get_allocator<int>() == arena.get_allocator<char>());
+  CHECK(&headers.get_allocator().arena() == &arena);
+
+  monotonic_arena other{};
+  CHECK(!(arena.get_allocator() == other.get_allocator()));
+}
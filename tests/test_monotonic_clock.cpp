@@ -17,6 +17,7 @@
  */
 #include <thread>  // NOLINT
 
+#include "fast_monotonic_clock.hpp"
 #include "monotonic_clock.hpp"
 
 using namespace std;  // NOLINT
@@ -71,3 +72,32 @@ TEST_CASE(
   CHECK(tp2.seconds() == 9);
   CHECK(tp2.nanoseconds() == 0);
 }
+
+TEST_CASE("[fast_monotonic_clock should follow CLOCK_MONOTONIC]",
+          "[fast_monotonic_clock.now]") {
+  // Calibrate outside of the measured window.
+  (void)fast_monotonic_clock::is_tsc_based();
+  auto clock_start = monotonic_clock::now();
+  auto start = fast_monotonic_clock::now();
+  // Anchored to the same clock.
+  CHECK(start >= clock_start);
+  CHECK(start - clock_start < 10ms);
+
+  std::this_thread::sleep_for(200ms);
+  auto end = fast_monotonic_clock::now();
+  auto clock_end = monotonic_clock::now();
+  CHECK(end - start >= 199ms);
+  CHECK(end <= clock_end);
+}
+
+TEST_CASE("[fast_monotonic_clock should never go backwards]",
+          "[fast_monotonic_clock.now]") {
+  auto last = fast_monotonic_clock::now();
+  bool monotonic = true;
+  for (int i = 0; i < 100'000; ++i) {
+    auto tp = fast_monotonic_clock::now();
+    monotonic = monotonic && tp >= last;
+    last = tp;
+  }
+  CHECK(monotonic);
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <string>
+#include <system_error>  // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "ip/address_v4.hpp"
+#include "ip/address_v6.hpp"
+#include "ip/network_v4.hpp"
+#include "ip/network_v6.hpp"
+
+using net::ip::address_v4;
+using net::ip::address_v6;
+using net::ip::make_address_v4;
+using net::ip::make_address_v6;
+using net::ip::make_network_v4;
+using net::ip::make_network_v6;
+using net::ip::network_v4;
+using net::ip::network_v6;
+
+TEST_CASE("[network_v4 should derive its addresses from the prefix]",
+          "[network_v4]") {
+  network_v4 net{make_address_v4("192.168.1.7"), 16};
+  CHECK(net.prefix_length() == 16);
+  CHECK(net.netmask() == make_address_v4("255.255.0.0"));
+  CHECK(net.network() == make_address_v4("192.168.0.0"));
+  CHECK(net.broadcast() == make_address_v4("192.168.255.255"));
+  CHECK(net.canonical() == network_v4{make_address_v4("192.168.0.0"), 16});
+  CHECK_FALSE(net.is_host());
+  CHECK(network_v4{make_address_v4("10.0.0.1"), 32}.is_host());
+  CHECK(network_v4{}.netmask() == address_v4::any());
+}
+
+TEST_CASE("[network_v4 should test containment]", "[network_v4]") {
+  network_v4 net{make_address_v4("10.0.0.0"), 8};
+  CHECK(net.contains(make_address_v4("10.255.0.1")));
+  CHECK_FALSE(net.contains(make_address_v4("11.0.0.1")));
+  CHECK(network_v4{}.contains(make_address_v4("1.2.3.4")));
+  CHECK(network_v4{make_address_v4("10.1.0.0"), 16}.is_subnet_of(net));
+  CHECK(net.is_subnet_of(net));
+  CHECK_FALSE(net.is_subnet_of(network_v4{make_address_v4("10.1.0.0"), 16}));
+}
+
+TEST_CASE("[network_v4 should parse and format its text form]",
+          "[network_v4]") {
+  std::error_code ec;
+  auto net = make_network_v4("172.16.0.0/12", ec);
+  CHECK_FALSE(ec);
+  CHECK(net == network_v4{make_address_v4("172.16.0.0"), 12});
+  CHECK(net.to_string() == "172.16.0.0/12");
+
+  for (const char* bad : {"172.16.0.0", "172.16.0.0/", "172.16.0.0/33",
+                          "172.16.0.0/012", "172.16.0.0/1x", "/8"}) {
+    auto result = make_network_v4(bad, ec);
+    CHECK(ec == std::errc::invalid_argument);
+    CHECK(result.is_host());
+  }
+}
+
+TEST_CASE("[network_v6 should test containment]", "[network_v6]") {
+  std::error_code ec;
+  auto net = make_network_v6("2001:db8::1/33", ec);
+  CHECK_FALSE(ec);
+  CHECK(net.network() == make_address_v6("2001:db8::"));
+  CHECK(net.canonical().to_string() == "2001:db8::/33");
+  CHECK(net.contains(make_address_v6("2001:db8:7fff::1")));
+  CHECK_FALSE(net.contains(make_address_v6("2001:db8:8000::")));
+  CHECK(network_v6{}.contains(make_address_v6("::1")));
+  CHECK(network_v6{make_address_v6("::1"), 128}.is_host());
+  CHECK(make_network_v6("2001:db8:1::/48", ec).is_subnet_of(net));
+}
+
+TEST_CASE("[network_v6 should parse and format its text form]",
+          "[network_v6]") {
+  std::error_code ec;
+  auto net = make_network_v6("fe80::/10", ec);
+  CHECK_FALSE(ec);
+  CHECK(net.prefix_length() == 10);
+  CHECK(net.to_string() == "fe80::/10");
+
+  for (const char* bad : {"fe80::", "fe80::/129", "fe80::/-1", "x/8"}) {
+    auto result = make_network_v6(bad, ec);
+    CHECK(ec == std::errc::invalid_argument);
+    CHECK(result.is_host());
+  }
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <chrono>        // NOLINT
+#include <cstdint>
+#include <string_view>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "stdexec.hpp"
+
+#include "buffer.hpp"
+#include "epoll/descriptor_read_some_op.hpp"
+#include "epoll/descriptor_write_some_op.hpp"
+#include "epoll/epoll_context.hpp"
+#include "net_error.hpp"
+#include "posix/stream_descriptor.hpp"
+
+using net::epoll_context;
+using net::posix::stream_descriptor;
+using namespace std::chrono_literals;  // NOLINT
+
+TEST_CASE("[stream_descriptor should own its descriptor]",
+          "[posix_stream_descriptor.ctor]") {
+  epoll_context ctx{};
+  int fds[2];
+  REQUIRE(::pipe2(fds, O_CLOEXEC) == 0);
+  stream_descriptor r{ctx, fds[0]};
+  stream_descriptor w{ctx};
+  CHECK_FALSE(w.is_open());
+  w.assign(fds[1]);
+  CHECK(r.is_open());
+  CHECK(&r.context() == &ctx);
+  CHECK(r.native_handle() == fds[0]);
+
+  stream_descriptor moved{static_cast<stream_descriptor&&>(r)};
+  CHECK_FALSE(r.is_open());
+  CHECK(moved.native_handle() == fds[0]);
+  CHECK(moved.close().success());
+  CHECK_FALSE(moved.is_open());
+  CHECK(moved.close() == system_error2::errc::bad_file_descriptor);
+}
+
+TEST_CASE("[read_some and write_some should move bytes through a pipe]",
+          "[posix_stream_descriptor.sync]") {
+  epoll_context ctx{};
+  int fds[2];
+  REQUIRE(::pipe2(fds, O_CLOEXEC) == 0);
+  stream_descriptor r{ctx, fds[0]}, w{ctx, fds[1]};
+  REQUIRE(r.set_non_blocking(true).success());
+
+  char buf[8];
+  ::iovec in{buf, sizeof(buf)};
+  auto res = r.read_some(&in, 1);
+  REQUIRE(res.has_error());
+  CHECK(res.error() == system_error2::errc::operation_would_block);
+
+  char hello[] = "hello";
+  ::iovec out{hello, 5};
+  CHECK(w.write_some(&out, 1).value() == 5);
+  CHECK(r.read_some(&in, 1).value() == 5);
+  CHECK(std::string_view(buf, 5) == "hello");
+
+  REQUIRE(w.close().success());
+  res = r.read_some(&in, 1);
+  REQUIRE(res.has_error());
+  CHECK(res.error() == net::network_errc::eof);
+}
+
+TEST_CASE("[async_read_some should wait for a pipe to become readable]",
+          "[posix_stream_descriptor.async]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  int fds[2];
+  REQUIRE(::pipe2(fds, O_CLOEXEC | O_NONBLOCK) == 0);
+  stream_descriptor r{ctx, fds[0]}, w{ctx, fds[1]};
+
+  std::jthread writer([&w] {
+    std::this_thread::sleep_for(10ms);
+    stdexec::sync_wait(net::async_write_some(w, net::buffer("child", 5)));
+  });
+  char buf[8];
+  auto result = stdexec::sync_wait(net::async_read_some(r, net::buffer(buf)));
+  REQUIRE(result.has_value());
+  CHECK(std::string_view(buf, std::get<0>(result.value())) == "child");
+}
+
+TEST_CASE("[async_read_some should read an eventfd]",
+          "[posix_stream_descriptor.eventfd]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_context_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  REQUIRE(fd >= 0);
+  stream_descriptor event{ctx, fd};
+  std::jthread notifier([fd] {
+    std::this_thread::sleep_for(10ms);
+    std::uint64_t one = 1;
+    (void)::write(fd, &one, sizeof(one));
+  });
+  std::uint64_t count = 0;
+  auto result = stdexec::sync_wait(
+      net::async_read_some(event, net::buffer(&count, sizeof(count))));
+  REQUIRE(result.has_value());
+  CHECK(std::get<0>(result.value()) == sizeof(count));
+  CHECK(count == 1);
+}
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "ip/address.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/address_v6.hpp"
+#include "ip/network_v4.hpp"
+#include "ip/network_v6.hpp"
+#include "ip/prefix_table.hpp"
+
+using net::ip::address_v4;
+using net::ip::address_v6;
+using net::ip::make_address_v4;
+using net::ip::make_address_v6;
+using net::ip::network_v4;
+using net::ip::network_v6;
+using net::ip::prefix_table;
+
+namespace {
+network_v4 v4(const char* text) {
+  std::error_code ec;
+  auto net = net::ip::make_network_v4(text, ec);
+  REQUIRE_FALSE(ec);
+  return net;
+}
+
+network_v6 v6(const char* text) {
+  std::error_code ec;
+  auto net = net::ip::make_network_v6(text, ec);
+  REQUIRE_FALSE(ec);
+  return net;
+}
+
+template <typename Value, typename Address>
+std::string find(const prefix_table<Value>& table, const Address& addr) {
+  const Value* value = table.find(addr);
+  return value == nullptr ? "none" : *value;
+}
+}  // namespace
+
+TEST_CASE("[prefix_table should find the longest IPv4 match]",
+          "[prefix_table]") {
+  prefix_table<std::string> table;
+  table.insert(v4("10.0.0.0/8"), "a");
+  table.insert(v4("10.1.0.0/16"), "b");
+  table.insert(v4("10.1.2.0/24"), "c");
+  table.insert(v4("10.1.2.128/25"), "d");
+  table.insert(v4("10.1.2.3/32"), "e");
+  table.insert(v4("192.168.0.0/12"), "f");
+  table.build();
+  CHECK(table.size() == 6);
+
+  CHECK(find(table, make_address_v4("10.9.9.9")) == "a");
+  CHECK(find(table, make_address_v4("10.1.9.9")) == "b");
+  CHECK(find(table, make_address_v4("10.1.2.9")) == "c");
+  CHECK(find(table, make_address_v4("10.1.2.200")) == "d");
+  CHECK(find(table, make_address_v4("10.1.2.3")) == "e");
+  CHECK(find(table, make_address_v4("10.1.3.0")) == "b");
+  CHECK(find(table, make_address_v4("192.175.255.255")) == "f");
+  CHECK(find(table, make_address_v4("11.0.0.0")) == "none");
+}
+
+TEST_CASE("[prefix_table should find the longest IPv6 match]",
+          "[prefix_table]") {
+  prefix_table<std::string> table;
+  table.insert(v6("2001:db8::/32"), "a");
+  table.insert(v6("2001:db8:1::/48"), "b");
+  table.insert(v6("2001:db8:1::1/128"), "c");
+  table.insert(v6("2001:db9::/32"), "d");
+  table.insert(v6("ffff::/16"), "e");
+  table.build();
+
+  CHECK(find(table, make_address_v6("2001:db8::5")) == "a");
+  CHECK(find(table, make_address_v6("2001:db8:1::2")) == "b");
+  CHECK(find(table, make_address_v6("2001:db8:1::1")) == "c");
+  CHECK(find(table, make_address_v6("2001:db8:2::")) == "a");
+  CHECK(find(table, make_address_v6("2001:db9:ffff::")) == "d");
+  CHECK(find(table, make_address_v6("2001:dba::")) == "none");
+  CHECK(find(table, make_address_v6("ffff:ffff:ffff:ffff:ffff:ffff:ffff:"
+                                    "ffff")) == "e");
+  CHECK(find(table, make_address_v6("::")) == "none");
+}
+
+TEST_CASE("[prefix_table should match default routes and duplicates]",
+          "[prefix_table]") {
+  prefix_table<int> table;
+  table.insert(v4("0.0.0.0/0"), 1);
+  table.insert(v6("::/0"), 2);
+  table.insert(v4("1.2.3.0/24"), 3);
+  table.insert(v4("1.2.3.0/24"), 4);
+  table.build();
+  CHECK(*table.find(make_address_v4("8.8.8.8")) == 1);
+  CHECK(*table.find(make_address_v6("2001::1")) == 2);
+  CHECK(*table.find(make_address_v4("1.2.3.4")) == 4);
+}
+
+TEST_CASE("[prefix_table should look up v4-mapped and native addresses]",
+          "[prefix_table]") {
+  prefix_table<int> table;
+  table.insert(v4("10.0.0.0/8"), 1);
+  table.insert(v6("2001:db8::/32"), 2);
+  table.build();
+
+  auto mapped = net::ip::make_address_v6(net::ip::v4_mapped_t::v4_mapped,
+                                         make_address_v4("10.2.3.4"));
+  CHECK(*table.find(mapped) == 1);
+  CHECK(*table.find(net::ip::address{make_address_v4("10.0.0.1")}) == 1);
+
+  ::sockaddr_storage storage{};
+  auto size = make_address_v4("10.0.0.1").native_address(&storage, 80);
+  CHECK(*table.find(storage, size) == 1);
+  size = make_address_v6("2001:db8::1").native_address(&storage, 80);
+  CHECK(*table.find(storage, size) == 2);
+  storage.ss_family = AF_UNIX;
+  CHECK(table.find(storage, size) == nullptr);
+}
+
+TEST_CASE("[prefix_table should agree with a linear scan]", "[prefix_table]") {
+  std::mt19937 rng(42);
+  prefix_table<int> table;
+  std::vector<std::pair<network_v4, int>> nets4;
+  std::vector<std::pair<network_v6, int>> nets6;
+  for (int i = 0; i < 2000; ++i) {
+    network_v4 net{address_v4(rng() & 0xFF0FFFFF),
+                   static_cast<int>(8 + rng() % 25)};
+    table.insert(net, i);
+    nets4.emplace_back(net, i);
+  }
+  for (int i = 0; i < 2000; ++i) {
+    address_v6::bytes_type bytes;
+    for (auto& b : bytes) {
+      b = static_cast<unsigned char>(rng());
+    }
+    bytes[0] = 0x20;
+    bytes[1] &= 0x03;
+    network_v6 net{address_v6(bytes), static_cast<int>(16 + rng() % 113)};
+    table.insert(net, i);
+    nets6.emplace_back(net, i);
+  }
+  table.build();
+
+  auto expect = [](const auto& nets, const auto& addr) {
+    int best = -1;
+    int length = -1;
+    for (const auto& [net, value] : nets) {
+      if (net.contains(addr) && net.prefix_length() >= length) {
+        length = net.prefix_length();
+        best = value;
+      }
+    }
+    return best;
+  };
+  for (int i = 0; i < 2000; ++i) {
+    // Half of the addresses fall into an inserted network.
+    const auto& net4 = nets4[rng() % nets4.size()].first;
+    address_v4 a4(i % 2 == 0 ? net4.network().to_uint() | (rng() & 0xFF)
+                             : rng() & 0xFF0FFFFF);
+    const int* got4 = table.find(a4);
+    CHECK((got4 == nullptr ? -1 : *got4) == expect(nets4, a4));
+
+    auto bytes = nets6[rng() % nets6.size()].first.network().to_bytes();
+    if (i % 2 == 0) {
+      bytes[15] = static_cast<unsigned char>(rng());
+    } else {
+      bytes[4] = static_cast<unsigned char>(rng());
+    }
+    address_v6 a6(bytes);
+    const int* got6 = table.find(a6);
+    CHECK((got6 == nullptr ? -1 : *got6) == expect(nets6, a6));
+  }
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "stdexec.hpp"
+
+#include "epoll/epoll_context.hpp"
+#include "recycling_allocator.hpp"
+
+using net::recycling_allocator;
+using net::thread_info_base;
+
+TEST_CASE("[thread_info_base should recycle a freed block]",
+          "[recycling_allocator]") {
+  thread_info_base info;
+  using tag = thread_info_base::operation_tag;
+  void* p1 = thread_info_base::allocate<tag>(&info, 100);
+  thread_info_base::deallocate<tag>(&info, p1, 100);
+
+  // Smaller or equal sizes reuse it.
+  void* p2 = thread_info_base::allocate<tag>(&info, 90);
+  CHECK(p2 == p1);
+  thread_info_base::deallocate<tag>(&info, p2, 90);
+
+  // Other purposes don't.
+  using buffer_tag = thread_info_base::buffer_tag;
+  void* p3 = thread_info_base::allocate<buffer_tag>(&info, 90);
+  CHECK(p3 != p1);
+  thread_info_base::deallocate<buffer_tag>(&info, p3, 90);
+
+  // Too big for the cached block.
+  void* p4 = thread_info_base::allocate<tag>(&info, 1000);
+  thread_info_base::deallocate<tag>(&info, p4, 1000);
+
+  // Without an instance, the heap is used.
+  void* p5 = thread_info_base::allocate<tag>(nullptr, 64);
+  thread_info_base::deallocate<tag>(nullptr, p5, 64);
+}
+
+TEST_CASE("[recycling_allocator should work with standard containers]",
+          "[recycling_allocator]") {
+  CHECK(thread_info_base::current() == nullptr);
+  std::vector<int, recycling_allocator<int, thread_info_base::buffer_tag>> v;
+  for (int i = 0; i < 1000; ++i) {
+    v.push_back(i);
+  }
+  CHECK(v.size() == 1000);
+  CHECK(v[999] == 999);
+}
+
+TEST_CASE("[epoll_context should install its cache on the io thread]",
+          "[recycling_allocator]") {
+  net::epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  void* first = nullptr;
+  void* second = nullptr;
+  stdexec::sync_wait(stdexec::schedule(ctx.get_scheduler()) |
+                     stdexec::then([&first, &second] {
+                       CHECK(thread_info_base::current() != nullptr);
+                       recycling_allocator<char> alloc;
+                       first = alloc.allocate(200);
+                       alloc.deallocate(static_cast<char*>(first), 200);
+                       second = alloc.allocate(200);
+                       alloc.deallocate(static_cast<char*>(second), 200);
+                     }));
+  CHECK(first == second);
+  CHECK(thread_info_base::current() == nullptr);
+}
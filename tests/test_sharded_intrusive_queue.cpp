@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "sharded_intrusive_queue.hpp"
+
+namespace {
+struct item {
+  item* next_ = nullptr;
+  int producer_ = 0;
+  int sequence_ = 0;
+};
+
+using queue = net::sharded_intrusive_queue<&item::next_>;
+}  // namespace
+
+TEST_CASE("[sharded_intrusive_queue should round the lanes up]",
+          "[sharded_intrusive_queue]") {
+  CHECK(queue{0}.lane_count() == 1);
+  CHECK(queue{3}.lane_count() == 4);
+  CHECK(queue{8}.lane_count() == 8);
+}
+
+TEST_CASE("[sharded_intrusive_queue should keep the order of a producer]",
+          "[sharded_intrusive_queue]") {
+  queue q{4};
+  CHECK(q.empty());
+  item items[3];
+  for (auto& i : items) {
+    CHECK_FALSE(q.enqueue(&i));
+  }
+  CHECK_FALSE(q.empty());
+  auto dequeued = q.dequeue_all();
+  for (auto& i : items) {
+    CHECK(dequeued.pop_front() == &i);
+  }
+  CHECK(dequeued.empty());
+  CHECK(q.empty());
+}
+
+TEST_CASE("[sharded_intrusive_queue should wake up an inactive consumer]",
+          "[sharded_intrusive_queue]") {
+  queue q{2};
+  CHECK(q.try_mark_inactive_or_dequeue_all().empty());
+  item a;
+  item b;
+  // Only the first producer is told to wake up the consumer.
+  CHECK(q.enqueue(&a));
+  CHECK_FALSE(q.enqueue(&b));
+  CHECK_FALSE(q.try_mark_active());
+
+  // Items left behind keep the consumer active.
+  auto dequeued = q.try_mark_inactive_or_dequeue_all();
+  CHECK(dequeued.pop_front() == &a);
+  CHECK(dequeued.pop_front() == &b);
+  item c;
+  CHECK_FALSE(q.enqueue(&c));
+  (void)q.dequeue_all();
+
+  CHECK(q.try_mark_inactive_or_dequeue_all().empty());
+  CHECK(q.try_mark_active());
+  CHECK_FALSE(q.try_mark_active());
+}
+
+TEST_CASE("[sharded_intrusive_queue should collect items of many producers]",
+          "[sharded_intrusive_queue]") {
+  constexpr int producers = 8;
+  constexpr int per_producer = 10'000;
+  queue q{4};
+  std::vector<item> items(producers * per_producer);
+  std::atomic<int> wakeups{0};
+  {
+    std::vector<std::jthread> threads;
+    for (int p = 0; p < producers; ++p) {
+      threads.emplace_back([&, p] {
+        for (int s = 0; s < per_producer; ++s) {
+          item& i = items[p * per_producer + s];
+          i.producer_ = p;
+          i.sequence_ = s;
+          if (q.enqueue(&i)) {
+            wakeups.fetch_add(1);
+          }
+        }
+      });
+    }
+  }
+
+  std::vector<int> next_sequence(producers, 0);
+  auto dequeued = q.dequeue_all();
+  int count = 0;
+  while (!dequeued.empty()) {
+    item* i = dequeued.pop_front();
+    CHECK(i->sequence_ == next_sequence[i->producer_]++);
+    ++count;
+  }
+  CHECK(count == producers * per_producer);
+  CHECK(wakeups.load() == 0);
+}
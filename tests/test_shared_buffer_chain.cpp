@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "buffer.hpp"
+#include "buffer_sequence_adapter.hpp"
+#include "shared_buffer_chain.hpp"
+
+using net::shared_buffer_chain;
+
+namespace {
+std::string to_string(const shared_buffer_chain& chain) {
+  std::string s(chain.size(), '\0');
+  CHECK(net::buffer_copy(net::buffer(s), chain) == s.size());
+  return s;
+}
+}  // namespace
+
+TEST_CASE("[shared_buffer_chain should be a const buffer sequence]",
+          "[shared_buffer_chain]") {
+  STATIC_REQUIRE(net::const_buffer_sequence<shared_buffer_chain>);
+
+  auto chain = shared_buffer_chain::copy(net::buffer(std::string{"body"}));
+  chain.prepend(net::buffer(std::string{"head:"}));
+  CHECK(chain.segment_count() == 2);
+  CHECK(chain.size() == 9);
+  CHECK(to_string(chain) == "head:body");
+
+  net::buffer_sequence_adapter<net::const_buffer, shared_buffer_chain> bufs{
+      chain};
+  CHECK(bufs.count() == 2);
+  CHECK(bufs.total_size() == 9);
+}
+
+TEST_CASE("[shared_buffer_chain should share the payload between copies]",
+          "[shared_buffer_chain]") {
+  const auto payload =
+      shared_buffer_chain::copy(net::buffer(std::string{"payload"}));
+  std::vector<shared_buffer_chain> messages;
+  for (int i = 0; i < 10; ++i) {
+    shared_buffer_chain message = payload;
+    message.prepend(net::buffer(std::to_string(i)));
+    messages.push_back(std::move(message));
+  }
+  CHECK(payload.begin()->use_count() == 11);
+  CHECK(messages[3].begin()[1].data() == payload.begin()->data());
+  CHECK(to_string(messages[3]) == "3payload");
+
+  // Released on another thread.
+  std::thread([messages = std::move(messages)] {}).join();
+  CHECK(payload.begin()->use_count() == 1);
+}
+
+TEST_CASE("[shared_buffer_chain should slice across segments]",
+          "[shared_buffer_chain]") {
+  auto chain = shared_buffer_chain::copy(net::buffer(std::string{"abc"}));
+  chain.append(shared_buffer_chain::copy(net::buffer(std::string{"defg"})));
+  chain.append(shared_buffer_chain::copy(net::buffer(std::string{"hi"})));
+
+  CHECK(to_string(chain.slice(2, 5)) == "cdefg");
+  CHECK(chain.slice(2, 5).segment_count() == 2);
+  CHECK(to_string(chain.slice(7)) == "hi");
+  CHECK(chain.slice(9).empty());
+
+  chain.consume(4);
+  CHECK(to_string(chain) == "efghi");
+  CHECK(chain.begin()->use_count() == 1);
+}
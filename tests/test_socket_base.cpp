@@ -40,5 +40,8 @@ TEST_CASE("[options should compile]", "[socket_base.open]") {
   socket_base::out_of_band_Inline{};
   socket_base::receive_buffer_size{};
   socket_base::reuse_address{};
+  socket_base::reuse_port{};
+  socket_base::busy_poll{};
+  socket_base::max_pacing_rate{};
   socket_base::send_low_water_mark{};
 }
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 #include <netinet/in.h>
+#include <unistd.h>
+#include <cstdint>
 #include <cstring>
 #include "catch2/catch_test_macros.hpp"
 
@@ -103,3 +105,21 @@ TEST_CASE("[setsocketopt with integer should work]",
                      option.size(protocol)) == 0);
   // std::cout << ::strerror(errno) << std::endl;
 }
+
+TEST_CASE("[setsockopt with unsigned_integer64 should round trip]",
+          "[socket_option.unsigned_integer64]") {
+  unsigned_integer64<SOL_SOCKET, SO_MAX_PACING_RATE> option{1'000'000};
+  MockProtocol protocol;
+  CHECK(option.size(protocol) == sizeof(std::uint64_t));
+
+  int fd = ::socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+  REQUIRE(fd != -1);
+  CHECK(::setsockopt(fd, option.level(protocol), option.name(protocol),
+                     option.data(protocol), option.size(protocol)) == 0);
+  unsigned_integer64<SOL_SOCKET, SO_MAX_PACING_RATE> read;
+  ::socklen_t size = static_cast<::socklen_t>(read.size(protocol));
+  CHECK(::getsockopt(fd, read.level(protocol), read.name(protocol),
+                     read.data(protocol), &size) == 0);
+  CHECK(read.value() == 1'000'000);
+  ::close(fd);
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <tuple>
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+
+#include "execution_context.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/tcp.hpp"
+#include "socket_option_set.hpp"
+
+using net::ip::tcp;
+
+TEST_CASE("[socket_option_set should count the options accepted sockets set]",
+          "[socket_option_set]") {
+  net::socket_option_set options{tcp::no_delay{true}, tcp::quick_ack{true},
+                                 tcp::user_timeout{1000}};
+  CHECK(decltype(options)::accepted_count == 1);
+  CHECK(std::get<2>(options.options()).value() == 1000);
+}
+
+TEST_CASE("[apply() should set every option]", "[socket_option_set]") {
+  net::execution_context ctx{};
+  tcp::socket socket{ctx};
+  REQUIRE(socket.open(tcp::v4()).success());
+
+  net::socket_option_set options{tcp::no_delay{true},
+                                 tcp::user_timeout{1000}};
+  CHECK(options.apply(socket).success());
+  tcp::no_delay no_delay{};
+  CHECK(socket.get_option(no_delay).success());
+  CHECK(no_delay.value());
+  tcp::user_timeout timeout{};
+  CHECK(socket.get_option(timeout).success());
+  CHECK(timeout.value() == 1000);
+}
+
+TEST_CASE("[apply() should stop at the first failure]", "[socket_option_set]") {
+  net::execution_context ctx{};
+  tcp::socket socket{ctx};
+
+  // Not opened.
+  net::socket_option_set options{tcp::no_delay{true}};
+  CHECK(options.apply(socket).failure());
+}
+
+TEST_CASE("[accepted sockets should end up with all options]",
+          "[socket_option_set]") {
+  net::execution_context ctx{};
+  system_error2::system_code ec{};
+  tcp::acceptor acceptor{ctx, {net::ip::address_v4::loopback(), 12394}, ec};
+  REQUIRE(ec.success());
+
+  net::socket_option_set options{tcp::no_delay{true}, tcp::quick_ack{true}};
+  REQUIRE(options.apply_inherited(acceptor).success());
+
+  tcp::socket client{ctx};
+  REQUIRE(client.open(tcp::v4()).success());
+  REQUIRE(client.connect({net::ip::address_v4::loopback(), 12394}).success());
+  auto accepted = acceptor.accept();
+  REQUIRE(accepted.has_value());
+  CHECK(options.apply_accepted(accepted.value()).success());
+  tcp::no_delay no_delay{};
+  CHECK(accepted.value().get_option(no_delay).success());
+  CHECK(no_delay.value());
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <chrono>  // NOLINT
+#include <coroutine>
+#include <exception>
+#include <stdexcept>
+#include <thread>  // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "stdexec.hpp"
+
+#include "epoll/epoll_context.hpp"
+#include "task.hpp"
+
+using net::epoll_context;
+using net::task;
+using namespace std::chrono_literals;  // NOLINT
+
+namespace {
+// Reads the address of the awaiting coroutine frame.
+struct frame_address {
+  void*& address_;
+
+  bool await_ready() const noexcept { return false; }
+
+  bool await_suspend(std::coroutine_handle<> handle) noexcept {
+    address_ = handle.address();
+    return false;
+  }
+
+  void await_resume() const noexcept {}
+};
+
+task<int> twice(int value) { co_return value * 2; }
+
+task<int> fail() {
+  throw std::runtime_error("fail");
+  co_return 0;
+}
+
+task<void*> probe() {
+  void* address = nullptr;
+  co_await frame_address{address};
+  co_return address;
+}
+}  // namespace
+
+TEST_CASE("[task should satisfy stdexec::sender]", "[task.concept]") {
+  STATIC_REQUIRE(stdexec::sender<task<int>>);
+  STATIC_REQUIRE(stdexec::sender<task<>>);
+}
+
+TEST_CASE("[task should complete with the returned value]", "[task]") {
+  auto [value] = stdexec::sync_wait(twice(21)).value();
+  CHECK(value == 42);
+}
+
+TEST_CASE("[task should resume on the io thread after awaiting a sender]",
+          "[task]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+
+  auto handler = [&]() -> task<bool> {
+    co_await stdexec::schedule(ctx.get_scheduler());
+    co_await exec::schedule_after(ctx.get_scheduler(), 1ms);
+    int value = co_await twice(2);
+    co_return value == 4 && ctx.is_running_on_io_thread();
+  };
+  auto [on_io_thread] = stdexec::sync_wait(handler()).value();
+  CHECK(on_io_thread);
+  ctx.request_stop();
+}
+
+TEST_CASE("[task should rethrow the exception of an awaited task]",
+          "[task]") {
+  auto handler = []() -> task<int> {
+    try {
+      co_await fail();
+    } catch (const std::runtime_error&) {
+      co_return 1;
+    }
+    co_return 0;
+  };
+  auto [value] = stdexec::sync_wait(handler()).value();
+  CHECK(value == 1);
+  CHECK_THROWS_AS(stdexec::sync_wait(fail()), std::runtime_error);
+}
+
+TEST_CASE("[task should complete with stopped when an awaited sender stops]",
+          "[task]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+
+  bool resumed = false;
+  auto handler = [&]() -> task<> {
+    co_await exec::schedule_after(ctx.get_scheduler(), 10s);
+    resumed = true;
+  };
+  bool stopped = false;
+  stdexec::sync_wait(exec::when_any(
+      handler(), exec::schedule_after(ctx.get_scheduler(), 20ms) |
+                     stdexec::then([&stopped] { stopped = true; })));
+  CHECK(stopped);
+  CHECK_FALSE(resumed);
+  ctx.request_stop();
+}
+
+TEST_CASE("[task frames should be recycled on the io thread]", "[task]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+
+  auto handler = [&]() -> task<bool> {
+    co_await stdexec::schedule(ctx.get_scheduler());
+    void* first = co_await probe();
+    void* second = co_await probe();
+    co_return first == second;
+  };
+  auto [recycled] = stdexec::sync_wait(handler()).value();
+  CHECK(recycled);
+  ctx.request_stop();
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <atomic>
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "epoll/epoll_context.hpp"
+#include "stdexec.hpp"
+#include "stdexec/execution.hpp"
+#include "thread_pool_context.hpp"
+
+using net::epoll_context;
+using net::thread_pool_context;
+
+TEST_CASE("[thread_pool_context should start at least one worker]",
+          "[thread_pool_context]") {
+  thread_pool_context pool{0};
+  CHECK(pool.thread_count() == 1);
+  CHECK_FALSE(pool.is_running_on_worker());
+}
+
+TEST_CASE("[thread_pool_context::scheduler should complete on a worker]",
+          "[thread_pool_context.scheduler]") {
+  thread_pool_context pool{2};
+  auto [on_worker] =
+      stdexec::sync_wait(stdexec::schedule(pool.get_scheduler()) |
+                         stdexec::then([&] {
+                           return pool.is_running_on_worker();
+                         }))
+          .value();
+  CHECK(on_worker);
+  CHECK(pool.get_scheduler() == pool.get_scheduler());
+}
+
+TEST_CASE("[thread_pool_context should run every task spawned from workers]",
+          "[thread_pool_context.steal]") {
+  // Small deques push most of the fan out through stealing and overflow.
+  thread_pool_context pool{4, 4};
+  auto sched = pool.get_scheduler();
+  std::atomic<int> count{0};
+  auto fan_out = stdexec::just() | stdexec::bulk(256, [&](int) {
+                   count.fetch_add(1);
+                 });
+  stdexec::sync_wait(stdexec::when_all(
+      stdexec::on(sched, std::move(fan_out)),
+      stdexec::schedule(sched) | stdexec::then([&] { count.fetch_add(1); })));
+  CHECK(count == 257);
+}
+
+TEST_CASE("[thread_pool_context should hop from and back to epoll_context]",
+          "[thread_pool_context.epoll_context]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  thread_pool_context pool{2};
+
+  for (int i = 0; i < 100; ++i) {
+    auto [hops] =
+        stdexec::sync_wait(
+            stdexec::schedule(ctx.get_scheduler()) |
+            stdexec::transfer(pool.get_scheduler()) |
+            stdexec::then([&] { return pool.is_running_on_worker(); }) |
+            stdexec::transfer(ctx.get_scheduler()) |
+            stdexec::then([&](bool on_pool) {
+              return std::pair{on_pool, ctx.is_running_on_io_thread()};
+            }))
+            .value();
+    CHECK(hops.first);
+    CHECK(hops.second);
+  }
+  ctx.request_stop();
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <limits>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "monotonic_clock.hpp"
+#include "token_bucket.hpp"
+
+using net::monotonic_clock;
+using net::token_bucket;
+using namespace std::chrono_literals;  // NOLINT
+
+namespace {
+monotonic_clock::time_point at(std::int64_t seconds,
+                               std::int64_t nanoseconds = 0) {
+  return monotonic_clock::time_point::from_seconds_and_nanoseconds(
+      seconds, nanoseconds);
+}
+}  // namespace
+
+TEST_CASE("[default token_bucket should be unlimited]", "[token_bucket]") {
+  token_bucket bucket;
+  CHECK_FALSE(bucket.limited());
+  CHECK(bucket.tokens() == std::numeric_limits<std::uint64_t>::max());
+  bucket.consume(1 << 20);
+  CHECK(bucket.tokens() == std::numeric_limits<std::uint64_t>::max());
+  CHECK(bucket.time_until(1 << 20) == monotonic_clock::duration::zero());
+}
+
+TEST_CASE("[token_bucket should refill at its rate up to the burst]",
+          "[token_bucket]") {
+  token_bucket bucket{1000, 500, at(10)};
+  CHECK(bucket.limited());
+  CHECK(bucket.tokens() == 500);
+  bucket.consume(500);
+  CHECK(bucket.tokens() == 0);
+
+  bucket.refill(at(10, 100'000'000));
+  CHECK(bucket.tokens() == 100);
+  bucket.refill(at(12));
+  CHECK(bucket.tokens() == 500);
+}
+
+TEST_CASE("[token_bucket should keep fractions over frequent refills]",
+          "[token_bucket]") {
+  // One token every 10ms, refilled every 1ms.
+  token_bucket bucket{100, 100, at(0)};
+  bucket.consume(100);
+  for (int i = 1; i <= 1000; ++i) {
+    bucket.refill(at(0, i * 1'000'000));
+  }
+  CHECK(bucket.tokens() == 100);
+}
+
+TEST_CASE("[token_bucket should tell the time until tokens are available]",
+          "[token_bucket]") {
+  token_bucket bucket{1000, 500, at(0)};
+  bucket.consume(500);
+  CHECK(bucket.time_until(100) == 100ms);
+  // Capped at the burst.
+  CHECK(bucket.time_until(10'000) == 500ms);
+  bucket.refill(at(0, 100'000'000));
+  CHECK(bucket.time_until(100) == monotonic_clock::duration::zero());
+}
+
+TEST_CASE("[token_bucket should cap the tokens at a new burst]",
+          "[token_bucket]") {
+  token_bucket bucket{1000, 500, at(0)};
+  bucket.set_rate(2000, 100, at(1));
+  CHECK(bucket.rate() == 2000);
+  CHECK(bucket.burst() == 100);
+  CHECK(bucket.tokens() == 100);
+  bucket.set_rate(0, 0, at(2));
+  CHECK_FALSE(bucket.limited());
+}
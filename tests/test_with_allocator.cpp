@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <chrono>        // NOLINT
+#include <string>
+#include <system_error>  // NOLINT
+#include <thread>        // NOLINT
+
+#include "catch2/catch_test_macros.hpp"
+#include "status-code/system_code.hpp"
+#include "stdexec.hpp"
+
+#include "buffer.hpp"
+#include "epoll/epoll_context.hpp"
+#include "epoll/socket_recv_until_op.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/tcp.hpp"
+#include "monotonic_arena.hpp"
+#include "tcp_connection.hpp"
+#include "with_allocator.hpp"
+
+using net::epoll_context;
+using net::monotonic_arena;
+using namespace std::chrono_literals;  // NOLINT
+
+constexpr port_type mock_port = 12424;
+
+TEST_CASE("[with_allocator should answer get_allocator of the environment]",
+          "[with_allocator.env]") {
+  monotonic_arena arena{};
+  auto [alloc] =
+      stdexec::sync_wait(
+          net::with_allocator(stdexec::read(stdexec::get_allocator),
+                              arena.get_allocator()))
+          .value();
+  CHECK(&alloc.arena() == &arena);
+}
+
+TEST_CASE("[senders started within should share the allocator]",
+          "[with_allocator.env]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  monotonic_arena arena{};
+  auto [alloc] =
+      stdexec::sync_wait(net::with_allocator(
+                             stdexec::schedule(ctx.get_scheduler()) |
+                                 stdexec::let_value([] {
+                                   return stdexec::read(stdexec::get_allocator);
+                                 }),
+                             arena.get_allocator()))
+          .value();
+  CHECK(&alloc.arena() == &arena);
+}
+
+TEST_CASE("[with_allocator should forward the stop token]",
+          "[with_allocator.stop]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  monotonic_arena arena{};
+  int which = 0;
+  auto start = std::chrono::steady_clock::now();
+  stdexec::sync_wait(exec::when_any(
+      net::with_allocator(exec::schedule_after(ctx.get_scheduler(), 10s),
+                          arena.get_allocator()) |
+          stdexec::then([&which] { which = 1; }),
+      exec::schedule_after(ctx.get_scheduler(), 10ms) |
+          stdexec::then([&which] { which = 2; })));
+  CHECK(which == 2);
+  CHECK(std::chrono::steady_clock::now() - start < 5s);
+}
+
+TEST_CASE("[a request should be received into the arena]",
+          "[with_allocator.arena]") {
+  epoll_context ctx{};
+  std::jthread io_thread([&ctx] { ctx.run(); });
+  exec::scope_guard on_exit{[&ctx]() noexcept {
+    ctx.request_stop();
+  }};
+
+  connection conn{ctx, mock_port};
+  net::ip::tcp::socket& client = conn.client;
+  net::ip::tcp::socket& server = conn.server;
+
+  using string_t = std::basic_string<char, std::char_traits<char>,
+                                     monotonic_arena::allocator<char>>;
+  monotonic_arena arena{};
+  for (int i = 0; i < 3; ++i) {
+    CHECK(client.sync_send("GET / HTTP/1.1\r\n\r\n", 18, 0).has_value());
+    std::size_t length = 0;
+    stdexec::sync_wait(net::with_allocator(
+        stdexec::read(stdexec::get_allocator) |
+            stdexec::let_value([&](monotonic_arena::allocator<std::byte>& a) {
+              return stdexec::just(string_t{a}) |
+                     stdexec::let_value([&](string_t& head) {
+                       return net::async_recv_until(
+                                  server, net::dynamic_buffer(head),
+                                  "\r\n\r\n") |
+                              stdexec::then([&](std::size_t n) noexcept {
+                                length = n;
+                                CHECK(head.starts_with("GET / "));
+                              });
+                     });
+            }),
+        arena.get_allocator()));
+    CHECK(length == 18);
+
+    // The response has been sent, everything the request allocated goes.
+    arena.reset();
+    CHECK(arena.bytes_used() == 0);
+    CHECK(arena.block_count() == 1);
+  }
+}
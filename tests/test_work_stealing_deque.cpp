@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "work_stealing_deque.hpp"
+
+namespace {
+using deque = net::work_stealing_deque<int>;
+}  // namespace
+
+TEST_CASE("[work_stealing_deque should round the capacity up]",
+          "[work_stealing_deque]") {
+  CHECK(deque{0}.capacity() == 2);
+  CHECK(deque{5}.capacity() == 8);
+  CHECK(deque{64}.capacity() == 64);
+}
+
+TEST_CASE("[work_stealing_deque should pop LIFO and steal FIFO]",
+          "[work_stealing_deque]") {
+  deque d{4};
+  int items[4] = {0, 1, 2, 3};
+  for (int& i : items) {
+    CHECK(d.push(&i));
+  }
+  CHECK_FALSE(d.push(&items[0]));
+  CHECK(d.size() == 4);
+  CHECK(d.pop() == &items[3]);
+  CHECK(d.steal() == &items[0]);
+  CHECK(d.pop() == &items[2]);
+  CHECK(d.steal() == &items[1]);
+  CHECK(d.empty());
+  CHECK(d.pop() == nullptr);
+  CHECK(d.steal() == nullptr);
+  // The slots are reused once the indices wrap.
+  CHECK(d.push(&items[0]));
+  CHECK(d.pop() == &items[0]);
+}
+
+TEST_CASE("[work_stealing_deque should hand out every item exactly once]",
+          "[work_stealing_deque]") {
+  constexpr int count = 200000;
+  constexpr int thieves = 3;
+  deque d{256};
+  std::vector<int> items(count);
+  std::vector<std::atomic<int>> taken(count);
+  std::atomic<bool> done{false};
+  auto take = [&](int* item) { taken[item - items.data()].fetch_add(1); };
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thieves; ++t) {
+    threads.emplace_back([&] {
+      while (!done.load()) {
+        if (int* item = d.steal()) {
+          take(item);
+        }
+      }
+    });
+  }
+  for (int i = 0; i < count; ++i) {
+    while (!d.push(&items[i])) {
+      if (int* item = d.pop()) {
+        take(item);
+      }
+    }
+    if (i % 3 == 0) {
+      if (int* item = d.pop()) {
+        take(item);
+      }
+    }
+  }
+  while (int* item = d.pop()) {
+    take(item);
+  }
+  done.store(true);
+  for (auto& t : threads) {
+    t.join();
+  }
+  int total = 0;
+  bool once = true;
+  for (auto& n : taken) {
+    total += n.load();
+    once = once && n.load() == 1;
+  }
+  CHECK(total == count);
+  CHECK(once);
+}
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <linux/bpf.h>
+#include <sys/socket.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "xdp/udp_frame.hpp"
+#include "xdp/xdp_program.hpp"
+
+using net::xdp::parse_udp_frame;
+using net::xdp::udp_frame_addresses;
+using net::xdp::udp_frame_header_size;
+using net::xdp::udp_peer_cache;
+using net::xdp::write_udp_frame_headers;
+using net::xdp::xdp_program;
+
+namespace {
+udp_frame_addresses make_addresses(int family) {
+  udp_frame_addresses addrs{};
+  const std::uint8_t source_mac[6] = {0x02, 0, 0, 0, 0, 0x01};
+  const std::uint8_t destination_mac[6] = {0x02, 0, 0, 0, 0, 0x02};
+  std::memcpy(addrs.source_mac, source_mac, 6);
+  std::memcpy(addrs.destination_mac, destination_mac, 6);
+  addrs.family = family;
+  for (std::uint8_t i = 0; i < 16; ++i) {
+    addrs.source_ip[i] = static_cast<std::uint8_t>(10 + i);
+    addrs.destination_ip[i] = static_cast<std::uint8_t>(100 + i);
+  }
+  addrs.source_port = 4321;
+  addrs.destination_port = 9000;
+  return addrs;
+}
+
+// The one's complement sum of the big endian words.
+std::uint32_t sum_words(const std::uint8_t* p, std::size_t size) {
+  std::uint32_t sum = 0;
+  for (std::size_t i = 0; i + 1 < size; i += 2) {
+    sum += static_cast<std::uint32_t>((p[i] << 8) | p[i + 1]);
+  }
+  if (size % 2 != 0) {
+    sum += static_cast<std::uint32_t>(p[size - 1] << 8);
+  }
+  while ((sum >> 16) != 0) {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  return sum;
+}
+}  // namespace
+
+TEST_CASE("[written IPv4 frame should parse back]", "[xdp_udp_frame]") {
+  udp_frame_addresses addrs = make_addresses(AF_INET);
+  std::uint8_t frame[128] = {};
+  const std::size_t header = udp_frame_header_size(AF_INET);
+  CHECK(header == 42);
+  std::memcpy(frame + header, "hello", 5);
+  std::size_t size = write_udp_frame_headers(frame, addrs, 5);
+  CHECK(size == 47);
+
+  udp_frame_addresses parsed{};
+  const std::uint8_t* payload = nullptr;
+  std::size_t payload_size = 0;
+  REQUIRE(parse_udp_frame(frame, size, parsed, &payload, &payload_size));
+  CHECK(parsed.family == AF_INET);
+  CHECK(std::memcmp(parsed.source_mac, addrs.source_mac, 6) == 0);
+  CHECK(std::memcmp(parsed.destination_mac, addrs.destination_mac, 6) == 0);
+  CHECK(std::memcmp(parsed.source_ip, addrs.source_ip, 4) == 0);
+  CHECK(std::memcmp(parsed.destination_ip, addrs.destination_ip, 4) == 0);
+  CHECK(parsed.source_port == 4321);
+  CHECK(parsed.destination_port == 9000);
+  CHECK(payload == frame + header);
+  CHECK(payload_size == 5);
+}
+
+TEST_CASE("[written IPv6 frame should parse back]", "[xdp_udp_frame]") {
+  udp_frame_addresses addrs = make_addresses(AF_INET6);
+  std::uint8_t frame[128] = {};
+  const std::size_t header = udp_frame_header_size(AF_INET6);
+  CHECK(header == 62);
+  std::memcpy(frame + header, "hi", 2);
+  std::size_t size = write_udp_frame_headers(frame, addrs, 2);
+  CHECK(size == 64);
+
+  udp_frame_addresses parsed{};
+  const std::uint8_t* payload = nullptr;
+  std::size_t payload_size = 0;
+  REQUIRE(parse_udp_frame(frame, size, parsed, &payload, &payload_size));
+  CHECK(parsed.family == AF_INET6);
+  CHECK(std::memcmp(parsed.source_ip, addrs.source_ip, 16) == 0);
+  CHECK(std::memcmp(parsed.destination_ip, addrs.destination_ip, 16) == 0);
+  CHECK(payload_size == 2);
+}
+
+TEST_CASE("[written checksums should verify]", "[xdp_udp_frame]") {
+  for (int family : {AF_INET, AF_INET6}) {
+    udp_frame_addresses addrs = make_addresses(family);
+    std::uint8_t frame[128] = {};
+    const std::size_t header = udp_frame_header_size(family);
+    // An odd length exercises the padding of the last word.
+    std::memcpy(frame + header, "odd", 3);
+    std::size_t size = write_udp_frame_headers(frame, addrs, 3);
+    const std::uint8_t* ip = frame + 14;
+    const std::uint8_t* udp = frame + header - 8;
+    const std::size_t udp_size = size - (header - 8);
+
+    // The pseudo header: addresses, protocol and UDP length.
+    std::vector<std::uint8_t> data;
+    if (family == AF_INET) {
+      CHECK(sum_words(ip, 20) == 0xffff);
+      data.assign(ip + 12, ip + 20);
+    } else {
+      data.assign(ip + 8, ip + 40);
+    }
+    data.insert(data.end(), {0, IPPROTO_UDP, 0,
+                             static_cast<std::uint8_t>(udp_size)});
+    data.insert(data.end(), udp, udp + udp_size);
+    CHECK(sum_words(data.data(), data.size()) == 0xffff);
+  }
+}
+
+TEST_CASE("[parse should reject frames which aren't UDP datagrams]",
+          "[xdp_udp_frame]") {
+  udp_frame_addresses addrs = make_addresses(AF_INET);
+  std::uint8_t frame[128] = {};
+  std::memcpy(frame + 42, "hello", 5);
+  std::size_t size = write_udp_frame_headers(frame, addrs, 5);
+  udp_frame_addresses parsed{};
+  const std::uint8_t* payload = nullptr;
+  std::size_t payload_size = 0;
+
+  SECTION("truncated") {
+    CHECK_FALSE(parse_udp_frame(frame, size - 1, parsed, &payload,
+                                &payload_size));
+    CHECK_FALSE(parse_udp_frame(frame, 20, parsed, &payload, &payload_size));
+  }
+
+  SECTION("not IP") {
+    frame[12] = 0x08;
+    frame[13] = 0x06;
+    CHECK_FALSE(
+        parse_udp_frame(frame, size, parsed, &payload, &payload_size));
+  }
+
+  SECTION("not UDP") {
+    frame[23] = IPPROTO_TCP;
+    CHECK_FALSE(
+        parse_udp_frame(frame, size, parsed, &payload, &payload_size));
+  }
+
+  SECTION("a later fragment") {
+    frame[20] = 0x00;
+    frame[21] = 0x10;
+    CHECK_FALSE(
+        parse_udp_frame(frame, size, parsed, &payload, &payload_size));
+  }
+
+  SECTION("UDP length beyond the IP payload") {
+    frame[39] = 20;
+    CHECK_FALSE(
+        parse_udp_frame(frame, size, parsed, &payload, &payload_size));
+  }
+}
+
+TEST_CASE("[parse should skip IPv4 options and padding]", "[xdp_udp_frame]") {
+  udp_frame_addresses addrs = make_addresses(AF_INET);
+  std::uint8_t frame[128] = {};
+  std::memcpy(frame + 42, "hello", 5);
+  std::size_t size = write_udp_frame_headers(frame, addrs, 5);
+  // Insert 4 bytes of options and pad the frame to the Ethernet minimum.
+  std::uint8_t with_options[128] = {};
+  std::memcpy(with_options, frame, 34);
+  std::memcpy(with_options + 38, frame + 34, size - 34);
+  with_options[14] = 0x46;
+  with_options[17] = static_cast<std::uint8_t>(with_options[17] + 4);
+
+  udp_frame_addresses parsed{};
+  const std::uint8_t* payload = nullptr;
+  std::size_t payload_size = 0;
+  REQUIRE(parse_udp_frame(with_options, 60, parsed, &payload, &payload_size));
+  CHECK(payload == with_options + 46);
+  CHECK(payload_size == 5);
+}
+
+TEST_CASE("[peer cache should find the reply addresses of learned peers]",
+          "[xdp_udp_peer_cache]") {
+  udp_peer_cache cache{100};
+  CHECK(cache.capacity() == 128);
+
+  udp_frame_addresses received = make_addresses(AF_INET);
+  CHECK(cache.find(AF_INET, received.source_ip, 4321) == nullptr);
+  cache.learn(received);
+
+  const udp_frame_addresses* reply =
+      cache.find(AF_INET, received.source_ip, 4321);
+  REQUIRE(reply != nullptr);
+  CHECK(std::memcmp(reply->destination_mac, received.source_mac, 6) == 0);
+  CHECK(std::memcmp(reply->source_mac, received.destination_mac, 6) == 0);
+  CHECK(std::memcmp(reply->source_ip, received.destination_ip, 4) == 0);
+  CHECK(reply->source_port == 9000);
+  CHECK(reply->destination_port == 4321);
+
+  // Another port or family is another peer.
+  CHECK(cache.find(AF_INET, received.source_ip, 4322) == nullptr);
+  CHECK(cache.find(AF_INET6, received.source_ip, 4321) == nullptr);
+}
+
+TEST_CASE("[udp redirect program should resolve every jump]",
+          "[xdp_program]") {
+  for (std::uint16_t port : {0, 9000}) {
+    std::vector<bpf_insn> insns =
+        xdp_program::udp_redirect_instructions(port, 3);
+    REQUIRE(!insns.empty());
+    CHECK(insns.back().code == (BPF_JMP | BPF_EXIT));
+    for (std::size_t i = 0; i < insns.size(); ++i) {
+      std::uint8_t op = insns[i].code & 0xf0;
+      if ((insns[i].code & 0x07) == BPF_JMP && op != BPF_CALL &&
+          op != BPF_EXIT) {
+        // Forward only, and inside the program.
+        CHECK(insns[i].off >= 0);
+        CHECK(i + 1 + static_cast<std::size_t>(insns[i].off) < insns.size());
+      }
+    }
+  }
+  // The port filter is one more instruction.
+  CHECK(xdp_program::udp_redirect_instructions(9000, 3).size() ==
+        xdp_program::udp_redirect_instructions(0, 3).size() + 1);
+}
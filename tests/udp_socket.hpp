@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2023 Runner-2019
+ *
+ * Licensed under the Apache License Version 2.0 with LLVM Exceptions
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ *   https://llvm.org/LICENSE.txt
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TESTS_UDP_SOCKET_HPP_
+#define TESTS_UDP_SOCKET_HPP_
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "epoll/epoll_context.hpp"
+#include "ip/address_v4.hpp"
+#include "ip/udp.hpp"
+
+// Open a non-blocking udp socket bound to the loopback address.
+inline net::ip::udp::socket make_udp_socket(net::epoll_context& ctx,
+                                            port_type port) {
+  net::ip::udp::socket socket{ctx};
+  CHECK(socket.open(net::ip::udp::v4()).success());
+  CHECK(socket.bind({net::ip::address_v4::loopback(), port}).success());
+  CHECK(socket.set_non_blocking(true).success());
+  return socket;
+}
+
+#endif  // TESTS_UDP_SOCKET_HPP_